@@ -0,0 +1,224 @@
+#include "column_store.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PAD_CHUNK 512
+
+void columnStore_Sanitize(char *out, int size, const char *name, int len) {
+  int n = 0;
+  for (int i = 0; i < len && n < size - 1; i++) {
+    char c = name[i];
+    bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+              (c >= '0' && c <= '9') || c == '_' || c == '-' ||
+              (c == '.' && n > 0);
+    out[n++] = ok ? c : '_';
+  }
+  out[n] = '\0';
+}
+
+int columnSeries_Init(columnSeries_t *series, const char *root,
+                      const char *device, const char *seriesName) {
+  memset(series, 0, sizeof(columnSeries_t));
+  int len = snprintf(series->dir, sizeof(series->dir), "%s/%s/%s", root,
+                     device, seriesName);
+  if (len >= (int)sizeof(series->dir) - COLUMN_NAME_MAX - 8) {
+    return -1;
+  }
+  return 0;
+}
+
+static int ensureCapacity(column_t *column, int count) {
+  if (count <= column->cap) {
+    return 0;
+  }
+  int cap = column->cap ? column->cap * 2 : 16;
+  while (cap < count) {
+    cap *= 2;
+  }
+  double *values = (double *)realloc(column->values, cap * sizeof(double));
+  if (!values) {
+    return -1;
+  }
+  column->values = values;
+  column->cap = cap;
+  return 0;
+}
+
+static column_t *findColumn(columnSeries_t *series, const char *name,
+                            columnStoreStats_t *stats) {
+  if (series->cursor < series->columnCount &&
+      strcmp(series->columns[series->cursor].name, name) == 0) {
+    return &series->columns[series->cursor];
+  }
+  for (int i = 0; i < series->columnCount; i++) {
+    if (strcmp(series->columns[i].name, name) == 0) {
+      return &series->columns[i];
+    }
+  }
+  if (series->columnCount >= COLUMN_MAX_PER_SERIES) {
+    stats->droppedColumns++;
+    return NULL;
+  }
+
+  // 新字段：缓存中已有的行补 NaN，已写入文件的行在首次写入时补
+  column_t *column = &series->columns[series->columnCount];
+  memset(column, 0, sizeof(column_t));
+  snprintf(column->name, sizeof(column->name), "%s", name);
+  if (ensureCapacity(column, series->rows + 1) != 0) {
+    return NULL;
+  }
+  for (int i = 0; i < series->rows; i++) {
+    column->values[i] = NAN;
+  }
+  column->count = series->rows;
+  column->padRows = series->fileRows;
+  series->columnCount++;
+  return column;
+}
+
+void columnSeries_Set(columnSeries_t *series, const char *name, double value,
+                      columnStoreStats_t *stats) {
+  char key[COLUMN_NAME_MAX];
+  columnStore_Sanitize(key, sizeof(key), name, strlen(name));
+  column_t *column = findColumn(series, key, stats);
+  if (!column || ensureCapacity(column, series->rows + 1) != 0) {
+    return;
+  }
+  // 同一行重复的字段取最后一个值
+  column->values[series->rows] = value;
+  column->count = series->rows + 1;
+  series->cursor = (int)(column - series->columns) + 1;
+}
+
+void columnSeries_EndRow(columnSeries_t *series, int batchRows,
+                         int64_t nowNs, columnStoreStats_t *stats) {
+  for (int i = 0; i < series->columnCount; i++) {
+    column_t *column = &series->columns[i];
+    if (column->count == series->rows &&
+        ensureCapacity(column, series->rows + 1) == 0) {
+      column->values[column->count++] = NAN;
+    }
+  }
+  if (series->rows++ == 0) {
+    series->firstNs = nowNs;
+  }
+  series->cursor = 0;
+  stats->rows++;
+  if (series->rows >= batchRows) {
+    columnSeries_Flush(series, stats);
+  }
+}
+
+/* 逐级创建目录 */
+static int makeDirs(char *path) {
+  for (char *p = path + 1; *p; p++) {
+    if (*p != '/') {
+      continue;
+    }
+    *p = '\0';
+    int rc = mkdir(path, 0755);
+    *p = '/';
+    if (rc != 0 && errno != EEXIST) {
+      return -1;
+    }
+  }
+  if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+    return -1;
+  }
+  return 0;
+}
+
+static int writeAll(int fd, const void *data, size_t len,
+                    columnStoreStats_t *stats) {
+  const char *p = (const char *)data;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return -1;
+    }
+    stats->writes++;
+    stats->bytes += (unsigned long)n;
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+static int appendColumn(columnSeries_t *series, column_t *column, int rows,
+                        columnStoreStats_t *stats) {
+  char path[COLUMN_PATH_MAX + COLUMN_NAME_MAX + 8];
+  snprintf(path, sizeof(path), "%s/%s.f64", series->dir, column->name);
+  int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return -1;
+  }
+
+  int rc = 0;
+  if (column->padRows > 0) {
+    double nanChunk[PAD_CHUNK];
+    for (int i = 0; i < PAD_CHUNK; i++) {
+      nanChunk[i] = NAN;
+    }
+    for (long pad = column->padRows; pad > 0 && rc == 0; pad -= PAD_CHUNK) {
+      long n = pad < PAD_CHUNK ? pad : PAD_CHUNK;
+      rc = writeAll(fd, nanChunk, n * sizeof(double), stats);
+    }
+  }
+  if (rc == 0) {
+    rc = writeAll(fd, column->values, rows * sizeof(double), stats);
+  }
+  close(fd);
+  return rc;
+}
+
+int columnSeries_Flush(columnSeries_t *series, columnStoreStats_t *stats) {
+  if (series->rows == 0) {
+    return 0;
+  }
+  int rc = 0;
+  if (!series->dirReady && makeDirs(series->dir) != 0) {
+    // 缓存的行丢弃，下一批再尝试创建
+    fprintf(stderr, "Error creating %s: %s\n", series->dir, strerror(errno));
+    stats->errors++;
+    rc = -1;
+  } else {
+    series->dirReady = true;
+  }
+
+  for (int i = 0; i < series->columnCount; i++) {
+    column_t *column = &series->columns[i];
+    if (series->dirReady &&
+        appendColumn(series, column, series->rows, stats) != 0) {
+      // 该列此后与其他列不再对齐，只记录错误，不中断其他列
+      fprintf(stderr, "Error writing %s/%s.f64: %s\n", series->dir,
+              column->name, strerror(errno));
+      stats->errors++;
+      rc = -1;
+    }
+    column->count = 0;
+    column->padRows = 0;
+  }
+  if (series->dirReady) {
+    series->fileRows += series->rows;
+  }
+  series->rows = 0;
+  stats->flushes++;
+  return rc;
+}
+
+void columnSeries_Free(columnSeries_t *series) {
+  for (int i = 0; i < series->columnCount; i++) {
+    free(series->columns[i].values);
+    series->columns[i].values = NULL;
+  }
+  series->columnCount = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef _COLUMN_STORE_H
+#define _COLUMN_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 按列存储的时间序列：每个设备的每个数据系列（Topic中设备ID之后的部分）
+ * 一个目录，每个数值字段一个文件 <root>/<device>/<series>/<column>.f64，
+ * 依次追加本机字节序的 double。同一系列的各列行数对齐，某行缺少的字段
+ * 和新字段出现之前的行均为 NaN。
+ * 行先缓存在内存中，攒够 batchRows 行或调用 Flush 时每列一次 write，
+ * 文件写完即关闭，设备再多也不会占用大量文件描述符
+ * */
+
+#define COLUMN_MAX_PER_SERIES 48
+#define COLUMN_NAME_MAX 48
+#define COLUMN_PATH_MAX 320
+
+typedef struct {
+  char name[COLUMN_NAME_MAX];
+  double *values; // 缓存的行
+  int count;      // 缓存中的值数，当前行写入后为 rows + 1
+  int cap;
+  long padRows; // 该列出现前已写入文件的行数，首次写入时先补 NaN
+} column_t;
+
+typedef struct {
+  char dir[COLUMN_PATH_MAX]; // <root>/<device>/<series>
+  bool dirReady;
+  int rows;       // 缓存的行数
+  long fileRows;  // 已写入文件的行数
+  int64_t firstNs; // 缓存中第一行的时间（CLOCK_MONOTONIC），用于定时写入
+  int cursor;      // 当前行已设置的字段数，字段顺序通常不变，先按位置匹配
+  int columnCount;
+  column_t columns[COLUMN_MAX_PER_SERIES];
+} columnSeries_t;
+
+/* 写入统计 */
+typedef struct {
+  unsigned long rows;
+  unsigned long bytes;
+  unsigned long writes; // write 调用次数
+  unsigned long flushes;
+  unsigned long errors;
+  unsigned long droppedColumns; // 超过 COLUMN_MAX_PER_SERIES 被忽略的字段
+} columnStoreStats_t;
+
+/* 把名称中文件名不允许或有歧义的字符替换为 '_' */
+void columnStore_Sanitize(char *out, int size, const char *name, int len);
+
+/* 初始化系列，device 和 series 需已经过 Sanitize */
+int columnSeries_Init(columnSeries_t *series, const char *root,
+                      const char *device, const char *seriesName);
+
+/* 设置当前行的字段值，缺失值传 NaN */
+void columnSeries_Set(columnSeries_t *series, const char *name, double value,
+                      columnStoreStats_t *stats);
+
+/* 结束当前行：未设置的字段补 NaN，缓存满 batchRows 行时写入文件 */
+void columnSeries_EndRow(columnSeries_t *series, int batchRows,
+                         int64_t nowNs, columnStoreStats_t *stats);
+
+/* 把缓存的行写入文件，返回0成功 */
+int columnSeries_Flush(columnSeries_t *series, columnStoreStats_t *stats);
+
+void columnSeries_Free(columnSeries_t *series);
+
+#endif // !_COLUMN_STORE_H
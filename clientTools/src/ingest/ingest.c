@@ -0,0 +1,684 @@
+#include "ingest.h"
+#include "cJSON/cJSON.h"
+#include "modules/payload_codec.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TOPIC_PREFIX "sentinel/"
+#define TOPIC_PREFIX_LEN 9
+#define RECORD_ALIGN 32
+#define RECORD_WRAP 0xFFFFFFFFu // 记录到缓冲末尾放不下，跳到开头
+#define DRAIN_BATCH 256
+#define SUBMIT_WAIT_MS 1000
+#define FLUSH_CHECK_NS 100000000LL
+
+/* 环形缓冲中一条消息的头部，后接 topic + '\0' + payload，按32字节对齐 */
+typedef struct {
+  uint32_t size; // 含头部和对齐
+  uint32_t topicLen;
+  uint32_t payloadLen;
+  uint32_t deviceLen;
+  uint64_t arrivalNs; // CLOCK_MONOTONIC
+  int64_t receivedMs; // CLOCK_REALTIME
+} ingestRecord_t;
+
+static uint64_t monotonicNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int64_t realtimeMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void initMonotonicCond(pthread_cond_t *cond) {
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+/* 只由一个线程写入、其他线程读取的计数 */
+static void bump(unsigned long *counter) {
+  __atomic_store_n(counter, *counter + 1, __ATOMIC_RELAXED);
+}
+
+static uint32_t hashName(const char *name, int len) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < len; i++) {
+    hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static void histAdd(unsigned long *hist, uint64_t value) {
+  int bucket = 0;
+  for (uint64_t v = value; v > 0 && bucket < INGEST_HIST_BUCKETS - 1;
+       v >>= 1) {
+    bucket++;
+  }
+  hist[bucket]++;
+}
+
+/* 直方图的百分位数，取所在桶的上界 */
+static uint32_t histPercentile(const unsigned long *hist, int percent) {
+  unsigned long total = 0;
+  for (int i = 0; i < INGEST_HIST_BUCKETS; i++) {
+    total += hist[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  unsigned long threshold = total - total * (100 - percent) / 100;
+  unsigned long cumulative = 0;
+  for (int i = 0; i < INGEST_HIST_BUCKETS; i++) {
+    cumulative += hist[i];
+    if (cumulative >= threshold) {
+      return i == 0 ? 1 : 1u << i;
+    }
+  }
+  return 1u << (INGEST_HIST_BUCKETS - 1);
+}
+
+/* sentinel/{device_id}/{series}，返回设备ID长度，不合法返回-1 */
+static int parseTopic(const char *topic, int topicLen) {
+  if (topicLen >= INGEST_TOPIC_MAX || topicLen <= TOPIC_PREFIX_LEN ||
+      memcmp(topic, TOPIC_PREFIX, TOPIC_PREFIX_LEN) != 0) {
+    return -1;
+  }
+  const char *device = topic + TOPIC_PREFIX_LEN;
+  const char *slash = memchr(device, '/', topicLen - TOPIC_PREFIX_LEN);
+  int deviceLen = slash ? (int)(slash - device) : -1;
+  if (deviceLen <= 0 || deviceLen >= INGEST_NAME_MAX ||
+      slash + 1 >= topic + topicLen) {
+    return -1;
+  }
+  return deviceLen;
+}
+
+/* ---------------- 环形缓冲 ---------------- */
+
+static bool ringPush(ingestParser_t *p, const ingestRecord_t *rec,
+                     const char *topic, const void *payload) {
+  uint32_t size = p->ringSize;
+  uint32_t tail = p->tail;
+  uint32_t pos = tail & (size - 1);
+  uint32_t contiguous = size - pos;
+  uint32_t total = rec->size <= contiguous ? rec->size : contiguous + rec->size;
+  if (size - (tail - p->headCache) < total) {
+    p->headCache = __atomic_load_n(&p->head, __ATOMIC_ACQUIRE);
+    if (size - (tail - p->headCache) < total) {
+      return false;
+    }
+  }
+
+  if (rec->size > contiguous) {
+    ingestRecord_t *wrap = (ingestRecord_t *)(p->ring + pos);
+    wrap->size = contiguous;
+    wrap->topicLen = RECORD_WRAP;
+    tail += contiguous;
+    pos = 0;
+  }
+  uint8_t *dst = p->ring + pos;
+  memcpy(dst, rec, sizeof(ingestRecord_t));
+  dst += sizeof(ingestRecord_t);
+  memcpy(dst, topic, rec->topicLen);
+  dst[rec->topicLen] = '\0';
+  memcpy(dst + rec->topicLen + 1, payload, rec->payloadLen);
+
+  // 与消费者对 sleeping 的写入和 tail 的读取构成 Dekker 式配对
+  __atomic_store_n(&p->tail, tail + rec->size, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&p->sleeping, __ATOMIC_SEQ_CST)) {
+    pthread_mutex_lock(&p->lock);
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+  }
+  return true;
+}
+
+int ingest_Submit(ingest_t *ingest, const char *topic, int topicLen,
+                  const void *payload, int payloadLen) {
+  uint64_t arrivalNs = monotonicNs();
+  if (topicLen <= 0) {
+    topicLen = strlen(topic); // paho 对以 '\0' 结尾的Topic传0
+  }
+  int deviceLen = parseTopic(topic, topicLen);
+  if (deviceLen < 0 || payloadLen < 0) {
+    bump(&ingest->badTopics);
+    return -1;
+  }
+
+  uint32_t hash = hashName(topic + TOPIC_PREFIX_LEN, deviceLen);
+  ingestParser_t *p = ingest->parsers[(hash >> 16) % ingest->parserCount];
+  ingestRecord_t rec = {
+      .size = (sizeof(ingestRecord_t) + topicLen + 1 + payloadLen +
+               RECORD_ALIGN - 1) & ~(uint32_t)(RECORD_ALIGN - 1),
+      .topicLen = topicLen,
+      .payloadLen = payloadLen,
+      .deviceLen = deviceLen,
+      .arrivalNs = arrivalNs,
+      .receivedMs = realtimeMs(),
+  };
+  if (payloadLen > ingest->config.maxPayloadBytes ||
+      rec.size > p->ringSize / 2) {
+    bump(&p->dropped);
+    return -1;
+  }
+
+  if (!ringPush(p, &rec, topic, payload)) {
+    // 缓冲满：短暂等待解析线程，接收线程阻塞期间由Broker和TCP缓冲积压
+    bump(&p->stalls);
+    uint64_t deadline = arrivalNs + SUBMIT_WAIT_MS * 1000000ULL;
+    bool pushed = false;
+    while (!pushed && monotonicNs() < deadline) {
+      usleep(50);
+      pushed = ringPush(p, &rec, topic, payload);
+    }
+    if (!pushed) {
+      bump(&p->dropped);
+      return -1;
+    }
+  }
+  bump(&p->received);
+  return 0;
+}
+
+/* ---------------- 解析线程 ---------------- */
+
+static ingestDevice_t *findDevice(ingestParser_t *p, const char *name,
+                                  int len) {
+  uint32_t bucket = hashName(name, len) % INGEST_DEVICE_BUCKETS;
+  for (ingestDevice_t *dev = p->buckets[bucket]; dev; dev = dev->next) {
+    if (strncmp(dev->name, name, len) == 0 && dev->name[len] == '\0') {
+      return dev;
+    }
+  }
+
+  ingestDevice_t *dev = (ingestDevice_t *)calloc(1, sizeof(ingestDevice_t));
+  if (!dev) {
+    return NULL;
+  }
+  memcpy(dev->name, name, len);
+  dev->online = -1;
+  dev->next = p->buckets[bucket];
+  p->buckets[bucket] = dev;
+  p->local.devices++;
+  return dev;
+}
+
+static columnSeries_t *findSeries(ingestParser_t *p, ingestDevice_t *dev,
+                                  const char *name, int len) {
+  char seriesName[INGEST_NAME_MAX];
+  columnStore_Sanitize(seriesName, sizeof(seriesName), name, len);
+  for (int i = 0; i < dev->seriesCount; i++) {
+    if (strcmp(dev->seriesNames[i], seriesName) == 0) {
+      return dev->series[i];
+    }
+  }
+  if (dev->seriesCount >= INGEST_MAX_SERIES) {
+    p->local.droppedSeries++;
+    return NULL;
+  }
+
+  char deviceName[INGEST_NAME_MAX];
+  columnStore_Sanitize(deviceName, sizeof(deviceName), dev->name,
+                       strlen(dev->name));
+  columnSeries_t *series = (columnSeries_t *)malloc(sizeof(columnSeries_t));
+  if (!series || columnSeries_Init(series, p->ingest->outputDir, deviceName,
+                                   seriesName) != 0) {
+    free(series);
+    p->local.droppedSeries++;
+    return NULL;
+  }
+  strcpy(dev->seriesNames[dev->seriesCount], seriesName);
+  dev->series[dev->seriesCount++] = series;
+  return series;
+}
+
+/* 数值、布尔和null字段按名称存为列，嵌套一层的对象展开为 "父.子" */
+static void appendFields(ingestParser_t *p, columnSeries_t *series,
+                         const cJSON *object, const char *prefix) {
+  for (const cJSON *item = object->child; item; item = item->next) {
+    if (!item->string) {
+      continue;
+    }
+    char name[COLUMN_NAME_MAX];
+    if (prefix) {
+      snprintf(name, sizeof(name), "%s.%s", prefix, item->string);
+    } else {
+      snprintf(name, sizeof(name), "%s", item->string);
+    }
+    if (cJSON_IsNumber(item)) {
+      columnSeries_Set(series, name, item->valuedouble, &p->local.store);
+    } else if (cJSON_IsBool(item)) {
+      columnSeries_Set(series, name, cJSON_IsTrue(item) ? 1 : 0,
+                       &p->local.store);
+    } else if (cJSON_IsNull(item)) {
+      columnSeries_Set(series, name, NAN, &p->local.store);
+    } else if (cJSON_IsObject(item) && !prefix) {
+      appendFields(p, series, item, name);
+    }
+    // 字符串和数组不存储
+  }
+}
+
+/* online 话题：在线消息和LWT离线消息，status 存为 online 列（1/0） */
+static void updateOnline(ingestParser_t *p, ingestDevice_t *dev,
+                         const cJSON *root, columnSeries_t *series,
+                         int64_t receivedMs) {
+  const cJSON *status = cJSON_GetObjectItemCaseSensitive(root, "status");
+  if (!cJSON_IsString(status)) {
+    return;
+  }
+  int online = strcmp(status->valuestring, "online") == 0    ? 1
+               : strcmp(status->valuestring, "offline") == 0 ? 0
+                                                             : -1;
+  if (online < 0) {
+    return;
+  }
+  if (series) {
+    columnSeries_Set(series, "online", online, &p->local.store);
+  }
+  if (online == 0) {
+    dev->offlines++;
+  }
+  if (dev->online == online) {
+    return;
+  }
+
+  if (dev->online == 1) {
+    p->local.online--;
+  } else if (dev->online == 0) {
+    p->local.offline--;
+  }
+  if (online) {
+    p->local.online++;
+  } else {
+    p->local.offline++;
+  }
+  dev->online = online;
+  const cJSON *ts = cJSON_GetObjectItemCaseSensitive(root, "timestamp_ms");
+  dev->statusMs = cJSON_IsNumber(ts) ? (int64_t)ts->valuedouble : receivedMs;
+}
+
+static void handleRecord(ingestParser_t *p, const ingestRecord_t *rec) {
+  ingest_t *ingest = p->ingest;
+  uint64_t startNs = monotonicNs();
+  const char *topic = (const char *)(rec + 1);
+  const char *payload = topic + rec->topicLen + 1;
+  const char *deviceName = topic + TOPIC_PREFIX_LEN;
+  const char *seriesName = deviceName + rec->deviceLen + 1;
+  int seriesLen = (int)(topic + rec->topicLen - seriesName);
+
+  ingestDevice_t *dev = findDevice(p, deviceName, rec->deviceLen);
+  if (!dev) {
+    p->local.parseErrors++;
+    return;
+  }
+  dev->messages++;
+  dev->lastSeenMs = rec->receivedMs;
+
+  const char *json = payload;
+  int len = rec->payloadLen;
+  if (payloadCodec_IsCompressed(payload, len)) {
+    len = payloadCodec_Decompress((const uint8_t *)payload, len, p->unpacked,
+                                  ingest->config.maxPayloadBytes);
+    json = p->unpacked;
+  }
+  cJSON *root = len > 0 ? cJSON_ParseWithLength(json, len) : NULL;
+  if (!cJSON_IsObject(root)) {
+    p->local.parseErrors++;
+    cJSON_Delete(root);
+    return;
+  }
+
+  columnSeries_t *series = findSeries(p, dev, seriesName, seriesLen);
+  if (series) {
+    columnSeries_Set(series, "_received_ms", (double)rec->receivedMs,
+                     &p->local.store);
+    appendFields(p, series, root, NULL);
+  }
+  if (seriesLen == 6 && memcmp(seriesName, "online", 6) == 0) {
+    updateOnline(p, dev, root, series, rec->receivedMs);
+  }
+  const cJSON *ts = cJSON_GetObjectItemCaseSensitive(root, "timestamp_ms");
+  if (cJSON_IsNumber(ts)) {
+    int64_t lagMs = realtimeMs() - (int64_t)ts->valuedouble;
+    histAdd(p->local.e2eLagHist, lagMs > 0 ? (uint64_t)lagMs : 0);
+    p->local.e2eSamples++;
+  }
+  cJSON_Delete(root);
+
+  // 解析耗时不含写文件，写文件的开销见 store 统计
+  uint64_t endNs = monotonicNs();
+  uint64_t parseNs = endNs - startNs;
+  p->local.parseNsTotal += parseNs;
+  if (parseNs > p->local.parseNsMax) {
+    p->local.parseNsMax = parseNs;
+  }
+  histAdd(p->local.parseHist, parseNs);
+  uint64_t lagUs = (endNs - rec->arrivalNs) / 1000;
+  histAdd(p->local.queueLagHist, lagUs);
+  if (lagUs > p->local.queueLagMaxUs) {
+    p->local.queueLagMaxUs = (uint32_t)lagUs;
+  }
+  p->local.parsed++;
+
+  if (series) {
+    columnSeries_EndRow(series, ingest->config.batchRows, (int64_t)endNs,
+                        &p->local.store);
+  }
+}
+
+/* 写入缓存时间超过 flushIntervalMs 的系列，all 为 true 时全部写入 */
+static void flushSeries(ingestParser_t *p, int64_t nowNs, bool all) {
+  int64_t maxAgeNs = (int64_t)p->ingest->config.flushIntervalMs * 1000000;
+  for (int b = 0; b < INGEST_DEVICE_BUCKETS; b++) {
+    for (ingestDevice_t *dev = p->buckets[b]; dev; dev = dev->next) {
+      for (int i = 0; i < dev->seriesCount; i++) {
+        columnSeries_t *series = dev->series[i];
+        if (series->rows > 0 &&
+            (all || nowNs - series->firstNs >= maxAgeNs)) {
+          columnSeries_Flush(series, &p->local.store);
+        }
+      }
+    }
+  }
+}
+
+static void publishStats(ingestParser_t *p) {
+  pthread_mutex_lock(&p->lock);
+  p->shared = p->local;
+  pthread_mutex_unlock(&p->lock);
+}
+
+/*
+ * @brief 解析线程：每次最多处理 DRAIN_BATCH 条后发布统计，
+ *        缓冲为空时在条件变量上等待（生产者看到 sleeping 时唤醒）
+ * */
+static void *parserThreadFunc(void *arg) {
+  ingestParser_t *p = (ingestParser_t *)arg;
+  ingest_t *ingest = p->ingest;
+  uint32_t mask = p->ringSize - 1;
+  uint64_t lastCheckNs = monotonicNs();
+  int64_t waitNs = (int64_t)ingest->config.flushIntervalMs * 1000000 / 2;
+  if (waitNs > FLUSH_CHECK_NS) {
+    waitNs = FLUSH_CHECK_NS;
+  }
+
+  for (;;) {
+    int n = 0;
+    while (n < DRAIN_BATCH) {
+      if (p->head == p->tailCache) {
+        p->tailCache = __atomic_load_n(&p->tail, __ATOMIC_ACQUIRE);
+        if (p->head == p->tailCache) {
+          break;
+        }
+      }
+      const ingestRecord_t *rec =
+          (const ingestRecord_t *)(p->ring + (p->head & mask));
+      if (rec->topicLen != RECORD_WRAP) {
+        handleRecord(p, rec);
+        n++;
+      }
+      __atomic_store_n(&p->head, p->head + rec->size, __ATOMIC_RELEASE);
+    }
+
+    uint64_t nowNs = monotonicNs();
+    if (nowNs - lastCheckNs >= (uint64_t)waitNs) {
+      flushSeries(p, (int64_t)nowNs, false);
+      lastCheckNs = nowNs;
+    }
+    publishStats(p);
+    if (n == DRAIN_BATCH) {
+      continue;
+    }
+
+    // Stop 在最后一次 Submit 之后设置，此时重新读取的 tail 是最终值
+    if (__atomic_load_n(&ingest->stopping, __ATOMIC_ACQUIRE)) {
+      if (__atomic_load_n(&p->tail, __ATOMIC_ACQUIRE) == p->head) {
+        break;
+      }
+      continue;
+    }
+    pthread_mutex_lock(&p->lock);
+    __atomic_store_n(&p->sleeping, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&p->tail, __ATOMIC_SEQ_CST) == p->head &&
+        !__atomic_load_n(&ingest->stopping, __ATOMIC_ACQUIRE)) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_MONOTONIC, &deadline);
+      deadline.tv_nsec += waitNs;
+      if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+      }
+      pthread_cond_timedwait(&p->cond, &p->lock, &deadline);
+    }
+    __atomic_store_n(&p->sleeping, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&p->lock);
+  }
+
+  flushSeries(p, 0, true);
+  publishStats(p);
+  return NULL;
+}
+
+/*
+ * @brief 初始化
+ *
+ * @return 0 成功
+ * */
+int ingest_Init(ingest_t *ingest, const ingestConfig_t *config) {
+  if (!ingest || !config || !config->outputDir || config->parserCount <= 0 ||
+      config->parserCount > INGEST_MAX_PARSERS || config->ringBytes < 4096 ||
+      (config->ringBytes & (config->ringBytes - 1)) != 0 ||
+      config->batchRows <= 0 || config->maxPayloadBytes <= 0) {
+    return -1;
+  }
+
+  memset(ingest, 0, sizeof(ingest_t));
+  ingest->config = *config;
+  snprintf(ingest->outputDir, sizeof(ingest->outputDir), "%s",
+           config->outputDir);
+  ingest->config.outputDir = ingest->outputDir;
+  if (ingest->config.flushIntervalMs <= 0) {
+    ingest->config.flushIntervalMs = 1000;
+  }
+  if (mkdir(ingest->outputDir, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "Error creating %s: %s\n", ingest->outputDir,
+            strerror(errno));
+    return -1;
+  }
+
+  for (int i = 0; i < config->parserCount; i++) {
+    ingestParser_t *p = NULL;
+    if (posix_memalign((void **)&p, 64, sizeof(ingestParser_t)) != 0) {
+      ingest_Stop(ingest);
+      return -1;
+    }
+    memset(p, 0, sizeof(ingestParser_t));
+    p->ingest = ingest;
+    p->ringSize = (uint32_t)config->ringBytes;
+    p->ring = (uint8_t *)malloc(p->ringSize);
+    p->unpacked = (char *)malloc(config->maxPayloadBytes);
+    pthread_mutex_init(&p->lock, NULL);
+    initMonotonicCond(&p->cond);
+    ingest->parsers[ingest->parserCount] = p;
+    if (!p->ring || !p->unpacked ||
+        pthread_create(&p->thread, NULL, parserThreadFunc, p) != 0) {
+      free(p->ring);
+      free(p->unpacked);
+      free(p);
+      ingest->parsers[ingest->parserCount] = NULL;
+      ingest_Stop(ingest);
+      return -1;
+    }
+    ingest->parserCount++;
+  }
+  return 0;
+}
+
+void ingest_Stop(ingest_t *ingest) {
+  if (__atomic_exchange_n(&ingest->stopping, 1, __ATOMIC_ACQ_REL)) {
+    return;
+  }
+  for (int i = 0; i < ingest->parserCount; i++) {
+    ingestParser_t *p = ingest->parsers[i];
+    pthread_mutex_lock(&p->lock);
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+  }
+  for (int i = 0; i < ingest->parserCount; i++) {
+    pthread_join(ingest->parsers[i]->thread, NULL);
+  }
+}
+
+void ingest_GetStats(ingest_t *ingest, ingestStats_t *stats) {
+  memset(stats, 0, sizeof(ingestStats_t));
+  stats->badTopics = __atomic_load_n(&ingest->badTopics, __ATOMIC_RELAXED);
+
+  ingestParserStats_t sum;
+  memset(&sum, 0, sizeof(sum));
+  for (int i = 0; i < ingest->parserCount; i++) {
+    ingestParser_t *p = ingest->parsers[i];
+    stats->received += __atomic_load_n(&p->received, __ATOMIC_RELAXED);
+    stats->dropped += __atomic_load_n(&p->dropped, __ATOMIC_RELAXED);
+    stats->stalls += __atomic_load_n(&p->stalls, __ATOMIC_RELAXED);
+
+    ingestParserStats_t s;
+    pthread_mutex_lock(&p->lock);
+    s = p->shared;
+    pthread_mutex_unlock(&p->lock);
+    sum.parsed += s.parsed;
+    sum.parseErrors += s.parseErrors;
+    sum.droppedSeries += s.droppedSeries;
+    sum.devices += s.devices;
+    sum.online += s.online;
+    sum.offline += s.offline;
+    sum.parseNsTotal += s.parseNsTotal;
+    if (s.parseNsMax > sum.parseNsMax) {
+      sum.parseNsMax = s.parseNsMax;
+    }
+    if (s.queueLagMaxUs > sum.queueLagMaxUs) {
+      sum.queueLagMaxUs = s.queueLagMaxUs;
+    }
+    for (int k = 0; k < INGEST_HIST_BUCKETS; k++) {
+      sum.parseHist[k] += s.parseHist[k];
+      sum.queueLagHist[k] += s.queueLagHist[k];
+      sum.e2eLagHist[k] += s.e2eLagHist[k];
+    }
+    sum.store.rows += s.store.rows;
+    sum.store.bytes += s.store.bytes;
+    sum.store.writes += s.store.writes;
+    sum.store.flushes += s.store.flushes;
+    sum.store.errors += s.store.errors;
+    sum.store.droppedColumns += s.store.droppedColumns;
+  }
+
+  stats->parsed = sum.parsed;
+  stats->parseErrors = sum.parseErrors;
+  stats->droppedSeries = sum.droppedSeries;
+  stats->devices = sum.devices;
+  stats->online = sum.online;
+  stats->offline = sum.offline;
+  stats->parseAvgNs =
+      sum.parsed ? (uint32_t)(sum.parseNsTotal / sum.parsed) : 0;
+  stats->parseP99Ns = histPercentile(sum.parseHist, 99);
+  stats->parseMaxNs = (uint32_t)sum.parseNsMax;
+  stats->queueLagP99Us = histPercentile(sum.queueLagHist, 99);
+  stats->queueLagMaxUs = sum.queueLagMaxUs;
+  stats->e2eLagP50Ms = histPercentile(sum.e2eLagHist, 50);
+  stats->e2eLagP99Ms = histPercentile(sum.e2eLagHist, 99);
+  stats->store = sum.store;
+}
+
+static ingestDevice_t *lookupDevice(ingest_t *ingest, const char *name) {
+  int len = strlen(name);
+  uint32_t hash = hashName(name, len);
+  if (ingest->parserCount == 0) {
+    return NULL;
+  }
+  ingestParser_t *p = ingest->parsers[(hash >> 16) % ingest->parserCount];
+  for (ingestDevice_t *dev = p->buckets[hash % INGEST_DEVICE_BUCKETS]; dev;
+       dev = dev->next) {
+    if (strcmp(dev->name, name) == 0) {
+      return dev;
+    }
+  }
+  return NULL;
+}
+
+int ingest_GetDevice(ingest_t *ingest, const char *name,
+                     ingestDeviceInfo_t *info) {
+  ingestDevice_t *dev = lookupDevice(ingest, name);
+  if (!dev) {
+    return -1;
+  }
+  info->online = dev->online;
+  info->statusMs = dev->statusMs;
+  info->lastSeenMs = dev->lastSeenMs;
+  info->messages = dev->messages;
+  info->offlines = dev->offlines;
+  info->seriesCount = dev->seriesCount;
+  return 0;
+}
+
+int ingest_WriteDeviceIndex(ingest_t *ingest) {
+  char path[sizeof(ingest->outputDir) + 16];
+  snprintf(path, sizeof(path), "%s/devices.csv", ingest->outputDir);
+  FILE *fp = fopen(path, "w");
+  if (!fp) {
+    fprintf(stderr, "Error writing %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  static const char *states[] = {"unknown", "offline", "online"};
+  fprintf(fp, "device,state,status_ms,last_seen_ms,messages,offlines\n");
+  for (int i = 0; i < ingest->parserCount; i++) {
+    ingestParser_t *p = ingest->parsers[i];
+    for (int b = 0; b < INGEST_DEVICE_BUCKETS; b++) {
+      for (ingestDevice_t *dev = p->buckets[b]; dev; dev = dev->next) {
+        fprintf(fp, "%s,%s,%lld,%lld,%lu,%lu\n", dev->name,
+                states[dev->online + 1], (long long)dev->statusMs,
+                (long long)dev->lastSeenMs, dev->messages, dev->offlines);
+      }
+    }
+  }
+  return fclose(fp) == 0 ? 0 : -1;
+}
+
+void ingest_Deinit(ingest_t *ingest) {
+  ingest_Stop(ingest);
+  for (int i = 0; i < ingest->parserCount; i++) {
+    ingestParser_t *p = ingest->parsers[i];
+    for (int b = 0; b < INGEST_DEVICE_BUCKETS; b++) {
+      ingestDevice_t *dev = p->buckets[b];
+      while (dev) {
+        ingestDevice_t *next = dev->next;
+        for (int k = 0; k < dev->seriesCount; k++) {
+          columnSeries_Free(dev->series[k]);
+          free(dev->series[k]);
+        }
+        free(dev);
+        dev = next;
+      }
+    }
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->cond);
+    free(p->ring);
+    free(p->unpacked);
+    free(p);
+    ingest->parsers[i] = NULL;
+  }
+  ingest->parserCount = 0;
+}
@@ -0,0 +1,161 @@
+#ifndef _INGEST_H
+#define _INGEST_H
+
+#include "column_store.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 后台接入流水线：MQTT接收线程（唯一的生产者）把消息复制到解析线程的
+ * 无锁单生产者单消费者环形缓冲，按设备ID哈希选择解析线程，
+ * 同一设备的消息保持顺序，设备状态只由一个线程访问，不需要加锁。
+ * 解析线程用 cJSON 解析载荷（压缩帧先解压），把数值字段追加到设备的
+ * 列存储文件（见 column_store.h），并根据 online 话题跟踪在线/LWT离线状态
+ * */
+
+#define INGEST_MAX_PARSERS 16
+#define INGEST_NAME_MAX 64     // 设备ID、系列名称的上限
+#define INGEST_TOPIC_MAX 256
+#define INGEST_MAX_SERIES 16   // 每个设备的数据系列数
+#define INGEST_HIST_BUCKETS 32 // 按2的幂划分的延迟直方图
+#define INGEST_DEVICE_BUCKETS 4096
+
+/* 配置 */
+typedef struct {
+  const char *outputDir;
+  int parserCount;
+  int ringBytes;       // 每个解析线程的环形缓冲大小（2的幂）
+  int batchRows;       // 每列攒够多少行写一次文件
+  int flushIntervalMs; // 缓存的行最长等待多久写入
+  int maxPayloadBytes; // 单条消息（解压后）的上限
+} ingestConfig_t;
+
+/* 设备状态，由所属解析线程独占 */
+typedef struct ingestDevice {
+  struct ingestDevice *next;
+  char name[INGEST_NAME_MAX];
+  int online;       // 1 在线，0 离线（LWT），-1 尚未收到 online 消息
+  int64_t statusMs; // 最近一次状态变化的时间（载荷中的 timestamp_ms）
+  int64_t lastSeenMs;
+  unsigned long messages;
+  unsigned long offlines; // 收到离线（LWT）消息的次数
+  int seriesCount;
+  char seriesNames[INGEST_MAX_SERIES][INGEST_NAME_MAX];
+  columnSeries_t *series[INGEST_MAX_SERIES];
+} ingestDevice_t;
+
+/* 解析线程的统计，由解析线程定期发布 */
+typedef struct {
+  unsigned long parsed;
+  unsigned long parseErrors;
+  unsigned long droppedSeries; // 超过 INGEST_MAX_SERIES 的系列
+  int devices;
+  int online;
+  int offline;
+  uint64_t parseNsTotal; // 解压、解析和追加到列缓存的耗时
+  uint64_t parseNsMax;
+  unsigned long parseHist[INGEST_HIST_BUCKETS];   // 纳秒
+  unsigned long queueLagHist[INGEST_HIST_BUCKETS]; // 到达到解析完成，微秒
+  uint32_t queueLagMaxUs;
+  unsigned long e2eLagHist[INGEST_HIST_BUCKETS]; // 载荷时间戳到解析完成，毫秒
+  unsigned long e2eSamples;
+  columnStoreStats_t store;
+} ingestParserStats_t;
+
+/* 解析线程及其环形缓冲 */
+typedef struct {
+  struct ingest *ingest;
+  uint8_t *ring;
+  uint32_t ringSize;
+
+  // 生产者（接收线程）独占
+  uint32_t tail __attribute__((aligned(64)));
+  uint32_t headCache;
+  unsigned long received;
+  unsigned long dropped; // 缓冲满且等待超时
+  unsigned long stalls;  // 缓冲满需要等待的次数
+
+  // 消费者（解析线程）独占
+  uint32_t head __attribute__((aligned(64)));
+  uint32_t tailCache;
+  int sleeping; // 缓冲为空时等待条件变量
+  char *unpacked;
+  ingestDevice_t *buckets[INGEST_DEVICE_BUCKETS];
+  ingestParserStats_t local;
+
+  pthread_mutex_t lock __attribute__((aligned(64))); // 保护 shared 和休眠
+  pthread_cond_t cond;
+  ingestParserStats_t shared;
+  pthread_t thread;
+} ingestParser_t;
+
+typedef struct ingest {
+  ingestConfig_t config;
+  char outputDir[128];
+  int parserCount;
+  ingestParser_t *parsers[INGEST_MAX_PARSERS];
+  unsigned long badTopics; // 不是 sentinel/{device_id}/... 的Topic
+  int stopping;
+} ingest_t;
+
+/* 汇总统计 */
+typedef struct {
+  unsigned long received;
+  unsigned long parsed;
+  unsigned long dropped;
+  unsigned long stalls;
+  unsigned long badTopics;
+  unsigned long parseErrors;
+  unsigned long droppedSeries;
+  int devices;
+  int online;
+  int offline;
+  uint32_t parseAvgNs;
+  uint32_t parseP99Ns; // 按直方图估算（所在桶的上界）
+  uint32_t parseMaxNs;
+  uint32_t queueLagP99Us;
+  uint32_t queueLagMaxUs;
+  uint32_t e2eLagP50Ms; // 依赖设备与本机的时钟同步
+  uint32_t e2eLagP99Ms;
+  columnStoreStats_t store;
+} ingestStats_t;
+
+/* 设备信息 */
+typedef struct {
+  int online;
+  int64_t statusMs;
+  int64_t lastSeenMs;
+  unsigned long messages;
+  unsigned long offlines;
+  int seriesCount;
+} ingestDeviceInfo_t;
+
+/* 创建解析线程，outputDir 不存在时自动创建 */
+int ingest_Init(ingest_t *ingest, const ingestConfig_t *config);
+
+/*
+ * 提交一条消息（只能由一个线程调用，如 paho 的消息回调）。
+ * 环形缓冲满时最多等待1s（向Broker施加背压），仍然满则丢弃
+ *
+ * @return 0 成功，-1 Topic不合法、消息过大或被丢弃
+ * */
+int ingest_Submit(ingest_t *ingest, const char *topic, int topicLen,
+                  const void *payload, int payloadLen);
+
+void ingest_GetStats(ingest_t *ingest, ingestStats_t *stats);
+
+/* 停止：解析线程处理完缓冲中的消息，写入所有缓存的行后退出 */
+void ingest_Stop(ingest_t *ingest);
+
+/* 查询设备（停止后调用），不存在返回-1 */
+int ingest_GetDevice(ingest_t *ingest, const char *name,
+                     ingestDeviceInfo_t *info);
+
+/* 写入设备索引 <outputDir>/devices.csv（停止后调用） */
+int ingest_WriteDeviceIndex(ingest_t *ingest);
+
+/* 释放设备和缓冲 */
+void ingest_Deinit(ingest_t *ingest);
+
+#endif // !_INGEST_H
@@ -0,0 +1,221 @@
+#include <MQTTClient.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ingest/ingest.h"
+
+/*
+ * Backend ingestion subscriber for Sentinel uplink topics.
+ *
+ * Subscribes to `sentinel/+/#` (override with -t) and hands every message to
+ * a pool of parser threads (see ingest/ingest.h). Numeric fields of each
+ * payload are stored per device and series as columnar files under the
+ * output directory, e.g. `data/ATK-IMX6U-01/light/light_lux.f64` (native
+ * doubles, NaN for missing values, plus a `_received_ms` column). Device
+ * online/offline (LWT) state is summarized in `data/devices.csv` on exit.
+ * Compressed payloads (docs section 5.6) are decompressed transparently.
+ *
+ * Every -r seconds a line with messages/sec, parse cost, queue and
+ * end-to-end lag, device counts and write volume is printed to stderr.
+ *
+ * gcc -std=gnu11 -O2 -D_GNU_SOURCE -I../../sentinel/include
+ *     -I../../sentinel/src/third_party ingest_subscriber.c
+ *     ingest/ingest.c ingest/column_store.c
+ *     ../../sentinel/src/modules/payload_codec/payload_codec.c
+ *     ../../sentinel/src/modules/mem_pool/mem_pool.c
+ *     ../../sentinel/src/third_party/cJSON/cJSON.c
+ *     -lpaho-mqtt3c -lpthread -lm -o ingest_subscriber
+ * */
+
+static volatile sig_atomic_t g_exit = 0;
+static volatile int g_connectionLost = 0;
+
+static void signalHandle(int sig) { g_exit = 1; }
+
+static int messageArrived(void *context, char *topicName, int topicLen,
+                          MQTTClient_message *message) {
+  ingest_Submit((ingest_t *)context, topicName, topicLen, message->payload,
+                message->payloadlen);
+  MQTTClient_freeMessage(&message);
+  MQTTClient_free(topicName);
+  return 1;
+}
+
+static void connectionLost(void *context, char *cause) {
+  fprintf(stderr, "Connection lost: %s\n", cause ? cause : "unknown");
+  g_connectionLost = 1;
+}
+
+static int connectAndSubscribe(MQTTClient client, const char *username,
+                               const char *password, const char *topic,
+                               int qos) {
+  MQTTClient_connectOptions opts = MQTTClient_connectOptions_initializer;
+  opts.keepAliveInterval = 30;
+  opts.cleansession = 1;
+  opts.username = username;
+  opts.password = password;
+  // 解析线程落后时接收线程会阻塞，QoS 1 需要更多的在途消息
+  opts.maxInflightMessages = 1024;
+  int rc = MQTTClient_connect(client, &opts);
+  if (rc != MQTTCLIENT_SUCCESS) {
+    fprintf(stderr, "Connect failed: %d\n", rc);
+    return -1;
+  }
+  rc = MQTTClient_subscribe(client, topic, qos);
+  if (rc != MQTTCLIENT_SUCCESS) {
+    fprintf(stderr, "Subscribe %s failed: %d\n", topic, rc);
+    MQTTClient_disconnect(client, 1000);
+    return -1;
+  }
+  g_connectionLost = 0;
+  fprintf(stderr, "Subscribed to %s\n", topic);
+  return 0;
+}
+
+static void printStats(const ingestStats_t *stats, double rate) {
+  fprintf(stderr,
+          "%.0f msg/s, total %lu (dropped %lu, stalls %lu, bad topic %lu, "
+          "parse errors %lu), parse avg %.1f us p99 %.1f us, queue lag p99 "
+          "%u us, e2e lag p50 %u ms p99 %u ms, devices %d (online %d, "
+          "offline %d), written %.1f MB in %lu writes\n",
+          rate, stats->received, stats->dropped, stats->stalls,
+          stats->badTopics, stats->parseErrors, stats->parseAvgNs / 1000.0,
+          stats->parseP99Ns / 1000.0, stats->queueLagP99Us,
+          stats->e2eLagP50Ms, stats->e2eLagP99Ms, stats->devices,
+          stats->online, stats->offline,
+          stats->store.bytes / (1024.0 * 1024.0), stats->store.writes);
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "Usage: %s [-a address] [-i client_id] [-u username] "
+          "[-P password] [-t topic] [-q qos] [-o dir] [-j parsers] "
+          "[-b batch_rows] [-f flush_ms] [-r report_sec]\n",
+          name);
+}
+
+int main(int argc, char *argv[]) {
+  const char *address = "tcp://127.0.0.1:1883";
+  const char *username = NULL;
+  const char *password = NULL;
+  const char *topic = "sentinel/+/#";
+  char clientId[64];
+  snprintf(clientId, sizeof(clientId), "sentinel-ingest-%d", (int)getpid());
+  int qos = 0;
+  int reportSec = 5;
+  ingestConfig_t config = {
+      .outputDir = "sentinel_data",
+      .parserCount = 4,
+      .ringBytes = 4 * 1024 * 1024,
+      .batchRows = 1024,
+      .flushIntervalMs = 2000,
+      .maxPayloadBytes = 64 * 1024,
+  };
+
+  int opt;
+  while ((opt = getopt(argc, argv, "a:i:u:P:t:q:o:j:b:f:r:h")) != -1) {
+    switch (opt) {
+    case 'a':
+      address = optarg;
+      break;
+    case 'i':
+      snprintf(clientId, sizeof(clientId), "%s", optarg);
+      break;
+    case 'u':
+      username = optarg;
+      break;
+    case 'P':
+      password = optarg;
+      break;
+    case 't':
+      topic = optarg;
+      break;
+    case 'q':
+      qos = atoi(optarg);
+      break;
+    case 'o':
+      config.outputDir = optarg;
+      break;
+    case 'j':
+      config.parserCount = atoi(optarg);
+      break;
+    case 'b':
+      config.batchRows = atoi(optarg);
+      break;
+    case 'f':
+      config.flushIntervalMs = atoi(optarg);
+      break;
+    case 'r':
+      reportSec = atoi(optarg) > 0 ? atoi(optarg) : 1;
+      break;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  static ingest_t ingest;
+  if (ingest_Init(&ingest, &config) != 0) {
+    fprintf(stderr, "Ingest initial failed.\n");
+    return EXIT_FAILURE;
+  }
+
+  MQTTClient client;
+  if (MQTTClient_create(&client, address, clientId,
+                        MQTTCLIENT_PERSISTENCE_NONE,
+                        NULL) != MQTTCLIENT_SUCCESS) {
+    fprintf(stderr, "Client create failed.\n");
+    ingest_Deinit(&ingest);
+    return EXIT_FAILURE;
+  }
+  MQTTClient_setCallbacks(client, &ingest, connectionLost, messageArrived,
+                          NULL);
+
+  signal(SIGINT, signalHandle);
+  signal(SIGTERM, signalHandle);
+
+  ingestStats_t stats;
+  unsigned long lastParsed = 0;
+  struct timespec last;
+  clock_gettime(CLOCK_MONOTONIC, &last);
+  bool connected = false;
+  int retryDelaySec = 1;
+  while (!g_exit) {
+    if (!connected || g_connectionLost || !MQTTClient_isConnected(client)) {
+      connected = connectAndSubscribe(client, username, password, topic,
+                                      qos) == 0;
+      if (!connected) {
+        sleep(retryDelaySec);
+        retryDelaySec = retryDelaySec < 30 ? retryDelaySec * 2 : 30;
+        continue;
+      }
+      retryDelaySec = 1;
+    }
+
+    sleep(reportSec);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (now.tv_sec - last.tv_sec) +
+                     (now.tv_nsec - last.tv_nsec) / 1e9;
+    ingest_GetStats(&ingest, &stats);
+    printStats(&stats, (stats.parsed - lastParsed) / elapsed);
+    lastParsed = stats.parsed;
+    last = now;
+  }
+
+  if (MQTTClient_isConnected(client)) {
+    MQTTClient_disconnect(client, 1000);
+  }
+  MQTTClient_destroy(&client);
+
+  ingest_Stop(&ingest);
+  ingest_GetStats(&ingest, &stats);
+  printStats(&stats, 0);
+  ingest_WriteDeviceIndex(&ingest);
+  ingest_Deinit(&ingest);
+  return EXIT_SUCCESS;
+}
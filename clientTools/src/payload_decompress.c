@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "modules/payload_codec.h"
+
+/*
+ * Reference decompressor for Sentinel uplink payloads.
+ *
+ * Reads one MQTT payload exactly as received (e.g. `mosquitto_sub -C 1 -N
+ * -t sentinel/+/status > msg.bin`) from a file or stdin and writes the JSON
+ * document to stdout. Uncompressed JSON payloads are passed through, so the
+ * tool can sit in front of any consumer.
+ *
+ * gcc -std=gnu11 -I../../sentinel/include payload_decompress.c
+ *     ../../sentinel/src/modules/payload_codec/payload_codec.c
+ *     ../../sentinel/src/modules/mem_pool/mem_pool.c
+ *     ../../sentinel/src/third_party/cJSON/cJSON.c
+ *     -I../../sentinel/src/third_party -lpthread -o payload_decompress
+ * */
+#define MAX_PAYLOAD (256 * 1024)
+
+int main(int argc, char *argv[]) {
+  static unsigned char input[MAX_PAYLOAD];
+  static char output[MAX_PAYLOAD];
+  FILE *fp = stdin;
+
+  if (argc > 1 && strcmp(argv[1], "--dict") == 0) {
+    size_t dictLen = 0;
+    const char *dict = payloadCodec_GetDictionary(&dictLen);
+    fwrite(dict, 1, dictLen, stdout);
+    printf("\n");
+    return EXIT_SUCCESS;
+  }
+
+  if (argc > 1 && (fp = fopen(argv[1], "rb")) == NULL) {
+    perror("Error opening payload file");
+    return EXIT_FAILURE;
+  }
+
+  size_t inLen = fread(input, 1, sizeof(input), fp);
+  if (fp != stdin) {
+    fclose(fp);
+  }
+
+  if (!payloadCodec_IsCompressed(input, (int)inLen)) {
+    fwrite(input, 1, inLen, stdout);
+    return EXIT_SUCCESS;
+  }
+
+  int outLen = payloadCodec_Decompress(input, (int)inLen, output,
+                                       sizeof(output));
+  if (outLen < 0) {
+    fprintf(stderr, "Corrupted compressed payload (%zu bytes).\n", inLen);
+    return EXIT_FAILURE;
+  }
+
+  fwrite(output, 1, outLen, stdout);
+  fprintf(stderr, "%zu -> %d bytes\n", inLen, outLen);
+  return EXIT_SUCCESS;
+}
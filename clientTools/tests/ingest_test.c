@@ -0,0 +1,379 @@
+#include "../../sentinel/tests/test_check.h"
+#include "../src/ingest/ingest.h"
+#include "modules/mem_pool.h"
+#include "modules/payload_codec.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * 接入流水线，对着本地的Broker替身运行。
+ *
+ * 替身线程扮演Paho的投递线程：先投递每个设备保留的上线消息，再尽流水线所能
+ * 接收的速度发送协议规范第5节的各种载荷（status、light、gpio、modbus、
+ * response；status 按5.6压缩），其间穿插格式错误的载荷和无关的主题，最后
+ * 发送部分设备的LWT下线消息。检查消息统计、列存文件（行对齐、缺失和迟到的
+ * 字段为NaN、数值顺序）、上下线跟踪，以及强制回绕和反压的小环形缓冲。输出
+ * 持续的每秒消息数、解析开销和延迟
+ * */
+#define DEVICES 2000
+#define ROUNDS 100
+#define STATUS_EVERY 10
+#define MODBUS_EVERY 5
+#define GPIO_EVERY 4
+#define SETTLED_FROM 12 // gpio 的 settled 字段从第12条开始出现
+#define OFFLINE_EVERY 10
+#define MALFORMED 50
+#define BAD_TOPICS 30
+
+static int64_t realtimeMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static double nowSec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* ---------------- Broker替身 ---------------- */
+
+typedef struct {
+  ingest_t *ingest;
+  int devices;
+  int rounds;
+  payloadCodec_t codec;
+  unsigned long valid; // 应被解析的消息数
+  unsigned long compressed;
+} standIn_t;
+
+static void deliver(standIn_t *b, const char *device, const char *series,
+                    const char *payload, int len) {
+  char topic[128];
+  snprintf(topic, sizeof(topic), "sentinel/%s/%s", device, series);
+  CHECK(ingest_Submit(b->ingest, topic, 0, payload, len) == 0);
+  b->valid++;
+}
+
+static void deviceName(char *out, int size, int index) {
+  snprintf(out, size, "dev%04d", index);
+}
+
+static void *standInThread(void *arg) {
+  standIn_t *b = (standIn_t *)arg;
+  char device[32];
+  char payload[512];
+  uint8_t packed[PAYLOAD_CODEC_BOUND(512)];
+
+  // 订阅时先收到所有设备保留的 online 消息
+  for (int d = 0; d < b->devices; d++) {
+    deviceName(device, sizeof(device), d);
+    int len = snprintf(payload, sizeof(payload),
+                       "{\"status\": \"online\", \"timestamp_ms\": %lld}",
+                       (long long)realtimeMs());
+    deliver(b, device, "online", payload, len);
+  }
+
+  int malformed = 0;
+  for (int r = 0; r < b->rounds; r++) {
+    for (int d = 0; d < b->devices; d++) {
+      deviceName(device, sizeof(device), d);
+      long long ts = (long long)realtimeMs();
+      int len = snprintf(payload, sizeof(payload),
+                         "{\"timestamp_ms\": %lld,\"light_lux\": %d,"
+                         "\"infrared_cd\": %d,\"sensor_id\": \"ap3216c_01\","
+                         "\"sample_hz\": 1.0}",
+                         ts, r * 10 + d % 7, r);
+      deliver(b, device, "light", payload, len);
+
+      if (r % STATUS_EVERY == 0) {
+        len = snprintf(payload, sizeof(payload),
+                       "{\"timestamp_ms\": %lld,\"cpu_temp_c\": %.1f,"
+                       "\"mem_usage_percent\": 0.45,\"uptime_seconds\": %d,"
+                       "\"network_rx_kbps\": 120,\"network_tx_kbps\": 80,"
+                       "\"peak_rss_kb\": 2048,\"sample_hz\": 1.0}",
+                       ts, 40.0 + r / 10, r);
+        int packedLen = payloadCodec_Compress(&b->codec, payload, len, packed,
+                                              sizeof(packed));
+        if (packedLen > 0) {
+          deliver(b, device, "status", (const char *)packed, packedLen);
+          b->compressed++;
+        } else {
+          deliver(b, device, "status", payload, len);
+        }
+      }
+      if (r % GPIO_EVERY == 0) {
+        int n = r / GPIO_EVERY;
+        if (n < SETTLED_FROM) {
+          len = snprintf(payload, sizeof(payload),
+                         "{\"timestamp_ms\": %lld,\"name\": \"key0\","
+                         "\"line\": 18,\"value\": %d,\"edge\": \"falling\","
+                         "\"kernel_ts_ns\": 52318861234}",
+                         ts, n % 2);
+        } else {
+          len = snprintf(payload, sizeof(payload),
+                         "{\"timestamp_ms\": %lld,\"name\": \"key0\","
+                         "\"line\": 18,\"value\": %d,\"edge\": \"falling\","
+                         "\"kernel_ts_ns\": 52318861234,\"settled\": %s}",
+                         ts, n % 2, n % 3 ? "false" : "true");
+        }
+        deliver(b, device, "gpio", payload, len);
+      }
+      if (r % MODBUS_EVERY == 0) {
+        len = snprintf(payload, sizeof(payload),
+                       "{\"device\": \"meter1\",\"timestamp_ms\": %lld,"
+                       "\"cycle_us\": 1830,\"values\": {\"voltage\": 230.5,"
+                       "\"current\": -1.5,\"energy_kwh\": %d.5,"
+                       "\"frequency\": null}}",
+                       ts, r);
+        deliver(b, device, "modbus", payload, len);
+      }
+      if (d % 100 == 0 && r == b->rounds / 2) {
+        len = snprintf(payload, sizeof(payload),
+                       "{\"command_id\": \"CTL_LED_%d\",\"status\": "
+                       "\"success\",\"error_code\": 0,\"result_data\": "
+                       "{\"current_state\": 1}}",
+                       d);
+        deliver(b, device, "response", payload, len);
+      }
+
+      // 损坏的载荷和不属于网关的Topic
+      if (malformed < MALFORMED && (r * b->devices + d) % 997 == 0) {
+        ingest_Submit(b->ingest, "sentinel/dev0001/light", 0, "{\"light", 7);
+        malformed++;
+      }
+      if (d == r % b->devices && r < BAD_TOPICS) {
+        CHECK(ingest_Submit(b->ingest, "app/console/control", 0, "{}", 2) <
+              0);
+      }
+    }
+  }
+  while (malformed < MALFORMED) {
+    ingest_Submit(b->ingest, "sentinel/dev0001/light", 0, "not json", 8);
+    malformed++;
+  }
+
+  // LWT：部分设备离线
+  for (int d = 0; d < b->devices; d += OFFLINE_EVERY) {
+    deviceName(device, sizeof(device), d);
+    int len = snprintf(payload, sizeof(payload),
+                       "{\"status\": \"offline\", \"timestamp_ms\": %lld}",
+                       (long long)realtimeMs());
+    deliver(b, device, "online", payload, len);
+  }
+  return NULL;
+}
+
+/* ---------------- 检查列文件 ---------------- */
+
+static double *readColumn(const char *dir, const char *device,
+                          const char *series, const char *column,
+                          long *rows) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s/%s/%s.f64", dir, device, series, column);
+  *rows = -1;
+  FILE *fp = fopen(path, "rb");
+  if (!fp) {
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  double *values = (double *)malloc(size > 0 ? size : 1);
+  *rows = (long)fread(values, sizeof(double), size / sizeof(double), fp);
+  fclose(fp);
+  return values;
+}
+
+static void checkFiles(const char *dir, int rounds) {
+  long rows;
+  int gpioRows = (rounds + GPIO_EVERY - 1) / GPIO_EVERY;
+
+  // 光照：每轮一行，按到达顺序
+  double *lux = readColumn(dir, "dev0007", "light", "light_lux", &rows);
+  CHECK(rows == rounds);
+  bool ordered = lux != NULL;
+  for (long i = 0; lux && i < rows; i++) {
+    ordered = ordered && lux[i] == i * 10 + 0;
+  }
+  CHECK(ordered);
+  free(lux);
+  double *received = readColumn(dir, "dev0007", "light", "_received_ms",
+                                &rows);
+  CHECK(rows == rounds && received && received[0] > 1.6e12);
+  free(received);
+  // 字符串字段不存储
+  double *sensor = readColumn(dir, "dev0007", "light", "sensor_id", &rows);
+  CHECK(sensor == NULL);
+
+  // 压缩的状态消息
+  double *temp = readColumn(dir, "dev0003", "status", "cpu_temp_c", &rows);
+  CHECK(rows == (rounds + STATUS_EVERY - 1) / STATUS_EVERY);
+  CHECK(temp && temp[0] == 40.0);
+  free(temp);
+
+  // 晚出现的字段：之前的行（含已写入文件的批次）为 NaN，与其他列对齐
+  double *settled = readColumn(dir, "dev0005", "gpio", "settled", &rows);
+  long valueRows;
+  double *value = readColumn(dir, "dev0005", "gpio", "value", &valueRows);
+  CHECK(rows == gpioRows && valueRows == gpioRows);
+  bool padded = settled != NULL && value != NULL;
+  for (long i = 0; padded && i < rows; i++) {
+    if (i < SETTLED_FROM) {
+      padded = isnan(settled[i]);
+    } else {
+      padded = settled[i] == (i % 3 ? 0 : 1);
+    }
+    padded = padded && value[i] == i % 2;
+  }
+  CHECK(padded);
+  free(settled);
+  free(value);
+
+  // 嵌套对象展开，null 为 NaN
+  double *voltage =
+      readColumn(dir, "dev0009", "modbus", "values.voltage", &rows);
+  CHECK(rows == (rounds + MODBUS_EVERY - 1) / MODBUS_EVERY);
+  CHECK(voltage && voltage[0] == 230.5);
+  free(voltage);
+  double *freq =
+      readColumn(dir, "dev0009", "modbus", "values.frequency", &rows);
+  CHECK(rows == (rounds + MODBUS_EVERY - 1) / MODBUS_EVERY);
+  CHECK(freq && isnan(freq[0]));
+  free(freq);
+
+  double *state = readColumn(dir, "dev0010", "online", "online", &rows);
+  CHECK(rows == 2 && state && state[0] == 1 && state[1] == 0);
+  free(state);
+}
+
+static void run(const char *dir, int devices, int rounds, int parsers,
+                int ringBytes, int batchRows, bool verify) {
+  static ingest_t ingest;
+  ingestConfig_t config = {
+      .outputDir = dir,
+      .parserCount = parsers,
+      .ringBytes = ringBytes,
+      .batchRows = batchRows,
+      .flushIntervalMs = 1000,
+      .maxPayloadBytes = 4096,
+  };
+  CHECK(ingest_Init(&ingest, &config) == 0);
+
+  static standIn_t b;
+  memset(&b, 0, sizeof(b));
+  b.ingest = &ingest;
+  b.devices = devices;
+  b.rounds = rounds;
+  payloadCodecConfig_t codecConfig = {.enabled = true,
+                                      .minBytes = 0,
+                                      .maxPayloadBytes = 512,
+                                      .topicCount = 1,
+                                      .topics = {"status"}};
+  CHECK(payloadCodec_Init(&b.codec, &codecConfig) == 0);
+
+  double start = nowSec();
+  pthread_t thread;
+  pthread_create(&thread, NULL, standInThread, &b);
+  pthread_join(thread, NULL);
+  double produced = nowSec() - start;
+
+  // 等待解析线程追上
+  ingestStats_t stats;
+  unsigned long expected = b.valid + MALFORMED;
+  do {
+    usleep(1000);
+    ingest_GetStats(&ingest, &stats);
+  } while (stats.parsed + stats.parseErrors < stats.received &&
+           nowSec() - start < 60);
+  double elapsed = nowSec() - start;
+  ingest_Stop(&ingest);
+  ingest_GetStats(&ingest, &stats);
+
+  printf("ingest (%d parsers, %d KB ring): %lu messages in %.2f s "
+         "(%.0f msg/s, stand-in %.0f msg/s), %lu compressed, stalls %lu, "
+         "parse avg %.2f us p99 %.2f us max %.1f us, queue lag p99 %u us "
+         "max %u us, e2e lag p50 %u ms p99 %u ms, %lu rows, %.1f MB in "
+         "%lu writes (%lu flushes)\n",
+         parsers, ringBytes / 1024, stats.received, elapsed,
+         stats.received / elapsed, stats.received / produced, b.compressed,
+         stats.stalls, stats.parseAvgNs / 1000.0, stats.parseP99Ns / 1000.0,
+         stats.parseMaxNs / 1000.0, stats.queueLagP99Us, stats.queueLagMaxUs,
+         stats.e2eLagP50Ms, stats.e2eLagP99Ms, stats.store.rows,
+         stats.store.bytes / (1024.0 * 1024.0), stats.store.writes,
+         stats.store.flushes);
+
+  CHECK(stats.received == expected);
+  CHECK(stats.dropped == 0);
+  CHECK(stats.parsed == b.valid);
+  CHECK(stats.parseErrors == MALFORMED);
+  CHECK(stats.badTopics == BAD_TOPICS);
+  CHECK(stats.store.errors == 0);
+  CHECK(stats.store.rows == b.valid);
+  CHECK(stats.devices == devices);
+  CHECK(stats.offline == (devices + OFFLINE_EVERY - 1) / OFFLINE_EVERY);
+  CHECK(stats.online == devices - stats.offline);
+  CHECK(stats.e2eLagP99Ms < 5000);
+  // 批量写入：平均每次 write 远大于一行
+  CHECK(stats.store.bytes / stats.store.writes > 8 * 4);
+
+  ingestDeviceInfo_t info;
+  CHECK(ingest_GetDevice(&ingest, "dev0020", &info) == 0);
+  CHECK(info.online == 0 && info.offlines == 1 && info.statusMs > 0);
+  CHECK(ingest_GetDevice(&ingest, "dev0021", &info) == 0);
+  CHECK(info.online == 1 && info.seriesCount >= 5);
+  CHECK(ingest_GetDevice(&ingest, "nobody", &info) < 0);
+
+  if (verify) {
+    checkFiles(dir, rounds);
+    CHECK(ingest_WriteDeviceIndex(&ingest) == 0);
+    char path[256];
+    snprintf(path, sizeof(path), "%s/devices.csv", dir);
+    FILE *fp = fopen(path, "r");
+    int lines = 0;
+    char line[256];
+    while (fp && fgets(line, sizeof(line), fp)) {
+      lines++;
+    }
+    if (fp) {
+      fclose(fp);
+    }
+    CHECK(lines == devices + 1);
+  }
+  ingest_Deinit(&ingest);
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  char dir[] = "/tmp/ingest_testXXXXXX";
+  if (!mkdtemp(dir)) {
+    return 1;
+  }
+  char small[sizeof(dir) + 8];
+  char large[sizeof(dir) + 8];
+  snprintf(small, sizeof(small), "%s/small", dir);
+  snprintf(large, sizeof(large), "%s/large", dir);
+
+  // 每批8行：晚出现的字段需要为已写入文件的行补 NaN
+  run(dir, 200, ROUNDS, 4, 4 * 1024 * 1024, 8, true);
+  run(large, DEVICES, ROUNDS, 4, 4 * 1024 * 1024, 1024, false);
+  // 最小的环形缓冲：频繁回绕，接收线程需要等待解析线程
+  run(small, 50, 40, 1, 4096, 64, false);
+
+  char command[64];
+  snprintf(command, sizeof(command), "rm -rf %s", dir);
+  if (system(command) != 0) {
+    fprintf(stderr, "Failed to remove %s\n", dir);
+  }
+
+  return testReport("ingest_test");
+}
@@ -0,0 +1,70 @@
+#ifndef _ADAPTIVE_RATE_H
+#define _ADAPTIVE_RATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ADAPTIVE_RATE_WINDOW 16
+
+/*
+ * 自适应采样率：信号变化快（窗口内拟合的变化速率或去除趋势后的标准差
+ * 接近阈值）时立即提高到相应的采样率，信号平稳时按 decay 逐步降低到 minHz。
+ * 所有数据源共用一个CPU预算：网关进程自身CPU占用超过上限时，
+ * 按比例降低所有数据源的采样率（不低于各自的 minHz）。
+ * 时间由调用者传入，便于用记录的数据离线回放测试
+ * */
+
+/* 单个数据源的配置（对应 sentinel_config.json 中 adaptiveSampling.sources） */
+typedef struct {
+  double minHz;           // 信号平稳时的采样率
+  double maxHz;           // 信号变化剧烈时的采样率
+  int window;             // 拟合使用的样本数（2 ~ ADAPTIVE_RATE_WINDOW）
+  double changeThreshold; // 变化速率（单位/秒）达到该值时使用 maxHz
+  double stdThreshold;    // 去除趋势后的标准差达到该值时使用 maxHz
+  double decay;           // 信号平稳时每秒采样率乘以该系数（0 ~ 1]
+} adaptiveRateConfig_t;
+
+/* 全局CPU预算，scale 由预算定时器更新，采样线程读取 */
+typedef struct {
+  double cpuLimitPercent; // 网关进程CPU占用上限（单核百分比），0 表示不限制
+  double minScale;        // 最低缩放系数
+  int scalePermille;      // 当前缩放系数（千分比，原子访问）
+  double lastCpuPercent;  // 最近一次测得的CPU占用
+} adaptiveBudget_t;
+
+/* 单个数据源的控制器 */
+typedef struct {
+  adaptiveRateConfig_t config;
+  const adaptiveBudget_t *budget; // 可为NULL
+  double values[ADAPTIVE_RATE_WINDOW];
+  int64_t times[ADAPTIVE_RATE_WINDOW];
+  int count; // 窗口中的样本数
+  int next;  // 下一个写入位置
+  int64_t lastMs;
+  double rateHz;     // 按信号动态计算的采样率（未考虑CPU预算）
+  double activity;   // 最近一次样本的活跃度（>=1 表示使用 maxHz）
+  unsigned long samples;
+} adaptiveRate_t;
+
+/* 检查并初始化控制器，初始采样率为 maxHz（启动时尽快建立基线） */
+int adaptiveRate_Init(adaptiveRate_t *rate, const adaptiveRateConfig_t *config,
+                      const adaptiveBudget_t *budget);
+
+/* 输入一个样本（nowMs 为单调时钟毫秒数），更新采样率 */
+void adaptiveRate_OnSample(adaptiveRate_t *rate, double value, int64_t nowMs);
+
+/* 当前实际采样率（已考虑CPU预算） */
+double adaptiveRate_EffectiveHz(const adaptiveRate_t *rate);
+
+/* 距下一次采样的间隔（毫秒） */
+int adaptiveRate_IntervalMs(const adaptiveRate_t *rate);
+
+void adaptiveRate_BudgetInit(adaptiveBudget_t *budget, double cpuLimitPercent);
+
+/* 输入网关进程的CPU占用，更新缩放系数：超出上限时按比例降低，否则缓慢恢复 */
+void adaptiveRate_UpdateBudget(adaptiveBudget_t *budget, double cpuPercent);
+
+/* 当前缩放系数（0 ~ 1） */
+double adaptiveRate_BudgetScale(const adaptiveBudget_t *budget);
+
+#endif // !_ADAPTIVE_RATE_H
@@ -0,0 +1,345 @@
+#ifndef _BROKER_GROUP_H
+#define _BROKER_GROUP_H
+
+#include "modules/mqtt_client.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BROKER_GROUP_MAX 4
+#define BROKER_MAX_SOURCES 32
+#define BROKER_SOURCE_DEFAULT 0 // 初始化时注册的 "default" 数据源（bulk）
+#define BROKER_LATENCY_BUCKETS 24
+
+/* 多Broker工作模式 */
+typedef enum {
+  BROKER_MODE_FAILOVER = 0, // 只连接一个Broker，故障时切换到下一个健康的Broker
+  BROKER_MODE_FANOUT,       // 同时连接所有Broker，每条消息发布到每个Broker
+} brokerMode_t;
+
+/* 发送优先级：数值小的先发送，各优先级有独立的队列，互不挤占 */
+typedef enum {
+  BROKER_CLASS_CONTROL = 0, // 命令响应
+  BROKER_CLASS_ALARM,       // GPIO事件等告警
+  BROKER_CLASS_STATUS,      // 设备状态
+  BROKER_CLASS_BULK,        // 遥测、下游设备转发和指标
+  BROKER_CLASS_COUNT,
+} brokerClass_t;
+
+/* 单个优先级的队列长度和令牌桶限速 */
+typedef struct {
+  int depth;      // 队列消息数，0 表示使用 queueDepth
+  int ratePerSec; // 每秒发送的消息数，0 表示不限速
+  int burst;      // 令牌桶容量，0 表示等于 ratePerSec
+} brokerClassConfig_t;
+
+/* 多Broker配置（对应 sentinel_config.json 中 mqttClientConfig 的 brokers 等字段） */
+typedef struct {
+  brokerMode_t mode;
+  int brokerCount;
+  const char *brokerAddresses[BROKER_GROUP_MAX]; // 按优先级排列
+  int probeIntervalMs;    // 健康探测间隔
+  int probeTimeoutMs;     // 单次探测（TCP连接）超时
+  int probeFailThreshold; // 已连接或空闲的Broker连续探测失败多少次判定为不健康
+  int switchTimeoutMs; // 故障切换模式下当前Broker断开超过该时间仍未恢复则切换
+  int queueDepth;      // 每个优先级队列的默认消息数
+  int queueSlotBytes;  // 每条消息（topic + payload）的上限
+  brokerClassConfig_t classes[BROKER_CLASS_COUNT];
+} brokerGroupConfig_t;
+
+/* 数据源：同一优先级内的数据源按权重轮流发送（按字节的差额轮询） */
+typedef struct {
+  char name[24];
+  brokerClass_t cls;
+  int weight;
+  bool coalesce; // 队列中已有同一Topic的消息时只替换内容，适合只关心最新值的数据
+} brokerSource_t;
+
+/* 发送队列中的一条消息，槽位在初始化时一次性分配 */
+typedef struct {
+  int source;
+  int next; // 同一数据源的下一条消息（槽位下标），空闲时为空闲链表
+  int topicLen;
+  int payloadLen;
+  int qos;
+  bool retained;
+  const mqttPublishOptions_t *options; // 发布属性（不复制，需长期有效）
+  int64_t enqueuedUs; // 入队时间，用于计算剩余过期时间和排队延迟
+  char *data;         // topic + '\0' + payload
+} brokerMessage_t;
+
+/* 发送队列中一个数据源的消息链表 */
+typedef struct {
+  int head; // 槽位下标，-1 表示空
+  int tail;
+  int count;
+  int deficit; // 差额轮询的剩余额度（字节）
+  unsigned long sent;
+  unsigned long dropped;
+  unsigned long coalesced;
+} brokerSourceQueue_t;
+
+/* 发送队列中一个优先级的槽位、令牌桶和统计 */
+typedef struct {
+  brokerMessage_t *slots;
+  int freeSlot; // 空闲槽位链表头，-1 表示已满
+  int count;
+  int highWater;
+  double tokens;
+  int64_t refillUs;
+  int cursor;    // 差额轮询的当前数据源（classSources 中的下标）
+  bool credited; // 当前数据源本轮已获得额度
+  unsigned long enqueued;
+  unsigned long sent;
+  unsigned long dropped;
+  unsigned long coalesced;
+  unsigned long expired;
+  unsigned long failed;
+  uint64_t latencyTotalUs; // 入队到发布完成
+  uint32_t latencyMaxUs;
+  unsigned long latencyHist[BROKER_LATENCY_BUCKETS]; // 按2的幂划分（微秒）
+} brokerClassQueue_t;
+
+struct brokerGroup;
+
+/*
+ * 发送队列：每个发送目标一个。高优先级先发送，同一优先级内按数据源
+ * 权重轮流发送；优先级队列满时丢弃该优先级中积压最多的数据源的最旧消息，
+ * 生产者不会被阻塞
+ * */
+typedef struct {
+  struct brokerGroup *group;
+  int target; // 目标Broker下标，-1 表示当前活动的Broker（故障切换模式）
+  brokerClassQueue_t classes[BROKER_CLASS_COUNT];
+  brokerSourceQueue_t sources[BROKER_MAX_SOURCES];
+  int count;               // 各优先级的消息总数
+  brokerMessage_t sending; // 发送线程的私有副本，发送期间不占用队列锁
+  int sendingClass;        // -1 表示没有待发送（或待重试）的消息
+  int attempts;            // 待重试消息已失败的发布次数
+  pthread_cond_t cond;
+  pthread_t thread;
+  unsigned long enqueued;
+  unsigned long sent;
+  unsigned long dropped;
+  unsigned long expired; // 在队列中超过过期时间而被丢弃的消息数
+  unsigned long failed;  // 被Broker拒绝或重试次数用完而被丢弃的消息数
+  int highWater;
+  int watchdogId; // 发送线程的看门狗ID
+} brokerOutbox_t;
+
+/* 单个Broker的连接和健康状态 */
+typedef struct {
+  struct brokerGroup *group;
+  int index;
+  mqttClientContext_t ctx;
+  char host[128];
+  int port;
+  bool healthy;
+  int probeFailures;
+  int probeRttUs;     // 最近一次成功探测的连接耗时
+  int64_t lastUpMs;   // 最近一次确认已连接的时间
+  unsigned long sent; // 经由该Broker发送的消息数
+} brokerLink_t;
+
+typedef struct brokerGroup {
+  brokerGroupConfig_t config;
+  brokerLink_t links[BROKER_GROUP_MAX];
+  brokerOutbox_t outboxes[BROKER_GROUP_MAX];
+  int outboxCount;
+  brokerSource_t sources[BROKER_MAX_SOURCES];
+  int sourceCount;
+  int classSources[BROKER_CLASS_COUNT][BROKER_MAX_SOURCES];
+  int classSourceCount[BROKER_CLASS_COUNT];
+
+  pthread_mutex_t lock; // 保护发送队列、数据源和健康状态
+  pthread_cond_t supervisorCond;
+  bool supervisorWake; // 连接断开时立即唤醒健康探测线程
+  pthread_t supervisorThread;
+  int watchdogId; // 健康探测线程的看门狗ID
+  volatile bool shouldExit;
+  bool started;
+
+  int64_t startedMs;      // 调用 Start 的时间
+  bool everConnected;     // 启动后已连上过Broker（原子读写）
+  int64_t firstSentUs;    // 第一条消息发布完成的时间，0 表示尚未发布
+  int active;             // 故障切换模式下当前使用的Broker
+  int64_t activeSinceMs;  // 切换到当前Broker的时间
+  bool switching;         // 切换进行中（旧Broker已断开，新Broker尚未连上）
+  int64_t outageStartMs;  // 当前Broker最近一次断开（或探测失败）的时间
+  int lastFailoverMs;     // 最近一次故障切换耗时（从断开到新Broker连上）
+  unsigned long failovers;
+  bool connected;         // 汇总连接状态
+  // 各Broker的状态变化在不同线程中发生，上层通知按顺序逐个进行，
+  // 每次通知时的最新状态，与上一次通知相同时不再通知
+  pthread_mutex_t notifyLock;
+  bool notified; // 最近一次通知上层的状态
+
+  mqttOnConnectionStatusCallback_t onConnStatusCb;
+  void *onConnStatusUserData;
+} brokerGroup_t;
+
+/* 发送队列中单个优先级的统计 */
+typedef struct {
+  int queued;
+  int highWater;
+  unsigned long enqueued;
+  unsigned long sent;
+  unsigned long dropped;
+  unsigned long coalesced;
+  unsigned long expired;
+  unsigned long failed;
+  uint32_t latencyAvgUs; // 入队到发布完成
+  uint32_t latencyP50Us; // 按直方图在所在桶内插值估算，不超过最大值
+  uint32_t latencyP99Us;
+  uint32_t latencyMaxUs;
+} brokerClassStats_t;
+
+/* 统计信息 */
+typedef struct {
+  int active;
+  unsigned long failovers;
+  int lastFailoverMs;
+  int64_t startedMs;   // 调用 Start 的时间（单调时钟）
+  int64_t firstSentUs; // 第一条消息发布完成的时间，0 表示尚未发布
+  int brokerCount;
+  struct {
+    const char *address;
+    bool healthy;
+    bool connected;
+    int probeRttUs;
+    unsigned long sent;
+    mqttConnectStats_t connect; // 连接次数和耗时（含TLS握手）
+    mqttPublishStats_t publish; // 报文字节数和Topic别名命中情况
+  } brokers[BROKER_GROUP_MAX];
+  int outboxCount;
+  struct {
+    int queued;
+    int highWater;
+    unsigned long enqueued;
+    unsigned long sent;
+    unsigned long dropped;
+    unsigned long expired;
+    unsigned long failed;
+    brokerClassStats_t classes[BROKER_CLASS_COUNT];
+  } outboxes[BROKER_GROUP_MAX];
+  int sourceCount;
+  struct {
+    const char *name;
+    brokerClass_t cls;
+    int weight;
+    int queued; // 各发送队列之和
+    unsigned long sent;
+    unsigned long dropped;
+    unsigned long coalesced;
+  } sources[BROKER_MAX_SOURCES];
+} brokerGroupStats_t;
+
+/* 发送队列中的一条积压消息，用于退出前导出和重启后恢复 */
+typedef struct {
+  int source;
+  const char *topic;
+  const char *payload;
+  int payloadLen;
+  int qos;
+  bool retained;
+  const mqttPublishOptions_t *options;
+  int64_t ageUs; // 已排队的时间，恢复后继续计算过期时间
+} brokerQueuedMessage_t;
+
+/* 导出积压消息的回调，返回非0时停止导出 */
+typedef int (*brokerQueuedVisitor_t)(const brokerQueuedMessage_t *msg,
+                                     void *userData);
+
+/* 为每个Broker创建客户端实例并分配发送队列 */
+int brokerGroup_Init(brokerGroup_t *group, const brokerGroupConfig_t *config,
+                     const mqttClientConfig_t *clientConfig);
+
+/* 以下接口与mqttClient同名接口一致，作用于组内每个Broker */
+void brokerGroup_SetLWT(brokerGroup_t *group, const char *topic,
+                        const char *payload, int qos);
+
+int brokerGroup_AddSubscription(brokerGroup_t *group, const char *topic,
+                                int qos);
+
+void brokerGroup_RegisterCommandCallback(brokerGroup_t *group,
+                                         mqttOnCommandCallback_t callback,
+                                         void *userData);
+
+/*
+ * 只为第 link 个Broker注册命令回调。扇出模式下各Broker的接收线程并发调用
+ * 回调，回调需要的可写状态（如命令解析arena）应按Broker分别通过 userData
+ * 传入。link 超出范围时返回-1
+ * */
+int brokerGroup_RegisterLinkCommandCallback(brokerGroup_t *group, int link,
+                                            mqttOnCommandCallback_t callback,
+                                            void *userData);
+
+void brokerGroup_RegisterConnectionStatusCallback(
+    brokerGroup_t *group, mqttOnConnectionStatusCallback_t callback,
+    void *userData);
+
+/* 启动连接、发送线程和健康探测线程 */
+int brokerGroup_Start(brokerGroup_t *group);
+
+/*
+ * 停止发送线程和健康探测线程，不断开连接，队列中的消息保留，
+ * 之后只能导出积压的消息、获取统计或调用 Stop（退出前保存快照用）
+ * */
+void brokerGroup_Pause(brokerGroup_t *group);
+
+/* 停止所有线程，断开连接并释放资源 */
+void brokerGroup_Stop(brokerGroup_t *group);
+
+/*
+ * 注册数据源，返回数据源ID（失败返回-1）。weight 为同一优先级内的
+ * 相对份额，coalesce 见 brokerSource_t
+ * */
+int brokerGroup_AddSource(brokerGroup_t *group, const char *name,
+                          brokerClass_t cls, int weight, bool coalesce);
+
+/*
+ * 将数据源 source 的消息放入发送队列（非阻塞），由发送线程发布。
+ * options 可为NULL，设置了过期时间的消息在队列中过期后直接丢弃，
+ * 发出时携带剩余的过期时间
+ */
+int brokerGroup_Publish(brokerGroup_t *group, int source, const char *topic,
+                        const char *payload, int payloadLen, int qos,
+                        bool retained, const mqttPublishOptions_t *options);
+
+/*
+ * 按优先级、数据源的顺序导出积压的消息（正在发送的一条排在最前），
+ * 扇出模式下取积压最多的发送队列。持有队列锁调用 visitor，
+ * 返回交给 visitor 的消息数
+ * */
+int brokerGroup_ExportQueued(brokerGroup_t *group,
+                             brokerQueuedVisitor_t visitor, void *userData);
+
+/*
+ * 恢复一条导出的消息：与 Publish 相同，入队时间按 ageUs 回推，
+ * 过期时间继续计算。可以在 Start 之前调用
+ * */
+int brokerGroup_Requeue(brokerGroup_t *group,
+                        const brokerQueuedMessage_t *msg);
+
+/* 某个优先级的剩余槽位（取各发送队列的最小值），供外部数据源做背压 */
+int brokerGroup_QueueRoom(brokerGroup_t *group, brokerClass_t cls);
+
+/*
+ * 是否可以发布：有Broker已连接，或故障切换正在进行，或启动后的首次连接
+ * 尚未超过 switchTimeoutMs（这期间的消息进入队列，连上后立即发出）
+ * */
+bool brokerGroup_IsConnected(brokerGroup_t *group);
+
+/* 获取统计信息 */
+void brokerGroup_GetStats(brokerGroup_t *group, brokerGroupStats_t *stats);
+
+/* 解析 "failover" / "fanout"，无法识别时返回-1 */
+int brokerGroup_ParseMode(const char *name);
+
+/* 解析 "control" / "alarm" / "status" / "bulk"，无法识别时返回-1 */
+int brokerGroup_ParseClass(const char *name);
+
+/* 优先级名称 */
+const char *brokerGroup_ClassName(brokerClass_t cls);
+
+#endif // !_BROKER_GROUP_H
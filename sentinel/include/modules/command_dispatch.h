@@ -0,0 +1,87 @@
+#ifndef _COMMAND_DISPATCH_H
+#define _COMMAND_DISPATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define COMMAND_MAX_TARGETS 32 // 网关自身的target加上每个PWM通道一个
+#define COMMAND_MAX_PARAMS 4
+
+/* 命令来源 */
+typedef enum {
+  COMMAND_SOURCE_REMOTE = 0, // 来自 app/{id}/control
+  COMMAND_SOURCE_RULE,       // 来自本地规则引擎
+} commandSource_t;
+
+/* 错误码（response 中的 error_code） */
+typedef enum {
+  COMMAND_OK = 0,
+  COMMAND_ERR_PARSE = 1,          // 命令JSON格式错误
+  COMMAND_ERR_UNKNOWN_TARGET = 2, // 未注册的target
+  COMMAND_ERR_UNKNOWN_ACTION = 3, // target不支持该action
+  COMMAND_ERR_INVALID_VALUE = 4,  // value或参数不合法
+  COMMAND_ERR_EXEC = 5,           // 执行失败
+  COMMAND_ERR_BUSY = 6,           // 执行队列已满
+  COMMAND_ERR_TIMEOUT = 7,        // 排队超过期限，未执行
+  COMMAND_ERR_CANCELLED = 8,      // 被取消
+} commandError_t;
+
+/* 命令参数（device_specific_params 中的数值字段） */
+typedef struct {
+  char name[24];
+  double value;
+} commandParam_t;
+
+/* 解析后的控制命令（按值传递，不引用JSON树） */
+typedef struct {
+  char commandId[64];
+  char target[32];
+  char action[32];
+  bool hasValue;       // value 是否为数值
+  double value;        // 数值型 value
+  char valueStr[72];   // 字符串型 value（可容纳SHA-256十六进制摘要）
+  int paramCount;
+  commandParam_t params[COMMAND_MAX_PARAMS];
+  int timeoutMs; // 期限（timeout_ms），排队超过时不再执行，0 使用默认值
+  commandSource_t source;
+  long long receivedNs; // 接收时间（CLOCK_MONOTONIC，纳秒）
+} sentinelCommand_t;
+
+/* 命令执行结果，对应 sentinel/{id}/response 的载荷字段 */
+typedef struct {
+  int errorCode;        // 0 表示成功
+  char message[128];    // 可读的说明
+  // result_data 的JSON对象文本（可为空），历史查询的降采样结果需要较大空间
+  char resultData[1536];
+} sentinelCommandResult_t;
+
+/* 命令处理函数，返回0表示成功 */
+typedef int (*commandHandler_t)(const sentinelCommand_t *cmd,
+                                sentinelCommandResult_t *result,
+                                void *userData);
+
+/* 注册目标（target）的处理函数，只能在启动阶段调用，表已满时返回-1 */
+int commandDispatch_Register(const char *target, commandHandler_t handler,
+                             void *userData);
+
+/* 解析控制命令JSON，cJSON树的内存由调用方绑定的arena提供 */
+int commandDispatch_Parse(const char *payload, int payloadLen,
+                          sentinelCommand_t *cmd);
+
+/* 按target分发执行命令，远程命令和本地规则共用该入口 */
+int commandDispatch_Execute(const sentinelCommand_t *cmd,
+                            sentinelCommandResult_t *result);
+
+/* 查找命令参数，找不到时返回默认值 */
+double commandDispatch_GetParam(const sentinelCommand_t *cmd, const char *name,
+                                double defaultValue);
+
+/* 格式化 sentinel/{id}/response 载荷，返回长度 */
+int commandDispatch_FormatResponse(const sentinelCommand_t *cmd,
+                                   const sentinelCommandResult_t *result,
+                                   char *buffer, size_t size);
+
+/* 获取单调时钟时间（纳秒） */
+long long commandDispatch_NowNs(void);
+
+#endif // !_COMMAND_DISPATCH_H
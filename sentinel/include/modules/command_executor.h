@@ -0,0 +1,85 @@
+#ifndef _COMMAND_EXECUTOR_H
+#define _COMMAND_EXECUTOR_H
+
+#include "modules/command_dispatch.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 命令执行器：接收线程（paho回调、规则引擎）只把命令放入队列，由少量
+ * 工作线程调用 commandDispatch_Execute。同一 target 的命令按到达顺序
+ * 逐条执行，不同 target 并行。排队超过期限的命令不再执行，
+ * 执行中的命令可以通过 commandExecutor_Cancelled 检查是否应提前结束
+ * */
+
+#define COMMAND_EXECUTOR_MAX_WORKERS 8
+// 耗时直方图的桶：第 i 个桶为 [2^(i-1), 2^i) 毫秒（第0个桶为 <1ms），
+// 最后一个桶包含更长的耗时
+#define COMMAND_HIST_BUCKETS 16
+
+/* 配置（对应 sentinel_config.json 中的 commandConfig） */
+typedef struct {
+  int workers;          // 工作线程数
+  int queueDepth;       // 排队（不含执行中）的命令数上限
+  int defaultTimeoutMs; // 命令未指定 timeout_ms 时的期限，0 不限
+} commandExecutorConfig_t;
+
+/* 命令完成（执行、过期或取消）时在工作线程上调用，用于发布响应 */
+typedef void (*commandDoneCallback_t)(const sentinelCommand_t *cmd,
+                                      const sentinelCommandResult_t *result,
+                                      void *userData);
+
+/* 统计 */
+typedef struct {
+  unsigned long submitted;
+  unsigned long executed;
+  unsigned long rejected;  // 队列满
+  unsigned long expired;   // 排队超过期限，未执行
+  unsigned long cancelled; // 排队时被取消，未执行
+  unsigned long late;      // 执行完成时已超过期限
+  int queued;              // 当前排队数
+  int running;             // 当前执行数
+  int maxQueued;
+  int workers;
+  uint64_t queueTotalUs; // 排队耗时（接收到开始执行）
+  uint64_t queueMaxUs;
+  uint64_t execTotalUs; // 执行耗时
+  uint64_t execMaxUs;
+  unsigned long queueHist[COMMAND_HIST_BUCKETS];
+  unsigned long execHist[COMMAND_HIST_BUCKETS];
+} commandExecutorStats_t;
+
+/* 预分配队列并启动工作线程，只能在启动阶段调用 */
+int commandExecutor_Init(const commandExecutorConfig_t *config,
+                         commandDoneCallback_t done, void *userData);
+
+/* 等待执行中的命令结束后停止工作线程，排队中的命令丢弃 */
+void commandExecutor_Deinit(void);
+
+/*
+ * @brief 提交命令（按值复制），立即返回
+ *
+ * @return 0 成功，-1 队列已满或未初始化
+ * */
+int commandExecutor_Submit(const sentinelCommand_t *cmd);
+
+/*
+ * @brief 按 command_id 取消命令：排队中的命令不再执行（以
+ *        COMMAND_ERR_CANCELLED 完成），执行中的命令设置取消标志
+ *
+ * @return 1 已从队列移除，2 正在执行（已通知），0 找不到
+ * */
+int commandExecutor_Cancel(const char *commandId);
+
+/*
+ * 由处理函数在耗时操作中调用：当前命令已被取消或超过期限时返回true。
+ * 不在工作线程上时返回false
+ * */
+bool commandExecutor_Cancelled(void);
+
+void commandExecutor_GetStats(commandExecutorStats_t *stats);
+
+/* 直方图桶的上界（毫秒），最后一个桶返回-1 */
+int commandExecutor_BucketLimitMs(int bucket);
+
+#endif // !_COMMAND_EXECUTOR_H
@@ -8,6 +8,7 @@
 #define CPU_TEMP_FILE "/sys/class/thermal/thermal_zone0/temp"
 #define CPU_TIME_FILE "/proc/stat"
 #define MEM_USAGE_FILE "/proc/meminfo"
+#define PROC_SELF_STAT_FILE "/proc/self/stat"
 
 /*  The time slice(jiffies) spent by the CPU in different states since its
  * startup */
@@ -26,6 +27,9 @@ typedef struct {
 float getCpuTemperature();
 void readCpuTimes(CpuTimes *times);
 double getCpuLoad();
+void getCpuLoadBaseline(CpuTimes *times);
+int setCpuLoadBaseline(const CpuTimes *times);
+double getProcessCpuLoad(void);
 long getMemValue(const char *fileContent, const char *key);
 float getMemUsage(void);
 
@@ -0,0 +1,72 @@
+#ifndef _EVENT_LOOP_H
+#define _EVENT_LOOP_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+/* 文件描述符就绪回调 */
+typedef void (*eventLoopCallback_t)(int fd, uint32_t events, void *userData);
+
+/* 已注册的文件描述符 */
+typedef struct {
+  int fd;
+  bool used;
+  eventLoopCallback_t callback;
+  void *userData;
+} eventLoopHandler_t;
+
+/*
+ * 基于epoll的事件循环，运行在独立线程中，由多个模块共享。
+ * 注册、修改和注销都是O(1)：fd 到槽位用开放寻址哈希表查找，
+ * 空闲槽位按先进先出复用，刚注销的槽位不会被同一批事件中新注册的fd占用
+ * */
+typedef struct {
+  int epollFd;
+  int wakeFd;                   // eventfd，用于唤醒并退出循环
+  volatile bool running;
+  pthread_t thread;
+  pthread_mutex_t lock;         // 保护handlers表
+  eventLoopHandler_t *handlers; // 启动时按maxFds一次性分配
+  int maxFds;
+  int *freeSlots; // 空闲槽位环形队列
+  int freeHead;
+  int freeCount;
+  int *fdIndex;   // fd -> 槽位（线性探测），-1 表示空
+  int indexMask;
+} eventLoop_t;
+
+/* 初始化事件循环 */
+int eventLoop_Init(eventLoop_t *loop, int maxFds);
+
+/* 注册文件描述符，events为EPOLLIN/EPOLLOUT等 */
+int eventLoop_AddFd(eventLoop_t *loop, int fd, uint32_t events,
+                    eventLoopCallback_t callback, void *userData);
+
+/* 修改关注的事件 */
+int eventLoop_ModifyFd(eventLoop_t *loop, int fd, uint32_t events);
+
+/* 注销文件描述符（不关闭fd） */
+int eventLoop_RemoveFd(eventLoop_t *loop, int fd);
+
+/* 创建timerfd并注册到事件循环，返回timer fd */
+int eventLoop_AddTimer(eventLoop_t *loop, eventLoopCallback_t callback,
+                       void *userData);
+
+/* 设置定时器：首次触发延时和周期（纳秒），均为0表示停止 */
+int eventLoop_ArmTimer(int timerFd, uint64_t initialNs, uint64_t intervalNs);
+
+/* 读取定时器到期次数（在定时器回调中调用） */
+uint64_t eventLoop_AckTimer(int timerFd);
+
+/* 处理一轮事件，timeoutMs为-1时一直等待；返回处理的事件数 */
+int eventLoop_RunOnce(eventLoop_t *loop, int timeoutMs);
+
+/* 在独立线程中启动事件循环 */
+int eventLoop_Start(eventLoop_t *loop);
+
+/* 停止事件循环并等待线程退出 */
+void eventLoop_Stop(eventLoop_t *loop);
+
+#endif // !_EVENT_LOOP_H
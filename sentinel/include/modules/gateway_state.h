@@ -0,0 +1,116 @@
+#ifndef _GATEWAY_STATE_H
+#define _GATEWAY_STATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modules/broker_group.h"
+#include "modules/device_monitor.h"
+#include "modules/event_loop.h"
+
+/* 对应 sentinel_config.json 中的 snapshotConfig */
+typedef struct {
+  bool enabled;
+  char path[128];
+  int intervalSec; // 定期保存的间隔，0 表示只在退出时保存
+  int maxBytes;    // 快照缓冲，启动时一次性分配
+} gatewayStateConfig_t;
+
+/* 快照中保存的计数器，恢复时累加到当前值 */
+typedef struct {
+  uint64_t samplesProduced;
+  uint64_t samplesOffline;
+} gatewayCounters_t;
+
+/*
+ * 快照与网关其余部分的接口：保存时由 visitor 提供计数器、CPU负载基线和
+ * 发送队列中积压的消息，恢复时把读出的内容交还给 visitor。记录的格式
+ * 只在本模块中定义，网关不接触快照记录
+ * */
+typedef struct {
+  void (*getCounters)(gatewayCounters_t *counters, void *userData);
+  void (*addCounters)(const gatewayCounters_t *counters, void *userData);
+  /* cpu->total 为0表示还没有基线 */
+  void (*getCpuBaseline)(CpuTimes *cpu, void *userData);
+  void (*setCpuBaseline)(const CpuTimes *cpu, void *userData);
+  /* 把积压的消息依次交给 visitor，返回交出的消息数 */
+  int (*exportQueued)(brokerQueuedVisitor_t visitor, void *visitorData,
+                      void *userData);
+  int (*requeue)(const brokerQueuedMessage_t *msg, void *userData);
+  /* 快照按名称保存数据源（ID与登记顺序有关），未知时返回NULL / -1 */
+  const char *(*sourceName)(int source, void *userData);
+  int (*sourceByName)(const char *name, int len, void *userData);
+  /* 压缩帧和JSON的发布属性，快照只记录是否压缩 */
+  const mqttPublishOptions_t *packedOptions;
+  const mqttPublishOptions_t *jsonOptions;
+  void *userData;
+} gatewayStateVisitor_t;
+
+typedef struct {
+  bool enabled;
+  bool restored;
+  int restoreUs;
+  int restoredMessages;
+  int skippedMessages;
+  int64_t savedAgoMs; // 恢复的快照在多久之前保存
+  unsigned long saves;
+  unsigned long saveFailures;
+  int lastSaveUs;
+  int lastBytes;
+  int lastMessages;
+  unsigned long truncated; // 快照空间不足而未保存的消息
+} gatewayStateStats_t;
+
+/*
+ * 网关运行状态：启动各阶段的耗时和启动完成的门闩，以及定期和退出时
+ * 保存、重启后恢复的状态快照（计数器、CPU负载基线和积压的消息）。
+ * 启动阶段的时间为单调时钟，仿真模式下为虚拟时间
+ * */
+
+/* 进入main时调用，记录启动的开始时间 */
+void gatewayState_StartupBegin(void);
+
+/* 记录一个启动阶段的耗时，下一个阶段从现在开始 */
+void gatewayState_PhaseDone(const char *name);
+
+/* 启动完成：输出各阶段耗时，放行 gatewayState_WaitReady 中的线程 */
+void gatewayState_Ready(void);
+
+/* 等待启动完成：Broker先于外设启动，命令可能用到尚未初始化的模块 */
+void gatewayState_WaitReady(void);
+
+/* 启动的开始时间（simClock_NowNs） */
+int64_t gatewayState_StartNs(void);
+
+/*
+ * @brief 分配快照缓冲并恢复上次保存的快照，在Broker组启动前调用：计数器
+ *        接着累加，CPU负载基线只在同一次开机内有效，积压的消息按数据源
+ *        名称重新入队，排队时间加上停机时间。恢复后删除快照文件，避免在
+ *        下一次保存前崩溃时重复发送。config->enabled 为 false 时什么也不做
+ *
+ * @return 0 成功，缓冲分配失败时返回-1并关闭快照
+ * */
+int gatewayState_Init(const gatewayStateConfig_t *config,
+                      const gatewayStateVisitor_t *visitor);
+
+/*
+ * @brief 保存快照。发送队列只在 exportQueued 期间加锁，写文件时不影响发布
+ *
+ * @return 0 成功
+ * */
+int gatewayState_Save(void);
+
+/* 按 intervalSec 在事件循环上定期保存，intervalSec 为0时不添加定时器 */
+int gatewayState_StartTimer(eventLoop_t *loop);
+
+void gatewayState_GetStats(gatewayStateStats_t *stats);
+
+/*
+ * @brief 格式化启动情况的JSON：各阶段耗时、启动完成时间、第一条消息的
+ *        发布时间（firstPublishMs 小于0时为 null）和快照情况
+ *
+ * @return 写入的长度
+ * */
+int gatewayState_FormatStartup(char *out, int size, double firstPublishMs);
+
+#endif // !_GATEWAY_STATE_H
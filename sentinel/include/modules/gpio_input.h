@@ -0,0 +1,65 @@
+#ifndef _GPIO_INPUT_H
+#define _GPIO_INPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modules/event_loop.h"
+
+#define GPIO_MAX_LINES 16
+
+/* 关注的边沿 */
+typedef enum {
+  GPIO_EDGE_RISING = 1,
+  GPIO_EDGE_FALLING = 2,
+  GPIO_EDGE_BOTH = 3,
+} gpioEdge_t;
+
+/* 单条输入线配置（对应 gpioInputConfig.lines） */
+typedef struct {
+  char name[32];       // 事件名称，如 "door_contact"
+  char chip[64];       // GPIO字符设备，如 "/dev/gpiochip0"
+  int line;            // 线偏移
+  gpioEdge_t edge;     // 关注的边沿
+  bool activeLow;      // 低电平有效
+  uint32_t debounceMs; // 软件去抖时间
+  char trigger[16];    // 事件触发的采样源（如 "light"），可为空
+} gpioLineConfig_t;
+
+/* 去抖后的输入事件 */
+typedef struct {
+  const gpioLineConfig_t *config;
+  int value;               // 当前电平（已考虑activeLow）
+  uint64_t kernelTsNs;     // 内核记录的边沿时间戳
+  uint64_t dispatchNs;     // 事件回调时的单调时间
+  bool settled;            // true 表示由去抖窗口结束后的校正产生
+} gpioEvent_t;
+
+/* 事件回调（在事件循环线程中调用） */
+typedef void (*gpioEventCallback_t)(const gpioEvent_t *event, void *userData);
+
+/* 统计信息 */
+typedef struct {
+  unsigned long rawEdges;   // 内核上报的边沿数
+  unsigned long delivered;  // 去抖后上报的事件数
+  unsigned long suppressed; // 被去抖过滤的边沿数
+} gpioInputStats_t;
+
+/* 初始化模块，去抖定时器挂在事件循环上 */
+int gpioInput_Init(eventLoop_t *loop, gpioEventCallback_t callback,
+                   void *userData);
+
+/* 通过GPIO字符设备申请输入线并注册到事件循环 */
+int gpioInput_AddLine(const gpioLineConfig_t *config);
+
+/* 注册一个已经打开的事件fd（输出gpioevent_data记录），用于测试注入 */
+int gpioInput_AddLineFd(const gpioLineConfig_t *config, int eventFd,
+                        int initialValue);
+
+/* 获取统计信息 */
+void gpioInput_GetStats(gpioInputStats_t *stats);
+
+/* 注销并关闭所有输入线 */
+void gpioInput_Deinit(void);
+
+#endif // !_GPIO_INPUT_H
@@ -0,0 +1,89 @@
+#ifndef _HISTORY_STORE_H
+#define _HISTORY_STORE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HISTORY_MAX_SERIES 16
+#define HISTORY_NAME_LEN 32
+
+/* 历史存储配置（对应 sentinel_config.json 中的 historyConfig） */
+typedef struct {
+  char path[128];      // 存储文件路径
+  uint32_t blockBytes; // 块大小（字节），每个块只属于一个序列
+  uint32_t blockCount; // 块数量，写满后回收最旧的块
+} historyStoreConfig_t;
+
+/* 序列的写入状态（Gorilla 编码器状态） */
+typedef struct {
+  int block;             // 当前写入的块，-1 表示需要分配新块
+  int64_t prevTs;        // 上一个时间戳（毫秒）
+  int64_t prevDelta;     // 上一个时间间隔
+  uint64_t prevBits;     // 上一个值的位模式
+  uint8_t prevLeading;   // 上一个XOR值的前导零个数
+  uint8_t prevTrailing;  // 上一个XOR值的尾随零个数
+} historySeries_t;
+
+/* 基于mmap文件的压缩时序存储 */
+typedef struct {
+  historyStoreConfig_t config;
+  int fd;
+  uint8_t *base;     // 文件映射起始地址
+  size_t mapBytes;
+  pthread_mutex_t lock;
+  int seriesCount;
+  historySeries_t series[HISTORY_MAX_SERIES];
+  unsigned long appends;
+} historyStore_t;
+
+/* 降采样后的一个时间桶 */
+typedef struct {
+  int64_t startMs;
+  int count;
+  double min;
+  double max;
+  double sum;
+} historyBucket_t;
+
+/* 统计信息 */
+typedef struct {
+  int seriesCount;
+  uint32_t blocksUsed;
+  uint32_t blockCount;
+  uint64_t samples;     // 存储中保留的样本数
+  uint64_t storedBytes; // 已编码的字节数（不含块头）
+  unsigned long appends;
+} historyStoreStats_t;
+
+/* 打开（或创建）存储文件；几何参数与已有文件不一致时重建 */
+int historyStore_Open(historyStore_t *store, const historyStoreConfig_t *config);
+
+/* 按名称查找序列，不存在时创建，返回序列ID */
+int historyStore_SeriesId(historyStore_t *store, const char *name);
+
+/* 查找序列，不存在时返回-1 */
+int historyStore_FindSeries(historyStore_t *store, const char *name);
+
+/* 追加一个样本，时间戳为毫秒 */
+int historyStore_Append(historyStore_t *store, int seriesId, int64_t tsMs,
+                        double value);
+
+/*
+ * 查询[fromMs, toMs)范围内的样本并按stepMs降采样到buckets中，
+ * 返回桶的数量（包括空桶）
+ * */
+int historyStore_Query(historyStore_t *store, int seriesId, int64_t fromMs,
+                       int64_t toMs, int64_t stepMs, historyBucket_t *buckets,
+                       int maxBuckets);
+
+/* 获取统计信息 */
+void historyStore_GetStats(historyStore_t *store, historyStoreStats_t *stats);
+
+/* 将映射的修改写回文件 */
+void historyStore_Sync(historyStore_t *store);
+
+/* 同步并关闭存储 */
+void historyStore_Close(historyStore_t *store);
+
+#endif // !_HISTORY_STORE_H
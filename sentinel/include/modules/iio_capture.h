@@ -0,0 +1,73 @@
+#ifndef _IIO_CAPTURE_H
+#define _IIO_CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modules/event_loop.h"
+
+#define IIO_SYSFS_ROOT "/sys/bus/iio/devices"
+#define IIO_DEV_ROOT "/dev"
+#define IIO_MAX_CHANNELS 8
+
+/* scan_elements/<channel>_type 描述符，如 "le:s12/16>>4" */
+typedef struct {
+  bool bigEndian;
+  bool isSigned;
+  uint8_t bits;        // 有效位数
+  uint8_t storageBits; // 存储位数
+  uint8_t shift;       // 右移位数
+} iioScanType_t;
+
+/* 单个采集通道配置 */
+typedef struct {
+  char element[32]; // scan_elements 中的通道名，如 "in_illuminance"
+  char field[32];   // 送入采样流水线的字段名，如 "light.light_lux"
+} iioChannelConfig_t;
+
+/* IIO采集配置（对应 sentinel_config.json 中的 iioConfig） */
+typedef struct {
+  char sysfsRoot[128]; // 测试时可指向伪造的sysfs目录树
+  char devRoot[64];    // 字符设备目录
+  char device[32];     // 设备名，如 "iio:device0"
+  char trigger[32];    // 写入 trigger/current_trigger 的触发器名，可为空
+  int bufferLength;    // 内核缓冲区长度（扫描数）
+  int watermark;       // 唤醒读取的扫描数
+  bool timestamp;      // 是否启用 in_timestamp 通道
+  int channelCount;
+  iioChannelConfig_t channels[IIO_MAX_CHANNELS];
+} iioCaptureConfig_t;
+
+/* 一次扫描解码后的多通道样本，各通道在同一触发时刻采集 */
+typedef struct {
+  int64_t timestampNs; // in_timestamp 通道的值，未启用时为读取时的单调时间
+  int channelCount;
+  double values[IIO_MAX_CHANNELS]; // (raw + offset) * scale，顺序与配置一致
+  int64_t raw[IIO_MAX_CHANNELS];
+} iioSample_t;
+
+/* 样本回调（在事件循环线程中调用） */
+typedef void (*iioSampleCallback_t)(const iioSample_t *sample, void *userData);
+
+/* 统计信息 */
+typedef struct {
+  unsigned long reads;   // read() 调用次数
+  unsigned long samples; // 解码的扫描数
+  unsigned long bytes;
+  int scanBytes;         // 单次扫描的字节数
+} iioCaptureStats_t;
+
+/* 解析scan_elements类型描述符 */
+int iioCapture_ParseType(const char *desc, iioScanType_t *type);
+
+/* 使能通道、触发器和缓冲区，并把字符设备注册到事件循环 */
+int iioCapture_Init(const iioCaptureConfig_t *config, eventLoop_t *loop,
+                    iioSampleCallback_t callback, void *userData);
+
+/* 获取统计信息 */
+void iioCapture_GetStats(iioCaptureStats_t *stats);
+
+/* 关闭缓冲区并注销字符设备 */
+void iioCapture_Deinit(void);
+
+#endif // !_IIO_CAPTURE_H
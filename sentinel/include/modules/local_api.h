@@ -0,0 +1,40 @@
+#ifndef _LOCAL_API_H
+#define _LOCAL_API_H
+
+#include "modules/event_loop.h"
+#include "modules/value_table.h"
+
+#define LOCAL_API_SOCKET_PATH "/run/sentinel/api.sock"
+#define LOCAL_API_LINE_MAX 128
+
+/* 本地接口配置（对应 sentinel_config.json 中的 localApiConfig） */
+typedef struct {
+  char socketPath[108]; // Unix域套接字路径（sun_path 长度限制）
+  int maxClients;       // 同时连接的客户端数
+} localApiConfig_t;
+
+/* 统计信息 */
+typedef struct {
+  unsigned long accepted;
+  unsigned long requests;
+  unsigned long rejected; // 超出连接数被拒绝
+  unsigned long dropped;  // 不读取响应而被断开的客户端
+} localApiStats_t;
+
+/*
+ * 在Unix域套接字上提供最新值查询，按行请求/响应：
+ *   PING            -> "OK pong"
+ *   GET <name>      -> "OK <name> <value> <ts_ms>" 或 "ERR <reason>"
+ *   LIST            -> "OK <n>"，随后n行 "<name> <value> <ts_ms>"
+ * 读取只访问最新值表，不经过采样线程，也不等待采样线程。
+ */
+int localApi_Init(const localApiConfig_t *config, eventLoop_t *loop,
+                  const valueTable_t *table);
+
+/* 获取统计信息 */
+void localApi_GetStats(localApiStats_t *stats);
+
+/* 关闭所有连接并删除套接字文件 */
+void localApi_Deinit(void);
+
+#endif // !_LOCAL_API_H
@@ -0,0 +1,78 @@
+#ifndef _LOCK_PROFILE_H
+#define _LOCK_PROFILE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 互斥锁争用分析：按加锁位置（文件、行号）统计等待时间和持有时间的直方图，
+ * 用于找出持有时间过长的临界区（例如持锁期间进行网络调用）。
+ * 未启用时只多一次原子读，直接调用pthread接口
+ * */
+
+/* 直方图按2的幂划分（微秒）：桶0为 <1us，桶k为 [2^(k-1), 2^k) us */
+#define LOCK_PROFILE_BUCKETS 24
+#define LOCK_PROFILE_SITE_NAME 48
+
+/* 加锁位置，由 PROFILED_LOCK 宏为每个调用点定义一个静态实例 */
+typedef struct lockSite {
+  const char *file;
+  int line;
+  const char *func;
+  int registered; // 首次加锁时加入全局链表
+  struct lockSite *next;
+  unsigned long acquisitions;
+  unsigned long contended; // 需要等待的加锁次数
+  uint64_t waitTotalNs;
+  uint64_t holdTotalNs;
+  uint32_t waitMaxUs;
+  uint32_t holdMaxUs;
+  unsigned long waitHist[LOCK_PROFILE_BUCKETS];
+  unsigned long holdHist[LOCK_PROFILE_BUCKETS];
+} lockSite_t;
+
+/* 单个加锁位置的统计快照 */
+typedef struct {
+  char name[LOCK_PROFILE_SITE_NAME]; // "文件名:行号 函数名"
+  unsigned long acquisitions;
+  unsigned long contended;
+  uint64_t waitTotalNs; // 总时间按纳秒累加，短临界区不会被截断为0
+  uint64_t holdTotalNs;
+  uint32_t waitMaxUs;
+  uint32_t holdMaxUs;
+  uint32_t waitP99Us; // 按直方图估算（所在桶的上界）
+  uint32_t holdP99Us;
+} lockSiteStats_t;
+
+#define LOCK_PROFILE_SITE_INIT                                                 \
+  { .file = __FILE__, .line = __LINE__, .func = __func__ }
+
+/* 替代 pthread_mutex_lock，按调用位置统计 */
+#define PROFILED_LOCK(mutex)                                                   \
+  do {                                                                         \
+    static lockSite_t lockSite_ = LOCK_PROFILE_SITE_INIT;                      \
+    lockProfile_Lock((mutex), &lockSite_);                                     \
+  } while (0)
+
+/* 运行时开关，默认关闭 */
+void lockProfile_SetEnabled(bool enabled);
+bool lockProfile_IsEnabled(void);
+
+void lockProfile_Lock(pthread_mutex_t *mutex, lockSite_t *site);
+
+/* 替代 pthread_mutex_unlock，持有时间计入加锁位置 */
+void lockProfile_Unlock(pthread_mutex_t *mutex);
+
+/* 替代 pthread_cond_wait/timedwait：等待期间不计入持有时间 */
+int lockProfile_CondWait(pthread_cond_t *cond, pthread_mutex_t *mutex);
+int lockProfile_CondTimedWait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                              const struct timespec *deadline);
+
+/* 按总持有时间从大到小输出最多 max 个加锁位置，返回个数 */
+int lockProfile_GetSites(lockSiteStats_t *out, int max);
+
+/* 清零所有统计 */
+void lockProfile_Reset(void);
+
+#endif // !_LOCK_PROFILE_H
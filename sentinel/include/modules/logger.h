@@ -0,0 +1,124 @@
+#ifndef _LOGGER_H
+#define _LOGGER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * 异步日志：调用线程只检查级别、复制参数到本线程的无锁环形缓冲，
+ * 格式化和写文件/syslog由后台线程批量完成，日志输出慢时不会阻塞调用线程。
+ * 每个调用位置（文件、行号）对连续相同的消息只输出一次，之后定期输出
+ * "repeated N times"；另外按位置限制单位时间内的条数。
+ * 未初始化（或已停止）时直接同步输出到stderr
+ * */
+
+/* 级别：数值越大越详细 */
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARN 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+
+#define LOGGER_MAX_ARGS 8       // 每条消息的参数个数上限，超出部分原样输出
+#define LOGGER_RECORD_BYTES 192 // 一条记录的大小，字符串参数超出时截断
+#define LOGGER_DYNAMIC_SITES 64 // logger_Callback 按格式串区分的位置数
+
+/* 配置（对应 sentinel_config.json 中的 loggerConfig） */
+typedef struct {
+  int level;
+  const char *file;      // 日志文件，NULL 或空字符串输出到stderr
+  bool syslog;           // 输出到syslog（优先于file）
+  long maxBytes;         // 文件超过该大小时轮转（配置中为 maxKB），0 不轮转
+  int maxFiles;          // 轮转保留的历史文件数（file.1 ... file.N）
+  int maxThreads;        // 预分配的线程缓冲数，超出的线程同步输出
+  int ringSlots;         // 每个线程缓冲的记录数（2的幂）
+  int flushIntervalMs;   // 后台线程的最长写入间隔
+  int rateLimit;         // 每个位置在 rateWindowMs 内最多输出的条数，0 不限
+  int rateWindowMs;
+  int summaryIntervalMs; // 输出重复和限流条数的间隔
+} loggerConfig_t;
+
+/* 调用位置，由 LOGGER_LOG 宏为每个调用点定义一个静态实例 */
+typedef struct loggerSite {
+  const char *file; // NULL 表示 logger_Callback 的位置，不输出文件和行号
+  int line;
+  const char *format;
+  int registered; // 首次输出时加入全局链表
+  struct loggerSite *next;
+  int parsedArgs; // 参数个数+1，0 表示格式串尚未解析
+  uint8_t argTypes[LOGGER_MAX_ARGS];
+  int level; // 最近一次的级别，用于汇总行
+  uint64_t lastHash;   // 最近一次输出的消息（格式串和参数）的哈希
+  unsigned long repeats;     // 尚未汇总输出的重复条数
+  unsigned long repeatTotal; // 累计合并的重复条数
+  int64_t windowMs;          // 限流窗口起点
+  unsigned int windowCount;
+  unsigned long limited;      // 尚未汇总输出的限流条数
+  unsigned long limitedTotal; // 累计限流丢弃的条数
+} loggerSite_t;
+
+/* 统计 */
+typedef struct {
+  unsigned long lines;   // 已写入的行数
+  unsigned long bytes;
+  unsigned long writes;  // write/syslog 调用次数
+  unsigned long dropped; // 线程缓冲满而丢弃的条数
+  unsigned long repeats; // 合并的重复条数
+  unsigned long limited; // 限流丢弃的条数
+  unsigned long direct;  // 没有空闲线程缓冲而同步输出的条数
+  unsigned long rotations;
+  unsigned long writeErrors;
+  int threads; // 正在使用的线程缓冲数
+  int level;
+} loggerStats_t;
+
+extern int g_loggerLevel; // 只读，通过 logger_SetLevel 修改
+
+/*
+ * 按调用位置输出日志，格式串必须是字符串常量（记录中只保存指针）。
+ * 级别关闭时只多一次读取；if (0) printf 仅用于编译期检查格式串和参数
+ * */
+#define LOGGER_LOG(level, fmt, ...)                                            \
+  do {                                                                         \
+    static loggerSite_t loggerSite_ = {                                        \
+        .file = __FILE__, .line = __LINE__, .format = fmt};                    \
+    if ((level) <= __atomic_load_n(&g_loggerLevel, __ATOMIC_RELAXED)) {        \
+      logger_Log(&loggerSite_, (level), ##__VA_ARGS__);                        \
+    }                                                                          \
+    if (0) {                                                                   \
+      printf(fmt, ##__VA_ARGS__);                                              \
+    }                                                                          \
+  } while (0)
+
+#define LOGGER_ERROR(...) LOGGER_LOG(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOGGER_WARN(...) LOGGER_LOG(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOGGER_INFO(...) LOGGER_LOG(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOGGER_DEBUG(...) LOGGER_LOG(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+/* 预分配线程缓冲，打开输出并启动后台线程 */
+int logger_Init(const loggerConfig_t *config);
+
+/*
+ * 写入所有缓冲中的日志和未输出的汇总后停止后台线程，此后同步输出到stderr。
+ * 线程缓冲不释放（其他线程可能仍在使用）
+ * */
+void logger_Deinit(void);
+
+void logger_Log(loggerSite_t *site, int level, ...);
+
+/* 与 mqtt_client.h 中的 loggerCallback 兼容，按格式串区分调用位置 */
+void logger_Callback(int level, const char *format, ...);
+
+/* 运行时修改级别 */
+void logger_SetLevel(int level);
+
+/* 级别名称（error/warn/info/debug）与数值的转换，未知名称返回-1 */
+int logger_ParseLevel(const char *name);
+const char *logger_LevelName(int level);
+
+/* 等待后台线程写入调用之前提交的所有日志 */
+void logger_Flush(void);
+
+void logger_GetStats(loggerStats_t *stats);
+
+#endif // !_LOGGER_H
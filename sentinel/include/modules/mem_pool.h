@@ -0,0 +1,78 @@
+#ifndef _MEM_POOL_H
+#define _MEM_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* 静态内存模式配置（对应 sentinel_config.json 中的 memoryConfig） */
+typedef struct {
+  bool staticMode;          // 是否启用静态内存模式
+  size_t budgetBytes;       // 启动时一次性申请的内存预算（字节）
+  int maxPayloadBytes;      // 单条MQTT消息载荷的最大长度
+  int maxTopicLen;          // Topic字符串的最大长度
+  size_t commandArenaBytes; // 命令解析arena大小（字节）
+} memPoolConfig_t;
+
+/* 线性分配器（arena）：只分配不单独释放，使用完毕后整体reset复用 */
+typedef struct {
+  char *base;    // arena起始地址
+  size_t size;   // arena总大小
+  size_t used;   // 当前已使用大小
+  size_t peak;   // 历史最大使用量
+  size_t failed; // 空间不足导致的分配失败次数
+} memArena_t;
+
+/* 内存池统计信息 */
+typedef struct {
+  size_t budgetBytes; // 预算总量
+  size_t usedBytes;   // 已从预算中切分出的大小
+  bool sealed;        // 是否已进入稳态（禁止再分配）
+  long peakRssKb;     // 进程峰值常驻内存（KB）
+} memPoolStats_t;
+
+/* 初始化内存池，静态模式下一次性申请全部预算 */
+int memPool_Init(const memPoolConfig_t *config);
+
+/* 是否处于静态内存模式 */
+bool memPool_IsStatic(void);
+
+/* 获取内存池配置 */
+const memPoolConfig_t *memPool_GetConfig(void);
+
+/* 从内存池分配（静态模式下从预算切分，否则退化为malloc） */
+void *memPool_Alloc(size_t size);
+
+/* 复制字符串到内存池 */
+char *memPool_Strdup(const char *str);
+
+/* 释放内存（池内地址为空操作，池外地址调用free） */
+void memPool_Free(void *ptr);
+
+/* 判断地址是否属于静态内存池 */
+bool memPool_Owns(const void *ptr);
+
+/* 启动完成，封闭内存池：此后任何memPool_Alloc都会失败 */
+void memPool_Seal(void);
+
+/* 获取内存池统计信息 */
+void memPool_GetStats(memPoolStats_t *stats);
+
+/* 获取进程峰值常驻内存（KB），不分配堆内存 */
+long memPool_GetPeakRssKb(void);
+
+/* 初始化arena，空间从内存池中切分 */
+int memArena_Init(memArena_t *arena, size_t size);
+
+/* 从arena中分配内存（8字节对齐） */
+void *memArena_Alloc(memArena_t *arena, size_t size);
+
+/* 重置arena，之前分配的内存全部失效 */
+void memArena_Reset(memArena_t *arena);
+
+/* 安装cJSON内存钩子（启动时调用一次） */
+void memPool_InstallCJSONHooks(void);
+
+/* 将当前线程的cJSON分配绑定到arena（NULL表示解绑，恢复malloc） */
+void memArena_BindCJSON(memArena_t *arena);
+
+#endif // !_MEM_POOL_H
@@ -0,0 +1,105 @@
+#ifndef _MODBUS_POLLER_H
+#define _MODBUS_POLLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modules/event_loop.h"
+
+#define MODBUS_MAX_POINTS 32    // 每个设备的测点数
+#define MODBUS_MAX_REGS 125     // 单个读请求的寄存器上限（协议规定）
+#define MODBUS_MAX_IN_FLIGHT 16 // 每个连接同时未完成的请求数上限
+
+/* 寄存器表，取值即读取的功能码 */
+typedef enum {
+  MODBUS_TABLE_HOLDING = 3, // 保持寄存器（0x03）
+  MODBUS_TABLE_INPUT = 4,   // 输入寄存器（0x04）
+} modbusTable_t;
+
+/* 测点数据类型，32位类型占两个寄存器，默认高字在前 */
+typedef enum {
+  MODBUS_TYPE_U16 = 0,
+  MODBUS_TYPE_I16,
+  MODBUS_TYPE_U32,
+  MODBUS_TYPE_I32,
+  MODBUS_TYPE_F32,
+} modbusType_t;
+
+/* 单个测点（modbusConfig.devices[].points），值 = 原始值 * scale + offset */
+typedef struct {
+  char name[24];
+  modbusTable_t table;
+  uint16_t address; // 协议地址（从0开始）
+  modbusType_t type;
+  bool swapWords; // 32位类型低字在前
+  double scale;
+  double offset;
+} modbusPointConfig_t;
+
+/* 单个从站设备 */
+typedef struct {
+  char name[24];
+  char host[64]; // IPv4地址
+  int port;
+  uint8_t unitId;
+  int intervalMs; // 轮询周期
+  int pointCount;
+  modbusPointConfig_t points[MODBUS_MAX_POINTS];
+} modbusDeviceConfig_t;
+
+/* 对应 sentinel_config.json 中 modbusConfig 的公共参数 */
+typedef struct {
+  int maxDevices;
+  int maxGap;      // 测点间隔不超过该寄存器数时合并为一个请求
+  int maxRegs;     // 单个请求的寄存器上限（不超过 MODBUS_MAX_REGS）
+  int maxInFlight; // 流水线深度，1 表示逐个请求
+  int timeoutMs;   // 一轮轮询的超时，超时后断开重连
+} modbusPollerConfig_t;
+
+/* 一个测点的结果，valid 为 false 表示该轮读取失败（异常响应） */
+typedef struct {
+  const char *name;
+  double value;
+  bool valid;
+} modbusValue_t;
+
+/* 每轮轮询完成时调用（事件循环线程），cycleUs 为发出请求到全部响应的时间 */
+typedef void (*modbusPollerCallback_t)(const char *device,
+                                       const modbusValue_t *values, int count,
+                                       int64_t cycleUs, void *userData);
+
+typedef struct {
+  bool connected;
+  int requestsPerCycle; // 合并后每轮的请求数
+  int registersPerCycle;
+  unsigned long cycles;
+  unsigned long overruns;   // 上一轮未完成而跳过的周期
+  unsigned long timeouts;   // 超时断开的次数
+  unsigned long exceptions; // 异常响应
+  unsigned long reconnects;
+  unsigned long requests;
+  unsigned long registers;
+  int64_t lastCycleUs;
+  int64_t maxCycleUs;
+} modbusDeviceStats_t;
+
+/* 初始化模块，设备的轮询定时器和连接挂在事件循环上 */
+int modbusPoller_Init(const modbusPollerConfig_t *config, eventLoop_t *loop,
+                      modbusPollerCallback_t callback, void *userData);
+
+/*
+ * 添加设备：把测点按寄存器表和地址合并成尽量少的读请求，
+ * 建立持久连接并按 intervalMs 轮询。返回设备序号，失败返回-1
+ * */
+int modbusPoller_AddDevice(const modbusDeviceConfig_t *device);
+
+int modbusPoller_DeviceCount(void);
+
+/* 获取设备名称和统计，序号无效返回-1 */
+int modbusPoller_GetDeviceStats(int index, const char **name,
+                                modbusDeviceStats_t *stats);
+
+/* 关闭所有连接和定时器 */
+void modbusPoller_Deinit(void);
+
+#endif // !_MODBUS_POLLER_H
@@ -6,6 +6,11 @@
 #include <stddef.h>  // for bool
 
 #include "MQTTClient.h"
+#include "modules/mqtt_tls.h"
+#include "modules/mqtt_v5.h"
+#include "modules/sim_broker.h"
+
+#define MQTT_MAX_EXTRA_SUBSCRIPTIONS 4
 
 /* 预定义日志级别回调函数 */
 typedef void (*loggerCallback)(int level, const char *format, ...);
@@ -37,11 +42,33 @@ typedef struct {
   char *password;           // 密码
   int keepAliveInterval;    // Keep-alive 心跳间隔（秒）
   int reconnectDelaySec;    // 自动重连间隔起点（秒）
-  int maxReconnectAttempts; // 最大尝试重连次数（0表示无限次）
+  int maxReconnectAttempts; // 连续重连失败次数上限（0表示不限），超过后按最大间隔重试
+  int connectTimeoutSec;    // 单次连接超时（秒），0 使用paho默认值
   bool
       cleanSession; // 清理会话（true：每次连接都创建新会话，不保留订阅和离线消息）
+  int maxPayloadBytes; // 接收载荷上限（>0时启动阶段预分配接收缓冲区，0表示按需动态分配）
+  int maxTopicLen;     // 接收Topic长度上限（与maxPayloadBytes配合使用）
+  mqttTlsConfig_t tls; // TLS配置
+  int mqttVersion;     // 协议版本：4 为 MQTT 3.1.1（默认，0 等同于4），5 为 MQTT 5
+  int topicAliasMax;   // MQTT 5 发送方向的Topic别名数量（0 不使用）
+  loggerCallback logger; // 日志回调（级别见 logger.h），NULL 时输出到stderr
+  bool simulated; // 仿真模式：连接仿真Broker（sim_broker.h），不创建paho客户端
 } mqttClientConfig_t;
 
+/* 连接统计，TLS连接的耗时包含握手 */
+typedef struct {
+  unsigned long attempts;
+  unsigned long failures;
+  unsigned long connects;    // 成功连接次数
+  unsigned long pskConnects; // 其中使用PSK握手的次数
+  unsigned long totalMs;     // 成功连接的总耗时
+  unsigned long pskTotalMs;  // PSK握手连接的总耗时
+  int lastMs;                // 最近一次成功连接的耗时
+  int maxMs;
+  int lastConnectReason;    // MQTT 5：最近一次CONNACK原因码（失败时为paho错误码）
+  int lastDisconnectReason; // MQTT 5：Broker发来的DISCONNECT原因码
+} mqttConnectStats_t;
+
 /* MQTT Client context structure */
 typedef struct {
   MQTTClient client;         // Paho MQTT 客户端句柄
@@ -50,8 +77,10 @@ typedef struct {
   // 线程同步机制
   pthread_mutex_t lock;     // 保持客户端状态和发送队列的互斥锁
   pthread_cond_t cond;      // 条件变量（实现发送队列的非阻塞等待）
-  bool isConnected;         // 当前连接状态
+  bool isConnected;         // 当前连接状态（原子访问，见mqttClient_IsConnected）
   volatile bool shouldExit; // 模块退出标志
+  pthread_t reconnectThread; // 连接/重连线程
+  bool threadRunning;
 
   // 注册的回调函数和用户数据
   mqttOnCommandCallback_t onCommandCb;
@@ -67,6 +96,26 @@ typedef struct {
   char *lwtTopic;
   char *lwtPayload;
   int lwtQos;
+
+  // 控制Topic之外的订阅（如OTA分片），每次连接后重新订阅
+  char *extraTopics[MQTT_MAX_EXTRA_SUBSCRIPTIONS];
+  int extraQos[MQTT_MAX_EXTRA_SUBSCRIPTIONS];
+  int extraCount;
+
+  // 预分配的接收缓冲区（静态内存模式，仅由paho接收线程使用）
+  char *rxTopicBuf;
+  char *rxPayloadBuf;
+  unsigned long rxDropped; // 超出缓冲区大小而被丢弃的消息数
+
+  mqttTlsPsk_t psk;                // TLS-PSK 状态
+  mqttConnectStats_t connectStats; // 连接统计（原子访问）
+
+  mqttTopicAliasTable_t aliases;    // MQTT 5 Topic别名（持有lock时访问）
+  mqttPublishStats_t publishStats;  // 发布统计（原子访问）
+
+  int watchdogId; // 重连线程的看门狗ID，-1 表示未监视
+
+  simBrokerSession_t simSession; // 仿真模式下的连接（持有lock时访问）
 } mqttClientContext_t;
 
 /* 初始化MQTT客户端上下文和配置 */
@@ -86,8 +135,18 @@ void mqttClient_RegisterConnectionStatusCallback(
 void mqttClient_SetLWT(mqttClientContext_t *ctx, const char *topic,
                        const char *payload, int qos);
 
+/*
+ * 增加订阅的Topic，消息同样交给命令回调（按Topic区分）。
+ * 在 mqttClient_Start 之前调用
+ * */
+int mqttClient_AddSubscription(mqttClientContext_t *ctx, const char *topic,
+                               int qos);
+
 /* 启动MQTT客户端和后台处理进程 */
-void mqttClient_Start(mqttClientContext_t *ctx);
+int mqttClient_Start(mqttClientContext_t *ctx);
+
+/* 停止后台线程并断开连接，之后可以再次调用mqttClient_Start */
+void mqttClient_Disconnect(mqttClientContext_t *ctx);
 
 /* 停止MQTT客户端连接并清理资源 */
 void mqttClient_Stop(mqttClientContext_t *ctx);
@@ -97,6 +156,30 @@ int mqttClient_Publish(mqttClientContext_t *ctx, const char *topic,
                        const char *payload, int payloadLen, int qos,
                        bool retained);
 
+/*
+ * 带发布属性发布MQTT消息（options 可为NULL）。reasonCode 非NULL时返回
+ * MQTT 5 原因码，失败且没有原因码时为paho错误码
+ */
+int mqttClient_PublishWithOptions(mqttClientContext_t *ctx, const char *topic,
+                                  const char *payload, int payloadLen, int qos,
+                                  bool retained,
+                                  const mqttPublishOptions_t *options,
+                                  int *reasonCode);
+
 /* 订阅MQTT Topic */
 int mqttClient_Subscribe(mqttClientContext_t *ctx, const char *topic, int qos);
+
+/* 获取连接统计（无锁） */
+void mqttClient_GetConnectStats(const mqttClientContext_t *ctx,
+                                mqttConnectStats_t *stats);
+
+/* 获取发布统计（无锁） */
+void mqttClient_GetPublishStats(const mqttClientContext_t *ctx,
+                                mqttPublishStats_t *stats);
+
+/* 获取连接状态（无锁） */
+bool mqttClient_IsConnected(const mqttClientContext_t *ctx);
+
+/* 单次连接的最长耗时（毫秒），用于设置看门狗超时 */
+int mqttClient_ConnectTimeoutMs(const mqttClientContext_t *ctx);
 #endif // !_MQTT_CLIENT_H
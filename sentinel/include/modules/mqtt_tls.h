@@ -0,0 +1,56 @@
+#ifndef _MQTT_TLS_H
+#define _MQTT_TLS_H
+
+#include <stdbool.h>
+
+#define MQTT_TLS_PSK_IDENTITY_MAX 64
+#define MQTT_TLS_PSK_KEY_MAX 64
+
+/* TLS配置（对应 sentinel_config.json 中 mqttClientConfig.tls） */
+typedef struct {
+  bool enabled;        // Broker地址需为 ssl:// 或 mqtts://
+  char *caFile;        // 校验服务端证书的CA证书（PEM）
+  char *caPath;        // CA证书目录（可选）
+  char *certFile;      // 客户端证书（双向认证，可选）
+  char *keyFile;       // 客户端私钥
+  char *keyPassword;   // 私钥口令（可选）
+  char *ciphers;       // 密码套件（OpenSSL格式，可选）
+  bool verifyServer;   // 校验服务端证书链
+  bool verifyHostname; // 校验证书中的主机名
+  char *pskIdentity;   // TLS-PSK 身份（可选）
+  char *pskKey;        // TLS-PSK 密钥（十六进制）
+} mqttTlsConfig_t;
+
+/*
+ * TLS-PSK 状态。Broker选择PSK套件时，握手只做对称运算，
+ * 不传输和校验证书链，也没有签名运算，重连开销接近会话恢复
+ */
+typedef struct {
+  char identity[MQTT_TLS_PSK_IDENTITY_MAX];
+  unsigned char key[MQTT_TLS_PSK_KEY_MAX];
+  unsigned int keyLen;
+  unsigned long invocations; // 回调被调用的次数，即PSK握手次数
+} mqttTlsPsk_t;
+
+/* 检查配置中的证书和私钥文件是否可读，便于启动时给出明确的错误 */
+int mqttTls_CheckConfig(const mqttTlsConfig_t *config);
+
+/* 解析十六进制密钥，返回字节数，格式错误返回-1 */
+int mqttTls_ParseHexKey(const char *hex, unsigned char *key,
+                        unsigned int maxLen);
+
+/* 初始化PSK状态，identity 为空表示不使用PSK */
+int mqttTls_InitPsk(mqttTlsPsk_t *psk, const char *identity,
+                    const char *keyHex);
+
+/* PSK回调，签名与paho的 MQTTClient_SSLOptions.ssl_psk_cb 一致 */
+unsigned int mqttTls_PskCallback(const char *hint, char *identity,
+                                 unsigned int maxIdentityLen,
+                                 unsigned char *psk, unsigned int maxPskLen,
+                                 void *userData);
+
+/* 复制TLS配置（字符串使用内存池），释放使用 mqttTls_FreeConfig */
+void mqttTls_CopyConfig(mqttTlsConfig_t *dst, const mqttTlsConfig_t *src);
+void mqttTls_FreeConfig(mqttTlsConfig_t *config);
+
+#endif // !_MQTT_TLS_H
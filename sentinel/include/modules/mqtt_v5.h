@@ -0,0 +1,72 @@
+#ifndef _MQTT_V5_H
+#define _MQTT_V5_H
+
+#include <stdbool.h>
+
+#define MQTT_USER_PROPERTY_MAX 4
+#define MQTT_TOPIC_ALIAS_MAX 16
+
+/* MQTT 5 用户属性（名称/值对） */
+typedef struct {
+  const char *name;
+  const char *value;
+} mqttUserProperty_t;
+
+/*
+ * 发布属性。字符串只保存指针，需在消息发出前保持有效（通常为静态字符串）。
+ * 使用 MQTT 3.1.1 时内容类型和用户属性不发送，过期时间只用于本地丢弃
+ */
+typedef struct {
+  const char *contentType; // 内容类型，如 "application/json"
+  int messageExpirySec;    // 消息过期时间（秒），0 表示不过期
+  int userPropertyCount;
+  mqttUserProperty_t userProperties[MQTT_USER_PROPERTY_MAX];
+} mqttPublishOptions_t;
+
+/*
+ * 发送方向的Topic别名表。别名只在一个网络连接内有效，每次连接后按
+ * Broker在CONNACK中声明的 Topic Alias Maximum 重置，按首次发布的顺序分配
+ */
+typedef struct {
+  int capacity; // 配置的别名数量（槽位数）
+  int max;      // 本次连接可用的别名数量，0 表示不使用别名
+  int count;    // 已分配的别名数量，别名值为下标+1
+  int topicCap; // 每个槽位的长度
+  char *topics; // capacity 个槽位，启动时从内存池分配
+} mqttTopicAliasTable_t;
+
+/* 发布统计，字节数按MQTT报文编码计算（不含TCP/TLS开销） */
+typedef struct {
+  unsigned long messages;
+  unsigned long bytes;           // PUBLISH报文字节数
+  unsigned long aliasHits;       // 使用已建立的别名、省略Topic的消息数
+  unsigned long aliasSavedBytes; // 因省略Topic节省的字节数
+  unsigned long rejected;        // Broker返回失败原因码（>=0x80）的消息数
+  int lastReasonCode;            // 最近一次失败的原因码
+} mqttPublishStats_t;
+
+/* 分配别名表，capacity 为0时不使用别名 */
+int mqttV5_AliasInit(mqttTopicAliasTable_t *table, int capacity, int topicCap);
+void mqttV5_AliasFree(mqttTopicAliasTable_t *table);
+
+/* 新连接建立后调用，brokerMax 为Broker允许的别名数量 */
+void mqttV5_AliasReset(mqttTopicAliasTable_t *table, int brokerMax);
+
+/*
+ * 查找或分配Topic的别名。返回别名（0 表示不使用别名）；
+ * *established 为 true 表示该别名已随之前的消息发给Broker，本次可省略Topic
+ */
+int mqttV5_AliasLookup(mqttTopicAliasTable_t *table, const char *topic,
+                       bool *established);
+
+/* 计算发布属性编码后的长度（不含属性长度字段本身） */
+int mqttV5_PropertiesLength(const mqttPublishOptions_t *options, int alias);
+
+/*
+ * 计算PUBLISH报文的总长度。mqttVersion 为 4（3.1.1）时没有属性字段，
+ * topicLen 为0表示使用已建立的别名
+ */
+int mqttV5_PublishPacketSize(int mqttVersion, int topicLen, int payloadLen,
+                             int qos, int propertiesLen);
+
+#endif // !_MQTT_V5_H
@@ -0,0 +1,110 @@
+#ifndef _OTA_UPDATE_H
+#define _OTA_UPDATE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modules/sha256.h"
+
+/*
+ * OTA固件下载：镜像按固定大小分片，在 app/{app_id}/ota 上以二进制消息发送，
+ * 每片带8字节头（会话ID、分片序号，均为大端 uint32），之后是分片数据。
+ * 分片按序号顺序追加到写缓冲，缓冲写满时整块写入目标（非活动分区或文件）
+ * 并同步，然后持久化偏移和SHA-256中间状态；断线或重启后从最后持久化的
+ * 偏移继续。内存占用固定为一个写缓冲加一条消息
+ * */
+
+#define OTA_CHUNK_HEADER 8
+#define OTA_WRITE_ALIGN 512 // 分片大小和写缓冲大小的对齐单位（扇区）
+
+/* 对应 sentinel_config.json 中的 otaConfig */
+typedef struct {
+  char target[128];       // 写入目标：非活动分区的块设备或镜像文件
+  char stateFile[128];    // 断点续传状态文件，空字符串不支持续传
+  char applyCommand[128]; // 校验通过后由 apply 命令执行（如切换启动分区）
+  uint32_t bufferBytes;   // 写缓冲大小，即每次写入的大小
+  uint32_t maxChunkBytes; // 分片大小上限（受MQTT接收缓冲限制）
+  int progressStepPercent; // 进度上报间隔（百分比）
+} otaConfig_t;
+
+typedef enum {
+  OTA_STATE_IDLE = 0,
+  OTA_STATE_DOWNLOADING,
+  OTA_STATE_VERIFIED, // 下载完成且SHA-256一致
+  OTA_STATE_FAILED,
+} otaState_t;
+
+/* 下载状态快照 */
+typedef struct {
+  otaState_t state;
+  uint32_t sessionId;
+  uint32_t chunkSize;
+  uint64_t size;
+  uint64_t received;  // 已按顺序接收的字节数
+  uint64_t committed; // 已写入并持久化的字节数（续传起点）
+  uint32_t nextSeq;   // 期望的下一个分片序号
+  unsigned long duplicates; // 重复分片（已接收过，直接丢弃）
+  unsigned long gaps;       // 序号超前的分片（需从 nextSeq 重发）
+  unsigned long writes;     // 写入次数
+  uint32_t bytesPerSec;     // 本次（续传后）的平均速率
+  bool resumed;             // 本次下载是否从断点继续
+  char error[64];
+} otaStatus_t;
+
+/* 进度、完成、失败和分片缺失时调用（不持有锁） */
+typedef void (*otaProgressCallback_t)(const otaStatus_t *status,
+                                      void *userData);
+
+typedef struct {
+  otaConfig_t config;
+  pthread_mutex_t lock; // 多个Broker的接收线程可能同时投递分片
+  int fd;
+  uint8_t *buffer; // 写缓冲（启动阶段从内存池分配）
+  uint32_t buffered;
+  uint8_t digest[SHA256_DIGEST_LEN]; // 期望的摘要
+  sha256_t sha;
+  otaStatus_t status;
+  int64_t runStartMs;
+  uint64_t runStartOffset;
+  int reportedPercent;
+  uint32_t reportedGapSeq;
+  otaProgressCallback_t progressCb;
+  void *progressUserData;
+} otaUpdate_t;
+
+/*
+ * 分配写缓冲并加载续传状态，未完成的下载会重新打开目标等待后续分片；
+ * 保存的分片大小不适用于当前的写缓冲或分片上限时，该下载标记为失败
+ * */
+int otaUpdate_Init(otaUpdate_t *ota, const otaConfig_t *config,
+                   otaProgressCallback_t callback, void *userData);
+
+/*
+ * 开始下载。会话ID、大小、分片大小和摘要与未完成的下载一致时从断点继续，
+ * 否则从头开始
+ * */
+int otaUpdate_Begin(otaUpdate_t *ota, uint32_t sessionId, uint64_t size,
+                    uint32_t chunkSize,
+                    const uint8_t digest[SHA256_DIGEST_LEN]);
+
+/*
+ * 处理一条分片消息（含头）。返回0表示已接收或为重复分片，
+ * -1 表示不属于当前下载、序号不连续或写入失败
+ * */
+int otaUpdate_WriteChunk(otaUpdate_t *ota, const void *data, int len);
+
+/* 放弃当前下载并删除续传状态 */
+void otaUpdate_Abort(otaUpdate_t *ota);
+
+/* 执行 applyCommand，只在校验通过后允许，返回命令的退出状态 */
+int otaUpdate_Apply(otaUpdate_t *ota);
+
+void otaUpdate_GetStatus(otaUpdate_t *ota, otaStatus_t *status);
+
+const char *otaUpdate_StateName(otaState_t state);
+
+/* 写入缓冲中剩余的数据并关闭目标 */
+void otaUpdate_Deinit(otaUpdate_t *ota);
+
+#endif // !_OTA_UPDATE_H
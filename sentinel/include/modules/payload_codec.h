@@ -0,0 +1,69 @@
+#ifndef _PAYLOAD_CODEC_H
+#define _PAYLOAD_CODEC_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 上行载荷压缩：LZ77类编码（LZ4风格的序列格式），使用根据协议规范内置的
+ * 预置字典，使小消息中重复出现的JSON键名也能被压缩。
+ *
+ * 压缩帧格式：
+ *   [0]    PAYLOAD_CODEC_MAGIC（JSON载荷不可能以该字节开头）
+ *   [1]    字典版本 PAYLOAD_CODEC_DICT_ID
+ *   [2..]  原始长度（LEB128 变长整数）
+ *   [...]  序列：token(高4位字面量长度，低4位匹配长度-4) + 扩展长度 +
+ *          字面量 + 2字节小端偏移 + 扩展匹配长度；最后一个序列只有字面量
+ * */
+#define PAYLOAD_CODEC_MAGIC 0xC5
+#define PAYLOAD_CODEC_DICT_ID 0x01
+#define PAYLOAD_CODEC_MAX_TOPICS 8
+#define PAYLOAD_CODEC_HASH_BITS 12
+
+/* 压缩输出的最坏长度 */
+#define PAYLOAD_CODEC_BOUND(n) ((n) + (n) / 255 + 16)
+
+/* 压缩配置（对应 sentinel_config.json 中的 compressionConfig） */
+typedef struct {
+  bool enabled;         // 是否启用压缩
+  int minBytes;         // 小于该长度的载荷不压缩
+  int maxPayloadBytes;  // 可压缩的最大原始载荷长度（决定工作区大小）
+  int topicCount;       // 启用压缩的Topic数量
+  char topics[PAYLOAD_CODEC_MAX_TOPICS][32]; // Topic最后一级名称，如 "status"
+} payloadCodecConfig_t;
+
+/* 压缩器上下文 */
+typedef struct {
+  payloadCodecConfig_t config;
+  pthread_mutex_t lock;      // 工作区由发布线程共享
+  uint8_t *work;             // 工作区：字典 + 原始载荷
+  size_t workCap;            // 工作区大小
+  uint32_t *dictTable;       // 预置字典的哈希表（初始化时计算一次）
+  uint32_t *table;           // 每次压缩使用的哈希表
+  unsigned long rawBytes;    // 累计原始字节数
+  unsigned long packedBytes; // 累计压缩后字节数
+} payloadCodec_t;
+
+/* 初始化压缩器，工作区从内存池分配 */
+int payloadCodec_Init(payloadCodec_t *codec, const payloadCodecConfig_t *config);
+
+/* 判断某个Topic（按最后一级名称匹配）是否需要压缩 */
+bool payloadCodec_TopicEnabled(const payloadCodec_t *codec, const char *topic);
+
+/* 压缩载荷，返回压缩后长度；压缩后不更小或失败时返回-1 */
+int payloadCodec_Compress(payloadCodec_t *codec, const char *src, int srcLen,
+                          uint8_t *dst, int dstCap);
+
+/* 判断载荷是否为压缩帧 */
+bool payloadCodec_IsCompressed(const void *payload, int payloadLen);
+
+/* 解压缩载荷（线程安全，无需上下文），返回原始长度，失败返回-1 */
+int payloadCodec_Decompress(const uint8_t *src, int srcLen, char *dst,
+                            int dstCap);
+
+/* 获取预置字典 */
+const char *payloadCodec_GetDictionary(size_t *len);
+
+#endif // !_PAYLOAD_CODEC_H
@@ -0,0 +1,96 @@
+#ifndef _PERF_COUNTERS_H
+#define _PERF_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 硬件性能计数器：用 perf_event_open 统计采样周期中各阶段（读取、序列化、
+ * 发布）的周期数、指令数、缓存未命中、分支预测失败和上下文切换。
+ * 计数器按线程打开（只统计用户态），同一线程的计数器组成一组，每个阶段
+ * 结束时一次 read 读出全部计数。
+ * 内核不支持或权限不足（容器、perf_event_paranoid 限制）时对应事件标记
+ * 为不可用，阶段的墙上时间照常统计；上下文切换退化为 getrusage。
+ * 未启用时只多一次原子读
+ * */
+
+typedef enum {
+  PERF_EVENT_CYCLES = 0,
+  PERF_EVENT_INSTRUCTIONS,
+  PERF_EVENT_CACHE_MISSES,
+  PERF_EVENT_BRANCH_MISSES,
+  PERF_EVENT_CONTEXT_SWITCHES,
+  PERF_EVENT_COUNT,
+} perfEvent_t;
+
+/* 阶段累计值，由 PERF_LAP 宏为每个调用点定义一个静态实例 */
+typedef struct perfStage {
+  const char *name;
+  int registered; // 首次统计时加入全局链表
+  struct perfStage *next;
+  unsigned long samples;
+  uint64_t wallNs;
+  uint64_t maxWallNs;
+  uint64_t counts[PERF_EVENT_COUNT];
+  unsigned long counted[PERF_EVENT_COUNT]; // 该事件有效的样本数
+} perfStage_t;
+
+/* 上一个阶段结束时的计数，作为下一个阶段的起点 */
+typedef struct {
+  bool active;
+  uint64_t wallNs;
+  uint64_t enabledNs; // 计数器组的启用时间和实际计数时间（分时复用）
+  uint64_t runningNs;
+  uint64_t values[PERF_EVENT_COUNT];
+  uint32_t valid; // 按 perfEvent_t 的位掩码
+} perfSnapshot_t;
+
+/* 单个阶段的统计快照 */
+typedef struct {
+  const char *name;
+  unsigned long samples;
+  uint64_t wallNs;
+  uint64_t maxWallNs;
+  uint64_t counts[PERF_EVENT_COUNT];
+  unsigned long counted[PERF_EVENT_COUNT];
+} perfStageStats_t;
+
+/* 计数器可用情况 */
+typedef struct {
+  uint32_t available; // 最近打开计数器的线程中可用事件的位掩码
+  int openErrno;      // 第一个打开失败的事件的错误码，0 表示全部成功
+  int paranoid;       // /proc/sys/kernel/perf_event_paranoid，读取失败为-100
+} perfCountersStatus_t;
+
+#define PERF_STAGE_INIT(stageName)                                             \
+  { .name = (stageName) }
+
+/* 结束名为 stageName 的阶段并开始下一个阶段 */
+#define PERF_LAP(snapshot, stageName)                                          \
+  do {                                                                         \
+    static perfStage_t perfStage_ = PERF_STAGE_INIT(stageName);                \
+    perfCounters_Lap((snapshot), &perfStage_);                                 \
+  } while (0)
+
+/* 运行时开关，默认关闭 */
+void perfCounters_SetEnabled(bool enabled);
+bool perfCounters_IsEnabled(void);
+
+/* 开始一个采样周期：首次调用时为当前线程打开计数器 */
+void perfCounters_Begin(perfSnapshot_t *snapshot);
+
+/* 把上一个阶段结束以来的增量计入 stage，snapshot 更新为当前计数 */
+void perfCounters_Lap(perfSnapshot_t *snapshot, perfStage_t *stage);
+
+/* 事件名称，如 "cycles" */
+const char *perfCounters_EventName(perfEvent_t event);
+
+void perfCounters_GetStatus(perfCountersStatus_t *status);
+
+/* 按注册顺序输出最多 max 个有样本的阶段，返回个数 */
+int perfCounters_GetStages(perfStageStats_t *out, int max);
+
+/* 清零所有统计 */
+void perfCounters_Reset(void);
+
+#endif // !_PERF_COUNTERS_H
@@ -0,0 +1,87 @@
+#ifndef _PWM_LED_H
+#define _PWM_LED_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modules/event_loop.h"
+
+#define PWM_SYSFS_ROOT "/sys/class/pwm"
+#define PWM_MAX_CHANNELS 8
+
+/* 单个PWM通道配置 */
+typedef struct {
+  char name[32];     // 命令中的target名称，如 "pwm_led0"
+  int chip;          // pwmchipN
+  int channel;       // pwmM
+  uint32_t periodNs; // PWM周期（纳秒）
+  bool inverted;     // 低电平点亮的LED
+} pwmChannelConfig_t;
+
+/* PWM模块配置（对应 sentinel_config.json 中的 pwmConfig） */
+typedef struct {
+  char sysfsRoot[128]; // sysfs根目录，测试时可指向伪造的目录树
+  uint32_t tickUs;     // 渐变/闪烁的定时器步长（微秒）
+  int channelCount;
+  pwmChannelConfig_t channels[PWM_MAX_CHANNELS];
+} pwmLedConfig_t;
+
+/* 通道当前的输出模式 */
+typedef enum {
+  PWM_MODE_STATIC = 0, // 固定亮度
+  PWM_MODE_FADE,       // 在给定时间内线性渐变到目标亮度
+  PWM_MODE_BLINK,      // 周期性闪烁
+} pwmMode_t;
+
+/* 通道运行状态，duty_cycle 文件句柄在初始化时打开并一直保持 */
+typedef struct {
+  pwmChannelConfig_t config;
+  int dutyFd;            // duty_cycle
+  int enableFd;          // enable
+  pwmMode_t mode;
+  float level;           // 当前亮度（0~100）
+  uint32_t lastDutyNs;   // 最近一次写入的占空比，相同值不重复写
+  float fadeFrom;        // 渐变起点亮度
+  float fadeTo;          // 渐变终点亮度
+  int64_t startNs;       // 渐变/闪烁开始时间
+  uint64_t durationNs;   // 渐变时长
+  float blinkOn;         // 闪烁点亮时的亮度
+  uint64_t blinkPeriodNs; // 闪烁周期
+  uint32_t blinkCount;   // 闪烁次数（0 表示一直闪烁）
+  int64_t pendingCmdNs;  // 等待第一次输出的命令接收时间（0 表示无）
+} pwmChannel_t;
+
+/* 命令到输出的延迟统计 */
+typedef struct {
+  unsigned long count;
+  uint64_t totalNs;
+  uint64_t maxNs;
+  uint64_t lastNs;
+  unsigned long writes; // pwrite 次数
+} pwmLatencyStats_t;
+
+/* 初始化PWM通道并注册为命令target，定时器挂在事件循环上 */
+int pwmLed_Init(const pwmLedConfig_t *config, eventLoop_t *loop);
+
+/* 设置亮度（0~100），立即生效 */
+int pwmLed_Set(const char *name, float level, int64_t cmdNs);
+
+/* 在durationMs内渐变到目标亮度 */
+int pwmLed_Fade(const char *name, float level, uint32_t durationMs,
+                int64_t cmdNs);
+
+/* 以periodMs为周期闪烁count次（0表示一直闪烁） */
+int pwmLed_Blink(const char *name, float level, uint32_t periodMs,
+                 uint32_t count, int64_t cmdNs);
+
+/* 获取通道当前亮度，找不到通道返回-1 */
+float pwmLed_GetLevel(const char *name);
+
+/* 获取命令到输出的延迟统计 */
+void pwmLed_GetLatencyStats(pwmLatencyStats_t *stats);
+
+/* 关闭所有通道句柄 */
+void pwmLed_Deinit(void);
+
+#endif // !_PWM_LED_H
@@ -0,0 +1,104 @@
+#ifndef _RULE_ENGINE_H
+#define _RULE_ENGINE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cJSON/cJSON.h"
+#include "modules/command_dispatch.h"
+
+#define RULE_MAX_RULES 64
+#define RULE_MAX_CONDITIONS 4 // 每条规则最多的条件数（AND关系）
+#define RULE_MAX_FIELDS 32
+#define RULE_MAX_ACTIONS (RULE_MAX_RULES * 2)
+
+/* 比较运算符 */
+typedef enum {
+  RULE_OP_LT = 0,
+  RULE_OP_LE,
+  RULE_OP_GT,
+  RULE_OP_GE,
+  RULE_OP_EQ,
+  RULE_OP_NE,
+} ruleOp_t;
+
+/* 编译后的条件：字段ID + 运算符 + 阈值 */
+typedef struct {
+  uint8_t fieldId;
+  uint8_t op;
+  float threshold;
+} ruleCondition_t;
+
+/* 编译后的规则及其运行状态 */
+typedef struct {
+  char name[32];
+  ruleCondition_t conds[RULE_MAX_CONDITIONS];
+  uint8_t condCount;
+  bool active;          // 当前是否处于触发状态
+  float hysteresis;     // 退出触发状态所需越过阈值的回差
+  uint32_t debounceMs;  // 状态变化需要持续的时间
+  uint32_t rateLimitMs; // 两次动作之间的最小间隔
+  int16_t actionIdx;    // 进入触发状态时执行的动作（-1 表示无）
+  int16_t clearIdx;     // 退出触发状态时执行的动作（-1 表示无）
+  int64_t pendingSinceMs; // 等待去抖的状态变化开始时间（0 表示无）
+  int64_t lastFireMs;     // 上一次执行动作的时间
+  uint32_t fireCount;     // 累计执行动作次数
+} rule_t;
+
+/* 规则动作回调：执行命令（与远程命令走同一分发入口） */
+typedef void (*ruleActionCallback_t)(const char *ruleName,
+                                     const sentinelCommand_t *cmd,
+                                     void *userData);
+
+/* 一次采样中某个字段的值 */
+typedef struct {
+  int fieldId; // ruleEngine_FieldId 返回的ID，-1 的字段会被忽略
+  double value;
+} ruleSample_t;
+
+/* 规则评估开销统计 */
+typedef struct {
+  unsigned long samples;   // 评估的采样次数
+  unsigned long long totalNs;
+  unsigned long long maxNs;
+  int ruleCount;
+  int fieldCount;
+} ruleEngineStats_t;
+
+/* 规则引擎 */
+typedef struct {
+  pthread_mutex_t lock; // 多个采样线程共享
+  rule_t *rules;
+  int ruleCount;
+  sentinelCommand_t *actions;
+  int actionCount;
+  char fieldNames[RULE_MAX_FIELDS][48];
+  double values[RULE_MAX_FIELDS];
+  bool valid[RULE_MAX_FIELDS];
+  uint64_t fieldRules[RULE_MAX_FIELDS]; // 依赖该字段的规则位图
+  int fieldCount;
+  ruleActionCallback_t actionCb;
+  void *actionUserData;
+  ruleEngineStats_t stats;
+} ruleEngine_t;
+
+/* 从配置（ruleEngineConfig.rules 数组）编译规则 */
+int ruleEngine_Init(ruleEngine_t *engine, const cJSON *rules);
+
+/* 设置规则动作回调 */
+void ruleEngine_SetActionCallback(ruleEngine_t *engine,
+                                  ruleActionCallback_t callback,
+                                  void *userData);
+
+/* 查询字段ID（"source.field" 形式），没有规则引用该字段时返回-1 */
+int ruleEngine_FieldId(const ruleEngine_t *engine, const char *name);
+
+/* 提交一次采样并评估依赖这些字段的规则 */
+void ruleEngine_OnSample(ruleEngine_t *engine, const ruleSample_t *samples,
+                         int count, int64_t nowMs);
+
+/* 获取评估开销统计 */
+void ruleEngine_GetStats(ruleEngine_t *engine, ruleEngineStats_t *stats);
+
+#endif // !_RULE_ENGINE_H
@@ -0,0 +1,29 @@
+#ifndef _SHA256_H
+#define _SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_DIGEST_LEN 32
+
+/*
+ * 增量SHA-256（FIPS 180-4）。上下文是普通结构体，可以整体保存到文件，
+ * 恢复后继续计算（OTA断点续传）
+ * */
+typedef struct {
+  uint32_t state[8];
+  uint64_t bytes;    // 已输入的总字节数
+  uint8_t block[64]; // 未满一个分组的数据
+} sha256_t;
+
+void sha256_Init(sha256_t *ctx);
+void sha256_Update(sha256_t *ctx, const void *data, size_t len);
+void sha256_Final(sha256_t *ctx, uint8_t digest[SHA256_DIGEST_LEN]);
+
+/* 解析64位十六进制摘要，成功返回0 */
+int sha256_ParseHex(const char *hex, uint8_t digest[SHA256_DIGEST_LEN]);
+
+/* 格式化为十六进制字符串，out 至少 65 字节 */
+void sha256_ToHex(const uint8_t digest[SHA256_DIGEST_LEN], char *out);
+
+#endif // !_SHA256_H
@@ -0,0 +1,58 @@
+#ifndef _SIM_H
+#define _SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cJSON/cJSON.h"
+#include "modules/broker_group.h"
+#include "modules/sim_broker.h"
+
+/*
+ * 仿真模式：虚拟时钟加仿真Broker，传感器读数按种子生成或回放，运行
+ * durationSec 后写出报告。报告中除 rss_kb 外的数值只由配置和种子决定，
+ * 可以直接与上一次运行的报告比较
+ * */
+
+/* 对应 sentinel_config.json 中的 simulationConfig */
+typedef struct {
+  bool enabled;
+  int64_t durationMs;
+  int64_t epochMs;          // 虚拟时钟的起始Unix时间
+  int64_t reportIntervalMs; // 记录内存用量的间隔
+  char reportPath[128];
+  char replayFile[128]; // 传感器回放文件（CSV），空表示按种子生成
+  simBrokerConfig_t broker;
+} simConfig_t;
+
+/* 仿真报告用到的网关状态 */
+typedef struct {
+  brokerGroup_t *brokerGroup;
+  const unsigned long *samplesProduced; // 原子读取
+  const unsigned long *samplesOffline;
+  bool *exitFlag; // 提前退出时为 true，仿真结束时置为 true
+} simContext_t;
+
+/*
+ * @brief 解析 simulationConfig（时间以秒配置），无法识别的中断方式和
+ *        无效的中断输出到 stderr 后忽略
+ * */
+void sim_ParseConfig(const cJSON *config_sim, simConfig_t *config);
+
+/*
+ * @brief 启动虚拟时钟、仿真Broker和仿真传感器，必须在所有工作线程之前调用
+ *
+ * @return 0 成功
+ * */
+int sim_Init(const simConfig_t *config);
+
+/*
+ * @brief 运行仿真直到 durationSec（启动完成后在主线程调用）：按
+ *        reportIntervalSec 记录内存，结束时写出报告，置位 exitFlag 并结束
+ *        虚拟时钟，让各线程按真实时间退出
+ *
+ * @return 0 成功，报告写入失败返回-1
+ * */
+int sim_Run(const simContext_t *ctx);
+
+#endif // !_SIM_H
@@ -0,0 +1,104 @@
+#ifndef _SIM_BROKER_H
+#define _SIM_BROKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 仿真Broker：仿真模式下代替paho和真实Broker，按脚本制造中断、延迟和
+ * 确认丢失，并统计送达情况。所有等待都使用虚拟时钟（sim_clock.h），
+ * 随机数按Broker分别播种，同样的配置得到同样的结果。
+ * Broker按地址（主机:端口）区分，按首次出现的顺序编号
+ * */
+
+#define SIM_BROKER_MAX 4
+#define SIM_BROKER_MAX_OUTAGES 16
+
+/* 中断方式 */
+typedef enum {
+  SIM_OUTAGE_CLOSE = 0, // 连接被重置：客户端立即发现，重连被拒绝
+  SIM_OUTAGE_BLACKHOLE, // 报文被丢弃：客户端靠keep-alive超时发现，连接超时
+} simOutageMode_t;
+
+typedef struct {
+  int64_t startMs; // 相对仿真开始的时间
+  int64_t durationMs;
+  simOutageMode_t mode;
+  int broker; // Broker编号，-1 表示全部
+} simOutage_t;
+
+/* 对应 sentinel_config.json 中 simulationConfig 的 broker */
+typedef struct {
+  uint32_t seed;
+  int latencyMs;             // 单程延迟
+  int jitterMs;              // 延迟的随机增量上限
+  double connectFailPercent; // 连接被拒绝的比例
+  double ackLossPercent;     // QoS>0 消息确认丢失、重发后Broker收到重复消息的比例
+  double dropPercent;        // QoS 0 消息在传输中丢失的比例
+  int64_t periodicEveryMs;   // 周期性中断的间隔，0 不启用
+  int64_t periodicDurationMs;
+  simOutageMode_t periodicMode;
+  int outageCount;
+  simOutage_t outages[SIM_BROKER_MAX_OUTAGES];
+} simBrokerConfig_t;
+
+/* 单个Broker的统计 */
+typedef struct {
+  char address[64];
+  unsigned long connects;
+  unsigned long connectFailures;
+  unsigned long sessionsLost; // 被中断的连接数
+  unsigned long received;     // 送达的消息（不含重复）
+  unsigned long duplicates;
+  unsigned long lost;     // 客户端已发出但没有送达的消息
+  unsigned long refused;  // 连接已断开，发布直接失败（由发送队列重试）
+  unsigned long bytes;    // 送达的载荷字节数
+  unsigned long probes;
+  unsigned long probeFailures;
+  int64_t outageMs; // 已经历的中断总时长
+} simBrokerStats_t;
+
+/* 一个客户端连接，由 mqtt_client 持有 */
+typedef struct {
+  int broker;
+  bool open;
+  int keepAliveMs;
+  int connectTimeoutMs;
+  int64_t connectedMs;
+  int64_t outageMs; // 本次连接遇到的第一个中断的开始时间，-1 表示没有
+  int64_t lostMs;   // 客户端发现连接断开的时间
+  bool blackhole;
+} simBrokerSession_t;
+
+/* 启用仿真Broker，在 simClock_Start 之后调用 */
+int simBroker_Init(const simBrokerConfig_t *config);
+
+bool simBroker_IsActive(void);
+
+/* 按地址绑定到一个Broker */
+int simBroker_Open(simBrokerSession_t *session, const char *address,
+                   int keepAliveSec, int connectTimeoutMs);
+
+/* 建立连接（耗时一个往返，连接超时时为超时时间），0 成功 */
+int simBroker_Connect(simBrokerSession_t *session);
+
+/*
+ * 代替 MQTTClient_yield：等待最多 ms 毫秒，期间连接断开时提前返回-1
+ * */
+int simBroker_Yield(simBrokerSession_t *session, int ms);
+
+/* 发布一条消息，0 表示客户端发送成功（不代表送达） */
+int simBroker_Publish(simBrokerSession_t *session, int payloadLen, int qos);
+
+void simBroker_Disconnect(simBrokerSession_t *session);
+
+/* 代替TCP健康探测，返回连接耗时（微秒），失败返回-1 */
+int simBroker_Probe(const char *host, int port, int timeoutMs);
+
+/* 解析 "close" / "blackhole"，无法识别时返回-1 */
+int simBroker_ParseOutageMode(const char *name);
+
+/* 返回Broker数量 */
+int simBroker_GetStats(simBrokerStats_t *stats, int max);
+
+#endif // !_SIM_BROKER_H
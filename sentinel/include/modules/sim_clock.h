@@ -0,0 +1,87 @@
+#ifndef _SIM_CLOCK_H
+#define _SIM_CLOCK_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * 时钟抽象：时间戳、睡眠、条件变量超时和线程创建都经过这里。
+ * 默认直接使用系统时钟；仿真模式（simClock_Start）下改为虚拟时钟，
+ * 通过 simClock_CreateThread 创建的线程为参与线程，同一时刻只有一个
+ * 参与线程在运行，其余都在 simClock_* 中等待。运行中的线程进入等待时
+ * 把运行权交给最早到期的线程（同时到期按进入等待的顺序），
+ * 虚拟时间直接跳到该时刻，因此运行速度只受CPU限制，且调度顺序确定。
+ * 参与线程在 simClock_* 之外不能无限期阻塞在其他参与线程上
+ * （持锁等待用 simClock_Lock，PROFILED_LOCK 已经使用）
+ * */
+
+#define SIM_CLOCK_MAX_THREADS 32
+
+typedef struct {
+  bool running;           // 处于仿真模式
+  int threads;            // 参与线程数
+  unsigned long switches; // 运行权交接次数
+  unsigned long advances; // 虚拟时间前进次数
+  unsigned long lockRetries; // simClock_Lock 遇到争用后重试的次数
+  int64_t elapsedMs;      // 仿真开始以来的虚拟时间
+} simClockStats_t;
+
+/*
+ * 进入仿真模式，调用线程成为第一个参与线程。epochMs 为仿真开始时的
+ * Unix时间（毫秒），之后 simClock_RealtimeMs 从这里开始计时。
+ * simClock_Release 之后可以再次进入（之前的参与线程需已退出）
+ * */
+int simClock_Start(int64_t epochMs);
+
+/*
+ * 结束仿真：唤醒所有等待中的参与线程，之后的等待按真实时间进行，
+ * 时钟从当前虚拟时间继续走（不回退）
+ * */
+void simClock_Release(void);
+
+bool simClock_IsVirtual(void);
+
+/* 单调时钟（CLOCK_MONOTONIC 或虚拟时间） */
+int64_t simClock_NowNs(void);
+int64_t simClock_NowMs(void);
+
+/* 墙上时间（CLOCK_REALTIME 或 epochMs 加上虚拟时间） */
+int64_t simClock_RealtimeNs(void);
+int64_t simClock_RealtimeMs(void);
+
+/* 仿真开始以来的时间（未启用时为0） */
+int64_t simClock_ElapsedMs(void);
+
+/*
+ * 计算 ms 毫秒后的绝对超时时间，供 simClock_CondTimedWait 使用。
+ * 条件变量需要使用 CLOCK_MONOTONIC
+ * */
+void simClock_Deadline(struct timespec *deadline, int64_t ms);
+
+/* 睡眠指定毫秒数 */
+void simClock_SleepMs(int64_t ms);
+
+/*
+ * 替代 pthread_cond_wait/timedwait，deadline 由 simClock_Deadline 计算，
+ * NULL 表示一直等待。超时返回 ETIMEDOUT
+ * */
+int simClock_CondTimedWait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                           const struct timespec *deadline);
+
+/* 替代 pthread_cond_signal/broadcast，仿真模式下唤醒的线程按顺序排队 */
+void simClock_CondSignal(pthread_cond_t *cond);
+void simClock_CondBroadcast(pthread_cond_t *cond);
+
+/* 替代 pthread_mutex_lock：仿真模式下锁被占用时让出运行权后重试 */
+void simClock_Lock(pthread_mutex_t *mutex);
+
+/* 替代 pthread_create/pthread_join，仿真模式下新线程成为参与线程 */
+int simClock_CreateThread(pthread_t *thread, void *(*func)(void *),
+                          void *arg);
+int simClock_JoinThread(pthread_t thread);
+
+void simClock_GetStats(simClockStats_t *stats);
+
+#endif // !_SIM_CLOCK_H
@@ -0,0 +1,38 @@
+#ifndef _SIM_SENSOR_H
+#define _SIM_SENSOR_H
+
+#include <stdint.h>
+
+/*
+ * 仿真模式下代替设备状态和AP3216C的读数。指定回放文件时按文件取值，
+ * 文件中没有的列以及未指定文件时按种子生成：日周期变化加上确定的噪声，
+ * 同样的种子和时间得到同样的值
+ * */
+
+typedef enum {
+  SIM_SENSOR_CPU_TEMP = 0, // cpu_temp_c
+  SIM_SENSOR_CPU_LOAD,     // cpu_load
+  SIM_SENSOR_MEM_USAGE,    // mem_usage_percent
+  SIM_SENSOR_LIGHT_LUX,    // light_lux
+  SIM_SENSOR_PROXIMITY,    // proximity
+  SIM_SENSOR_INFRARED,     // infrared
+  SIM_SENSOR_FIELDS,
+} simSensorField_t;
+
+/*
+ * @brief 加载回放文件（CSV）：首行为列名，第一列为 t_ms（相对仿真开始的
+ *        毫秒数，递增），其余列名同上。两行之间保持前一行的值，
+ *        到文件末尾后从头循环
+ *
+ * @param replayPath: NULL 或空字符串表示不回放
+ *
+ * @return 0 成功
+ * */
+int simSensor_Init(const char *replayPath, uint32_t seed);
+
+/* 仿真开始 elapsedMs 毫秒时的读数 */
+double simSensor_Value(simSensorField_t field, int64_t elapsedMs);
+
+void simSensor_Free(void);
+
+#endif // !_SIM_SENSOR_H
@@ -0,0 +1,57 @@
+#ifndef _STATE_SNAPSHOT_H
+#define _STATE_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATE_SNAPSHOT_MAGIC 0x50414e53 // "SNAP"
+#define STATE_SNAPSHOT_VERSION 1
+#define STATE_SNAPSHOT_HEADER 16 // 魔数、版本、内容长度、CRC32
+#define STATE_SNAPSHOT_RECORD 8  // 每条记录的头：tag、保留、长度
+
+/*
+ * 运行状态快照：重启后恢复计数器、差值基线和积压的消息。文件为紧凑的
+ * 二进制格式，头部之后是若干条记录，每条为 tag（2字节）、保留（2字节）、
+ * 长度（4字节）和内容，内容补齐到8字节，本机字节序。记录的含义由调用者
+ * 定义，读取时跳过不认识的 tag。保存时写临时文件、同步后重命名，
+ * 掉电不会留下半个快照；读取时校验长度和CRC32。
+ * 缓冲由调用者提供（启动阶段分配），保存和读取都不分配内存
+ * */
+typedef struct {
+  uint8_t *buf; // 8字节对齐
+  size_t cap;
+  size_t len;              // 含头部
+  unsigned long truncated; // 空间不足而未写入的记录数
+} stateSnapshot_t;
+
+/* 开始写入新快照 */
+void stateSnapshot_Begin(stateSnapshot_t *snap, void *buf, size_t cap);
+
+/*
+ * 追加一条长度为 len 的记录，返回内容的写入位置（8字节对齐），
+ * 剩余空间不足时返回NULL，已写入的记录不受影响
+ * */
+void *stateSnapshot_Reserve(stateSnapshot_t *snap, uint16_t tag, uint32_t len);
+
+/* 追加一条记录，剩余空间不足时返回-1 */
+int stateSnapshot_Put(stateSnapshot_t *snap, uint16_t tag, const void *data,
+                      uint32_t len);
+
+/* 原子地写入文件，返回0成功 */
+int stateSnapshot_Save(stateSnapshot_t *snap, const char *path);
+
+/* 读入快照并校验，文件不存在或无效时返回-1 */
+int stateSnapshot_Load(stateSnapshot_t *snap, void *buf, size_t cap,
+                       const char *path);
+
+/*
+ * 依次读取记录，*offset 初始为0。返回0并输出 tag、内容和长度，
+ * 没有更多记录时返回-1
+ * */
+int stateSnapshot_Next(const stateSnapshot_t *snap, size_t *offset,
+                       uint16_t *tag, const void **data, uint32_t *len);
+
+/* CRC-32（IEEE 802.3，与 zlib 相同） */
+uint32_t stateSnapshot_Crc32(const void *data, size_t len);
+
+#endif // !_STATE_SNAPSHOT_H
@@ -0,0 +1,64 @@
+#ifndef _TCP_INGEST_H
+#define _TCP_INGEST_H
+
+#include <stdint.h>
+
+#include "modules/event_loop.h"
+
+#define TCP_INGEST_TYPE_MAX 31 // sensor_type 最大长度
+
+/* 对应 sentinel_config.json 中的 tcpIngestConfig */
+typedef struct {
+  char bindAddress[64]; // 监听地址（IPv4），如 "0.0.0.0"
+  int port;             // 0 表示由系统分配（测试用）
+  int maxClients;       // 同时连接的设备数
+  int ringBytes;        // 每个连接的接收环形缓冲（2的幂），也是单帧上限
+  int maxMsgsPerSec;    // 每个设备的消息速率上限，0 不限制
+} tcpIngestConfig_t;
+
+/*
+ * @brief 转发一条读数。sensorType 和 payload 直接指向接收缓冲，
+ *        不以'\0'结尾，只在回调期间有效
+ *
+ * @return 0 已转发；-1 发布通道繁忙，该帧保留，连接暂停读取后重试
+ * */
+typedef int (*tcpIngestForwardCallback_t)(const char *sensorType, int typeLen,
+                                          const char *payload, int payloadLen,
+                                          void *userData);
+
+typedef struct {
+  unsigned long accepted;
+  unsigned long rejected; // 超出连接数被拒绝
+  unsigned long closed;
+  unsigned long messages; // 已转发的读数
+  unsigned long bytes;
+  unsigned long badFrames; // 无法识别的帧（丢弃，连接保持）
+  unsigned long oversized; // 超过缓冲的帧（断开连接）
+  unsigned long throttled; // 超过速率上限而暂停的次数
+  unsigned long busy;      // 发布通道繁忙而暂停的次数
+  unsigned long copied;    // 跨越环形缓冲末尾、需要复制后解析的帧
+  int connections;
+  int paused;
+} tcpIngestStats_t;
+
+/*
+ * 在共享的事件循环上接收下游设备的TCP连接。每个连接一个环形缓冲，
+ * 帧可以是换行分隔的JSON，也可以是4字节大端长度前缀加JSON（首字节为0），
+ * 同一连接可以混用。JSON对象必须包含字符串字段 "sensor_type"，
+ * 整帧原样交给转发回调。
+ *
+ * 背压按连接进行：设备超过速率上限或发布通道繁忙时，只停止读取该连接，
+ * 数据留在内核接收缓冲中，TCP流控让该设备自己放慢，其他设备不受影响。
+ * */
+int tcpIngest_Init(const tcpIngestConfig_t *config, eventLoop_t *loop,
+                   tcpIngestForwardCallback_t callback, void *userData);
+
+/* 实际监听的端口 */
+int tcpIngest_Port(void);
+
+void tcpIngest_GetStats(tcpIngestStats_t *stats);
+
+/* 关闭所有连接和监听套接字 */
+void tcpIngest_Deinit(void);
+
+#endif // !_TCP_INGEST_H
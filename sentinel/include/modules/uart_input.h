@@ -0,0 +1,110 @@
+#ifndef _UART_INPUT_H
+#define _UART_INPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modules/event_loop.h"
+
+#define UART_MAX_PORTS 8
+#define UART_MAX_FRAMERS 8
+
+typedef enum {
+  UART_PARITY_NONE = 0,
+  UART_PARITY_EVEN,
+  UART_PARITY_ODD,
+} uartParity_t;
+
+/* 单个串口配置（对应 uartConfig.ports） */
+typedef struct {
+  char name[32];       // 端口名称，如 "pm_sensor"
+  char device[64];     // 串口设备，如 "/dev/ttymxc2"
+  int baud;            // 波特率
+  uartParity_t parity; // 校验位
+  int dataBits;        // 7 或 8
+  int stopBits;        // 1 或 2
+  char framer[16];     // 分帧方式："line"、"length"、"slip" 或注册的名称
+  char sensorType[32]; // 读数发布到 sentinel/{id}/{sensorType}
+  int maxFrame;        // 单帧上限（字节）
+  int ringBytes;       // 接收环形缓冲（2的幂）
+  int lengthBytes;     // length 分帧：长度字段字节数（1 或 2，大端）
+  int syncByte;        // length 分帧：帧起始字节，-1 表示无
+} uartPortConfig_t;
+
+/* 端口统计 */
+typedef struct {
+  bool open;
+  unsigned long bytes;
+  unsigned long frames;
+  unsigned long badFrames; // CRC错误、长度非法或转义错误
+  unsigned long overflows; // 超过 maxFrame 被丢弃的帧
+  unsigned long readErrors;
+  unsigned long reopens;
+} uartInputStats_t;
+
+/* 解码出的一帧（数据只在回调期间有效） */
+typedef struct {
+  int port; // uartInput_AddPort 返回的序号
+  const uartPortConfig_t *config;
+  const uint8_t *data;
+  int len;
+  uint64_t rxNs; // 读到帧尾字节时的单调时间
+} uartFrame_t;
+
+/* 帧回调（在事件循环线程中调用） */
+typedef void (*uartFrameCallback_t)(const uartFrame_t *frame, void *userData);
+
+/*
+ * 分帧器的逐字节状态。字节可以按任意大小的分段输入，分帧器把帧内容
+ * 累积到 frame 中，得到完整帧时调用 emit
+ * */
+typedef struct uartParser {
+  const uartPortConfig_t *config;
+  uint8_t *frame; // 容量为 config->maxFrame
+  int len;
+  int state;
+  int expected;
+  bool discarding; // 丢弃到下一个帧边界
+  uartInputStats_t *stats;
+  void (*emit)(struct uartParser *parser, const uint8_t *data, int len);
+  void *context;
+} uartParser_t;
+
+typedef struct {
+  const char *name;
+  void (*feed)(uartParser_t *parser, const uint8_t *data, int len);
+} uartFramer_t;
+
+/* 内置分帧器 */
+extern const uartFramer_t uartFramer_Line;   // '\n' 结尾，去掉 '\r'
+extern const uartFramer_t uartFramer_Length; // [同步字节] 长度 数据
+extern const uartFramer_t uartFramer_Slip;   // RFC 1055，帧尾带CRC-16
+
+/* CRC-16/CCITT-FALSE（多项式0x1021，初值0xFFFF） */
+uint16_t uartFramer_Crc16(const uint8_t *data, int len);
+
+/* 注册自定义分帧器，按名称在端口配置中引用 */
+int uartInput_RegisterFramer(const uartFramer_t *framer);
+
+const uartFramer_t *uartInput_FindFramer(const char *name);
+
+/* 初始化模块，端口和重新打开的定时器挂在事件循环上 */
+int uartInput_Init(eventLoop_t *loop, uartFrameCallback_t callback,
+                   void *userData);
+
+/*
+ * 以非阻塞方式打开串口，设置为原始模式和配置的波特率、校验位，
+ * 注册到事件循环。返回端口序号，失败返回-1。
+ * 运行中读出错（如USB串口拔出）时关闭端口，每秒尝试重新打开
+ * */
+int uartInput_AddPort(const uartPortConfig_t *config);
+
+int uartInput_PortCount(void);
+
+/* 获取端口统计，序号无效返回-1 */
+int uartInput_GetStats(int port, uartInputStats_t *stats);
+
+/* 关闭所有端口 */
+void uartInput_Deinit(void);
+
+#endif // !_UART_INPUT_H
@@ -0,0 +1,77 @@
+#ifndef _VALUE_TABLE_H
+#define _VALUE_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define VALUE_TABLE_MAGIC 0x53564C54 // "SVLT"
+#define VALUE_TABLE_VERSION 1
+#define VALUE_NAME_LEN 32
+
+/*
+ * 共享内存中的表项布局（64字节，与外部读者约定的ABI）。
+ * seq 为奇数表示写入进行中；读者在读取前后比较 seq，不一致则重读。
+ */
+typedef struct {
+  uint32_t seq;
+  uint32_t reserved;
+  char name[VALUE_NAME_LEN];
+  double value;
+  int64_t tsMs;     // 最近一次更新的Unix时间戳（毫秒）
+  uint64_t updates; // 更新次数
+} valueEntry_t;
+
+/* 共享内存头部 */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t capacity;
+  uint32_t count; // 已登记的表项数，只在启动阶段增长
+  uint32_t reserved[12];
+  valueEntry_t entries[];
+} valueTableShm_t;
+
+/* 最新值表：每个数据源写入自己的表项，读者无锁读取 */
+typedef struct {
+  valueTableShm_t *shm; // 表内存（共享内存或进程内分配）
+  size_t bytes;
+  char shmName[64];     // 为空表示不使用共享内存
+  bool readOnly;
+} valueTable_t;
+
+/* 读取到的一致快照 */
+typedef struct {
+  char name[VALUE_NAME_LEN];
+  double value;
+  int64_t tsMs;
+  uint64_t updates;
+} valueSnapshot_t;
+
+/* 创建最新值表，shmName 非空时放在 POSIX 共享内存中供其他进程只读映射 */
+int valueTable_Init(valueTable_t *table, int capacity, const char *shmName);
+
+/* 以只读方式映射其他进程创建的共享内存表（本地读者使用） */
+int valueTable_Attach(valueTable_t *table, const char *shmName);
+
+/* 登记表项（启动阶段调用），已存在时返回原索引 */
+int valueTable_Register(valueTable_t *table, const char *name);
+
+/* 按名称查找表项，找不到返回-1 */
+int valueTable_Find(const valueTable_t *table, const char *name);
+
+/* 表项数量 */
+int valueTable_Count(const valueTable_t *table);
+
+/* 写入表项，每个表项只能有一个写者 */
+void valueTable_Write(valueTable_t *table, int index, double value,
+                      int64_t tsMs);
+
+/* 无锁读取表项，写者持续写入导致无法取得一致快照时返回-1 */
+int valueTable_Read(const valueTable_t *table, int index,
+                    valueSnapshot_t *snapshot);
+
+/* 解除映射，创建者同时删除共享内存对象 */
+void valueTable_Close(valueTable_t *table);
+
+#endif // !_VALUE_TABLE_H
@@ -0,0 +1,78 @@
+#ifndef _WATCHDOG_H
+#define _WATCHDOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modules/event_loop.h"
+
+#define WATCHDOG_MAX_THREADS 16
+#define WATCHDOG_NAME_LEN 24
+
+/*
+ * 线程看门狗：各工作线程在循环中调用 watchdog_Kick 上报心跳，
+ * 事件循环上的定时器检查心跳间隔，超时的线程报告为停滞，
+ * 注册了重启回调的线程由回调重建（最多 maxRestarts 次）。
+ * 存在无法恢复的停滞线程时停止喂硬件看门狗，由硬件复位；
+ * 事件循环本身停滞时同样不再喂狗
+ * */
+
+/* 对应 sentinel_config.json 中的 watchdogConfig */
+typedef struct {
+  char device[64];     // 硬件看门狗设备（如 "/dev/watchdog"），空字符串不使用
+  int hwTimeoutSec;    // 硬件看门狗超时，0 保持驱动默认值
+  int checkIntervalMs; // 心跳检查（及喂狗）间隔
+  int maxRestarts;     // 每个线程最多重启次数，超过后视为无法恢复
+} watchdogConfig_t;
+
+/*
+ * @brief 重启停滞线程的回调（在事件循环线程中调用）。回调应启动新的
+ *        工作线程，并让停滞的旧线程恢复后自行退出
+ * */
+typedef void (*watchdogRestartCallback_t)(int id, void *userData);
+
+/* 单个线程的状态 */
+typedef struct {
+  char name[WATCHDOG_NAME_LEN];
+  int timeoutMs;
+  int64_t sinceKickMs;  // 距最近一次心跳的时间
+  int maxGapMs;         // 最长心跳间隔（空闲等待除外）
+  bool idle;            // 处于无限期等待中，不检查
+  bool stalled;
+  unsigned long stalls;
+  unsigned long restarts;
+} watchdogThreadStats_t;
+
+typedef struct {
+  bool hardware;         // 是否打开了硬件看门狗
+  bool fatal;            // 存在无法恢复的停滞线程（已停止喂狗）
+  unsigned long hwFeeds; // 喂狗次数
+  int threadCount;
+  watchdogThreadStats_t threads[WATCHDOG_MAX_THREADS];
+} watchdogStats_t;
+
+/* 打开硬件看门狗（可选）并在事件循环上启动检查定时器 */
+int watchdog_Init(const watchdogConfig_t *config, eventLoop_t *loop);
+
+/*
+ * 注册线程，返回ID；未初始化或已满时返回-1。
+ * 各模块可以无条件注册，对-1调用 watchdog_Kick/Idle 不做任何事
+ * */
+int watchdog_Register(const char *name, int timeoutMs,
+                      watchdogRestartCallback_t restart, void *userData);
+
+/* 上报心跳（无锁） */
+void watchdog_Kick(int id);
+
+/* 进入无限期等待（如等待队列非空）前调用，下次 Kick 时恢复检查 */
+void watchdog_Idle(int id);
+
+/* 按给定的单调时钟时间检查一次，由定时器调用，测试中可直接调用 */
+void watchdog_Check(int64_t nowMs);
+
+void watchdog_GetStats(watchdogStats_t *stats);
+
+/* 停止检查，并按 magic close 关闭硬件看门狗（不再复位） */
+void watchdog_Deinit(void);
+
+#endif // !_WATCHDOG_H
@@ -0,0 +1,73 @@
+#ifndef _WS_SERVER_H
+#define _WS_SERVER_H
+
+#include <stdint.h>
+
+#include "modules/event_loop.h"
+
+#define WS_SERVER_MAX_SOURCES 16
+#define WS_SERVER_SOURCE_NAME 16
+
+/* 对应 sentinel_config.json 中的 webSocketConfig */
+typedef struct {
+  char bindAddress[64]; // 监听地址（IPv4）
+  int port;             // 0 表示由系统分配（测试用）
+  int maxClients;
+  int sendBufferBytes;  // 每个客户端的发送缓冲（2的幂）
+  int queueSlots;       // 采样线程到事件循环的消息队列长度
+  int maxMessageBytes;  // 单条消息（采样载荷）的上限
+  int stallTimeoutMs;   // 发送缓冲持续写满超过该时间的客户端被断开
+  char allowedOrigins[256]; // 允许跨域握手的 Origin，逗号分隔，"*" 表示全部
+} wsServerConfig_t;
+
+typedef struct {
+  unsigned long accepted;
+  unsigned long rejected;     // 超出连接数或握手失败
+  unsigned long closed;
+  unsigned long published;    // 有订阅者时提交的消息
+  unsigned long queueDrops;   // 消息队列满而丢弃（事件循环来不及处理）
+  unsigned long oversized;    // 超过 maxMessageBytes 而丢弃
+  unsigned long frames;       // 放入客户端发送缓冲的帧
+  unsigned long frameDrops;   // 客户端发送缓冲满而丢弃的帧
+  unsigned long slowClosed;   // 持续写满被断开的客户端
+  unsigned long bytesSent;
+  uint64_t fanoutTotalUs;     // 提交到放入发送缓冲的耗时
+  uint64_t fanoutMaxUs;
+  int clients;                // 已完成握手的客户端
+  int bytesPerClient;         // 每个客户端预分配的内存
+} wsServerStats_t;
+
+/*
+ * 本地实时推送：在共享的事件循环上提供 HTTP/WebSocket 服务，不为客户端
+ * 创建线程。客户端连接 ws://<网关>:<port>/live（可带 ?sources=a,b），
+ * 发送文本消息 "subscribe a,b" / "unsubscribe a"（"*" 表示全部）修改订阅；
+ * 每条采样以文本帧
+ *   {"source":"light","t_ns":<CLOCK_MONOTONIC>,"data":<采样载荷>}
+ * 推送给订阅了该数据源的客户端。GET /sources 返回可订阅的数据源。
+ * 带 Origin 的握手（浏览器页面）只接受 allowedOrigins 中的来源，否则403。
+ *
+ * 采样线程调用 wsServer_Publish 只复制到队列，不做网络I/O；每个客户端有
+ * 独立的发送缓冲，写满时丢弃该客户端的新消息，持续写满超过
+ * stallTimeoutMs 时断开，慢客户端不影响采样和其他客户端。
+ * 所有缓冲在启动时一次性分配
+ * */
+int wsServer_Init(const wsServerConfig_t *config, eventLoop_t *loop);
+
+/* 登记数据源，返回数据源ID，只能在启动阶段调用 */
+int wsServer_RegisterSource(const char *name);
+
+/*
+ * @brief 推送一条采样（任意线程），载荷为JSON。没有客户端订阅该数据源时
+ *        只有一次原子读
+ * */
+void wsServer_Publish(int sourceId, const char *payload, int len);
+
+/* 实际监听的端口 */
+int wsServer_Port(void);
+
+void wsServer_GetStats(wsServerStats_t *stats);
+
+/* 关闭所有连接和监听套接字 */
+void wsServer_Deinit(void);
+
+#endif // !_WS_SERVER_H
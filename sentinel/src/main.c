@@ -2,18 +2,47 @@
 #include <signal.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 // 第三方库文件
 #include "cJSON/cJSON.h"
 
 // 自定义模块头文件
+#include "modules/adaptive_rate.h"
+#include "modules/broker_group.h"
+#include "modules/command_dispatch.h"
+#include "modules/command_executor.h"
 #include "modules/device_monitor.h"
+#include "modules/event_loop.h"
+#include "modules/gateway_state.h"
+#include "modules/gpio_input.h"
+#include "modules/history_store.h"
+#include "modules/iio_capture.h"
 #include "modules/light_sensor.h"
+#include "modules/local_api.h"
+#include "modules/lock_profile.h"
+#include "modules/logger.h"
+#include "modules/mem_pool.h"
+#include "modules/modbus_poller.h"
 #include "modules/mqtt_client.h"
+#include "modules/ota_update.h"
+#include "modules/payload_codec.h"
+#include "modules/perf_counters.h"
+#include "modules/pwm_led.h"
+#include "modules/rule_engine.h"
+#include "modules/sim.h"
+#include "modules/sim_clock.h"
+#include "modules/sim_sensor.h"
+#include "modules/tcp_ingest.h"
+#include "modules/uart_input.h"
+#include "modules/value_table.h"
+#include "modules/watchdog.h"
+#include "modules/ws_server.h"
 
 // MQTT客户端设置
 char *my_BrokerAddress = NULL;
@@ -24,169 +53,2972 @@ int my_reconnectDelaySec = 5;
 int my_keepAliveInterval = 60;
 int my_maxReconnectAttempts = 99;
 
-// 定义全局MQTT客户端上下文
-static mqttClientContext_t g_mqttContex;
+// 静态内存模式设置
+static memPoolConfig_t g_memConfig = {
+    .staticMode = false,
+    .budgetBytes = 256 * 1024,
+    .maxPayloadBytes = 1024,
+    .maxTopicLen = 128,
+    .commandArenaBytes = 16 * 1024,
+};
+// 命令解析arena，每个Broker一个（扇出模式下各接收线程并发解析），
+// 每条命令处理完毕后reset
+static memArena_t g_commandArenas[BROKER_GROUP_MAX];
+
+// 上行载荷压缩设置
+static payloadCodecConfig_t g_codecConfig = {
+    .enabled = false,
+    .minBytes = 32,
+    .maxPayloadBytes = 1024,
+};
+static payloadCodec_t g_payloadCodec;
+
+// 事件循环：驱动定时器和各类文件描述符事件
+#define EVENT_LOOP_MAX_FDS 64
+static eventLoop_t g_eventLoop;
+
+// PWM LED 设置
+static pwmLedConfig_t g_pwmConfig = {
+    .sysfsRoot = PWM_SYSFS_ROOT,
+    .tickUs = 5000,
+};
+
+// GPIO输入线设置，每条线对应规则引擎字段 "gpio.{name}"
+static gpioLineConfig_t g_gpioLines[GPIO_MAX_LINES];
+static int g_gpioLineCount = 0;
+static int g_gpioFieldIds[GPIO_MAX_LINES];
+
+// 自适应采样：信号变化快时提高状态和光照的采样率，平稳时降低；
+// 网关进程CPU占用超过预算时所有数据源按比例降低。未启用时固定1Hz
+static bool g_adaptiveEnabled = false;
+static adaptiveBudget_t g_rateBudget;
+static adaptiveRateConfig_t g_statusRateConfig = {
+    .minHz = 0.2,
+    .maxHz = 2,
+    .window = 8,
+    .changeThreshold = 10, // cpu_load 百分点/秒
+    .stdThreshold = 5,
+    .decay = 0.9,
+};
+static adaptiveRateConfig_t g_lightRateConfig = {
+    .minHz = 0.2,
+    .maxHz = 5,
+    .window = 8,
+    .changeThreshold = 50, // lux/秒
+    .stdThreshold = 20,
+    .decay = 0.8,
+};
+static adaptiveRate_t g_statusRate;
+static adaptiveRate_t g_lightRate;
+
+// 线程看门狗：采样线程停滞时重建线程，旧线程恢复后发现代数变化自行退出
+static bool g_watchdogEnabled = false;
+static watchdogConfig_t g_watchdogConfig = {
+    .device = "/dev/watchdog",
+    .hwTimeoutSec = 30,
+    .checkIntervalMs = 1000,
+    .maxRestarts = 3,
+};
+static int g_threadTimeoutMs = 10000;
+
+// 异步日志：同一位置的重复消息合并，10秒内最多输出10条
+static char g_logFile[128] = "";
+static loggerConfig_t g_loggerConfig = {
+    .level = LOG_LEVEL_INFO,
+    .file = g_logFile,
+    .maxBytes = 1024 * 1024,
+    .maxFiles = 3,
+    .maxThreads = 16,
+    .ringSlots = 64,
+    .flushIntervalMs = 200,
+    .rateLimit = 10,
+    .rateWindowMs = 10000,
+    .summaryIntervalMs = 60000,
+};
+
+// 仿真模式：虚拟时钟加仿真Broker，传感器读数按种子生成或回放，
+// 运行 durationSec 后写出报告并退出。外设、本地接口和接入模块不启用
+static simConfig_t g_simConfig = {
+    .durationMs = 86400000,
+    .epochMs = 1704067200000LL, // 2024-01-01T00:00:00Z
+    .reportIntervalMs = 86400000,
+    .reportPath = "sim_report.json",
+    .broker = {.seed = 1, .latencyMs = 20, .jitterMs = 10},
+};
+
+// 采样线程生成的消息数和因未连接而跳过发布的次数（仿真报告使用）
+static unsigned long g_samplesProduced = 0;
+static unsigned long g_samplesOffline = 0;
+
+// 性能计数器：metricsIntervalSec 大于0时定期发布到 sentinel/{id}/metrics
+static int g_perfMetricsIntervalSec = 0;
+static char *g_perfMetricsTopic = NULL;
+
+// 命令执行器：statsIntervalSec 大于0时定期发布排队/执行耗时直方图
+static commandExecutorConfig_t g_commandConfig = {
+    .workers = 2,
+    .queueDepth = 16,
+    .defaultTimeoutMs = 30000,
+};
+static int g_commandStatsIntervalSec = 0;
+static int g_statusWatchdogId = -1;
+static int g_lightWatchdogId = -1;
+static int g_statusGeneration = 0;
+static int g_lightGeneration = 0;
+
+// 光照采样线程唤醒条件：AP3216C中断线触发时立即采样，否则按采样间隔
+static pthread_mutex_t g_lightWakeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_lightWakeCond;
+static bool g_lightWakePending = false;
+
+// 本地规则引擎及采样字段ID
+static ruleEngine_t g_ruleEngine;
+enum {
+  FIELD_CPU_TEMP = 0,
+  FIELD_CPU_LOAD,
+  FIELD_MEM_USAGE,
+  FIELD_LIGHT_LUX,
+  FIELD_INFRARED,
+  FIELD_PROXIMITY,
+  FIELD_COUNT,
+};
+static const char *g_fieldNames[FIELD_COUNT] = {
+    "status.cpu_temp_c", "status.cpu_load",   "status.mem_usage_percent",
+    "light.light_lux",   "light.infrared_cd", "light.proximity",
+};
+static int g_fieldIds[FIELD_COUNT];
+
+// 本地历史存储：每个发布的字段一个序列
+#define HISTORY_MAX_POINTS 60
+static historyStoreConfig_t g_historyConfig = {
+    .path = "/var/lib/sentinel/history.db",
+    .blockBytes = 4096,
+    .blockCount = 2048,
+};
+static bool g_historyEnabled = false;
+static historyStore_t g_historyStore;
+static int g_historyIds[FIELD_COUNT];
+static int g_gpioHistoryIds[GPIO_MAX_LINES];
+
+// 最新值表：各数据源写入，本地进程通过Unix域套接字或共享内存读取
+#define VALUE_TABLE_CAPACITY (FIELD_COUNT + GPIO_MAX_LINES + 1)
+static valueTable_t g_valueTable;
+static int g_valueIds[FIELD_COUNT];
+static int g_gpioValueIds[GPIO_MAX_LINES];
+static int g_connectedValueId = -1;
+static bool g_localApiEnabled = false;
+static char g_valueShmName[64] = "";
+static localApiConfig_t g_localApiConfig = {
+    .socketPath = LOCAL_API_SOCKET_PATH,
+    .maxClients = 4,
+};
+
+// OTA固件下载：分片在 app/{id}/ota 上接收，进度作为 start 命令的响应上报
+static bool g_otaEnabled = false;
+static otaConfig_t g_otaConfig = {
+    .target = "/var/lib/sentinel/ota/firmware.img",
+    .stateFile = "/var/lib/sentinel/ota/state.bin",
+    .bufferBytes = 65536,
+    .maxChunkBytes = 4096,
+    .progressStepPercent = 5,
+};
+static otaUpdate_t g_ota;
+static char *g_otaTopic = NULL;
+// 最近一次 start 命令：start 在执行器线程上执行，进度在接收线程上回复
+static sentinelCommand_t g_otaCommand;
+static pthread_mutex_t g_otaCommandLock = PTHREAD_MUTEX_INITIALIZER;
+
+// TCP接入：下游设备的读数转发到 sentinel/{id}/{sensor_type}
+static bool g_tcpIngestEnabled = false;
+static tcpIngestConfig_t g_tcpIngestConfig = {
+    .bindAddress = "0.0.0.0",
+    .port = 9000,
+    .maxClients = 64,
+    .ringBytes = 1024,
+    .maxMsgsPerSec = 20,
+};
+
+// 本地实时推送：采样同时推送给订阅的WebSocket客户端（本地仪表盘）
+static bool g_wsEnabled = false;
+static wsServerConfig_t g_wsConfig = {
+    .bindAddress = "127.0.0.1",
+    .port = 8080,
+    .maxClients = 8,
+    .sendBufferBytes = 4096,
+    .queueSlots = 16,
+    .maxMessageBytes = 1024,
+    .stallTimeoutMs = 5000,
+};
+
+// 运行状态快照：定期和退出时保存计数器、CPU负载基线和发送队列中积压的
+// 消息，重启后在连接Broker之前恢复
+static gatewayStateConfig_t g_snapshotConfig = {
+    .path = "/var/lib/sentinel/state.snap",
+    .intervalSec = 60,
+    .maxBytes = 16384,
+};
+
+// Modbus TCP轮询：每轮的测点值发布到 sentinel/{id}/modbus
+#define MODBUS_MAX_DEVICES 16
+static bool g_modbusEnabled = false;
+static modbusPollerConfig_t g_modbusConfig = {
+    .maxGap = 8,
+    .maxRegs = MODBUS_MAX_REGS,
+    .maxInFlight = 4,
+    .timeoutMs = 1000,
+};
+static modbusDeviceConfig_t g_modbusDevices[MODBUS_MAX_DEVICES];
+static int g_modbusDeviceCount = 0;
+static char *g_modbusTopic = NULL;
+
+// 串口接入：每个端口的帧发布到 sentinel/{id}/{sensorType}
+static bool g_uartEnabled = false;
+static uartPortConfig_t g_uartPorts[UART_MAX_PORTS];
+static int g_uartPortCount = 0;
+static char *g_uartTopics[UART_MAX_PORTS]; // 按 uartInput_AddPort 的序号
+
+// IIO触发缓冲采集：启用后光照数据来自同一时刻采集的多通道扫描
+static iioCaptureConfig_t g_iioConfig = {
+    .sysfsRoot = IIO_SYSFS_ROOT,
+    .devRoot = IIO_DEV_ROOT,
+    .bufferLength = 64,
+    .watermark = 1,
+    .timestamp = true,
+};
+static bool g_iioEnabled = false;
+static int g_iioFieldSlots[IIO_MAX_CHANNELS]; // 通道对应的FIELD_*，-1 表示未映射
+static pthread_mutex_t g_iioLock = PTHREAD_MUTEX_INITIALIZER;
+static iioSample_t g_iioLatest; // 最近一次扫描，由光照线程按采样间隔发布
+static bool g_iioValid = false;
+
+// 启动时构建一次的Topic字符串
+static char *g_deviceStatusTopic = NULL;
+static char *g_lightSensorTopic = NULL;
+static char *g_responseTopic = NULL;
+static char *g_gpioTopic = NULL;
+
+// buildDeviceTopic 构建的全部Topic，TCP接入的下游设备不能占用
+#define DEVICE_TOPIC_MAX 32
+static const char *g_deviceTopics[DEVICE_TOPIC_MAX];
+static int g_deviceTopicCount = 0;
+
+// 定义全局MQTT客户端（多Broker组，只配置一个Broker时即单连接）
+static brokerGroup_t g_brokerGroup;
+static brokerGroupConfig_t g_brokerConfig = {
+    .mode = BROKER_MODE_FAILOVER,
+    .probeIntervalMs = 1000,
+    .probeTimeoutMs = 500,
+    .probeFailThreshold = 2,
+    .switchTimeoutMs = 5000,
+    .queueDepth = 16,
+};
 static mqttClientConfig_t g_mqttConfig;
+#define RESPONSE_PAYLOAD_MAX 2048
+
+// 发送数据源：上行带宽受限时命令响应先于告警、状态和遥测发出，
+// 同一优先级内按权重分配，只关心最新值的数据源合并积压的消息；
+// 采样类数据源同时推送到本地实时流
+typedef enum {
+  SOURCE_RESPONSE = 0,
+  SOURCE_GPIO,
+  SOURCE_STATUS,
+  SOURCE_LIGHT,
+  SOURCE_INGEST,
+  SOURCE_MODBUS,
+  SOURCE_UART,
+  SOURCE_METRICS,
+  SOURCE_COUNT,
+} outboundSource_t;
+static struct {
+  const char *name;
+  brokerClass_t cls;
+  int weight;
+  bool coalesce;
+  bool live;
+} g_sources[SOURCE_COUNT] = {
+    {"response", BROKER_CLASS_CONTROL, 1, false, false},
+    {"gpio", BROKER_CLASS_ALARM, 1, false, true},
+    {"status", BROKER_CLASS_STATUS, 1, true, true},
+    {"light", BROKER_CLASS_BULK, 1, true, true},
+    {"ingest", BROKER_CLASS_BULK, 2, false, true},
+    {"modbus", BROKER_CLASS_BULK, 2, true, true},
+    {"uart", BROKER_CLASS_BULK, 1, false, true},
+    {"metrics", BROKER_CLASS_BULK, 1, true, false},
+};
+static int g_sourceIds[SOURCE_COUNT]; // 注册前为默认数据源
+static int g_liveIds[SOURCE_COUNT];   // 实时流的数据源，-1 表示不推送
+
+// MQTT 5 发布属性：设备消息可设置过期时间。内容类型每条约占19字节，
+// 与Topic别名节省的字节相当，因此JSON作为默认格式不标注，只标注压缩帧
+static mqttPublishOptions_t g_jsonPublishOptions;
+static mqttPublishOptions_t g_packedPublishOptions = {
+    .contentType = "application/x-sentinel-packed",
+    .userPropertyCount = 1,
+    .userProperties = {{"dict", "1"}}, // 与 PAYLOAD_CODEC_DICT_ID 一致
+};
 bool g_exitFlag = false; // 全局退出标志，所有线程共享
 
-// 定义线程ID变量
-pthread_t deviceStatusThreadID;
-pthread_t lightSensorThreadID;
+// 定义线程ID变量
+pthread_t deviceStatusThreadID;
+pthread_t lightSensorThreadID;
+
+static int publishDeviceMessage(outboundSource_t source, const char *topic,
+                                const char *payload, int payloadLen, int qos,
+                                bool retained);
+
+/* 回调函数 */
+/*
+ * @brief  在 sentinel/{id}/response 上回复命令结果（命令执行器的完成回调，
+ *         在工作线程上调用）
+ * */
+static void commandDoneHandle(const sentinelCommand_t *cmd,
+                              const sentinelCommandResult_t *result,
+                              void *userData) {
+  char responsePayload[RESPONSE_PAYLOAD_MAX];
+  int len = commandDispatch_FormatResponse(cmd, result, responsePayload,
+                                           sizeof(responsePayload));
+  if (publishDeviceMessage(SOURCE_RESPONSE, g_responseTopic, responsePayload,
+                           len, 1, false) != 0 &&
+      cmd->source == COMMAND_SOURCE_REMOTE) {
+    LOGGER_ERROR("Failed to publish command response.");
+  }
+}
+
+/* 在调用线程上执行命令并回复结果 */
+static void executeAndRespond(const sentinelCommand_t *cmd) {
+  sentinelCommandResult_t result;
+  commandDispatch_Execute(cmd, &result);
+  commandDoneHandle(cmd, &result, NULL);
+}
+
+/*
+ * @brief  直接在接收线程上执行的命令：commands 的 cancel 不能排在它要取消
+ *         的命令后面，ota 的 status 只读取进度。ota 的 start、abort 和
+ *         apply（执行 applyCommand，可能耗时数秒）交给执行器，同一 target
+ *         的命令仍按到达顺序执行
+ * */
+static bool isInlineCommand(const sentinelCommand_t *cmd) {
+  if (strcmp(cmd->target, "ota") == 0) {
+    return strcmp(cmd->action, "status") == 0;
+  }
+  return strcmp(cmd->target, "commands") == 0;
+}
+
+/* 提交到命令执行器，队列满时直接回复失败 */
+static void submitCommand(const sentinelCommand_t *cmd) {
+  if (commandExecutor_Submit(cmd) == 0) {
+    return;
+  }
+  sentinelCommandResult_t result = {.errorCode = COMMAND_ERR_BUSY};
+  snprintf(result.message, sizeof(result.message), "Command queue full");
+  LOGGER_WARN("Command queue full, rejected %s/%s.", cmd->target, cmd->action);
+  commandDoneHandle(cmd, &result, NULL);
+}
+
+void mqttCommandHandle(const char *topic, const char *payload, int payloadLen,
+                       void *userData) {
+  sentinelCommand_t cmd;
+
+  // OTA分片是二进制载荷，不按命令解析
+  if (g_otaTopic && strcmp(topic, g_otaTopic) == 0) {
+    otaUpdate_WriteChunk(&g_ota, payload, payloadLen);
+    return;
+  }
+  gatewayState_WaitReady();
+
+  // 命令JSON树分配在本Broker的arena中，处理完毕后整体reset，不触发malloc
+  memArena_t *arena = (memArena_t *)userData;
+  memArena_BindCJSON(arena);
+  int rc = commandDispatch_Parse(payload, payloadLen, &cmd);
+  memArena_BindCJSON(NULL);
+  memArena_Reset(arena);
+
+  if (rc != 0) {
+    sentinelCommandResult_t result = {.errorCode = COMMAND_ERR_PARSE};
+    snprintf(result.message, sizeof(result.message), "Invalid command payload");
+    commandDoneHandle(&cmd, &result, NULL);
+    return;
+  }
+
+  // 接收线程只排队，耗时的处理函数不会阻塞paho的收发和keep-alive
+  if (isInlineCommand(&cmd)) {
+    executeAndRespond(&cmd);
+  } else {
+    submitCommand(&cmd);
+  }
+}
+
+/* 本地规则触发的动作，与远程命令走同一分发路径 */
+static void ruleActionHandle(const char *ruleName, const sentinelCommand_t *cmd,
+                             void *userData) {
+  LOGGER_INFO("Rule '%s' fired: %s/%s", ruleName, cmd->target, cmd->action);
+  submitCommand(cmd);
+}
+
+/* 规则引擎自身的命令：get_stats 返回评估开销 */
+static int ruleEngineCommandHandle(const sentinelCommand_t *cmd,
+                                   sentinelCommandResult_t *result,
+                                   void *userData) {
+  if (strcmp(cmd->action, "get_stats") != 0) {
+    return COMMAND_ERR_UNKNOWN_ACTION;
+  }
+
+  ruleEngineStats_t stats;
+  ruleEngine_GetStats(&g_ruleEngine, &stats);
+  snprintf(result->resultData, sizeof(result->resultData),
+           "{\"rules\":%d,\"samples\":%lu,\"avg_eval_ns\":%llu,"
+           "\"max_eval_ns\":%llu}",
+           stats.ruleCount, stats.samples,
+           stats.samples ? stats.totalNs / stats.samples : 0, stats.maxNs);
+  return COMMAND_OK;
+}
+
+/* 耗时直方图：各桶的计数，桶的上界见 bucket_ms */
+static int formatHistogram(const unsigned long *hist, char *out, int size) {
+  int len = snprintf(out, size, "[");
+  for (int i = 0; i < COMMAND_HIST_BUCKETS && len < size; i++) {
+    len += snprintf(out + len, size - len, "%s%lu", i ? "," : "", hist[i]);
+  }
+  if (len < size) {
+    len += snprintf(out + len, size - len, "]");
+  }
+  return len;
+}
+
+/*
+ * @brief  命令执行器的计数、排队耗时（接收到开始执行）和执行耗时的直方图，
+ *         第 i 个桶为小于 bucket_ms[i] 毫秒，最后一个桶不设上界
+ * */
+static int formatCommandStats(char *out, int size) {
+  commandExecutorStats_t stats;
+  commandExecutor_GetStats(&stats);
+  unsigned long started = stats.executed + stats.running;
+
+  char bucketMs[128];
+  int n = snprintf(bucketMs, sizeof(bucketMs), "[");
+  for (int i = 0; i < COMMAND_HIST_BUCKETS - 1; i++) {
+    n += snprintf(bucketMs + n, sizeof(bucketMs) - n, "%s%d", i ? "," : "",
+                  commandExecutor_BucketLimitMs(i));
+  }
+  snprintf(bucketMs + n, sizeof(bucketMs) - n, "]");
+  char queueHist[COMMAND_HIST_BUCKETS * 11 + 4];
+  char execHist[COMMAND_HIST_BUCKETS * 11 + 4];
+  formatHistogram(stats.queueHist, queueHist, sizeof(queueHist));
+  formatHistogram(stats.execHist, execHist, sizeof(execHist));
+
+  return snprintf(
+      out, size,
+      "{\"commands\":{\"workers\":%d,\"queued\":%d,\"running\":%d,"
+      "\"max_queued\":%d,\"submitted\":%lu,\"executed\":%lu,"
+      "\"rejected\":%lu,\"expired\":%lu,\"cancelled\":%lu,\"late\":%lu,"
+      "\"queue_avg_us\":%llu,\"queue_max_us\":%llu,\"exec_avg_us\":%llu,"
+      "\"exec_max_us\":%llu,\"bucket_ms\":%s,\"queue_hist\":%s,"
+      "\"exec_hist\":%s}}",
+      stats.workers, stats.queued, stats.running, stats.maxQueued,
+      stats.submitted, stats.executed, stats.rejected, stats.expired,
+      stats.cancelled, stats.late,
+      (unsigned long long)(started ? stats.queueTotalUs / started : 0),
+      (unsigned long long)stats.queueMaxUs,
+      (unsigned long long)(stats.executed ? stats.execTotalUs / stats.executed
+                                          : 0),
+      (unsigned long long)stats.execMaxUs, bucketMs, queueHist, execHist);
+}
+
+/*
+ * @brief  命令执行器的命令（target "commands"，在接收线程上执行）：
+ *         cancel 取消 value 指定 command_id 的命令，排队中的不再执行，
+ *         执行中的由处理函数自行提前结束；get_stats 返回计数和耗时直方图
+ * */
+static int commandsCommandHandle(const sentinelCommand_t *cmd,
+                                 sentinelCommandResult_t *result,
+                                 void *userData) {
+  if (strcmp(cmd->action, "cancel") == 0) {
+    static const char *states[] = {"not_found", "cancelled", "signalled"};
+    int rc = commandExecutor_Cancel(cmd->valueStr);
+    snprintf(result->resultData, sizeof(result->resultData),
+             "{\"state\":\"%s\"}", states[rc]);
+    if (rc == 0) {
+      snprintf(result->message, sizeof(result->message),
+               "No queued or running command '%.64s'", cmd->valueStr);
+      return COMMAND_ERR_INVALID_VALUE;
+    }
+    return COMMAND_OK;
+  }
+  if (strcmp(cmd->action, "get_stats") == 0) {
+    formatCommandStats(result->resultData, sizeof(result->resultData));
+    return COMMAND_OK;
+  }
+  return COMMAND_ERR_UNKNOWN_ACTION;
+}
+
+/*
+ * @brief  各优先级的排队、丢弃、合并和延迟（多个发送队列时计数求和，
+ *         延迟取最大值），以及各数据源的发送情况
+ * */
+static void formatOutboundStats(const brokerGroupStats_t *stats, char *out,
+                                int size) {
+  // 预留结尾 "],\"truncated\":false}" 的空间
+  int room = size - 32;
+  bool truncated = false;
+  char entry[320];
+  int len = snprintf(out, room, "{\"classes\":[");
+  for (int k = 0; k < BROKER_CLASS_COUNT; k++) {
+    brokerClassStats_t sum = {0};
+    for (int i = 0; i < stats->outboxCount; i++) {
+      const brokerClassStats_t *c = &stats->outboxes[i].classes[k];
+      sum.queued += c->queued;
+      sum.enqueued += c->enqueued;
+      sum.sent += c->sent;
+      sum.dropped += c->dropped;
+      sum.coalesced += c->coalesced;
+      sum.expired += c->expired;
+      sum.failed += c->failed;
+      sum.highWater = c->highWater > sum.highWater ? c->highWater
+                                                   : sum.highWater;
+      sum.latencyAvgUs = c->latencyAvgUs > sum.latencyAvgUs ? c->latencyAvgUs
+                                                            : sum.latencyAvgUs;
+      sum.latencyP99Us = c->latencyP99Us > sum.latencyP99Us ? c->latencyP99Us
+                                                            : sum.latencyP99Us;
+      sum.latencyMaxUs = c->latencyMaxUs > sum.latencyMaxUs ? c->latencyMaxUs
+                                                            : sum.latencyMaxUs;
+    }
+    len += snprintf(out + len, room - len,
+                    "%s{\"class\":\"%s\",\"queued\":%d,\"high_water\":%d,"
+                    "\"enqueued\":%lu,\"sent\":%lu,\"dropped\":%lu,"
+                    "\"coalesced\":%lu,\"expired\":%lu,\"failed\":%lu,"
+                    "\"avg_us\":%u,\"p99_us\":%u,\"max_us\":%u}",
+                    k ? "," : "", brokerGroup_ClassName((brokerClass_t)k),
+                    sum.queued, sum.highWater, sum.enqueued, sum.sent,
+                    sum.dropped, sum.coalesced, sum.expired, sum.failed,
+                    sum.latencyAvgUs, sum.latencyP99Us, sum.latencyMaxUs);
+  }
+  len += snprintf(out + len, room - len, "],\"sources\":[");
+  for (int i = 0; i < stats->sourceCount && len < room; i++) {
+    int n = snprintf(entry, sizeof(entry),
+                     "%s{\"name\":\"%s\",\"weight\":%d,\"sent\":%lu,"
+                     "\"dropped\":%lu,\"coalesced\":%lu}",
+                     i ? "," : "", stats->sources[i].name,
+                     stats->sources[i].weight, stats->sources[i].sent,
+                     stats->sources[i].dropped, stats->sources[i].coalesced);
+    if (len + n >= room) {
+      truncated = true;
+      break;
+    }
+    memcpy(out + len, entry, n + 1);
+    len += n;
+  }
+  if (len >= room) {
+    // 优先级部分已经超出，只保留合法的JSON
+    len = snprintf(out, room, "{\"sources\":[");
+    truncated = true;
+  }
+  snprintf(out + len, size - len, "],\"truncated\":%s}",
+           truncated ? "true" : "false");
+}
+
+/*
+ * @brief  MQTT连接命令：get_stats 返回每个Broker的连接耗时（含TLS握手）、
+ *         PSK握手次数、健康状态和发送队列情况；get_outbound 返回各优先级的
+ *         排队延迟、丢弃和合并数，以及各数据源的发送情况
+ * */
+static int mqttStatsCommandHandle(const sentinelCommand_t *cmd,
+                                  sentinelCommandResult_t *result,
+                                  void *userData) {
+  if (strcmp(cmd->action, "get_outbound") == 0) {
+    brokerGroupStats_t stats;
+    brokerGroup_GetStats(&g_brokerGroup, &stats);
+    formatOutboundStats(&stats, result->resultData,
+                        sizeof(result->resultData));
+    return COMMAND_OK;
+  }
+  if (strcmp(cmd->action, "get_stats") != 0) {
+    return COMMAND_ERR_UNKNOWN_ACTION;
+  }
+
+  brokerGroupStats_t stats;
+  brokerGroup_GetStats(&g_brokerGroup, &stats);
+  char *out = result->resultData;
+  // 预留结尾 "],\"truncated\":false}" 的空间
+  int room = (int)sizeof(result->resultData) - 32;
+  bool truncated = false;
+  char entry[512];
+  int len = snprintf(out, room,
+                     "{\"mode\":\"%s\",\"active\":%d,\"failovers\":%lu,"
+                     "\"last_failover_ms\":%d,\"queues\":[",
+                     g_brokerConfig.mode == BROKER_MODE_FANOUT ? "fanout"
+                                                               : "failover",
+                     stats.active, stats.failovers, stats.lastFailoverMs);
+  for (int i = 0; i < stats.outboxCount; i++) {
+    len += snprintf(out + len, room - len,
+                    "%s{\"queued\":%d,\"high_water\":%d,\"dropped\":%lu,"
+                    "\"expired\":%lu,\"failed\":%lu}",
+                    i ? "," : "", stats.outboxes[i].queued,
+                    stats.outboxes[i].highWater, stats.outboxes[i].dropped,
+                    stats.outboxes[i].expired, stats.outboxes[i].failed);
+  }
+  len += snprintf(out + len, room - len, "],\"brokers\":[");
+
+  for (int i = 0; i < stats.brokerCount; i++) {
+    const mqttConnectStats_t *c = &stats.brokers[i].connect;
+    const mqttPublishStats_t *p = &stats.brokers[i].publish;
+    unsigned long fullConnects = c->connects - c->pskConnects;
+    int n = snprintf(
+        entry, sizeof(entry),
+        "%s{\"address\":\"%s\",\"connected\":%s,\"healthy\":%s,"
+        "\"probe_rtt_us\":%d,\"sent\":%lu,\"attempts\":%lu,\"failures\":%lu,"
+        "\"last_connect_ms\":%d,\"max_connect_ms\":%d,"
+        "\"avg_full_connect_ms\":%lu,\"psk_connects\":%lu,"
+        "\"avg_psk_connect_ms\":%lu,\"bytes_per_msg\":%lu,"
+        "\"alias_hits\":%lu,\"alias_saved_bytes\":%lu,\"rejected\":%lu,"
+        "\"last_reason\":%d,\"last_disconnect_reason\":%d}",
+        i ? "," : "", stats.brokers[i].address,
+        stats.brokers[i].connected ? "true" : "false",
+        stats.brokers[i].healthy ? "true" : "false",
+        stats.brokers[i].probeRttUs, stats.brokers[i].sent, c->attempts,
+        c->failures, c->lastMs, c->maxMs,
+        fullConnects ? (c->totalMs - c->pskTotalMs) / fullConnects : 0,
+        c->pskConnects, c->pskConnects ? c->pskTotalMs / c->pskConnects : 0,
+        p->messages ? p->bytes / p->messages : 0, p->aliasHits,
+        p->aliasSavedBytes, p->rejected, p->lastReasonCode,
+        c->lastDisconnectReason);
+    if (n >= (int)sizeof(entry) || len + n >= room) {
+      truncated = true;
+      break;
+    }
+    memcpy(out + len, entry, n + 1);
+    len += n;
+  }
+  snprintf(out + len, sizeof(result->resultData) - len,
+           "],\"truncated\":%s}", truncated ? "true" : "false");
+  return COMMAND_OK;
+}
+
+/*
+ * @brief  输出各采样阶段的平均墙上时间和平均计数（不可用的事件为 null），
+ *         用于 get_perf 命令和 metrics 发布
+ *
+ * @return 写入的长度
+ * */
+static int formatPerfStages(char *out, int size) {
+  perfCountersStatus_t status;
+  perfCounters_GetStatus(&status);
+  perfStageStats_t stages[12];
+  int count = perfCounters_GetStages(stages, 12);
+
+  // 预留结尾 "],\"truncated\":false}" 的空间
+  int room = size - 32;
+  bool truncated = false;
+  char entry[384];
+  int len = snprintf(out, room,
+                     "{\"enabled\":%s,\"paranoid\":%d,\"open_error\":\"%s\","
+                     "\"stages\":[",
+                     perfCounters_IsEnabled() ? "true" : "false",
+                     status.paranoid,
+                     status.openErrno ? strerror(status.openErrno) : "");
+  for (int i = 0; i < count; i++) {
+    const perfStageStats_t *s = &stages[i];
+    int n = snprintf(entry, sizeof(entry),
+                     "%s{\"name\":\"%s\",\"samples\":%lu,\"avg_ns\":%llu,"
+                     "\"max_ns\":%llu",
+                     i ? "," : "", s->name, s->samples,
+                     (unsigned long long)(s->wallNs / s->samples),
+                     (unsigned long long)s->maxWallNs);
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+      if (s->counted[e] == 0) {
+        n += snprintf(entry + n, sizeof(entry) - n, ",\"%s\":null",
+                      perfCounters_EventName((perfEvent_t)e));
+      } else {
+        n += snprintf(entry + n, sizeof(entry) - n, ",\"%s\":%.1f",
+                      perfCounters_EventName((perfEvent_t)e),
+                      (double)s->counts[e] / s->counted[e]);
+      }
+    }
+    n += snprintf(entry + n, sizeof(entry) - n, "}");
+    if (n >= (int)sizeof(entry) || len + n >= room) {
+      truncated = true;
+      break;
+    }
+    memcpy(out + len, entry, n + 1);
+    len += n;
+  }
+  return len + snprintf(out + len, size - len, "],\"truncated\":%s}",
+                        truncated ? "true" : "false");
+}
+
+/* 第一条消息发布完成距进程启动的时间（毫秒），尚未发布时为-1 */
+static double firstPublishMs(void) {
+  brokerGroupStats_t stats;
+  brokerGroup_GetStats(&g_brokerGroup, &stats);
+  if (stats.firstSentUs == 0) {
+    return -1;
+  }
+  return (stats.firstSentUs - gatewayState_StartNs() / 1000) / 1000.0;
+}
+
+/*
+ * @brief  运行时诊断命令（target "diagnostics"）：
+ *         get_threads 返回看门狗监视的线程心跳，get_locks 返回持有时间
+ *         最长的加锁位置，lock_profile 开关锁争用统计（value 为 1 开启，
+ *         0 关闭；参数 reset 为 1 时清零已有统计），perf_profile 同样开关
+ *         采样阶段的性能计数器，get_perf 返回各阶段的平均计数，
+ *         log_level 修改日志级别（valueStr 为级别名称或 value 为数值），
+ *         get_log 返回日志统计，get_startup 返回启动各阶段耗时、
+ *         第一条消息的发布时间和快照情况
+ * */
+static int diagnosticsCommandHandle(const sentinelCommand_t *cmd,
+                                    sentinelCommandResult_t *result,
+                                    void *userData) {
+  char *out = result->resultData;
+  // 预留结尾 "],\"truncated\":false}" 的空间
+  int room = (int)sizeof(result->resultData) - 32;
+  bool truncated = false;
+  char entry[256];
+  int len = 0;
+
+  if (strcmp(cmd->action, "lock_profile") == 0) {
+    if (!cmd->hasValue) {
+      return COMMAND_ERR_INVALID_VALUE;
+    }
+    if (commandDispatch_GetParam(cmd, "reset", 0) != 0) {
+      lockProfile_Reset();
+    }
+    lockProfile_SetEnabled(cmd->value != 0);
+    snprintf(out, sizeof(result->resultData), "{\"enabled\":%s}",
+             lockProfile_IsEnabled() ? "true" : "false");
+    return COMMAND_OK;
+  }
+
+  if (strcmp(cmd->action, "perf_profile") == 0) {
+    if (!cmd->hasValue) {
+      return COMMAND_ERR_INVALID_VALUE;
+    }
+    if (commandDispatch_GetParam(cmd, "reset", 0) != 0) {
+      perfCounters_Reset();
+    }
+    perfCounters_SetEnabled(cmd->value != 0);
+    snprintf(out, sizeof(result->resultData), "{\"enabled\":%s}",
+             perfCounters_IsEnabled() ? "true" : "false");
+    return COMMAND_OK;
+  }
+  if (strcmp(cmd->action, "get_perf") == 0) {
+    formatPerfStages(out, sizeof(result->resultData));
+    return COMMAND_OK;
+  }
+
+  if (strcmp(cmd->action, "log_level") == 0) {
+    int level = cmd->hasValue ? (int)cmd->value
+                              : logger_ParseLevel(cmd->valueStr);
+    if (level < LOG_LEVEL_ERROR || level > LOG_LEVEL_DEBUG) {
+      return COMMAND_ERR_INVALID_VALUE;
+    }
+    logger_SetLevel(level);
+    snprintf(out, sizeof(result->resultData), "{\"level\":\"%s\"}",
+             logger_LevelName(level));
+    return COMMAND_OK;
+  }
+  if (strcmp(cmd->action, "get_log") == 0) {
+    loggerStats_t stats;
+    logger_GetStats(&stats);
+    snprintf(out, sizeof(result->resultData),
+             "{\"level\":\"%s\",\"lines\":%lu,\"bytes\":%lu,"
+             "\"writes\":%lu,\"dropped\":%lu,\"repeats\":%lu,"
+             "\"limited\":%lu,\"direct\":%lu,\"rotations\":%lu,"
+             "\"write_errors\":%lu,\"threads\":%d}",
+             logger_LevelName(stats.level), stats.lines, stats.bytes,
+             stats.writes, stats.dropped, stats.repeats, stats.limited,
+             stats.direct, stats.rotations, stats.writeErrors, stats.threads);
+    return COMMAND_OK;
+  }
+
+  if (strcmp(cmd->action, "get_startup") == 0) {
+    gatewayState_FormatStartup(out, sizeof(result->resultData),
+                               firstPublishMs());
+    return COMMAND_OK;
+  }
+
+  if (strcmp(cmd->action, "get_threads") == 0) {
+    watchdogStats_t stats;
+    watchdog_GetStats(&stats);
+    len = snprintf(out, room,
+                   "{\"enabled\":%s,\"hardware\":%s,\"fatal\":%s,"
+                   "\"hw_feeds\":%lu,\"threads\":[",
+                   g_watchdogEnabled ? "true" : "false",
+                   stats.hardware ? "true" : "false",
+                   stats.fatal ? "true" : "false", stats.hwFeeds);
+    for (int i = 0; i < stats.threadCount; i++) {
+      const watchdogThreadStats_t *t = &stats.threads[i];
+      int n = snprintf(entry, sizeof(entry),
+                       "%s{\"name\":\"%s\",\"age_ms\":%lld,"
+                       "\"max_gap_ms\":%d,\"timeout_ms\":%d,\"idle\":%s,"
+                       "\"stalled\":%s,\"stalls\":%lu,\"restarts\":%lu}",
+                       i ? "," : "", t->name, (long long)t->sinceKickMs,
+                       t->maxGapMs, t->timeoutMs, t->idle ? "true" : "false",
+                       t->stalled ? "true" : "false", t->stalls, t->restarts);
+      if (n >= (int)sizeof(entry) || len + n >= room) {
+        truncated = true;
+        break;
+      }
+      memcpy(out + len, entry, n + 1);
+      len += n;
+    }
+  } else if (strcmp(cmd->action, "get_locks") == 0) {
+    lockSiteStats_t sites[8];
+    int count = lockProfile_GetSites(sites, 8);
+    len = snprintf(out, room, "{\"enabled\":%s,\"locks\":[",
+                   lockProfile_IsEnabled() ? "true" : "false");
+    for (int i = 0; i < count; i++) {
+      const lockSiteStats_t *l = &sites[i];
+      int n = snprintf(
+          entry, sizeof(entry),
+          "%s{\"site\":\"%s\",\"count\":%lu,\"contended\":%lu,"
+          "\"wait_total_us\":%.3f,\"wait_p99_us\":%u,\"wait_max_us\":%u,"
+          "\"hold_total_us\":%.3f,\"hold_p99_us\":%u,\"hold_max_us\":%u}",
+          i ? "," : "", l->name, l->acquisitions, l->contended,
+          l->waitTotalNs / 1000.0, l->waitP99Us, l->waitMaxUs,
+          l->holdTotalNs / 1000.0, l->holdP99Us, l->holdMaxUs);
+      if (n >= (int)sizeof(entry) || len + n >= room) {
+        truncated = true;
+        break;
+      }
+      memcpy(out + len, entry, n + 1);
+      len += n;
+    }
+  } else {
+    return COMMAND_ERR_UNKNOWN_ACTION;
+  }
+
+  snprintf(out + len, sizeof(result->resultData) - len,
+           "],\"truncated\":%s}", truncated ? "true" : "false");
+  return COMMAND_OK;
+}
+
+static int formatOtaStatus(const otaStatus_t *status, char *out, size_t size) {
+  return snprintf(
+      out, size,
+      "{\"state\":\"%s\",\"session\":%u,\"size\":%llu,\"received\":%llu,"
+      "\"committed\":%llu,\"percent\":%d,\"chunk_size\":%u,"
+      "\"next_seq\":%u,\"rate_bps\":%u,\"resumed\":%s,\"duplicates\":%lu,"
+      "\"gaps\":%lu,\"writes\":%lu,\"error\":\"%s\"}",
+      otaUpdate_StateName(status->state), status->sessionId,
+      (unsigned long long)status->size, (unsigned long long)status->received,
+      (unsigned long long)status->committed,
+      status->size ? (int)(status->received * 100 / status->size) : 0,
+      status->chunkSize, status->nextSeq, status->bytesPerSec,
+      status->resumed ? "true" : "false", status->duplicates, status->gaps,
+      status->writes, status->error);
+}
+
+/* OTA进度、完成和分片缺失作为 start 命令的响应发布 */
+static void otaProgressHandle(const otaStatus_t *status, void *userData) {
+  sentinelCommandResult_t result = {.errorCode = COMMAND_OK};
+  if (status->state == OTA_STATE_FAILED) {
+    result.errorCode = COMMAND_ERR_EXEC;
+    snprintf(result.message, sizeof(result.message), "OTA failed: %s",
+             status->error);
+  }
+  formatOtaStatus(status, result.resultData, sizeof(result.resultData));
+
+  char responsePayload[RESPONSE_PAYLOAD_MAX];
+  PROFILED_LOCK(&g_otaCommandLock);
+  int len = commandDispatch_FormatResponse(&g_otaCommand, &result,
+                                           responsePayload,
+                                           sizeof(responsePayload));
+  lockProfile_Unlock(&g_otaCommandLock);
+  publishDeviceMessage(SOURCE_RESPONSE, g_responseTopic, responsePayload, len,
+                       1, false);
+}
+
+/*
+ * @brief  OTA命令（target "ota"）：
+ *         start 开始或继续下载，value 为镜像的SHA-256（十六进制），
+ *         参数 session（非0会话ID）、size（字节）、chunk_size（字节）；
+ *         status 查询进度（续传时从 next_seq 开始发送）；abort 放弃下载；
+ *         apply 在校验通过后执行 applyCommand。均返回下载状态
+ * */
+static int otaCommandHandle(const sentinelCommand_t *cmd,
+                            sentinelCommandResult_t *result, void *userData) {
+  if (!g_otaEnabled) {
+    snprintf(result->message, sizeof(result->message), "OTA disabled");
+    return COMMAND_ERR_EXEC;
+  }
+
+  int rc = COMMAND_OK;
+  if (strcmp(cmd->action, "start") == 0) {
+    uint8_t digest[SHA256_DIGEST_LEN];
+    double session = commandDispatch_GetParam(cmd, "session", 0);
+    double size = commandDispatch_GetParam(cmd, "size", 0);
+    double chunkSize = commandDispatch_GetParam(cmd, "chunk_size",
+                                                g_otaConfig.maxChunkBytes);
+    if (sha256_ParseHex(cmd->valueStr, digest) != 0 || session < 1 ||
+        session > UINT32_MAX || size < 1 || chunkSize < 1) {
+      snprintf(result->message, sizeof(result->message),
+               "Expect sha256 value and session/size params");
+      return COMMAND_ERR_INVALID_VALUE;
+    }
+    if (otaUpdate_Begin(&g_ota, (uint32_t)session, (uint64_t)size,
+                        (uint32_t)chunkSize, digest) != 0) {
+      snprintf(result->message, sizeof(result->message),
+               "chunk_size must be a multiple of %d dividing %u, max %u",
+               OTA_WRITE_ALIGN, g_otaConfig.bufferBytes,
+               g_otaConfig.maxChunkBytes);
+      rc = COMMAND_ERR_INVALID_VALUE;
+    } else {
+      PROFILED_LOCK(&g_otaCommandLock);
+      g_otaCommand = *cmd;
+      lockProfile_Unlock(&g_otaCommandLock);
+    }
+  } else if (strcmp(cmd->action, "abort") == 0) {
+    otaUpdate_Abort(&g_ota);
+  } else if (strcmp(cmd->action, "apply") == 0) {
+    if (otaUpdate_Apply(&g_ota) != 0) {
+      snprintf(result->message, sizeof(result->message),
+               "Image not verified or apply command failed");
+      rc = COMMAND_ERR_EXEC;
+    }
+  } else if (strcmp(cmd->action, "status") != 0) {
+    return COMMAND_ERR_UNKNOWN_ACTION;
+  }
+
+  otaStatus_t status;
+  otaUpdate_GetStatus(&g_ota, &status);
+  formatOtaStatus(&status, result->resultData, sizeof(result->resultData));
+  return rc;
+}
+
+/*
+ * @brief  网关自身使用的Topic：启动时构建的全部Topic（事件循环启动前
+ *         登记完毕），以及遗嘱和命令Topic
+ * */
+static bool isDeviceTopic(const char *topic) {
+  static const char *fixed[] = {"online", "command"};
+  const char *suffix = strrchr(topic, '/') + 1;
+  for (size_t i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++) {
+    if (strcmp(fixed[i], suffix) == 0) {
+      return true;
+    }
+  }
+  for (int i = 0; i < g_deviceTopicCount; i++) {
+    if (strcmp(g_deviceTopics[i], topic) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * @brief  转发下游设备的读数（事件循环线程）。发送队列剩余不足1/4时
+ *         返回繁忙，由接入模块暂停该连接，把队列留给网关自身的消息
+ * */
+static int tcpIngestForwardHandle(const char *sensorType, int typeLen,
+                                  const char *payload, int payloadLen,
+                                  void *userData) {
+  char topic[256];
+  snprintf(topic, sizeof(topic), "sentinel/%s/%.*s", g_mqttConfig.clientID,
+           typeLen, sensorType);
+  if (isDeviceTopic(topic)) {
+    return 0;
+  }
+
+  if (brokerGroup_QueueRoom(&g_brokerGroup, BROKER_CLASS_BULK) <
+      g_brokerGroup.config.classes[BROKER_CLASS_BULK].depth / 4) {
+    return -1;
+  }
+  publishDeviceMessage(SOURCE_INGEST, topic, payload, payloadLen, 0, false);
+  return 0;
+}
+
+/*
+ * @brief  TCP接入命令（target "ingest"）：get_stats 返回连接数和转发统计
+ * */
+static int tcpIngestCommandHandle(const sentinelCommand_t *cmd,
+                                  sentinelCommandResult_t *result,
+                                  void *userData) {
+  if (!g_tcpIngestEnabled) {
+    snprintf(result->message, sizeof(result->message), "TCP ingest disabled");
+    return COMMAND_ERR_EXEC;
+  }
+  if (strcmp(cmd->action, "get_stats") != 0) {
+    return COMMAND_ERR_UNKNOWN_ACTION;
+  }
+
+  tcpIngestStats_t stats;
+  tcpIngest_GetStats(&stats);
+  snprintf(result->resultData, sizeof(result->resultData),
+           "{\"port\":%d,\"connections\":%d,\"paused\":%d,"
+           "\"accepted\":%lu,\"rejected\":%lu,\"closed\":%lu,"
+           "\"messages\":%lu,\"bytes\":%lu,\"bad_frames\":%lu,"
+           "\"oversized\":%lu,\"throttled\":%lu,\"busy\":%lu,"
+           "\"copied\":%lu}",
+           tcpIngest_Port(), stats.connections, stats.paused, stats.accepted,
+           stats.rejected, stats.closed, stats.messages, stats.bytes,
+           stats.badFrames, stats.oversized, stats.throttled, stats.busy,
+           stats.copied);
+  return COMMAND_OK;
+}
+
+/*
+ * @brief  本地实时推送命令（target "live"）：get_stats 返回客户端数、
+ *         推送和丢弃统计以及推送延迟
+ * */
+static int liveCommandHandle(const sentinelCommand_t *cmd,
+                             sentinelCommandResult_t *result,
+                             void *userData) {
+  if (!g_wsEnabled) {
+    snprintf(result->message, sizeof(result->message),
+             "Live stream disabled");
+    return COMMAND_ERR_EXEC;
+  }
+  if (strcmp(cmd->action, "get_stats") != 0) {
+    return COMMAND_ERR_UNKNOWN_ACTION;
+  }
+
+  wsServerStats_t stats;
+  wsServer_GetStats(&stats);
+  snprintf(result->resultData, sizeof(result->resultData),
+           "{\"port\":%d,\"clients\":%d,\"bytes_per_client\":%d,"
+           "\"accepted\":%lu,\"rejected\":%lu,\"closed\":%lu,"
+           "\"published\":%lu,\"queue_drops\":%lu,\"oversized\":%lu,"
+           "\"frames\":%lu,\"frame_drops\":%lu,\"slow_closed\":%lu,"
+           "\"bytes_sent\":%lu,\"fanout_avg_us\":%llu,"
+           "\"fanout_max_us\":%llu}",
+           wsServer_Port(), stats.clients, stats.bytesPerClient,
+           stats.accepted, stats.rejected, stats.closed, stats.published,
+           stats.queueDrops, stats.oversized, stats.frames, stats.frameDrops,
+           stats.slowClosed, stats.bytesSent,
+           (unsigned long long)(stats.published
+                                    ? stats.fanoutTotalUs / stats.published
+                                    : 0),
+           (unsigned long long)stats.fanoutMaxUs);
+  return COMMAND_OK;
+}
+
+/* 单调时钟毫秒数，用于规则去抖和限速（仿真模式下为虚拟时间） */
+static int64_t monotonicMs(void) { return simClock_NowMs(); }
+
+/* Unix时间戳（毫秒），历史数据按墙上时间查询 */
+static int64_t realtimeMs(void) { return simClock_RealtimeMs(); }
+
+/* 睡眠指定毫秒数，被信号打断时继续睡完剩余时间 */
+static void sleepMs(int ms) {
+  if (simClock_IsVirtual()) {
+    simClock_SleepMs(ms);
+    return;
+  }
+  struct timespec ts = {.tv_sec = ms / 1000,
+                        .tv_nsec = (long)(ms % 1000) * 1000000};
+  while (nanosleep(&ts, &ts) != 0 && !g_exitFlag) {
+  }
+}
+
+/* 一轮Modbus轮询完成（事件循环线程），读取失败的测点为 null */
+static void modbusPollHandle(const char *device, const modbusValue_t *values,
+                             int count, int64_t cycleUs, void *userData) {
+  char payload[RESPONSE_PAYLOAD_MAX];
+  int room = (int)sizeof(payload) - 2;
+  int len = snprintf(payload, room,
+                     "{\"device\":\"%s\",\"timestamp_ms\":%lld,"
+                     "\"cycle_us\":%lld,\"values\":{",
+                     device, (long long)realtimeMs(), (long long)cycleUs);
+  for (int i = 0; i < count && len < room; i++) {
+    if (values[i].valid) {
+      len += snprintf(payload + len, room - len, "%s\"%s\":%.6g",
+                      i ? "," : "", values[i].name, values[i].value);
+    } else {
+      len += snprintf(payload + len, room - len, "%s\"%s\":null",
+                      i ? "," : "", values[i].name);
+    }
+  }
+  if (len >= room) {
+    LOGGER_WARN("Modbus payload of %s too large.", device);
+    return;
+  }
+  len += snprintf(payload + len, sizeof(payload) - len, "}}");
+  publishDeviceMessage(SOURCE_MODBUS, g_modbusTopic, payload, len, 0, false);
+}
+
+/*
+ * @brief  Modbus命令（target "modbus"）：get_stats 返回各设备的连接状态、
+ *         合并后的请求数和轮询耗时
+ * */
+static int modbusCommandHandle(const sentinelCommand_t *cmd,
+                               sentinelCommandResult_t *result,
+                               void *userData) {
+  if (!g_modbusEnabled) {
+    snprintf(result->message, sizeof(result->message), "Modbus disabled");
+    return COMMAND_ERR_EXEC;
+  }
+  if (strcmp(cmd->action, "get_stats") != 0) {
+    return COMMAND_ERR_UNKNOWN_ACTION;
+  }
+
+  char *out = result->resultData;
+  // 预留结尾 "],\"truncated\":false}" 的空间
+  int room = (int)sizeof(result->resultData) - 32;
+  bool truncated = false;
+  char entry[320];
+  int len = snprintf(out, room, "{\"devices\":[");
+  for (int i = 0; i < modbusPoller_DeviceCount(); i++) {
+    const char *name;
+    modbusDeviceStats_t stats;
+    modbusPoller_GetDeviceStats(i, &name, &stats);
+    int n = snprintf(
+        entry, sizeof(entry),
+        "%s{\"name\":\"%s\",\"connected\":%s,\"requests_per_cycle\":%d,"
+        "\"registers_per_cycle\":%d,\"cycles\":%lu,\"overruns\":%lu,"
+        "\"timeouts\":%lu,\"exceptions\":%lu,\"reconnects\":%lu,"
+        "\"last_cycle_us\":%lld,\"max_cycle_us\":%lld}",
+        i ? "," : "", name, stats.connected ? "true" : "false",
+        stats.requestsPerCycle, stats.registersPerCycle, stats.cycles,
+        stats.overruns, stats.timeouts, stats.exceptions, stats.reconnects,
+        (long long)stats.lastCycleUs, (long long)stats.maxCycleUs);
+    if (len + n >= room) {
+      truncated = true;
+      break;
+    }
+    memcpy(out + len, entry, n + 1);
+    len += n;
+  }
+  snprintf(out + len, sizeof(result->resultData) - len,
+           "],\"truncated\":%s}", truncated ? "true" : "false");
+  return COMMAND_OK;
+}
+
+/*
+ * @brief  串口帧发布（事件循环线程）。JSON对象原样发布，其他帧包装为
+ *         {"port","timestamp_ms","data"}，二进制分帧的 data 为十六进制
+ * */
+static void uartFrameHandle(const uartFrame_t *frame, void *userData) {
+  if (frame->len > 0 && frame->data[0] == '{') {
+    publishDeviceMessage(SOURCE_UART, g_uartTopics[frame->port],
+                         (const char *)frame->data, frame->len, 0, false);
+    return;
+  }
+
+  char payload[RESPONSE_PAYLOAD_MAX];
+  bool text = strcmp(frame->config->framer, "line") == 0;
+  int room = (int)sizeof(payload) - 3;
+  int len = snprintf(payload, room,
+                     "{\"port\":\"%s\",\"timestamp_ms\":%lld,\"%s\":\"",
+                     frame->config->name, (long long)realtimeMs(),
+                     text ? "data" : "hex");
+  for (int i = 0; i < frame->len && len < room; i++) {
+    uint8_t c = frame->data[i];
+    if (!text) {
+      len += snprintf(payload + len, room - len, "%02x", c);
+    } else if (c == '"' || c == '\\') {
+      len += snprintf(payload + len, room - len, "\\%c", c);
+    } else if (c < 0x20) {
+      len += snprintf(payload + len, room - len, "\\u%04x", c);
+    } else {
+      payload[len++] = (char)c;
+    }
+  }
+  if (len >= room) {
+    LOGGER_WARN("UART frame of %s too large.", frame->config->name);
+    return;
+  }
+  len += snprintf(payload + len, sizeof(payload) - len, "\"}");
+  publishDeviceMessage(SOURCE_UART, g_uartTopics[frame->port], payload, len, 0,
+                       false);
+}
+
+/*
+ * @brief  串口命令（target "uart"）：get_stats 返回各端口的打开状态和
+ *         分帧统计
+ * */
+static int uartCommandHandle(const sentinelCommand_t *cmd,
+                             sentinelCommandResult_t *result, void *userData) {
+  if (!g_uartEnabled) {
+    snprintf(result->message, sizeof(result->message), "UART disabled");
+    return COMMAND_ERR_EXEC;
+  }
+  if (strcmp(cmd->action, "get_stats") != 0) {
+    return COMMAND_ERR_UNKNOWN_ACTION;
+  }
+
+  char *out = result->resultData;
+  // 预留结尾 "],\"truncated\":false}" 的空间
+  int room = (int)sizeof(result->resultData) - 32;
+  bool truncated = false;
+  char entry[320];
+  int len = snprintf(out, room, "{\"ports\":[");
+  for (int i = 0; i < uartInput_PortCount(); i++) {
+    uartInputStats_t stats;
+    uartInput_GetStats(i, &stats);
+    int n = snprintf(
+        entry, sizeof(entry),
+        "%s{\"name\":\"%s\",\"open\":%s,\"bytes\":%lu,\"frames\":%lu,"
+        "\"bad_frames\":%lu,\"overflows\":%lu,\"read_errors\":%lu,"
+        "\"reopens\":%lu}",
+        i ? "," : "", g_uartPorts[i].name, stats.open ? "true" : "false",
+        stats.bytes, stats.frames, stats.badFrames, stats.overflows,
+        stats.readErrors, stats.reopens);
+    if (len + n >= room) {
+      truncated = true;
+      break;
+    }
+    memcpy(out + len, entry, n + 1);
+    len += n;
+  }
+  snprintf(out + len, sizeof(result->resultData) - len,
+           "],\"truncated\":%s}", truncated ? "true" : "false");
+  return COMMAND_OK;
+}
+
+/* 性能计数器发布定时器：发布各阶段的平均计数 */
+static void perfMetricsTimerHandle(int fd, uint32_t events, void *userData) {
+  eventLoop_AckTimer(fd);
+  if (!perfCounters_IsEnabled()) {
+    return;
+  }
+  char payload[RESPONSE_PAYLOAD_MAX];
+  int len = formatPerfStages(payload, sizeof(payload));
+  publishDeviceMessage(SOURCE_METRICS, g_perfMetricsTopic, payload, len, 0,
+                       false);
+}
+
+/* 命令执行器统计发布定时器 */
+static void commandStatsTimerHandle(int fd, uint32_t events, void *userData) {
+  eventLoop_AckTimer(fd);
+  char payload[RESPONSE_PAYLOAD_MAX];
+  int len = formatCommandStats(payload, sizeof(payload));
+  publishDeviceMessage(SOURCE_METRICS, g_perfMetricsTopic, payload, len, 0,
+                       false);
+}
+
+/* CPU预算定时器：每秒按网关进程的CPU占用更新采样率缩放系数 */
+static void rateBudgetTimerHandle(int fd, uint32_t events, void *userData) {
+  eventLoop_AckTimer(fd);
+  adaptiveRate_UpdateBudget(&g_rateBudget, getProcessCpuLoad());
+}
+
+/* 更新最新值表（每个表项只由一个线程写入） */
+static void updateLatest(int valueId, int64_t tsMs, double value) {
+  valueTable_Write(&g_valueTable, valueId, value, tsMs);
+}
+
+/* 把一个字段的样本写入历史存储 */
+static void recordHistory(int seriesId, int64_t tsMs, double value) {
+  if (g_historyEnabled && seriesId >= 0) {
+    historyStore_Append(&g_historyStore, seriesId, tsMs, value);
+  }
+}
+
+/*
+ * @brief  历史存储命令：get_history 按字段返回降采样的时间范围，
+ *         get_stats 返回存储占用
+ * */
+static int historyCommandHandle(const sentinelCommand_t *cmd,
+                                sentinelCommandResult_t *result,
+                                void *userData) {
+  if (!g_historyEnabled) {
+    snprintf(result->message, sizeof(result->message),
+             "History store disabled");
+    return COMMAND_ERR_EXEC;
+  }
+
+  if (strcmp(cmd->action, "get_stats") == 0) {
+    historyStoreStats_t stats;
+    historyStore_GetStats(&g_historyStore, &stats);
+    snprintf(result->resultData, sizeof(result->resultData),
+             "{\"series\":%d,\"blocks_used\":%u,\"block_count\":%u,"
+             "\"samples\":%llu,\"stored_bytes\":%llu,"
+             "\"bytes_per_sample\":%.2f}",
+             stats.seriesCount, stats.blocksUsed, stats.blockCount,
+             (unsigned long long)stats.samples,
+             (unsigned long long)stats.storedBytes,
+             stats.samples ? (double)stats.storedBytes / stats.samples : 0.0);
+    return COMMAND_OK;
+  }
+  if (strcmp(cmd->action, "get_history") != 0) {
+    return COMMAND_ERR_UNKNOWN_ACTION;
+  }
+
+  int seriesId = historyStore_FindSeries(&g_historyStore, cmd->valueStr);
+  if (seriesId < 0) {
+    snprintf(result->message, sizeof(result->message),
+             "Unknown history field '%s'", cmd->valueStr);
+    return COMMAND_ERR_INVALID_VALUE;
+  }
+
+  // 时间范围：from_ms/to_ms，或最近 last_s 秒（默认1小时）
+  int64_t toMs = (int64_t)commandDispatch_GetParam(cmd, "to_ms", realtimeMs());
+  double lastSec = commandDispatch_GetParam(cmd, "last_s", 3600);
+  int64_t fromMs = (int64_t)commandDispatch_GetParam(
+      cmd, "from_ms", (double)(toMs - (int64_t)(lastSec * 1000)));
+  int points = (int)commandDispatch_GetParam(cmd, "points", 30);
+  if (points < 1 || points > HISTORY_MAX_POINTS || toMs <= fromMs) {
+    return COMMAND_ERR_INVALID_VALUE;
+  }
+  int64_t stepMs = (toMs - fromMs + points - 1) / points;
+
+  historyBucket_t buckets[HISTORY_MAX_POINTS];
+  int count = historyStore_Query(&g_historyStore, seriesId, fromMs, toMs,
+                                 stepMs, buckets, points);
+  if (count < 0) {
+    return COMMAND_ERR_EXEC;
+  }
+
+  // 每个点为 [start_ms, avg, min, max, count]，空桶省略
+  char *out = result->resultData;
+  size_t size = sizeof(result->resultData);
+  size_t len = snprintf(out, size,
+                        "{\"field\":\"%s\",\"from_ms\":%lld,\"to_ms\":%lld,"
+                        "\"step_ms\":%lld,\"points\":[",
+                        cmd->valueStr, (long long)fromMs, (long long)toMs,
+                        (long long)stepMs);
+  bool first = true;
+  bool truncated = false;
+  for (int i = 0; i < count; i++) {
+    const historyBucket_t *b = &buckets[i];
+    if (b->count == 0) {
+      continue;
+    }
+    char point[96];
+    int n = snprintf(point, sizeof(point), "%s[%lld,%.6g,%.6g,%.6g,%d]",
+                     first ? "" : ",", (long long)b->startMs,
+                     b->sum / b->count, b->min, b->max, b->count);
+    if (len + n + 24 >= size) {
+      truncated = true;
+      break;
+    }
+    memcpy(out + len, point, n);
+    len += n;
+    first = false;
+  }
+  snprintf(out + len, size - len, "],\"truncated\":%s}",
+           truncated ? "true" : "false");
+  return COMMAND_OK;
+}
+
+/* 网关自身的命令target，PWM通道的target由 pwmLed_Init 逐个注册 */
+static const struct {
+  const char *target;
+  commandHandler_t handler;
+} g_commandTargets[] = {
+    {"rule_engine", ruleEngineCommandHandle},
+    {"history", historyCommandHandle},
+    {"mqtt", mqttStatsCommandHandle},
+    {"diagnostics", diagnosticsCommandHandle},
+    {"ota", otaCommandHandle},
+    {"commands", commandsCommandHandle},
+    {"ingest", tcpIngestCommandHandle},
+    {"live", liveCommandHandle},
+    {"modbus", modbusCommandHandle},
+    {"uart", uartCommandHandle},
+};
+_Static_assert(sizeof(g_commandTargets) / sizeof(g_commandTargets[0]) +
+                       PWM_MAX_CHANNELS <=
+                   COMMAND_MAX_TARGETS,
+               "command target table too small for fixed and PWM targets");
+
+/* 唤醒光照采样线程 */
+static void wakeLightSampler(void) {
+  PROFILED_LOCK(&g_lightWakeLock);
+  g_lightWakePending = true;
+  simClock_CondSignal(&g_lightWakeCond);
+  lockProfile_Unlock(&g_lightWakeLock);
+}
+
+/*
+ * @brief  GPIO输入事件（事件循环线程中调用）：唤醒关联的采样源、
+ *         送入规则引擎，并发布到 sentinel/{id}/gpio（Broker断开时照常入队）
+ * */
+static void gpioInputEventHandle(const gpioEvent_t *event, void *userData) {
+  const gpioLineConfig_t *line = event->config;
+  if (strcmp(line->trigger, "light") == 0) {
+    wakeLightSampler();
+  }
+
+  for (int i = 0; i < g_gpioLineCount; i++) {
+    if (strcmp(g_gpioLines[i].name, line->name) != 0) {
+      continue;
+    }
+    if (g_gpioFieldIds[i] >= 0) {
+      ruleSample_t sample = {g_gpioFieldIds[i], event->value};
+      ruleEngine_OnSample(&g_ruleEngine, &sample, 1, monotonicMs());
+    }
+    int64_t nowMs = realtimeMs();
+    updateLatest(g_gpioValueIds[i], nowMs, event->value);
+    recordHistory(g_gpioHistoryIds[i], nowMs, event->value);
+    break;
+  }
+
+  // 断开期间事件留在告警优先级的发送队列中，重连后发出
+  long long timestampMs = realtimeMs();
+  int physical = line->activeLow ? !event->value : event->value;
+
+  char gpioPayload[256];
+  int len = snprintf(
+      gpioPayload, sizeof(gpioPayload),
+      "{\"timestamp_ms\": %lld,\"name\": \"%s\",\"line\": %d,\"value\": "
+      "%d,\"edge\": \"%s\",\"kernel_ts_ns\": %llu,\"settled\": %s}",
+      timestampMs, line->name, line->line, event->value,
+      physical ? "rising" : "falling", (unsigned long long)event->kernelTsNs,
+      event->settled ? "true" : "false");
+  if (publishDeviceMessage(SOURCE_GPIO, g_gpioTopic, gpioPayload, len, 1,
+                           false) != 0) {
+    LOGGER_ERROR("Failed to publish GPIO event.");
+  }
+}
+
+/*
+ * @brief  IIO扫描样本（事件循环线程中调用）：每个扫描都送入规则引擎，
+ *         并保存为最新样本供光照线程发布
+ * */
+static void iioSampleHandle(const iioSample_t *sample, void *userData) {
+  ruleSample_t samples[IIO_MAX_CHANNELS];
+  int count = 0;
+  int64_t nowMs = realtimeMs();
+  for (int i = 0; i < sample->channelCount; i++) {
+    if (g_iioFieldSlots[i] >= 0) {
+      samples[count].fieldId = g_fieldIds[g_iioFieldSlots[i]];
+      samples[count].value = sample->values[i];
+      count++;
+      updateLatest(g_valueIds[g_iioFieldSlots[i]], nowMs, sample->values[i]);
+    }
+  }
+  ruleEngine_OnSample(&g_ruleEngine, samples, count, monotonicMs());
+
+  PROFILED_LOCK(&g_iioLock);
+  g_iioLatest = *sample;
+  g_iioValid = true;
+  lockProfile_Unlock(&g_iioLock);
+}
+
+/* 从最新的IIO扫描中取出某个字段，未映射时返回-1 */
+static int iioFieldValue(const iioSample_t *sample, int field) {
+  for (int i = 0; i < sample->channelCount; i++) {
+    if (g_iioFieldSlots[i] == field) {
+      return (int)sample->values[i];
+    }
+  }
+  return -1;
+}
+
+void mqttConnectionStatusHandle(bool isConnected, void *userData) {
+  updateLatest(g_connectedValueId, realtimeMs(), isConnected ? 1 : 0);
+  if (isConnected) {
+    LOGGER_INFO("Client is connected.");
+  } else {
+    LOGGER_WARN("Connect error.");
+  }
+}
+
+/* 推送到本地实时流，没有客户端订阅该数据源时直接返回 */
+static void publishLive(outboundSource_t source, const char *payload,
+                        int payloadLen) {
+  if (g_wsEnabled) {
+    wsServer_Publish(g_liveIds[source], payload, payloadLen);
+  }
+}
+
+/*
+ * @brief  发布设备消息，对配置了压缩的Topic先经过压缩阶段
+ *
+ * @return 0 成功
+ * */
+static int publishDeviceMessage(outboundSource_t source, const char *topic,
+                                const char *payload, int payloadLen, int qos,
+                                bool retained) {
+  publishLive(source, payload, payloadLen);
+  if (payloadLen >= g_codecConfig.minBytes &&
+      payloadLen <= g_codecConfig.maxPayloadBytes &&
+      payloadCodec_TopicEnabled(&g_payloadCodec, topic)) {
+    uint8_t packed[PAYLOAD_CODEC_BOUND(1024)];
+    int packedLen = payloadCodec_Compress(&g_payloadCodec, payload, payloadLen,
+                                          packed, sizeof(packed));
+    // 压缩无收益时仍然发送原始JSON，订阅端按首字节区分
+    if (packedLen > 0) {
+      return brokerGroup_Publish(&g_brokerGroup, g_sourceIds[source], topic,
+                                 (const char *)packed, packedLen, qos,
+                                 retained, &g_packedPublishOptions);
+    }
+  }
+  return brokerGroup_Publish(&g_brokerGroup, g_sourceIds[source], topic,
+                             payload, payloadLen, qos, retained,
+                             &g_jsonPublishOptions);
+}
+
+/* 子线程函数 */
+// 信号处理函数
+void signalHandle(int signum) {
+  if (signum == SIGINT || signum == SIGTERM) {
+    g_exitFlag = true;
+  }
+}
+
+// 设备状态采集和发送线程
+void *deviceStatusThreadFunc(void *arg) {
+  int generation = (int)(intptr_t)arg;
+  bool first = true; // 启动后立即采样，之后按采样间隔
+
+  while (!g_exitFlag &&
+         generation == __atomic_load_n(&g_statusGeneration, __ATOMIC_ACQUIRE)) {
+    watchdog_Kick(g_statusWatchdogId);
+    if (!first) {
+      sleepMs(adaptiveRate_IntervalMs(&g_statusRate));
+    }
+    first = false;
+    perfSnapshot_t perf;
+    perfCounters_Begin(&perf);
+
+    // 开始采集设备状态（与连接状态无关，本地规则需要持续评估）
+    float cpuTemp, memUsage;
+    double cpuLoad;
+    if (g_simConfig.enabled) {
+      int64_t elapsedMs = simClock_ElapsedMs();
+      cpuTemp = simSensor_Value(SIM_SENSOR_CPU_TEMP, elapsedMs);
+      memUsage = simSensor_Value(SIM_SENSOR_MEM_USAGE, elapsedMs);
+      cpuLoad = simSensor_Value(SIM_SENSOR_CPU_LOAD, elapsedMs);
+    } else {
+      cpuTemp = getCpuTemperature();
+      memUsage = getMemUsage();
+      cpuLoad = getCpuLoad();
+    }
+    PERF_LAP(&perf, "status.read");
+    if (cpuLoad >= 0) {
+      adaptiveRate_OnSample(&g_statusRate, cpuLoad, monotonicMs());
+    }
+
+    ruleSample_t samples[] = {
+        {g_fieldIds[FIELD_CPU_TEMP], cpuTemp},
+        {g_fieldIds[FIELD_CPU_LOAD], cpuLoad},
+        {g_fieldIds[FIELD_MEM_USAGE], memUsage},
+    };
+    ruleEngine_OnSample(&g_ruleEngine, samples, 3, monotonicMs());
+
+    int64_t nowMs = realtimeMs();
+    updateLatest(g_valueIds[FIELD_CPU_TEMP], nowMs, cpuTemp);
+    updateLatest(g_valueIds[FIELD_CPU_LOAD], nowMs, cpuLoad);
+    updateLatest(g_valueIds[FIELD_MEM_USAGE], nowMs, memUsage);
+    recordHistory(g_historyIds[FIELD_CPU_TEMP], nowMs, cpuTemp);
+    // 负载按float精度保存：与上报精度一致，低位清零后XOR编码更紧凑
+    recordHistory(g_historyIds[FIELD_CPU_LOAD], nowMs, (float)cpuLoad);
+    recordHistory(g_historyIds[FIELD_MEM_USAGE], nowMs, memUsage);
+    PERF_LAP(&perf, "status.process");
+
+    // 设置消息载荷
+    char deviceStatusPaylod[256];
+    int payloadLen = snprintf(
+        deviceStatusPaylod, sizeof(deviceStatusPaylod),
+        "{\"timestamp_ms\": %ld,\"cpu_temp_c\": %lf,\"cpu_load\": "
+        "%f,\"mem_usage_percent\": %f,\"peak_rss_kb\": %ld,"
+        "\"sample_hz\": %.2f}",
+        (long)(realtimeMs() / 1000), cpuTemp, cpuLoad, memUsage,
+        memPool_GetPeakRssKb(), adaptiveRate_EffectiveHz(&g_statusRate));
+    PERF_LAP(&perf, "status.serialize");
+
+    // 检查MQTT是否连接，断开期间本地实时流照常推送
+    if (!brokerGroup_IsConnected(&g_brokerGroup)) {
+      __atomic_add_fetch(&g_samplesOffline, 1, __ATOMIC_RELAXED);
+      publishLive(SOURCE_STATUS, deviceStatusPaylod, payloadLen);
+      LOGGER_WARN("MQTT Client does not connected.");
+      continue;
+    }
+
+    // 发布消息
+    __atomic_add_fetch(&g_samplesProduced, 1, __ATOMIC_RELAXED);
+    int rc = publishDeviceMessage(SOURCE_STATUS, g_deviceStatusTopic,
+                                  deviceStatusPaylod, payloadLen, 0, true);
+    PERF_LAP(&perf, "status.publish");
+    if (rc != 0) {
+      LOGGER_ERROR("Failed publish device status.");
+    }
+  }
+
+  return NULL;
+}
+
+/* 环境光传感器数据发布线程 */
+void *lightSensorThreadFunc(void *arg) {
+  char *sensorType = "light_sensor";
+  int generation = (int)(intptr_t)arg;
+  bool first = true; // 启动后立即采样，之后按采样间隔
+
+  while (!g_exitFlag &&
+         generation == __atomic_load_n(&g_lightGeneration, __ATOMIC_ACQUIRE)) {
+    watchdog_Kick(g_lightWatchdogId);
+    // 等待采样间隔或AP3216C中断唤醒（条件变量使用单调时钟）
+    int intervalMs = first ? 0 : adaptiveRate_IntervalMs(&g_lightRate);
+    first = false;
+    struct timespec deadline;
+    simClock_Deadline(&deadline, intervalMs);
+    PROFILED_LOCK(&g_lightWakeLock);
+    while (!g_lightWakePending && !g_exitFlag) {
+      if (lockProfile_CondTimedWait(&g_lightWakeCond, &g_lightWakeLock,
+                                    &deadline) != 0) {
+        break;
+      }
+    }
+    g_lightWakePending = false;
+    lockProfile_Unlock(&g_lightWakeLock);
+    perfSnapshot_t perf;
+    perfCounters_Begin(&perf);
+
+    // 采集数据：IIO模式下取最近一次扫描（规则引擎已在扫描到达时评估）
+    int als, ps, ir;
+    if (g_iioEnabled) {
+      PROFILED_LOCK(&g_iioLock);
+      iioSample_t sample = g_iioLatest;
+      bool valid = g_iioValid;
+      lockProfile_Unlock(&g_iioLock);
+      if (!valid) {
+        continue;
+      }
+      als = iioFieldValue(&sample, FIELD_LIGHT_LUX);
+      ps = iioFieldValue(&sample, FIELD_PROXIMITY);
+      ir = iioFieldValue(&sample, FIELD_INFRARED);
+    } else if (g_simConfig.enabled) {
+      int64_t elapsedMs = simClock_ElapsedMs();
+      als = (int)simSensor_Value(SIM_SENSOR_LIGHT_LUX, elapsedMs);
+      ps = (int)simSensor_Value(SIM_SENSOR_PROXIMITY, elapsedMs);
+      ir = (int)simSensor_Value(SIM_SENSOR_INFRARED, elapsedMs);
+    } else {
+      als = getAlsData();
+      ps = getPsData();
+      ir = getIrData();
+    }
+    if (!g_iioEnabled) {
+
+      ruleSample_t samples[] = {
+          {g_fieldIds[FIELD_LIGHT_LUX], als},
+          {g_fieldIds[FIELD_INFRARED], ir},
+          {g_fieldIds[FIELD_PROXIMITY], ps},
+      };
+      ruleEngine_OnSample(&g_ruleEngine, samples, 3, monotonicMs());
+    }
+    PERF_LAP(&perf, "light.read");
+    adaptiveRate_OnSample(&g_lightRate, als, monotonicMs());
+
+    int64_t nowMs = realtimeMs();
+    if (!g_iioEnabled) {
+      // IIO模式下最新值由扫描回调写入
+      updateLatest(g_valueIds[FIELD_LIGHT_LUX], nowMs, als);
+      updateLatest(g_valueIds[FIELD_INFRARED], nowMs, ir);
+      updateLatest(g_valueIds[FIELD_PROXIMITY], nowMs, ps);
+    }
+    recordHistory(g_historyIds[FIELD_LIGHT_LUX], nowMs, als);
+    recordHistory(g_historyIds[FIELD_INFRARED], nowMs, ir);
+    recordHistory(g_historyIds[FIELD_PROXIMITY], nowMs, ps);
+    PERF_LAP(&perf, "light.process");
+
+    // 构建payload
+    char lightSensorPayload[256];
+    int payloadLen = snprintf(
+        lightSensorPayload, sizeof(lightSensorPayload),
+        "{\"timestamp_ms\": %ld,\"light_lux\": %d,\"infrared_cd\": %d, "
+        "\"sensor_id\": \"%s\", \"sample_hz\": %.2f}",
+        (long)(realtimeMs() / 1000), als, ir, sensorType,
+        adaptiveRate_EffectiveHz(&g_lightRate));
+    PERF_LAP(&perf, "light.serialize");
+
+    // 检查MQTT是否连接，断开期间本地实时流照常推送
+    if (!brokerGroup_IsConnected(&g_brokerGroup)) {
+      __atomic_add_fetch(&g_samplesOffline, 1, __ATOMIC_RELAXED);
+      publishLive(SOURCE_LIGHT, lightSensorPayload, payloadLen);
+      LOGGER_WARN("MQTT Client does not connected.");
+      continue;
+    }
+
+    __atomic_add_fetch(&g_samplesProduced, 1, __ATOMIC_RELAXED);
+    int rc = publishDeviceMessage(SOURCE_LIGHT, g_lightSensorTopic,
+                                  lightSensorPayload, payloadLen, 0, true);
+    PERF_LAP(&perf, "light.publish");
+    if (rc != 0) {
+      LOGGER_ERROR("Fialed to publish light senser data.");
+    }
+  }
+  return NULL;
+}
+
+/*
+ * @brief  看门狗重启回调（事件循环线程）：代数加一后创建新的采样线程，
+ *         停滞的旧线程恢复后在下一轮循环检查代数时退出
+ * */
+static void samplingThreadRestart(int id, void *userData) {
+  bool status = id == g_statusWatchdogId;
+  int generation = __atomic_add_fetch(
+      status ? &g_statusGeneration : &g_lightGeneration, 1, __ATOMIC_RELEASE);
+  pthread_t *threadId = status ? &deviceStatusThreadID : &lightSensorThreadID;
+
+  pthread_t thread;
+  if (simClock_CreateThread(&thread,
+                            status ? deviceStatusThreadFunc
+                                   : lightSensorThreadFunc,
+                            (void *)(intptr_t)generation) != 0) {
+    LOGGER_ERROR("Failed to restart sampling thread.");
+    return;
+  }
+  pthread_detach(*threadId);
+  *threadId = thread;
+  if (!status) {
+    wakeLightSampler(); // 让等待中的旧线程尽快退出
+  }
+}
+
+/* 采样线程的心跳超时：不短于配置值，也不短于最低采样率下的三个间隔 */
+static int samplingTimeoutMs(const adaptiveRate_t *rate) {
+  int timeoutMs = (int)(3000 / rate->config.minHz);
+  return timeoutMs > g_threadTimeoutMs ? timeoutMs : g_threadTimeoutMs;
+}
+
+/* 快照 visitor：计数器、CPU负载基线和发送队列在网关中的位置 */
+static void snapshotGetCounters(gatewayCounters_t *counters, void *userData) {
+  counters->samplesProduced =
+      __atomic_load_n(&g_samplesProduced, __ATOMIC_RELAXED);
+  counters->samplesOffline =
+      __atomic_load_n(&g_samplesOffline, __ATOMIC_RELAXED);
+}
+
+static void snapshotAddCounters(const gatewayCounters_t *counters,
+                                void *userData) {
+  g_samplesProduced += counters->samplesProduced;
+  g_samplesOffline += counters->samplesOffline;
+}
+
+static void snapshotGetCpuBaseline(CpuTimes *cpu, void *userData) {
+  getCpuLoadBaseline(cpu);
+}
+
+static void snapshotSetCpuBaseline(const CpuTimes *cpu, void *userData) {
+  setCpuLoadBaseline(cpu);
+}
+
+static int snapshotExportQueued(brokerQueuedVisitor_t visitor,
+                                void *visitorData, void *userData) {
+  return brokerGroup_ExportQueued(&g_brokerGroup, visitor, visitorData);
+}
+
+static int snapshotRequeue(const brokerQueuedMessage_t *msg, void *userData) {
+  return brokerGroup_Requeue(&g_brokerGroup, msg);
+}
+
+static const char *snapshotSourceName(int source, void *userData) {
+  for (int i = 0; i < SOURCE_COUNT; i++) {
+    if (g_sourceIds[i] == source) {
+      return g_sources[i].name;
+    }
+  }
+  return NULL;
+}
+
+static int snapshotSourceByName(const char *name, int len, void *userData) {
+  for (int i = 0; i < SOURCE_COUNT; i++) {
+    if ((int)strlen(g_sources[i].name) == len &&
+        memcmp(g_sources[i].name, name, len) == 0) {
+      return g_sourceIds[i];
+    }
+  }
+  return -1;
+}
+
+static const gatewayStateVisitor_t g_snapshotVisitor = {
+    .getCounters = snapshotGetCounters,
+    .addCounters = snapshotAddCounters,
+    .getCpuBaseline = snapshotGetCpuBaseline,
+    .setCpuBaseline = snapshotSetCpuBaseline,
+    .exportQueued = snapshotExportQueued,
+    .requeue = snapshotRequeue,
+    .sourceName = snapshotSourceName,
+    .sourceByName = snapshotSourceByName,
+    .packedOptions = &g_packedPublishOptions,
+    .jsonOptions = &g_jsonPublishOptions,
+};
+
+/*
+ * @brief:  从.json文件读取内容并返回
+ *
+ * @param:  filename: 文件的储存路径字符串
+ *
+ * @return: char *: 字符串，存储.json文件内容
+ * */
+char *readFileToString(const char *filename) {
+  FILE *fp = NULL;
+  long fileSize = 0;
+  char *buffer = NULL;
+  size_t readLen = 0;
+
+  fp = fopen(filename, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "Error: Could not open file %s\n", filename);
+    return NULL;
+  }
+
+  // 获取文件大小
+  fseek(fp, 0, SEEK_END); // 重置光标到文件结束位置
+  fileSize = ftell(fp);   // 获取当前光标位置
+  rewind(fp);             // 重置光标到文家开头
+
+  // 分配内存
+  buffer = (char *)malloc(sizeof(char) * (fileSize + 1)); // +1 for "\0"
+  if (buffer == NULL) {
+    fprintf(stderr, "Error: Memoy allocation failed for file buffer. \n");
+    fclose(fp);
+    return NULL;
+  }
+
+  // 读取文件内容
+  readLen = fread(buffer, 1, fileSize, fp);
+  if (readLen != fileSize) {
+    fprintf(
+        stderr,
+        "Error: Failed to read entire file %s. Read %zu bytes, expected %ld.\n",
+        filename, readLen, fileSize);
+    free(buffer);
+    fclose(fp);
+    return NULL;
+  }
+
+  buffer[fileSize] = '\0';
+  fclose(fp);
+  return buffer;
+}
+
+/*
+ * @brief  解析静态内存模式配置（memoryConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseMemoryConfig(const cJSON *config_Root) {
+  cJSON *config_memory =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "memoryConfig");
+  if (config_memory == NULL || !cJSON_IsObject(config_memory)) {
+    return;
+  }
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_memory, "staticMode");
+  if (item && cJSON_IsBool(item)) {
+    g_memConfig.staticMode = cJSON_IsTrue(item);
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(config_memory, "budgetKB");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_memConfig.budgetBytes = (size_t)item->valueint * 1024;
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(config_memory, "maxPayloadBytes");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_memConfig.maxPayloadBytes = item->valueint;
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(config_memory, "maxTopicLen");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_memConfig.maxTopicLen = item->valueint;
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(config_memory, "commandArenaKB");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_memConfig.commandArenaBytes = (size_t)item->valueint * 1024;
+  }
+}
+
+/*
+ * @brief  解析上行载荷压缩配置（compressionConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseCompressionConfig(const cJSON *config_Root) {
+  cJSON *config_codec =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "compressionConfig");
+  if (config_codec == NULL || !cJSON_IsObject(config_codec)) {
+    return;
+  }
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_codec, "enabled");
+  if (item && cJSON_IsBool(item)) {
+    g_codecConfig.enabled = cJSON_IsTrue(item);
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(config_codec, "minBytes");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_codecConfig.minBytes = item->valueint;
+  }
+
+  cJSON *topics = cJSON_GetObjectItemCaseSensitive(config_codec, "topics");
+  cJSON *topic = NULL;
+  g_codecConfig.topicCount = 0;
+  cJSON_ArrayForEach(topic, topics) {
+    if (!cJSON_IsString(topic) ||
+        g_codecConfig.topicCount >= PAYLOAD_CODEC_MAX_TOPICS) {
+      fprintf(stderr, "Warning: ignore compression topic entry.\n");
+      continue;
+    }
+    snprintf(g_codecConfig.topics[g_codecConfig.topicCount],
+             sizeof(g_codecConfig.topics[0]), "%s", topic->valuestring);
+    g_codecConfig.topicCount++;
+  }
+}
+
+/*
+ * @brief  解析PWM LED配置（pwmConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parsePwmConfig(const cJSON *config_Root) {
+  cJSON *config_pwm = cJSON_GetObjectItemCaseSensitive(config_Root, "pwmConfig");
+  if (config_pwm == NULL || !cJSON_IsObject(config_pwm)) {
+    return;
+  }
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_pwm, "sysfsRoot");
+  if (item && cJSON_IsString(item)) {
+    snprintf(g_pwmConfig.sysfsRoot, sizeof(g_pwmConfig.sysfsRoot), "%s",
+             item->valuestring);
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(config_pwm, "tickUs");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_pwmConfig.tickUs = item->valueint;
+  }
+
+  cJSON *channel = NULL;
+  cJSON_ArrayForEach(channel,
+                     cJSON_GetObjectItemCaseSensitive(config_pwm, "channels")) {
+    cJSON *name = cJSON_GetObjectItemCaseSensitive(channel, "name");
+    cJSON *chip = cJSON_GetObjectItemCaseSensitive(channel, "chip");
+    cJSON *index = cJSON_GetObjectItemCaseSensitive(channel, "channel");
+    cJSON *period = cJSON_GetObjectItemCaseSensitive(channel, "periodNs");
+    cJSON *inverted = cJSON_GetObjectItemCaseSensitive(channel, "inverted");
+    if (!cJSON_IsString(name) || !cJSON_IsNumber(chip) ||
+        !cJSON_IsNumber(index) || g_pwmConfig.channelCount >= PWM_MAX_CHANNELS) {
+      fprintf(stderr, "Warning: ignore invalid PWM channel entry.\n");
+      continue;
+    }
+
+    pwmChannelConfig_t *ch = &g_pwmConfig.channels[g_pwmConfig.channelCount++];
+    snprintf(ch->name, sizeof(ch->name), "%s", name->valuestring);
+    ch->chip = chip->valueint;
+    ch->channel = index->valueint;
+    ch->periodNs = cJSON_IsNumber(period) ? (uint32_t)period->valuedouble
+                                          : 1000000;
+    ch->inverted = cJSON_IsTrue(inverted);
+  }
+}
+
+/*
+ * @brief  解析GPIO输入配置（gpioInputConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseGpioInputConfig(const cJSON *config_Root) {
+  cJSON *config_gpio =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "gpioInputConfig");
+  if (config_gpio == NULL || !cJSON_IsObject(config_gpio)) {
+    return;
+  }
+
+  cJSON *entry = NULL;
+  cJSON_ArrayForEach(entry,
+                     cJSON_GetObjectItemCaseSensitive(config_gpio, "lines")) {
+    cJSON *name = cJSON_GetObjectItemCaseSensitive(entry, "name");
+    cJSON *chip = cJSON_GetObjectItemCaseSensitive(entry, "chip");
+    cJSON *line = cJSON_GetObjectItemCaseSensitive(entry, "line");
+    cJSON *edge = cJSON_GetObjectItemCaseSensitive(entry, "edge");
+    cJSON *debounce = cJSON_GetObjectItemCaseSensitive(entry, "debounceMs");
+    cJSON *trigger = cJSON_GetObjectItemCaseSensitive(entry, "trigger");
+    if (!cJSON_IsString(name) || !cJSON_IsString(chip) ||
+        !cJSON_IsNumber(line) || g_gpioLineCount >= GPIO_MAX_LINES) {
+      fprintf(stderr, "Warning: ignore invalid GPIO input entry.\n");
+      continue;
+    }
+
+    gpioLineConfig_t *cfg = &g_gpioLines[g_gpioLineCount++];
+    memset(cfg, 0, sizeof(gpioLineConfig_t));
+    snprintf(cfg->name, sizeof(cfg->name), "%s", name->valuestring);
+    snprintf(cfg->chip, sizeof(cfg->chip), "%s", chip->valuestring);
+    cfg->line = line->valueint;
+    cfg->edge = GPIO_EDGE_BOTH;
+    if (cJSON_IsString(edge) && strcmp(edge->valuestring, "rising") == 0) {
+      cfg->edge = GPIO_EDGE_RISING;
+    } else if (cJSON_IsString(edge) &&
+               strcmp(edge->valuestring, "falling") == 0) {
+      cfg->edge = GPIO_EDGE_FALLING;
+    }
+    cfg->activeLow =
+        cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(entry, "activeLow"));
+    cfg->debounceMs = cJSON_IsNumber(debounce) && debounce->valueint > 0
+                          ? (uint32_t)debounce->valueint
+                          : 0;
+    if (cJSON_IsString(trigger)) {
+      snprintf(cfg->trigger, sizeof(cfg->trigger), "%s", trigger->valuestring);
+    }
+  }
+}
+
+/*
+ * @brief  解析看门狗、锁争用分析和性能计数器配置（watchdogConfig、
+ *         lockProfileConfig、perfProfileConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseDiagnosticsConfig(const cJSON *config_Root) {
+  cJSON *config_watchdog =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "watchdogConfig");
+  if (config_watchdog && cJSON_IsObject(config_watchdog)) {
+    g_watchdogEnabled = cJSON_IsTrue(
+        cJSON_GetObjectItemCaseSensitive(config_watchdog, "enabled"));
+
+    // 设备为空字符串时只检查线程心跳
+    cJSON *item = cJSON_GetObjectItemCaseSensitive(config_watchdog, "device");
+    if (item && cJSON_IsString(item)) {
+      snprintf(g_watchdogConfig.device, sizeof(g_watchdogConfig.device), "%s",
+               item->valuestring);
+    }
+
+    item = cJSON_GetObjectItemCaseSensitive(config_watchdog, "hwTimeoutSec");
+    if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+      g_watchdogConfig.hwTimeoutSec = item->valueint;
+    }
+    item = cJSON_GetObjectItemCaseSensitive(config_watchdog, "checkIntervalMs");
+    if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+      g_watchdogConfig.checkIntervalMs = item->valueint;
+    }
+    item = cJSON_GetObjectItemCaseSensitive(config_watchdog, "maxRestarts");
+    if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+      g_watchdogConfig.maxRestarts = item->valueint;
+    }
+    item = cJSON_GetObjectItemCaseSensitive(config_watchdog, "threadTimeoutMs");
+    if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+      g_threadTimeoutMs = item->valueint;
+    }
+  }
+
+  cJSON *config_lock =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "lockProfileConfig");
+  if (config_lock && cJSON_IsObject(config_lock)) {
+    lockProfile_SetEnabled(
+        cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_lock, "enabled")));
+  }
+
+  cJSON *config_perf =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "perfProfileConfig");
+  if (config_perf && cJSON_IsObject(config_perf)) {
+    perfCounters_SetEnabled(
+        cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_perf, "enabled")));
+    cJSON *item =
+        cJSON_GetObjectItemCaseSensitive(config_perf, "metricsIntervalSec");
+    if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+      g_perfMetricsIntervalSec = item->valueint;
+    }
+  }
+}
+
+/*
+ * @brief  解析命令执行器配置（commandConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseCommandConfig(const cJSON *config_Root) {
+  cJSON *config_cmd =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "commandConfig");
+  if (config_cmd == NULL || !cJSON_IsObject(config_cmd)) {
+    return;
+  }
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_cmd, "workers");
+  if (item && cJSON_IsNumber(item)) {
+    if (item->valueint >= 1 && item->valueint <= COMMAND_EXECUTOR_MAX_WORKERS) {
+      g_commandConfig.workers = item->valueint;
+    } else {
+      fprintf(stderr, "Warning: 'workers' must be 1-%d. Using %d.\n",
+              COMMAND_EXECUTOR_MAX_WORKERS, g_commandConfig.workers);
+    }
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_cmd, "queueDepth");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_commandConfig.queueDepth = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_cmd, "defaultTimeoutMs");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_commandConfig.defaultTimeoutMs = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_cmd, "statsIntervalSec");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_commandStatsIntervalSec = item->valueint;
+  }
+}
+
+/*
+ * @brief  解析日志配置（loggerConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseLoggerConfig(const cJSON *config_Root) {
+  cJSON *config_log =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "loggerConfig");
+  if (config_log == NULL || !cJSON_IsObject(config_log)) {
+    return;
+  }
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_log, "level");
+  if (item && cJSON_IsString(item)) {
+    int level = logger_ParseLevel(item->valuestring);
+    if (level >= 0) {
+      g_loggerConfig.level = level;
+    } else {
+      fprintf(stderr, "Unknown log level '%s'.\n", item->valuestring);
+    }
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_log, "file");
+  if (item && cJSON_IsString(item)) {
+    snprintf(g_logFile, sizeof(g_logFile), "%s", item->valuestring);
+  }
+  g_loggerConfig.syslog =
+      cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_log, "syslog"));
+
+  item = cJSON_GetObjectItemCaseSensitive(config_log, "maxKB");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_loggerConfig.maxBytes = (long)item->valueint * 1024;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_log, "maxFiles");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_loggerConfig.maxFiles = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_log, "maxThreads");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_loggerConfig.maxThreads = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_log, "ringSlots");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_loggerConfig.ringSlots = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_log, "flushIntervalMs");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_loggerConfig.flushIntervalMs = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_log, "rateLimit");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_loggerConfig.rateLimit = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_log, "rateWindowSec");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_loggerConfig.rateWindowMs = item->valueint * 1000;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_log, "summaryIntervalSec");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_loggerConfig.summaryIntervalMs = item->valueint * 1000;
+  }
+}
+
+/*
+ * @brief  解析OTA配置（otaConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseOtaConfig(const cJSON *config_Root) {
+  cJSON *config_ota =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "otaConfig");
+  if (config_ota == NULL || !cJSON_IsObject(config_ota)) {
+    return;
+  }
+
+  g_otaEnabled =
+      cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_ota, "enabled"));
+
+  const char *strings[] = {"target", "stateFile", "applyCommand"};
+  char *targets[] = {g_otaConfig.target, g_otaConfig.stateFile,
+                     g_otaConfig.applyCommand};
+  size_t sizes[] = {sizeof(g_otaConfig.target), sizeof(g_otaConfig.stateFile),
+                    sizeof(g_otaConfig.applyCommand)};
+  for (int i = 0; i < 3; i++) {
+    cJSON *item = cJSON_GetObjectItemCaseSensitive(config_ota, strings[i]);
+    if (item && cJSON_IsString(item)) {
+      snprintf(targets[i], sizes[i], "%s", item->valuestring);
+    }
+  }
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_ota, "bufferKB");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_otaConfig.bufferBytes = (uint32_t)item->valueint * 1024;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_ota, "maxChunkBytes");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_otaConfig.maxChunkBytes = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_ota, "progressStepPercent");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_otaConfig.progressStepPercent = item->valueint;
+  }
+}
+
+/*
+ * @brief  解析TCP接入配置（tcpIngestConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseTcpIngestConfig(const cJSON *config_Root) {
+  cJSON *config_ingest =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "tcpIngestConfig");
+  if (config_ingest == NULL || !cJSON_IsObject(config_ingest)) {
+    return;
+  }
+
+  g_tcpIngestEnabled =
+      cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_ingest, "enabled"));
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_ingest, "bindAddress");
+  if (item && cJSON_IsString(item)) {
+    snprintf(g_tcpIngestConfig.bindAddress,
+             sizeof(g_tcpIngestConfig.bindAddress), "%s", item->valuestring);
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_ingest, "port");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_tcpIngestConfig.port = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_ingest, "maxClients");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_tcpIngestConfig.maxClients = item->valueint;
+  }
+  // 环形缓冲大小向上取整到2的幂
+  item = cJSON_GetObjectItemCaseSensitive(config_ingest, "ringBytes");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    int ringBytes = 64;
+    while (ringBytes < item->valueint) {
+      ringBytes <<= 1;
+    }
+    g_tcpIngestConfig.ringBytes = ringBytes;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_ingest, "maxMsgsPerSec");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_tcpIngestConfig.maxMsgsPerSec = item->valueint;
+  }
+}
+
+/*
+ * @brief  解析本地实时推送配置（webSocketConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseWebSocketConfig(const cJSON *config_Root) {
+  cJSON *config_ws =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "webSocketConfig");
+  if (config_ws == NULL || !cJSON_IsObject(config_ws)) {
+    return;
+  }
+
+  g_wsEnabled =
+      cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_ws, "enabled"));
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_ws, "bindAddress");
+  if (item && cJSON_IsString(item)) {
+    snprintf(g_wsConfig.bindAddress, sizeof(g_wsConfig.bindAddress), "%s",
+             item->valuestring);
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_ws, "port");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_wsConfig.port = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_ws, "maxClients");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_wsConfig.maxClients = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_ws, "maxMessageBytes");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_wsConfig.maxMessageBytes = item->valueint;
+  }
+  // 发送缓冲向上取整到2的幂，至少能放下一条最大的消息
+  item = cJSON_GetObjectItemCaseSensitive(config_ws, "sendBufferBytes");
+  int minBytes = item && cJSON_IsNumber(item) && item->valueint > 0
+                     ? item->valueint
+                     : g_wsConfig.sendBufferBytes;
+  if (minBytes < g_wsConfig.maxMessageBytes + 128) {
+    minBytes = g_wsConfig.maxMessageBytes + 128;
+  }
+  int sendBufferBytes = 1024;
+  while (sendBufferBytes < minBytes) {
+    sendBufferBytes <<= 1;
+  }
+  g_wsConfig.sendBufferBytes = sendBufferBytes;
+  item = cJSON_GetObjectItemCaseSensitive(config_ws, "queueSlots");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_wsConfig.queueSlots = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_ws, "stallTimeoutMs");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_wsConfig.stallTimeoutMs = item->valueint;
+  }
+  // 允许跨域握手的仪表盘页面，如 "http://192.168.1.20:3000"
+  int len = 0;
+  const cJSON *origin = NULL;
+  cJSON_ArrayForEach(
+      origin, cJSON_GetObjectItemCaseSensitive(config_ws, "allowedOrigins")) {
+    if (cJSON_IsString(origin) && origin->valuestring[0] != '\0') {
+      len += snprintf(g_wsConfig.allowedOrigins + len,
+                      sizeof(g_wsConfig.allowedOrigins) - len, "%s%s",
+                      len > 0 ? "," : "", origin->valuestring);
+      if (len >= (int)sizeof(g_wsConfig.allowedOrigins)) {
+        fprintf(stderr, "webSocketConfig.allowedOrigins too long.\n");
+        g_wsConfig.allowedOrigins[0] = '\0';
+        break;
+      }
+    }
+  }
+}
+
+static void parseSnapshotConfig(const cJSON *config_Root) {
+  cJSON *config_snapshot =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "snapshotConfig");
+  if (config_snapshot == NULL || !cJSON_IsObject(config_snapshot)) {
+    return;
+  }
+
+  g_snapshotConfig.enabled = cJSON_IsTrue(
+      cJSON_GetObjectItemCaseSensitive(config_snapshot, "enabled"));
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_snapshot, "path");
+  if (item && cJSON_IsString(item)) {
+    snprintf(g_snapshotConfig.path, sizeof(g_snapshotConfig.path), "%s",
+             item->valuestring);
+  }
+  // 0 表示只在退出时保存
+  item = cJSON_GetObjectItemCaseSensitive(config_snapshot, "intervalSec");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_snapshotConfig.intervalSec = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_snapshot, "maxKB");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_snapshotConfig.maxBytes = item->valueint * 1024;
+  }
+  if (g_snapshotConfig.path[0] == '\0') {
+    g_snapshotConfig.enabled = false;
+  }
+}
+
+/*
+ * @brief  解析单个Modbus测点，table 为 holding/input，
+ *         type 为 u16/i16/u32/i32/f32
+ *
+ * @return 0 成功
+ * */
+static int parseModbusPoint(const cJSON *entry, modbusPointConfig_t *point) {
+  static const char *types[] = {"u16", "i16", "u32", "i32", "f32"};
+  cJSON *name = cJSON_GetObjectItemCaseSensitive(entry, "name");
+  cJSON *table = cJSON_GetObjectItemCaseSensitive(entry, "table");
+  cJSON *address = cJSON_GetObjectItemCaseSensitive(entry, "address");
+  cJSON *type = cJSON_GetObjectItemCaseSensitive(entry, "type");
+  cJSON *scale = cJSON_GetObjectItemCaseSensitive(entry, "scale");
+  cJSON *offset = cJSON_GetObjectItemCaseSensitive(entry, "offset");
+  if (!cJSON_IsString(name) || !cJSON_IsNumber(address) ||
+      address->valueint < 0 || address->valueint > UINT16_MAX) {
+    return -1;
+  }
+
+  memset(point, 0, sizeof(modbusPointConfig_t));
+  snprintf(point->name, sizeof(point->name), "%s", name->valuestring);
+  point->address = (uint16_t)address->valueint;
+  point->table = MODBUS_TABLE_HOLDING;
+  if (cJSON_IsString(table) && strcmp(table->valuestring, "input") == 0) {
+    point->table = MODBUS_TABLE_INPUT;
+  } else if (cJSON_IsString(table) &&
+             strcmp(table->valuestring, "holding") != 0) {
+    return -1;
+  }
+  point->type = MODBUS_TYPE_U16;
+  if (cJSON_IsString(type)) {
+    int i = 0;
+    while (i < 5 && strcmp(type->valuestring, types[i]) != 0) {
+      i++;
+    }
+    if (i == 5) {
+      return -1;
+    }
+    point->type = (modbusType_t)i;
+  }
+  point->swapWords =
+      cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(entry, "swapWords"));
+  point->scale = cJSON_IsNumber(scale) ? scale->valuedouble : 1;
+  point->offset = cJSON_IsNumber(offset) ? offset->valuedouble : 0;
+  return 0;
+}
+
+/*
+ * @brief  解析Modbus轮询配置（modbusConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseModbusConfig(const cJSON *config_Root) {
+  cJSON *config_modbus =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "modbusConfig");
+  if (config_modbus == NULL || !cJSON_IsObject(config_modbus)) {
+    return;
+  }
+
+  g_modbusEnabled =
+      cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_modbus, "enabled"));
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_modbus, "maxGap");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_modbusConfig.maxGap = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_modbus, "maxRegsPerRequest");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 2 &&
+      item->valueint <= MODBUS_MAX_REGS) {
+    g_modbusConfig.maxRegs = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_modbus, "maxInFlight");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 1 &&
+      item->valueint <= MODBUS_MAX_IN_FLIGHT) {
+    g_modbusConfig.maxInFlight = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_modbus, "timeoutMs");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_modbusConfig.timeoutMs = item->valueint;
+  }
+
+  cJSON *entry = NULL;
+  cJSON *devices = cJSON_GetObjectItemCaseSensitive(config_modbus, "devices");
+  cJSON_ArrayForEach(entry, devices) {
+    cJSON *name = cJSON_GetObjectItemCaseSensitive(entry, "name");
+    cJSON *host = cJSON_GetObjectItemCaseSensitive(entry, "host");
+    cJSON *port = cJSON_GetObjectItemCaseSensitive(entry, "port");
+    cJSON *unitId = cJSON_GetObjectItemCaseSensitive(entry, "unitId");
+    cJSON *interval = cJSON_GetObjectItemCaseSensitive(entry, "intervalMs");
+    if (!cJSON_IsString(name) || !cJSON_IsString(host) ||
+        g_modbusDeviceCount >= MODBUS_MAX_DEVICES) {
+      fprintf(stderr, "Warning: ignore invalid Modbus device entry.\n");
+      continue;
+    }
+
+    modbusDeviceConfig_t *cfg = &g_modbusDevices[g_modbusDeviceCount];
+    memset(cfg, 0, sizeof(modbusDeviceConfig_t));
+    snprintf(cfg->name, sizeof(cfg->name), "%s", name->valuestring);
+    snprintf(cfg->host, sizeof(cfg->host), "%s", host->valuestring);
+    cfg->port = cJSON_IsNumber(port) ? port->valueint : 502;
+    cfg->unitId = cJSON_IsNumber(unitId) ? (uint8_t)unitId->valueint : 1;
+    cfg->intervalMs = cJSON_IsNumber(interval) && interval->valueint > 0
+                          ? interval->valueint
+                          : 1000;
+
+    cJSON *point = NULL;
+    cJSON *points = cJSON_GetObjectItemCaseSensitive(entry, "points");
+    cJSON_ArrayForEach(point, points) {
+      if (cfg->pointCount >= MODBUS_MAX_POINTS ||
+          parseModbusPoint(point, &cfg->points[cfg->pointCount]) != 0) {
+        fprintf(stderr, "Warning: ignore invalid Modbus point of %s.\n",
+                cfg->name);
+        continue;
+      }
+      cfg->pointCount++;
+    }
+    if (cfg->pointCount > 0) {
+      g_modbusDeviceCount++;
+    }
+  }
+}
+
+/*
+ * @brief  解析单个串口配置，parity 为 none/even/odd，
+ *         framer 为 line/length/slip
+ *
+ * @return 0 成功
+ * */
+static int parseUartPort(const cJSON *entry, uartPortConfig_t *port) {
+  static const char *parities[] = {"none", "even", "odd"};
+  cJSON *name = cJSON_GetObjectItemCaseSensitive(entry, "name");
+  cJSON *device = cJSON_GetObjectItemCaseSensitive(entry, "device");
+  cJSON *sensorType = cJSON_GetObjectItemCaseSensitive(entry, "sensorType");
+  cJSON *framer = cJSON_GetObjectItemCaseSensitive(entry, "framer");
+  cJSON *parity = cJSON_GetObjectItemCaseSensitive(entry, "parity");
+  if (!cJSON_IsString(name) || !cJSON_IsString(device) ||
+      !cJSON_IsString(sensorType)) {
+    return -1;
+  }
+
+  memset(port, 0, sizeof(uartPortConfig_t));
+  snprintf(port->name, sizeof(port->name), "%s", name->valuestring);
+  snprintf(port->device, sizeof(port->device), "%s", device->valuestring);
+  snprintf(port->sensorType, sizeof(port->sensorType), "%s",
+           sensorType->valuestring);
+  snprintf(port->framer, sizeof(port->framer), "%s",
+           cJSON_IsString(framer) ? framer->valuestring : "line");
+  port->parity = UART_PARITY_NONE;
+  if (cJSON_IsString(parity)) {
+    int i = 0;
+    while (i < 3 && strcmp(parity->valuestring, parities[i]) != 0) {
+      i++;
+    }
+    if (i == 3) {
+      return -1;
+    }
+    port->parity = (uartParity_t)i;
+  }
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(entry, "baud");
+  port->baud = cJSON_IsNumber(item) ? item->valueint : 115200;
+  item = cJSON_GetObjectItemCaseSensitive(entry, "dataBits");
+  port->dataBits = cJSON_IsNumber(item) && item->valueint == 7 ? 7 : 8;
+  item = cJSON_GetObjectItemCaseSensitive(entry, "stopBits");
+  port->stopBits = cJSON_IsNumber(item) && item->valueint == 2 ? 2 : 1;
+  item = cJSON_GetObjectItemCaseSensitive(entry, "maxFrame");
+  port->maxFrame = cJSON_IsNumber(item) && item->valueint > 0
+                       ? item->valueint
+                       : 256;
+  // 环形缓冲大小向上取整到2的幂
+  item = cJSON_GetObjectItemCaseSensitive(entry, "ringBytes");
+  int ringBytes = cJSON_IsNumber(item) ? item->valueint : 1024;
+  port->ringBytes = 64;
+  while (port->ringBytes < ringBytes) {
+    port->ringBytes <<= 1;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(entry, "lengthBytes");
+  port->lengthBytes = cJSON_IsNumber(item) ? item->valueint : 1;
+  item = cJSON_GetObjectItemCaseSensitive(entry, "syncByte");
+  port->syncByte = cJSON_IsNumber(item) && item->valueint >= 0 &&
+                           item->valueint <= 0xff
+                       ? item->valueint
+                       : -1;
+  return 0;
+}
+
+/*
+ * @brief  解析串口接入配置（uartConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseUartConfig(const cJSON *config_Root) {
+  cJSON *config_uart =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "uartConfig");
+  if (config_uart == NULL || !cJSON_IsObject(config_uart)) {
+    return;
+  }
+
+  g_uartEnabled =
+      cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_uart, "enabled"));
+
+  cJSON *entry = NULL;
+  cJSON *ports = cJSON_GetObjectItemCaseSensitive(config_uart, "ports");
+  cJSON_ArrayForEach(entry, ports) {
+    if (g_uartPortCount >= UART_MAX_PORTS ||
+        parseUartPort(entry, &g_uartPorts[g_uartPortCount]) != 0) {
+      fprintf(stderr, "Warning: ignore invalid UART port entry.\n");
+      continue;
+    }
+    g_uartPortCount++;
+  }
+}
+
+/*
+ * @brief  解析单个数据源的自适应采样配置，缺省字段保留默认值
+ * */
+static void parseRateSourceConfig(const cJSON *config_source,
+                                  adaptiveRateConfig_t *config) {
+  static const struct {
+    const char *key;
+    size_t offset;
+  } fields[] = {
+      {"minHz", offsetof(adaptiveRateConfig_t, minHz)},
+      {"maxHz", offsetof(adaptiveRateConfig_t, maxHz)},
+      {"changeThreshold", offsetof(adaptiveRateConfig_t, changeThreshold)},
+      {"stdThreshold", offsetof(adaptiveRateConfig_t, stdThreshold)},
+      {"decay", offsetof(adaptiveRateConfig_t, decay)},
+  };
+  if (config_source == NULL || !cJSON_IsObject(config_source)) {
+    return;
+  }
+
+  for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+    cJSON *item =
+        cJSON_GetObjectItemCaseSensitive(config_source, fields[i].key);
+    if (item && cJSON_IsNumber(item)) {
+      *(double *)((char *)config + fields[i].offset) = item->valuedouble;
+    }
+  }
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_source, "window");
+  if (item && cJSON_IsNumber(item)) {
+    config->window = item->valueint;
+  }
+}
+
+/*
+ * @brief  解析自适应采样配置（adaptiveSampling，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseAdaptiveSamplingConfig(const cJSON *config_Root) {
+  double cpuBudgetPercent = 0;
+  cJSON *config_adaptive =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "adaptiveSampling");
+  if (config_adaptive && cJSON_IsObject(config_adaptive)) {
+    g_adaptiveEnabled = cJSON_IsTrue(
+        cJSON_GetObjectItemCaseSensitive(config_adaptive, "enabled"));
+
+    cJSON *item =
+        cJSON_GetObjectItemCaseSensitive(config_adaptive, "cpuBudgetPercent");
+    if (item && cJSON_IsNumber(item) && item->valuedouble >= 0) {
+      cpuBudgetPercent = item->valuedouble;
+    }
+
+    cJSON *sources =
+        cJSON_GetObjectItemCaseSensitive(config_adaptive, "sources");
+    parseRateSourceConfig(cJSON_GetObjectItemCaseSensitive(sources, "status"),
+                          &g_statusRateConfig);
+    parseRateSourceConfig(cJSON_GetObjectItemCaseSensitive(sources, "light"),
+                          &g_lightRateConfig);
+  }
+  adaptiveRate_BudgetInit(&g_rateBudget, cpuBudgetPercent);
+}
+
+/*
+ * @brief  初始化采样率控制器。未启用或配置无效时固定1Hz
+ * */
+static void initSampleRates(void) {
+  static const adaptiveRateConfig_t fixed = {
+      .minHz = 1, .maxHz = 1, .window = 2, .decay = 1};
+
+  if (!g_adaptiveEnabled ||
+      adaptiveRate_Init(&g_statusRate, &g_statusRateConfig, &g_rateBudget) !=
+          0 ||
+      adaptiveRate_Init(&g_lightRate, &g_lightRateConfig, &g_rateBudget) !=
+          0) {
+    g_adaptiveEnabled = false;
+    adaptiveRate_Init(&g_statusRate, &fixed, NULL);
+    adaptiveRate_Init(&g_lightRate, &fixed, NULL);
+  }
+}
+
+/*
+ * @brief  解析本地读取接口配置（localApiConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseLocalApiConfig(const cJSON *config_Root) {
+  cJSON *config_api =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "localApiConfig");
+  if (config_api == NULL || !cJSON_IsObject(config_api)) {
+    return;
+  }
+
+  g_localApiEnabled =
+      cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_api, "enabled"));
+
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_api, "socketPath");
+  if (item && cJSON_IsString(item)) {
+    snprintf(g_localApiConfig.socketPath, sizeof(g_localApiConfig.socketPath),
+             "%s", item->valuestring);
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(config_api, "maxClients");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_localApiConfig.maxClients = item->valueint;
+  }
+
+  // 共享内存名称为空时不导出共享内存
+  item = cJSON_GetObjectItemCaseSensitive(config_api, "sharedMemory");
+  if (item && cJSON_IsString(item)) {
+    snprintf(g_valueShmName, sizeof(g_valueShmName), "%s", item->valuestring);
+  }
+}
+
+/*
+ * @brief  解析TLS配置（mqttClientConfig.tls，可选）。需要在内存池初始化之后调用
+ *
+ * @param  config_mqttClient: mqttClientConfig 对象
+ * */
+static void parseTlsConfig(const cJSON *config_mqttClient) {
+  const cJSON *config_tls =
+      cJSON_GetObjectItemCaseSensitive(config_mqttClient, "tls");
+  if (config_tls == NULL || !cJSON_IsObject(config_tls)) {
+    return;
+  }
+
+  mqttTlsConfig_t *tls = &g_mqttConfig.tls;
+  tls->enabled =
+      cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_tls, "enabled"));
+  // 默认校验服务端证书和主机名
+  tls->verifyServer = !cJSON_IsFalse(
+      cJSON_GetObjectItemCaseSensitive(config_tls, "verifyServer"));
+  tls->verifyHostname = !cJSON_IsFalse(
+      cJSON_GetObjectItemCaseSensitive(config_tls, "verifyHostname"));
 
-/* 回调函数 */
-void mqttCommandHandle(const char *topic, const char *payload, int payloadLen,
-                       void *userData) {
-  fprintf(stdout, "Receice command.\n");
+  static const struct {
+    const char *key;
+    size_t offset;
+  } strings[] = {
+      {"caFile", offsetof(mqttTlsConfig_t, caFile)},
+      {"caPath", offsetof(mqttTlsConfig_t, caPath)},
+      {"certFile", offsetof(mqttTlsConfig_t, certFile)},
+      {"keyFile", offsetof(mqttTlsConfig_t, keyFile)},
+      {"keyPassword", offsetof(mqttTlsConfig_t, keyPassword)},
+      {"ciphers", offsetof(mqttTlsConfig_t, ciphers)},
+      {"pskIdentity", offsetof(mqttTlsConfig_t, pskIdentity)},
+      {"pskKey", offsetof(mqttTlsConfig_t, pskKey)},
+  };
+  for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++) {
+    cJSON *item = cJSON_GetObjectItemCaseSensitive(config_tls, strings[i].key);
+    // 空字符串视为未配置
+    if (item && cJSON_IsString(item) && item->valuestring[0] != '\0') {
+      *(char **)((char *)tls + strings[i].offset) =
+          memPool_Strdup(item->valuestring);
+    }
+  }
 }
 
-void mqttConnectionStatusHandle(bool isConnected, void *userData) {
-  if (isConnected) {
-    fprintf(stdout, "Client is connected.\n");
-  } else {
-    fprintf(stdout, "Connect error.\n");
+/*
+ * @brief  解析MQTT协议版本相关配置（mqttVersion、topicAliasMax、
+ *         messageExpirySec，均可选）
+ *
+ * @param  config_mqttClient: mqttClientConfig 对象
+ * */
+static void parseMqtt5Config(const cJSON *config_mqttClient) {
+  cJSON *item =
+      cJSON_GetObjectItemCaseSensitive(config_mqttClient, "mqttVersion");
+  if (item && cJSON_IsNumber(item)) {
+    g_mqttConfig.mqttVersion = item->valueint;
   }
-}
 
-/* 子线程函数 */
-// 信号处理函数
-void signalHandle(int signum) {
-  if (signum == SIGINT || signum == SIGTERM) {
-    g_exitFlag = true;
+  item = cJSON_GetObjectItemCaseSensitive(config_mqttClient, "topicAliasMax");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_mqttConfig.topicAliasMax = item->valueint;
+  }
+
+  // 过期时间对3.1.1同样有效：断线期间在发送队列中过期的消息不再发出
+  item =
+      cJSON_GetObjectItemCaseSensitive(config_mqttClient, "messageExpirySec");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    g_jsonPublishOptions.messageExpirySec = item->valueint;
+    g_packedPublishOptions.messageExpirySec = item->valueint;
   }
 }
 
-// 设备状态采集和发送线程
-void *deviceStatusThreadFunc(void *arg) {
-  while (!g_exitFlag) {
-    sleep(1);
-    // usleep(1000 * 10); // 数据刷新率：100Hz
+/*
+ * @brief  解析多Broker配置（mqttClientConfig 中的 brokers 等字段，可选）。
+ *         未配置 brokers 时只使用 brokerAddress。需要在内存池初始化之后调用
+ *
+ * @param  config_mqttClient: mqttClientConfig 对象
+ * */
+static void parseBrokerGroupConfig(const cJSON *config_mqttClient) {
+  const cJSON *brokers =
+      cJSON_GetObjectItemCaseSensitive(config_mqttClient, "brokers");
+  const cJSON *broker = NULL;
+  cJSON_ArrayForEach(broker, brokers) {
+    if (g_brokerConfig.brokerCount >= BROKER_GROUP_MAX) {
+      fprintf(stderr, "Warning: only %d brokers supported.\n",
+              BROKER_GROUP_MAX);
+      break;
+    }
+    if (cJSON_IsString(broker)) {
+      g_brokerConfig.brokerAddresses[g_brokerConfig.brokerCount++] =
+          memPool_Strdup(broker->valuestring);
+    }
+  }
+  if (g_brokerConfig.brokerCount == 0 && my_BrokerAddress) {
+    g_brokerConfig.brokerAddresses[g_brokerConfig.brokerCount++] =
+        my_BrokerAddress;
+  }
 
-    // 检查MQTT是否连接
-    if (!g_mqttContex.isConnected) {
-      fprintf(stderr, "MQTT Client does not connected.\n");
-      continue;
+  cJSON *item =
+      cJSON_GetObjectItemCaseSensitive(config_mqttClient, "brokerMode");
+  if (item && cJSON_IsString(item)) {
+    int mode = brokerGroup_ParseMode(item->valuestring);
+    if (mode < 0) {
+      fprintf(stderr, "Warning: unknown brokerMode '%s', using failover.\n",
+              item->valuestring);
+    } else {
+      g_brokerConfig.mode = (brokerMode_t)mode;
     }
+  }
 
-    // 开始采集设备状态
-    float cpuTemp = getCpuTemperature();
-    float memUsage = getMemUsage();
-    double cpuLoad = getCpuLoad();
+  item = cJSON_GetObjectItemCaseSensitive(config_mqttClient, "probeIntervalMs");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_brokerConfig.probeIntervalMs = item->valueint;
+  }
 
-    // 设置消息载荷
-    char deviceStatusPaylod[256];
-    snprintf(deviceStatusPaylod, sizeof(deviceStatusPaylod),
-             "{\"timestamp_ms\": %ld,\"cpu_temp_c\": %lf,\"cpu_load\": "
-             "%f,\"mem_usage_percent\": %f}",
-             (long)time(NULL), cpuTemp, cpuLoad, memUsage);
+  item = cJSON_GetObjectItemCaseSensitive(config_mqttClient, "probeTimeoutMs");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_brokerConfig.probeTimeoutMs = item->valueint;
+  }
 
-    // 设置消息话题
-    char deviceStatusTopic[256];
-    snprintf(deviceStatusTopic, sizeof(deviceStatusTopic), "sentinel/%s/status",
-             g_mqttConfig.clientID);
+  item = cJSON_GetObjectItemCaseSensitive(config_mqttClient, "switchTimeoutMs");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_brokerConfig.switchTimeoutMs = item->valueint;
+  }
 
-    // 发布消息
-    int rc =
-        mqttClient_Publish(&g_mqttContex, deviceStatusTopic, deviceStatusPaylod,
-                           strlen(deviceStatusPaylod), 0, true);
-    if (rc != 0) {
-      fprintf(stderr, "Failed publish device status.\n");
+  item = cJSON_GetObjectItemCaseSensitive(config_mqttClient, "queueDepth");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_brokerConfig.queueDepth = item->valueint;
+  }
+
+  // 各优先级的队列长度和限速，以及数据源权重
+  cJSON *config_outbound =
+      cJSON_GetObjectItemCaseSensitive(config_mqttClient, "outbound");
+  for (int i = 0; config_outbound && i < BROKER_CLASS_COUNT; i++) {
+    cJSON *config_class = cJSON_GetObjectItemCaseSensitive(
+        config_outbound, brokerGroup_ClassName((brokerClass_t)i));
+    brokerClassConfig_t *cls = &g_brokerConfig.classes[i];
+    item = cJSON_GetObjectItemCaseSensitive(config_class, "depth");
+    if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+      cls->depth = item->valueint;
+    }
+    item = cJSON_GetObjectItemCaseSensitive(config_class, "ratePerSec");
+    if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+      cls->ratePerSec = item->valueint;
+    }
+    item = cJSON_GetObjectItemCaseSensitive(config_class, "burst");
+    if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+      cls->burst = item->valueint;
+    }
+  }
+  cJSON *weights = cJSON_GetObjectItemCaseSensitive(config_outbound, "weights");
+  for (int i = 0; weights && i < SOURCE_COUNT; i++) {
+    item = cJSON_GetObjectItemCaseSensitive(weights, g_sources[i].name);
+    if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+      g_sources[i].weight = item->valueint;
     }
   }
 
-  return NULL;
+  item =
+      cJSON_GetObjectItemCaseSensitive(config_mqttClient, "connectTimeoutSec");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_mqttConfig.connectTimeoutSec = item->valueint;
+  }
 }
 
-/* 环境光传感器数据发布线程 */
-void *lightSensorThreadFunc(void *arg) {
-  char *sensorType = "light_sensor";
+/*
+ * @brief  解析历史存储配置（historyConfig，可选）
+ *
+ * @param  config_Root: 配置文件JSON根对象
+ * */
+static void parseHistoryConfig(const cJSON *config_Root) {
+  cJSON *config_history =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "historyConfig");
+  if (config_history == NULL || !cJSON_IsObject(config_history)) {
+    return;
+  }
 
-  while (!g_exitFlag) {
-    sleep(1);
-    // usleep(1000 * 1000);
+  g_historyEnabled =
+      cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_history, "enabled"));
 
-    // 检查MQTT是否连接
-    if (!g_mqttContex.isConnected) {
-      fprintf(stderr, "MQTT Client does not connected.\n");
-      continue;
-    }
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_history, "path");
+  if (item && cJSON_IsString(item)) {
+    snprintf(g_historyConfig.path, sizeof(g_historyConfig.path), "%s",
+             item->valuestring);
+  }
 
-    // 采集数据
-    int als = getAlsData();
-    int ps = getPsData();
-    int ir = getIrData();
+  item = cJSON_GetObjectItemCaseSensitive(config_history, "blockBytes");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_historyConfig.blockBytes = item->valueint;
+  }
 
-    // 构建payload
-    char lightSensorPayload[256];
-    snprintf(lightSensorPayload, sizeof(lightSensorPayload),
-             "{\"timestamp_ms\": %ld,\"light_lux\": %d,\"infrared_cd\": %d, "
-             "\"sensor_id\": %s}",
-             (long)time(NULL), als, ir, sensorType);
-
-    // 构建topic
-    char lightSensorTopic[256];
-    snprintf(lightSensorTopic, sizeof(lightSensorTopic), "sentinel/%s/light",
-             g_mqttConfig.clientID);
-
-    int rc =
-        mqttClient_Publish(&g_mqttContex, lightSensorTopic, lightSensorPayload,
-                           strlen(lightSensorPayload), 0, true);
-    if (rc != 0) {
-      fprintf(stderr, "Fialed to publish light senser data.\n");
-    }
+  // 总容量按MB配置，换算为块数量
+  item = cJSON_GetObjectItemCaseSensitive(config_history, "sizeMB");
+  if (item && cJSON_IsNumber(item) && item->valuedouble > 0) {
+    g_historyConfig.blockCount =
+        (uint32_t)(item->valuedouble * 1024 * 1024 / g_historyConfig.blockBytes);
   }
-  return NULL;
 }
 
 /*
- * @brief:  从.json文件读取内容并返回
- *
- * @param:  filename: 文件的储存路径字符串
+ * @brief  解析IIO采集配置（iioConfig，可选）
  *
- * @return: char *: 字符串，存储.json文件内容
+ * @param  config_Root: 配置文件JSON根对象
  * */
-char *readFileToString(const char *filename) {
-  FILE *fp = NULL;
-  long fileSize = 0;
-  char *buffer = NULL;
-  size_t readLen = 0;
+static void parseIioConfig(const cJSON *config_Root) {
+  cJSON *config_iio = cJSON_GetObjectItemCaseSensitive(config_Root, "iioConfig");
+  if (config_iio == NULL || !cJSON_IsObject(config_iio) ||
+      !cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_iio, "enabled"))) {
+    return;
+  }
 
-  fp = fopen(filename, "r");
-  if (fp == NULL) {
-    fprintf(stderr, "Error: Could not open file %s\n", filename);
-    return NULL;
+  const char *strings[] = {"sysfsRoot", "devRoot", "device", "trigger"};
+  char *targets[] = {g_iioConfig.sysfsRoot, g_iioConfig.devRoot,
+                     g_iioConfig.device, g_iioConfig.trigger};
+  size_t sizes[] = {sizeof(g_iioConfig.sysfsRoot), sizeof(g_iioConfig.devRoot),
+                    sizeof(g_iioConfig.device), sizeof(g_iioConfig.trigger)};
+  for (int i = 0; i < 4; i++) {
+    cJSON *item = cJSON_GetObjectItemCaseSensitive(config_iio, strings[i]);
+    if (item && cJSON_IsString(item)) {
+      snprintf(targets[i], sizes[i], "%s", item->valuestring);
+    }
   }
 
-  // 获取文件大小
-  fseek(fp, 0, SEEK_END); // 重置光标到文件结束位置
-  fileSize = ftell(fp);   // 获取当前光标位置
-  rewind(fp);             // 重置光标到文家开头
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_iio, "bufferLength");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_iioConfig.bufferLength = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_iio, "watermark");
+  if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+    g_iioConfig.watermark = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_iio, "timestamp");
+  if (item && cJSON_IsBool(item)) {
+    g_iioConfig.timestamp = cJSON_IsTrue(item);
+  }
 
-  // 分配内存
-  buffer = (char *)malloc(sizeof(char) * (fileSize + 1)); // +1 for "\0"
-  if (buffer == NULL) {
-    fprintf(stderr, "Error: Memoy allocation failed for file buffer. \n");
-    fclose(fp);
-    return NULL;
+  cJSON *channel = NULL;
+  cJSON_ArrayForEach(channel,
+                     cJSON_GetObjectItemCaseSensitive(config_iio, "channels")) {
+    cJSON *element = cJSON_GetObjectItemCaseSensitive(channel, "element");
+    cJSON *field = cJSON_GetObjectItemCaseSensitive(channel, "field");
+    if (!cJSON_IsString(element) || !cJSON_IsString(field) ||
+        g_iioConfig.channelCount >= IIO_MAX_CHANNELS) {
+      fprintf(stderr, "Warning: ignore invalid IIO channel entry.\n");
+      continue;
+    }
+
+    int index = g_iioConfig.channelCount++;
+    iioChannelConfig_t *ch = &g_iioConfig.channels[index];
+    snprintf(ch->element, sizeof(ch->element), "%s", element->valuestring);
+    snprintf(ch->field, sizeof(ch->field), "%s", field->valuestring);
+    g_iioFieldSlots[index] = -1;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+      if (strcmp(g_fieldNames[f], ch->field) == 0) {
+        g_iioFieldSlots[index] = f;
+      }
+    }
   }
+  g_iioEnabled = g_iioConfig.channelCount > 0;
+}
 
-  // 读取文件内容
-  readLen = fread(buffer, 1, fileSize, fp);
-  if (readLen != fileSize) {
-    fprintf(
-        stderr,
-        "Error: Failed to read entire file %s. Read %zu bytes, expected %ld.\n",
-        filename, readLen, fileSize);
-    free(buffer);
-    fclose(fp);
-    return NULL;
+/*
+ * @brief  在内存池中构建 "sentinel/{clientID}/{suffix}" 格式的Topic，
+ *         并登记为网关自身的Topic
+ *
+ * @return char *: Topic字符串，失败返回NULL
+ * */
+static char *buildDeviceTopic(const char *suffix) {
+  char *topic = (char *)memPool_Alloc(g_memConfig.maxTopicLen);
+  if (topic) {
+    snprintf(topic, g_memConfig.maxTopicLen, "sentinel/%s/%s",
+             g_mqttConfig.clientID, suffix);
+    if (g_deviceTopicCount < DEVICE_TOPIC_MAX) {
+      g_deviceTopics[g_deviceTopicCount++] = topic;
+    } else {
+      fprintf(stderr, "Too many device topics, %s not reserved.\n", topic);
+    }
   }
+  return topic;
+}
 
-  buffer[fileSize] = '\0';
-  fclose(fp);
-  return buffer;
+/*
+ * @brief  进入仿真模式：虚拟时钟先于所有工作线程启动；依赖真实硬件、
+ *         真实时间或对外监听的功能不启用
+ *
+ * @return 0 成功
+ * */
+static int startSimulation(void) {
+  g_pwmConfig.channelCount = 0;
+  g_gpioLineCount = 0;
+  g_iioEnabled = false;
+  g_historyEnabled = false;
+  g_localApiEnabled = false;
+  g_valueShmName[0] = '\0';
+  g_otaEnabled = false;
+  g_tcpIngestEnabled = false;
+  g_wsEnabled = false;
+  g_snapshotConfig.enabled = false; // 报告只由配置和种子决定
+  g_modbusEnabled = false;
+  g_uartEnabled = false;
+  g_watchdogEnabled = false;
+  g_rateBudget.cpuLimitPercent = 0; // 进程CPU占用与虚拟时间无关
+  g_perfMetricsIntervalSec = 0;
+
+  return sim_Init(&g_simConfig);
 }
 
 int main(int argc, char *argv[]) {
+  gatewayState_StartupBegin();
+
   // 打开json文件
   char *config_JsonString = readFileToString("./config/sentinel_config.json");
   if (config_JsonString == NULL) {
@@ -216,10 +3048,52 @@ int main(int argc, char *argv[]) {
     free(config_JsonString);
     return EXIT_FAILURE;
   }
+  // 内存池必须先于其他配置字段的复制初始化
+  parseMemoryConfig(config_Root);
+  parseCompressionConfig(config_Root);
+  parsePwmConfig(config_Root);
+  parseGpioInputConfig(config_Root);
+  parseIioConfig(config_Root);
+  parseHistoryConfig(config_Root);
+  parseLocalApiConfig(config_Root);
+  parseAdaptiveSamplingConfig(config_Root);
+  parseDiagnosticsConfig(config_Root);
+  parseLoggerConfig(config_Root);
+  parseCommandConfig(config_Root);
+  parseOtaConfig(config_Root);
+  parseTcpIngestConfig(config_Root);
+  parseWebSocketConfig(config_Root);
+  parseSnapshotConfig(config_Root);
+  parseModbusConfig(config_Root);
+  parseUartConfig(config_Root);
+  // 仿真配置可选，命令行 --simulate 也可以启用
+  sim_ParseConfig(
+      cJSON_GetObjectItemCaseSensitive(config_Root, "simulationConfig"),
+      &g_simConfig);
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--simulate") == 0) {
+      g_simConfig.enabled = true;
+    }
+  }
+  if (memPool_Init(&g_memConfig) != 0) {
+    cJSON_Delete(config_Root);
+    free(config_JsonString);
+    return EXIT_FAILURE;
+  }
+  // 线程缓冲从内存池预分配，失败时日志同步输出到stderr
+  if (logger_Init(&g_loggerConfig) != 0) {
+    fprintf(stderr, "Logger initial failed, logging to stderr.\n");
+  }
+  if (g_simConfig.enabled && startSimulation() != 0) {
+    cJSON_Delete(config_Root);
+    free(config_JsonString);
+    return EXIT_FAILURE;
+  }
+
   cJSON *item = NULL;
   item = cJSON_GetObjectItemCaseSensitive(config_mqttClient, "brokerAddress");
   if (item && cJSON_IsString(item)) {
-    my_BrokerAddress = strdup(item->valuestring);
+    my_BrokerAddress = memPool_Strdup(item->valuestring);
   } else {
     fprintf(
         stderr,
@@ -228,7 +3102,7 @@ int main(int argc, char *argv[]) {
 
   item = cJSON_GetObjectItemCaseSensitive(config_mqttClient, "clientID");
   if (item && cJSON_IsString(item)) {
-    my_ClienID = strdup(item->valuestring);
+    my_ClienID = memPool_Strdup(item->valuestring);
   } else {
     fprintf(stderr, "Warning: 'clientID' not found or not a string. Using "
                     "default/empty.\n");
@@ -236,7 +3110,7 @@ int main(int argc, char *argv[]) {
 
   item = cJSON_GetObjectItemCaseSensitive(config_mqttClient, "username");
   if (item && cJSON_IsString(item)) {
-    my_Username = strdup(item->valuestring);
+    my_Username = memPool_Strdup(item->valuestring);
   } else {
     fprintf(stderr, "Warning: 'username' not found or not a string. Using "
                     "default/empty.\n");
@@ -244,7 +3118,7 @@ int main(int argc, char *argv[]) {
 
   item = cJSON_GetObjectItemCaseSensitive(config_mqttClient, "password");
   if (item && cJSON_IsString(item)) {
-    my_Password = strdup(item->valuestring);
+    my_Password = memPool_Strdup(item->valuestring);
   } else {
     fprintf(stderr, "Warning: 'password' not found or not a string. Using "
                     "default/empty.\n");
@@ -276,6 +3150,94 @@ int main(int argc, char *argv[]) {
     fprintf(stderr, "Warning: 'maxReconnectAttempts' not found or not a "
                     "number. Using default/0.\n");
   }
+  parseBrokerGroupConfig(config_mqttClient);
+  parseTlsConfig(config_mqttClient);
+  parseMqtt5Config(config_mqttClient);
+  gatewayState_PhaseDone("config");
+
+  // 编译本地规则（可选）
+  cJSON *config_rules =
+      cJSON_GetObjectItemCaseSensitive(config_Root, "ruleEngineConfig");
+  if (ruleEngine_Init(&g_ruleEngine, cJSON_GetObjectItemCaseSensitive(
+                                         config_rules, "rules")) != 0) {
+    fprintf(stderr, "Error: invalid 'ruleEngineConfig'.\n");
+    cJSON_Delete(config_Root);
+    free(config_JsonString);
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    g_fieldIds[i] = ruleEngine_FieldId(&g_ruleEngine, g_fieldNames[i]);
+  }
+  for (int i = 0; i < g_gpioLineCount; i++) {
+    char fieldName[48];
+    snprintf(fieldName, sizeof(fieldName), "gpio.%s", g_gpioLines[i].name);
+    g_gpioFieldIds[i] = ruleEngine_FieldId(&g_ruleEngine, fieldName);
+  }
+  ruleEngine_SetActionCallback(&g_ruleEngine, ruleActionHandle, NULL);
+
+  // 处理函数在启动完成后才会被调用，所有target在这里一次注册
+  for (size_t i = 0; i < sizeof(g_commandTargets) / sizeof(g_commandTargets[0]);
+       i++) {
+    if (commandDispatch_Register(g_commandTargets[i].target,
+                                 g_commandTargets[i].handler, NULL) != 0) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  // 打开历史存储并登记每个字段的序列（失败时只关闭历史功能）
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    g_historyIds[i] = -1;
+  }
+  for (int i = 0; i < GPIO_MAX_LINES; i++) {
+    g_gpioHistoryIds[i] = -1;
+  }
+  if (g_historyEnabled &&
+      historyStore_Open(&g_historyStore, &g_historyConfig) != 0) {
+    fprintf(stderr, "History store initial failed.\n");
+    g_historyEnabled = false;
+  }
+  if (g_historyEnabled) {
+    for (int i = 0; i < FIELD_COUNT; i++) {
+      g_historyIds[i] = historyStore_SeriesId(&g_historyStore, g_fieldNames[i]);
+    }
+    for (int i = 0; i < g_gpioLineCount; i++) {
+      char seriesName[48];
+      snprintf(seriesName, sizeof(seriesName), "gpio.%s", g_gpioLines[i].name);
+      g_gpioHistoryIds[i] = historyStore_SeriesId(&g_historyStore, seriesName);
+    }
+  }
+
+  // 静态内存模式下分片（含头）必须放得下预分配的接收缓冲区
+  if (g_memConfig.staticMode &&
+      g_otaConfig.maxChunkBytes + OTA_CHUNK_HEADER >=
+          (uint32_t)g_memConfig.maxPayloadBytes) {
+    g_otaConfig.maxChunkBytes =
+        g_memConfig.maxPayloadBytes - OTA_CHUNK_HEADER - 1;
+  }
+  if (g_otaEnabled &&
+      otaUpdate_Init(&g_ota, &g_otaConfig, otaProgressHandle, NULL) != 0) {
+    fprintf(stderr, "OTA initial failed.\n");
+    g_otaEnabled = false;
+  }
+
+  // 最新值表：共享内存创建失败时退回进程内表
+  if (valueTable_Init(&g_valueTable, VALUE_TABLE_CAPACITY, g_valueShmName) !=
+          0 &&
+      valueTable_Init(&g_valueTable, VALUE_TABLE_CAPACITY, NULL) != 0) {
+    fprintf(stderr, "Value table initial failed.\n");
+    cJSON_Delete(config_Root);
+    free(config_JsonString);
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    g_valueIds[i] = valueTable_Register(&g_valueTable, g_fieldNames[i]);
+  }
+  for (int i = 0; i < g_gpioLineCount; i++) {
+    char valueName[48];
+    snprintf(valueName, sizeof(valueName), "gpio.%s", g_gpioLines[i].name);
+    g_gpioValueIds[i] = valueTable_Register(&g_valueTable, valueName);
+  }
+  g_connectedValueId = valueTable_Register(&g_valueTable, "mqtt.connected");
 
   // 清理资源：释放cJSON对象和从文件读取的字符串
   cJSON_Delete(config_Root);
@@ -289,12 +3251,104 @@ int main(int argc, char *argv[]) {
   g_mqttConfig.keepAliveInterval = my_keepAliveInterval;
   g_mqttConfig.reconnectDelaySec = my_reconnectDelaySec;
   g_mqttConfig.maxReconnectAttempts = my_maxReconnectAttempts;
+  g_mqttConfig.logger = logger_Callback;
+  g_mqttConfig.simulated = g_simConfig.enabled;
+  if (g_memConfig.staticMode) {
+    g_mqttConfig.maxPayloadBytes = g_memConfig.maxPayloadBytes;
+    g_mqttConfig.maxTopicLen = g_memConfig.maxTopicLen;
+  }
+
+  // 命令解析arena和cJSON钩子
+  memPool_InstallCJSONHooks();
+  for (int i = 0; i < g_brokerConfig.brokerCount; i++) {
+    if (memArena_Init(&g_commandArenas[i], g_memConfig.commandArenaBytes) !=
+        0) {
+      fprintf(stderr, "Command arena initial failed.\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (g_codecConfig.enabled &&
+      payloadCodec_Init(&g_payloadCodec, &g_codecConfig) != 0) {
+    fprintf(stderr, "Payload codec initial failed.\n");
+    return EXIT_FAILURE;
+  }
+
+  // 事件循环和执行器模块，TCP接入的每个连接各占一个槽位
+  int loopFds = EVENT_LOOP_MAX_FDS;
+  if (g_tcpIngestEnabled) {
+    loopFds += g_tcpIngestConfig.maxClients + 2;
+  }
+  if (g_wsEnabled) {
+    loopFds += g_wsConfig.maxClients + 2; // 监听套接字和唤醒用的eventfd
+  }
+  if (g_modbusEnabled) {
+    loopFds += g_modbusDeviceCount * 2; // 轮询定时器和连接
+  }
+  if (g_uartEnabled) {
+    loopFds += g_uartPortCount + 1; // 端口和重新打开的定时器
+  }
+  if (eventLoop_Init(&g_eventLoop, loopFds) != 0) {
+    fprintf(stderr, "Event loop initial failed.\n");
+    return EXIT_FAILURE;
+  }
+  initSampleRates();
+  if (g_watchdogEnabled &&
+      watchdog_Init(&g_watchdogConfig, &g_eventLoop) != 0) {
+    fprintf(stderr, "Watchdog initial failed.\n");
+    g_watchdogEnabled = false;
+  }
+  g_deviceStatusTopic = buildDeviceTopic("status");
+  g_lightSensorTopic = buildDeviceTopic("light");
+  g_responseTopic = buildDeviceTopic("response");
+  g_gpioTopic = buildDeviceTopic("gpio");
+  if (!g_deviceStatusTopic || !g_lightSensorTopic || !g_responseTopic ||
+      !g_gpioTopic) {
+    fprintf(stderr, "Topic buffers initial failed.\n");
+    return EXIT_FAILURE;
+  }
+
+  gatewayState_PhaseDone("core");
 
-  if (mqttClient_Init(&g_mqttContex, &g_mqttConfig) != 0) {
+  // 先启动Broker连接，连接（含TLS握手）与外设初始化并行进行
+  // 发送队列槽位需要容纳最大的响应载荷
+  g_brokerConfig.queueSlotBytes =
+      g_memConfig.maxTopicLen + RESPONSE_PAYLOAD_MAX;
+  if (brokerGroup_Init(&g_brokerGroup, &g_brokerConfig, &g_mqttConfig) != 0) {
     fprintf(stderr, "Client initial failed.\n");
     return EXIT_FAILURE;
   }
+  for (int i = 0; i < SOURCE_COUNT; i++) {
+    g_sourceIds[i] =
+        brokerGroup_AddSource(&g_brokerGroup, g_sources[i].name,
+                              g_sources[i].cls, g_sources[i].weight,
+                              g_sources[i].coalesce);
+    if (g_sourceIds[i] < 0) {
+      fprintf(stderr, "Outbound source %s initial failed.\n",
+              g_sources[i].name);
+      g_sourceIds[i] = BROKER_SOURCE_DEFAULT;
+    }
+  }
+
+  // OTA分片与控制命令走同一个回调，按Topic区分
+  if (g_otaEnabled) {
+    g_otaTopic = (char *)memPool_Alloc(g_memConfig.maxTopicLen);
+    if (g_otaTopic) {
+      snprintf(g_otaTopic, g_memConfig.maxTopicLen, "app/%s/ota",
+               g_mqttConfig.clientID);
+    }
+    if (!g_otaTopic ||
+        brokerGroup_AddSubscription(&g_brokerGroup, g_otaTopic, 1) != 0) {
+      fprintf(stderr, "OTA topic subscription failed.\n");
+    }
+  }
 
+  // 命令在工作线程上执行，需在连接Broker（开始接收命令）之前启动；
+  // 启动完成前收到的命令在接收线程上等待（见 gatewayState_WaitReady）
+  if (commandExecutor_Init(&g_commandConfig, commandDoneHandle, NULL) != 0) {
+    fprintf(stderr, "Command executor initial failed.\n");
+    return EXIT_FAILURE;
+  }
   // 设置遗嘱消息
   char lwtTopic[256];
   char lwtPayload[256];
@@ -302,40 +3356,263 @@ int main(int argc, char *argv[]) {
            g_mqttConfig.clientID);
   snprintf(lwtPayload, sizeof(lwtPayload),
            "\"status\": \"online\",\"timestamp_ms\": %ld",
-           (long)time(NULL) * 1000);
-  mqttClient_SetLWT(&g_mqttContex, lwtTopic, lwtPayload, 1);
+           (long)realtimeMs());
+  brokerGroup_SetLWT(&g_brokerGroup, lwtTopic, lwtPayload, 1);
 
   // 注册回调函数
-  mqttClient_RegisterCommandCallback(&g_mqttContex, mqttCommandHandle, NULL);
-  mqttClient_RegisterConnectionStatusCallback(&g_mqttContex,
-                                              mqttConnectionStatusHandle, NULL);
+  for (int i = 0; i < g_brokerConfig.brokerCount; i++) {
+    brokerGroup_RegisterLinkCommandCallback(&g_brokerGroup, i,
+                                            mqttCommandHandle,
+                                            &g_commandArenas[i]);
+  }
+  brokerGroup_RegisterConnectionStatusCallback(
+      &g_brokerGroup, mqttConnectionStatusHandle, NULL);
+
+  gatewayState_PhaseDone("broker");
+
+  // 恢复上次退出前的计数器、CPU负载基线和积压的消息，连上后最先发出
+  gatewayState_Init(&g_snapshotConfig, &g_snapshotVisitor);
+  gatewayState_PhaseDone("restore");
+
+  if (brokerGroup_Start(&g_brokerGroup) != 0) {
+    fprintf(stderr, "Client start failed.\n");
+    return EXIT_FAILURE;
+  }
+  gatewayState_PhaseDone("connect");
+
+  if (g_adaptiveEnabled && g_rateBudget.cpuLimitPercent > 0) {
+    int budgetTimerFd =
+        eventLoop_AddTimer(&g_eventLoop, rateBudgetTimerHandle, NULL);
+    if (budgetTimerFd < 0 ||
+        eventLoop_ArmTimer(budgetTimerFd, 1000000000ULL, 1000000000ULL) != 0) {
+      fprintf(stderr, "CPU budget timer initial failed.\n");
+    }
+  }
+  if (g_pwmConfig.channelCount > 0 &&
+      pwmLed_Init(&g_pwmConfig, &g_eventLoop) != 0) {
+    fprintf(stderr, "PWM LED initial failed.\n");
+  }
+
+  if (g_localApiEnabled &&
+      localApi_Init(&g_localApiConfig, &g_eventLoop, &g_valueTable) != 0) {
+    fprintf(stderr, "Local API initial failed.\n");
+  }
+
+  // IIO不可用时回退到sysfs逐值读取
+  if (g_iioEnabled &&
+      iioCapture_Init(&g_iioConfig, &g_eventLoop, iioSampleHandle, NULL) != 0) {
+    fprintf(stderr, "IIO capture initial failed, using sysfs polling.\n");
+    g_iioEnabled = false;
+  }
+
+  pthread_condattr_t condAttr;
+  pthread_condattr_init(&condAttr);
+  pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+  pthread_cond_init(&g_lightWakeCond, &condAttr);
+  pthread_condattr_destroy(&condAttr);
+
+  if (gpioInput_Init(&g_eventLoop, gpioInputEventHandle, NULL) != 0) {
+    fprintf(stderr, "GPIO input initial failed.\n");
+  } else {
+    // 单条线申请失败（如设备树未导出）不影响其他功能
+    for (int i = 0; i < g_gpioLineCount; i++) {
+      gpioInput_AddLine(&g_gpioLines[i]);
+    }
+  }
+
+  // TCP接入需要发布通道，在Broker组之后启动
+  if (g_tcpIngestEnabled &&
+      tcpIngest_Init(&g_tcpIngestConfig, &g_eventLoop, tcpIngestForwardHandle,
+                     NULL) != 0) {
+    fprintf(stderr, "TCP ingest initial failed.\n");
+    g_tcpIngestEnabled = false;
+  }
+
+  // 实时流的数据源与发送数据源一一对应，不推送的数据源不登记
+  for (int i = 0; i < SOURCE_COUNT; i++) {
+    g_liveIds[i] = -1;
+  }
+  if (g_wsEnabled) {
+    for (int i = 0; i < SOURCE_COUNT; i++) {
+      if (g_sources[i].live) {
+        g_liveIds[i] = wsServer_RegisterSource(g_sources[i].name);
+      }
+    }
+    if (wsServer_Init(&g_wsConfig, &g_eventLoop) != 0) {
+      fprintf(stderr, "Live stream server initial failed.\n");
+      g_wsEnabled = false;
+    }
+  }
+
+  // 连接不上的设备在每个轮询周期重试，不影响其他设备
+  if (g_modbusEnabled && g_modbusDeviceCount > 0) {
+    g_modbusConfig.maxDevices = g_modbusDeviceCount;
+    g_modbusTopic = buildDeviceTopic("modbus");
+    if (!g_modbusTopic ||
+        modbusPoller_Init(&g_modbusConfig, &g_eventLoop, modbusPollHandle,
+                          NULL) != 0) {
+      fprintf(stderr, "Modbus poller initial failed.\n");
+      g_modbusEnabled = false;
+    }
+    for (int i = 0; g_modbusEnabled && i < g_modbusDeviceCount; i++) {
+      if (modbusPoller_AddDevice(&g_modbusDevices[i]) < 0) {
+        fprintf(stderr, "Modbus device %s initial failed.\n",
+                g_modbusDevices[i].name);
+      }
+    }
+  } else {
+    g_modbusEnabled = false;
+  }
+
+  // 打开失败的端口跳过，运行中断开的端口由模块自动重新打开
+  if (g_uartEnabled && g_uartPortCount > 0 &&
+      uartInput_Init(&g_eventLoop, uartFrameHandle, NULL) == 0) {
+    int opened = 0;
+    for (int i = 0; i < g_uartPortCount; i++) {
+      char *topic = buildDeviceTopic(g_uartPorts[i].sensorType);
+      int index = topic ? uartInput_AddPort(&g_uartPorts[i]) : -1;
+      if (index < 0) {
+        fprintf(stderr, "UART port %s initial failed.\n",
+                g_uartPorts[i].name);
+        continue;
+      }
+      g_uartTopics[index] = topic;
+      g_uartPorts[index] = g_uartPorts[i];
+      opened++;
+    }
+    if (opened == 0) {
+      uartInput_Deinit();
+      g_uartEnabled = false;
+    }
+  } else {
+    g_uartEnabled = false;
+  }
+
+  // 计数器可以用命令随时开启，发布定时器按配置常驻
+  if (g_perfMetricsIntervalSec > 0) {
+    g_perfMetricsTopic = buildDeviceTopic("metrics");
+    int metricsTimerFd =
+        eventLoop_AddTimer(&g_eventLoop, perfMetricsTimerHandle, NULL);
+    uint64_t intervalNs = g_perfMetricsIntervalSec * 1000000000ULL;
+    if (!g_perfMetricsTopic || metricsTimerFd < 0 ||
+        eventLoop_ArmTimer(metricsTimerFd, intervalNs, intervalNs) != 0) {
+      fprintf(stderr, "Perf metrics timer initial failed.\n");
+    }
+  }
+
+  if (g_commandStatsIntervalSec > 0) {
+    if (g_perfMetricsTopic == NULL) {
+      g_perfMetricsTopic = buildDeviceTopic("metrics");
+    }
+    int statsTimerFd =
+        eventLoop_AddTimer(&g_eventLoop, commandStatsTimerHandle, NULL);
+    uint64_t intervalNs = g_commandStatsIntervalSec * 1000000000ULL;
+    if (!g_perfMetricsTopic || statsTimerFd < 0 ||
+        eventLoop_ArmTimer(statsTimerFd, intervalNs, intervalNs) != 0) {
+      fprintf(stderr, "Command stats timer initial failed.\n");
+    }
+  }
 
-  // 启动客户端
-  mqttClient_Start(&g_mqttContex);
+  gatewayState_StartTimer(&g_eventLoop);
+  gatewayState_PhaseDone("peripherals");
+
+  // 启动事件循环
+  if (eventLoop_Start(&g_eventLoop) != 0) {
+    return EXIT_FAILURE;
+  }
 
   // 设置信号处理，用于退出
   signal(SIGINT, signalHandle);
   signal(SIGTERM, signalHandle);
 
   /* 创建并启动应用层工作线程 */
-  if (pthread_create(&deviceStatusThreadID, NULL, deviceStatusThreadFunc,
-                     NULL) != 0) {
+  g_statusWatchdogId =
+      watchdog_Register("status", samplingTimeoutMs(&g_statusRate),
+                        samplingThreadRestart, NULL);
+  g_lightWatchdogId =
+      watchdog_Register("light", samplingTimeoutMs(&g_lightRate),
+                        samplingThreadRestart, NULL);
+  if (simClock_CreateThread(&deviceStatusThreadID, deviceStatusThreadFunc,
+                            NULL) != 0) {
     fprintf(stderr, "Creat device ststus thread failed.\n");
-    mqttClient_Stop(&g_mqttContex);
+    brokerGroup_Stop(&g_brokerGroup);
     return EXIT_FAILURE;
   }
 
-  if (pthread_create(&lightSensorThreadID, NULL, lightSensorThreadFunc, NULL) !=
-      0) {
+  if (simClock_CreateThread(&lightSensorThreadID, lightSensorThreadFunc,
+                            NULL) != 0) {
     fprintf(stderr, "Creat light sensor thread failed.\n");
-    mqttClient_Stop(&g_mqttContex);
+    brokerGroup_Stop(&g_brokerGroup);
     return EXIT_FAILURE;
   }
 
-  /* 主线程进入等待状态，直到收到退出信号 */
+  gatewayState_PhaseDone("sampling");
+
+  /* 启动完成，封闭内存池：稳态运行期间不再分配内存 */
+  memPool_Seal();
+  if (g_memConfig.staticMode) {
+    memPoolStats_t memStats;
+    memPool_GetStats(&memStats);
+    fprintf(stdout, "Static memory: %zu/%zu bytes reserved, peak RSS %ld KB.\n",
+            memStats.usedBytes, memStats.budgetBytes, memStats.peakRssKb);
+  }
+  gatewayState_Ready();
+
+  /* 主线程进入等待状态，直到收到退出信号（仿真模式下运行到设定时长） */
+  int exitCode = EXIT_SUCCESS;
+  if (g_simConfig.enabled) {
+    simContext_t simContext = {
+        .brokerGroup = &g_brokerGroup,
+        .samplesProduced = &g_samplesProduced,
+        .samplesOffline = &g_samplesOffline,
+        .exitFlag = &g_exitFlag,
+    };
+    if (sim_Run(&simContext) != 0) {
+      exitCode = EXIT_FAILURE;
+    }
+  }
   while (!g_exitFlag) {
     sleep(1);
   }
 
-  return EXIT_SUCCESS;
+  // 等待执行中的命令结束，之后再关闭它们可能用到的模块
+  commandExecutor_Deinit();
+  // 停止发送后保存快照（含刚发出的命令响应），积压的消息下次启动时发出
+  gatewayStateStats_t snapshotStats;
+  gatewayState_GetStats(&snapshotStats);
+  if (snapshotStats.enabled) {
+    brokerGroup_Pause(&g_brokerGroup);
+    if (gatewayState_Save() == 0) {
+      gatewayState_GetStats(&snapshotStats);
+      fprintf(stdout, "Saved state snapshot: %d queued messages.\n",
+              snapshotStats.lastMessages);
+    }
+  }
+  if (g_tcpIngestEnabled) {
+    tcpIngest_Deinit();
+  }
+  if (g_wsEnabled) {
+    wsServer_Deinit();
+  }
+  if (g_modbusEnabled) {
+    modbusPoller_Deinit();
+  }
+  if (g_uartEnabled) {
+    uartInput_Deinit();
+  }
+  // 正常退出时关闭硬件看门狗，避免退出后被复位
+  if (g_watchdogEnabled) {
+    watchdog_Deinit();
+  }
+  if (g_historyEnabled) {
+    historyStore_Close(&g_historyStore);
+  }
+  // 写缓冲中已接收的分片落盘，下次启动从这里继续
+  if (g_otaEnabled) {
+    otaUpdate_Deinit(&g_ota);
+  }
+  valueTable_Close(&g_valueTable);
+  // 写入剩余日志和重复汇总
+  logger_Deinit();
+  return exitCode;
 }
@@ -0,0 +1,153 @@
+#include "modules/adaptive_rate.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * @brief 检查配置并初始化控制器
+ *
+ * @return 0 成功
+ * */
+int adaptiveRate_Init(adaptiveRate_t *rate, const adaptiveRateConfig_t *config,
+                      const adaptiveBudget_t *budget) {
+  if (!rate || !config || config->minHz <= 0 ||
+      config->maxHz < config->minHz || config->window < 2 ||
+      config->window > ADAPTIVE_RATE_WINDOW || config->decay <= 0 ||
+      config->decay > 1) {
+    fprintf(stderr, "Invalid adaptive sampling config.\n");
+    return -1;
+  }
+
+  memset(rate, 0, sizeof(adaptiveRate_t));
+  rate->config = *config;
+  rate->budget = budget;
+  rate->rateHz = config->maxHz;
+  return 0;
+}
+
+/*
+ * @brief 计算活跃度：对窗口内样本做最小二乘直线拟合，斜率为变化速率，
+ *        拟合残差的标准差为波动幅度，分别除以各自的阈值后取较大者。
+ *        缓慢的线性变化（如日出）只体现在斜率上，不会被当作波动
+ * */
+static double computeActivity(const adaptiveRate_t *rate) {
+  const adaptiveRateConfig_t *cfg = &rate->config;
+  int n = rate->count;
+  if (n < 2) {
+    return 0;
+  }
+
+  // 以最近一次采样时间为原点（秒），窗口内样本的先后顺序不影响拟合结果
+  double meanX = 0, meanY = 0;
+  for (int i = 0; i < n; i++) {
+    meanX += (rate->times[i] - rate->lastMs) / 1000.0;
+    meanY += rate->values[i];
+  }
+  meanX /= n;
+  meanY /= n;
+
+  double sxx = 0, sxy = 0, syy = 0;
+  for (int i = 0; i < n; i++) {
+    double dx = (rate->times[i] - rate->lastMs) / 1000.0 - meanX;
+    double dy = rate->values[i] - meanY;
+    sxx += dx * dx;
+    sxy += dx * dy;
+    syy += dy * dy;
+  }
+  double slope = sxx > 0 ? sxy / sxx : 0;
+  double residual = syy - slope * sxy;
+  double std = n > 2 && residual > 0 ? sqrt(residual / (n - 2)) : 0;
+
+  double activity = 0;
+  if (cfg->changeThreshold > 0) {
+    activity = fabs(slope) / cfg->changeThreshold;
+  }
+  if (cfg->stdThreshold > 0 && std / cfg->stdThreshold > activity) {
+    activity = std / cfg->stdThreshold;
+  }
+  return activity;
+}
+
+/*
+ * @brief 输入样本并更新采样率。目标采样率在 minHz 和 maxHz 之间按活跃度
+ *        几何插值，噪声带来的小活跃度不会明显抬高采样率；目标高于当前值时
+ *        立即提高，否则按每秒 decay 的比例逐步降低到目标值
+ *
+ * @param rate: 控制器
+ *        value: 样本值
+ *        nowMs: 采样时间（单调时钟毫秒数）
+ * */
+void adaptiveRate_OnSample(adaptiveRate_t *rate, double value, int64_t nowMs) {
+  const adaptiveRateConfig_t *cfg = &rate->config;
+  double elapsedSec =
+      rate->samples > 0 ? (nowMs - rate->lastMs) / 1000.0 : 0;
+
+  rate->values[rate->next] = value;
+  rate->times[rate->next] = nowMs;
+  rate->next = (rate->next + 1) % cfg->window;
+  if (rate->count < cfg->window) {
+    rate->count++;
+  }
+  rate->lastMs = nowMs;
+  rate->samples++;
+
+  rate->activity = computeActivity(rate);
+  double level = rate->activity < 1 ? rate->activity : 1;
+  double target = cfg->minHz * pow(cfg->maxHz / cfg->minHz, level);
+  if (target >= rate->rateHz) {
+    rate->rateHz = target;
+  } else if (elapsedSec > 0) {
+    double decayed = rate->rateHz * pow(cfg->decay, elapsedSec);
+    rate->rateHz = decayed > target ? decayed : target;
+  }
+}
+
+double adaptiveRate_EffectiveHz(const adaptiveRate_t *rate) {
+  double hz = rate->rateHz;
+  if (rate->budget) {
+    hz *= adaptiveRate_BudgetScale(rate->budget);
+  }
+  return hz > rate->config.minHz ? hz : rate->config.minHz;
+}
+
+int adaptiveRate_IntervalMs(const adaptiveRate_t *rate) {
+  return (int)(1000.0 / adaptiveRate_EffectiveHz(rate) + 0.5);
+}
+
+void adaptiveRate_BudgetInit(adaptiveBudget_t *budget,
+                             double cpuLimitPercent) {
+  memset(budget, 0, sizeof(adaptiveBudget_t));
+  budget->cpuLimitPercent = cpuLimitPercent;
+  budget->minScale = 0.05;
+  budget->scalePermille = 1000;
+}
+
+/*
+ * @brief 按网关进程CPU占用更新缩放系数。超出上限时按 上限/占用 的比例
+ *        立即降低，低于上限时每次恢复25%，避免在上限附近来回振荡
+ * */
+void adaptiveRate_UpdateBudget(adaptiveBudget_t *budget, double cpuPercent) {
+  budget->lastCpuPercent = cpuPercent;
+  if (budget->cpuLimitPercent <= 0 || cpuPercent < 0) {
+    return;
+  }
+
+  double scale = adaptiveRate_BudgetScale(budget);
+  if (cpuPercent > budget->cpuLimitPercent) {
+    scale *= budget->cpuLimitPercent / cpuPercent;
+  } else {
+    scale *= 1.25;
+  }
+  if (scale > 1) {
+    scale = 1;
+  }
+  if (scale < budget->minScale) {
+    scale = budget->minScale;
+  }
+  __atomic_store_n(&budget->scalePermille, (int)(scale * 1000 + 0.5),
+                   __ATOMIC_RELAXED);
+}
+
+double adaptiveRate_BudgetScale(const adaptiveBudget_t *budget) {
+  return __atomic_load_n(&budget->scalePermille, __ATOMIC_RELAXED) / 1000.0;
+}
@@ -0,0 +1,1259 @@
+#include "modules/broker_group.h"
+#include "modules/lock_profile.h"
+#include "modules/mem_pool.h"
+#include "modules/sim_broker.h"
+#include "modules/sim_clock.h"
+#include "modules/watchdog.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PUBLISH_MAX_ATTEMPTS 5 // 可重试的错误连续失败多少次后丢弃消息
+
+static int64_t monotonicMs(void) { return simClock_NowMs(); }
+
+static int64_t monotonicUs(void) { return simClock_NowNs() / 1000; }
+
+/* 条件变量使用单调时钟，系统时间被校正时不影响等待时长 */
+static void initMonotonicCond(pthread_cond_t *cond) {
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+static void timedWaitMs(pthread_cond_t *cond, pthread_mutex_t *lock, int ms) {
+  struct timespec deadline;
+  simClock_Deadline(&deadline, ms);
+  lockProfile_CondTimedWait(cond, lock, &deadline);
+}
+
+/*
+ * @brief 从Broker地址中解析出主机和端口，用于TCP健康探测
+ *
+ * @param address: 如 "tcp://host:1883"、"ssl://[::1]:8883"
+ *
+ * @return 0 成功
+ * */
+static int parseEndpoint(const char *address, char *host, size_t hostSize,
+                         int *port) {
+  static const struct {
+    const char *scheme;
+    int port;
+  } schemes[] = {{"tcp://", 1883}, {"mqtt://", 1883}, {"ssl://", 8883},
+                 {"mqtts://", 8883}, {"ws://", 80},     {"wss://", 443}};
+
+  *port = 1883;
+  for (size_t i = 0; i < sizeof(schemes) / sizeof(schemes[0]); i++) {
+    size_t len = strlen(schemes[i].scheme);
+    if (strncmp(address, schemes[i].scheme, len) == 0) {
+      address += len;
+      *port = schemes[i].port;
+      break;
+    }
+  }
+
+  const char *hostEnd;
+  if (address[0] == '[') {
+    address++;
+    hostEnd = strchr(address, ']');
+    if (hostEnd == NULL) {
+      return -1;
+    }
+  } else {
+    hostEnd = address + strcspn(address, ":/");
+  }
+
+  size_t hostLen = hostEnd - address;
+  if (hostLen == 0 || hostLen >= hostSize) {
+    return -1;
+  }
+  memcpy(host, address, hostLen);
+  host[hostLen] = '\0';
+
+  const char *portStr = strchr(hostEnd, ':');
+  if (portStr && (portStr == hostEnd || portStr == hostEnd + 1)) {
+    *port = atoi(portStr + 1);
+  }
+  return *port > 0 ? 0 : -1;
+}
+
+/*
+ * @brief TCP层健康探测：在超时时间内能否建立连接
+ *
+ * @return 连接耗时（微秒），失败返回-1
+ * */
+static int probeEndpoint(const char *host, int port, int timeoutMs) {
+  if (simBroker_IsActive()) {
+    return simBroker_Probe(host, port, timeoutMs);
+  }
+
+  char portStr[8];
+  snprintf(portStr, sizeof(portStr), "%d", port);
+
+  struct addrinfo hints, *result = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, portStr, &hints, &result) != 0 || result == NULL) {
+    return -1;
+  }
+
+  int64_t start = monotonicUs();
+  int rtt = -1;
+  int fd = socket(result->ai_family, result->ai_socktype | SOCK_NONBLOCK |
+                                         SOCK_CLOEXEC,
+                  result->ai_protocol);
+  if (fd >= 0) {
+    int rc = connect(fd, result->ai_addr, result->ai_addrlen);
+    if (rc != 0 && errno == EINPROGRESS) {
+      struct pollfd pfd = {fd, POLLOUT, 0};
+      int err = 0;
+      socklen_t errLen = sizeof(err);
+      if (poll(&pfd, 1, timeoutMs) == 1 &&
+          getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) == 0 &&
+          err == 0) {
+        rc = 0;
+      }
+    }
+    if (rc == 0) {
+      rtt = (int)(monotonicUs() - start);
+    }
+    close(fd);
+  }
+  freeaddrinfo(result);
+  return rtt;
+}
+
+static bool anyConnected(const brokerGroup_t *group) {
+  for (int i = 0; i < group->config.brokerCount; i++) {
+    if (mqttClient_IsConnected(&group->links[i].ctx)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void wakeOutboxes(brokerGroup_t *group) {
+  for (int i = 0; i < group->outboxCount; i++) {
+    simClock_CondBroadcast(&group->outboxes[i].cond);
+  }
+}
+
+/*
+ * @brief 把汇总连接状态通知上层。不同Broker的线程可能同时调用，通知逐个
+ *        进行，每次取最新的状态，乱序到达的旧状态不会覆盖新状态
+ * */
+static void notifyConnectionStatus(brokerGroup_t *group) {
+  PROFILED_LOCK(&group->notifyLock);
+  PROFILED_LOCK(&group->lock);
+  bool connected = group->connected;
+  lockProfile_Unlock(&group->lock);
+
+  if (connected != group->notified) {
+    group->notified = connected;
+    if (group->onConnStatusCb) {
+      group->onConnStatusCb(connected, group->onConnStatusUserData);
+    }
+  }
+  lockProfile_Unlock(&group->notifyLock);
+}
+
+/*
+ * @brief 单个Broker连接状态变化（paho线程或重连线程中调用）：
+ *        唤醒发送线程；活动Broker断开时立即唤醒探测线程进行切换判断；
+ *        汇总后的状态变化才通知上层
+ * */
+static void linkConnectionHandle(bool isConnected, void *userData) {
+  brokerLink_t *link = (brokerLink_t *)userData;
+  brokerGroup_t *group = link->group;
+  int64_t now = monotonicMs();
+
+  PROFILED_LOCK(&group->lock);
+  bool isActive = group->config.mode == BROKER_MODE_FAILOVER &&
+                  link->index == group->active;
+  if (isConnected) {
+    __atomic_store_n(&group->everConnected, true, __ATOMIC_RELAXED);
+    link->lastUpMs = now;
+    link->healthy = true;
+    link->probeFailures = 0;
+    if (isActive && group->switching) {
+      group->switching = false;
+      group->lastFailoverMs = (int)(now - group->outageStartMs);
+      fprintf(stdout, "MQTT failover to %s completed in %d ms.\n",
+              link->ctx.config.brokerAddress, group->lastFailoverMs);
+    }
+  } else if (isActive) {
+    link->lastUpMs = now;
+    group->outageStartMs = now;
+    group->supervisorWake = true;
+    simClock_CondSignal(&group->supervisorCond);
+  }
+  wakeOutboxes(group);
+
+  bool connected = anyConnected(group);
+  bool changed = connected != group->connected;
+  group->connected = connected;
+  lockProfile_Unlock(&group->lock);
+
+  if (changed) {
+    notifyConnectionStatus(group);
+  }
+}
+
+/*
+ * @brief 探测一个Broker并更新健康状态。已连接的Broker需要连续失败
+ *        probeFailThreshold次才判定为不健康，避免偶发超时引起切换
+ * */
+static void probeLink(brokerGroup_t *group, brokerLink_t *link) {
+  int rtt = probeEndpoint(link->host, link->port, group->config.probeTimeoutMs);
+
+  PROFILED_LOCK(&group->lock);
+  if (rtt >= 0) {
+    link->healthy = true;
+    link->probeFailures = 0;
+    link->probeRttUs = rtt;
+  } else {
+    link->probeFailures++;
+    int threshold = mqttClient_IsConnected(&link->ctx)
+                        ? group->config.probeFailThreshold
+                        : 1;
+    if (link->probeFailures >= threshold) {
+      link->healthy = false;
+    }
+  }
+  lockProfile_Unlock(&group->lock);
+}
+
+/*
+ * @brief 故障切换判断：当前Broker探测不健康，或断开超过switchTimeoutMs，
+ *        且存在健康的备用Broker时切换。不主动切回优先级更高的Broker，
+ *        避免来回切换
+ * */
+static void checkFailover(brokerGroup_t *group) {
+  int64_t now = monotonicMs();
+
+  PROFILED_LOCK(&group->lock);
+  int from = group->active;
+  brokerLink_t *link = &group->links[from];
+  bool connected = mqttClient_IsConnected(&link->ctx);
+  if (connected) {
+    link->lastUpMs = now;
+  }
+  int64_t downSince = link->lastUpMs > group->activeSinceMs
+                          ? link->lastUpMs
+                          : group->activeSinceMs;
+  bool down = !connected && now - downSince >= group->config.switchTimeoutMs;
+  if (link->healthy && !down) {
+    lockProfile_Unlock(&group->lock);
+    return;
+  }
+
+  int to = -1;
+  for (int k = 1; k < group->config.brokerCount; k++) {
+    int candidate = (from + k) % group->config.brokerCount;
+    if (group->links[candidate].healthy) {
+      to = candidate;
+      break;
+    }
+  }
+  if (to < 0) {
+    // 没有可用的备用Broker，由当前客户端继续重连，期间不再接收新消息
+    if (down) {
+      group->switching = false;
+    }
+    lockProfile_Unlock(&group->lock);
+    return;
+  }
+
+  if (connected) {
+    group->outageStartMs = now; // 连接仍在但探测失败（如对端主机失联）
+  }
+  group->active = to;
+  group->activeSinceMs = now;
+  group->switching = true;
+  group->failovers++;
+  lockProfile_Unlock(&group->lock);
+
+  fprintf(stdout, "MQTT failover: %s -> %s\n", link->ctx.config.brokerAddress,
+          group->links[to].ctx.config.brokerAddress);
+
+  // 先启动新连接再断开旧连接，旧连接断开的通知不再影响切换状态
+  if (mqttClient_Start(&group->links[to].ctx) != 0) {
+    fprintf(stderr, "Failed to start MQTT client for %s.\n",
+            group->links[to].ctx.config.brokerAddress);
+  }
+  mqttClient_Disconnect(&link->ctx);
+
+  PROFILED_LOCK(&group->lock);
+  wakeOutboxes(group);
+  lockProfile_Unlock(&group->lock);
+}
+
+/*
+ * @brief 健康探测线程：按间隔探测所有Broker，活动Broker断开时被立即唤醒。
+ *        先探测活动Broker再做切换判断，备用Broker使用上一轮的探测结果
+ * */
+static void *supervisorThreadFunc(void *arg) {
+  brokerGroup_t *group = (brokerGroup_t *)arg;
+
+  while (!group->shouldExit) {
+    watchdog_Kick(group->watchdogId);
+    PROFILED_LOCK(&group->lock);
+    if (!group->supervisorWake && !group->shouldExit) {
+      timedWaitMs(&group->supervisorCond, &group->lock,
+                  group->config.probeIntervalMs);
+    }
+    group->supervisorWake = false;
+    int active = group->active;
+    lockProfile_Unlock(&group->lock);
+    if (group->shouldExit) {
+      break;
+    }
+
+    bool failover = group->config.mode == BROKER_MODE_FAILOVER;
+    if (failover) {
+      probeLink(group, &group->links[active]);
+      checkFailover(group);
+    }
+    for (int i = 0; i < group->config.brokerCount && !group->shouldExit; i++) {
+      if (!failover || i != active) {
+        probeLink(group, &group->links[i]);
+      }
+    }
+  }
+  return NULL;
+}
+
+static void timedWaitUs(pthread_cond_t *cond, pthread_mutex_t *lock,
+                        int64_t us) {
+  struct timespec deadline;
+  simClock_Deadline(&deadline, 0);
+  deadline.tv_sec += us / 1000000;
+  deadline.tv_nsec += (long)(us % 1000000) * 1000;
+  if (deadline.tv_nsec >= 1000000000) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000;
+  }
+  lockProfile_CondTimedWait(cond, lock, &deadline);
+}
+
+static bool messageExpired(const brokerMessage_t *msg, int64_t nowUs) {
+  return msg->options && msg->options->messageExpirySec > 0 &&
+         nowUs - msg->enqueuedUs >=
+             (int64_t)msg->options->messageExpirySec * 1000000;
+}
+
+/* 取出数据源的队首消息，槽位放回空闲链表（调用者先复制内容） */
+static brokerMessage_t *popSource(brokerOutbox_t *outbox, int cls,
+                                  int source) {
+  brokerClassQueue_t *queue = &outbox->classes[cls];
+  brokerSourceQueue_t *src = &outbox->sources[source];
+  int index = src->head;
+  brokerMessage_t *msg = &queue->slots[index];
+  src->head = msg->next;
+  if (--src->count == 0) {
+    src->tail = -1;
+  }
+  msg->next = queue->freeSlot;
+  queue->freeSlot = index;
+  queue->count--;
+  outbox->count--;
+  return msg;
+}
+
+/*
+ * @brief 差额轮询：轮到的数据源获得 权重 × 槽位大小 字节的额度，
+ *        额度足够发送队首消息时选中它，否则轮到下一个数据源。
+ *        调用前该优先级必须有消息
+ *
+ * @return 数据源ID
+ * */
+static int pickSource(brokerGroup_t *group, brokerOutbox_t *outbox, int cls) {
+  brokerClassQueue_t *queue = &outbox->classes[cls];
+  int count = group->classSourceCount[cls];
+  int quantum = group->config.queueSlotBytes;
+  for (;;) {
+    queue->cursor %= count;
+    int source = group->classSources[cls][queue->cursor];
+    brokerSourceQueue_t *src = &outbox->sources[source];
+    if (src->count > 0) {
+      if (!queue->credited) {
+        src->deficit += quantum * group->sources[source].weight;
+        queue->credited = true;
+      }
+      const brokerMessage_t *head = &queue->slots[src->head];
+      int size = head->topicLen + 1 + head->payloadLen;
+      if (src->deficit >= size) {
+        src->deficit -= size;
+        return source;
+      }
+    } else {
+      src->deficit = 0;
+    }
+    queue->cursor++;
+    queue->credited = false;
+  }
+}
+
+/*
+ * @brief 取出下一条要发送的消息复制到 sending：从高优先级开始，
+ *        跳过令牌不足的优先级，过期的消息直接丢弃
+ *
+ * @param waitUs: 没有可发送的消息且有优先级在等待令牌时，设置为
+ *                最早获得令牌的等待时间，否则为-1
+ *
+ * @return 优先级，没有可发送的消息返回-1
+ * */
+static int takeNext(brokerGroup_t *group, brokerOutbox_t *outbox,
+                    int64_t *waitUs) {
+  int64_t now = monotonicUs();
+  *waitUs = -1;
+  for (int cls = 0; cls < BROKER_CLASS_COUNT; cls++) {
+    brokerClassQueue_t *queue = &outbox->classes[cls];
+    const brokerClassConfig_t *config = &group->config.classes[cls];
+    if (config->ratePerSec > 0) {
+      queue->tokens += (double)(now - queue->refillUs) * config->ratePerSec /
+                       1000000.0;
+      if (queue->tokens > config->burst) {
+        queue->tokens = config->burst;
+      }
+      queue->refillUs = now;
+    }
+
+    while (queue->count > 0) {
+      if (config->ratePerSec > 0 && queue->tokens < 1) {
+        int64_t us =
+            (int64_t)((1 - queue->tokens) * 1000000.0 / config->ratePerSec) +
+            1;
+        if (*waitUs < 0 || us < *waitUs) {
+          *waitUs = us;
+        }
+        break;
+      }
+
+      int source = pickSource(group, outbox, cls);
+      brokerMessage_t *msg = popSource(outbox, cls, source);
+      // 断线期间积压的消息过期后不再发送，不占用令牌
+      if (messageExpired(msg, now)) {
+        queue->expired++;
+        outbox->expired++;
+        continue;
+      }
+      if (config->ratePerSec > 0) {
+        queue->tokens -= 1;
+      }
+      char *data = outbox->sending.data;
+      outbox->sending = *msg;
+      outbox->sending.data = data;
+      memcpy(data, msg->data, msg->topicLen + 1 + msg->payloadLen);
+      return cls;
+    }
+  }
+  return -1;
+}
+
+/* 记录一条消息从入队到发布完成的延迟 */
+static void recordSent(brokerGroup_t *group, brokerOutbox_t *outbox,
+                       brokerLink_t *link) {
+  brokerClassQueue_t *queue = &outbox->classes[outbox->sendingClass];
+  int64_t us = monotonicUs() - outbox->sending.enqueuedUs;
+  uint32_t latencyUs = us > 0 ? (uint32_t)us : 0;
+  int bucket = 0;
+  for (uint32_t v = latencyUs; v > 0 && bucket < BROKER_LATENCY_BUCKETS - 1;
+       v >>= 1) {
+    bucket++;
+  }
+  queue->latencyHist[bucket]++;
+  queue->latencyTotalUs += latencyUs;
+  if (latencyUs > queue->latencyMaxUs) {
+    queue->latencyMaxUs = latencyUs;
+  }
+  queue->sent++;
+  if (group->firstSentUs == 0) {
+    group->firstSentUs = monotonicUs();
+  }
+  outbox->sources[outbox->sending.source].sent++;
+  outbox->sent++;
+  link->sent++;
+}
+
+/*
+ * 发布失败后重试能否成功：在途消息已满、Broker繁忙或配额不足以及原因
+ * 不明的失败可以重试；参数错误和Broker拒绝（MQTT 5 原因码）重试也不会成功
+ * */
+static bool isTransientError(int reasonCode) {
+  switch (reasonCode) {
+  case MQTTCLIENT_FAILURE:
+  case MQTTCLIENT_MAX_MESSAGES_INFLIGHT:
+  case MQTTREASONCODE_SERVER_BUSY:
+  case MQTTREASONCODE_QUOTA_EXCEEDED:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/*
+ * @brief 发送线程：按优先级和数据源权重取出消息发布到目标Broker。
+ *        目标未连接时消息留在队列中；发布失败时可重试的错误重试同一条
+ *        消息，连续失败 PUBLISH_MAX_ATTEMPTS 次或不可重试时丢弃并计入
+ *        failed。发布期间不持有队列锁
+ * */
+static void *outboxThreadFunc(void *arg) {
+  brokerOutbox_t *outbox = (brokerOutbox_t *)arg;
+  brokerGroup_t *group = outbox->group;
+
+  PROFILED_LOCK(&group->lock);
+  while (!group->shouldExit) {
+    watchdog_Kick(outbox->watchdogId);
+    if (outbox->count == 0 && outbox->sendingClass < 0) {
+      watchdog_Idle(outbox->watchdogId);
+      lockProfile_CondWait(&outbox->cond, &group->lock);
+      continue;
+    }
+
+    brokerLink_t *link =
+        &group->links[outbox->target >= 0 ? outbox->target : group->active];
+    if (!mqttClient_IsConnected(&link->ctx)) {
+      timedWaitMs(&outbox->cond, &group->lock, 100);
+      continue;
+    }
+
+    if (outbox->sendingClass < 0) {
+      int64_t waitUs;
+      outbox->sendingClass = takeNext(group, outbox, &waitUs);
+      if (outbox->sendingClass < 0) {
+        // 只剩等待令牌的消息（或全部已过期）
+        if (waitUs > 0) {
+          timedWaitUs(&outbox->cond, &group->lock, waitUs);
+        }
+        continue;
+      }
+    }
+
+    // 重试期间过期的消息同样丢弃
+    brokerMessage_t *msg = &outbox->sending;
+    const mqttPublishOptions_t *options = msg->options;
+    mqttPublishOptions_t remaining;
+    int64_t nowUs = monotonicUs();
+    if (messageExpired(msg, nowUs)) {
+      outbox->classes[outbox->sendingClass].expired++;
+      outbox->expired++;
+      outbox->attempts = 0;
+      outbox->sendingClass = -1;
+      continue;
+    }
+    if (options && options->messageExpirySec > 0) {
+      remaining = *options;
+      remaining.messageExpirySec -= (int)((nowUs - msg->enqueuedUs) / 1000000);
+      options = &remaining;
+    }
+    lockProfile_Unlock(&group->lock);
+
+    int reasonCode = MQTTCLIENT_FAILURE;
+    int rc = mqttClient_PublishWithOptions(
+        &link->ctx, msg->data, msg->data + msg->topicLen + 1, msg->payloadLen,
+        msg->qos, msg->retained, options, &reasonCode);
+
+    PROFILED_LOCK(&group->lock);
+    if (rc != 0) {
+      // 发布期间断开的消息等重新连接后再发，不计入失败次数
+      if (reasonCode == MQTTCLIENT_DISCONNECTED ||
+          (isTransientError(reasonCode) &&
+           ++outbox->attempts < PUBLISH_MAX_ATTEMPTS)) {
+        timedWaitMs(&outbox->cond, &group->lock, 20);
+        continue;
+      }
+      outbox->classes[outbox->sendingClass].failed++;
+      outbox->failed++;
+      outbox->attempts = 0;
+      outbox->sendingClass = -1;
+      continue;
+    }
+    recordSent(group, outbox, link);
+    outbox->attempts = 0;
+    outbox->sendingClass = -1;
+  }
+  lockProfile_Unlock(&group->lock);
+  return NULL;
+}
+
+int brokerGroup_ParseMode(const char *name) {
+  if (name == NULL || strcmp(name, "failover") == 0) {
+    return BROKER_MODE_FAILOVER;
+  }
+  if (strcmp(name, "fanout") == 0) {
+    return BROKER_MODE_FANOUT;
+  }
+  return -1;
+}
+
+static const char *g_classNames[BROKER_CLASS_COUNT] = {"control", "alarm",
+                                                       "status", "bulk"};
+
+int brokerGroup_ParseClass(const char *name) {
+  for (int i = 0; name && i < BROKER_CLASS_COUNT; i++) {
+    if (strcmp(name, g_classNames[i]) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+const char *brokerGroup_ClassName(brokerClass_t cls) {
+  return cls < BROKER_CLASS_COUNT ? g_classNames[cls] : "unknown";
+}
+
+/* 分配一个优先级的槽位并串成空闲链表 */
+static int initClassQueue(brokerClassQueue_t *queue, int depth,
+                          int slotBytes) {
+  queue->slots =
+      (brokerMessage_t *)memPool_Alloc(depth * sizeof(brokerMessage_t));
+  char *data = (char *)memPool_Alloc((size_t)depth * slotBytes);
+  if (queue->slots == NULL || data == NULL) {
+    return -1;
+  }
+  for (int k = 0; k < depth; k++) {
+    queue->slots[k].data = data + (size_t)k * slotBytes;
+    queue->slots[k].next = k + 1 < depth ? k + 1 : -1;
+  }
+  queue->freeSlot = 0;
+  queue->refillUs = monotonicUs();
+  return 0;
+}
+
+/*
+ * @brief 初始化多Broker组：为每个Broker创建客户端实例，按模式分配发送队列
+ *        （故障切换模式一个，扇出模式每个Broker一个）
+ *
+ * @param group: 多Broker组
+ *        config: 多Broker配置
+ *        clientConfig: 公共的客户端配置，brokerAddress 字段被忽略
+ *
+ * @return 0 成功
+ * */
+int brokerGroup_Init(brokerGroup_t *group, const brokerGroupConfig_t *config,
+                     const mqttClientConfig_t *clientConfig) {
+  if (!group || !config || !clientConfig || config->brokerCount <= 0 ||
+      config->brokerCount > BROKER_GROUP_MAX || config->queueDepth <= 0 ||
+      config->queueSlotBytes <= 0) {
+    return -1;
+  }
+
+  memset(group, 0, sizeof(brokerGroup_t));
+  group->config = *config;
+  group->watchdogId = -1;
+  if (group->config.probeIntervalMs <= 0) {
+    group->config.probeIntervalMs = 1000;
+  }
+  if (group->config.probeTimeoutMs <= 0) {
+    group->config.probeTimeoutMs = 500;
+  }
+  if (group->config.probeFailThreshold <= 0) {
+    group->config.probeFailThreshold = 2;
+  }
+  for (int i = 0; i < BROKER_CLASS_COUNT; i++) {
+    brokerClassConfig_t *cls = &group->config.classes[i];
+    if (cls->depth <= 0) {
+      cls->depth = config->queueDepth;
+    }
+    if (cls->burst <= 0) {
+      cls->burst = cls->ratePerSec > 0 ? cls->ratePerSec : 1;
+    }
+    // 令牌桶初始为满，启动后可以立即发送一批
+    for (int k = 0; k < BROKER_GROUP_MAX; k++) {
+      group->outboxes[k].classes[i].tokens = cls->burst;
+    }
+  }
+  pthread_mutex_init(&group->lock, NULL);
+  pthread_mutex_init(&group->notifyLock, NULL);
+  initMonotonicCond(&group->supervisorCond);
+
+  for (int i = 0; i < config->brokerCount; i++) {
+    brokerLink_t *link = &group->links[i];
+    link->group = group;
+    link->index = i;
+    link->healthy = true; // 首次探测前视为可用
+
+    mqttClientConfig_t linkConfig = *clientConfig;
+    linkConfig.brokerAddress = (char *)config->brokerAddresses[i];
+    if (parseEndpoint(config->brokerAddresses[i], link->host,
+                      sizeof(link->host), &link->port) != 0 ||
+        mqttClient_Init(&link->ctx, &linkConfig) != 0) {
+      fprintf(stderr, "Invalid MQTT broker address: %s\n",
+              config->brokerAddresses[i]);
+      return -1;
+    }
+    mqttClient_RegisterConnectionStatusCallback(&link->ctx,
+                                                linkConnectionHandle, link);
+  }
+
+  group->outboxCount =
+      config->mode == BROKER_MODE_FANOUT ? config->brokerCount : 1;
+  for (int i = 0; i < group->outboxCount; i++) {
+    brokerOutbox_t *outbox = &group->outboxes[i];
+    outbox->group = group;
+    outbox->watchdogId = -1;
+    outbox->target = config->mode == BROKER_MODE_FANOUT ? i : -1;
+    outbox->sendingClass = -1;
+    outbox->sending.data = (char *)memPool_Alloc(config->queueSlotBytes);
+    bool reserved = outbox->sending.data != NULL;
+    for (int k = 0; k < BROKER_CLASS_COUNT && reserved; k++) {
+      reserved = initClassQueue(&outbox->classes[k],
+                                group->config.classes[k].depth,
+                                config->queueSlotBytes) == 0;
+    }
+    if (!reserved) {
+      fprintf(stderr, "Failed to reserve MQTT outbound queue.\n");
+      return -1;
+    }
+    initMonotonicCond(&outbox->cond);
+  }
+  return brokerGroup_AddSource(group, "default", BROKER_CLASS_BULK, 1, false) ==
+                 BROKER_SOURCE_DEFAULT
+             ? 0
+             : -1;
+}
+
+/*
+ * @brief 注册数据源。可以在启动后注册，新数据源加入所属优先级的轮询
+ *
+ * @return 数据源ID，失败返回-1
+ * */
+int brokerGroup_AddSource(brokerGroup_t *group, const char *name,
+                          brokerClass_t cls, int weight, bool coalesce) {
+  if (!group || !name || cls >= BROKER_CLASS_COUNT || weight <= 0) {
+    return -1;
+  }
+
+  PROFILED_LOCK(&group->lock);
+  int id = group->sourceCount;
+  if (id < BROKER_MAX_SOURCES) {
+    brokerSource_t *source = &group->sources[id];
+    snprintf(source->name, sizeof(source->name), "%s", name);
+    source->cls = cls;
+    source->weight = weight;
+    source->coalesce = coalesce;
+    for (int i = 0; i < group->outboxCount; i++) {
+      group->outboxes[i].sources[id].head = -1;
+      group->outboxes[i].sources[id].tail = -1;
+    }
+    group->classSources[cls][group->classSourceCount[cls]++] = id;
+    group->sourceCount++;
+  } else {
+    id = -1;
+  }
+  lockProfile_Unlock(&group->lock);
+  return id;
+}
+
+void brokerGroup_SetLWT(brokerGroup_t *group, const char *topic,
+                        const char *payload, int qos) {
+  for (int i = 0; group && i < group->config.brokerCount; i++) {
+    mqttClient_SetLWT(&group->links[i].ctx, topic, payload, qos);
+  }
+}
+
+int brokerGroup_AddSubscription(brokerGroup_t *group, const char *topic,
+                                int qos) {
+  for (int i = 0; group && i < group->config.brokerCount; i++) {
+    if (mqttClient_AddSubscription(&group->links[i].ctx, topic, qos) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void brokerGroup_RegisterCommandCallback(brokerGroup_t *group,
+                                         mqttOnCommandCallback_t callback,
+                                         void *userData) {
+  for (int i = 0; group && i < group->config.brokerCount; i++) {
+    mqttClient_RegisterCommandCallback(&group->links[i].ctx, callback,
+                                       userData);
+  }
+}
+
+int brokerGroup_RegisterLinkCommandCallback(brokerGroup_t *group, int link,
+                                            mqttOnCommandCallback_t callback,
+                                            void *userData) {
+  if (!group || link < 0 || link >= group->config.brokerCount) {
+    return -1;
+  }
+  mqttClient_RegisterCommandCallback(&group->links[link].ctx, callback,
+                                     userData);
+  return 0;
+}
+
+void brokerGroup_RegisterConnectionStatusCallback(
+    brokerGroup_t *group, mqttOnConnectionStatusCallback_t callback,
+    void *userData) {
+  if (group) {
+    group->onConnStatusCb = callback;
+    group->onConnStatusUserData = userData;
+  }
+}
+
+/*
+ * @brief 启动连接：故障切换模式从第一个Broker开始，扇出模式同时连接
+ *        所有Broker；然后启动发送线程和健康探测线程
+ *
+ * @return 0 成功
+ * */
+int brokerGroup_Start(brokerGroup_t *group) {
+  if (!group || group->started) {
+    return -1;
+  }
+
+  group->shouldExit = false;
+  group->active = 0;
+  group->activeSinceMs = monotonicMs();
+  group->startedMs = group->activeSinceMs;
+  int linkCount =
+      group->config.mode == BROKER_MODE_FANOUT ? group->config.brokerCount : 1;
+  for (int i = 0; i < linkCount; i++) {
+    if (mqttClient_Start(&group->links[i].ctx) != 0) {
+      return -1;
+    }
+  }
+
+  // 故障切换时探测线程会等待旧连接的重连线程退出，发送线程可能等待
+  // 正在连接的客户端，超时按最长连接耗时计算
+  int timeoutMs =
+      group->config.probeIntervalMs +
+      group->config.probeTimeoutMs * group->config.brokerCount +
+      mqttClient_ConnectTimeoutMs(&group->links[0].ctx) * 2 + 5000;
+  if (group->watchdogId < 0) {
+    group->watchdogId =
+        watchdog_Register("broker_probe", timeoutMs, NULL, NULL);
+  }
+  for (int i = 0; i < group->outboxCount; i++) {
+    char name[WATCHDOG_NAME_LEN];
+    snprintf(name, sizeof(name), "mqtt_outbox:%d", i);
+    if (group->outboxes[i].watchdogId < 0) {
+      group->outboxes[i].watchdogId =
+          watchdog_Register(name, timeoutMs, NULL, NULL);
+    }
+  }
+
+  for (int i = 0; i < group->outboxCount; i++) {
+    if (simClock_CreateThread(&group->outboxes[i].thread, outboxThreadFunc,
+                              &group->outboxes[i]) != 0) {
+      fprintf(stderr, "Fail to create MQTT outbound thread.\n");
+      return -1;
+    }
+  }
+  if (simClock_CreateThread(&group->supervisorThread, supervisorThreadFunc,
+                            group) != 0) {
+    fprintf(stderr, "Fail to create MQTT broker probe thread.\n");
+    return -1;
+  }
+  group->started = true;
+  return 0;
+}
+
+void brokerGroup_Pause(brokerGroup_t *group) {
+  if (!group) {
+    return;
+  }
+
+  PROFILED_LOCK(&group->lock);
+  group->shouldExit = true;
+  simClock_CondSignal(&group->supervisorCond);
+  wakeOutboxes(group);
+  lockProfile_Unlock(&group->lock);
+
+  if (group->started) {
+    simClock_JoinThread(group->supervisorThread);
+    for (int i = 0; i < group->outboxCount; i++) {
+      simClock_JoinThread(group->outboxes[i].thread);
+    }
+    group->started = false;
+  }
+}
+
+void brokerGroup_Stop(brokerGroup_t *group) {
+  if (!group) {
+    return;
+  }
+
+  brokerGroup_Pause(group);
+
+  for (int i = 0; i < group->config.brokerCount; i++) {
+    mqttClient_Stop(&group->links[i].ctx);
+  }
+  for (int i = 0; i < group->outboxCount; i++) {
+    brokerOutbox_t *outbox = &group->outboxes[i];
+    for (int k = 0; k < BROKER_CLASS_COUNT; k++) {
+      brokerClassQueue_t *queue = &outbox->classes[k];
+      if (queue->slots) {
+        memPool_Free(queue->slots[0].data);
+        memPool_Free(queue->slots);
+        queue->slots = NULL;
+      }
+    }
+    if (outbox->sending.data) {
+      memPool_Free(outbox->sending.data);
+      outbox->sending.data = NULL;
+    }
+    pthread_cond_destroy(&outbox->cond);
+  }
+  pthread_cond_destroy(&group->supervisorCond);
+  pthread_mutex_destroy(&group->notifyLock);
+  pthread_mutex_destroy(&group->lock);
+}
+
+/* 在数据源的积压消息中查找同一Topic的消息，用于合并 */
+static brokerMessage_t *findQueued(brokerOutbox_t *outbox, int cls,
+                                   int source, const char *topic,
+                                   int topicLen) {
+  brokerClassQueue_t *queue = &outbox->classes[cls];
+  for (int i = outbox->sources[source].head; i >= 0;
+       i = queue->slots[i].next) {
+    brokerMessage_t *msg = &queue->slots[i];
+    if (msg->topicLen == topicLen && memcmp(msg->data, topic, topicLen) == 0) {
+      return msg;
+    }
+  }
+  return NULL;
+}
+
+/* 优先级队列满时，丢弃该优先级中积压最多的数据源的最旧消息 */
+static void dropOldest(brokerGroup_t *group, brokerOutbox_t *outbox,
+                       int cls) {
+  int victim = -1;
+  for (int i = 0; i < group->classSourceCount[cls]; i++) {
+    int source = group->classSources[cls][i];
+    if (victim < 0 ||
+        outbox->sources[source].count > outbox->sources[victim].count) {
+      victim = source;
+    }
+  }
+  popSource(outbox, cls, victim);
+  outbox->classes[cls].dropped++;
+  outbox->sources[victim].dropped++;
+  outbox->dropped++;
+}
+
+static void fillMessage(brokerMessage_t *msg, const char *topic, int topicLen,
+                        const char *payload, int payloadLen, int qos,
+                        bool retained, const mqttPublishOptions_t *options,
+                        int64_t now) {
+  msg->topicLen = topicLen;
+  msg->payloadLen = payloadLen;
+  msg->qos = qos;
+  msg->retained = retained;
+  msg->options = options;
+  msg->enqueuedUs = now;
+  memcpy(msg->data, topic, topicLen + 1);
+  memcpy(msg->data + topicLen + 1, payload, payloadLen);
+}
+
+/* 复制到每个发送队列，入队时间为 enqueuedUs */
+static int enqueue(brokerGroup_t *group, int source, const char *topic,
+                   const char *payload, int payloadLen, int qos,
+                   bool retained, const mqttPublishOptions_t *options,
+                   int64_t enqueuedUs);
+
+/*
+ * @brief 发布消息：复制到每个发送队列后立即返回。合并数据源中已有同一
+ *        Topic的消息时只替换内容（保留排队位置）；优先级队列满时丢弃
+ *        同优先级中积压最多的数据源的最旧消息。某个Broker变慢或断开只影响
+ *        它自己的队列，低优先级的积压不会挤占高优先级的槽位
+ *
+ * @return 0 成功，-1 参数错误或消息超过槽位大小
+ * */
+int brokerGroup_Publish(brokerGroup_t *group, int source, const char *topic,
+                        const char *payload, int payloadLen, int qos,
+                        bool retained, const mqttPublishOptions_t *options) {
+  if (!group || !topic || !payload || payloadLen < 0 || source < 0) {
+    return -1;
+  }
+
+  return enqueue(group, source, topic, payload, payloadLen, qos, retained,
+                 options, monotonicUs());
+}
+
+int brokerGroup_Requeue(brokerGroup_t *group,
+                        const brokerQueuedMessage_t *msg) {
+  if (!group || !msg || !msg->topic || !msg->payload || msg->payloadLen < 0 ||
+      msg->source < 0) {
+    return -1;
+  }
+  int64_t ageUs = msg->ageUs > 0 ? msg->ageUs : 0;
+  return enqueue(group, msg->source, msg->topic, msg->payload,
+                 msg->payloadLen, msg->qos, msg->retained, msg->options,
+                 monotonicUs() - ageUs);
+}
+
+static int enqueue(brokerGroup_t *group, int source, const char *topic,
+                   const char *payload, int payloadLen, int qos,
+                   bool retained, const mqttPublishOptions_t *options,
+                   int64_t now) {
+  int topicLen = strlen(topic);
+  if (topicLen + 1 + payloadLen > group->config.queueSlotBytes) {
+    fprintf(stderr, "MQTT message too large for outbound queue (%d bytes).\n",
+            payloadLen);
+    return -1;
+  }
+
+  PROFILED_LOCK(&group->lock);
+  if (source >= group->sourceCount) {
+    lockProfile_Unlock(&group->lock);
+    return -1;
+  }
+  const brokerSource_t *config = &group->sources[source];
+  int cls = config->cls;
+  for (int i = 0; i < group->outboxCount; i++) {
+    brokerOutbox_t *outbox = &group->outboxes[i];
+    brokerClassQueue_t *queue = &outbox->classes[cls];
+    brokerSourceQueue_t *src = &outbox->sources[source];
+    brokerMessage_t *msg =
+        config->coalesce ? findQueued(outbox, cls, source, topic, topicLen)
+                         : NULL;
+    if (msg) {
+      fillMessage(msg, topic, topicLen, payload, payloadLen, qos, retained,
+                  options, now);
+      queue->coalesced++;
+      src->coalesced++;
+      continue;
+    }
+
+    if (queue->freeSlot < 0) {
+      dropOldest(group, outbox, cls);
+    }
+    int index = queue->freeSlot;
+    msg = &queue->slots[index];
+    queue->freeSlot = msg->next;
+    fillMessage(msg, topic, topicLen, payload, payloadLen, qos, retained,
+                options, now);
+    msg->source = source;
+    msg->next = -1;
+    if (src->tail >= 0) {
+      queue->slots[src->tail].next = index;
+    } else {
+      src->head = index;
+    }
+    src->tail = index;
+    src->count++;
+
+    queue->count++;
+    queue->enqueued++;
+    if (queue->count > queue->highWater) {
+      queue->highWater = queue->count;
+    }
+    outbox->count++;
+    outbox->enqueued++;
+    if (outbox->count > outbox->highWater) {
+      outbox->highWater = outbox->count;
+    }
+    simClock_CondSignal(&outbox->cond);
+  }
+  lockProfile_Unlock(&group->lock);
+  return 0;
+}
+
+/*
+ * @brief 是否有Broker可以发布。故障切换进行中也返回true，
+ *        切换期间产生的消息进入队列，在新Broker连上后发出
+ * */
+int brokerGroup_QueueRoom(brokerGroup_t *group, brokerClass_t cls) {
+  if (!group || cls >= BROKER_CLASS_COUNT) {
+    return 0;
+  }
+
+  int depth = group->config.classes[cls].depth;
+  int room = depth;
+  PROFILED_LOCK(&group->lock);
+  for (int i = 0; i < group->outboxCount; i++) {
+    int free = depth - group->outboxes[i].classes[cls].count;
+    if (free < room) {
+      room = free;
+    }
+  }
+  lockProfile_Unlock(&group->lock);
+  return room;
+}
+
+/* 启动后的首次连接正在进行，不超过 switchTimeoutMs */
+static bool firstConnecting(brokerGroup_t *group) {
+  return __atomic_load_n(&group->started, __ATOMIC_RELAXED) &&
+         !__atomic_load_n(&group->everConnected, __ATOMIC_RELAXED) &&
+         monotonicMs() - group->startedMs < group->config.switchTimeoutMs;
+}
+
+bool brokerGroup_IsConnected(brokerGroup_t *group) {
+  if (!group) {
+    return false;
+  }
+  return anyConnected(group) ||
+         __atomic_load_n(&group->switching, __ATOMIC_RELAXED) ||
+         firstConnecting(group);
+}
+
+/* 复制一条积压消息交给 visitor */
+static int visitQueued(const brokerMessage_t *msg, int64_t nowUs,
+                       brokerQueuedVisitor_t visitor, void *userData) {
+  brokerQueuedMessage_t queued = {
+      .source = msg->source,
+      .topic = msg->data,
+      .payload = msg->data + msg->topicLen + 1,
+      .payloadLen = msg->payloadLen,
+      .qos = msg->qos,
+      .retained = msg->retained,
+      .options = msg->options,
+      .ageUs = nowUs - msg->enqueuedUs,
+  };
+  return visitor(&queued, userData);
+}
+
+int brokerGroup_ExportQueued(brokerGroup_t *group,
+                             brokerQueuedVisitor_t visitor, void *userData) {
+  if (!group || !visitor) {
+    return 0;
+  }
+
+  int64_t nowUs = monotonicUs();
+  int count = 0;
+  PROFILED_LOCK(&group->lock);
+  // 扇出模式下各发送队列的进度不同，取积压最多的一个（至少一次）
+  brokerOutbox_t *outbox = NULL;
+  for (int i = 0; i < group->outboxCount; i++) {
+    brokerOutbox_t *candidate = &group->outboxes[i];
+    if (!outbox || candidate->count + (candidate->sendingClass >= 0) >
+                       outbox->count + (outbox->sendingClass >= 0)) {
+      outbox = candidate;
+    }
+  }
+  if (!outbox) {
+    lockProfile_Unlock(&group->lock);
+    return 0;
+  }
+
+  // 正在发送（或等待重试）的消息尚未确认发出
+  if (outbox->sendingClass >= 0) {
+    count++;
+    if (visitQueued(&outbox->sending, nowUs, visitor, userData) != 0) {
+      lockProfile_Unlock(&group->lock);
+      return count;
+    }
+  }
+  for (int cls = 0; cls < BROKER_CLASS_COUNT; cls++) {
+    const brokerClassQueue_t *queue = &outbox->classes[cls];
+    for (int k = 0; k < group->classSourceCount[cls]; k++) {
+      int source = group->classSources[cls][k];
+      for (int i = outbox->sources[source].head; i >= 0;
+           i = queue->slots[i].next) {
+        count++;
+        if (visitQueued(&queue->slots[i], nowUs, visitor, userData) != 0) {
+          lockProfile_Unlock(&group->lock);
+          return count;
+        }
+      }
+    }
+  }
+  lockProfile_Unlock(&group->lock);
+  return count;
+}
+
+/* 延迟直方图的百分位数：在所在的2的幂区间内线性插值，不超过最大值 */
+static uint32_t latencyPercentile(const unsigned long *hist, int percent,
+                                  uint32_t maxUs) {
+  unsigned long total = 0;
+  for (int i = 0; i < BROKER_LATENCY_BUCKETS; i++) {
+    total += hist[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  // 桶 i（i>0）内的延迟在 [2^(i-1), 2^i) 之间
+  unsigned long threshold = total - total * (100 - percent) / 100;
+  unsigned long cumulative = 0;
+  uint64_t us = maxUs;
+  for (int i = 0; i < BROKER_LATENCY_BUCKETS; i++) {
+    if (cumulative + hist[i] >= threshold) {
+      uint64_t lower = i == 0 ? 0 : 1ull << (i - 1);
+      uint64_t upper = i == 0 ? 1 : 1ull << i;
+      us = lower + (upper - lower) * (threshold - cumulative) / hist[i];
+      break;
+    }
+    cumulative += hist[i];
+  }
+  return us < maxUs ? (uint32_t)us : maxUs;
+}
+
+void brokerGroup_GetStats(brokerGroup_t *group, brokerGroupStats_t *stats) {
+  memset(stats, 0, sizeof(brokerGroupStats_t));
+
+  PROFILED_LOCK(&group->lock);
+  stats->active = group->active;
+  stats->failovers = group->failovers;
+  stats->lastFailoverMs = group->lastFailoverMs;
+  stats->startedMs = group->startedMs;
+  stats->firstSentUs = group->firstSentUs;
+  stats->brokerCount = group->config.brokerCount;
+  for (int i = 0; i < group->config.brokerCount; i++) {
+    const brokerLink_t *link = &group->links[i];
+    stats->brokers[i].address = link->ctx.config.brokerAddress;
+    stats->brokers[i].healthy = link->healthy;
+    stats->brokers[i].connected = mqttClient_IsConnected(&link->ctx);
+    stats->brokers[i].probeRttUs = link->probeRttUs;
+    stats->brokers[i].sent = link->sent;
+    mqttClient_GetConnectStats(&link->ctx, &stats->brokers[i].connect);
+    mqttClient_GetPublishStats(&link->ctx, &stats->brokers[i].publish);
+  }
+  stats->outboxCount = group->outboxCount;
+  for (int i = 0; i < group->outboxCount; i++) {
+    const brokerOutbox_t *outbox = &group->outboxes[i];
+    stats->outboxes[i].queued = outbox->count;
+    stats->outboxes[i].highWater = outbox->highWater;
+    stats->outboxes[i].enqueued = outbox->enqueued;
+    stats->outboxes[i].sent = outbox->sent;
+    stats->outboxes[i].dropped = outbox->dropped;
+    stats->outboxes[i].expired = outbox->expired;
+    stats->outboxes[i].failed = outbox->failed;
+    for (int k = 0; k < BROKER_CLASS_COUNT; k++) {
+      const brokerClassQueue_t *queue = &outbox->classes[k];
+      brokerClassStats_t *out = &stats->outboxes[i].classes[k];
+      out->queued = queue->count;
+      out->highWater = queue->highWater;
+      out->enqueued = queue->enqueued;
+      out->sent = queue->sent;
+      out->dropped = queue->dropped;
+      out->coalesced = queue->coalesced;
+      out->expired = queue->expired;
+      out->failed = queue->failed;
+      out->latencyAvgUs =
+          queue->sent ? (uint32_t)(queue->latencyTotalUs / queue->sent) : 0;
+      out->latencyP50Us =
+          latencyPercentile(queue->latencyHist, 50, queue->latencyMaxUs);
+      out->latencyP99Us =
+          latencyPercentile(queue->latencyHist, 99, queue->latencyMaxUs);
+      out->latencyMaxUs = queue->latencyMaxUs;
+    }
+  }
+  stats->sourceCount = group->sourceCount;
+  for (int i = 0; i < group->sourceCount; i++) {
+    const brokerSource_t *source = &group->sources[i];
+    stats->sources[i].name = source->name;
+    stats->sources[i].cls = source->cls;
+    stats->sources[i].weight = source->weight;
+    for (int k = 0; k < group->outboxCount; k++) {
+      const brokerSourceQueue_t *src = &group->outboxes[k].sources[i];
+      stats->sources[i].queued += src->count;
+      stats->sources[i].sent += src->sent;
+      stats->sources[i].dropped += src->dropped;
+      stats->sources[i].coalesced += src->coalesced;
+    }
+  }
+  lockProfile_Unlock(&group->lock);
+}
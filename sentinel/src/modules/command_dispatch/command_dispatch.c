@@ -0,0 +1,210 @@
+#include "modules/command_dispatch.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON/cJSON.h"
+
+/* 已注册的target处理函数表（启动阶段写入，运行期只读） */
+typedef struct {
+  char target[32];
+  commandHandler_t handler;
+  void *userData;
+} commandTarget_t;
+
+static commandTarget_t g_targets[COMMAND_MAX_TARGETS];
+static int g_targetCount = 0;
+
+long long commandDispatch_NowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * @brief 注册target的处理函数
+ *
+ * @param target: 硬件组件名称，如 "gpio_led_alarm"
+ *        handler: 处理函数
+ *        userData: 用户数据
+ *
+ * @return 0 成功，-1 参数错误或target表已满
+ * */
+int commandDispatch_Register(const char *target, commandHandler_t handler,
+                             void *userData) {
+  if (!target || !handler) {
+    return -1;
+  }
+  if (g_targetCount >= COMMAND_MAX_TARGETS) {
+    fprintf(stderr, "Command target table full (%d), '%s' not registered.\n",
+            COMMAND_MAX_TARGETS, target);
+    return -1;
+  }
+
+  commandTarget_t *entry = &g_targets[g_targetCount];
+  snprintf(entry->target, sizeof(entry->target), "%s", target);
+  entry->handler = handler;
+  entry->userData = userData;
+  g_targetCount++;
+  return 0;
+}
+
+/*
+ * @brief 解析 app/{id}/control 命令载荷
+ *
+ * @param payload/payloadLen: 命令JSON
+ *        cmd: 输出的命令结构体
+ *
+ * @return 0 成功，-1 格式错误（cmd中已解析出的command_id仍可用于回复）
+ * */
+int commandDispatch_Parse(const char *payload, int payloadLen,
+                          sentinelCommand_t *cmd) {
+  if (!payload || !cmd) {
+    return -1;
+  }
+
+  memset(cmd, 0, sizeof(sentinelCommand_t));
+  cmd->source = COMMAND_SOURCE_REMOTE;
+  cmd->receivedNs = commandDispatch_NowNs();
+
+  cJSON *root = cJSON_ParseWithLength(payload, payloadLen);
+  if (root == NULL || !cJSON_IsObject(root)) {
+    cJSON_Delete(root);
+    return -1;
+  }
+
+  int rc = 0;
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(root, "command_id");
+  if (cJSON_IsString(item)) {
+    snprintf(cmd->commandId, sizeof(cmd->commandId), "%s", item->valuestring);
+  } else {
+    rc = -1;
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(root, "target");
+  if (cJSON_IsString(item)) {
+    snprintf(cmd->target, sizeof(cmd->target), "%s", item->valuestring);
+  } else {
+    rc = -1;
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(root, "action");
+  if (cJSON_IsString(item)) {
+    snprintf(cmd->action, sizeof(cmd->action), "%s", item->valuestring);
+  } else {
+    rc = -1;
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(root, "value");
+  if (cJSON_IsNumber(item)) {
+    cmd->hasValue = true;
+    cmd->value = item->valuedouble;
+  } else if (cJSON_IsBool(item)) {
+    cmd->hasValue = true;
+    cmd->value = cJSON_IsTrue(item) ? 1 : 0;
+  } else if (cJSON_IsString(item)) {
+    snprintf(cmd->valueStr, sizeof(cmd->valueStr), "%s", item->valuestring);
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(root, "timeout_ms");
+  if (cJSON_IsNumber(item) && item->valuedouble > 0) {
+    cmd->timeoutMs = item->valuedouble < INT32_MAX ? (int)item->valuedouble
+                                                   : INT32_MAX;
+  }
+
+  cJSON *params =
+      cJSON_GetObjectItemCaseSensitive(root, "device_specific_params");
+  cJSON_ArrayForEach(item, params) {
+    if (!cJSON_IsNumber(item) || cmd->paramCount >= COMMAND_MAX_PARAMS) {
+      continue;
+    }
+    commandParam_t *param = &cmd->params[cmd->paramCount++];
+    snprintf(param->name, sizeof(param->name), "%s", item->string);
+    param->value = item->valuedouble;
+  }
+
+  cJSON_Delete(root);
+  return rc;
+}
+
+/*
+ * @brief 按target查找处理函数并执行
+ *
+ * @param cmd: 命令
+ *        result: 执行结果
+ *
+ * @return commandError_t
+ * */
+int commandDispatch_Execute(const sentinelCommand_t *cmd,
+                            sentinelCommandResult_t *result) {
+  if (!cmd || !result) {
+    return COMMAND_ERR_PARSE;
+  }
+
+  memset(result, 0, sizeof(sentinelCommandResult_t));
+  for (int i = 0; i < g_targetCount; i++) {
+    if (strcmp(g_targets[i].target, cmd->target) == 0) {
+      result->errorCode =
+          g_targets[i].handler(cmd, result, g_targets[i].userData);
+      if (result->errorCode != COMMAND_OK && result->message[0] == '\0') {
+        snprintf(result->message, sizeof(result->message),
+                 "Action '%s' failed on '%s'", cmd->action, cmd->target);
+      }
+      return result->errorCode;
+    }
+  }
+
+  result->errorCode = COMMAND_ERR_UNKNOWN_TARGET;
+  snprintf(result->message, sizeof(result->message), "Unknown target '%s'",
+           cmd->target);
+  return result->errorCode;
+}
+
+double commandDispatch_GetParam(const sentinelCommand_t *cmd, const char *name,
+                                double defaultValue) {
+  for (int i = 0; cmd && i < cmd->paramCount; i++) {
+    if (strcmp(cmd->params[i].name, name) == 0) {
+      return cmd->params[i].value;
+    }
+  }
+  return defaultValue;
+}
+
+/* 复制字符串并转义JSON特殊字符 */
+static void escapeJsonString(const char *src, char *dst, size_t size) {
+  size_t pos = 0;
+  for (; *src && pos + 2 < size; src++) {
+    unsigned char c = (unsigned char)*src;
+    if (c == '"' || c == '\\') {
+      dst[pos++] = '\\';
+      dst[pos++] = c;
+    } else if (c >= 0x20) {
+      dst[pos++] = c;
+    }
+  }
+  dst[pos] = '\0';
+}
+
+/*
+ * @brief 格式化 sentinel/{id}/response 载荷
+ *
+ * @return int: 载荷长度
+ * */
+int commandDispatch_FormatResponse(const sentinelCommand_t *cmd,
+                                   const sentinelCommandResult_t *result,
+                                   char *buffer, size_t size) {
+  char commandId[sizeof(cmd->commandId) * 2];
+  char message[sizeof(result->message) * 2];
+  escapeJsonString(cmd->commandId, commandId, sizeof(commandId));
+  escapeJsonString(result->message, message, sizeof(message));
+
+  int len = snprintf(
+      buffer, size,
+      "{\"command_id\":\"%s\",\"status\":\"%s\",\"message\":\"%s\","
+      "\"error_code\":%d,\"result_data\":%s}",
+      commandId, result->errorCode == COMMAND_OK ? "success" : "failure",
+      message, result->errorCode,
+      result->resultData[0] ? result->resultData : "{}");
+  return len < (int)size ? len : (int)size - 1;
+}
@@ -0,0 +1,336 @@
+#include "modules/command_executor.h"
+#include "modules/lock_profile.h"
+#include "modules/mem_pool.h"
+#include "modules/sim_clock.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+/* 排队中或执行中的命令 */
+typedef struct {
+  sentinelCommand_t cmd;
+  bool used;
+  uint64_t seq;       // 到达顺序
+  int64_t submitNs;   // 单调时钟（仿真模式下为虚拟时间）
+  int64_t deadlineNs; // 0 表示不限
+  int cancelled;      // 执行中被取消（原子读写）
+} commandSlot_t;
+
+typedef struct {
+  pthread_t thread;
+  bool busy;
+  commandSlot_t current;
+} commandWorker_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static bool g_running = false;
+static commandExecutorConfig_t g_config;
+static commandDoneCallback_t g_done = NULL;
+static void *g_userData = NULL;
+static commandSlot_t *g_slots = NULL; // queueDepth 个
+static uint64_t g_seq = 0;
+static commandWorker_t g_workers[COMMAND_EXECUTOR_MAX_WORKERS];
+static int g_workerCount = 0;
+static commandExecutorStats_t g_stats;
+
+static __thread commandWorker_t *t_worker = NULL;
+
+static int bucketOf(uint64_t us) {
+  uint64_t ms = us / 1000;
+  int bucket = ms ? 64 - __builtin_clzll(ms) : 0;
+  return bucket < COMMAND_HIST_BUCKETS ? bucket : COMMAND_HIST_BUCKETS - 1;
+}
+
+int commandExecutor_BucketLimitMs(int bucket) {
+  if (bucket < 0 || bucket >= COMMAND_HIST_BUCKETS - 1) {
+    return -1;
+  }
+  return 1 << bucket;
+}
+
+/* 同一 target 正在执行（持有 g_lock 调用） */
+static bool targetBusy(const char *target) {
+  for (int i = 0; i < g_workerCount; i++) {
+    if (g_workers[i].busy &&
+        strcmp(g_workers[i].current.cmd.target, target) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* 同一 target 有更早到达的命令在排队（持有 g_lock 调用） */
+static bool hasEarlier(const commandSlot_t *slot) {
+  for (int i = 0; i < g_config.queueDepth; i++) {
+    const commandSlot_t *other = &g_slots[i];
+    if (other->used && other->seq < slot->seq &&
+        strcmp(other->cmd.target, slot->cmd.target) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * @brief 选择下一条命令（持有 g_lock 调用）：已过期的命令优先，不受
+ *        target 顺序限制（不会执行）；否则取最早到达且 target 空闲的命令
+ *
+ * @param nowNs: 当前时间
+ *        nextDeadlineNs: 输出排队命令中最近的期限，没有时为0
+ *
+ * @return 槽下标，-1 表示没有可执行的命令
+ * */
+static int pickNext(int64_t nowNs, int64_t *nextDeadlineNs) {
+  int best = -1;
+  *nextDeadlineNs = 0;
+  for (int i = 0; i < g_config.queueDepth; i++) {
+    const commandSlot_t *slot = &g_slots[i];
+    if (!slot->used) {
+      continue;
+    }
+    if (slot->deadlineNs && slot->deadlineNs <= nowNs) {
+      return i;
+    }
+    if (slot->deadlineNs &&
+        (*nextDeadlineNs == 0 || slot->deadlineNs < *nextDeadlineNs)) {
+      *nextDeadlineNs = slot->deadlineNs;
+    }
+    if ((best < 0 || slot->seq < g_slots[best].seq) &&
+        !targetBusy(slot->cmd.target) && !hasEarlier(slot)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+/* 完成一条未执行的命令（过期或取消），在锁外调用 */
+static void finishUnexecuted(const sentinelCommand_t *cmd, int errorCode,
+                             const char *message) {
+  sentinelCommandResult_t result;
+  memset(&result, 0, sizeof(result));
+  result.errorCode = errorCode;
+  snprintf(result.message, sizeof(result.message), "%s", message);
+  if (g_done) {
+    g_done(cmd, &result, g_userData);
+  }
+}
+
+static void *workerThread(void *arg) {
+  commandWorker_t *worker = (commandWorker_t *)arg;
+  t_worker = worker;
+
+  PROFILED_LOCK(&g_lock);
+  while (g_running) {
+    int64_t nowNs = simClock_NowNs();
+    int64_t nextDeadlineNs;
+    int index = pickNext(nowNs, &nextDeadlineNs);
+    if (index < 0) {
+      if (nextDeadlineNs) {
+        struct timespec deadline;
+        simClock_Deadline(&deadline,
+                          (nextDeadlineNs - nowNs + 999999) / 1000000);
+        lockProfile_CondTimedWait(&g_cond, &g_lock, &deadline);
+      } else {
+        lockProfile_CondWait(&g_cond, &g_lock);
+      }
+      continue;
+    }
+
+    commandSlot_t *slot = &g_slots[index];
+    worker->current = *slot;
+    slot->used = false;
+    g_stats.queued--;
+    uint64_t queueUs = (uint64_t)(nowNs - slot->submitNs) / 1000;
+    bool expired = slot->deadlineNs && slot->deadlineNs <= nowNs;
+    if (expired) {
+      g_stats.expired++;
+      lockProfile_Unlock(&g_lock);
+      char message[64];
+      snprintf(message, sizeof(message), "Expired after %llu ms in queue",
+               (unsigned long long)(queueUs / 1000));
+      finishUnexecuted(&worker->current.cmd, COMMAND_ERR_TIMEOUT, message);
+      PROFILED_LOCK(&g_lock);
+      continue;
+    }
+
+    worker->busy = true;
+    g_stats.running++;
+    g_stats.queueTotalUs += queueUs;
+    if (queueUs > g_stats.queueMaxUs) {
+      g_stats.queueMaxUs = queueUs;
+    }
+    g_stats.queueHist[bucketOf(queueUs)]++;
+    lockProfile_Unlock(&g_lock);
+
+    sentinelCommandResult_t result;
+    commandDispatch_Execute(&worker->current.cmd, &result);
+    int64_t endNs = simClock_NowNs();
+    if (g_done) {
+      g_done(&worker->current.cmd, &result, g_userData);
+    }
+
+    PROFILED_LOCK(&g_lock);
+    uint64_t execUs = (uint64_t)(endNs - nowNs) / 1000;
+    worker->busy = false;
+    g_stats.running--;
+    g_stats.executed++;
+    if (worker->current.deadlineNs && endNs > worker->current.deadlineNs) {
+      g_stats.late++;
+    }
+    g_stats.execTotalUs += execUs;
+    if (execUs > g_stats.execMaxUs) {
+      g_stats.execMaxUs = execUs;
+    }
+    g_stats.execHist[bucketOf(execUs)]++;
+  }
+  lockProfile_Unlock(&g_lock);
+  return NULL;
+}
+
+/*
+ * @brief 预分配队列并启动工作线程
+ *
+ * @param config: 配置
+ *        done: 命令完成时的回调（发布响应）
+ *        userData: 回调的用户数据
+ *
+ * @return 0 成功
+ * */
+int commandExecutor_Init(const commandExecutorConfig_t *config,
+                         commandDoneCallback_t done, void *userData) {
+  if (config == NULL || config->workers < 1 ||
+      config->workers > COMMAND_EXECUTOR_MAX_WORKERS ||
+      config->queueDepth < 1 || g_running) {
+    return -1;
+  }
+
+  g_slots = (commandSlot_t *)memPool_Alloc(sizeof(commandSlot_t) *
+                                           config->queueDepth);
+  if (g_slots == NULL) {
+    return -1;
+  }
+  memset(g_slots, 0, sizeof(commandSlot_t) * config->queueDepth);
+  memset(g_workers, 0, sizeof(g_workers));
+  memset(&g_stats, 0, sizeof(g_stats));
+  g_config = *config;
+  g_done = done;
+  g_userData = userData;
+  g_workerCount = config->workers;
+  g_stats.workers = config->workers;
+  g_running = true;
+
+  for (int i = 0; i < config->workers; i++) {
+    if (simClock_CreateThread(&g_workers[i].thread, workerThread,
+                              &g_workers[i]) != 0) {
+      fprintf(stderr, "Create command worker failed.\n");
+      g_workerCount = i;
+      commandExecutor_Deinit();
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void commandExecutor_Deinit(void) {
+  PROFILED_LOCK(&g_lock);
+  commandSlot_t *slots = g_slots;
+  g_running = false;
+  g_slots = NULL;
+  simClock_CondBroadcast(&g_cond);
+  lockProfile_Unlock(&g_lock);
+  if (slots == NULL) {
+    return;
+  }
+
+  for (int i = 0; i < g_workerCount; i++) {
+    simClock_JoinThread(g_workers[i].thread);
+  }
+  g_workerCount = 0;
+  g_stats.queued = 0;
+  memPool_Free(slots);
+}
+
+int commandExecutor_Submit(const sentinelCommand_t *cmd) {
+  if (cmd == NULL) {
+    return -1;
+  }
+
+  PROFILED_LOCK(&g_lock);
+  int index = -1;
+  for (int i = 0; g_running && i < g_config.queueDepth; i++) {
+    if (!g_slots[i].used) {
+      index = i;
+      break;
+    }
+  }
+  if (index < 0) {
+    g_stats.rejected++;
+    lockProfile_Unlock(&g_lock);
+    return -1;
+  }
+
+  commandSlot_t *slot = &g_slots[index];
+  slot->cmd = *cmd;
+  slot->used = true;
+  slot->seq = g_seq++;
+  slot->submitNs = simClock_NowNs();
+  int timeoutMs =
+      cmd->timeoutMs > 0 ? cmd->timeoutMs : g_config.defaultTimeoutMs;
+  slot->deadlineNs =
+      timeoutMs > 0 ? slot->submitNs + (int64_t)timeoutMs * 1000000 : 0;
+  slot->cancelled = 0;
+  g_stats.submitted++;
+  if (++g_stats.queued > g_stats.maxQueued) {
+    g_stats.maxQueued = g_stats.queued;
+  }
+  simClock_CondSignal(&g_cond);
+  lockProfile_Unlock(&g_lock);
+  return 0;
+}
+
+int commandExecutor_Cancel(const char *commandId) {
+  if (commandId == NULL || commandId[0] == '\0') {
+    return 0;
+  }
+
+  PROFILED_LOCK(&g_lock);
+  for (int i = 0; g_slots && i < g_config.queueDepth; i++) {
+    commandSlot_t *slot = &g_slots[i];
+    if (slot->used && strcmp(slot->cmd.commandId, commandId) == 0) {
+      sentinelCommand_t cmd = slot->cmd;
+      slot->used = false;
+      g_stats.queued--;
+      g_stats.cancelled++;
+      lockProfile_Unlock(&g_lock);
+      finishUnexecuted(&cmd, COMMAND_ERR_CANCELLED, "Cancelled before start");
+      return 1;
+    }
+  }
+  for (int i = 0; i < g_workerCount; i++) {
+    commandWorker_t *worker = &g_workers[i];
+    if (worker->busy &&
+        strcmp(worker->current.cmd.commandId, commandId) == 0) {
+      __atomic_store_n(&worker->current.cancelled, 1, __ATOMIC_RELAXED);
+      lockProfile_Unlock(&g_lock);
+      return 2;
+    }
+  }
+  lockProfile_Unlock(&g_lock);
+  return 0;
+}
+
+bool commandExecutor_Cancelled(void) {
+  const commandSlot_t *current = t_worker ? &t_worker->current : NULL;
+  if (current == NULL) {
+    return false;
+  }
+  return __atomic_load_n(&current->cancelled, __ATOMIC_RELAXED) ||
+         (current->deadlineNs && simClock_NowNs() > current->deadlineNs);
+}
+
+void commandExecutor_GetStats(commandExecutorStats_t *stats) {
+  PROFILED_LOCK(&g_lock);
+  *stats = g_stats;
+  lockProfile_Unlock(&g_lock);
+}
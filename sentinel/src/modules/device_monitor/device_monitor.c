@@ -1,37 +1,66 @@
 #include "modules/device_monitor.h"
+#include <fcntl.h>
+#include <pthread.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+/*
+ * brief  Read a whole proc/sysfs file into a caller provided buffer. Uses
+ * open/read instead of stdio so that no FILE object is heap allocated on the
+ * sampling path.
+ *
+ * param  path: The file path.
+ *        buffer: Destination buffer, always NUL terminated on success.
+ *        size: Size of the destination buffer.
+ *
+ * return ssize_t: Number of bytes read, -1 on error.
+ * */
+static ssize_t readFileToBuffer(const char *path, char *buffer, size_t size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+
+  ssize_t total = 0;
+  while ((size_t)total < size - 1) {
+    ssize_t n = read(fd, buffer + total, size - 1 - total);
+    if (n <= 0) {
+      break;
+    }
+    total += n;
+  }
+  close(fd);
+
+  buffer[total] = '\0';
+  return total;
+}
+
 /*
  * @brief Get the CPU temperature,
  *
  * @return float: The CPU temperature ('C)
  * */
 float getCpuTemperature(void) {
-  const char *temp_file = CPU_TEMP_FILE;
-  FILE *fp;
+  char buffer[32];
   int temp_raw;
   float temp_current;
 
-  // open the cpu temperature data file
-  fp = fopen(temp_file, "r");
-  if (fp == NULL) {
+  // read the cpu temperature data file
+  if (readFileToBuffer(CPU_TEMP_FILE, buffer, sizeof(buffer)) < 0) {
     perror("Error opening temperature file");
     return -1;
   }
 
   // get the data
-  if (fscanf(fp, "%d", &temp_raw) != 1) {
+  if (sscanf(buffer, "%d", &temp_raw) != 1) {
     fprintf(stderr, "Error reading temperature value.\n");
-    fclose(fp);
     return -1;
   }
 
-  fclose(fp);
-
   temp_current = (float)temp_raw / 1000.0;
   return temp_current;
 }
@@ -44,19 +73,11 @@ float getCpuTemperature(void) {
  *
  * */
 void readCpuTimes(CpuTimes *times) {
-  FILE *fp = fopen(CPU_TIME_FILE, "r");
-  if (fp == NULL) {
-    perror("Error opening CPU_TIME_FILE");
-    memset(times, 0, sizeof(CpuTimes));
-    return;
-  }
-
+  // The aggregate "cpu" line is the first line of /proc/stat
   char line[256];
-  // Read first line
-  if (fgets(line, sizeof(line), fp) == NULL) {
-    fprintf(stderr, "Error reading from CPU_TIME_FILE\n");
+  if (readFileToBuffer(CPU_TIME_FILE, line, sizeof(line)) <= 0) {
+    perror("Error opening CPU_TIME_FILE");
     memset(times, 0, sizeof(CpuTimes));
-    fclose(fp);
     return;
   }
 
@@ -66,35 +87,128 @@ void readCpuTimes(CpuTimes *times) {
 
   times->total = times->user + times->nice + times->system + times->idle +
                  times->iowait + times->irq + times->softirq + times->steal;
-
-  fclose(fp);
 }
 
+/* Previous reading of getCpuLoad, also saved to and restored from the
+ * state snapshot, hence the lock. */
+static CpuTimes g_cpuPrev;
+static pthread_mutex_t g_cpuPrevLock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
- * brief Read the CPU time slice data twice in successtion, calculate the
- * difference to obtian the CPU load during that period of time.
+ * brief  CPU load since the previous call. The previous reading is kept in a
+ * static so the sampling thread is not blocked for a second per sample; the
+ * first call returns the average since boot (or since the restored baseline).
+ * Call it from one sampling thread only.
  *
- * return double: The CPU load(utilization rate)
+ * return double: The CPU load(utilization rate), -1 on error.
  * */
 double getCpuLoad(void) {
-  CpuTimes t1, t2;
-  readCpuTimes(&t1);
-  sleep(1);
-  readCpuTimes(&t2);
+  CpuTimes now;
+  readCpuTimes(&now);
 
-  unsigned long long totalDelta = t2.total - t1.total;
-  unsigned long long idelDelta = t2.idle - t1.idle;
-
-  if (totalDelta == 0) {
+  pthread_mutex_lock(&g_cpuPrevLock);
+  CpuTimes prev = g_cpuPrev;
+  if (now.total < prev.total || now.idle < prev.idle) {
+    memset(&prev, 0, sizeof(prev)); // counters went back, average since boot
+  }
+  unsigned long long totalDelta = now.total - prev.total;
+  unsigned long long idelDelta = now.idle - prev.idle;
+  if (now.total == 0 || totalDelta == 0) {
+    pthread_mutex_unlock(&g_cpuPrevLock);
     fprintf(stderr, "CPU is not run.\n");
     return -1;
   }
+  g_cpuPrev = now;
+  pthread_mutex_unlock(&g_cpuPrevLock);
 
   double cpuUsage =
       100.0 * (double)(totalDelta - idelDelta) / (double)totalDelta;
   return cpuUsage;
 }
 
+/*
+ * brief  Copy the baseline of the next getCpuLoad call, all zero before the
+ * first call.
+ * */
+void getCpuLoadBaseline(CpuTimes *times) {
+  pthread_mutex_lock(&g_cpuPrevLock);
+  *times = g_cpuPrev;
+  pthread_mutex_unlock(&g_cpuPrevLock);
+}
+
+/*
+ * brief  Restore a baseline saved by a previous process, so the first
+ * getCpuLoad call reports the load since then instead of since boot. The
+ * /proc/stat counters restart at boot, a baseline ahead of them is refused.
+ *
+ * return int: 0 on success, -1 if the baseline is not usable.
+ * */
+int setCpuLoadBaseline(const CpuTimes *times) {
+  CpuTimes now;
+  readCpuTimes(&now);
+  if (times->total == 0 || times->total > now.total ||
+      times->idle > now.idle) {
+    return -1;
+  }
+  pthread_mutex_lock(&g_cpuPrevLock);
+  g_cpuPrev = *times;
+  pthread_mutex_unlock(&g_cpuPrevLock);
+  return 0;
+}
+
+/*
+ * brief  CPU time used by this process (user + system, all threads) since the
+ * previous call, as a percentage of one core. The first call returns the
+ * average since the process started.
+ *
+ * return double: The process CPU load, -1 on error.
+ * */
+double getProcessCpuLoad(void) {
+  static unsigned long long prevTicks;
+  static double prevSec = -1;
+
+  char buffer[1024];
+  if (readFileToBuffer(PROC_SELF_STAT_FILE, buffer, sizeof(buffer)) <= 0) {
+    perror("Error opening PROC_SELF_STAT_FILE");
+    return -1;
+  }
+
+  // comm may contain spaces, fields after it start at the last ')'
+  char *p = strrchr(buffer, ')');
+  unsigned long long utime, stime, startTime;
+  if (!p || sscanf(p + 2,
+                   "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu "
+                   "%*d %*d %*d %*d %*d %*d %llu",
+                   &utime, &stime, &startTime) != 3) {
+    fprintf(stderr, "Could not parse process CPU times.\n");
+    return -1;
+  }
+
+  long ticksPerSec = sysconf(_SC_CLK_TCK);
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  double nowSec = ts.tv_sec + ts.tv_nsec / 1e9;
+  unsigned long long ticks = utime + stime;
+
+  double elapsedSec;
+  unsigned long long ticksDelta;
+  if (prevSec < 0) {
+    // CLOCK_MONOTONIC and starttime both count from boot
+    elapsedSec = nowSec - (double)startTime / ticksPerSec;
+    ticksDelta = ticks;
+  } else {
+    elapsedSec = nowSec - prevSec;
+    ticksDelta = ticks - prevTicks;
+  }
+  prevTicks = ticks;
+  prevSec = nowSec;
+
+  if (elapsedSec <= 0 || ticksPerSec <= 0) {
+    return 0;
+  }
+  return 100.0 * (double)ticksDelta / ticksPerSec / elapsedSec;
+}
+
 /*
  * brief  Helper function to parse a value from MEM_USAGE_FILE
  *
@@ -123,17 +237,12 @@ long getMemValue(const char *fileContent, const char *key) {
  * return float: The memory usage rate.
  * */
 float getMemUsage(void) {
-  FILE *fp = fopen(MEM_USAGE_FILE, "r");
-  if (fp == NULL) {
+  char buffer[2048];
+  if (readFileToBuffer(MEM_USAGE_FILE, buffer, sizeof(buffer)) < 0) {
     perror("Error opening MEM_USAGE_FILE");
     return -1;
   }
 
-  char buffer[2048];
-  size_t bytesRead = fread(buffer, 1, sizeof(buffer), fp);
-  fclose(fp);
-  buffer[bytesRead] = '\0';
-
   long totalMemory = getMemValue(buffer, "MemTotal:");
   long availableMemory = getMemValue(buffer, "MemAvailable:");
 
@@ -0,0 +1,280 @@
+#include "modules/event_loop.h"
+#include "modules/mem_pool.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#define EVENT_LOOP_BATCH 32
+
+static void wakeHandle(int fd, uint32_t events, void *userData) {
+  uint64_t value;
+  if (read(fd, &value, sizeof(value)) < 0) {
+    // 仅用于唤醒，读取失败无需处理
+  }
+}
+
+/* 哈希表中 fd 的起始位置（fd 通常是连续的小整数，直接取低位） */
+static int indexSlot(const eventLoop_t *loop, int fd) {
+  return fd & loop->indexMask;
+}
+
+static int findSlot(const eventLoop_t *loop, int fd) {
+  for (int i = indexSlot(loop, fd);; i = (i + 1) & loop->indexMask) {
+    int slot = loop->fdIndex[i];
+    if (slot < 0) {
+      return -1;
+    }
+    if (loop->handlers[slot].fd == fd) {
+      return i;
+    }
+  }
+}
+
+static void indexInsert(eventLoop_t *loop, int fd, int slot) {
+  int i = indexSlot(loop, fd);
+  while (loop->fdIndex[i] >= 0) {
+    i = (i + 1) & loop->indexMask;
+  }
+  loop->fdIndex[i] = slot;
+}
+
+/* 删除后把探测链上后续的表项前移（不使用墓碑） */
+static void indexRemove(eventLoop_t *loop, int pos) {
+  loop->fdIndex[pos] = -1;
+  for (int i = (pos + 1) & loop->indexMask; loop->fdIndex[i] >= 0;
+       i = (i + 1) & loop->indexMask) {
+    int slot = loop->fdIndex[i];
+    int home = indexSlot(loop, loop->handlers[slot].fd);
+    // home 不在 (pos, i] 之间时，该表项可以移到 pos
+    if (((i - home) & loop->indexMask) >= ((i - pos) & loop->indexMask)) {
+      loop->fdIndex[pos] = slot;
+      loop->fdIndex[i] = -1;
+      pos = i;
+    }
+  }
+}
+
+static void releaseSlot(eventLoop_t *loop, int slot) {
+  loop->handlers[slot].used = false;
+  loop->handlers[slot].fd = -1;
+  loop->freeSlots[(loop->freeHead + loop->freeCount) % loop->maxFds] = slot;
+  loop->freeCount++;
+}
+
+/*
+ * @brief 初始化事件循环
+ *
+ * @param loop: 事件循环
+ *        maxFds: 最多可注册的文件描述符数量
+ *
+ * @return 0 成功
+ * */
+int eventLoop_Init(eventLoop_t *loop, int maxFds) {
+  if (!loop || maxFds <= 0) {
+    return -1;
+  }
+
+  memset(loop, 0, sizeof(eventLoop_t));
+  // 哈希表大小取不小于2倍maxFds的2的幂，保持负载因子不超过0.5
+  int indexSize = 16;
+  while (indexSize < maxFds * 2) {
+    indexSize <<= 1;
+  }
+  loop->handlers =
+      (eventLoopHandler_t *)memPool_Alloc(maxFds * sizeof(eventLoopHandler_t));
+  loop->freeSlots = (int *)memPool_Alloc(maxFds * sizeof(int));
+  loop->fdIndex = (int *)memPool_Alloc(indexSize * sizeof(int));
+  if (!loop->handlers || !loop->freeSlots || !loop->fdIndex) {
+    return -1;
+  }
+  memset(loop->handlers, 0, maxFds * sizeof(eventLoopHandler_t));
+  memset(loop->fdIndex, 0xff, indexSize * sizeof(int));
+  loop->indexMask = indexSize - 1;
+  loop->maxFds = maxFds;
+  for (int i = 0; i < maxFds; i++) {
+    loop->freeSlots[i] = i;
+  }
+  loop->freeCount = maxFds;
+
+  loop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+  loop->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (loop->epollFd < 0 || loop->wakeFd < 0) {
+    perror("Error creating event loop");
+    return -1;
+  }
+
+  pthread_mutex_init(&loop->lock, NULL);
+  return eventLoop_AddFd(loop, loop->wakeFd, EPOLLIN, wakeHandle, NULL);
+}
+
+int eventLoop_AddFd(eventLoop_t *loop, int fd, uint32_t events,
+                    eventLoopCallback_t callback, void *userData) {
+  if (!loop || fd < 0 || !callback) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&loop->lock);
+  if (loop->freeCount == 0 || findSlot(loop, fd) >= 0) {
+    pthread_mutex_unlock(&loop->lock);
+    fprintf(stderr, "Event loop full or fd %d already watched.\n", fd);
+    return -1;
+  }
+  int slot = loop->freeSlots[loop->freeHead];
+  loop->freeHead = (loop->freeHead + 1) % loop->maxFds;
+  loop->freeCount--;
+
+  eventLoopHandler_t *handler = &loop->handlers[slot];
+  handler->fd = fd;
+  handler->callback = callback;
+  handler->userData = userData;
+  handler->used = true;
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.ptr = handler;
+  if (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    releaseSlot(loop, slot);
+    pthread_mutex_unlock(&loop->lock);
+    perror("Error adding fd to event loop");
+    return -1;
+  }
+  indexInsert(loop, fd, slot);
+  pthread_mutex_unlock(&loop->lock);
+  return 0;
+}
+
+int eventLoop_ModifyFd(eventLoop_t *loop, int fd, uint32_t events) {
+  if (!loop) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&loop->lock);
+  int pos = findSlot(loop, fd);
+  int rc = -1;
+  if (pos >= 0) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = &loop->handlers[loop->fdIndex[pos]];
+    rc = epoll_ctl(loop->epollFd, EPOLL_CTL_MOD, fd, &ev);
+  }
+  pthread_mutex_unlock(&loop->lock);
+  return rc;
+}
+
+int eventLoop_RemoveFd(eventLoop_t *loop, int fd) {
+  if (!loop) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&loop->lock);
+  int pos = findSlot(loop, fd);
+  if (pos >= 0) {
+    int slot = loop->fdIndex[pos];
+    epoll_ctl(loop->epollFd, EPOLL_CTL_DEL, fd, NULL);
+    indexRemove(loop, pos);
+    releaseSlot(loop, slot);
+  }
+  pthread_mutex_unlock(&loop->lock);
+  return pos >= 0 ? 0 : -1;
+}
+
+int eventLoop_AddTimer(eventLoop_t *loop, eventLoopCallback_t callback,
+                       void *userData) {
+  int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (timerFd < 0) {
+    perror("Error creating timerfd");
+    return -1;
+  }
+
+  if (eventLoop_AddFd(loop, timerFd, EPOLLIN, callback, userData) != 0) {
+    close(timerFd);
+    return -1;
+  }
+  return timerFd;
+}
+
+int eventLoop_ArmTimer(int timerFd, uint64_t initialNs, uint64_t intervalNs) {
+  struct itimerspec spec;
+  spec.it_value.tv_sec = initialNs / 1000000000ULL;
+  spec.it_value.tv_nsec = initialNs % 1000000000ULL;
+  spec.it_interval.tv_sec = intervalNs / 1000000000ULL;
+  spec.it_interval.tv_nsec = intervalNs % 1000000000ULL;
+  return timerfd_settime(timerFd, 0, &spec, NULL);
+}
+
+uint64_t eventLoop_AckTimer(int timerFd) {
+  uint64_t expirations = 0;
+  if (read(timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+    return 0;
+  }
+  return expirations;
+}
+
+/*
+ * @brief 处理一轮事件
+ *
+ * @param loop: 事件循环
+ *        timeoutMs: 等待超时（毫秒），-1 表示一直等待
+ *
+ * @return int: 处理的事件数，出错返回-1
+ * */
+int eventLoop_RunOnce(eventLoop_t *loop, int timeoutMs) {
+  struct epoll_event events[EVENT_LOOP_BATCH];
+  int n = epoll_wait(loop->epollFd, events, EVENT_LOOP_BATCH, timeoutMs);
+  if (n < 0) {
+    return errno == EINTR ? 0 : -1;
+  }
+
+  for (int i = 0; i < n; i++) {
+    eventLoopHandler_t *handler = (eventLoopHandler_t *)events[i].data.ptr;
+    // 同一批次中先前的回调可能已经注销了该fd
+    if (!handler->used) {
+      continue;
+    }
+    handler->callback(handler->fd, events[i].events, handler->userData);
+  }
+  return n;
+}
+
+static void *eventLoopThreadFunc(void *arg) {
+  eventLoop_t *loop = (eventLoop_t *)arg;
+  while (loop->running) {
+    if (eventLoop_RunOnce(loop, -1) < 0) {
+      perror("Event loop epoll_wait failed");
+      break;
+    }
+  }
+  return NULL;
+}
+
+int eventLoop_Start(eventLoop_t *loop) {
+  if (!loop) {
+    return -1;
+  }
+
+  loop->running = true;
+  if (pthread_create(&loop->thread, NULL, eventLoopThreadFunc, loop) != 0) {
+    loop->running = false;
+    fprintf(stderr, "Fail to create event loop thread.\n");
+    return -1;
+  }
+  return 0;
+}
+
+void eventLoop_Stop(eventLoop_t *loop) {
+  if (!loop || !loop->running) {
+    return;
+  }
+
+  loop->running = false;
+  uint64_t one = 1;
+  if (write(loop->wakeFd, &one, sizeof(one)) < 0) {
+    perror("Error waking event loop");
+  }
+  pthread_join(loop->thread, NULL);
+}
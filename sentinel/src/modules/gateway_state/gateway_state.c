@@ -0,0 +1,354 @@
+#include "modules/gateway_state.h"
+#include "modules/lock_profile.h"
+#include "modules/logger.h"
+#include "modules/mem_pool.h"
+#include "modules/sim_clock.h"
+#include "modules/state_snapshot.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define STARTUP_MAX_PHASES 8
+
+// 快照记录的类型，新增记录使用新的 tag，旧版本读取时跳过
+typedef enum {
+  SNAPSHOT_TAG_META = 1,     // snapshotMeta_t
+  SNAPSHOT_TAG_COUNTERS,     // gatewayCounters_t
+  SNAPSHOT_TAG_CPU_BASELINE, // CpuTimes，只在同一次开机内恢复
+  SNAPSHOT_TAG_MESSAGE, // snapshotMessage_t + 数据源名 + Topic和'\0' + 载荷
+} snapshotTag_t;
+
+typedef struct {
+  char bootId[40];
+  int64_t realtimeMs; // 保存时间，用于计算消息在停机期间的排队时间
+} snapshotMeta_t;
+
+typedef struct {
+  int64_t ageUs;
+  int32_t payloadLen;
+  uint16_t topicLen;
+  uint8_t nameLen;
+  uint8_t qos;
+  uint8_t retained;
+  uint8_t packed; // 压缩帧，恢复时使用对应的发布属性
+} snapshotMessage_t;
+
+// 启动各阶段的耗时，启动完成后只读
+static int64_t g_startNs = 0; // 进入main的时间
+static int64_t g_phaseNs = 0; // 当前阶段的开始时间
+static int64_t g_readyNs = 0; // 启动完成的时间
+static struct {
+  const char *name;
+  int us;
+} g_phases[STARTUP_MAX_PHASES];
+static int g_phaseCount = 0;
+
+static pthread_mutex_t g_readyLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_readyCond = PTHREAD_COND_INITIALIZER;
+static bool g_ready = false;
+
+static gatewayStateConfig_t g_config;
+static gatewayStateVisitor_t g_visitor;
+static void *g_buf = NULL; // 保存和恢复共用
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static char g_bootId[40] = ""; // 本次开机的ID，重新开机后CPU时间从0开始
+static gatewayStateStats_t g_stats;
+
+void gatewayState_StartupBegin(void) {
+  g_startNs = simClock_NowNs();
+  g_phaseNs = g_startNs;
+}
+
+void gatewayState_PhaseDone(const char *name) {
+  int64_t now = simClock_NowNs();
+  if (g_phaseCount < STARTUP_MAX_PHASES) {
+    g_phases[g_phaseCount].name = name;
+    g_phases[g_phaseCount].us = (int)((now - g_phaseNs) / 1000);
+    g_phaseCount++;
+  }
+  g_phaseNs = now;
+}
+
+void gatewayState_Ready(void) {
+  g_readyNs = simClock_NowNs();
+  char line[256];
+  int len = 0;
+  for (int i = 0; i < g_phaseCount; i++) {
+    len += snprintf(line + len, sizeof(line) - len, "%s%s %.1f",
+                    i ? ", " : "", g_phases[i].name, g_phases[i].us / 1000.0);
+    if (len >= (int)sizeof(line)) {
+      break;
+    }
+  }
+  fprintf(stdout, "Startup ready in %.1f ms (%s ms).\n",
+          (g_readyNs - g_startNs) / 1e6, line);
+
+  PROFILED_LOCK(&g_readyLock);
+  __atomic_store_n(&g_ready, true, __ATOMIC_RELEASE);
+  simClock_CondBroadcast(&g_readyCond);
+  lockProfile_Unlock(&g_readyLock);
+}
+
+void gatewayState_WaitReady(void) {
+  if (__atomic_load_n(&g_ready, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  PROFILED_LOCK(&g_readyLock);
+  while (!g_ready) {
+    lockProfile_CondWait(&g_readyCond, &g_readyLock);
+  }
+  lockProfile_Unlock(&g_readyLock);
+}
+
+int64_t gatewayState_StartNs(void) { return g_startNs; }
+
+/* 读取本次开机的ID（重启进程不变，重新开机后改变） */
+static void readBootId(void) {
+  FILE *fp = fopen("/proc/sys/kernel/random/boot_id", "r");
+  if (fp == NULL) {
+    return;
+  }
+  if (fgets(g_bootId, sizeof(g_bootId), fp) == NULL) {
+    g_bootId[0] = '\0';
+  }
+  g_bootId[strcspn(g_bootId, "\n")] = '\0';
+  fclose(fp);
+}
+
+/* 把发送队列中的一条积压消息写入快照，放不下时跳过（继续尝试较短的消息） */
+static int exportMessage(const brokerQueuedMessage_t *msg, void *userData) {
+  stateSnapshot_t *snap = (stateSnapshot_t *)userData;
+  const char *name = g_visitor.sourceName(msg->source, g_visitor.userData);
+  int topicLen = strlen(msg->topic);
+  if (name == NULL || topicLen > UINT16_MAX) {
+    return 0;
+  }
+
+  snapshotMessage_t header = {
+      .ageUs = msg->ageUs,
+      .payloadLen = msg->payloadLen,
+      .topicLen = (uint16_t)topicLen,
+      .nameLen = (uint8_t)strlen(name),
+      .qos = (uint8_t)msg->qos,
+      .retained = msg->retained,
+      .packed = msg->options == g_visitor.packedOptions,
+  };
+  char *p = (char *)stateSnapshot_Reserve(
+      snap, SNAPSHOT_TAG_MESSAGE,
+      sizeof(header) + header.nameLen + topicLen + 1 + msg->payloadLen);
+  if (p == NULL) {
+    return 0;
+  }
+  memcpy(p, &header, sizeof(header));
+  p += sizeof(header);
+  memcpy(p, name, header.nameLen);
+  memcpy(p + header.nameLen, msg->topic, topicLen + 1);
+  memcpy(p + header.nameLen + topicLen + 1, msg->payload, msg->payloadLen);
+  return 0;
+}
+
+int gatewayState_Save(void) {
+  if (!g_stats.enabled) {
+    return -1;
+  }
+  PROFILED_LOCK(&g_lock);
+  int64_t startNs = simClock_NowNs();
+  stateSnapshot_t snap;
+  stateSnapshot_Begin(&snap, g_buf, g_config.maxBytes);
+
+  snapshotMeta_t meta = {.realtimeMs = simClock_RealtimeMs()};
+  memcpy(meta.bootId, g_bootId, sizeof(meta.bootId));
+  stateSnapshot_Put(&snap, SNAPSHOT_TAG_META, &meta, sizeof(meta));
+  gatewayCounters_t counters;
+  g_visitor.getCounters(&counters, g_visitor.userData);
+  stateSnapshot_Put(&snap, SNAPSHOT_TAG_COUNTERS, &counters, sizeof(counters));
+  CpuTimes cpu;
+  g_visitor.getCpuBaseline(&cpu, g_visitor.userData);
+  if (cpu.total > 0) {
+    stateSnapshot_Put(&snap, SNAPSHOT_TAG_CPU_BASELINE, &cpu, sizeof(cpu));
+  }
+  unsigned long truncated = snap.truncated;
+  int messages =
+      g_visitor.exportQueued(exportMessage, &snap, g_visitor.userData);
+  int rc = stateSnapshot_Save(&snap, g_config.path);
+
+  g_stats.saves++;
+  if (rc != 0) {
+    g_stats.saveFailures++;
+  }
+  g_stats.lastSaveUs = (int)((simClock_NowNs() - startNs) / 1000);
+  g_stats.lastBytes = (int)snap.len;
+  g_stats.lastMessages = messages - (int)(snap.truncated - truncated);
+  g_stats.truncated += snap.truncated - truncated;
+  lockProfile_Unlock(&g_lock);
+  return rc;
+}
+
+/* 按数据源名称恢复一条消息，返回0成功 */
+static int restoreMessage(const char *data, uint32_t len, int64_t downUs) {
+  snapshotMessage_t header;
+  if (len < sizeof(header)) {
+    return -1;
+  }
+  memcpy(&header, data, sizeof(header));
+  const char *name = data + sizeof(header);
+  const char *topic = name + header.nameLen;
+  if (header.payloadLen < 0 ||
+      sizeof(header) + header.nameLen + header.topicLen + 1 +
+              (uint32_t)header.payloadLen !=
+          len ||
+      topic[header.topicLen] != '\0') {
+    return -1;
+  }
+  int source = g_visitor.sourceByName(name, header.nameLen, g_visitor.userData);
+  if (source < 0) {
+    return -1;
+  }
+
+  brokerQueuedMessage_t msg = {
+      .source = source,
+      .topic = topic,
+      .payload = topic + header.topicLen + 1,
+      .payloadLen = header.payloadLen,
+      .qos = header.qos,
+      .retained = header.retained,
+      .options =
+          header.packed ? g_visitor.packedOptions : g_visitor.jsonOptions,
+      .ageUs = header.ageUs + downUs,
+  };
+  return g_visitor.requeue(&msg, g_visitor.userData);
+}
+
+static void restore(void) {
+  int64_t startNs = simClock_NowNs();
+  stateSnapshot_t snap;
+  if (stateSnapshot_Load(&snap, g_buf, g_config.maxBytes, g_config.path) !=
+      0) {
+    return;
+  }
+
+  bool sameBoot = false;
+  int64_t downUs = 0;
+  size_t offset = 0;
+  uint16_t tag;
+  const void *data;
+  uint32_t len;
+  while (stateSnapshot_Next(&snap, &offset, &tag, &data, &len) == 0) {
+    if (tag == SNAPSHOT_TAG_META && len == sizeof(snapshotMeta_t)) {
+      snapshotMeta_t meta;
+      memcpy(&meta, data, sizeof(meta));
+      meta.bootId[sizeof(meta.bootId) - 1] = '\0';
+      sameBoot = g_bootId[0] != '\0' && strcmp(meta.bootId, g_bootId) == 0;
+      g_stats.savedAgoMs = simClock_RealtimeMs() - meta.realtimeMs;
+      if (g_stats.savedAgoMs > 0) {
+        downUs = g_stats.savedAgoMs * 1000;
+      }
+    } else if (tag == SNAPSHOT_TAG_COUNTERS &&
+               len == sizeof(gatewayCounters_t)) {
+      gatewayCounters_t counters;
+      memcpy(&counters, data, sizeof(counters));
+      g_visitor.addCounters(&counters, g_visitor.userData);
+    } else if (tag == SNAPSHOT_TAG_CPU_BASELINE && len == sizeof(CpuTimes)) {
+      CpuTimes cpu;
+      memcpy(&cpu, data, sizeof(cpu));
+      if (sameBoot) {
+        g_visitor.setCpuBaseline(&cpu, g_visitor.userData);
+      }
+    } else if (tag == SNAPSHOT_TAG_MESSAGE) {
+      if (restoreMessage((const char *)data, len, downUs) == 0) {
+        g_stats.restoredMessages++;
+      } else {
+        g_stats.skippedMessages++;
+      }
+    }
+  }
+  unlink(g_config.path);
+
+  g_stats.restored = true;
+  g_stats.restoreUs = (int)((simClock_NowNs() - startNs) / 1000);
+  fprintf(stdout,
+          "Restored state snapshot saved %lld ms ago: %d queued messages "
+          "(%d skipped) in %d us.\n",
+          (long long)g_stats.savedAgoMs, g_stats.restoredMessages,
+          g_stats.skippedMessages, g_stats.restoreUs);
+}
+
+int gatewayState_Init(const gatewayStateConfig_t *config,
+                      const gatewayStateVisitor_t *visitor) {
+  g_config = *config;
+  g_visitor = *visitor;
+  g_stats.enabled = false;
+  readBootId();
+  if (!config->enabled) {
+    return 0;
+  }
+  g_buf = memPool_Alloc(config->maxBytes);
+  if (g_buf == NULL) {
+    fprintf(stderr, "State snapshot buffer initial failed.\n");
+    return -1;
+  }
+  g_stats.enabled = true;
+  restore();
+  return 0;
+}
+
+/* 快照定时器 */
+static void timerHandle(int fd, uint32_t events, void *userData) {
+  eventLoop_AckTimer(fd);
+  if (gatewayState_Save() != 0) {
+    LOGGER_WARN("Failed to save state snapshot %s.", g_config.path);
+  }
+}
+
+int gatewayState_StartTimer(eventLoop_t *loop) {
+  if (!g_stats.enabled || g_config.intervalSec <= 0) {
+    return 0;
+  }
+  int timerFd = eventLoop_AddTimer(loop, timerHandle, NULL);
+  uint64_t intervalNs = g_config.intervalSec * 1000000000ULL;
+  if (timerFd < 0 || eventLoop_ArmTimer(timerFd, intervalNs, intervalNs) != 0) {
+    fprintf(stderr, "State snapshot timer initial failed.\n");
+    return -1;
+  }
+  return 0;
+}
+
+void gatewayState_GetStats(gatewayStateStats_t *stats) {
+  PROFILED_LOCK(&g_lock);
+  *stats = g_stats;
+  lockProfile_Unlock(&g_lock);
+}
+
+int gatewayState_FormatStartup(char *out, int size, double firstPublishMs) {
+  char first[32] = "null";
+  if (firstPublishMs >= 0) {
+    snprintf(first, sizeof(first), "%.3f", firstPublishMs);
+  }
+
+  int len = snprintf(out, size, "{\"phases\":[");
+  for (int i = 0; i < g_phaseCount && len < size; i++) {
+    len += snprintf(out + len, size - len, "%s{\"name\":\"%s\",\"us\":%d}",
+                    i ? "," : "", g_phases[i].name, g_phases[i].us);
+  }
+  if (len >= size) {
+    return size - 1;
+  }
+
+  gatewayStateStats_t stats;
+  gatewayState_GetStats(&stats);
+  len += snprintf(
+      out + len, size - len,
+      "],\"ready_ms\":%.3f,\"first_publish_ms\":%s,\"snapshot\":{"
+      "\"enabled\":%s,\"restored\":%s,\"restore_us\":%d,"
+      "\"restored_messages\":%d,\"skipped_messages\":%d,"
+      "\"saved_ago_ms\":%lld,\"saves\":%lu,\"save_failures\":%lu,"
+      "\"last_save_us\":%d,\"last_bytes\":%d,\"last_messages\":%d,"
+      "\"truncated\":%lu}}",
+      (g_readyNs - g_startNs) / 1e6, first, stats.enabled ? "true" : "false",
+      stats.restored ? "true" : "false", stats.restoreUs,
+      stats.restoredMessages, stats.skippedMessages,
+      (long long)stats.savedAgoMs, stats.saves, stats.saveFailures,
+      stats.lastSaveUs, stats.lastBytes, stats.lastMessages, stats.truncated);
+  return len < size ? len : size - 1;
+}
@@ -0,0 +1,360 @@
+#include "modules/gpio_input.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/ioctl.h>
+#include <linux/types.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * GPIO字符设备 v1 line-event 接口（内核4.8+）。
+ * 交叉编译工具链自带的内核头文件可能早于<linux/gpio.h>，这里按内核uapi
+ * 定义所需的结构和ioctl，ABI与内核保持一致。
+ */
+#define GPIOHANDLE_REQUEST_INPUT (1UL << 0)
+#define GPIOEVENT_REQUEST_RISING_EDGE (1UL << 0)
+#define GPIOEVENT_REQUEST_FALLING_EDGE (1UL << 1)
+#define GPIOEVENT_EVENT_RISING_EDGE 0x01
+#define GPIOEVENT_EVENT_FALLING_EDGE 0x02
+
+struct gpioevent_request {
+  __u32 lineoffset;
+  __u32 handleflags;
+  __u32 eventflags;
+  char consumer_label[32];
+  int fd;
+};
+
+struct gpioevent_data {
+  __u64 timestamp;
+  __u32 id;
+};
+
+struct gpiohandle_data {
+  __u8 values[64];
+};
+
+#define GPIO_GET_LINEEVENT_IOCTL _IOWR(0xB4, 0x04, struct gpioevent_request)
+#define GPIOHANDLE_GET_LINE_VALUES_IOCTL                                       \
+  _IOWR(0xB4, 0x08, struct gpiohandle_data)
+
+#define GPIO_READ_BATCH 16
+
+/* 输入线运行状态 */
+typedef struct {
+  gpioLineConfig_t config;
+  int fd;
+  bool owned;             // 由本模块申请的fd，注销时关闭
+  int reportedValue;      // 最近一次上报的电平，-1 表示未知
+  int lastSeenValue;      // 最近一次边沿之后的电平
+  bool hasAccepted;
+  uint64_t lastAcceptedTs; // 最近一次上报边沿的内核时间戳
+  uint64_t lastEdgeTs;     // 最近一次边沿的内核时间戳
+  int64_t settleDeadlineNs; // 去抖窗口结束时间（单调时钟），0 表示无
+} gpioLine_t;
+
+static gpioLine_t g_lines[GPIO_MAX_LINES];
+static int g_lineCount = 0;
+static pthread_mutex_t g_gpioLock = PTHREAD_MUTEX_INITIALIZER;
+static eventLoop_t *g_loop = NULL;
+static int g_settleTimerFd = -1;
+static gpioEventCallback_t g_callback = NULL;
+static void *g_userData = NULL;
+static gpioInputStats_t g_stats;
+
+static int64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* 将去抖窗口定时器设置到最早的截止时间，调用方需持有g_gpioLock */
+static void armSettleTimer(int64_t now) {
+  int64_t earliest = 0;
+  for (int i = 0; i < g_lineCount; i++) {
+    int64_t deadline = g_lines[i].settleDeadlineNs;
+    if (deadline > 0 && (earliest == 0 || deadline < earliest)) {
+      earliest = deadline;
+    }
+  }
+
+  if (earliest == 0) {
+    eventLoop_ArmTimer(g_settleTimerFd, 0, 0);
+    return;
+  }
+  // initialNs 为0会停止定时器，已到期时取1ns立即触发
+  uint64_t delay = earliest > now ? (uint64_t)(earliest - now) : 1;
+  eventLoop_ArmTimer(g_settleTimerFd, delay, 0);
+}
+
+static void fillEvent(gpioEvent_t *event, const gpioLine_t *line, int value,
+                      uint64_t ts, bool settled) {
+  event->config = &line->config;
+  event->value = value;
+  event->kernelTsNs = ts;
+  event->dispatchNs = 0;
+  event->settled = settled;
+}
+
+static void deliver(gpioEvent_t *events, int count) {
+  for (int i = 0; i < count; i++) {
+    events[i].dispatchNs = (uint64_t)nowNs();
+    if (g_callback) {
+      g_callback(&events[i], g_userData);
+    }
+  }
+}
+
+/*
+ * @brief 处理一条边沿，调用方需持有g_gpioLock
+ *
+ * 去抖采用"前沿立即上报 + 窗口结束后校正"：距上次上报超过debounceMs的边沿
+ * 立即上报，保证按键/门磁的响应延迟；窗口内的抖动边沿只记录电平，由定时器
+ * 在窗口结束后检查最终电平，与已上报电平不同则补报一次。
+ *
+ * @return bool: 是否需要立即上报
+ * */
+static bool handleEdge(gpioLine_t *line, const struct gpioevent_data *data,
+                       int64_t now, int *value) {
+  int physical = data->id == GPIOEVENT_EVENT_RISING_EDGE ? 1 : 0;
+  *value = line->config.activeLow ? !physical : physical;
+  g_stats.rawEdges++;
+
+  uint64_t debounceNs = (uint64_t)line->config.debounceMs * 1000000ULL;
+  line->lastSeenValue = *value;
+  line->lastEdgeTs = data->timestamp;
+
+  bool outside = !line->hasAccepted ||
+                 data->timestamp - line->lastAcceptedTs >= debounceNs;
+  // 只关注单一边沿时无法跟踪电平，每个窗口外的边沿都上报
+  bool changed = line->config.edge != GPIO_EDGE_BOTH ||
+                 *value != line->reportedValue;
+  if (outside && changed) {
+    line->hasAccepted = true;
+    line->lastAcceptedTs = data->timestamp;
+    line->reportedValue = *value;
+    if (debounceNs > 0 && line->config.edge == GPIO_EDGE_BOTH) {
+      line->settleDeadlineNs = now + (int64_t)debounceNs;
+    }
+    return true;
+  }
+
+  g_stats.suppressed++;
+  if (debounceNs > 0 && line->config.edge == GPIO_EDGE_BOTH &&
+      line->settleDeadlineNs == 0) {
+    line->settleDeadlineNs = now + (int64_t)debounceNs;
+  }
+  return false;
+}
+
+static void lineReadHandle(int fd, uint32_t events, void *userData) {
+  gpioLine_t *line = (gpioLine_t *)userData;
+  struct gpioevent_data data[GPIO_READ_BATCH];
+
+  ssize_t n = read(fd, data, sizeof(data));
+  if (n < 0) {
+    if (errno != EAGAIN && errno != EINTR) {
+      perror("Error reading GPIO event");
+    }
+    return;
+  }
+  if (n == 0) {
+    // 写端关闭（测试注入的管道），不再监听
+    eventLoop_RemoveFd(g_loop, fd);
+    return;
+  }
+
+  gpioEvent_t out[GPIO_READ_BATCH];
+  int outCount = 0;
+  int64_t now = nowNs();
+
+  pthread_mutex_lock(&g_gpioLock);
+  int records = (int)(n / sizeof(struct gpioevent_data));
+  for (int i = 0; i < records; i++) {
+    int value;
+    if (handleEdge(line, &data[i], now, &value)) {
+      fillEvent(&out[outCount++], line, value, data[i].timestamp, false);
+    }
+  }
+  armSettleTimer(now);
+  if (outCount > 0) {
+    g_stats.delivered += outCount;
+  }
+  pthread_mutex_unlock(&g_gpioLock);
+
+  // 回调在锁外执行，回调中可以发布消息
+  deliver(out, outCount);
+}
+
+static void settleTimerHandle(int fd, uint32_t events, void *userData) {
+  eventLoop_AckTimer(fd);
+
+  gpioEvent_t out[GPIO_MAX_LINES];
+  int outCount = 0;
+  int64_t now = nowNs();
+
+  pthread_mutex_lock(&g_gpioLock);
+  for (int i = 0; i < g_lineCount; i++) {
+    gpioLine_t *line = &g_lines[i];
+    if (line->settleDeadlineNs == 0 || line->settleDeadlineNs > now) {
+      continue;
+    }
+    line->settleDeadlineNs = 0;
+    if (line->lastSeenValue != line->reportedValue) {
+      line->reportedValue = line->lastSeenValue;
+      line->lastAcceptedTs = line->lastEdgeTs;
+      fillEvent(&out[outCount++], line, line->lastSeenValue, line->lastEdgeTs,
+                true);
+    }
+  }
+  armSettleTimer(now);
+  g_stats.delivered += outCount;
+  pthread_mutex_unlock(&g_gpioLock);
+
+  deliver(out, outCount);
+}
+
+/*
+ * @brief 初始化GPIO输入模块
+ *
+ * @param loop: 共享的事件循环
+ *        callback: 去抖后的事件回调
+ *        userData: 回调参数
+ *
+ * @return 0 成功
+ * */
+int gpioInput_Init(eventLoop_t *loop, gpioEventCallback_t callback,
+                   void *userData) {
+  if (!loop) {
+    return -1;
+  }
+
+  g_loop = loop;
+  g_callback = callback;
+  g_userData = userData;
+  g_lineCount = 0;
+  memset(&g_stats, 0, sizeof(g_stats));
+
+  g_settleTimerFd = eventLoop_AddTimer(loop, settleTimerHandle, NULL);
+  return g_settleTimerFd < 0 ? -1 : 0;
+}
+
+/*
+ * @brief 注册一个输出gpioevent_data记录的fd
+ *
+ * @param config: 输入线配置
+ *        eventFd: line-event fd，或测试中注入的管道读端
+ *        initialValue: 初始电平（已考虑activeLow），-1 表示未知
+ *
+ * @return 0 成功
+ * */
+int gpioInput_AddLineFd(const gpioLineConfig_t *config, int eventFd,
+                        int initialValue) {
+  if (!config || eventFd < 0 || g_loop == NULL) {
+    return -1;
+  }
+  if (g_lineCount >= GPIO_MAX_LINES) {
+    fprintf(stderr, "Too many GPIO input lines (max %d).\n", GPIO_MAX_LINES);
+    return -1;
+  }
+
+  int flags = fcntl(eventFd, F_GETFL, 0);
+  if (flags >= 0) {
+    fcntl(eventFd, F_SETFL, flags | O_NONBLOCK);
+  }
+
+  gpioLine_t *line = &g_lines[g_lineCount];
+  memset(line, 0, sizeof(gpioLine_t));
+  line->config = *config;
+  line->fd = eventFd;
+  line->reportedValue = initialValue;
+  line->lastSeenValue = initialValue;
+
+  if (eventLoop_AddFd(g_loop, eventFd, EPOLLIN, lineReadHandle, line) != 0) {
+    return -1;
+  }
+  g_lineCount++;
+  return 0;
+}
+
+/*
+ * @brief 通过GPIO字符设备申请输入线的边沿事件
+ *
+ * @param config: 输入线配置
+ *
+ * @return 0 成功
+ * */
+int gpioInput_AddLine(const gpioLineConfig_t *config) {
+  if (!config) {
+    return -1;
+  }
+
+  int chipFd = open(config->chip, O_RDONLY | O_CLOEXEC);
+  if (chipFd < 0) {
+    fprintf(stderr, "Error opening %s: %s\n", config->chip, strerror(errno));
+    return -1;
+  }
+
+  struct gpioevent_request req;
+  memset(&req, 0, sizeof(req));
+  req.lineoffset = config->line;
+  req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+  // 电平取反由本模块处理，不使用ACTIVE_LOW标志（不同内核版本对事件边沿的
+  // 处理不一致）
+  if (config->edge & GPIO_EDGE_RISING) {
+    req.eventflags |= GPIOEVENT_REQUEST_RISING_EDGE;
+  }
+  if (config->edge & GPIO_EDGE_FALLING) {
+    req.eventflags |= GPIOEVENT_REQUEST_FALLING_EDGE;
+  }
+  snprintf(req.consumer_label, sizeof(req.consumer_label), "sentinel-%.22s",
+           config->name);
+
+  int rc = ioctl(chipFd, GPIO_GET_LINEEVENT_IOCTL, &req);
+  close(chipFd);
+  if (rc < 0) {
+    fprintf(stderr, "Error requesting GPIO line %s:%d: %s\n", config->chip,
+            config->line, strerror(errno));
+    return -1;
+  }
+
+  int initialValue = -1;
+  struct gpiohandle_data values;
+  memset(&values, 0, sizeof(values));
+  if (ioctl(req.fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &values) == 0) {
+    initialValue = config->activeLow ? !values.values[0] : values.values[0];
+  }
+
+  if (gpioInput_AddLineFd(config, req.fd, initialValue) != 0) {
+    close(req.fd);
+    return -1;
+  }
+  g_lines[g_lineCount - 1].owned = true;
+  return 0;
+}
+
+void gpioInput_GetStats(gpioInputStats_t *stats) {
+  pthread_mutex_lock(&g_gpioLock);
+  *stats = g_stats;
+  pthread_mutex_unlock(&g_gpioLock);
+}
+
+void gpioInput_Deinit(void) {
+  for (int i = 0; i < g_lineCount; i++) {
+    eventLoop_RemoveFd(g_loop, g_lines[i].fd);
+    if (g_lines[i].owned) {
+      close(g_lines[i].fd);
+    }
+  }
+  g_lineCount = 0;
+
+  if (g_settleTimerFd >= 0) {
+    eventLoop_RemoveFd(g_loop, g_settleTimerFd);
+    close(g_settleTimerFd);
+    g_settleTimerFd = -1;
+  }
+}
@@ -0,0 +1,549 @@
+#include "modules/history_store.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * 文件布局：第0块为文件头（序列名称表），之后是blockCount个定长数据块。
+ * 每个数据块只保存一个序列的一段连续样本，使用 Gorilla 编码：
+ *   时间戳：二阶差分（delta-of-delta）变长编码
+ *   数值：与上一个值的位模式XOR，只保存有效位
+ * 块写满后分配新块，没有空闲块时回收序号最小（最旧）的块。
+ */
+#define HISTORY_MAGIC 0x53544E53       // "SNTS"
+#define HISTORY_BLOCK_MAGIC 0x4B4C4253 // "SBLK"
+#define HISTORY_VERSION 1
+#define HISTORY_MAX_RECORD_BITS 128 // 单个样本编码的最大位数（36 + 77，取整）
+#define HISTORY_NO_LEADING 0xff
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t blockBytes;
+  uint32_t blockCount;
+  uint64_t nextSeq;
+  uint32_t seriesCount;
+  uint32_t reserved;
+  char seriesNames[HISTORY_MAX_SERIES][HISTORY_NAME_LEN];
+} historyFileHeader_t;
+
+typedef struct {
+  uint32_t magic;
+  uint16_t seriesId;
+  uint16_t reserved;
+  uint32_t count;  // 样本数
+  uint32_t bitLen; // 已写入的位数
+  uint64_t seq;    // 分配序号，越小越旧
+  int64_t firstTs;
+  int64_t lastTs;
+} historyBlockHeader_t;
+
+static historyFileHeader_t *fileHeader(historyStore_t *store) {
+  return (historyFileHeader_t *)store->base;
+}
+
+static historyBlockHeader_t *blockAt(historyStore_t *store, int index) {
+  return (historyBlockHeader_t *)(store->base + (size_t)(index + 1) *
+                                                    store->config.blockBytes);
+}
+
+static uint8_t *blockData(historyBlockHeader_t *block) {
+  return (uint8_t *)(block + 1);
+}
+
+static uint32_t blockCapacityBits(const historyStore_t *store) {
+  return (store->config.blockBytes - sizeof(historyBlockHeader_t)) * 8;
+}
+
+/* 按MSB优先写入nbits位，目标区域在分配块时已清零 */
+static void writeBits(uint8_t *data, uint32_t *pos, uint64_t value,
+                      int nbits) {
+  while (nbits > 0) {
+    int used = *pos & 7;
+    int room = 8 - used;
+    int take = nbits < room ? nbits : room;
+    uint8_t chunk = (uint8_t)((value >> (nbits - take)) & ((1u << take) - 1));
+    data[*pos >> 3] |= (uint8_t)(chunk << (room - take));
+    *pos += take;
+    nbits -= take;
+  }
+}
+
+static uint64_t readBits(const uint8_t *data, uint32_t *pos, int nbits) {
+  uint64_t value = 0;
+  while (nbits > 0) {
+    int used = *pos & 7;
+    int room = 8 - used;
+    int take = nbits < room ? nbits : room;
+    uint8_t byte = data[*pos >> 3];
+    uint8_t chunk = (uint8_t)((byte >> (room - take)) & ((1u << take) - 1));
+    value = (value << take) | chunk;
+    *pos += take;
+    nbits -= take;
+  }
+  return value;
+}
+
+static int64_t signExtend(uint64_t value, int bits) {
+  uint64_t sign = 1ULL << (bits - 1);
+  return (int64_t)((value ^ sign) - sign);
+}
+
+static uint64_t doubleBits(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static double bitsDouble(uint64_t bits) {
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/*
+ * @brief 分配一个新块：优先使用空闲块，否则回收最旧的非活动块。
+ *        调用方需持有store->lock
+ *
+ * @return int: 块索引，失败返回-1
+ * */
+static int allocBlock(historyStore_t *store, int seriesId) {
+  int best = -1;
+  uint64_t bestSeq = UINT64_MAX;
+
+  for (uint32_t i = 0; i < store->config.blockCount; i++) {
+    historyBlockHeader_t *block = blockAt(store, i);
+    if (block->magic != HISTORY_BLOCK_MAGIC) {
+      best = i;
+      break;
+    }
+
+    bool active = false;
+    for (int s = 0; s < store->seriesCount; s++) {
+      if (store->series[s].block == (int)i) {
+        active = true;
+        break;
+      }
+    }
+    if (!active && block->seq < bestSeq) {
+      bestSeq = block->seq;
+      best = i;
+    }
+  }
+  if (best < 0) {
+    return -1;
+  }
+
+  historyBlockHeader_t *block = blockAt(store, best);
+  memset(block, 0, store->config.blockBytes);
+  block->magic = HISTORY_BLOCK_MAGIC;
+  block->seriesId = seriesId;
+  block->seq = fileHeader(store)->nextSeq++;
+  return best;
+}
+
+/* 二阶差分的变长编码，超出32位范围返回-1（需要换块） */
+static int encodeDod(uint8_t *data, uint32_t *pos, int64_t dod) {
+  if (dod == 0) {
+    writeBits(data, pos, 0, 1);
+  } else if (dod >= -64 && dod <= 63) {
+    writeBits(data, pos, 0x2, 2);
+    writeBits(data, pos, (uint64_t)dod, 7);
+  } else if (dod >= -256 && dod <= 255) {
+    writeBits(data, pos, 0x6, 3);
+    writeBits(data, pos, (uint64_t)dod, 9);
+  } else if (dod >= -2048 && dod <= 2047) {
+    writeBits(data, pos, 0xe, 4);
+    writeBits(data, pos, (uint64_t)dod, 12);
+  } else if (dod >= INT32_MIN && dod <= INT32_MAX) {
+    writeBits(data, pos, 0xf, 4);
+    writeBits(data, pos, (uint64_t)dod, 32);
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+static int64_t decodeDod(const uint8_t *data, uint32_t *pos) {
+  if (readBits(data, pos, 1) == 0) {
+    return 0;
+  }
+  if (readBits(data, pos, 1) == 0) {
+    return signExtend(readBits(data, pos, 7), 7);
+  }
+  if (readBits(data, pos, 1) == 0) {
+    return signExtend(readBits(data, pos, 9), 9);
+  }
+  if (readBits(data, pos, 1) == 0) {
+    return signExtend(readBits(data, pos, 12), 12);
+  }
+  return signExtend(readBits(data, pos, 32), 32);
+}
+
+/* 数值的XOR编码 */
+static void encodeValue(uint8_t *data, uint32_t *pos, historySeries_t *s,
+                        uint64_t bits) {
+  uint64_t xor = bits ^ s->prevBits;
+  s->prevBits = bits;
+  if (xor == 0) {
+    writeBits(data, pos, 0, 1);
+    return;
+  }
+
+  int leading = __builtin_clzll(xor);
+  int trailing = __builtin_ctzll(xor);
+  if (leading > 31) {
+    leading = 31; // 前导零个数用5位保存
+  }
+
+  if (s->prevLeading != HISTORY_NO_LEADING && leading >= s->prevLeading &&
+      trailing >= s->prevTrailing) {
+    // 有效位落在上一个窗口内，复用窗口
+    int significant = 64 - s->prevLeading - s->prevTrailing;
+    writeBits(data, pos, 0x2, 2);
+    writeBits(data, pos, xor >> s->prevTrailing, significant);
+    return;
+  }
+
+  int significant = 64 - leading - trailing;
+  writeBits(data, pos, 0x3, 2);
+  writeBits(data, pos, leading, 5);
+  writeBits(data, pos, significant & 63, 6); // 64 记为 0
+  writeBits(data, pos, xor >> trailing, significant);
+  s->prevLeading = leading;
+  s->prevTrailing = trailing;
+}
+
+/* 解码器状态 */
+typedef struct {
+  uint32_t pos;
+  int64_t ts;
+  int64_t delta;
+  uint64_t bits;
+  int leading;
+  int trailing;
+} historyDecoder_t;
+
+static void decodeValue(const uint8_t *data, historyDecoder_t *d) {
+  if (readBits(data, &d->pos, 1) == 0) {
+    return;
+  }
+  if (readBits(data, &d->pos, 1) == 1) {
+    d->leading = (int)readBits(data, &d->pos, 5);
+    int significant = (int)readBits(data, &d->pos, 6);
+    if (significant == 0) {
+      significant = 64;
+    }
+    d->trailing = 64 - d->leading - significant;
+  }
+  int significant = 64 - d->leading - d->trailing;
+  d->bits ^= readBits(data, &d->pos, significant) << d->trailing;
+}
+
+/*
+ * @brief 打开（或创建）存储文件
+ *
+ * @param store: 存储
+ *        config: 配置
+ *
+ * @return 0 成功
+ * */
+int historyStore_Open(historyStore_t *store,
+                      const historyStoreConfig_t *config) {
+  if (!store || !config || config->blockCount == 0 ||
+      config->blockBytes < sizeof(historyFileHeader_t) ||
+      config->blockBytes % 8 != 0) {
+    return -1;
+  }
+
+  memset(store, 0, sizeof(historyStore_t));
+  store->config = *config;
+  store->mapBytes = (size_t)config->blockBytes * (config->blockCount + 1);
+
+  store->fd = open(config->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (store->fd < 0) {
+    fprintf(stderr, "Error opening history store %s: %s\n", config->path,
+            strerror(errno));
+    return -1;
+  }
+
+  // 读取已有文件头，几何参数不一致时丢弃旧数据
+  historyFileHeader_t header;
+  memset(&header, 0, sizeof(header));
+  struct stat st;
+  bool valid = fstat(store->fd, &st) == 0 &&
+               (size_t)st.st_size == store->mapBytes &&
+               pread(store->fd, &header, sizeof(header), 0) ==
+                   sizeof(header) &&
+               header.magic == HISTORY_MAGIC &&
+               header.version == HISTORY_VERSION &&
+               header.blockBytes == config->blockBytes &&
+               header.blockCount == config->blockCount;
+  if (!valid) {
+    // 截断后重新扩展，得到全零的稀疏文件
+    if (ftruncate(store->fd, 0) != 0 ||
+        ftruncate(store->fd, store->mapBytes) != 0) {
+      perror("Error sizing history store");
+      close(store->fd);
+      return -1;
+    }
+  }
+
+  store->base = (uint8_t *)mmap(NULL, store->mapBytes, PROT_READ | PROT_WRITE,
+                                MAP_SHARED, store->fd, 0);
+  if (store->base == MAP_FAILED) {
+    perror("Error mapping history store");
+    close(store->fd);
+    store->base = NULL;
+    return -1;
+  }
+
+  historyFileHeader_t *fh = fileHeader(store);
+  if (!valid) {
+    fh->magic = HISTORY_MAGIC;
+    fh->version = HISTORY_VERSION;
+    fh->blockBytes = config->blockBytes;
+    fh->blockCount = config->blockCount;
+    fh->nextSeq = 1;
+    fh->seriesCount = 0;
+  }
+  if (fh->seriesCount > HISTORY_MAX_SERIES) {
+    fh->seriesCount = 0;
+  }
+
+  // 上次运行未写满的块保持封闭，新样本写入新块
+  store->seriesCount = fh->seriesCount;
+  for (int i = 0; i < HISTORY_MAX_SERIES; i++) {
+    store->series[i].block = -1;
+  }
+  pthread_mutex_init(&store->lock, NULL);
+  return 0;
+}
+
+int historyStore_FindSeries(historyStore_t *store, const char *name) {
+  historyFileHeader_t *fh = fileHeader(store);
+  for (int i = 0; i < store->seriesCount; i++) {
+    if (strncmp(fh->seriesNames[i], name, HISTORY_NAME_LEN) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int historyStore_SeriesId(historyStore_t *store, const char *name) {
+  if (!store || !store->base || !name) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&store->lock);
+  int id = historyStore_FindSeries(store, name);
+  if (id < 0 && store->seriesCount < HISTORY_MAX_SERIES) {
+    historyFileHeader_t *fh = fileHeader(store);
+    id = store->seriesCount++;
+    snprintf(fh->seriesNames[id], HISTORY_NAME_LEN, "%s", name);
+    fh->seriesCount = store->seriesCount;
+  }
+  pthread_mutex_unlock(&store->lock);
+  return id;
+}
+
+/*
+ * @brief 追加一个样本
+ *
+ * @param store: 存储
+ *        seriesId: 序列ID
+ *        tsMs: 时间戳（毫秒）
+ *        value: 数值
+ *
+ * @return 0 成功
+ * */
+int historyStore_Append(historyStore_t *store, int seriesId, int64_t tsMs,
+                        double value) {
+  if (!store || !store->base || seriesId < 0 ||
+      seriesId >= store->seriesCount) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&store->lock);
+  historySeries_t *s = &store->series[seriesId];
+  uint64_t bits = doubleBits(value);
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (s->block < 0) {
+      s->block = allocBlock(store, seriesId);
+      if (s->block < 0) {
+        pthread_mutex_unlock(&store->lock);
+        return -1;
+      }
+    }
+
+    historyBlockHeader_t *block = blockAt(store, s->block);
+    uint8_t *data = blockData(block);
+    uint32_t pos = block->bitLen;
+
+    if (block->count == 0) {
+      block->firstTs = tsMs;
+      writeBits(data, &pos, bits, 64);
+      s->prevDelta = 0;
+      s->prevBits = bits;
+      s->prevLeading = HISTORY_NO_LEADING;
+      s->prevTrailing = 0;
+    } else {
+      // 块写满或时间戳回退时换块，保证块内时间单调
+      if (pos + HISTORY_MAX_RECORD_BITS > blockCapacityBits(store) ||
+          tsMs < s->prevTs) {
+        s->block = -1;
+        continue;
+      }
+      int64_t delta = tsMs - s->prevTs;
+      if (encodeDod(data, &pos, delta - s->prevDelta) != 0) {
+        s->block = -1;
+        continue;
+      }
+      s->prevDelta = delta;
+      encodeValue(data, &pos, s, bits);
+    }
+
+    s->prevTs = tsMs;
+    block->lastTs = tsMs;
+    block->bitLen = pos;
+    block->count++;
+    store->appends++;
+    pthread_mutex_unlock(&store->lock);
+    return 0;
+  }
+
+  pthread_mutex_unlock(&store->lock);
+  return -1;
+}
+
+/* 解码一个块并把[fromMs, toMs)范围内的样本累加到桶中 */
+static void queryBlock(historyBlockHeader_t *block, int64_t fromMs,
+                       int64_t toMs, int64_t stepMs, historyBucket_t *buckets,
+                       int bucketCount) {
+  const uint8_t *data = blockData(block);
+  historyDecoder_t d;
+  memset(&d, 0, sizeof(d));
+  d.ts = block->firstTs;
+
+  for (uint32_t i = 0; i < block->count; i++) {
+    if (i == 0) {
+      d.bits = readBits(data, &d.pos, 64);
+    } else {
+      d.delta += decodeDod(data, &d.pos);
+      d.ts += d.delta;
+      decodeValue(data, &d);
+    }
+
+    if (d.ts >= toMs) {
+      break; // 块内时间单调递增
+    }
+    if (d.ts < fromMs) {
+      continue;
+    }
+
+    int index = (int)((d.ts - fromMs) / stepMs);
+    if (index >= bucketCount) {
+      break;
+    }
+    double value = bitsDouble(d.bits);
+    historyBucket_t *b = &buckets[index];
+    if (b->count == 0 || value < b->min) {
+      b->min = value;
+    }
+    if (b->count == 0 || value > b->max) {
+      b->max = value;
+    }
+    b->sum += value;
+    b->count++;
+  }
+}
+
+/*
+ * @brief 范围查询并降采样
+ *
+ * @param store: 存储
+ *        seriesId: 序列ID
+ *        fromMs/toMs: 查询范围 [fromMs, toMs)
+ *        stepMs: 桶宽度
+ *        buckets: 输出桶数组
+ *        maxBuckets: 桶数组容量
+ *
+ * @return int: 桶的数量，参数错误返回-1
+ * */
+int historyStore_Query(historyStore_t *store, int seriesId, int64_t fromMs,
+                       int64_t toMs, int64_t stepMs, historyBucket_t *buckets,
+                       int maxBuckets) {
+  if (!store || !store->base || seriesId < 0 ||
+      seriesId >= store->seriesCount || toMs <= fromMs || stepMs <= 0 ||
+      maxBuckets <= 0) {
+    return -1;
+  }
+
+  int64_t span = (toMs - fromMs + stepMs - 1) / stepMs;
+  int bucketCount = span < maxBuckets ? (int)span : maxBuckets;
+  for (int i = 0; i < bucketCount; i++) {
+    memset(&buckets[i], 0, sizeof(historyBucket_t));
+    buckets[i].startMs = fromMs + i * stepMs;
+  }
+
+  // 聚合与块的先后顺序无关，按物理顺序扫描即可
+  pthread_mutex_lock(&store->lock);
+  for (uint32_t i = 0; i < store->config.blockCount; i++) {
+    historyBlockHeader_t *block = blockAt(store, i);
+    if (block->magic != HISTORY_BLOCK_MAGIC || block->seriesId != seriesId ||
+        block->count == 0 || block->lastTs < fromMs ||
+        block->firstTs >= toMs) {
+      continue;
+    }
+    queryBlock(block, fromMs, toMs, stepMs, buckets, bucketCount);
+  }
+  pthread_mutex_unlock(&store->lock);
+  return bucketCount;
+}
+
+void historyStore_GetStats(historyStore_t *store, historyStoreStats_t *stats) {
+  memset(stats, 0, sizeof(historyStoreStats_t));
+  if (!store || !store->base) {
+    return;
+  }
+
+  pthread_mutex_lock(&store->lock);
+  stats->seriesCount = store->seriesCount;
+  stats->blockCount = store->config.blockCount;
+  stats->appends = store->appends;
+  for (uint32_t i = 0; i < store->config.blockCount; i++) {
+    historyBlockHeader_t *block = blockAt(store, i);
+    if (block->magic != HISTORY_BLOCK_MAGIC) {
+      continue;
+    }
+    stats->blocksUsed++;
+    stats->samples += block->count;
+    stats->storedBytes += (block->bitLen + 7) / 8;
+  }
+  pthread_mutex_unlock(&store->lock);
+}
+
+void historyStore_Sync(historyStore_t *store) {
+  if (store && store->base) {
+    msync(store->base, store->mapBytes, MS_ASYNC);
+  }
+}
+
+void historyStore_Close(historyStore_t *store) {
+  if (!store || !store->base) {
+    return;
+  }
+
+  pthread_mutex_lock(&store->lock);
+  msync(store->base, store->mapBytes, MS_SYNC);
+  munmap(store->base, store->mapBytes);
+  store->base = NULL;
+  close(store->fd);
+  store->fd = -1;
+  pthread_mutex_unlock(&store->lock);
+}
@@ -0,0 +1,354 @@
+#include "modules/iio_capture.h"
+#include "modules/mem_pool.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define IIO_MAX_READ_SCANS 64
+
+/* 已使能的扫描通道（包括时间戳通道） */
+typedef struct {
+  char element[32];
+  int index;          // scan_elements/<element>_index
+  iioScanType_t type;
+  int offset;         // 在扫描记录中的字节偏移
+  double scale;
+  double valueOffset;
+  int slot;           // 在iioSample_t.values中的位置，-1 表示时间戳通道
+} iioScanChannel_t;
+
+static iioScanChannel_t g_scan[IIO_MAX_CHANNELS + 1];
+static int g_scanCount = 0;
+static int g_scanBytes = 0;
+static int g_valueCount = 0;
+
+static char g_deviceDir[192];
+static int g_devFd = -1;
+static eventLoop_t *g_loop = NULL;
+static uint8_t *g_readBuffer = NULL; // 按扫描长度在初始化时分配
+static int g_readCapacity = 0;
+static int g_carryBytes = 0;         // 上次读取剩余的不完整扫描
+static iioSampleCallback_t g_callback = NULL;
+static void *g_userData = NULL;
+static iioCaptureStats_t g_stats;
+
+static int64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int readAttr(const char *path, char *buffer, size_t size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+  ssize_t n = read(fd, buffer, size - 1);
+  close(fd);
+  if (n <= 0) {
+    return -1;
+  }
+  buffer[n] = '\0';
+  return 0;
+}
+
+static int writeAttr(const char *path, const char *value) {
+  int fd = open(path, O_WRONLY);
+  if (fd < 0) {
+    return -1;
+  }
+  ssize_t n = write(fd, value, strlen(value));
+  close(fd);
+  return n == (ssize_t)strlen(value) ? 0 : -1;
+}
+
+static int writeDeviceAttr(const char *attr, const char *value) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", g_deviceDir, attr);
+  return writeAttr(path, value);
+}
+
+/* 读取可选的浮点属性（如 _scale、_offset），不存在时返回默认值 */
+static double readDeviceDouble(const char *element, const char *suffix,
+                               double def) {
+  char path[256];
+  char buffer[32];
+  snprintf(path, sizeof(path), "%s/%s_%s", g_deviceDir, element, suffix);
+  if (readAttr(path, buffer, sizeof(buffer)) != 0) {
+    return def;
+  }
+  return strtod(buffer, NULL);
+}
+
+/*
+ * @brief 解析scan_elements类型描述符
+ *
+ * @param desc: 形如 "le:s12/16>>4" 的字符串（"be"/"le"，"s"/"u"）
+ *        type: 输出
+ *
+ * @return 0 成功，-1 格式错误或不支持（repeat > 1）
+ * */
+int iioCapture_ParseType(const char *desc, iioScanType_t *type) {
+  char endian[3] = {0};
+  char sign = 0;
+  unsigned bits = 0, storage = 0, shift = 0;
+
+  if (!desc || !type ||
+      sscanf(desc, "%2[bl]e:%c%u/%u>>%u", endian, &sign, &bits, &storage,
+             &shift) != 5) {
+    return -1;
+  }
+  if ((sign != 's' && sign != 'u') || bits == 0 || bits > storage ||
+      (storage != 8 && storage != 16 && storage != 32 && storage != 64) ||
+      shift + bits > storage) {
+    return -1;
+  }
+
+  type->bigEndian = endian[0] == 'b';
+  type->isSigned = sign == 's';
+  type->bits = bits;
+  type->storageBits = storage;
+  type->shift = shift;
+  return 0;
+}
+
+/* 按类型描述符从扫描记录中取出一个通道的原始值 */
+static int64_t decodeChannel(const uint8_t *record, const iioScanChannel_t *ch) {
+  int bytes = ch->type.storageBits / 8;
+  const uint8_t *p = record + ch->offset;
+  uint64_t value = 0;
+
+  for (int i = 0; i < bytes; i++) {
+    int b = ch->type.bigEndian ? i : bytes - 1 - i;
+    value = (value << 8) | p[b];
+  }
+
+  value >>= ch->type.shift;
+  if (ch->type.bits < 64) {
+    value &= (1ULL << ch->type.bits) - 1;
+    if (ch->type.isSigned && (value & (1ULL << (ch->type.bits - 1)))) {
+      value |= ~((1ULL << ch->type.bits) - 1);
+    }
+  }
+  return (int64_t)value;
+}
+
+static void decodeScan(const uint8_t *record, int64_t readNs) {
+  iioSample_t sample;
+  sample.channelCount = g_valueCount;
+  sample.timestampNs = readNs;
+
+  for (int i = 0; i < g_scanCount; i++) {
+    const iioScanChannel_t *ch = &g_scan[i];
+    int64_t raw = decodeChannel(record, ch);
+    if (ch->slot < 0) {
+      sample.timestampNs = raw;
+      continue;
+    }
+    sample.raw[ch->slot] = raw;
+    sample.values[ch->slot] = ((double)raw + ch->valueOffset) * ch->scale;
+  }
+
+  g_stats.samples++;
+  if (g_callback) {
+    g_callback(&sample, g_userData);
+  }
+}
+
+/* 字符设备可读：批量读取完整的扫描记录并逐条解码 */
+static void deviceReadHandle(int fd, uint32_t events, void *userData) {
+  ssize_t n = read(fd, g_readBuffer + g_carryBytes,
+                   g_readCapacity - g_carryBytes);
+  if (n <= 0) {
+    if (n < 0 && errno != EAGAIN && errno != EINTR) {
+      perror("Error reading IIO buffer");
+    }
+    return;
+  }
+
+  g_stats.reads++;
+  g_stats.bytes += n;
+  int64_t readNs = nowNs();
+  int total = g_carryBytes + (int)n;
+  int scans = total / g_scanBytes;
+  for (int i = 0; i < scans; i++) {
+    decodeScan(g_readBuffer + i * g_scanBytes, readNs);
+  }
+
+  g_carryBytes = total - scans * g_scanBytes;
+  if (g_carryBytes > 0) {
+    memmove(g_readBuffer, g_readBuffer + scans * g_scanBytes, g_carryBytes);
+  }
+}
+
+/* 使能一个scan element并读取其索引和类型 */
+static int enableScanElement(const char *element, int slot) {
+  char path[256];
+  char buffer[32];
+  iioScanChannel_t *ch = &g_scan[g_scanCount];
+  memset(ch, 0, sizeof(iioScanChannel_t));
+  snprintf(ch->element, sizeof(ch->element), "%s", element);
+  ch->slot = slot;
+
+  snprintf(path, sizeof(path), "%s/scan_elements/%s_en", g_deviceDir, element);
+  if (writeAttr(path, "1") != 0) {
+    fprintf(stderr, "Error enabling IIO channel %s.\n", element);
+    return -1;
+  }
+
+  snprintf(path, sizeof(path), "%s/scan_elements/%s_index", g_deviceDir,
+           element);
+  if (readAttr(path, buffer, sizeof(buffer)) != 0) {
+    fprintf(stderr, "Error reading IIO channel index %s.\n", element);
+    return -1;
+  }
+  ch->index = atoi(buffer);
+
+  snprintf(path, sizeof(path), "%s/scan_elements/%s_type", g_deviceDir,
+           element);
+  if (readAttr(path, buffer, sizeof(buffer)) != 0 ||
+      iioCapture_ParseType(buffer, &ch->type) != 0) {
+    fprintf(stderr, "Invalid IIO channel type %s.\n", element);
+    return -1;
+  }
+
+  ch->scale = slot < 0 ? 1.0 : readDeviceDouble(element, "scale", 1.0);
+  ch->valueOffset = slot < 0 ? 0.0 : readDeviceDouble(element, "offset", 0.0);
+  g_scanCount++;
+  return 0;
+}
+
+/*
+ * @brief 按索引排序通道并计算扫描记录布局：每个通道按自身存储长度对齐，
+ *        记录总长度按最大存储长度对齐（与内核 iio_compute_scan_bytes 一致）
+ * */
+static void computeLayout(void) {
+  for (int i = 1; i < g_scanCount; i++) {
+    iioScanChannel_t tmp = g_scan[i];
+    int j = i - 1;
+    while (j >= 0 && g_scan[j].index > tmp.index) {
+      g_scan[j + 1] = g_scan[j];
+      j--;
+    }
+    g_scan[j + 1] = tmp;
+  }
+
+  int offset = 0;
+  int maxBytes = 1;
+  for (int i = 0; i < g_scanCount; i++) {
+    int bytes = g_scan[i].type.storageBits / 8;
+    offset = (offset + bytes - 1) / bytes * bytes;
+    g_scan[i].offset = offset;
+    offset += bytes;
+    if (bytes > maxBytes) {
+      maxBytes = bytes;
+    }
+  }
+  g_scanBytes = (offset + maxBytes - 1) / maxBytes * maxBytes;
+}
+
+/*
+ * @brief 初始化IIO触发缓冲采集
+ *
+ * @param config: 采集配置
+ *        loop: 共享的事件循环
+ *        callback: 样本回调
+ *        userData: 回调参数
+ *
+ * @return 0 成功
+ * */
+int iioCapture_Init(const iioCaptureConfig_t *config, eventLoop_t *loop,
+                    iioSampleCallback_t callback, void *userData) {
+  if (!config || !loop || config->channelCount <= 0) {
+    return -1;
+  }
+
+  g_loop = loop;
+  g_callback = callback;
+  g_userData = userData;
+  g_scanCount = 0;
+  g_carryBytes = 0;
+  memset(&g_stats, 0, sizeof(g_stats));
+  snprintf(g_deviceDir, sizeof(g_deviceDir), "%s/%s", config->sysfsRoot,
+           config->device);
+
+  // 修改扫描配置前缓冲区必须处于关闭状态
+  writeDeviceAttr("buffer/enable", "0");
+
+  for (int i = 0; i < config->channelCount && i < IIO_MAX_CHANNELS; i++) {
+    if (enableScanElement(config->channels[i].element, i) != 0) {
+      return -1;
+    }
+  }
+  g_valueCount = g_scanCount;
+  // 没有时间戳通道的设备退化为读取时刻
+  if (config->timestamp && enableScanElement("in_timestamp", -1) != 0) {
+    fprintf(stderr, "IIO timestamp channel unavailable, using read time.\n");
+  }
+  computeLayout();
+  g_stats.scanBytes = g_scanBytes;
+
+  if (config->trigger[0] != '\0' &&
+      writeDeviceAttr("trigger/current_trigger", config->trigger) != 0) {
+    fprintf(stderr, "Error setting IIO trigger %s.\n", config->trigger);
+    return -1;
+  }
+
+  char value[16];
+  snprintf(value, sizeof(value), "%d",
+           config->bufferLength > 0 ? config->bufferLength : 64);
+  if (writeDeviceAttr("buffer/length", value) != 0) {
+    fprintf(stderr, "Error setting IIO buffer length.\n");
+    return -1;
+  }
+  int watermark = config->watermark > 0 ? config->watermark : 1;
+  snprintf(value, sizeof(value), "%d", watermark);
+  // watermark 在较早的内核上不存在，失败时按每次唤醒一个扫描处理
+  writeDeviceAttr("buffer/watermark", value);
+
+  // 读缓冲区容纳两个watermark，一次read取走内核唤醒时积累的全部扫描
+  int readScans = watermark * 2;
+  if (readScans > IIO_MAX_READ_SCANS) {
+    readScans = IIO_MAX_READ_SCANS;
+  }
+  g_readCapacity = readScans * g_scanBytes;
+  g_readBuffer = (uint8_t *)memPool_Alloc(g_readCapacity);
+  if (g_readBuffer == NULL) {
+    return -1;
+  }
+
+  if (writeDeviceAttr("buffer/enable", "1") != 0) {
+    fprintf(stderr, "Error enabling IIO buffer.\n");
+    return -1;
+  }
+
+  char devPath[128];
+  snprintf(devPath, sizeof(devPath), "%s/%s", config->devRoot, config->device);
+  g_devFd = open(devPath, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (g_devFd < 0) {
+    fprintf(stderr, "Error opening %s: %s\n", devPath, strerror(errno));
+    writeDeviceAttr("buffer/enable", "0");
+    return -1;
+  }
+
+  if (eventLoop_AddFd(loop, g_devFd, EPOLLIN, deviceReadHandle, NULL) != 0) {
+    iioCapture_Deinit();
+    return -1;
+  }
+  return 0;
+}
+
+void iioCapture_GetStats(iioCaptureStats_t *stats) { *stats = g_stats; }
+
+void iioCapture_Deinit(void) {
+  if (g_devFd >= 0) {
+    eventLoop_RemoveFd(g_loop, g_devFd);
+    close(g_devFd);
+    g_devFd = -1;
+  }
+  writeDeviceAttr("buffer/enable", "0");
+}
@@ -1,30 +1,52 @@
 #include "ap3216c_linux.h"
+#include <fcntl.h>
 #include <stdio.h>
 #include <unistd.h>
 
+/*
+ * @brief   Read an integer value from a sysfs attribute. open/read is used
+ *          instead of stdio so that sampling does not heap allocate.
+ *
+ * @param   path: The sysfs attribute path
+ *          value: Output value
+ *
+ * @return  int:  0 on success, -1 on open error, -2 on parse error
+ * */
+static int ap3216c_linux_readValue(const char *path, int *value) {
+  char buffer[32];
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+
+  ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+  close(fd);
+  if (n <= 0) {
+    return -2;
+  }
+  buffer[n] = '\0';
+
+  return sscanf(buffer, "%d", value) == 1 ? 0 : -2;
+}
+
 /*
  * @brief   Get the ambient light intensity data
  *
  * @return  int:  ambient light intensity data
  * */
 int ap3216c_linux_getAlsData(void) {
-  FILE *fd;
   int als;
+  int rc = ap3216c_linux_readValue(AP3216C_ALS_FILE, &als);
 
-  // open ALS file
-  if ((fd = fopen(AP3216C_ALS_FILE, "r")) == NULL) {
+  if (rc == -1) {
     perror("Error opening ALS file");
     return -1;
   }
-
-  // read ALS data
-  if ((fscanf(fd, "%d", &als)) != 1) {
+  if (rc != 0) {
     perror("Error reading ALS data");
-    fclose(fd);
     return -1;
   }
 
-  fclose(fd);
   return als;
 }
 
@@ -34,23 +56,18 @@ int ap3216c_linux_getAlsData(void) {
  * @return  int:  approching distance data
  * */
 int ap3216c_linux_getPsData(void) {
-  FILE *fd;
   int ps;
+  int rc = ap3216c_linux_readValue(AP3216C_PS_FILE, &ps);
 
-  // open ALS file
-  if ((fd = fopen(AP3216C_PS_FILE, "r")) == NULL) {
+  if (rc == -1) {
     perror("Error opening PS file");
     return -1;
   }
-
-  // read ALS data
-  if ((fscanf(fd, "%d", &ps)) != 1) {
+  if (rc != 0) {
     perror("Error reading PS data");
-    fclose(fd);
     return -1;
   }
 
-  fclose(fd);
   return ps;
 }
 
@@ -60,22 +77,17 @@ int ap3216c_linux_getPsData(void) {
  * @return  int:  infraed intensity data
  * */
 int ap3216c_linux_getIrData(void) {
-  FILE *fd;
   int ir;
+  int rc = ap3216c_linux_readValue(AP3216C_IR_FILE, &ir);
 
-  // open ALS file
-  if ((fd = fopen(AP3216C_IR_FILE, "r")) == NULL) {
+  if (rc == -1) {
     perror("Error opening IR file");
     return -1;
   }
-
-  // read ALS data
-  if ((fscanf(fd, "%d", &ir)) != 1) {
-    perror("Error reading ALS data");
-    fclose(fd);
+  if (rc != 0) {
+    perror("Error reading IR data");
     return -1;
   }
 
-  fclose(fd);
   return ir;
 }
@@ -0,0 +1,227 @@
+#include "modules/local_api.h"
+#include "modules/mem_pool.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define LOCAL_API_RESPONSE_MAX 4096
+
+/* 客户端连接，请求缓冲区在初始化时按maxClients一次性分配 */
+typedef struct {
+  int fd; // -1 表示空闲
+  int inLen;
+  char inBuf[LOCAL_API_LINE_MAX];
+} localApiClient_t;
+
+static localApiConfig_t g_config;
+static eventLoop_t *g_loop = NULL;
+static const valueTable_t *g_table = NULL;
+static int g_listenFd = -1;
+static localApiClient_t *g_clients = NULL;
+static localApiStats_t g_stats;
+
+static void closeClient(localApiClient_t *client) {
+  eventLoop_RemoveFd(g_loop, client->fd);
+  close(client->fd);
+  client->fd = -1;
+  client->inLen = 0;
+}
+
+static int formatEntry(char *buffer, size_t size, const valueSnapshot_t *s) {
+  return snprintf(buffer, size, "%s %.9g %lld\n", s->name, s->value,
+                  (long long)s->tsMs);
+}
+
+/* 处理一行请求，返回响应长度 */
+static int handleRequest(const char *line, char *out, size_t size) {
+  g_stats.requests++;
+
+  if (strcmp(line, "PING") == 0) {
+    return snprintf(out, size, "OK pong\n");
+  }
+
+  if (strncmp(line, "GET ", 4) == 0) {
+    int index = valueTable_Find(g_table, line + 4);
+    valueSnapshot_t snapshot;
+    if (index < 0) {
+      return snprintf(out, size, "ERR unknown\n");
+    }
+    if (valueTable_Read(g_table, index, &snapshot) != 0) {
+      return snprintf(out, size, "ERR busy\n");
+    }
+    int len = snprintf(out, size, "OK ");
+    return len + formatEntry(out + len, size - len, &snapshot);
+  }
+
+  if (strcmp(line, "LIST") == 0) {
+    int count = valueTable_Count(g_table);
+    int len = snprintf(out, size, "OK %d\n", count);
+    for (int i = 0; i < count && len < (int)size; i++) {
+      valueSnapshot_t snapshot;
+      if (valueTable_Read(g_table, i, &snapshot) != 0) {
+        // 保持行数与声明一致
+        snprintf(snapshot.name, sizeof(snapshot.name), "%s",
+                 g_table->shm->entries[i].name);
+        snapshot.value = 0;
+        snapshot.tsMs = -1;
+      }
+      len += formatEntry(out + len, size - len, &snapshot);
+    }
+    return len < (int)size ? len : (int)size - 1;
+  }
+
+  return snprintf(out, size, "ERR bad request\n");
+}
+
+/*
+ * @brief 客户端可读：按行处理请求。响应一次性非阻塞发送，
+ *        发送缓冲区已满的客户端直接断开，不在网关侧积压数据
+ * */
+static void clientReadHandle(int fd, uint32_t events, void *userData) {
+  localApiClient_t *client = (localApiClient_t *)userData;
+
+  ssize_t n = read(fd, client->inBuf + client->inLen,
+                   sizeof(client->inBuf) - client->inLen);
+  if (n <= 0) {
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+      return;
+    }
+    closeClient(client);
+    return;
+  }
+  client->inLen += n;
+
+  char response[LOCAL_API_RESPONSE_MAX];
+  int start = 0;
+  for (int i = 0; i < client->inLen; i++) {
+    if (client->inBuf[i] != '\n') {
+      continue;
+    }
+    client->inBuf[i] = '\0';
+    if (i > start && client->inBuf[i - 1] == '\r') {
+      client->inBuf[i - 1] = '\0';
+    }
+
+    int len = handleRequest(client->inBuf + start, response, sizeof(response));
+    if (send(fd, response, len, MSG_DONTWAIT | MSG_NOSIGNAL) != len) {
+      g_stats.dropped++;
+      closeClient(client);
+      return;
+    }
+    start = i + 1;
+  }
+
+  // 保留不完整的行；超长的行视为错误
+  client->inLen -= start;
+  memmove(client->inBuf, client->inBuf + start, client->inLen);
+  if (client->inLen == sizeof(client->inBuf)) {
+    static const char tooLong[] = "ERR line too long\n";
+    send(fd, tooLong, sizeof(tooLong) - 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+    closeClient(client);
+  }
+}
+
+static void acceptHandle(int fd, uint32_t events, void *userData) {
+  int clientFd;
+  while ((clientFd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >=
+         0) {
+    localApiClient_t *client = NULL;
+    for (int i = 0; i < g_config.maxClients; i++) {
+      if (g_clients[i].fd < 0) {
+        client = &g_clients[i];
+        break;
+      }
+    }
+
+    if (client == NULL ||
+        eventLoop_AddFd(g_loop, clientFd, EPOLLIN, clientReadHandle, client) !=
+            0) {
+      g_stats.rejected++;
+      close(clientFd);
+      continue;
+    }
+    client->fd = clientFd;
+    client->inLen = 0;
+    g_stats.accepted++;
+  }
+}
+
+/*
+ * @brief 创建Unix域套接字并注册到事件循环
+ *
+ * @param config: 配置
+ *        loop: 共享的事件循环
+ *        table: 最新值表
+ *
+ * @return 0 成功
+ * */
+int localApi_Init(const localApiConfig_t *config, eventLoop_t *loop,
+                  const valueTable_t *table) {
+  if (!config || !loop || !table || config->maxClients <= 0) {
+    return -1;
+  }
+
+  g_config = *config;
+  g_loop = loop;
+  g_table = table;
+  memset(&g_stats, 0, sizeof(g_stats));
+
+  g_clients = (localApiClient_t *)memPool_Alloc(config->maxClients *
+                                                sizeof(localApiClient_t));
+  if (g_clients == NULL) {
+    return -1;
+  }
+  for (int i = 0; i < config->maxClients; i++) {
+    g_clients[i].fd = -1;
+    g_clients[i].inLen = 0;
+  }
+
+  g_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (g_listenFd < 0) {
+    perror("Error creating local API socket");
+    return -1;
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", config->socketPath);
+  unlink(config->socketPath); // 上次运行遗留的套接字文件
+
+  if (bind(g_listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(g_listenFd, config->maxClients) != 0) {
+    fprintf(stderr, "Error binding local API socket %s: %s\n",
+            config->socketPath, strerror(errno));
+    close(g_listenFd);
+    g_listenFd = -1;
+    return -1;
+  }
+  chmod(config->socketPath, 0660);
+
+  if (eventLoop_AddFd(loop, g_listenFd, EPOLLIN, acceptHandle, NULL) != 0) {
+    localApi_Deinit();
+    return -1;
+  }
+  return 0;
+}
+
+void localApi_GetStats(localApiStats_t *stats) { *stats = g_stats; }
+
+void localApi_Deinit(void) {
+  for (int i = 0; g_clients && i < g_config.maxClients; i++) {
+    if (g_clients[i].fd >= 0) {
+      closeClient(&g_clients[i]);
+    }
+  }
+
+  if (g_listenFd >= 0) {
+    eventLoop_RemoveFd(g_loop, g_listenFd);
+    close(g_listenFd);
+    g_listenFd = -1;
+    unlink(g_config.socketPath);
+  }
+}
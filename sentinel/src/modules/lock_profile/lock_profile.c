@@ -0,0 +1,238 @@
+#include "modules/lock_profile.h"
+#include "modules/sim_clock.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* 每个线程同时持有的锁一般不超过2把，超出的不统计持有时间 */
+#define HELD_MAX 8
+
+typedef struct {
+  pthread_mutex_t *mutex;
+  lockSite_t *site;
+  int64_t sinceNs;
+} heldLock_t;
+
+static int g_enabled = 0;
+static lockSite_t *g_sites = NULL; // 只增不减，读者无需加锁
+
+static __thread heldLock_t t_held[HELD_MAX];
+static __thread int t_heldCount = 0;
+
+static int64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int bucketOf(uint32_t us) {
+  int bucket = 0;
+  while (us > 0 && bucket < LOCK_PROFILE_BUCKETS - 1) {
+    us >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+/* 直方图和最大值按微秒统计，总时间按纳秒累加，不足1微秒的临界区也计入 */
+static void addSample(unsigned long *hist, uint64_t *totalNs, uint32_t *max,
+                      int64_t ns) {
+  if (ns < 0) {
+    ns = 0;
+  }
+  uint32_t us = (uint32_t)(ns / 1000);
+  __atomic_add_fetch(&hist[bucketOf(us)], 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(totalNs, (uint64_t)ns, __ATOMIC_RELAXED);
+  uint32_t prev = __atomic_load_n(max, __ATOMIC_RELAXED);
+  while (us > prev && !__atomic_compare_exchange_n(max, &prev, us, true,
+                                                   __ATOMIC_RELAXED,
+                                                   __ATOMIC_RELAXED)) {
+  }
+}
+
+static void registerSite(lockSite_t *site) {
+  int expected = 0;
+  if (__atomic_load_n(&site->registered, __ATOMIC_ACQUIRE) ||
+      !__atomic_compare_exchange_n(&site->registered, &expected, 1, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  site->next = __atomic_load_n(&g_sites, __ATOMIC_ACQUIRE);
+  while (!__atomic_compare_exchange_n(&g_sites, &site->next, site, true,
+                                      __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+  }
+}
+
+/* 在本线程持有的锁中查找（从最近加锁的开始） */
+static int findHeld(pthread_mutex_t *mutex) {
+  for (int i = t_heldCount - 1; i >= 0; i--) {
+    if (t_held[i].mutex == mutex) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void recordHold(const heldLock_t *held, int64_t now) {
+  lockSite_t *site = held->site;
+  addSample(site->holdHist, &site->holdTotalNs, &site->holdMaxUs,
+            now - held->sinceNs);
+}
+
+void lockProfile_SetEnabled(bool enabled) {
+  __atomic_store_n(&g_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+bool lockProfile_IsEnabled(void) {
+  return __atomic_load_n(&g_enabled, __ATOMIC_RELAXED) != 0;
+}
+
+/*
+ * @brief 加锁并记录等待时间。先尝试trylock，未争用时不计入 contended
+ * */
+void lockProfile_Lock(pthread_mutex_t *mutex, lockSite_t *site) {
+  if (!lockProfile_IsEnabled()) {
+    simClock_Lock(mutex);
+    return;
+  }
+
+  registerSite(site);
+  int64_t start = nowNs();
+  if (pthread_mutex_trylock(mutex) != 0) {
+    simClock_Lock(mutex);
+    __atomic_add_fetch(&site->contended, 1, __ATOMIC_RELAXED);
+  }
+  int64_t acquired = nowNs();
+  __atomic_add_fetch(&site->acquisitions, 1, __ATOMIC_RELAXED);
+  addSample(site->waitHist, &site->waitTotalNs, &site->waitMaxUs,
+            acquired - start);
+
+  if (t_heldCount < HELD_MAX) {
+    t_held[t_heldCount].mutex = mutex;
+    t_held[t_heldCount].site = site;
+    t_held[t_heldCount].sinceNs = acquired;
+    t_heldCount++;
+  }
+}
+
+void lockProfile_Unlock(pthread_mutex_t *mutex) {
+  // 加锁时未启用（或超出 HELD_MAX）的锁找不到记录，直接解锁
+  int i = findHeld(mutex);
+  if (i >= 0) {
+    recordHold(&t_held[i], nowNs());
+    t_heldCount--;
+    memmove(&t_held[i], &t_held[i + 1],
+            sizeof(heldLock_t) * (t_heldCount - i));
+  }
+  pthread_mutex_unlock(mutex);
+}
+
+int lockProfile_CondWait(pthread_cond_t *cond, pthread_mutex_t *mutex) {
+  return lockProfile_CondTimedWait(cond, mutex, NULL);
+}
+
+/*
+ * @brief 条件变量等待期间锁被释放：等待前结束本段持有时间，
+ *        唤醒并重新获得锁后开始新的一段
+ *
+ * @param deadline: 绝对超时时间，NULL 表示一直等待
+ * */
+int lockProfile_CondTimedWait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                              const struct timespec *deadline) {
+  int i = findHeld(mutex);
+  if (i >= 0) {
+    recordHold(&t_held[i], nowNs());
+  }
+
+  int rc = simClock_CondTimedWait(cond, mutex, deadline);
+
+  if (i >= 0) {
+    t_held[i].sinceNs = nowNs();
+  }
+  return rc;
+}
+
+/* 直方图的99分位数，取所在桶的上界 */
+static uint32_t percentile99(const unsigned long *hist) {
+  unsigned long counts[LOCK_PROFILE_BUCKETS];
+  unsigned long total = 0;
+  for (int i = 0; i < LOCK_PROFILE_BUCKETS; i++) {
+    counts[i] = __atomic_load_n(&hist[i], __ATOMIC_RELAXED);
+    total += counts[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  unsigned long threshold = total - total / 100;
+  unsigned long cumulative = 0;
+  for (int i = 0; i < LOCK_PROFILE_BUCKETS; i++) {
+    cumulative += counts[i];
+    if (cumulative >= threshold) {
+      return i == 0 ? 1 : 1u << i;
+    }
+  }
+  return 1u << (LOCK_PROFILE_BUCKETS - 1);
+}
+
+static void snapshotSite(const lockSite_t *site, lockSiteStats_t *out) {
+  const char *file = strrchr(site->file, '/');
+  snprintf(out->name, sizeof(out->name), "%s:%d %s",
+           file ? file + 1 : site->file, site->line, site->func);
+  out->acquisitions = __atomic_load_n(&site->acquisitions, __ATOMIC_RELAXED);
+  out->contended = __atomic_load_n(&site->contended, __ATOMIC_RELAXED);
+  out->waitTotalNs = __atomic_load_n(&site->waitTotalNs, __ATOMIC_RELAXED);
+  out->holdTotalNs = __atomic_load_n(&site->holdTotalNs, __ATOMIC_RELAXED);
+  out->waitMaxUs = __atomic_load_n(&site->waitMaxUs, __ATOMIC_RELAXED);
+  out->holdMaxUs = __atomic_load_n(&site->holdMaxUs, __ATOMIC_RELAXED);
+  out->waitP99Us = percentile99(site->waitHist);
+  out->holdP99Us = percentile99(site->holdHist);
+}
+
+/*
+ * @brief 输出统计快照，按总持有时间从大到小排序（插入排序，只保留前 max 个）
+ *
+ * @return 输出的个数
+ * */
+int lockProfile_GetSites(lockSiteStats_t *out, int max) {
+  int count = 0;
+  for (lockSite_t *site = __atomic_load_n(&g_sites, __ATOMIC_ACQUIRE); site;
+       site = site->next) {
+    lockSiteStats_t stats;
+    snapshotSite(site, &stats);
+    if (stats.acquisitions == 0) {
+      continue;
+    }
+
+    int pos = count < max ? count : max;
+    while (pos > 0 && out[pos - 1].holdTotalNs < stats.holdTotalNs) {
+      if (pos < max) {
+        out[pos] = out[pos - 1];
+      }
+      pos--;
+    }
+    if (pos < max) {
+      out[pos] = stats;
+      if (count < max) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+void lockProfile_Reset(void) {
+  for (lockSite_t *site = __atomic_load_n(&g_sites, __ATOMIC_ACQUIRE); site;
+       site = site->next) {
+    __atomic_store_n(&site->acquisitions, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&site->contended, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&site->waitTotalNs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&site->holdTotalNs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&site->waitMaxUs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&site->holdMaxUs, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < LOCK_PROFILE_BUCKETS; i++) {
+      __atomic_store_n(&site->waitHist[i], 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&site->holdHist[i], 0, __ATOMIC_RELAXED);
+    }
+  }
+}
@@ -0,0 +1,1060 @@
+#include "modules/logger.h"
+#include "modules/mem_pool.h"
+#include "modules/sim_clock.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+/* 参数类型，按格式串中的长度修饰符区分，格式化时还原为原类型 */
+enum {
+  ARG_NONE = -1,
+  ARG_INT,
+  ARG_LONG,
+  ARG_LLONG,
+  ARG_SIZE,
+  ARG_DOUBLE,
+  ARG_LDOUBLE,
+  ARG_STR,
+  ARG_PTR,
+};
+
+enum { RECORD_MESSAGE, RECORD_REPEAT, RECORD_LIMITED };
+
+enum { RING_FREE, RING_ACTIVE, RING_CLOSING };
+
+#define RECORD_HEADER_BYTES 32
+#define RECORD_STRING_BYTES                                                    \
+  (LOGGER_RECORD_BYTES - RECORD_HEADER_BYTES - 8 * LOGGER_MAX_ARGS)
+#define STRING_NULL 0xffff
+#define STRING_TRUNC 0xfffe // 前面的字符串参数已占满 strings
+#define SPEC_MAX 32
+#define LINE_MAX_BYTES 512
+#define WRITE_BUFFER_BYTES (16 * 1024)
+#define DRAIN_BATCH 1024 // 每次最多连续处理的记录数，之后先写出
+
+/* 一条记录：只保存格式串指针和参数，字符串参数复制到 strings */
+typedef struct {
+  loggerSite_t *site;
+  const char *format;
+  int64_t timeNs; // 墙上时间（simClock_RealtimeNs）
+  int32_t tid;
+  uint8_t level;
+  uint8_t kind;
+  uint8_t argCount;
+  uint8_t strUsed;
+  uint64_t args[LOGGER_MAX_ARGS];
+  char strings[RECORD_STRING_BYTES];
+} logRecord_t;
+
+/* 单生产者（所属线程）单消费者（后台线程）的环形缓冲 */
+typedef struct {
+  logRecord_t *records;
+  uint32_t mask;
+  int state;
+  int tid;
+  char pad0[64];
+  uint32_t tail; // 生产者写
+  unsigned long dropped;
+  char pad1[64];
+  uint32_t head; // 消费者写
+  char pad2[64];
+} logRing_t;
+
+/* 格式串中的一个转换说明 */
+typedef struct {
+  int stars; // 宽度、精度中的 * 个数，各占一个int参数
+  int type;
+  char conv;
+} logSpec_t;
+
+int g_loggerLevel = LOG_LEVEL_INFO;
+
+static loggerConfig_t g_config;
+static char g_path[256];
+static logRing_t *g_rings = NULL;
+static int g_ringCount = 0;
+static int g_generation = 0; // 每次初始化加一，线程据此丢弃旧的缓冲
+static int g_running = 0;
+static pthread_key_t g_ringKey;
+static bool g_keyCreated = false;
+static __thread logRing_t *t_ring = NULL;
+static __thread int t_generation = 0;
+
+static pthread_t g_writer;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond;      // 唤醒后台线程
+static pthread_cond_t g_flushCond; // 一轮写入完成
+static bool g_stopping = false;
+static unsigned long g_flushRequest = 0;
+static unsigned long g_flushDone = 0;
+
+static loggerSite_t *g_sites = NULL; // 只增不减，读者无需加锁
+static loggerSite_t g_dynamicSites[LOGGER_DYNAMIC_SITES];
+static loggerSite_t g_overflowSite = {.parsedArgs = -1};
+
+// 输出目标，后台线程和同步输出的线程共用
+static pthread_mutex_t g_sinkLock = PTHREAD_MUTEX_INITIALIZER;
+static int g_fd = STDERR_FILENO;
+static long g_fileBytes = 0;
+static loggerStats_t g_stats;
+
+// 后台线程的写缓冲
+static char g_buffer[WRITE_BUFFER_BYTES];
+static int g_bufferLen = 0;
+
+static const char *g_levelNames[] = {"error", "warn", "info", "debug"};
+static const char *g_levelTags[] = {"ERROR", "WARN ", "INFO ", "DEBUG"};
+
+static int64_t monotonicMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void initMonotonicCond(pthread_cond_t *cond) {
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+void logger_SetLevel(int level) {
+  if (level < LOG_LEVEL_ERROR) {
+    level = LOG_LEVEL_ERROR;
+  } else if (level > LOG_LEVEL_DEBUG) {
+    level = LOG_LEVEL_DEBUG;
+  }
+  __atomic_store_n(&g_loggerLevel, level, __ATOMIC_RELAXED);
+}
+
+int logger_ParseLevel(const char *name) {
+  for (int i = 0; name && i <= LOG_LEVEL_DEBUG; i++) {
+    if (strcmp(name, g_levelNames[i]) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+const char *logger_LevelName(int level) {
+  return level >= 0 && level <= LOG_LEVEL_DEBUG ? g_levelNames[level]
+                                                : "unknown";
+}
+
+/*
+ * @brief 解析 % 之后的一个转换说明（标志、宽度、精度、长度修饰符）
+ *
+ * @return 指向转换字符的指针，格式串不完整时指向结束符
+ * */
+static const char *parseSpec(const char *p, logSpec_t *spec) {
+  spec->stars = 0;
+  spec->type = ARG_NONE;
+  while (*p && strchr("-+ #0'I", *p)) {
+    p++;
+  }
+  if (*p == '*') {
+    spec->stars++;
+    p++;
+  }
+  while (*p >= '0' && *p <= '9') {
+    p++;
+  }
+  if (*p == '.') {
+    p++;
+    if (*p == '*') {
+      spec->stars++;
+      p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+      p++;
+    }
+  }
+
+  int length = ARG_INT;
+  bool longDouble = false;
+  bool wide = false;
+  for (;; p++) {
+    if (*p == 'h') {
+      continue;
+    } else if (*p == 'l') {
+      length = length == ARG_LONG ? ARG_LLONG : ARG_LONG;
+      wide = true;
+    } else if (*p == 'q' || *p == 'j') {
+      length = ARG_LLONG;
+    } else if (*p == 'z' || *p == 't') {
+      length = ARG_SIZE;
+    } else if (*p == 'L') {
+      longDouble = true;
+    } else {
+      break;
+    }
+  }
+
+  spec->conv = *p;
+  switch (*p) {
+  case 'd':
+  case 'i':
+  case 'o':
+  case 'u':
+  case 'x':
+  case 'X':
+  case 'c':
+    spec->type = length;
+    break;
+  case 'e':
+  case 'E':
+  case 'f':
+  case 'F':
+  case 'g':
+  case 'G':
+  case 'a':
+  case 'A':
+    spec->type = longDouble ? ARG_LDOUBLE : ARG_DOUBLE;
+    break;
+  case 's':
+    spec->type = wide ? ARG_PTR : ARG_STR;
+    break;
+  case 'p':
+  case 'n':
+    spec->type = ARG_PTR;
+    break;
+  default:
+    break;
+  }
+  return p;
+}
+
+/* 按顺序列出格式串需要的参数类型，返回个数（最多 LOGGER_MAX_ARGS） */
+static int parseFormat(const char *format, uint8_t *types) {
+  int count = 0;
+  for (const char *p = format; *p; p++) {
+    if (*p != '%') {
+      continue;
+    }
+    if (p[1] == '%') {
+      p++;
+      continue;
+    }
+    logSpec_t spec;
+    p = parseSpec(p + 1, &spec);
+    for (int i = 0; i < spec.stars && count < LOGGER_MAX_ARGS; i++) {
+      types[count++] = ARG_INT;
+    }
+    if (spec.type != ARG_NONE && count < LOGGER_MAX_ARGS) {
+      types[count++] = (uint8_t)spec.type;
+    }
+    if (!*p || count == LOGGER_MAX_ARGS) {
+      break;
+    }
+  }
+  return count;
+}
+
+static uint64_t hashMix(uint64_t hash, uint64_t value) {
+  return (hash ^ value) * 0x100000001b3ULL;
+}
+
+/*
+ * @brief 按参数类型从 va_list 取出参数保存到记录中（字符串复制内容）
+ *
+ * @return 格式串和参数的哈希，用于判断与上一条消息是否相同
+ * */
+static uint64_t captureArgs(loggerSite_t *site, const char *format,
+                            logRecord_t *rec, va_list ap) {
+  uint8_t local[LOGGER_MAX_ARGS];
+  const uint8_t *types = site->argTypes;
+  int count;
+  int parsed = __atomic_load_n(&site->parsedArgs, __ATOMIC_ACQUIRE);
+  if (parsed > 0) {
+    count = parsed - 1;
+  } else {
+    // 首次调用时解析格式串，结果缓存在位置中；-1 表示正在写入或不缓存
+    count = parseFormat(format, local);
+    types = local;
+    int expected = 0;
+    if (__atomic_compare_exchange_n(&site->parsedArgs, &expected, -1, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      memcpy(site->argTypes, local, count);
+      __atomic_store_n(&site->parsedArgs, count + 1, __ATOMIC_RELEASE);
+    }
+  }
+
+  uint64_t hash = hashMix(0xcbf29ce484222325ULL, (uintptr_t)format);
+  rec->argCount = (uint8_t)count;
+  rec->strUsed = 0;
+  for (int i = 0; i < count; i++) {
+    uint64_t value = 0;
+    switch (types[i]) {
+    case ARG_INT:
+      value = (uint64_t)(int64_t)va_arg(ap, int);
+      break;
+    case ARG_LONG:
+      value = (uint64_t)(int64_t)va_arg(ap, long);
+      break;
+    case ARG_LLONG:
+      value = (uint64_t)va_arg(ap, long long);
+      break;
+    case ARG_SIZE:
+      value = (uint64_t)va_arg(ap, size_t);
+      break;
+    case ARG_DOUBLE:
+    case ARG_LDOUBLE: {
+      double d = types[i] == ARG_DOUBLE ? va_arg(ap, double)
+                                        : (double)va_arg(ap, long double);
+      memcpy(&value, &d, sizeof(d));
+      break;
+    }
+    case ARG_PTR:
+      value = (uintptr_t)va_arg(ap, void *);
+      break;
+    case ARG_STR: {
+      const char *s = va_arg(ap, const char *);
+      if (!s) {
+        value = STRING_NULL;
+        break;
+      }
+      int room = RECORD_STRING_BYTES - rec->strUsed - 1;
+      if (room <= 0) {
+        value = STRING_TRUNC;
+        break;
+      }
+      int len = (int)strnlen(s, room);
+      memcpy(rec->strings + rec->strUsed, s, len);
+      rec->strings[rec->strUsed + len] = '\0';
+      value = rec->strUsed;
+      rec->strUsed += len + 1;
+      for (int k = 0; k < len; k++) {
+        hash = hashMix(hash, (uint8_t)s[k]);
+      }
+      break;
+    }
+    }
+    rec->args[i] = value;
+    hash = hashMix(hash, value);
+  }
+  return hash | 1; // 0 表示还没有输出过
+}
+
+static void registerSite(loggerSite_t *site) {
+  int expected = 0;
+  if (__atomic_load_n(&site->registered, __ATOMIC_ACQUIRE) ||
+      !__atomic_compare_exchange_n(&site->registered, &expected, 1, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  site->next = __atomic_load_n(&g_sites, __ATOMIC_ACQUIRE);
+  while (!__atomic_compare_exchange_n(&g_sites, &site->next, site, true,
+                                      __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+  }
+}
+
+/* 按位置限流：固定窗口计数，并发时窗口切换的瞬间可能多放行几条 */
+static bool rateLimited(loggerSite_t *site, int64_t nowMs) {
+  int64_t start = __atomic_load_n(&site->windowMs, __ATOMIC_RELAXED);
+  if (nowMs - start >= g_config.rateWindowMs &&
+      __atomic_compare_exchange_n(&site->windowMs, &start, nowMs, false,
+                                  __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    __atomic_store_n(&site->windowCount, 0, __ATOMIC_RELAXED);
+  }
+  if (__atomic_add_fetch(&site->windowCount, 1, __ATOMIC_RELAXED) <=
+      (unsigned int)g_config.rateLimit) {
+    return false;
+  }
+  __atomic_add_fetch(&site->limited, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&site->limitedTotal, 1, __ATOMIC_RELAXED);
+  return true;
+}
+
+static void ringRelease(void *arg) {
+  // 由后台线程写完剩余的记录后回收
+  __atomic_store_n(&((logRing_t *)arg)->state, RING_CLOSING, __ATOMIC_RELEASE);
+  t_ring = NULL;
+}
+
+/* 取得本线程的缓冲，首次调用时从预分配的缓冲中认领一个 */
+static logRing_t *claimRing(void) {
+  int generation = __atomic_load_n(&g_generation, __ATOMIC_ACQUIRE);
+  if (t_ring && t_generation == generation) {
+    return t_ring;
+  }
+  for (int i = 0; i < g_ringCount; i++) {
+    logRing_t *ring = &g_rings[i];
+    int expected = RING_FREE;
+    if (__atomic_load_n(&ring->state, __ATOMIC_RELAXED) == RING_FREE &&
+        __atomic_compare_exchange_n(&ring->state, &expected, RING_ACTIVE,
+                                    false, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED)) {
+      ring->tid = (int)syscall(SYS_gettid);
+      t_ring = ring;
+      t_generation = generation;
+      pthread_setspecific(g_ringKey, ring);
+      return ring;
+    }
+  }
+  return NULL;
+}
+
+static bool enqueue(logRing_t *ring, const logRecord_t *rec) {
+  uint32_t tail = ring->tail;
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  if (tail - head > ring->mask) {
+    __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+    return false;
+  }
+  logRecord_t *slot = &ring->records[tail & ring->mask];
+  memcpy(slot, rec, offsetof(logRecord_t, strings) + rec->strUsed);
+  slot->tid = ring->tid;
+  __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+  // 平时由后台线程定时取走，缓冲过半或出现错误时提前唤醒
+  if (tail + 1 - head == (ring->mask + 1) / 2 ||
+      rec->level == LOG_LEVEL_ERROR) {
+    pthread_cond_signal(&g_cond);
+  }
+  return true;
+}
+
+/* 写入输出目标（持有 g_sinkLock 时调用），超过大小时轮转 */
+static void rotateFile(void) {
+  char from[sizeof(g_path) + 16];
+  char to[sizeof(g_path) + 16];
+  close(g_fd);
+  for (int i = g_config.maxFiles - 1; i >= 1; i--) {
+    snprintf(from, sizeof(from), "%s.%d", g_path, i);
+    snprintf(to, sizeof(to), "%s.%d", g_path, i + 1);
+    rename(from, to);
+  }
+  if (g_config.maxFiles > 0) {
+    snprintf(to, sizeof(to), "%s.1", g_path);
+    rename(g_path, to);
+  } else {
+    unlink(g_path);
+  }
+  g_fd = open(g_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (g_fd < 0) {
+    g_fd = STDERR_FILENO;
+    g_stats.writeErrors++;
+  }
+  g_fileBytes = 0;
+  g_stats.rotations++;
+}
+
+static void sinkWrite(const char *data, int len) {
+  while (len > 0) {
+    ssize_t n = write(g_fd, data, len);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    g_stats.writes++;
+    if (n <= 0) {
+      g_stats.writeErrors++;
+      return;
+    }
+    g_stats.bytes += (unsigned long)n;
+    g_fileBytes += n;
+    data += n;
+    len -= (int)n;
+  }
+  if (g_fd != STDERR_FILENO && g_config.maxBytes > 0 &&
+      g_fileBytes >= g_config.maxBytes) {
+    rotateFile();
+  }
+}
+
+static const char *baseName(const char *path) {
+  const char *slash = strrchr(path, '/');
+  return slash ? slash + 1 : path;
+}
+
+static int clampLen(int len, int n, int size) {
+  if (n < 0) {
+    return len;
+  }
+  return len + n < size ? len + n : size - 1;
+}
+
+/* 格式化一个参数，stars 为宽度、精度参数的个数 */
+#define FORMAT_ARG(value)                                                      \
+  (stars == 0   ? snprintf(out, room, spec, value)                             \
+   : stars == 1 ? snprintf(out, room, spec, star[0], value)                    \
+                : snprintf(out, room, spec, star[0], star[1], value))
+
+static int formatArg(char *out, int room, const char *spec, int stars,
+                     const int *star, int type, const logRecord_t *rec,
+                     uint64_t value) {
+  double d;
+  switch (type) {
+  case ARG_INT:
+    return FORMAT_ARG((int)value);
+  case ARG_LONG:
+    return FORMAT_ARG((long)value);
+  case ARG_LLONG:
+    return FORMAT_ARG((long long)value);
+  case ARG_SIZE:
+    return FORMAT_ARG((size_t)value);
+  case ARG_DOUBLE:
+    memcpy(&d, &value, sizeof(d));
+    return FORMAT_ARG(d);
+  case ARG_LDOUBLE:
+    memcpy(&d, &value, sizeof(d));
+    return FORMAT_ARG((long double)d);
+  case ARG_STR:
+    if (value == STRING_NULL) {
+      return FORMAT_ARG("(null)");
+    }
+    return FORMAT_ARG(value == STRING_TRUNC ? "(trunc)"
+                                            : rec->strings + value);
+  case ARG_PTR:
+    return FORMAT_ARG((void *)(uintptr_t)value);
+  }
+  return 0;
+}
+
+/* 去掉格式串结尾的换行（由调用方统一添加） */
+static int messageLen(const char *format) {
+  int len = (int)strlen(format);
+  while (len > 0 && format[len - 1] == '\n') {
+    len--;
+  }
+  return len;
+}
+
+/* 按记录中的参数展开格式串，超出参数个数的转换说明原样输出 */
+static int formatMessage(const logRecord_t *rec, char *out, int size) {
+  const char *p = rec->format;
+  const char *end = p + messageLen(p);
+  int len = 0;
+  int argIndex = 0;
+  while (p < end && len < size - 1) {
+    const char *percent = memchr(p, '%', end - p);
+    int literal = (int)((percent ? percent : end) - p);
+    if (literal > 0) {
+      int n = literal < size - 1 - len ? literal : size - 1 - len;
+      memcpy(out + len, p, n);
+      len += n;
+      p += literal;
+      continue;
+    }
+    if (p[1] == '%') {
+      out[len++] = '%';
+      p += 2;
+      continue;
+    }
+
+    logSpec_t spec;
+    const char *conv = parseSpec(p + 1, &spec);
+    int specLen = (int)(conv - p) + 1;
+    int needed = spec.stars + (spec.type != ARG_NONE ? 1 : 0);
+    if (conv >= end || specLen >= SPEC_MAX ||
+        argIndex + needed > rec->argCount || spec.type == ARG_NONE) {
+      // 不支持的转换（如 %m）或参数不足：原样输出
+      int n = conv < end ? specLen : (int)(end - p);
+      n = n < size - 1 - len ? n : size - 1 - len;
+      memcpy(out + len, p, n);
+      len += n;
+      p += conv < end ? specLen : (int)(end - p);
+      argIndex += needed;
+      continue;
+    }
+
+    char specText[SPEC_MAX];
+    memcpy(specText, p, specLen);
+    specText[specLen] = '\0';
+    int star[2] = {0, 0};
+    for (int i = 0; i < spec.stars; i++) {
+      star[i] = (int)rec->args[argIndex++];
+    }
+    uint64_t value = rec->args[argIndex++];
+    p = conv + 1;
+    if (spec.conv == 'n') {
+      continue;
+    }
+    len = clampLen(len,
+                   formatArg(out + len, size - len, specText, spec.stars, star,
+                             spec.type, rec, value),
+                   size);
+  }
+  out[len] = '\0';
+  return len;
+}
+
+/* 汇总行：合并的重复条数或限流丢弃的条数，附上格式串便于识别 */
+static int formatSummary(const logRecord_t *rec, char *out, int size) {
+  int len = snprintf(out, size,
+                     rec->kind == RECORD_REPEAT
+                         ? "message repeated %llu times: "
+                         : "%llu messages suppressed by rate limit: ",
+                     (unsigned long long)rec->args[0]);
+  len = len < size - 1 ? len : size - 1;
+  int n = messageLen(rec->format);
+  n = n < size - 1 - len ? n : size - 1 - len;
+  memcpy(out + len, rec->format, n);
+  out[len + n] = '\0';
+  return len + n;
+}
+
+/*
+ * @brief 格式化一行："日期 时间.毫秒 级别 [线程] 文件:行号 消息\n"。
+ *        syslog 自带时间和级别，只输出位置和消息
+ * */
+static int formatLine(const logRecord_t *rec, char *out, int size,
+                      bool header) {
+  static __thread time_t cachedSec = -1;
+  static __thread char cachedTime[24];
+
+  int room = size - 1; // 结尾换行
+  int len = 0;
+  if (header) {
+    time_t sec = (time_t)(rec->timeNs / 1000000000LL);
+    if (sec != cachedSec) {
+      struct tm tm;
+      localtime_r(&sec, &tm);
+      strftime(cachedTime, sizeof(cachedTime), "%Y-%m-%d %H:%M:%S", &tm);
+      cachedSec = sec;
+    }
+    int level = rec->level <= LOG_LEVEL_DEBUG ? rec->level : LOG_LEVEL_DEBUG;
+    len = clampLen(0,
+                   snprintf(out, room, "%s.%03d %s ", cachedTime,
+                            (int)(rec->timeNs / 1000000 % 1000),
+                            g_levelTags[level]),
+                   room);
+    if (rec->tid != 0) {
+      len = clampLen(len, snprintf(out + len, room - len, "[%d] ", rec->tid),
+                     room);
+    }
+  }
+  if (rec->site->file) {
+    len = clampLen(len,
+                   snprintf(out + len, room - len, "%s:%d ",
+                            baseName(rec->site->file), rec->site->line),
+                   room);
+  }
+  len += rec->kind == RECORD_MESSAGE
+             ? formatMessage(rec, out + len, room - len)
+             : formatSummary(rec, out + len, room - len);
+  out[len++] = '\n';
+  out[len] = '\0';
+  return len;
+}
+
+static int syslogPriority(int level) {
+  static const int priorities[] = {LOG_ERR, LOG_WARNING, LOG_INFO, LOG_DEBUG};
+  return priorities[level <= LOG_LEVEL_DEBUG ? level : LOG_LEVEL_DEBUG];
+}
+
+/* 没有可用的线程缓冲时在调用线程中格式化并写出 */
+static void writeDirect(logRecord_t *rec) {
+  char line[LINE_MAX_BYTES];
+  rec->tid = (int)syscall(SYS_gettid);
+  int len = formatLine(rec, line, sizeof(line), !g_config.syslog);
+  __atomic_add_fetch(&g_stats.direct, 1, __ATOMIC_RELAXED);
+  pthread_mutex_lock(&g_sinkLock);
+  if (g_config.syslog) {
+    line[len - 1] = '\0';
+    syslog(syslogPriority(rec->level), "%s", line);
+    g_stats.writes++;
+  } else {
+    sinkWrite(line, len);
+  }
+  pthread_mutex_unlock(&g_sinkLock);
+  __atomic_add_fetch(&g_stats.lines, 1, __ATOMIC_RELAXED);
+}
+
+static void logVa(loggerSite_t *site, int level, const char *format,
+                  va_list ap) {
+  if (!__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) {
+    // 未启动：与之前直接输出到stderr的行为一致
+    int len = messageLen(format);
+    vfprintf(stderr, format, ap);
+    if (len == (int)strlen(format)) {
+      fputc('\n', stderr);
+    }
+    return;
+  }
+
+  logRecord_t rec;
+  rec.site = site;
+  rec.format = format;
+  rec.level = (uint8_t)level;
+  rec.kind = RECORD_MESSAGE;
+  rec.tid = 0;
+  uint64_t hash = captureArgs(site, format, &rec, ap);
+  rec.timeNs = simClock_RealtimeNs(); // 仿真模式下为虚拟时间
+
+  registerSite(site);
+  if (__atomic_load_n(&site->level, __ATOMIC_RELAXED) != level) {
+    __atomic_store_n(&site->level, level, __ATOMIC_RELAXED);
+  }
+  // 与该位置上一条消息相同：只计数，由汇总行输出
+  if (__atomic_exchange_n(&site->lastHash, hash, __ATOMIC_RELAXED) == hash) {
+    __atomic_add_fetch(&site->repeats, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&site->repeatTotal, 1, __ATOMIC_RELAXED);
+    return;
+  }
+  if (g_config.rateLimit > 0 && rateLimited(site, rec.timeNs / 1000000)) {
+    return;
+  }
+
+  // 消息变化：先输出之前合并的条数
+  unsigned long repeats =
+      __atomic_exchange_n(&site->repeats, 0, __ATOMIC_RELAXED);
+  logRing_t *ring = claimRing();
+  if (repeats > 0) {
+    logRecord_t summary = rec;
+    summary.kind = RECORD_REPEAT;
+    summary.argCount = 1;
+    summary.args[0] = repeats;
+    summary.strUsed = 0;
+    if (ring) {
+      enqueue(ring, &summary);
+    } else {
+      writeDirect(&summary);
+    }
+  }
+  if (ring) {
+    enqueue(ring, &rec);
+  } else {
+    writeDirect(&rec);
+  }
+}
+
+void logger_Log(loggerSite_t *site, int level, ...) {
+  va_list ap;
+  va_start(ap, level);
+  logVa(site, level, site->format, ap);
+  va_end(ap);
+}
+
+/* 按格式串指针查找（或占用）一个位置，表满时共用溢出位置 */
+static loggerSite_t *dynamicSite(const char *format) {
+  uint32_t hash = (uint32_t)((uintptr_t)format >> 3) * 2654435761u;
+  for (int i = 0; i < LOGGER_DYNAMIC_SITES; i++) {
+    loggerSite_t *site =
+        &g_dynamicSites[(hash + i) % LOGGER_DYNAMIC_SITES];
+    const char *current = __atomic_load_n(&site->format, __ATOMIC_ACQUIRE);
+    if (current == format) {
+      return site;
+    }
+    if (!current &&
+        (__atomic_compare_exchange_n(&site->format, &current, format, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ||
+         current == format)) {
+      return site;
+    }
+  }
+  return &g_overflowSite;
+}
+
+void logger_Callback(int level, const char *format, ...) {
+  if (!format ||
+      level > __atomic_load_n(&g_loggerLevel, __ATOMIC_RELAXED)) {
+    return;
+  }
+  va_list ap;
+  va_start(ap, format);
+  logVa(dynamicSite(format), level, format, ap);
+  va_end(ap);
+}
+
+/* 后台线程：格式化一条记录到写缓冲 */
+static void appendRecord(const logRecord_t *rec) {
+  if (g_config.syslog) {
+    char line[LINE_MAX_BYTES];
+    int len = formatLine(rec, line, sizeof(line), false);
+    line[len - 1] = '\0';
+    syslog(syslogPriority(rec->level), "%s", line);
+    pthread_mutex_lock(&g_sinkLock);
+    g_stats.writes++;
+    pthread_mutex_unlock(&g_sinkLock);
+    __atomic_add_fetch(&g_stats.lines, 1, __ATOMIC_RELAXED);
+    return;
+  }
+  if (g_bufferLen + LINE_MAX_BYTES > WRITE_BUFFER_BYTES) {
+    pthread_mutex_lock(&g_sinkLock);
+    sinkWrite(g_buffer, g_bufferLen);
+    pthread_mutex_unlock(&g_sinkLock);
+    g_bufferLen = 0;
+  }
+  g_bufferLen += formatLine(rec, g_buffer + g_bufferLen, LINE_MAX_BYTES, true);
+  __atomic_add_fetch(&g_stats.lines, 1, __ATOMIC_RELAXED);
+}
+
+static void flushBuffer(void) {
+  if (g_bufferLen == 0) {
+    return;
+  }
+  pthread_mutex_lock(&g_sinkLock);
+  sinkWrite(g_buffer, g_bufferLen);
+  pthread_mutex_unlock(&g_sinkLock);
+  g_bufferLen = 0;
+}
+
+/*
+ * @brief 取出各线程缓冲中的记录，按时间顺序合并输出
+ *
+ * @return 处理的记录数
+ * */
+static int drainRings(void) {
+  int drained = 0;
+  while (drained < DRAIN_BATCH) {
+    logRing_t *best = NULL;
+    logRecord_t *bestRec = NULL;
+    for (int i = 0; i < g_ringCount; i++) {
+      logRing_t *ring = &g_rings[i];
+      uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+      if (ring->head == tail) {
+        continue;
+      }
+      logRecord_t *rec = &ring->records[ring->head & ring->mask];
+      if (!bestRec || rec->timeNs < bestRec->timeNs) {
+        best = ring;
+        bestRec = rec;
+      }
+    }
+    if (!best) {
+      break;
+    }
+    appendRecord(bestRec);
+    __atomic_store_n(&best->head, best->head + 1, __ATOMIC_RELEASE);
+    drained++;
+  }
+
+  // 已退出线程的缓冲写完后回收
+  for (int i = 0; i < g_ringCount; i++) {
+    logRing_t *ring = &g_rings[i];
+    int expected = RING_CLOSING;
+    if (__atomic_load_n(&ring->state, __ATOMIC_ACQUIRE) == RING_CLOSING &&
+        ring->head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) {
+      __atomic_compare_exchange_n(&ring->state, &expected, RING_FREE, false,
+                                  __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+  }
+  return drained;
+}
+
+/* 输出各位置尚未汇总的重复条数和限流条数 */
+static void emitSummaries(void) {
+  int64_t timeNs = simClock_RealtimeNs();
+  loggerSite_t *site = __atomic_load_n(&g_sites, __ATOMIC_ACQUIRE);
+  for (; site; site = site->next) {
+    logRecord_t rec;
+    memset(&rec, 0, offsetof(logRecord_t, strings));
+    rec.site = site;
+    rec.format = site == &g_overflowSite ? "(overflow)" : site->format;
+    rec.timeNs = timeNs;
+    rec.level = (uint8_t)__atomic_load_n(&site->level, __ATOMIC_RELAXED);
+    rec.argCount = 1;
+    unsigned long repeats =
+        __atomic_exchange_n(&site->repeats, 0, __ATOMIC_RELAXED);
+    if (repeats > 0) {
+      rec.kind = RECORD_REPEAT;
+      rec.args[0] = repeats;
+      appendRecord(&rec);
+    }
+    unsigned long limited =
+        __atomic_exchange_n(&site->limited, 0, __ATOMIC_RELAXED);
+    if (limited > 0) {
+      rec.kind = RECORD_LIMITED;
+      rec.args[0] = limited;
+      appendRecord(&rec);
+    }
+  }
+}
+
+static void *writerThreadFunc(void *arg) {
+  int64_t nextSummaryMs = monotonicMs() + g_config.summaryIntervalMs;
+  pthread_mutex_lock(&g_lock);
+  for (;;) {
+    bool stopping = g_stopping;
+    unsigned long request = g_flushRequest;
+    pthread_mutex_unlock(&g_lock);
+
+    while (drainRings() == DRAIN_BATCH) {
+      flushBuffer();
+    }
+    if (stopping || monotonicMs() >= nextSummaryMs) {
+      emitSummaries();
+      nextSummaryMs = monotonicMs() + g_config.summaryIntervalMs;
+    }
+    flushBuffer();
+
+    pthread_mutex_lock(&g_lock);
+    g_flushDone = request;
+    pthread_cond_broadcast(&g_flushCond);
+    if (stopping) {
+      break;
+    }
+    if (!g_stopping && g_flushRequest == request) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_MONOTONIC, &deadline);
+      int64_t ns = deadline.tv_nsec +
+                   (int64_t)g_config.flushIntervalMs * 1000000LL;
+      deadline.tv_sec += ns / 1000000000LL;
+      deadline.tv_nsec = ns % 1000000000LL;
+      pthread_cond_timedwait(&g_cond, &g_lock, &deadline);
+    }
+  }
+  pthread_mutex_unlock(&g_lock);
+  return NULL;
+}
+
+static int openSink(void) {
+  if (g_config.syslog) {
+    openlog("sentinel", LOG_PID | LOG_NDELAY, LOG_DAEMON);
+    return 0;
+  }
+  if (g_path[0] == '\0') {
+    g_fd = STDERR_FILENO;
+    return 0;
+  }
+  g_fd = open(g_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (g_fd < 0) {
+    fprintf(stderr, "Error opening log file %s: %s\n", g_path,
+            strerror(errno));
+    g_fd = STDERR_FILENO;
+    return -1;
+  }
+  struct stat st;
+  g_fileBytes = fstat(g_fd, &st) == 0 ? (long)st.st_size : 0;
+  return 0;
+}
+
+int logger_Init(const loggerConfig_t *config) {
+  if (!config || __atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) {
+    return -1;
+  }
+  g_config = *config;
+  snprintf(g_path, sizeof(g_path), "%s", config->file ? config->file : "");
+  g_config.file = g_path;
+  if (g_config.maxThreads <= 0) {
+    g_config.maxThreads = 16;
+  }
+  uint32_t slots = 8;
+  while (slots < (uint32_t)g_config.ringSlots && slots < (1u << 16)) {
+    slots <<= 1;
+  }
+  g_config.ringSlots = (int)slots;
+  if (g_config.flushIntervalMs <= 0) {
+    g_config.flushIntervalMs = 200;
+  }
+  if (g_config.rateWindowMs <= 0) {
+    g_config.rateWindowMs = 1000;
+  }
+  if (g_config.summaryIntervalMs <= 0) {
+    g_config.summaryIntervalMs = 60000;
+  }
+
+  // 缓冲在启动阶段一次性分配，之前初始化的缓冲可能仍被其他线程引用，不释放
+  logRing_t *rings =
+      (logRing_t *)memPool_Alloc(sizeof(logRing_t) * g_config.maxThreads);
+  if (!rings) {
+    return -1;
+  }
+  memset(rings, 0, sizeof(logRing_t) * g_config.maxThreads);
+  for (int i = 0; i < g_config.maxThreads; i++) {
+    rings[i].mask = slots - 1;
+    rings[i].records =
+        (logRecord_t *)memPool_Alloc(sizeof(logRecord_t) * slots);
+    if (!rings[i].records) {
+      fprintf(stderr, "Failed to reserve log buffers.\n");
+      return -1;
+    }
+  }
+
+  if (openSink() != 0) {
+    return -1;
+  }
+  if (!g_keyCreated) {
+    if (pthread_key_create(&g_ringKey, ringRelease) != 0) {
+      return -1;
+    }
+    g_keyCreated = true;
+  }
+  g_rings = rings;
+  g_ringCount = g_config.maxThreads;
+  memset(&g_stats, 0, sizeof(g_stats));
+  for (loggerSite_t *site = g_sites; site; site = site->next) {
+    site->repeatTotal = 0;
+    site->limitedTotal = 0;
+  }
+  __atomic_add_fetch(&g_generation, 1, __ATOMIC_RELEASE);
+  logger_SetLevel(config->level);
+
+  initMonotonicCond(&g_cond);
+  pthread_cond_init(&g_flushCond, NULL);
+  g_stopping = false;
+  g_flushRequest = 0;
+  g_flushDone = 0;
+  __atomic_store_n(&g_running, 1, __ATOMIC_RELEASE);
+  if (pthread_create(&g_writer, NULL, writerThreadFunc, NULL) != 0) {
+    fprintf(stderr, "Fail to create logger thread.\n");
+    __atomic_store_n(&g_running, 0, __ATOMIC_RELEASE);
+    return -1;
+  }
+  return 0;
+}
+
+void logger_Deinit(void) {
+  if (!__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  __atomic_store_n(&g_running, 0, __ATOMIC_RELEASE);
+  pthread_mutex_lock(&g_lock);
+  g_stopping = true;
+  pthread_cond_signal(&g_cond);
+  pthread_mutex_unlock(&g_lock);
+  pthread_join(g_writer, NULL);
+
+  pthread_mutex_lock(&g_sinkLock);
+  if (g_config.syslog) {
+    closelog();
+  } else if (g_fd != STDERR_FILENO) {
+    close(g_fd);
+  }
+  g_fd = STDERR_FILENO;
+  pthread_mutex_unlock(&g_sinkLock);
+}
+
+void logger_Flush(void) {
+  pthread_mutex_lock(&g_lock);
+  if (__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) {
+    unsigned long request = ++g_flushRequest;
+    pthread_cond_signal(&g_cond);
+    while (g_flushDone < request && !g_stopping) {
+      pthread_cond_wait(&g_flushCond, &g_lock);
+    }
+  }
+  pthread_mutex_unlock(&g_lock);
+}
+
+void logger_GetStats(loggerStats_t *stats) {
+  pthread_mutex_lock(&g_sinkLock);
+  *stats = g_stats;
+  stats->lines = __atomic_load_n(&g_stats.lines, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&g_sinkLock);
+  stats->direct = __atomic_load_n(&g_stats.direct, __ATOMIC_RELAXED);
+  stats->dropped = 0;
+  stats->threads = 0;
+  for (int i = 0; i < g_ringCount; i++) {
+    stats->dropped += __atomic_load_n(&g_rings[i].dropped, __ATOMIC_RELAXED);
+    stats->threads +=
+        __atomic_load_n(&g_rings[i].state, __ATOMIC_RELAXED) == RING_ACTIVE;
+  }
+  stats->repeats = 0;
+  stats->limited = 0;
+  loggerSite_t *site = __atomic_load_n(&g_sites, __ATOMIC_ACQUIRE);
+  for (; site; site = site->next) {
+    stats->repeats += __atomic_load_n(&site->repeatTotal, __ATOMIC_RELAXED);
+    stats->limited += __atomic_load_n(&site->limitedTotal, __ATOMIC_RELAXED);
+  }
+  stats->level = __atomic_load_n(&g_loggerLevel, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,228 @@
+#include "modules/mem_pool.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "cJSON/cJSON.h"
+
+#define MEM_POOL_ALIGN 8
+#define MEM_ALIGN_UP(n) (((n) + (MEM_POOL_ALIGN - 1)) & ~(size_t)(MEM_POOL_ALIGN - 1))
+
+/* 全局内存池 */
+static memPoolConfig_t g_poolConfig;
+static char *g_poolBase = NULL;
+static size_t g_poolUsed = 0;
+static bool g_poolSealed = false;
+static pthread_mutex_t g_poolLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* 当前线程绑定的cJSON arena */
+static __thread memArena_t *t_cjsonArena = NULL;
+
+/*
+ * @brief 初始化内存池。静态模式下一次性申请全部预算并预先触碰页面，
+ *        保证预算内的内存在启动阶段就已真正驻留。
+ *
+ * @param config: 内存池配置
+ *
+ * @return 0 成功
+ * */
+int memPool_Init(const memPoolConfig_t *config) {
+  if (!config) {
+    return -1;
+  }
+
+  g_poolConfig = *config;
+  g_poolUsed = 0;
+  g_poolSealed = false;
+
+  if (!config->staticMode) {
+    return 0;
+  }
+
+  if (config->budgetBytes == 0) {
+    fprintf(stderr, "Static memory mode requires a non-zero budget.\n");
+    return -1;
+  }
+
+  g_poolBase = (char *)malloc(config->budgetBytes);
+  if (g_poolBase == NULL) {
+    fprintf(stderr, "Failed to reserve %zu bytes memory budget.\n",
+            config->budgetBytes);
+    return -1;
+  }
+  memset(g_poolBase, 0, config->budgetBytes);
+
+  return 0;
+}
+
+bool memPool_IsStatic(void) { return g_poolConfig.staticMode; }
+
+const memPoolConfig_t *memPool_GetConfig(void) { return &g_poolConfig; }
+
+/*
+ * @brief 从内存池中分配内存
+ *
+ * @param size: 需要的字节数
+ *
+ * @return 内存地址，失败返回NULL
+ * */
+void *memPool_Alloc(size_t size) {
+  if (!g_poolConfig.staticMode) {
+    return malloc(size);
+  }
+
+  void *ptr = NULL;
+  size_t need = MEM_ALIGN_UP(size);
+
+  pthread_mutex_lock(&g_poolLock);
+  if (g_poolSealed) {
+    pthread_mutex_unlock(&g_poolLock);
+    fprintf(stderr, "Memory pool sealed, refusing %zu bytes allocation.\n",
+            size);
+    return NULL;
+  }
+  if (g_poolUsed + need <= g_poolConfig.budgetBytes) {
+    ptr = g_poolBase + g_poolUsed;
+    g_poolUsed += need;
+  }
+  pthread_mutex_unlock(&g_poolLock);
+
+  if (ptr == NULL) {
+    fprintf(stderr, "Memory budget exceeded: %zu/%zu bytes used, need %zu.\n",
+            g_poolUsed, g_poolConfig.budgetBytes, need);
+  }
+  return ptr;
+}
+
+char *memPool_Strdup(const char *str) {
+  if (!str) {
+    return NULL;
+  }
+
+  size_t len = strlen(str);
+  char *copy = (char *)memPool_Alloc(len + 1);
+  if (copy) {
+    memcpy(copy, str, len + 1);
+  }
+  return copy;
+}
+
+bool memPool_Owns(const void *ptr) {
+  return g_poolBase != NULL && (const char *)ptr >= g_poolBase &&
+         (const char *)ptr < g_poolBase + g_poolConfig.budgetBytes;
+}
+
+void memPool_Free(void *ptr) {
+  if (ptr == NULL || memPool_Owns(ptr)) {
+    return;
+  }
+  free(ptr);
+}
+
+void memPool_Seal(void) {
+  pthread_mutex_lock(&g_poolLock);
+  g_poolSealed = true;
+  pthread_mutex_unlock(&g_poolLock);
+}
+
+void memPool_GetStats(memPoolStats_t *stats) {
+  if (!stats) {
+    return;
+  }
+
+  pthread_mutex_lock(&g_poolLock);
+  stats->budgetBytes = g_poolConfig.budgetBytes;
+  stats->usedBytes = g_poolUsed;
+  stats->sealed = g_poolSealed;
+  pthread_mutex_unlock(&g_poolLock);
+  stats->peakRssKb = memPool_GetPeakRssKb();
+}
+
+/*
+ * @brief 获取进程峰值常驻内存。使用getrusage而不是解析/proc，
+ *        避免fopen在稳态路径上分配堆内存。
+ *
+ * @return long: 峰值RSS（KB），失败返回-1
+ * */
+long memPool_GetPeakRssKb(void) {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return -1;
+  }
+  return usage.ru_maxrss;
+}
+
+/*
+ * @brief 初始化arena，空间从内存池中切分（非静态模式下使用malloc）
+ *
+ * @param arena: arena指针
+ *        size: arena大小
+ *
+ * @return 0 成功
+ * */
+int memArena_Init(memArena_t *arena, size_t size) {
+  if (!arena || size == 0) {
+    return -1;
+  }
+
+  memset(arena, 0, sizeof(memArena_t));
+  arena->base = (char *)memPool_Alloc(size);
+  if (arena->base == NULL) {
+    return -1;
+  }
+  arena->size = size;
+  return 0;
+}
+
+void *memArena_Alloc(memArena_t *arena, size_t size) {
+  size_t need = MEM_ALIGN_UP(size);
+  if (!arena || arena->used + need > arena->size) {
+    if (arena) {
+      arena->failed++;
+    }
+    return NULL;
+  }
+
+  void *ptr = arena->base + arena->used;
+  arena->used += need;
+  if (arena->used > arena->peak) {
+    arena->peak = arena->used;
+  }
+  return ptr;
+}
+
+void memArena_Reset(memArena_t *arena) {
+  if (arena) {
+    arena->used = 0;
+  }
+}
+
+static bool memArena_Owns(const memArena_t *arena, const void *ptr) {
+  return arena && arena->base && (const char *)ptr >= arena->base &&
+         (const char *)ptr < arena->base + arena->size;
+}
+
+/* cJSON内存钩子：绑定了arena的线程从arena分配，其余线程使用malloc */
+static void *cjsonHookMalloc(size_t size) {
+  if (t_cjsonArena) {
+    return memArena_Alloc(t_cjsonArena, size);
+  }
+  return malloc(size);
+}
+
+static void cjsonHookFree(void *ptr) {
+  if (ptr == NULL || memArena_Owns(t_cjsonArena, ptr) || memPool_Owns(ptr)) {
+    return;
+  }
+  free(ptr);
+}
+
+void memPool_InstallCJSONHooks(void) {
+  cJSON_Hooks hooks = {cjsonHookMalloc, cjsonHookFree};
+  cJSON_InitHooks(&hooks);
+}
+
+void memArena_BindCJSON(memArena_t *arena) { t_cjsonArena = arena; }
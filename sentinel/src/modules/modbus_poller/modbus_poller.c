@@ -0,0 +1,510 @@
+#include "modules/modbus_poller.h"
+#include "modules/mem_pool.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MODBUS_MBAP_LEN 7     // 事务ID、协议ID、长度、单元ID
+#define MODBUS_REQUEST_LEN 12 // MBAP + 功能码、起始地址、数量
+#define MODBUS_RX_BYTES 512   // 至少容纳一个最大响应（260字节）
+
+/* 合并后的读请求，覆盖 order[firstPoint..] 中的 pointCount 个测点 */
+typedef struct {
+  uint8_t function;
+  uint16_t start;
+  uint16_t count;
+  uint8_t firstPoint;
+  uint8_t pointCount;
+} modbusRequest_t;
+
+typedef struct {
+  modbusDeviceConfig_t config;
+  struct sockaddr_in addr;
+  int fd;
+  int timerFd;
+  bool connecting;
+  bool everConnected;
+
+  modbusRequest_t requests[MODBUS_MAX_POINTS];
+  int requestCount;
+  uint8_t order[MODBUS_MAX_POINTS]; // 按寄存器表和地址排序的测点下标
+  modbusValue_t values[MODBUS_MAX_POINTS];
+
+  // 当前一轮的流水线状态
+  bool cycleActive;
+  int64_t cycleStartUs;
+  int nextRequest;
+  int completed;
+  int outstanding;
+  uint16_t nextTid;
+  uint16_t pendingTid[MODBUS_MAX_IN_FLIGHT];
+  int pendingRequest[MODBUS_MAX_IN_FLIGHT]; // -1 表示空闲
+
+  uint8_t rx[MODBUS_RX_BYTES];
+  int rxLen;
+  modbusDeviceStats_t stats;
+} modbusDevice_t;
+
+static modbusPollerConfig_t g_config;
+static eventLoop_t *g_loop = NULL;
+static modbusDevice_t *g_devices = NULL;
+static int g_deviceCount = 0;
+static modbusPollerCallback_t g_callback = NULL;
+static void *g_userData = NULL;
+
+static int64_t monotonicUs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint16_t be16(const uint8_t *p) { return (uint16_t)(p[0] << 8 | p[1]); }
+
+static int pointWidth(const modbusPointConfig_t *point) {
+  return point->type >= MODBUS_TYPE_U32 ? 2 : 1;
+}
+
+/*
+ * @brief 把测点合并成读请求：按寄存器表和地址排序后贪心扩展，
+ *        与当前请求的间隔不超过 maxGap 且总长度不超过 maxRegs 时并入。
+ *        两个约束都随扩展单调，贪心得到的请求数最少
+ * */
+static void planRequests(modbusDevice_t *dev) {
+  const modbusPointConfig_t *points = dev->config.points;
+  int count = dev->config.pointCount;
+
+  for (int i = 0; i < count; i++) {
+    int j = i;
+    while (j > 0) {
+      const modbusPointConfig_t *prev = &points[dev->order[j - 1]];
+      if (prev->table < points[i].table ||
+          (prev->table == points[i].table &&
+           prev->address <= points[i].address)) {
+        break;
+      }
+      dev->order[j] = dev->order[j - 1];
+      j--;
+    }
+    dev->order[j] = (uint8_t)i;
+  }
+
+  dev->requestCount = 0;
+  modbusRequest_t *req = NULL;
+  for (int i = 0; i < count; i++) {
+    const modbusPointConfig_t *point = &points[dev->order[i]];
+    int end = point->address + pointWidth(point);
+    if (req && req->function == point->table &&
+        point->address <= req->start + req->count + g_config.maxGap &&
+        end - req->start <= g_config.maxRegs) {
+      if (end > req->start + req->count) {
+        req->count = (uint16_t)(end - req->start);
+      }
+      req->pointCount++;
+      continue;
+    }
+    req = &dev->requests[dev->requestCount++];
+    req->function = (uint8_t)point->table;
+    req->start = point->address;
+    req->count = (uint16_t)pointWidth(point);
+    req->firstPoint = (uint8_t)i;
+    req->pointCount = 1;
+  }
+
+  dev->stats.requestsPerCycle = dev->requestCount;
+  dev->stats.registersPerCycle = 0;
+  for (int i = 0; i < dev->requestCount; i++) {
+    dev->stats.registersPerCycle += dev->requests[i].count;
+  }
+}
+
+static void dropConnection(modbusDevice_t *dev, const char *reason) {
+  if (dev->fd < 0) {
+    return;
+  }
+  if (dev->stats.connected) {
+    fprintf(stderr, "Modbus device %s disconnected: %s\n", dev->config.name,
+            reason);
+  }
+  eventLoop_RemoveFd(g_loop, dev->fd);
+  close(dev->fd);
+  dev->fd = -1;
+  dev->connecting = false;
+  dev->stats.connected = false;
+  dev->cycleActive = false;
+  dev->outstanding = 0;
+  dev->rxLen = 0;
+  for (int i = 0; i < MODBUS_MAX_IN_FLIGHT; i++) {
+    dev->pendingRequest[i] = -1;
+  }
+}
+
+/*
+ * @brief 在流水线深度内发出后续请求，一次 send 发出多个请求帧。
+ *        请求只有12字节，新连接的发送缓冲不会写满，短写按连接异常处理
+ * */
+static void sendRequests(modbusDevice_t *dev) {
+  uint8_t frames[MODBUS_MAX_IN_FLIGHT * MODBUS_REQUEST_LEN];
+  int len = 0;
+
+  for (int slot = 0; slot < g_config.maxInFlight &&
+                     dev->nextRequest < dev->requestCount;
+       slot++) {
+    if (dev->pendingRequest[slot] >= 0) {
+      continue;
+    }
+    const modbusRequest_t *req = &dev->requests[dev->nextRequest];
+    uint16_t tid = dev->nextTid++;
+    uint8_t *f = frames + len;
+    f[0] = tid >> 8;
+    f[1] = tid & 0xff;
+    f[2] = 0; // 协议ID
+    f[3] = 0;
+    f[4] = 0; // 后续长度
+    f[5] = 6;
+    f[6] = dev->config.unitId;
+    f[7] = req->function;
+    f[8] = req->start >> 8;
+    f[9] = req->start & 0xff;
+    f[10] = req->count >> 8;
+    f[11] = req->count & 0xff;
+    len += MODBUS_REQUEST_LEN;
+
+    dev->pendingTid[slot] = tid;
+    dev->pendingRequest[slot] = dev->nextRequest++;
+    dev->outstanding++;
+  }
+
+  if (len > 0 && send(dev->fd, frames, len, MSG_NOSIGNAL) != len) {
+    dropConnection(dev, "send failed");
+  }
+}
+
+static void decodePoint(modbusDevice_t *dev, int pointIndex,
+                        const uint8_t *data) {
+  const modbusPointConfig_t *point = &dev->config.points[pointIndex];
+  uint32_t word = be16(data);
+  double raw;
+
+  if (point->type == MODBUS_TYPE_U16) {
+    raw = word;
+  } else if (point->type == MODBUS_TYPE_I16) {
+    raw = (int16_t)word;
+  } else {
+    uint32_t low = be16(data + 2);
+    uint32_t value = point->swapWords ? low << 16 | word : word << 16 | low;
+    if (point->type == MODBUS_TYPE_U32) {
+      raw = value;
+    } else if (point->type == MODBUS_TYPE_I32) {
+      raw = (int32_t)value;
+    } else {
+      float f;
+      memcpy(&f, &value, sizeof(f));
+      raw = f;
+    }
+  }
+
+  dev->values[pointIndex].value = raw * point->scale + point->offset;
+  dev->values[pointIndex].valid = true;
+}
+
+static void finishCycle(modbusDevice_t *dev) {
+  int64_t cycleUs = monotonicUs() - dev->cycleStartUs;
+  dev->cycleActive = false;
+  dev->stats.cycles++;
+  dev->stats.lastCycleUs = cycleUs;
+  if (cycleUs > dev->stats.maxCycleUs) {
+    dev->stats.maxCycleUs = cycleUs;
+  }
+  g_callback(dev->config.name, dev->values, dev->config.pointCount, cycleUs,
+             g_userData);
+}
+
+/*
+ * @brief 处理一帧响应。响应按事务ID匹配，允许乱序返回
+ *
+ * @return 0 成功，-1 协议错误
+ * */
+static int handleResponse(modbusDevice_t *dev, const uint8_t *frame,
+                          int len) {
+  uint16_t tid = be16(frame);
+  int slot = -1;
+  for (int i = 0; i < g_config.maxInFlight; i++) {
+    if (dev->pendingRequest[i] >= 0 && dev->pendingTid[i] == tid) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0) {
+    return -1;
+  }
+
+  const modbusRequest_t *req = &dev->requests[dev->pendingRequest[slot]];
+  const uint8_t *pdu = frame + MODBUS_MBAP_LEN;
+  int pduLen = len - MODBUS_MBAP_LEN;
+  if (pdu[0] == (req->function | 0x80)) {
+    // 异常响应：本轮该请求覆盖的测点无效
+    dev->stats.exceptions++;
+  } else if (pdu[0] == req->function && pduLen >= 2 &&
+             pdu[1] == req->count * 2 && pduLen == 2 + req->count * 2) {
+    for (int i = 0; i < req->pointCount; i++) {
+      int pointIndex = dev->order[req->firstPoint + i];
+      const modbusPointConfig_t *point = &dev->config.points[pointIndex];
+      decodePoint(dev, pointIndex, pdu + 2 + (point->address - req->start) * 2);
+    }
+    dev->stats.registers += req->count;
+  } else {
+    return -1;
+  }
+
+  dev->stats.requests++;
+  dev->pendingRequest[slot] = -1;
+  dev->outstanding--;
+  if (++dev->completed == dev->requestCount) {
+    finishCycle(dev);
+  } else {
+    sendRequests(dev);
+  }
+  return 0;
+}
+
+static void receiveResponses(modbusDevice_t *dev) {
+  ssize_t n = recv(dev->fd, dev->rx + dev->rxLen, MODBUS_RX_BYTES - dev->rxLen,
+                   0);
+  if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+    return;
+  }
+  if (n <= 0) {
+    dropConnection(dev, n == 0 ? "closed by peer" : strerror(errno));
+    return;
+  }
+  dev->rxLen += (int)n;
+
+  int offset = 0;
+  while (dev->rxLen - offset >= MODBUS_MBAP_LEN + 1) {
+    const uint8_t *frame = dev->rx + offset;
+    int length = be16(frame + 4); // 单元ID和PDU的长度
+    if (be16(frame + 2) != 0 || length < 2 || length > 254) {
+      dropConnection(dev, "bad frame");
+      return;
+    }
+    int frameLen = 6 + length;
+    if (dev->rxLen - offset < frameLen) {
+      break;
+    }
+    if (handleResponse(dev, frame, frameLen) != 0) {
+      dropConnection(dev, "unexpected response");
+      return;
+    }
+    if (dev->fd < 0) {
+      return;
+    }
+    offset += frameLen;
+  }
+  if (offset > 0) {
+    memmove(dev->rx, dev->rx + offset, dev->rxLen - offset);
+    dev->rxLen -= offset;
+  }
+}
+
+static void socketHandle(int fd, uint32_t events, void *userData) {
+  modbusDevice_t *dev = (modbusDevice_t *)userData;
+  if (dev->fd != fd) {
+    return;
+  }
+
+  if (dev->connecting) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err != 0) {
+      dropConnection(dev, strerror(err));
+      return;
+    }
+    dev->connecting = false;
+    dev->stats.connected = true;
+    dev->everConnected = true;
+    eventLoop_ModifyFd(g_loop, fd, EPOLLIN);
+    return;
+  }
+
+  if (events & EPOLLIN) {
+    receiveResponses(dev);
+  } else if (events & (EPOLLHUP | EPOLLERR)) {
+    dropConnection(dev, "connection error");
+  }
+}
+
+/* 非阻塞连接，完成后由 socketHandle 切换为接收响应 */
+static void startConnect(modbusDevice_t *dev) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return;
+  }
+  // 请求帧很小，关闭Nagle避免流水线中的请求被延迟合并
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  if (dev->everConnected) {
+    dev->stats.reconnects++;
+  }
+  int rc = connect(fd, (struct sockaddr *)&dev->addr, sizeof(dev->addr));
+  if (rc != 0 && errno != EINPROGRESS) {
+    close(fd);
+    return;
+  }
+  if (eventLoop_AddFd(g_loop, fd, rc == 0 ? EPOLLIN : EPOLLOUT, socketHandle,
+                      dev) != 0) {
+    close(fd);
+    return;
+  }
+  dev->fd = fd;
+  dev->connecting = rc != 0;
+  dev->stats.connected = rc == 0;
+  dev->everConnected |= rc == 0;
+}
+
+/* 轮询周期：未连接时重连，上一轮超时则断开，否则开始新一轮 */
+static void pollTimerHandle(int fd, uint32_t events, void *userData) {
+  modbusDevice_t *dev = (modbusDevice_t *)userData;
+  eventLoop_AckTimer(fd);
+
+  if (dev->fd < 0) {
+    startConnect(dev);
+    return;
+  }
+  if (dev->connecting) {
+    return;
+  }
+  if (dev->cycleActive) {
+    if (monotonicUs() - dev->cycleStartUs >= g_config.timeoutMs * 1000LL) {
+      dev->stats.timeouts++;
+      dropConnection(dev, "poll timeout");
+    } else {
+      dev->stats.overruns++;
+    }
+    return;
+  }
+
+  dev->cycleActive = true;
+  dev->cycleStartUs = monotonicUs();
+  dev->nextRequest = 0;
+  dev->completed = 0;
+  for (int i = 0; i < dev->config.pointCount; i++) {
+    dev->values[i].valid = false;
+  }
+  sendRequests(dev);
+}
+
+/*
+ * @brief 初始化模块
+ *
+ * @param config: 公共参数（合并间隔、流水线深度、超时）
+ *        loop: 共享的事件循环
+ *        callback: 每轮轮询完成时调用
+ *
+ * @return 0 成功
+ * */
+int modbusPoller_Init(const modbusPollerConfig_t *config, eventLoop_t *loop,
+                      modbusPollerCallback_t callback, void *userData) {
+  if (!config || !loop || !callback || config->maxDevices <= 0 ||
+      config->maxGap < 0 || config->maxRegs < 2 ||
+      config->maxRegs > MODBUS_MAX_REGS || config->maxInFlight < 1 ||
+      config->maxInFlight > MODBUS_MAX_IN_FLIGHT || config->timeoutMs <= 0) {
+    return -1;
+  }
+
+  g_devices = (modbusDevice_t *)memPool_Alloc(config->maxDevices *
+                                              sizeof(modbusDevice_t));
+  if (!g_devices) {
+    return -1;
+  }
+  g_config = *config;
+  g_loop = loop;
+  g_callback = callback;
+  g_userData = userData;
+  g_deviceCount = 0;
+  return 0;
+}
+
+int modbusPoller_AddDevice(const modbusDeviceConfig_t *device) {
+  if (!g_devices || !device || g_deviceCount >= g_config.maxDevices ||
+      device->pointCount <= 0 || device->pointCount > MODBUS_MAX_POINTS ||
+      device->intervalMs <= 0) {
+    return -1;
+  }
+  for (int i = 0; i < device->pointCount; i++) {
+    const modbusPointConfig_t *point = &device->points[i];
+    if ((point->table != MODBUS_TABLE_HOLDING &&
+         point->table != MODBUS_TABLE_INPUT) ||
+        point->address + pointWidth(point) > 0x10000) {
+      fprintf(stderr, "Invalid Modbus point %s.%s.\n", device->name,
+              point->name);
+      return -1;
+    }
+  }
+
+  modbusDevice_t *dev = &g_devices[g_deviceCount];
+  memset(dev, 0, sizeof(*dev));
+  dev->config = *device;
+  dev->fd = -1;
+  dev->addr.sin_family = AF_INET;
+  dev->addr.sin_port = htons((uint16_t)device->port);
+  if (inet_pton(AF_INET, device->host, &dev->addr.sin_addr) != 1) {
+    fprintf(stderr, "Invalid Modbus device address %s.\n", device->host);
+    return -1;
+  }
+  for (int i = 0; i < MODBUS_MAX_IN_FLIGHT; i++) {
+    dev->pendingRequest[i] = -1;
+  }
+  for (int i = 0; i < device->pointCount; i++) {
+    dev->values[i].name = dev->config.points[i].name;
+  }
+  planRequests(dev);
+
+  dev->timerFd = eventLoop_AddTimer(g_loop, pollTimerHandle, dev);
+  if (dev->timerFd < 0) {
+    return -1;
+  }
+  startConnect(dev);
+
+  // 第一轮错开到各设备的周期内，避免所有设备同时发出请求
+  uint64_t intervalNs = device->intervalMs * 1000000ULL;
+  uint64_t offsetNs = (g_deviceCount * 7919ULL * 1000000ULL) % intervalNs;
+  if (eventLoop_ArmTimer(dev->timerFd, intervalNs / 2 + offsetNs + 1,
+                         intervalNs) != 0) {
+    dropConnection(dev, "timer failed");
+    eventLoop_RemoveFd(g_loop, dev->timerFd);
+    close(dev->timerFd);
+    return -1;
+  }
+  return g_deviceCount++;
+}
+
+int modbusPoller_DeviceCount(void) { return g_deviceCount; }
+
+int modbusPoller_GetDeviceStats(int index, const char **name,
+                                modbusDeviceStats_t *stats) {
+  if (index < 0 || index >= g_deviceCount) {
+    return -1;
+  }
+  *name = g_devices[index].config.name;
+  *stats = g_devices[index].stats;
+  return 0;
+}
+
+void modbusPoller_Deinit(void) {
+  for (int i = 0; i < g_deviceCount; i++) {
+    modbusDevice_t *dev = &g_devices[i];
+    eventLoop_RemoveFd(g_loop, dev->timerFd);
+    close(dev->timerFd);
+    dev->stats.connected = false; // 正常退出不打印断开
+    dropConnection(dev, "shutdown");
+  }
+  g_deviceCount = 0;
+}
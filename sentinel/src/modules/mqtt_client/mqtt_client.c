@@ -1,4 +1,9 @@
 #include "modules/mqtt_client.h"
+#include "modules/lock_profile.h"
+#include "modules/logger.h"
+#include "modules/mem_pool.h"
+#include "modules/sim_clock.h"
+#include "modules/watchdog.h"
 #include <MQTTClient.h>
 #include <pthread.h>
 #include <stdbool.h>
@@ -8,6 +13,16 @@
 #include <time.h>
 #include <unistd.h>
 
+/* 有日志回调时交给回调（异步日志），否则直接输出到stderr */
+#define MQTT_LOG(ctx, level, ...)                                              \
+  do {                                                                         \
+    if ((ctx)->loggerCb) {                                                     \
+      (ctx)->loggerCb((level), __VA_ARGS__);                                   \
+    } else {                                                                   \
+      fprintf(stderr, __VA_ARGS__);                                            \
+    }                                                                          \
+  } while (0)
+
 /* 回调函数实现 */
 
 /*
@@ -18,14 +33,54 @@
  * */
 void paho_conn_lost(void *context, char *cause) {
   mqttClientContext_t *ctx = (mqttClientContext_t *)context;
-  pthread_mutex_lock(&ctx->lock);
-  ctx->isConnected = false;
-  // log日志
+  PROFILED_LOCK(&ctx->lock);
+  // MQTT 5 下Broker主动断开时先后触发disconnected和connectionLost，只通知一次
+  bool wasConnected =
+      __atomic_exchange_n(&ctx->isConnected, false, __ATOMIC_ACQ_REL);
+  if (wasConnected) {
+    MQTT_LOG(ctx, LOG_LEVEL_WARN, "Connection to %s lost: %s.\n",
+             ctx->config.brokerAddress, cause ? cause : "unknown");
+  }
 
-  if (ctx->onConnStatusCb) {
+  if (wasConnected && ctx->onConnStatusCb) {
     ctx->onConnStatusCb(false, ctx->onConnStatusUserData);
   }
-  pthread_mutex_unlock(&ctx->lock);
+  lockProfile_Unlock(&ctx->lock);
+}
+
+/*
+ * @brief MQTT 5：收到Broker的DISCONNECT报文时被paho库调用
+ *
+ * @param reasonCode: Broker给出的断开原因
+ * */
+void paho_disconnected(void *context, MQTTProperties *properties,
+                       enum MQTTReasonCodes reasonCode) {
+  mqttClientContext_t *ctx = (mqttClientContext_t *)context;
+  __atomic_store_n(&ctx->connectStats.lastDisconnectReason, (int)reasonCode,
+                   __ATOMIC_RELAXED);
+  MQTT_LOG(ctx, LOG_LEVEL_WARN, "Broker %s disconnected: %s (0x%02x).\n",
+           ctx->config.brokerAddress, MQTTReasonCode_toString(reasonCode),
+           (unsigned)reasonCode);
+  paho_conn_lost(context, NULL);
+}
+
+/*
+ * @brief MQTT 5：收到PUBACK/PUBREC/PUBCOMP时被paho库调用，
+ *        记录Broker拒绝消息的原因码
+ * */
+void paho_published(void *context, int dt, int packet_type,
+                    MQTTProperties *properties,
+                    enum MQTTReasonCodes reasonCode) {
+  mqttClientContext_t *ctx = (mqttClientContext_t *)context;
+  if (reasonCode >= MQTTREASONCODE_UNSPECIFIED_ERROR) {
+    __atomic_add_fetch(&ctx->publishStats.rejected, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&ctx->publishStats.lastReasonCode, (int)reasonCode,
+                     __ATOMIC_RELAXED);
+    MQTT_LOG(ctx, LOG_LEVEL_WARN,
+             "Broker %s rejected message %d: %s (0x%02x).\n",
+             ctx->config.brokerAddress, dt,
+             MQTTReasonCode_toString(reasonCode), (unsigned)reasonCode);
+  }
 }
 
 /*
@@ -41,7 +96,25 @@ int paho_msg_arrived(void *context, char *topicName, int topicLen,
   mqttClientContext_t *ctx = (mqttClientContext_t *)context;
   // log日志
 
-  if (ctx->onCommandCb) {
+  if (ctx->onCommandCb && ctx->rxPayloadBuf) {
+    // 静态内存模式：复制到启动时预分配的缓冲区，不在接收路径上分配内存
+    if (topicLen <= 0) {
+      topicLen = strlen(topicName);
+    }
+    if (topicLen < ctx->config.maxTopicLen &&
+        message->payloadlen < ctx->config.maxPayloadBytes) {
+      memcpy(ctx->rxTopicBuf, topicName, topicLen);
+      ctx->rxTopicBuf[topicLen] = '\0';
+      memcpy(ctx->rxPayloadBuf, message->payload, message->payloadlen);
+      ctx->rxPayloadBuf[message->payloadlen] = '\0';
+      ctx->onCommandCb(ctx->rxTopicBuf, ctx->rxPayloadBuf, message->payloadlen,
+                       ctx->onCommandUserData);
+    } else {
+      ctx->rxDropped++;
+      MQTT_LOG(ctx, LOG_LEVEL_WARN, "Drop oversized message (%d bytes).\n",
+               message->payloadlen);
+    }
+  } else if (ctx->onCommandCb) {
     // 复制topic和payload，因为paho提供的指针生命周期只在回调函数内
     char *topicCopy = strndup(topicName, topicLen);
     char *payloadCopy = (char *)malloc(message->payloadlen + 1);
@@ -72,6 +145,36 @@ void paho_delivery_complete(void *context, MQTTClient_deliveryToken dt) {
 }
 
 /* 内部辅助函数 */
+static bool isMqtt5(const mqttClientContext_t *ctx) {
+  return ctx->config.mqttVersion == MQTTVERSION_5;
+}
+
+static int64_t monotonicMs(void) { return simClock_NowMs(); }
+
+/*
+ * @brief 记录一次连接尝试，统计值只通过原子操作更新
+ * */
+static void recordConnect(mqttClientContext_t *ctx, bool success,
+                          int elapsedMs, bool psk) {
+  mqttConnectStats_t *stats = &ctx->connectStats;
+  __atomic_add_fetch(&stats->attempts, 1, __ATOMIC_RELAXED);
+  if (!success) {
+    __atomic_add_fetch(&stats->failures, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  __atomic_add_fetch(&stats->connects, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&stats->totalMs, elapsedMs, __ATOMIC_RELAXED);
+  if (psk) {
+    __atomic_add_fetch(&stats->pskConnects, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->pskTotalMs, elapsedMs, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&stats->lastMs, elapsedMs, __ATOMIC_RELAXED);
+  if (elapsedMs > __atomic_load_n(&stats->maxMs, __ATOMIC_RELAXED)) {
+    __atomic_store_n(&stats->maxMs, elapsedMs, __ATOMIC_RELAXED);
+  }
+}
+
 /*
  * @brief 尝试连接MQTT Broker
  *
@@ -79,10 +182,41 @@ void paho_delivery_complete(void *context, MQTTClient_deliveryToken dt) {
  * */
 static int connectToBroker(mqttClientContext_t *ctx) {
   MQTTClient_connectOptions conn_opts = MQTTClient_connectOptions_initializer;
+  MQTTClient_connectOptions conn_opts5 = MQTTClient_connectOptions_initializer5;
   int rc;
 
-  conn_opts.cleansession = ctx->config.cleanSession;
+  if (isMqtt5(ctx)) {
+    // MQTT 5 使用 cleanstart，cleansession 必须为0
+    conn_opts = conn_opts5;
+    conn_opts.cleanstart = ctx->config.cleanSession;
+  } else {
+    conn_opts.cleansession = ctx->config.cleanSession;
+  }
   conn_opts.keepAliveInterval = ctx->config.keepAliveInterval;
+  if (ctx->config.connectTimeoutSec > 0) {
+    conn_opts.connectTimeout = ctx->config.connectTimeoutSec;
+  }
+
+  // 配置TLS（paho按 ssl:// 或 mqtts:// 前缀决定是否使用TLS）
+  MQTTClient_SSLOptions ssl_opts = MQTTClient_SSLOptions_initializer;
+  const mqttTlsConfig_t *tls = &ctx->config.tls;
+  if (tls->enabled) {
+    ssl_opts.trustStore = tls->caFile;
+    ssl_opts.CApath = tls->caPath;
+    ssl_opts.keyStore = tls->certFile;
+    ssl_opts.privateKey = tls->keyFile;
+    ssl_opts.privateKeyPassword = tls->keyPassword;
+    ssl_opts.enabledCipherSuites = tls->ciphers;
+    ssl_opts.enableServerCertAuth = tls->verifyServer;
+    ssl_opts.verify = tls->verifyHostname;
+    if (ctx->psk.keyLen > 0) {
+      // TLS 1.2 中PSK回调只在Broker选择PSK套件时调用，可据此统计命中率
+      ssl_opts.sslVersion = MQTT_SSL_VERSION_TLS_1_2;
+      ssl_opts.ssl_psk_cb = mqttTls_PskCallback;
+      ssl_opts.ssl_psk_context = &ctx->psk;
+    }
+    conn_opts.ssl = &ssl_opts;
+  }
 
   // 存在用户名和密码
   if (ctx->config.userName && ctx->config.password) {
@@ -104,15 +238,49 @@ static int connectToBroker(mqttClientContext_t *ctx) {
   // log日志
 
   // 连接Broker
-  pthread_mutex_lock(&ctx->lock); // 保护客户端操作
-  rc = MQTTClient_connect(ctx->client, &conn_opts);
+  PROFILED_LOCK(&ctx->lock); // 保护客户端操作
+  unsigned long pskBefore =
+      __atomic_load_n(&ctx->psk.invocations, __ATOMIC_RELAXED);
+  int64_t start = monotonicMs();
+  int brokerAliasMax = 0;
+  if (ctx->config.simulated) {
+    rc = simBroker_Connect(&ctx->simSession) == 0 ? MQTTCLIENT_SUCCESS
+                                                  : MQTTCLIENT_FAILURE;
+  } else if (isMqtt5(ctx)) {
+    MQTTResponse response = MQTTClient_connect5(ctx->client, &conn_opts, NULL,
+                                                NULL);
+    rc = response.reasonCode;
+    if (rc == MQTTCLIENT_SUCCESS && response.properties &&
+        MQTTProperties_hasProperty(response.properties,
+                                   MQTTPROPERTY_CODE_TOPIC_ALIAS_MAXIMUM)) {
+      brokerAliasMax = MQTTProperties_getNumericValue(
+          response.properties, MQTTPROPERTY_CODE_TOPIC_ALIAS_MAXIMUM);
+    }
+    MQTTResponse_free(response);
+    __atomic_store_n(&ctx->connectStats.lastConnectReason, rc,
+                     __ATOMIC_RELAXED);
+    if (rc >= MQTTREASONCODE_UNSPECIFIED_ERROR) {
+      MQTT_LOG(ctx, LOG_LEVEL_WARN,
+               "Broker %s refused connection: %s (0x%02x).\n",
+               ctx->config.brokerAddress,
+               MQTTReasonCode_toString((enum MQTTReasonCodes)rc), rc);
+    }
+  } else {
+    rc = MQTTClient_connect(ctx->client, &conn_opts);
+  }
+  recordConnect(ctx, rc == MQTTCLIENT_SUCCESS, (int)(monotonicMs() - start),
+                __atomic_load_n(&ctx->psk.invocations, __ATOMIC_RELAXED) !=
+                    pskBefore);
   if (rc != MQTTCLIENT_SUCCESS) {
-    pthread_mutex_unlock(&ctx->lock);
+    lockProfile_Unlock(&ctx->lock);
     return -1;
   }
 
-  ctx->isConnected = true;
-  pthread_mutex_unlock(&ctx->lock);
+  // 别名只在本次连接内有效，按Broker允许的数量重新分配
+  mqttV5_AliasReset(&ctx->aliases, brokerAliasMax);
+
+  __atomic_store_n(&ctx->isConnected, true, __ATOMIC_RELEASE);
+  lockProfile_Unlock(&ctx->lock);
 
   // 连接成功后，发布上线消息（如果配置了LWT，通常LWT的topic就是online topic）
   // 确保与LWT topic一直，并带上Reatain标志，让所有订阅者知道设备上线了
@@ -122,7 +290,7 @@ static int connectToBroker(mqttClientContext_t *ctx) {
     char onlinePayload[128];
     snprintf(onlinePayload, sizeof(onlinePayload),
              "{\"status\":\"online\",\"timestamp_ms\":%ld}",
-             (long)time(NULL) * 1000);
+             (long)simClock_RealtimeMs());
 
     // 使用publish函数，Qos 1，Ratain为true
     // 注意：这里要确保LWT的topic和online status topic
@@ -139,7 +307,14 @@ static int connectToBroker(mqttClientContext_t *ctx) {
 
   rc = mqttClient_Subscribe(ctx, controlTopic, 1);
   if (rc != 0) {
-    fprintf(stderr, "Faild to subscribe to control topic.\n");
+    MQTT_LOG(ctx, LOG_LEVEL_ERROR, "Faild to subscribe to control topic.\n");
+  }
+  for (int i = 0; i < ctx->extraCount; i++) {
+    if (mqttClient_Subscribe(ctx, ctx->extraTopics[i], ctx->extraQos[i]) !=
+        0) {
+      MQTT_LOG(ctx, LOG_LEVEL_ERROR, "Failed to subscribe to %s.\n",
+               ctx->extraTopics[i]);
+    }
   }
 
   // 通知上层模块连接成功
@@ -150,10 +325,22 @@ static int connectToBroker(mqttClientContext_t *ctx) {
   return 0;
 }
 
+#define RECONNECT_MAX_DELAY_SEC 300
+
 /*
- * @brief 自动重联线程函数
- *
- *
+ * @brief 可被mqttClient_Disconnect打断的等待
+ * */
+static void waitReconnectDelay(mqttClientContext_t *ctx, int delaySec) {
+  for (int i = 0; i < delaySec * 10 && !ctx->shouldExit; i++) {
+    simClock_SleepMs(100);
+    watchdog_Kick(ctx->watchdogId);
+  }
+}
+
+/*
+ * @brief 自动重联线程函数：启动后立即连接，失败后指数退避。
+ *        超过最大重连次数时不再退出进程，而是按最大间隔继续重试，
+ *        是否切换到其他Broker由上层决定
  * */
 static void *reConnectThreadFunc(void *arg) {
   mqttClientContext_t *ctx = (mqttClientContext_t *)arg;
@@ -161,10 +348,16 @@ static void *reConnectThreadFunc(void *arg) {
   int currentDelay = ctx->config.reconnectDelaySec;
 
   while (!ctx->shouldExit) {
-    pthread_mutex_lock(&ctx->lock);
-    bool connected = ctx->isConnected;
-    pthread_mutex_unlock(&ctx->lock);
-
+    watchdog_Kick(ctx->watchdogId);
+    bool connected = mqttClient_IsConnected(ctx);
+
+    if (connected && ctx->config.simulated) {
+      // 仿真Broker按keep-alive计算发现断线的时刻，等待期间到达时提前返回
+      if (simBroker_Yield(&ctx->simSession, 1000) != 0) {
+        paho_conn_lost(ctx, "simulated outage");
+      }
+      continue;
+    }
     if (connected) {
       // 如果已经连接，定期调用paho的yield来处理网络IO和keep-alive
       MQTTClient_yield();    // yield 1s
@@ -174,23 +367,28 @@ static void *reConnectThreadFunc(void *arg) {
       continue;
     }
 
-    if (ctx->config.maxReconnectAttempts > 0 &&
-        reconnectAttempts >= ctx->config.maxReconnectAttempts) {
-      fprintf(stderr, "Exceeded max MQTT reconnect attempts (%d). Aborting.\n",
-              ctx->config.maxReconnectAttempts);
-      exit(EXIT_FAILURE);
-    }
-
-    sleep(currentDelay);
-
     if (connectToBroker(ctx) == 0) {
       reconnectAttempts = 0;
       currentDelay = ctx->config.reconnectDelaySec;
-    } else {
-      reconnectAttempts++;
-      // 指数退避，但限制最大重联间隔
-      currentDelay = currentDelay * 2 > 300 ? 300 : currentDelay * 2;
+      continue;
     }
+
+    reconnectAttempts++;
+    if (ctx->config.maxReconnectAttempts > 0 &&
+        reconnectAttempts == ctx->config.maxReconnectAttempts) {
+      MQTT_LOG(ctx, LOG_LEVEL_WARN,
+               "Exceeded max MQTT reconnect attempts (%d) for %s, retrying "
+               "every %d s.\n",
+               ctx->config.maxReconnectAttempts, ctx->config.brokerAddress,
+               RECONNECT_MAX_DELAY_SEC);
+      currentDelay = RECONNECT_MAX_DELAY_SEC;
+    }
+
+    waitReconnectDelay(ctx, currentDelay);
+    // 指数退避，但限制最大重联间隔
+    currentDelay = currentDelay * 2 > RECONNECT_MAX_DELAY_SEC
+                       ? RECONNECT_MAX_DELAY_SEC
+                       : currentDelay * 2;
   }
   return NULL;
 }
@@ -210,34 +408,99 @@ int mqttClient_Init(mqttClientContext_t *ctx,
   }
 
   memset(ctx, 0, sizeof(mqttClientContext_t));
+  ctx->watchdogId = -1;
 
   // 复制配置信息
-  ctx->config.brokerAddress = strdup(config->brokerAddress);
-  ctx->config.clientID = strdup(config->clientID);
+  ctx->config.brokerAddress = memPool_Strdup(config->brokerAddress);
+  ctx->config.clientID = memPool_Strdup(config->clientID);
   if (config->userName)
-    ctx->config.userName = strdup(config->userName);
+    ctx->config.userName = memPool_Strdup(config->userName);
   if (config->password)
-    ctx->config.password = strdup(config->password);
+    ctx->config.password = memPool_Strdup(config->password);
   ctx->config.keepAliveInterval = config->keepAliveInterval;
   ctx->config.reconnectDelaySec = config->reconnectDelaySec;
   ctx->config.maxReconnectAttempts = config->maxReconnectAttempts;
+  ctx->config.connectTimeoutSec = config->connectTimeoutSec;
   ctx->config.cleanSession = config->cleanSession;
+  ctx->config.maxPayloadBytes = config->maxPayloadBytes;
+  ctx->config.maxTopicLen = config->maxTopicLen;
+  mqttTls_CopyConfig(&ctx->config.tls, &config->tls);
+  ctx->config.mqttVersion =
+      config->mqttVersion == 0 ? MQTTVERSION_3_1_1 : config->mqttVersion;
+  ctx->config.topicAliasMax =
+      ctx->config.mqttVersion == MQTTVERSION_5 ? config->topicAliasMax : 0;
+  ctx->loggerCb = config->logger;
+  ctx->config.simulated = config->simulated;
 
   if (!ctx->config.brokerAddress || !ctx->config.clientID ||
       (ctx->config.userName && !ctx->config.password) ||
       (!ctx->config.userName && ctx->config.password)) {
     // log日志:初始化失败
-    free(ctx->config.brokerAddress);
-    free(ctx->config.clientID);
-    free(ctx->config.userName);
-    free(ctx->config.password);
+    memPool_Free(ctx->config.brokerAddress);
+    memPool_Free(ctx->config.clientID);
+    memPool_Free(ctx->config.userName);
+    memPool_Free(ctx->config.password);
+    mqttTls_FreeConfig(&ctx->config.tls);
     return -1;
   }
 
+  if (ctx->config.mqttVersion != MQTTVERSION_3_1_1 &&
+      ctx->config.mqttVersion != MQTTVERSION_5) {
+    MQTT_LOG(ctx, LOG_LEVEL_ERROR, "Unsupported MQTT version %d.\n",
+             ctx->config.mqttVersion);
+    return -1;
+  }
+  if (mqttV5_AliasInit(&ctx->aliases, ctx->config.topicAliasMax,
+                       ctx->config.maxTopicLen > 0 ? ctx->config.maxTopicLen
+                                                   : 128) != 0) {
+    MQTT_LOG(ctx, LOG_LEVEL_ERROR, "Invalid topicAliasMax %d (at most %d).\n",
+             ctx->config.topicAliasMax, MQTT_TOPIC_ALIAS_MAX);
+    return -1;
+  }
+
+  if (mqttTls_CheckConfig(&ctx->config.tls) != 0 ||
+      mqttTls_InitPsk(&ctx->psk, ctx->config.tls.pskIdentity,
+                      ctx->config.tls.pskKey) != 0) {
+    MQTT_LOG(ctx, LOG_LEVEL_ERROR, "Invalid TLS configuration for %s.\n",
+             ctx->config.brokerAddress);
+    return -1;
+  }
+  if (ctx->config.tls.enabled &&
+      strncmp(ctx->config.brokerAddress, "ssl://", 6) != 0 &&
+      strncmp(ctx->config.brokerAddress, "mqtts://", 8) != 0) {
+    MQTT_LOG(ctx, LOG_LEVEL_WARN,
+             "Warning: TLS enabled but %s is not an ssl:// address.\n",
+             ctx->config.brokerAddress);
+  }
+
+  // 预分配接收缓冲区（+1 用于字符串结束符）
+  if (ctx->config.maxPayloadBytes > 0 && ctx->config.maxTopicLen > 0) {
+    ctx->rxTopicBuf = (char *)memPool_Alloc(ctx->config.maxTopicLen + 1);
+    ctx->rxPayloadBuf = (char *)memPool_Alloc(ctx->config.maxPayloadBytes + 1);
+    if (!ctx->rxTopicBuf || !ctx->rxPayloadBuf) {
+      MQTT_LOG(ctx, LOG_LEVEL_ERROR,
+               "Failed to reserve MQTT receive buffers.\n");
+      return -1;
+    }
+  }
+
+  if (ctx->config.simulated) {
+    if (simBroker_Open(&ctx->simSession, ctx->config.brokerAddress,
+                       ctx->config.keepAliveInterval,
+                       mqttClient_ConnectTimeoutMs(ctx)) != 0) {
+      return -1;
+    }
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthread_cond_init(&ctx->cond, NULL);
+    return 0;
+  }
+
   // 初始化MQTT客户端实例
-  int rc = MQTTClient_create(&ctx->client, ctx->config.brokerAddress,
-                             ctx->config.clientID, MQTTCLIENT_PERSISTENCE_NONE,
-                             NULL);
+  MQTTClient_createOptions createOpts = MQTTClient_createOptions_initializer;
+  createOpts.MQTTVersion = ctx->config.mqttVersion;
+  int rc = MQTTClient_createWithOptions(
+      &ctx->client, ctx->config.brokerAddress, ctx->config.clientID,
+      MQTTCLIENT_PERSISTENCE_NONE, NULL, &createOpts);
   if (rc != MQTTCLIENT_SUCCESS) {
     // log日志：创建客户端实例失败
     return -1;
@@ -246,6 +509,10 @@ int mqttClient_Init(mqttClientContext_t *ctx,
   // 设置回调函数
   MQTTClient_setCallbacks(ctx->client, ctx, paho_conn_lost, paho_msg_arrived,
                           paho_delivery_complete);
+  if (isMqtt5(ctx)) {
+    MQTTClient_setDisconnected(ctx->client, ctx, paho_disconnected);
+    MQTTClient_setPublished(ctx->client, ctx, paho_published);
+  }
 
   // 初始化互斥锁
   pthread_mutex_init(&ctx->lock, NULL);
@@ -289,78 +556,140 @@ void mqttClient_RegisterConnectionStatusCallback(
 void mqttClient_SetLWT(mqttClientContext_t *ctx, const char *topic,
                        const char *payload, int qos) {
   if (ctx) {
-    free(ctx->lwtTopic);
-    free(ctx->lwtPayload); // 释放旧的
-    ctx->lwtTopic = topic;
-    ctx->lwtPayload = payload;
+    memPool_Free(ctx->lwtTopic);
+    memPool_Free(ctx->lwtPayload); // 释放旧的
+    ctx->lwtTopic = memPool_Strdup(topic);
+    ctx->lwtPayload = memPool_Strdup(payload);
     ctx->lwtQos = qos;
 
     if (!ctx->lwtTopic || !ctx->lwtPayload) {
       // 设置失败
-      fprintf(stderr, "Fail to set LWT.\n");
+      MQTT_LOG(ctx, LOG_LEVEL_ERROR, "Fail to set LWT.\n");
     }
   }
 }
 
-/*  */
-static pthread_t reconnectThreadID;
+int mqttClient_AddSubscription(mqttClientContext_t *ctx, const char *topic,
+                               int qos) {
+  if (!ctx || !topic || ctx->extraCount >= MQTT_MAX_EXTRA_SUBSCRIPTIONS) {
+    return -1;
+  }
+
+  char *copy = memPool_Strdup(topic);
+  if (!copy) {
+    return -1;
+  }
+  ctx->extraTopics[ctx->extraCount] = copy;
+  ctx->extraQos[ctx->extraCount] = qos;
+  ctx->extraCount++;
+  return 0;
+}
 
 /*
- * @brief 启动MQTT客户端的连接和后台处理线程。
- *        这是一个阻塞函数，应在单独的线程中调用。
+ * @brief 启动MQTT客户端的连接和后台处理线程，立即返回。
  *
  * @param ctx: MQTT客户端上下文指针
+ *
+ * @return 0 成功
  * */
-void mqttClient_Start(mqttClientContext_t *ctx) {
+int mqttClient_Start(mqttClientContext_t *ctx) {
   if (!ctx) {
-    return;
+    return -1;
+  }
+  if (ctx->threadRunning) {
+    return 0;
   }
 
   ctx->shouldExit = false;
 
+  // 连接可能持续到连接超时（含TLS握手），留出两倍余量
+  if (ctx->watchdogId < 0) {
+    const char *host = strstr(ctx->config.brokerAddress, "://");
+    char name[WATCHDOG_NAME_LEN];
+    snprintf(name, sizeof(name), "mqtt:%s",
+             host ? host + 3 : ctx->config.brokerAddress);
+    ctx->watchdogId =
+        watchdog_Register(name, mqttClient_ConnectTimeoutMs(ctx) * 2 + 10000,
+                          NULL, NULL);
+  }
+
   // 启动一个独立的线程用来处理连接和重联逻辑
-  if (pthread_create(&reconnectThreadID, NULL, reConnectThreadFunc, ctx) != 0) {
-    fprintf(stderr, "Fail to create MQTT reconnect thread \n");
-    exit(EXIT_FAILURE);
+  if (simClock_CreateThread(&ctx->reconnectThread, reConnectThreadFunc,
+                            ctx) != 0) {
+    MQTT_LOG(ctx, LOG_LEVEL_ERROR, "Fail to create MQTT reconnect thread \n");
+    return -1;
   }
+  ctx->threadRunning = true;
+  return 0;
 }
 
 /*
- * @brief 停止MQTT客户端并清理资源
+ * @brief 停止后台线程并断开连接，保留客户端实例，可以再次启动
  *
  * @param ctx: MQTT客户端上下文指针
  * */
-void mqttClient_Stop(mqttClientContext_t *ctx) {
+void mqttClient_Disconnect(mqttClientContext_t *ctx) {
   if (!ctx) {
     return;
   }
 
   ctx->shouldExit = true;
   // 等待后台线程结束
-  if (reconnectThreadID != 0) {
-    pthread_join(reconnectThreadID, NULL);
-    reconnectThreadID = 0; // 重置
+  if (ctx->threadRunning) {
+    simClock_JoinThread(ctx->reconnectThread);
+    ctx->threadRunning = false;
+    watchdog_Idle(ctx->watchdogId);
   }
 
-  pthread_mutex_lock(&ctx->lock);
-  if (ctx->isConnected) {
-    MQTTClient_disconnect(ctx->client, 1000);
-    ctx->isConnected = false;
+  PROFILED_LOCK(&ctx->lock);
+  if (mqttClient_IsConnected(ctx)) {
+    if (ctx->config.simulated) {
+      simBroker_Disconnect(&ctx->simSession);
+    } else if (isMqtt5(ctx)) {
+      MQTTClient_disconnect5(ctx->client, 1000,
+                             MQTTREASONCODE_NORMAL_DISCONNECTION, NULL);
+    } else {
+      MQTTClient_disconnect(ctx->client, 1000);
+    }
+    __atomic_store_n(&ctx->isConnected, false, __ATOMIC_RELEASE);
     if (ctx->onConnStatusCb) {
       ctx->onConnStatusCb(false, ctx->onConnStatusUserData);
     }
   }
-  pthread_mutex_unlock(&ctx->lock);
+  lockProfile_Unlock(&ctx->lock);
+}
+
+/*
+ * @brief 停止MQTT客户端并清理资源
+ *
+ * @param ctx: MQTT客户端上下文指针
+ * */
+void mqttClient_Stop(mqttClientContext_t *ctx) {
+  if (!ctx) {
+    return;
+  }
+
+  mqttClient_Disconnect(ctx);
 
   // 清理客户端资源
-  MQTTClient_destroy(&ctx->client);
+  if (!ctx->config.simulated) {
+    MQTTClient_destroy(&ctx->client);
+  }
 
-  free(ctx->config.brokerAddress);
-  free(ctx->config.clientID);
-  free(ctx->config.userName);
-  free(ctx->config.password);
-  free(ctx->lwtPayload);
-  free(ctx->lwtTopic);
+  memPool_Free(ctx->config.brokerAddress);
+  memPool_Free(ctx->config.clientID);
+  memPool_Free(ctx->config.userName);
+  memPool_Free(ctx->config.password);
+  memPool_Free(ctx->lwtPayload);
+  memPool_Free(ctx->lwtTopic);
+  for (int i = 0; i < ctx->extraCount; i++) {
+    memPool_Free(ctx->extraTopics[i]);
+  }
+  ctx->extraCount = 0;
+  memPool_Free(ctx->rxTopicBuf);
+  memPool_Free(ctx->rxPayloadBuf);
+  mqttTls_FreeConfig(&ctx->config.tls);
+  mqttV5_AliasFree(&ctx->aliases);
 
   // 摧毁互斥锁和条件变量
   pthread_mutex_destroy(&ctx->lock);
@@ -382,15 +711,131 @@ void mqttClient_Stop(mqttClientContext_t *ctx) {
 int mqttClient_Publish(mqttClientContext_t *ctx, const char *topic,
                        const char *payload, int payloadLen, int qos,
                        bool retained) {
+  return mqttClient_PublishWithOptions(ctx, topic, payload, payloadLen, qos,
+                                       retained, NULL, NULL);
+}
+
+/*
+ * @brief 把发布属性转换为paho的属性列表
+ * */
+static void buildProperties(MQTTProperties *props,
+                            const mqttPublishOptions_t *options, int alias) {
+  MQTTProperty property;
+  if (alias > 0) {
+    property.identifier = MQTTPROPERTY_CODE_TOPIC_ALIAS;
+    property.value.integer2 = (unsigned short)alias;
+    MQTTProperties_add(props, &property);
+  }
+  if (!options) {
+    return;
+  }
+
+  if (options->messageExpirySec > 0) {
+    property.identifier = MQTTPROPERTY_CODE_MESSAGE_EXPIRY_INTERVAL;
+    property.value.integer4 = (unsigned int)options->messageExpirySec;
+    MQTTProperties_add(props, &property);
+  }
+  if (options->contentType) {
+    property.identifier = MQTTPROPERTY_CODE_CONTENT_TYPE;
+    property.value.data.data = (char *)options->contentType;
+    property.value.data.len = strlen(options->contentType);
+    MQTTProperties_add(props, &property);
+  }
+  for (int i = 0; i < options->userPropertyCount; i++) {
+    const mqttUserProperty_t *user = &options->userProperties[i];
+    property.identifier = MQTTPROPERTY_CODE_USER_PROPERTY;
+    property.value.data.data = (char *)user->name;
+    property.value.data.len = strlen(user->name);
+    property.value.value.data = (char *)user->value;
+    property.value.value.len = strlen(user->value);
+    MQTTProperties_add(props, &property);
+  }
+}
+
+/*
+ * @brief 记录一条已发出的消息（报文字节数按协议编码计算）
+ * */
+static void recordPublish(mqttClientContext_t *ctx, int topicLen,
+                          int savedTopicLen, int payloadLen, int qos,
+                          int propertiesLen) {
+  mqttPublishStats_t *stats = &ctx->publishStats;
+  int bytes = mqttV5_PublishPacketSize(ctx->config.mqttVersion, topicLen,
+                                       payloadLen, qos, propertiesLen);
+  __atomic_add_fetch(&stats->messages, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&stats->bytes, bytes, __ATOMIC_RELAXED);
+  if (savedTopicLen > 0) {
+    __atomic_add_fetch(&stats->aliasHits, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->aliasSavedBytes, savedTopicLen,
+                       __ATOMIC_RELAXED);
+  }
+}
+
+/*
+ * @brief MQTT 5 发布：Topic已有别名时只发送别名（Topic为空字符串），
+ *        第一次使用某个Topic时同时发送Topic和新分配的别名
+ *
+ * @return paho返回码或Broker原因码
+ * */
+static int publishMqtt5(mqttClientContext_t *ctx, const char *topic,
+                        MQTTClient_message *pubmsg,
+                        const mqttPublishOptions_t *options) {
+  // 持久会话下paho在重连后原样重发未确认的QoS>0消息，而别名在新连接上
+  // 无效，因此这类消息不使用别名
+  bool established = false;
+  int alias = 0;
+  if (pubmsg->qos == 0 || ctx->config.cleanSession) {
+    alias = mqttV5_AliasLookup(&ctx->aliases, topic, &established);
+  }
+  buildProperties(&pubmsg->properties, options, alias);
+
+  MQTTClient_deliveryToken token;
+  MQTTResponse response = MQTTClient_publishMessage5(
+      ctx->client, established ? "" : topic, pubmsg, &token);
+  int rc = response.reasonCode;
+  MQTTResponse_free(response);
+  MQTTProperties_free(&pubmsg->properties);
+
+  if (rc != MQTTCLIENT_SUCCESS) {
+    // 无法确定Broker是否收到了别名映射，重新开始分配
+    mqttV5_AliasReset(&ctx->aliases, ctx->aliases.max);
+    return rc;
+  }
+
+  int topicLen = strlen(topic);
+  recordPublish(ctx, established ? 0 : topicLen, established ? topicLen : 0,
+                pubmsg->payloadlen, pubmsg->qos,
+                mqttV5_PropertiesLength(options, alias));
+  return rc;
+}
+
+int mqttClient_PublishWithOptions(mqttClientContext_t *ctx, const char *topic,
+                                  const char *payload, int payloadLen, int qos,
+                                  bool retained,
+                                  const mqttPublishOptions_t *options,
+                                  int *reasonCode) {
+  if (reasonCode) {
+    *reasonCode = MQTTCLIENT_SUCCESS;
+  }
   if (!ctx || !topic || !payload) {
     return -1;
   }
 
+  // 重连线程在连接（可能持续到连接超时）期间持有锁，未连接时不等待锁
+  if (!mqttClient_IsConnected(ctx)) {
+    if (reasonCode) {
+      *reasonCode = MQTTCLIENT_DISCONNECTED;
+    }
+    return -1;
+  }
+
   // 保护客户端操作
-  pthread_mutex_lock(&ctx->lock);
-  if (!ctx->isConnected) {
-    pthread_mutex_unlock(&ctx->lock);
+  PROFILED_LOCK(&ctx->lock);
+  if (!mqttClient_IsConnected(ctx)) {
+    lockProfile_Unlock(&ctx->lock);
     // log日志
+    if (reasonCode) {
+      *reasonCode = MQTTCLIENT_DISCONNECTED;
+    }
     return -1;
   }
 
@@ -400,12 +845,32 @@ int mqttClient_Publish(mqttClientContext_t *ctx, const char *topic,
   pubmsg.payloadlen = payloadLen;
   pubmsg.qos = qos;
   pubmsg.retained = retained;
-  MQTTClient_deliveryToken token;
 
   // 发送信息
-  int rc = MQTTClient_publishMessage(ctx->client, topic, &pubmsg, &token);
-  pthread_mutex_unlock(&ctx->lock);
+  int rc;
+  if (ctx->config.simulated) {
+    // 仿真Broker不使用Topic别名
+    rc = simBroker_Publish(&ctx->simSession, payloadLen, qos) == 0
+             ? MQTTCLIENT_SUCCESS
+             : MQTTCLIENT_DISCONNECTED;
+    if (rc == MQTTCLIENT_SUCCESS) {
+      recordPublish(ctx, strlen(topic), 0, payloadLen, qos,
+                    isMqtt5(ctx) ? mqttV5_PropertiesLength(options, 0) : 0);
+    }
+  } else if (isMqtt5(ctx)) {
+    rc = publishMqtt5(ctx, topic, &pubmsg, options);
+  } else {
+    MQTTClient_deliveryToken token;
+    rc = MQTTClient_publishMessage(ctx->client, topic, &pubmsg, &token);
+    if (rc == MQTTCLIENT_SUCCESS) {
+      recordPublish(ctx, strlen(topic), 0, payloadLen, qos, 0);
+    }
+  }
+  lockProfile_Unlock(&ctx->lock);
 
+  if (reasonCode) {
+    *reasonCode = rc;
+  }
   if (rc != MQTTCLIENT_SUCCESS) {
     // log日志
     return -1;
@@ -429,18 +894,74 @@ int mqttClient_Subscribe(mqttClientContext_t *ctx, const char *topic, int qos) {
     return -1;
   }
 
-  pthread_mutex_lock(&ctx->lock);
-  if (!ctx->isConnected) {
-    pthread_mutex_unlock(&ctx->lock);
+  PROFILED_LOCK(&ctx->lock);
+  if (!mqttClient_IsConnected(ctx)) {
+    lockProfile_Unlock(&ctx->lock);
     return -1;
   }
 
-  int rc = MQTTClient_subscribe(ctx->client, topic, qos);
-  pthread_mutex_unlock(&ctx->lock);
+  int rc;
+  if (ctx->config.simulated) {
+    rc = qos;
+  } else if (isMqtt5(ctx)) {
+    // MQTT 5 的SUBACK原因码 0~2 为授予的QoS，>=0x80 为失败
+    MQTTResponse response =
+        MQTTClient_subscribe5(ctx->client, topic, qos, NULL, NULL);
+    rc = response.reasonCode;
+    MQTTResponse_free(response);
+  } else {
+    rc = MQTTClient_subscribe(ctx->client, topic, qos);
+  }
+  lockProfile_Unlock(&ctx->lock);
 
-  if (rc != MQTTCLIENT_SUCCESS) {
+  if (rc < 0 || rc >= MQTTREASONCODE_UNSPECIFIED_ERROR) {
     return -1;
   }
 
   return 0;
 }
+
+/*
+ * @brief 获取连接状态。isConnected 只通过原子操作访问，
+ *        采样线程和本地接口读取时不需要获取客户端锁
+ * */
+bool mqttClient_IsConnected(const mqttClientContext_t *ctx) {
+  return ctx && __atomic_load_n(&ctx->isConnected, __ATOMIC_ACQUIRE);
+}
+
+/* paho未设置连接超时时默认30秒 */
+int mqttClient_ConnectTimeoutMs(const mqttClientContext_t *ctx) {
+  int sec = ctx->config.connectTimeoutSec > 0 ? ctx->config.connectTimeoutSec
+                                              : 30;
+  return sec * 1000;
+}
+
+void mqttClient_GetConnectStats(const mqttClientContext_t *ctx,
+                                mqttConnectStats_t *stats) {
+  const mqttConnectStats_t *src = &ctx->connectStats;
+  stats->attempts = __atomic_load_n(&src->attempts, __ATOMIC_RELAXED);
+  stats->failures = __atomic_load_n(&src->failures, __ATOMIC_RELAXED);
+  stats->connects = __atomic_load_n(&src->connects, __ATOMIC_RELAXED);
+  stats->pskConnects = __atomic_load_n(&src->pskConnects, __ATOMIC_RELAXED);
+  stats->totalMs = __atomic_load_n(&src->totalMs, __ATOMIC_RELAXED);
+  stats->pskTotalMs = __atomic_load_n(&src->pskTotalMs, __ATOMIC_RELAXED);
+  stats->lastMs = __atomic_load_n(&src->lastMs, __ATOMIC_RELAXED);
+  stats->maxMs = __atomic_load_n(&src->maxMs, __ATOMIC_RELAXED);
+  stats->lastConnectReason =
+      __atomic_load_n(&src->lastConnectReason, __ATOMIC_RELAXED);
+  stats->lastDisconnectReason =
+      __atomic_load_n(&src->lastDisconnectReason, __ATOMIC_RELAXED);
+}
+
+void mqttClient_GetPublishStats(const mqttClientContext_t *ctx,
+                                mqttPublishStats_t *stats) {
+  const mqttPublishStats_t *src = &ctx->publishStats;
+  stats->messages = __atomic_load_n(&src->messages, __ATOMIC_RELAXED);
+  stats->bytes = __atomic_load_n(&src->bytes, __ATOMIC_RELAXED);
+  stats->aliasHits = __atomic_load_n(&src->aliasHits, __ATOMIC_RELAXED);
+  stats->aliasSavedBytes =
+      __atomic_load_n(&src->aliasSavedBytes, __ATOMIC_RELAXED);
+  stats->rejected = __atomic_load_n(&src->rejected, __ATOMIC_RELAXED);
+  stats->lastReasonCode =
+      __atomic_load_n(&src->lastReasonCode, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,150 @@
+#include "modules/mqtt_tls.h"
+#include "modules/mem_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static int checkReadable(const char *path, const char *what) {
+  if (path && path[0] != '\0' && access(path, R_OK) != 0) {
+    fprintf(stderr, "TLS %s not readable: %s\n", what, path);
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ * @brief 检查TLS配置。paho在连接时才加载证书，且只返回笼统的错误码，
+ *        这里提前检查文件和必填项
+ *
+ * @return 0 成功
+ * */
+int mqttTls_CheckConfig(const mqttTlsConfig_t *config) {
+  if (!config || !config->enabled) {
+    return 0;
+  }
+
+  int rc = 0;
+  rc |= checkReadable(config->caFile, "CA file");
+  rc |= checkReadable(config->certFile, "client certificate");
+  rc |= checkReadable(config->keyFile, "client key");
+
+  if (config->verifyServer && !config->caFile && !config->caPath) {
+    fprintf(stderr, "TLS server verification needs caFile or caPath.\n");
+    rc = -1;
+  }
+  if ((config->certFile != NULL) != (config->keyFile != NULL)) {
+    fprintf(stderr, "TLS client certificate and key must be set together.\n");
+    rc = -1;
+  }
+  if (config->pskIdentity && config->pskIdentity[0] != '\0') {
+    unsigned char key[MQTT_TLS_PSK_KEY_MAX];
+    if (mqttTls_ParseHexKey(config->pskKey, key, sizeof(key)) <= 0) {
+      fprintf(stderr, "TLS pskKey must be a non-empty hex string.\n");
+      rc = -1;
+    }
+  }
+  return rc == 0 ? 0 : -1;
+}
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+int mqttTls_ParseHexKey(const char *hex, unsigned char *key,
+                        unsigned int maxLen) {
+  if (!hex || !key) {
+    return -1;
+  }
+
+  size_t len = strlen(hex);
+  if (len % 2 != 0 || len / 2 > maxLen) {
+    return -1;
+  }
+  for (size_t i = 0; i < len / 2; i++) {
+    int high = hexValue(hex[2 * i]);
+    int low = hexValue(hex[2 * i + 1]);
+    if (high < 0 || low < 0) {
+      return -1;
+    }
+    key[i] = (unsigned char)(high << 4 | low);
+  }
+  return (int)(len / 2);
+}
+
+int mqttTls_InitPsk(mqttTlsPsk_t *psk, const char *identity,
+                    const char *keyHex) {
+  if (!psk) {
+    return -1;
+  }
+
+  memset(psk, 0, sizeof(mqttTlsPsk_t));
+  if (!identity || identity[0] == '\0') {
+    return 0;
+  }
+  if (strlen(identity) >= sizeof(psk->identity)) {
+    return -1;
+  }
+
+  int keyLen = mqttTls_ParseHexKey(keyHex, psk->key, sizeof(psk->key));
+  if (keyLen <= 0) {
+    return -1;
+  }
+  snprintf(psk->identity, sizeof(psk->identity), "%s", identity);
+  psk->keyLen = keyLen;
+  return 0;
+}
+
+/*
+ * @brief PSK回调：只有Broker选择了PSK套件时才会被调用（TLS 1.2），
+ *        调用次数用于统计PSK握手的命中率
+ *
+ * @return 密钥长度，0 表示不使用PSK
+ * */
+unsigned int mqttTls_PskCallback(const char *hint, char *identity,
+                                 unsigned int maxIdentityLen,
+                                 unsigned char *psk, unsigned int maxPskLen,
+                                 void *userData) {
+  mqttTlsPsk_t *state = (mqttTlsPsk_t *)userData;
+  if (!state || state->keyLen == 0 || state->keyLen > maxPskLen ||
+      strlen(state->identity) >= maxIdentityLen) {
+    return 0;
+  }
+
+  snprintf(identity, maxIdentityLen, "%s", state->identity);
+  memcpy(psk, state->key, state->keyLen);
+  __atomic_add_fetch(&state->invocations, 1, __ATOMIC_RELAXED);
+  return state->keyLen;
+}
+
+void mqttTls_CopyConfig(mqttTlsConfig_t *dst, const mqttTlsConfig_t *src) {
+  *dst = *src;
+  dst->caFile = memPool_Strdup(src->caFile);
+  dst->caPath = memPool_Strdup(src->caPath);
+  dst->certFile = memPool_Strdup(src->certFile);
+  dst->keyFile = memPool_Strdup(src->keyFile);
+  dst->keyPassword = memPool_Strdup(src->keyPassword);
+  dst->ciphers = memPool_Strdup(src->ciphers);
+  dst->pskIdentity = memPool_Strdup(src->pskIdentity);
+  dst->pskKey = memPool_Strdup(src->pskKey);
+}
+
+void mqttTls_FreeConfig(mqttTlsConfig_t *config) {
+  memPool_Free(config->caFile);
+  memPool_Free(config->caPath);
+  memPool_Free(config->certFile);
+  memPool_Free(config->keyFile);
+  memPool_Free(config->keyPassword);
+  memPool_Free(config->ciphers);
+  memPool_Free(config->pskIdentity);
+  memPool_Free(config->pskKey);
+  memset(config, 0, sizeof(mqttTlsConfig_t));
+}
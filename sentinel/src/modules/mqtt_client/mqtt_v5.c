@@ -0,0 +1,107 @@
+#include "modules/mqtt_v5.h"
+#include "modules/mem_pool.h"
+#include <stdio.h>
+#include <string.h>
+
+/* MQTT 5 属性标识符的编码长度均为1字节 */
+#define PROPERTY_ID_BYTES 1
+
+int mqttV5_AliasInit(mqttTopicAliasTable_t *table, int capacity,
+                     int topicCap) {
+  memset(table, 0, sizeof(mqttTopicAliasTable_t));
+  if (capacity <= 0) {
+    return 0;
+  }
+  if (capacity > MQTT_TOPIC_ALIAS_MAX || topicCap <= 0) {
+    return -1;
+  }
+
+  table->topics = (char *)memPool_Alloc((size_t)capacity * topicCap);
+  if (!table->topics) {
+    return -1;
+  }
+  table->capacity = capacity;
+  table->topicCap = topicCap;
+  return 0;
+}
+
+void mqttV5_AliasFree(mqttTopicAliasTable_t *table) {
+  memPool_Free(table->topics);
+  memset(table, 0, sizeof(mqttTopicAliasTable_t));
+}
+
+void mqttV5_AliasReset(mqttTopicAliasTable_t *table, int brokerMax) {
+  table->max = brokerMax < table->capacity ? brokerMax : table->capacity;
+  if (table->max < 0) {
+    table->max = 0;
+  }
+  table->count = 0;
+}
+
+/*
+ * @brief 查找或分配别名。Topic数量很少（状态、传感器、响应等），线性查找即可；
+ *        别名用完后新的Topic按完整Topic发送
+ * */
+int mqttV5_AliasLookup(mqttTopicAliasTable_t *table, const char *topic,
+                       bool *established) {
+  *established = false;
+  if (table->max == 0) {
+    return 0;
+  }
+
+  for (int i = 0; i < table->count; i++) {
+    if (strcmp(table->topics + i * table->topicCap, topic) == 0) {
+      *established = true;
+      return i + 1;
+    }
+  }
+
+  if (table->count == table->max ||
+      strlen(topic) >= (size_t)table->topicCap) {
+    return 0;
+  }
+  snprintf(table->topics + table->count * table->topicCap, table->topicCap,
+           "%s", topic);
+  return ++table->count;
+}
+
+/* 变长整数（剩余长度、属性长度）的编码字节数 */
+static int varIntBytes(int value) {
+  int bytes = 1;
+  while (value >= 128) {
+    value /= 128;
+    bytes++;
+  }
+  return bytes;
+}
+
+int mqttV5_PropertiesLength(const mqttPublishOptions_t *options, int alias) {
+  int len = 0;
+  if (alias > 0) {
+    len += PROPERTY_ID_BYTES + 2;
+  }
+  if (!options) {
+    return len;
+  }
+
+  if (options->messageExpirySec > 0) {
+    len += PROPERTY_ID_BYTES + 4;
+  }
+  if (options->contentType) {
+    len += PROPERTY_ID_BYTES + 2 + strlen(options->contentType);
+  }
+  for (int i = 0; i < options->userPropertyCount; i++) {
+    len += PROPERTY_ID_BYTES + 2 + strlen(options->userProperties[i].name) +
+           2 + strlen(options->userProperties[i].value);
+  }
+  return len;
+}
+
+int mqttV5_PublishPacketSize(int mqttVersion, int topicLen, int payloadLen,
+                             int qos, int propertiesLen) {
+  int remaining = 2 + topicLen + (qos > 0 ? 2 : 0) + payloadLen;
+  if (mqttVersion >= 5) {
+    remaining += varIntBytes(propertiesLen) + propertiesLen;
+  }
+  return 1 + varIntBytes(remaining) + remaining;
+}
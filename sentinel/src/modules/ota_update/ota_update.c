@@ -0,0 +1,461 @@
+#include "modules/ota_update.h"
+#include "modules/mem_pool.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define OTA_STATE_MAGIC 0x41544f53 // "SOTA"
+#define OTA_STATE_VERSION 1
+
+/* 续传状态文件的内容，sha 为 committed 处的中间状态 */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  int32_t state;
+  uint32_t sessionId;
+  uint32_t chunkSize;
+  uint64_t size;
+  uint64_t committed;
+  uint8_t digest[SHA256_DIGEST_LEN];
+  sha256_t sha;
+} otaPersist_t;
+
+static int64_t monotonicMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void setError(otaUpdate_t *ota, const char *message) {
+  ota->status.state = OTA_STATE_FAILED;
+  snprintf(ota->status.error, sizeof(ota->status.error), "%s", message);
+  fprintf(stderr, "OTA failed: %s.\n", message);
+}
+
+/*
+ * @brief 原子地保存续传状态：写临时文件、同步后重命名
+ * */
+static int persistState(otaUpdate_t *ota) {
+  if (ota->config.stateFile[0] == '\0') {
+    return 0;
+  }
+
+  otaPersist_t record = {
+      .magic = OTA_STATE_MAGIC,
+      .version = OTA_STATE_VERSION,
+      .state = ota->status.state,
+      .sessionId = ota->status.sessionId,
+      .chunkSize = ota->status.chunkSize,
+      .size = ota->status.size,
+      .committed = ota->status.committed,
+      .sha = ota->sha,
+  };
+  memcpy(record.digest, ota->digest, sizeof(record.digest));
+
+  char tmpPath[sizeof(ota->config.stateFile) + 8];
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", ota->config.stateFile);
+  int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    perror("Error opening OTA state file");
+    return -1;
+  }
+  int rc = write(fd, &record, sizeof(record)) == sizeof(record) &&
+                   fsync(fd) == 0
+               ? 0
+               : -1;
+  close(fd);
+  if (rc != 0 || rename(tmpPath, ota->config.stateFile) != 0) {
+    perror("Error saving OTA state");
+    unlink(tmpPath);
+    return -1;
+  }
+  return 0;
+}
+
+/* 每次写入整个缓冲，分片必须能整除缓冲，且按扇区对齐 */
+static bool chunkSizeFits(const otaConfig_t *config, uint32_t chunkSize) {
+  return chunkSize > 0 && chunkSize <= config->maxChunkBytes &&
+         chunkSize % OTA_WRITE_ALIGN == 0 &&
+         config->bufferBytes % chunkSize == 0;
+}
+
+static int loadState(otaUpdate_t *ota, otaPersist_t *record) {
+  if (ota->config.stateFile[0] == '\0') {
+    return -1;
+  }
+  int fd = open(ota->config.stateFile, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  ssize_t n = read(fd, record, sizeof(otaPersist_t));
+  close(fd);
+  if (n != sizeof(otaPersist_t) || record->magic != OTA_STATE_MAGIC ||
+      record->version != OTA_STATE_VERSION || record->chunkSize == 0 ||
+      record->committed > record->size) {
+    fprintf(stderr, "Ignoring invalid OTA state file %s.\n",
+            ota->config.stateFile);
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ * @brief 打开写入目标。镜像文件截断到镜像大小，块设备检查容量
+ * */
+static int openTarget(otaUpdate_t *ota) {
+  if (ota->fd >= 0) {
+    return 0;
+  }
+
+  ota->fd = open(ota->config.target, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+  if (ota->fd < 0) {
+    perror("Error opening OTA target");
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(ota->fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    if (ftruncate(ota->fd, (off_t)ota->status.size) != 0) {
+      perror("Error resizing OTA image");
+    }
+    return 0;
+  }
+  off_t capacity = lseek(ota->fd, 0, SEEK_END);
+  if (capacity >= 0 && (uint64_t)capacity < ota->status.size) {
+    fprintf(stderr, "OTA target %s too small: %lld < %llu bytes.\n",
+            ota->config.target, (long long)capacity,
+            (unsigned long long)ota->status.size);
+    close(ota->fd);
+    ota->fd = -1;
+    return -1;
+  }
+  return 0;
+}
+
+static void closeTarget(otaUpdate_t *ota) {
+  if (ota->fd >= 0) {
+    close(ota->fd);
+    ota->fd = -1;
+  }
+}
+
+/*
+ * @brief 把写缓冲整块写入 committed 处并同步，随后丢弃对应的页缓存，
+ *        避免几十MB的镜像在内存中积累脏页；最后持久化续传状态
+ * */
+static int flushBuffer(otaUpdate_t *ota) {
+  if (ota->buffered == 0) {
+    return 0;
+  }
+
+  off_t offset = (off_t)ota->status.committed;
+  uint32_t done = 0;
+  while (done < ota->buffered) {
+    ssize_t n = pwrite(ota->fd, ota->buffer + done, ota->buffered - done,
+                       offset + done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      perror("Error writing OTA image");
+      return -1;
+    }
+    done += (uint32_t)n;
+  }
+  if (fdatasync(ota->fd) != 0) {
+    perror("Error syncing OTA image");
+    return -1;
+  }
+  posix_fadvise(ota->fd, offset, ota->buffered, POSIX_FADV_DONTNEED);
+
+  ota->status.committed += ota->buffered;
+  ota->status.writes++;
+  ota->buffered = 0;
+  return persistState(ota);
+}
+
+static void updateRate(otaUpdate_t *ota) {
+  int64_t elapsed = monotonicMs() - ota->runStartMs;
+  if (elapsed > 0) {
+    ota->status.bytesPerSec =
+        (uint32_t)((ota->status.received - ota->runStartOffset) * 1000 /
+                   (uint64_t)elapsed);
+  }
+}
+
+/* 开始（或继续）本次传输的计时 */
+static void startRun(otaUpdate_t *ota) {
+  ota->runStartMs = monotonicMs();
+  ota->runStartOffset = ota->status.received;
+  ota->reportedPercent =
+      ota->status.size ? (int)(ota->status.received * 100 / ota->status.size)
+                       : 0;
+  ota->reportedGapSeq = UINT32_MAX;
+}
+
+int otaUpdate_Init(otaUpdate_t *ota, const otaConfig_t *config,
+                   otaProgressCallback_t callback, void *userData) {
+  if (!ota || !config || config->target[0] == '\0' ||
+      config->bufferBytes == 0 || config->bufferBytes % OTA_WRITE_ALIGN != 0) {
+    return -1;
+  }
+
+  memset(ota, 0, sizeof(otaUpdate_t));
+  ota->config = *config;
+  if (ota->config.progressStepPercent <= 0) {
+    ota->config.progressStepPercent = 5;
+  }
+  ota->fd = -1;
+  ota->progressCb = callback;
+  ota->progressUserData = userData;
+  pthread_mutex_init(&ota->lock, NULL);
+
+  ota->buffer = (uint8_t *)memPool_Alloc(config->bufferBytes);
+  if (!ota->buffer) {
+    return -1;
+  }
+
+  otaPersist_t record;
+  if (loadState(ota, &record) != 0) {
+    return 0;
+  }
+  ota->status.state = (otaState_t)record.state;
+  ota->status.sessionId = record.sessionId;
+  ota->status.chunkSize = record.chunkSize;
+  ota->status.size = record.size;
+  memcpy(ota->digest, record.digest, sizeof(ota->digest));
+
+  // 重启前后写缓冲或分片上限可能改变（配置修改、静态内存模式下收紧），
+  // 旧的分片大小不再适用时放弃续传，发送端重新 start 后从0开始
+  if (ota->status.state == OTA_STATE_DOWNLOADING &&
+      (!chunkSizeFits(&ota->config, record.chunkSize) ||
+       record.committed % record.chunkSize != 0)) {
+    setError(ota, "chunk size no longer fits buffer");
+    persistState(ota);
+    return 0;
+  }
+  ota->status.committed = record.committed;
+  ota->status.received = record.committed;
+  ota->status.nextSeq = (uint32_t)(record.committed / record.chunkSize);
+  ota->sha = record.sha;
+
+  // 未完成的下载：重新打开目标，分片可以直接从 nextSeq 继续
+  if (ota->status.state == OTA_STATE_DOWNLOADING) {
+    ota->status.resumed = true;
+    startRun(ota);
+    if (openTarget(ota) != 0) {
+      setError(ota, "cannot open target");
+    }
+    fprintf(stdout, "OTA session %u resumable at %llu/%llu bytes.\n",
+            ota->status.sessionId,
+            (unsigned long long)ota->status.committed,
+            (unsigned long long)ota->status.size);
+  }
+  return 0;
+}
+
+int otaUpdate_Begin(otaUpdate_t *ota, uint32_t sessionId, uint64_t size,
+                    uint32_t chunkSize,
+                    const uint8_t digest[SHA256_DIGEST_LEN]) {
+  if (!ota || size == 0 || !chunkSizeFits(&ota->config, chunkSize)) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&ota->lock);
+  otaStatus_t *status = &ota->status;
+  bool same = status->sessionId == sessionId && status->size == size &&
+              status->chunkSize == chunkSize &&
+              memcmp(ota->digest, digest, SHA256_DIGEST_LEN) == 0;
+  if (same && (status->state == OTA_STATE_DOWNLOADING ||
+               status->state == OTA_STATE_VERIFIED)) {
+    // 同一镜像：继续下载，或已经校验通过
+    int rc = 0;
+    if (status->state == OTA_STATE_DOWNLOADING) {
+      status->resumed = status->received > 0;
+      startRun(ota);
+      if (openTarget(ota) != 0) {
+        setError(ota, "cannot open target");
+        rc = -1;
+      }
+    }
+    pthread_mutex_unlock(&ota->lock);
+    return rc;
+  }
+
+  closeTarget(ota);
+  memset(status, 0, sizeof(otaStatus_t));
+  status->state = OTA_STATE_DOWNLOADING;
+  status->sessionId = sessionId;
+  status->size = size;
+  status->chunkSize = chunkSize;
+  memcpy(ota->digest, digest, SHA256_DIGEST_LEN);
+  sha256_Init(&ota->sha);
+  ota->buffered = 0;
+  startRun(ota);
+
+  int rc = 0;
+  if (openTarget(ota) != 0) {
+    setError(ota, "cannot open target");
+    rc = -1;
+  }
+  persistState(ota);
+  pthread_mutex_unlock(&ota->lock);
+  return rc;
+}
+
+/*
+ * @brief 接收一个分片：按序号去重和检查连续性，追加到写缓冲并更新摘要，
+ *        缓冲写满或接收完毕时写入目标；接收完毕后比较SHA-256
+ * */
+int otaUpdate_WriteChunk(otaUpdate_t *ota, const void *data, int len) {
+  if (!ota || !data || len < OTA_CHUNK_HEADER) {
+    return -1;
+  }
+
+  const uint8_t *p = (const uint8_t *)data;
+  uint32_t sessionId = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |
+                       (uint32_t)p[2] << 8 | p[3];
+  uint32_t seq = (uint32_t)p[4] << 24 | (uint32_t)p[5] << 16 |
+                 (uint32_t)p[6] << 8 | p[7];
+  const uint8_t *chunk = p + OTA_CHUNK_HEADER;
+  uint32_t chunkLen = (uint32_t)(len - OTA_CHUNK_HEADER);
+
+  pthread_mutex_lock(&ota->lock);
+  otaStatus_t *status = &ota->status;
+  if (status->state != OTA_STATE_DOWNLOADING ||
+      sessionId != status->sessionId) {
+    pthread_mutex_unlock(&ota->lock);
+    return -1;
+  }
+
+  // 重连后Broker重发、或多个Broker各投递一次的分片
+  if (seq < status->nextSeq) {
+    status->duplicates++;
+    pthread_mutex_unlock(&ota->lock);
+    return 0;
+  }
+
+  bool report = false;
+  int rc = 0;
+  uint64_t remaining = status->size - status->received;
+  uint32_t expected =
+      remaining < status->chunkSize ? (uint32_t)remaining : status->chunkSize;
+  if (seq > status->nextSeq) {
+    // 每个缺口只上报一次，发送端据 next_seq 重发
+    status->gaps++;
+    report = ota->reportedGapSeq != status->nextSeq;
+    ota->reportedGapSeq = status->nextSeq;
+    rc = -1;
+  } else if (chunkLen != expected) {
+    setError(ota, "bad chunk length");
+    report = true;
+    rc = -1;
+  } else {
+    memcpy(ota->buffer + ota->buffered, chunk, chunkLen);
+    ota->buffered += chunkLen;
+    sha256_Update(&ota->sha, chunk, chunkLen);
+    status->received += chunkLen;
+    status->nextSeq++;
+
+    bool complete = status->received == status->size;
+    if ((ota->buffered == ota->config.bufferBytes || complete) &&
+        flushBuffer(ota) != 0) {
+      setError(ota, "write failed");
+      report = true;
+      rc = -1;
+    } else if (complete) {
+      uint8_t digest[SHA256_DIGEST_LEN];
+      sha256_t sha = ota->sha;
+      sha256_Final(&sha, digest);
+      if (memcmp(digest, ota->digest, SHA256_DIGEST_LEN) == 0) {
+        status->state = OTA_STATE_VERIFIED;
+        fprintf(stdout, "OTA session %u verified (%llu bytes).\n",
+                status->sessionId, (unsigned long long)status->size);
+      } else {
+        setError(ota, "sha256 mismatch");
+        rc = -1;
+      }
+      closeTarget(ota);
+      persistState(ota);
+      report = true;
+    } else {
+      int percent = (int)(status->received * 100 / status->size);
+      if (percent >= ota->reportedPercent + ota->config.progressStepPercent) {
+        ota->reportedPercent = percent;
+        report = true;
+      }
+    }
+  }
+
+  updateRate(ota);
+  otaStatus_t snapshot = *status;
+  pthread_mutex_unlock(&ota->lock);
+
+  if (report && ota->progressCb) {
+    ota->progressCb(&snapshot, ota->progressUserData);
+  }
+  return rc;
+}
+
+void otaUpdate_Abort(otaUpdate_t *ota) {
+  pthread_mutex_lock(&ota->lock);
+  closeTarget(ota);
+  memset(&ota->status, 0, sizeof(otaStatus_t));
+  memset(ota->digest, 0, sizeof(ota->digest));
+  ota->buffered = 0;
+  if (ota->config.stateFile[0] != '\0') {
+    unlink(ota->config.stateFile);
+  }
+  pthread_mutex_unlock(&ota->lock);
+}
+
+int otaUpdate_Apply(otaUpdate_t *ota) {
+  pthread_mutex_lock(&ota->lock);
+  bool verified = ota->status.state == OTA_STATE_VERIFIED;
+  pthread_mutex_unlock(&ota->lock);
+  if (!verified || ota->config.applyCommand[0] == '\0') {
+    return -1;
+  }
+
+  fprintf(stdout, "Applying OTA image: %s\n", ota->config.applyCommand);
+  int rc = system(ota->config.applyCommand);
+  return rc == -1 ? -1 : WEXITSTATUS(rc);
+}
+
+void otaUpdate_GetStatus(otaUpdate_t *ota, otaStatus_t *status) {
+  pthread_mutex_lock(&ota->lock);
+  *status = ota->status;
+  pthread_mutex_unlock(&ota->lock);
+}
+
+const char *otaUpdate_StateName(otaState_t state) {
+  switch (state) {
+  case OTA_STATE_DOWNLOADING:
+    return "downloading";
+  case OTA_STATE_VERIFIED:
+    return "verified";
+  case OTA_STATE_FAILED:
+    return "failed";
+  default:
+    return "idle";
+  }
+}
+
+void otaUpdate_Deinit(otaUpdate_t *ota) {
+  pthread_mutex_lock(&ota->lock);
+  if (ota->status.state == OTA_STATE_DOWNLOADING && ota->fd >= 0) {
+    flushBuffer(ota);
+  }
+  closeTarget(ota);
+  // 只改内存中的状态，之后到达的分片被忽略，续传状态文件保持不变
+  ota->status.state = OTA_STATE_IDLE;
+  pthread_mutex_unlock(&ota->lock);
+  memPool_Free(ota->buffer);
+  ota->buffer = NULL;
+}
@@ -0,0 +1,310 @@
+#include "modules/payload_codec.h"
+#include "modules/mem_pool.h"
+#include <stdio.h>
+#include <string.h>
+
+#define HASH_SIZE (1u << PAYLOAD_CODEC_HASH_BITS)
+#define MIN_MATCH 4
+#define MAX_OFFSET 65535
+
+/*
+ * 预置字典：由 docs/协议规范.md 中的载荷格式和网关实际发出的载荷模板组成。
+ * 越常用的片段放在越靠后的位置（离载荷更近）。修改字典内容必须同时修改
+ * PAYLOAD_CODEC_DICT_ID，否则旧版本的解压端将无法解码。
+ * */
+static const char g_dictionary[] =
+    "{\"command_id\":\"\",\"status\":\"success\",\"message\":\"\","
+    "\"error_code\":0,\"result_data\":{}}"
+    "{\"status\":\"offline\",\"timestamp_ms\":"
+    "{\"status\":\"online\",\"timestamp_ms\":"
+    "{\"timestamp_ms\":1701388800567,\"temperature_c\":,\"humidity_percent\":"
+    ",\"sensor_id\":\"dht11_01\"}"
+    "{\"timestamp_ms\":1701388800567,\"light_lux\":,\"infrared_cd\":,"
+    "\"sensor_id\":\"ap3216c_01\"}"
+    "{\"timestamp_ms\":1701388800123,\"cpu_temp_c\":,\"mem_usage_percent\":,"
+    "\"uptime_seconds\":,\"network_rx_kbps\":,\"network_tx_kbps\":}"
+    "[{\"timestamp_ms\": 17"
+    "{\"timestamp_ms\": 17,\"light_lux\": ,\"infrared_cd\": , \"sensor_id\": "
+    "\"light_sensor\"}"
+    "{\"timestamp_ms\": 17,\"cpu_temp_c\": ,\"cpu_load\": ,"
+    "\"mem_usage_percent\": ,\"peak_rss_kb\": }";
+
+#define DICT_LEN (sizeof(g_dictionary) - 1)
+
+static inline uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint32_t hash32(uint32_t v) {
+  return (v * 2654435761u) >> (32 - PAYLOAD_CODEC_HASH_BITS);
+}
+
+const char *payloadCodec_GetDictionary(size_t *len) {
+  if (len) {
+    *len = DICT_LEN;
+  }
+  return g_dictionary;
+}
+
+/*
+ * @brief 初始化压缩器：分配工作区并预先计算字典的哈希表
+ *
+ * @param codec: 压缩器上下文
+ *        config: 压缩配置
+ *
+ * @return 0 成功
+ * */
+int payloadCodec_Init(payloadCodec_t *codec,
+                      const payloadCodecConfig_t *config) {
+  if (!codec || !config || config->maxPayloadBytes <= 0) {
+    return -1;
+  }
+
+  memset(codec, 0, sizeof(payloadCodec_t));
+  codec->config = *config;
+  codec->workCap = DICT_LEN + config->maxPayloadBytes;
+  codec->work = (uint8_t *)memPool_Alloc(codec->workCap);
+  codec->dictTable = (uint32_t *)memPool_Alloc(HASH_SIZE * sizeof(uint32_t));
+  codec->table = (uint32_t *)memPool_Alloc(HASH_SIZE * sizeof(uint32_t));
+  if (!codec->work || !codec->dictTable || !codec->table) {
+    fprintf(stderr, "Failed to allocate payload codec workspace.\n");
+    return -1;
+  }
+
+  // 字典位置以 +1 存储，0 表示空槽
+  memset(codec->dictTable, 0, HASH_SIZE * sizeof(uint32_t));
+  memcpy(codec->work, g_dictionary, DICT_LEN);
+  for (size_t i = 0; i + MIN_MATCH <= DICT_LEN; i++) {
+    codec->dictTable[hash32(read32(codec->work + i))] = (uint32_t)i + 1;
+  }
+
+  pthread_mutex_init(&codec->lock, NULL);
+  return 0;
+}
+
+bool payloadCodec_TopicEnabled(const payloadCodec_t *codec, const char *topic) {
+  if (!codec || !codec->config.enabled || !topic) {
+    return false;
+  }
+
+  const char *name = strrchr(topic, '/');
+  name = name ? name + 1 : topic;
+  for (int i = 0; i < codec->config.topicCount; i++) {
+    if (strcmp(codec->config.topics[i], name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool payloadCodec_IsCompressed(const void *payload, int payloadLen) {
+  const uint8_t *p = (const uint8_t *)payload;
+  return payloadLen >= 3 && p[0] == PAYLOAD_CODEC_MAGIC &&
+         p[1] == PAYLOAD_CODEC_DICT_ID;
+}
+
+/* 写入扩展长度（每字节255累加，最后一个字节小于255） */
+static uint8_t *writeLength(uint8_t *op, size_t len) {
+  while (len >= 255) {
+    *op++ = 255;
+    len -= 255;
+  }
+  *op++ = (uint8_t)len;
+  return op;
+}
+
+/* 输出一个序列，match为0表示最后一个只有字面量的序列 */
+static uint8_t *writeSequence(uint8_t *op, const uint8_t *literals,
+                              size_t litLen, size_t offset, size_t matchLen) {
+  uint8_t *token = op++;
+  size_t matchCode = matchLen ? matchLen - MIN_MATCH : 0;
+
+  *token = (uint8_t)(((litLen >= 15 ? 15 : litLen) << 4) |
+                     (matchCode >= 15 ? 15 : matchCode));
+  if (litLen >= 15) {
+    op = writeLength(op, litLen - 15);
+  }
+  memcpy(op, literals, litLen);
+  op += litLen;
+
+  if (matchLen) {
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+    if (matchCode >= 15) {
+      op = writeLength(op, matchCode - 15);
+    }
+  }
+  return op;
+}
+
+/*
+ * @brief 压缩载荷。字典和载荷拼接在工作区中，匹配可以引用字典内容。
+ *
+ * @param codec: 压缩器上下文
+ *        src/srcLen: 原始载荷
+ *        dst/dstCap: 输出缓冲区，容量至少为 PAYLOAD_CODEC_BOUND(srcLen)
+ *
+ * @return int: 压缩后长度，失败或无收益时返回-1
+ * */
+int payloadCodec_Compress(payloadCodec_t *codec, const char *src, int srcLen,
+                          uint8_t *dst, int dstCap) {
+  if (!codec || !codec->work || !src || srcLen <= 0 ||
+      srcLen > codec->config.maxPayloadBytes ||
+      dstCap < PAYLOAD_CODEC_BOUND(srcLen)) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&codec->lock);
+
+  uint8_t *work = codec->work;
+  uint32_t *table = codec->table;
+  size_t total = DICT_LEN + (size_t)srcLen;
+  memcpy(work + DICT_LEN, src, srcLen);
+  memcpy(table, codec->dictTable, HASH_SIZE * sizeof(uint32_t));
+
+  // 帧头
+  uint8_t *op = dst;
+  *op++ = PAYLOAD_CODEC_MAGIC;
+  *op++ = PAYLOAD_CODEC_DICT_ID;
+  uint32_t rawLen = (uint32_t)srcLen;
+  while (rawLen >= 0x80) {
+    *op++ = (uint8_t)(rawLen | 0x80);
+    rawLen >>= 7;
+  }
+  *op++ = (uint8_t)rawLen;
+
+  size_t ip = DICT_LEN;
+  size_t anchor = DICT_LEN;
+  while (ip + MIN_MATCH <= total) {
+    uint32_t seq = read32(work + ip);
+    uint32_t h = hash32(seq);
+    size_t ref = table[h];
+    table[h] = (uint32_t)ip + 1;
+
+    if (ref == 0 || ip - (ref - 1) > MAX_OFFSET || read32(work + ref - 1) != seq) {
+      ip++;
+      continue;
+    }
+
+    size_t matchPos = ref - 1;
+    size_t matchLen = MIN_MATCH;
+    while (ip + matchLen < total && work[matchPos + matchLen] == work[ip + matchLen]) {
+      matchLen++;
+    }
+
+    op = writeSequence(op, work + anchor, ip - anchor, ip - matchPos, matchLen);
+
+    // 匹配末尾的位置也加入哈希表，提高下一次匹配的命中率
+    if (ip + matchLen - 2 + MIN_MATCH <= total) {
+      table[hash32(read32(work + ip + matchLen - 2))] =
+          (uint32_t)(ip + matchLen - 2) + 1;
+    }
+    ip += matchLen;
+    anchor = ip;
+  }
+  op = writeSequence(op, work + anchor, total - anchor, 0, 0);
+
+  int packedLen = (int)(op - dst);
+  if (packedLen < srcLen) {
+    codec->rawBytes += srcLen;
+    codec->packedBytes += packedLen;
+  }
+  pthread_mutex_unlock(&codec->lock);
+
+  return packedLen < srcLen ? packedLen : -1;
+}
+
+/* 读取扩展长度 */
+static int readLength(const uint8_t **ip, const uint8_t *end, size_t *len) {
+  uint8_t b;
+  do {
+    if (*ip >= end) {
+      return -1;
+    }
+    b = *(*ip)++;
+    *len += b;
+  } while (b == 255);
+  return 0;
+}
+
+/*
+ * @brief 解压缩载荷
+ *
+ * @param src/srcLen: 压缩帧
+ *        dst/dstCap: 输出缓冲区（输出不包含字符串结束符）
+ *
+ * @return int: 原始长度，格式错误或缓冲区不足返回-1
+ * */
+int payloadCodec_Decompress(const uint8_t *src, int srcLen, char *dst,
+                            int dstCap) {
+  if (!payloadCodec_IsCompressed(src, srcLen) || !dst) {
+    return -1;
+  }
+
+  const uint8_t *ip = src + 2;
+  const uint8_t *end = src + srcLen;
+  size_t rawLen = 0;
+  int shift = 0;
+  while (1) {
+    if (ip >= end || shift > 28) {
+      return -1;
+    }
+    uint8_t b = *ip++;
+    rawLen |= (size_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      break;
+    }
+    shift += 7;
+  }
+  if (rawLen > (size_t)dstCap) {
+    return -1;
+  }
+
+  size_t outPos = 0;
+  while (ip < end) {
+    uint8_t token = *ip++;
+
+    size_t litLen = token >> 4;
+    if (litLen == 15 && readLength(&ip, end, &litLen) != 0) {
+      return -1;
+    }
+    if ((size_t)(end - ip) < litLen || outPos + litLen > rawLen) {
+      return -1;
+    }
+    memcpy(dst + outPos, ip, litLen);
+    ip += litLen;
+    outPos += litLen;
+
+    if (ip == end) {
+      break; // 最后一个序列只有字面量
+    }
+
+    if (end - ip < 2) {
+      return -1;
+    }
+    size_t offset = ip[0] | ((size_t)ip[1] << 8);
+    ip += 2;
+    size_t matchLen = token & 0x0F;
+    if (matchLen == 15 && readLength(&ip, end, &matchLen) != 0) {
+      return -1;
+    }
+    matchLen += MIN_MATCH;
+
+    if (offset == 0 || offset > outPos + DICT_LEN ||
+        outPos + matchLen > rawLen) {
+      return -1;
+    }
+
+    // 逐字节复制：匹配源可能从字典跨入输出，也可能与输出重叠
+    for (size_t i = 0; i < matchLen; i++) {
+      size_t virtPos = DICT_LEN + outPos - offset; // 字典+输出的虚拟位置
+      dst[outPos] = virtPos < DICT_LEN ? g_dictionary[virtPos]
+                                        : dst[virtPos - DICT_LEN];
+      outPos++;
+    }
+  }
+
+  return outPos == rawLen ? (int)rawLen : -1;
+}
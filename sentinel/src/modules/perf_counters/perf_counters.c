@@ -0,0 +1,299 @@
+#include "modules/perf_counters.h"
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/* 线程的计数器组 */
+typedef struct {
+  int opened; // 0 未打开，1 已尝试打开（可能全部失败）
+  int fds[PERF_EVENT_COUNT];
+  int index[PERF_EVENT_COUNT]; // 事件在组读取结果中的位置，-1 表示不可用
+  int leader;
+  int count;
+} perfThread_t;
+
+/* PERF_FORMAT_GROUP 的读取格式 */
+typedef struct {
+  uint64_t nr;
+  uint64_t enabledNs;
+  uint64_t runningNs;
+  uint64_t values[PERF_EVENT_COUNT];
+} perfGroupRead_t;
+
+static const struct {
+  const char *name;
+  uint32_t type;
+  uint64_t config;
+} g_events[PERF_EVENT_COUNT] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"context_switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
+
+static int g_enabled = 0;
+static perfStage_t *g_stages = NULL; // 只增不减，读者无需加锁
+static uint32_t g_available = 0;
+static int g_openErrno = 0;
+static int g_warned = 0;
+
+static __thread perfThread_t t_perf;
+static pthread_key_t g_threadKey;
+static pthread_once_t g_keyOnce = PTHREAD_ONCE_INIT;
+
+static uint64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* 线程退出时关闭计数器（采样线程会被看门狗重建） */
+static void closeThreadCounters(void *arg) {
+  perfThread_t *perf = (perfThread_t *)arg;
+  for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+    if (perf->fds[i] >= 0) {
+      close(perf->fds[i]);
+      perf->fds[i] = -1;
+    }
+  }
+}
+
+static void createThreadKey(void) {
+  pthread_key_create(&g_threadKey, closeThreadCounters);
+}
+
+static int openEvent(perfEvent_t event, int leader, bool kernel) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = g_events[event].type;
+  attr.config = g_events[event].config;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.exclude_kernel = kernel ? 0 : 1;
+  attr.exclude_hv = 1;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader,
+                      PERF_FLAG_FD_CLOEXEC);
+}
+
+/*
+ * @brief 为当前线程打开计数器组，第一个打开成功的事件作为组长。
+ *        上下文切换发生在内核态，需要统计内核态才有计数，
+ *        perf_event_paranoid 不允许时改用 getrusage
+ * */
+static void openThreadCounters(perfThread_t *perf) {
+  perf->opened = 1;
+  perf->leader = -1;
+  perf->count = 0;
+  int firstErrno = 0;
+  uint32_t available = 0;
+
+  for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+    perf->index[i] = -1;
+    perf->fds[i] = openEvent((perfEvent_t)i, perf->leader,
+                             i == PERF_EVENT_CONTEXT_SWITCHES);
+    if (perf->fds[i] < 0) {
+      if (firstErrno == 0 && i != PERF_EVENT_CONTEXT_SWITCHES) {
+        firstErrno = errno;
+      }
+      continue;
+    }
+    if (perf->leader < 0) {
+      perf->leader = perf->fds[i];
+    }
+    perf->index[i] = perf->count++;
+    available |= 1u << i;
+  }
+  // getrusage 总是可用
+  available |= 1u << PERF_EVENT_CONTEXT_SWITCHES;
+
+  __atomic_store_n(&g_available, available, __ATOMIC_RELAXED);
+  __atomic_store_n(&g_openErrno, firstErrno, __ATOMIC_RELAXED);
+  // 每个线程都会打开一次，只提示一次
+  if (firstErrno != 0 && !__atomic_exchange_n(&g_warned, 1, __ATOMIC_RELAXED)) {
+    fprintf(stderr, "Some perf counters unavailable: %s\n",
+            strerror(firstErrno));
+  }
+
+  pthread_once(&g_keyOnce, createThreadKey);
+  pthread_setspecific(g_threadKey, perf);
+}
+
+static uint64_t threadContextSwitches(void) {
+  struct rusage usage;
+  if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+    return 0;
+  }
+  return (uint64_t)(usage.ru_nvcsw + usage.ru_nivcsw);
+}
+
+/* 读取当前线程的全部计数 */
+static void readCounters(perfSnapshot_t *snapshot) {
+  perfThread_t *perf = &t_perf;
+  snapshot->valid = 0;
+  if (perf->leader >= 0) {
+    perfGroupRead_t group;
+    ssize_t n = read(perf->leader, &group, sizeof(group));
+    if (n >= (ssize_t)(3 * sizeof(uint64_t)) &&
+        group.nr == (uint64_t)perf->count) {
+      snapshot->enabledNs = group.enabledNs;
+      snapshot->runningNs = group.runningNs;
+      for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (perf->index[i] >= 0) {
+          snapshot->values[i] = group.values[perf->index[i]];
+          snapshot->valid |= 1u << i;
+        }
+      }
+    }
+  }
+  if (perf->index[PERF_EVENT_CONTEXT_SWITCHES] < 0) {
+    snapshot->values[PERF_EVENT_CONTEXT_SWITCHES] = threadContextSwitches();
+    snapshot->valid |= 1u << PERF_EVENT_CONTEXT_SWITCHES;
+  }
+  snapshot->wallNs = nowNs();
+}
+
+static void registerStage(perfStage_t *stage) {
+  int expected = 0;
+  if (__atomic_load_n(&stage->registered, __ATOMIC_ACQUIRE) ||
+      !__atomic_compare_exchange_n(&stage->registered, &expected, 1, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  stage->next = __atomic_load_n(&g_stages, __ATOMIC_ACQUIRE);
+  while (!__atomic_compare_exchange_n(&g_stages, &stage->next, stage, true,
+                                      __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+  }
+}
+
+void perfCounters_SetEnabled(bool enabled) {
+  __atomic_store_n(&g_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+bool perfCounters_IsEnabled(void) {
+  return __atomic_load_n(&g_enabled, __ATOMIC_RELAXED) != 0;
+}
+
+void perfCounters_Begin(perfSnapshot_t *snapshot) {
+  snapshot->active = perfCounters_IsEnabled();
+  if (!snapshot->active) {
+    return;
+  }
+  if (!t_perf.opened) {
+    openThreadCounters(&t_perf);
+  }
+  readCounters(snapshot);
+}
+
+/*
+ * @brief 计入一个阶段的增量。计数器组被分时复用时按
+ *        启用时间/计数时间放大，这段时间完全没有计数时硬件事件不计入
+ * */
+void perfCounters_Lap(perfSnapshot_t *snapshot, perfStage_t *stage) {
+  if (!snapshot->active || !perfCounters_IsEnabled()) {
+    return;
+  }
+
+  perfSnapshot_t now;
+  readCounters(&now);
+  registerStage(stage);
+
+  uint64_t wallNs = now.wallNs - snapshot->wallNs;
+  __atomic_add_fetch(&stage->samples, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&stage->wallNs, wallNs, __ATOMIC_RELAXED);
+  uint64_t prev = __atomic_load_n(&stage->maxWallNs, __ATOMIC_RELAXED);
+  while (wallNs > prev &&
+         !__atomic_compare_exchange_n(&stage->maxWallNs, &prev, wallNs, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+
+  uint64_t enabledNs = now.enabledNs - snapshot->enabledNs;
+  uint64_t runningNs = now.runningNs - snapshot->runningNs;
+  uint32_t valid = now.valid & snapshot->valid;
+  for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+    if (!(valid & (1u << i))) {
+      continue;
+    }
+    uint64_t delta = now.values[i] - snapshot->values[i];
+    bool grouped = t_perf.index[i] >= 0;
+    if (grouped && runningNs == 0) {
+      continue;
+    }
+    if (grouped && runningNs < enabledNs) {
+      delta = (uint64_t)((double)delta * enabledNs / runningNs);
+    }
+    __atomic_add_fetch(&stage->counts[i], delta, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stage->counted[i], 1, __ATOMIC_RELAXED);
+  }
+  *snapshot = now;
+  snapshot->active = true;
+}
+
+const char *perfCounters_EventName(perfEvent_t event) {
+  return event < PERF_EVENT_COUNT ? g_events[event].name : "unknown";
+}
+
+void perfCounters_GetStatus(perfCountersStatus_t *status) {
+  status->available = __atomic_load_n(&g_available, __ATOMIC_RELAXED);
+  status->openErrno = __atomic_load_n(&g_openErrno, __ATOMIC_RELAXED);
+  status->paranoid = -100;
+  FILE *fp = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+  if (fp) {
+    if (fscanf(fp, "%d", &status->paranoid) != 1) {
+      status->paranoid = -100;
+    }
+    fclose(fp);
+  }
+}
+
+/*
+ * @brief 输出统计快照。链表按注册的逆序排列，先收集再反转
+ *
+ * @return 输出的个数
+ * */
+int perfCounters_GetStages(perfStageStats_t *out, int max) {
+  int count = 0;
+  for (perfStage_t *stage = __atomic_load_n(&g_stages, __ATOMIC_ACQUIRE);
+       stage && count < max; stage = stage->next) {
+    perfStageStats_t *s = &out[count];
+    s->samples = __atomic_load_n(&stage->samples, __ATOMIC_RELAXED);
+    if (s->samples == 0) {
+      continue;
+    }
+    s->name = stage->name;
+    s->wallNs = __atomic_load_n(&stage->wallNs, __ATOMIC_RELAXED);
+    s->maxWallNs = __atomic_load_n(&stage->maxWallNs, __ATOMIC_RELAXED);
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+      s->counts[i] = __atomic_load_n(&stage->counts[i], __ATOMIC_RELAXED);
+      s->counted[i] = __atomic_load_n(&stage->counted[i], __ATOMIC_RELAXED);
+    }
+    count++;
+  }
+
+  for (int i = 0; i < count / 2; i++) {
+    perfStageStats_t tmp = out[i];
+    out[i] = out[count - 1 - i];
+    out[count - 1 - i] = tmp;
+  }
+  return count;
+}
+
+void perfCounters_Reset(void) {
+  for (perfStage_t *stage = __atomic_load_n(&g_stages, __ATOMIC_ACQUIRE);
+       stage; stage = stage->next) {
+    __atomic_store_n(&stage->samples, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stage->wallNs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stage->maxWallNs, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+      __atomic_store_n(&stage->counts[i], 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&stage->counted[i], 0, __ATOMIC_RELAXED);
+    }
+  }
+}
@@ -0,0 +1,390 @@
+#include "modules/pwm_led.h"
+#include "modules/command_dispatch.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static pwmChannel_t g_channels[PWM_MAX_CHANNELS];
+static int g_channelCount = 0;
+static pthread_mutex_t g_pwmLock = PTHREAD_MUTEX_INITIALIZER;
+static int g_timerFd = -1;
+static bool g_timerArmed = false;
+static uint64_t g_tickNs = 5000000;
+static pwmLatencyStats_t g_latency;
+
+static int64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* 向sysfs属性写入一次字符串（只在初始化阶段使用） */
+static int writeAttr(const char *path, const char *value) {
+  int fd = open(path, O_WRONLY);
+  if (fd < 0) {
+    return -1;
+  }
+  ssize_t n = write(fd, value, strlen(value));
+  close(fd);
+  return n == (ssize_t)strlen(value) ? 0 : -1;
+}
+
+/* 使用pwrite写入已打开的属性，避免每次写入都重新open/lseek */
+static int pwriteValue(int fd, uint32_t value) {
+  char buffer[16];
+  int len = snprintf(buffer, sizeof(buffer), "%u\n", value);
+  return pwrite(fd, buffer, len, 0) == len ? 0 : -1;
+}
+
+/*
+ * @brief 按亮度计算占空比并写入，调用方需持有g_pwmLock
+ * */
+static void applyLevel(pwmChannel_t *ch, float level) {
+  if (level < 0) {
+    level = 0;
+  } else if (level > 100) {
+    level = 100;
+  }
+  ch->level = level;
+
+  uint32_t duty = (uint32_t)((double)ch->config.periodNs * level / 100.0);
+  if (ch->config.inverted) {
+    duty = ch->config.periodNs - duty;
+  }
+  if (duty != ch->lastDutyNs) {
+    if (pwriteValue(ch->dutyFd, duty) != 0) {
+      perror("Error writing PWM duty cycle");
+      return;
+    }
+    ch->lastDutyNs = duty;
+    g_latency.writes++;
+  }
+
+  // 命令到输出生效的延迟（输出已经是目标值时同样计入）
+  if (ch->pendingCmdNs > 0) {
+    uint64_t latency = nowNs() - ch->pendingCmdNs;
+    ch->pendingCmdNs = 0;
+    g_latency.count++;
+    g_latency.totalNs += latency;
+    g_latency.lastNs = latency;
+    if (latency > g_latency.maxNs) {
+      g_latency.maxNs = latency;
+    }
+  }
+}
+
+/* 计算渐变/闪烁通道在某时刻的亮度，返回false表示动作已结束 */
+static bool computeLevel(pwmChannel_t *ch, int64_t now, float *level) {
+  int64_t elapsed = now - ch->startNs;
+
+  if (ch->mode == PWM_MODE_FADE) {
+    if (elapsed >= (int64_t)ch->durationNs) {
+      *level = ch->fadeTo;
+      return false;
+    }
+    *level = ch->fadeFrom +
+             (ch->fadeTo - ch->fadeFrom) * (float)elapsed / ch->durationNs;
+    return true;
+  }
+
+  if (ch->mode == PWM_MODE_BLINK) {
+    uint64_t cycle = elapsed / ch->blinkPeriodNs;
+    if (ch->blinkCount > 0 && cycle >= ch->blinkCount) {
+      *level = 0;
+      return false;
+    }
+    bool on = (elapsed % ch->blinkPeriodNs) < ch->blinkPeriodNs / 2;
+    *level = on ? ch->blinkOn : 0;
+    return true;
+  }
+
+  *level = ch->level;
+  return false;
+}
+
+/* 确保定时器在有活动通道时运行，调用方需持有g_pwmLock */
+static void updateTimer(void) {
+  bool active = false;
+  for (int i = 0; i < g_channelCount; i++) {
+    active |= g_channels[i].mode != PWM_MODE_STATIC;
+  }
+
+  if (active != g_timerArmed && g_timerFd >= 0) {
+    eventLoop_ArmTimer(g_timerFd, active ? g_tickNs : 0, active ? g_tickNs : 0);
+    g_timerArmed = active;
+  }
+}
+
+/* 定时器回调：所有通道共用一个timerfd，不为每个LED创建线程 */
+static void pwmTimerHandle(int fd, uint32_t events, void *userData) {
+  eventLoop_AckTimer(fd);
+
+  pthread_mutex_lock(&g_pwmLock);
+  int64_t now = nowNs();
+  for (int i = 0; i < g_channelCount; i++) {
+    pwmChannel_t *ch = &g_channels[i];
+    if (ch->mode == PWM_MODE_STATIC) {
+      continue;
+    }
+
+    float level;
+    if (!computeLevel(ch, now, &level)) {
+      ch->mode = PWM_MODE_STATIC;
+    }
+    applyLevel(ch, level);
+  }
+  updateTimer();
+  pthread_mutex_unlock(&g_pwmLock);
+}
+
+static pwmChannel_t *findChannel(const char *name) {
+  for (int i = 0; i < g_channelCount; i++) {
+    if (strcmp(g_channels[i].config.name, name) == 0) {
+      return &g_channels[i];
+    }
+  }
+  return NULL;
+}
+
+int pwmLed_Set(const char *name, float level, int64_t cmdNs) {
+  pthread_mutex_lock(&g_pwmLock);
+  pwmChannel_t *ch = findChannel(name);
+  if (ch == NULL) {
+    pthread_mutex_unlock(&g_pwmLock);
+    return -1;
+  }
+
+  ch->mode = PWM_MODE_STATIC;
+  ch->pendingCmdNs = cmdNs;
+  applyLevel(ch, level);
+  updateTimer();
+  pthread_mutex_unlock(&g_pwmLock);
+  return 0;
+}
+
+int pwmLed_Fade(const char *name, float level, uint32_t durationMs,
+                int64_t cmdNs) {
+  if (durationMs == 0) {
+    return pwmLed_Set(name, level, cmdNs);
+  }
+
+  pthread_mutex_lock(&g_pwmLock);
+  pwmChannel_t *ch = findChannel(name);
+  if (ch == NULL) {
+    pthread_mutex_unlock(&g_pwmLock);
+    return -1;
+  }
+
+  // 起点回退一个步长，使第一步在命令处理时立即输出
+  ch->mode = PWM_MODE_FADE;
+  ch->fadeFrom = ch->level;
+  ch->fadeTo = level;
+  ch->durationNs = durationMs * 1000000ULL;
+  ch->startNs = nowNs() - (int64_t)g_tickNs;
+  ch->pendingCmdNs = cmdNs;
+
+  float first;
+  if (!computeLevel(ch, nowNs(), &first)) {
+    ch->mode = PWM_MODE_STATIC;
+  }
+  applyLevel(ch, first);
+  updateTimer();
+  pthread_mutex_unlock(&g_pwmLock);
+  return 0;
+}
+
+int pwmLed_Blink(const char *name, float level, uint32_t periodMs,
+                 uint32_t count, int64_t cmdNs) {
+  if (periodMs == 0) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&g_pwmLock);
+  pwmChannel_t *ch = findChannel(name);
+  if (ch == NULL) {
+    pthread_mutex_unlock(&g_pwmLock);
+    return -1;
+  }
+
+  ch->mode = PWM_MODE_BLINK;
+  ch->blinkOn = level;
+  ch->blinkPeriodNs = periodMs * 1000000ULL;
+  ch->blinkCount = count;
+  ch->startNs = nowNs();
+  ch->pendingCmdNs = cmdNs;
+  applyLevel(ch, level);
+  updateTimer();
+  pthread_mutex_unlock(&g_pwmLock);
+  return 0;
+}
+
+float pwmLed_GetLevel(const char *name) {
+  pthread_mutex_lock(&g_pwmLock);
+  pwmChannel_t *ch = findChannel(name);
+  float level = ch ? ch->level : -1;
+  pthread_mutex_unlock(&g_pwmLock);
+  return level;
+}
+
+void pwmLed_GetLatencyStats(pwmLatencyStats_t *stats) {
+  pthread_mutex_lock(&g_pwmLock);
+  *stats = g_latency;
+  pthread_mutex_unlock(&g_pwmLock);
+}
+
+/*
+ * @brief PWM通道的命令处理：set / fade / blink / get_status
+ *
+ * value: 亮度百分比（0~100）
+ * device_specific_params: duration_ms（fade），period_ms、count（blink）
+ * */
+static int pwmCommandHandle(const sentinelCommand_t *cmd,
+                            sentinelCommandResult_t *result, void *userData) {
+  const char *name = cmd->target;
+  int rc;
+
+  if (strcmp(cmd->action, "get_status") != 0 &&
+      strcmp(cmd->action, "blink") != 0 &&
+      (!cmd->hasValue || cmd->value < 0 || cmd->value > 100)) {
+    snprintf(result->message, sizeof(result->message),
+             "value must be a brightness between 0 and 100");
+    return COMMAND_ERR_INVALID_VALUE;
+  }
+
+  if (strcmp(cmd->action, "set") == 0 ||
+      strcmp(cmd->action, "set_state") == 0) {
+    rc = pwmLed_Set(name, (float)cmd->value, cmd->receivedNs);
+  } else if (strcmp(cmd->action, "fade") == 0) {
+    rc = pwmLed_Fade(name, (float)cmd->value,
+                     (uint32_t)commandDispatch_GetParam(cmd, "duration_ms", 1000),
+                     cmd->receivedNs);
+  } else if (strcmp(cmd->action, "blink") == 0) {
+    rc = pwmLed_Blink(name, cmd->hasValue ? (float)cmd->value : 100,
+                      (uint32_t)commandDispatch_GetParam(cmd, "period_ms", 500),
+                      (uint32_t)commandDispatch_GetParam(cmd, "count", 0),
+                      cmd->receivedNs);
+  } else if (strcmp(cmd->action, "get_status") == 0) {
+    rc = 0;
+  } else {
+    return COMMAND_ERR_UNKNOWN_ACTION;
+  }
+
+  if (rc != 0) {
+    return COMMAND_ERR_EXEC;
+  }
+
+  pwmLatencyStats_t stats;
+  pwmLed_GetLatencyStats(&stats);
+  snprintf(result->resultData, sizeof(result->resultData),
+           "{\"current_level\":%.1f,\"last_latency_us\":%.1f,"
+           "\"avg_latency_us\":%.1f,\"max_latency_us\":%.1f}",
+           pwmLed_GetLevel(name), stats.lastNs / 1000.0,
+           stats.count ? stats.totalNs / 1000.0 / stats.count : 0.0,
+           stats.maxNs / 1000.0);
+  return COMMAND_OK;
+}
+
+/* 打开单个通道：必要时export，设置周期并保持duty_cycle句柄 */
+static int openChannel(const char *root, pwmChannel_t *ch) {
+  char path[256];
+  char value[16];
+
+  snprintf(path, sizeof(path), "%s/pwmchip%d/pwm%d", root, ch->config.chip,
+           ch->config.channel);
+  if (access(path, F_OK) != 0) {
+    char exportPath[256];
+    snprintf(exportPath, sizeof(exportPath), "%s/pwmchip%d/export", root,
+             ch->config.chip);
+    snprintf(value, sizeof(value), "%d", ch->config.channel);
+    if (writeAttr(exportPath, value) != 0) {
+      perror("Error exporting PWM channel");
+      return -1;
+    }
+    // 等待udev为新导出的通道创建属性文件
+    for (int i = 0; i < 50 && access(path, F_OK) != 0; i++) {
+      usleep(2000);
+    }
+  }
+
+  char attr[288];
+  snprintf(attr, sizeof(attr), "%s/period", path);
+  snprintf(value, sizeof(value), "%u", ch->config.periodNs);
+  if (writeAttr(attr, value) != 0) {
+    perror("Error setting PWM period");
+    return -1;
+  }
+
+  snprintf(attr, sizeof(attr), "%s/duty_cycle", path);
+  ch->dutyFd = open(attr, O_WRONLY | O_CLOEXEC);
+  snprintf(attr, sizeof(attr), "%s/enable", path);
+  ch->enableFd = open(attr, O_WRONLY | O_CLOEXEC);
+  if (ch->dutyFd < 0 || ch->enableFd < 0) {
+    perror("Error opening PWM channel attributes");
+    return -1;
+  }
+
+  ch->lastDutyNs = UINT32_MAX;
+  applyLevel(ch, 0);
+  return pwriteValue(ch->enableFd, 1);
+}
+
+/*
+ * @brief 初始化所有PWM通道
+ *
+ * @param config: PWM配置
+ *        loop: 驱动渐变/闪烁定时器的事件循环
+ *
+ * @return 0 成功
+ * */
+int pwmLed_Init(const pwmLedConfig_t *config, eventLoop_t *loop) {
+  if (!config || !loop) {
+    return -1;
+  }
+
+  g_tickNs = (config->tickUs > 0 ? config->tickUs : 5000) * 1000ULL;
+  for (int i = 0; i < config->channelCount && i < PWM_MAX_CHANNELS; i++) {
+    pwmChannel_t *ch = &g_channels[g_channelCount];
+    memset(ch, 0, sizeof(pwmChannel_t));
+    ch->config = config->channels[i];
+    ch->dutyFd = -1;
+    ch->enableFd = -1;
+
+    pthread_mutex_lock(&g_pwmLock);
+    int rc = openChannel(config->sysfsRoot, ch);
+    pthread_mutex_unlock(&g_pwmLock);
+    if (rc != 0) {
+      fprintf(stderr, "PWM channel '%s' unavailable.\n", ch->config.name);
+      if (ch->dutyFd >= 0)
+        close(ch->dutyFd);
+      if (ch->enableFd >= 0)
+        close(ch->enableFd);
+      continue;
+    }
+
+    // 没有命令target的通道无法控制，按不可用处理
+    if (commandDispatch_Register(ch->config.name, pwmCommandHandle, NULL) !=
+        0) {
+      fprintf(stderr, "PWM channel '%s' has no command target.\n",
+              ch->config.name);
+      close(ch->dutyFd);
+      close(ch->enableFd);
+      continue;
+    }
+    g_channelCount++;
+  }
+
+  g_timerFd = eventLoop_AddTimer(loop, pwmTimerHandle, NULL);
+  return g_timerFd >= 0 ? 0 : -1;
+}
+
+void pwmLed_Deinit(void) {
+  pthread_mutex_lock(&g_pwmLock);
+  for (int i = 0; i < g_channelCount; i++) {
+    close(g_channels[i].dutyFd);
+    close(g_channels[i].enableFd);
+  }
+  g_channelCount = 0;
+  pthread_mutex_unlock(&g_pwmLock);
+}
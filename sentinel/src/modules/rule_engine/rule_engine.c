@@ -0,0 +1,345 @@
+#include "modules/rule_engine.h"
+#include "modules/mem_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* 查找或登记字段，返回字段ID */
+static int internField(ruleEngine_t *engine, const char *name) {
+  for (int i = 0; i < engine->fieldCount; i++) {
+    if (strcmp(engine->fieldNames[i], name) == 0) {
+      return i;
+    }
+  }
+  if (engine->fieldCount >= RULE_MAX_FIELDS) {
+    return -1;
+  }
+  snprintf(engine->fieldNames[engine->fieldCount],
+           sizeof(engine->fieldNames[0]), "%s", name);
+  return engine->fieldCount++;
+}
+
+static int parseOp(const char *op) {
+  static const char *ops[] = {"<", "<=", ">", ">=", "==", "!="};
+  for (int i = 0; i < (int)(sizeof(ops) / sizeof(ops[0])); i++) {
+    if (strcmp(op, ops[i]) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* 编译规则动作为命令模板，返回动作下标，未配置返回-1，格式错误返回-2 */
+static int compileAction(ruleEngine_t *engine, const char *ruleName,
+                         const cJSON *action) {
+  if (action == NULL) {
+    return -1;
+  }
+
+  cJSON *target = cJSON_GetObjectItemCaseSensitive(action, "target");
+  cJSON *name = cJSON_GetObjectItemCaseSensitive(action, "action");
+  if (!cJSON_IsString(target) || !cJSON_IsString(name) ||
+      engine->actionCount >= RULE_MAX_ACTIONS) {
+    return -2;
+  }
+
+  sentinelCommand_t *cmd = &engine->actions[engine->actionCount];
+  memset(cmd, 0, sizeof(sentinelCommand_t));
+  snprintf(cmd->commandId, sizeof(cmd->commandId), "rule:%s", ruleName);
+  snprintf(cmd->target, sizeof(cmd->target), "%s", target->valuestring);
+  snprintf(cmd->action, sizeof(cmd->action), "%s", name->valuestring);
+  cmd->source = COMMAND_SOURCE_RULE;
+
+  cJSON *value = cJSON_GetObjectItemCaseSensitive(action, "value");
+  if (cJSON_IsNumber(value)) {
+    cmd->hasValue = true;
+    cmd->value = value->valuedouble;
+  } else if (cJSON_IsString(value)) {
+    snprintf(cmd->valueStr, sizeof(cmd->valueStr), "%s", value->valuestring);
+  }
+
+  cJSON *param = NULL;
+  cJSON_ArrayForEach(param, cJSON_GetObjectItemCaseSensitive(action, "params")) {
+    if (cJSON_IsNumber(param) && cmd->paramCount < COMMAND_MAX_PARAMS) {
+      snprintf(cmd->params[cmd->paramCount].name, sizeof(cmd->params[0].name),
+               "%s", param->string);
+      cmd->params[cmd->paramCount].value = param->valuedouble;
+      cmd->paramCount++;
+    }
+  }
+
+  return engine->actionCount++;
+}
+
+/* 编译一个条件 */
+static int compileCondition(ruleEngine_t *engine, rule_t *rule,
+                            const cJSON *cond) {
+  cJSON *field = cJSON_GetObjectItemCaseSensitive(cond, "field");
+  cJSON *op = cJSON_GetObjectItemCaseSensitive(cond, "op");
+  cJSON *value = cJSON_GetObjectItemCaseSensitive(cond, "value");
+  if (!cJSON_IsString(field) || !cJSON_IsString(op) || !cJSON_IsNumber(value) ||
+      rule->condCount >= RULE_MAX_CONDITIONS) {
+    return -1;
+  }
+
+  int fieldId = internField(engine, field->valuestring);
+  int opCode = parseOp(op->valuestring);
+  if (fieldId < 0 || opCode < 0) {
+    return -1;
+  }
+
+  ruleCondition_t *c = &rule->conds[rule->condCount++];
+  c->fieldId = (uint8_t)fieldId;
+  c->op = (uint8_t)opCode;
+  c->threshold = (float)value->valuedouble;
+  return 0;
+}
+
+static uint32_t getUint(const cJSON *obj, const char *key) {
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+  return (cJSON_IsNumber(item) && item->valuedouble > 0)
+             ? (uint32_t)item->valuedouble
+             : 0;
+}
+
+/*
+ * @brief 编译配置中的规则。规则在启动时被编译为定长结构：字段名解析为
+ *        下标，运算符解析为枚举，动作解析为命令模板，运行时只做数值比较。
+ *
+ * @param engine: 规则引擎
+ *        rules: ruleEngineConfig.rules 数组（可为NULL）
+ *
+ * @return 0 成功，-1 配置错误
+ * */
+int ruleEngine_Init(ruleEngine_t *engine, const cJSON *rules) {
+  if (!engine) {
+    return -1;
+  }
+
+  memset(engine, 0, sizeof(ruleEngine_t));
+  pthread_mutex_init(&engine->lock, NULL);
+
+  int count = cJSON_GetArraySize(rules);
+  if (count > RULE_MAX_RULES) {
+    fprintf(stderr, "Too many rules (%d > %d).\n", count, RULE_MAX_RULES);
+    return -1;
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  engine->rules = (rule_t *)memPool_Alloc(count * sizeof(rule_t));
+  engine->actions =
+      (sentinelCommand_t *)memPool_Alloc(count * 2 * sizeof(sentinelCommand_t));
+  if (!engine->rules || !engine->actions) {
+    return -1;
+  }
+  memset(engine->rules, 0, count * sizeof(rule_t));
+
+  const cJSON *ruleJson = NULL;
+  cJSON_ArrayForEach(ruleJson, rules) {
+    rule_t *rule = &engine->rules[engine->ruleCount];
+    cJSON *name = cJSON_GetObjectItemCaseSensitive(ruleJson, "name");
+    if (cJSON_IsString(name)) {
+      snprintf(rule->name, sizeof(rule->name), "%s", name->valuestring);
+    } else {
+      snprintf(rule->name, sizeof(rule->name), "rule_%d", engine->ruleCount);
+    }
+
+    // when 可以是单个条件对象，也可以是条件数组（AND关系）
+    cJSON *when = cJSON_GetObjectItemCaseSensitive(ruleJson, "when");
+    int rc = 0;
+    if (cJSON_IsArray(when)) {
+      cJSON *cond = NULL;
+      cJSON_ArrayForEach(cond, when) {
+        rc |= compileCondition(engine, rule, cond);
+      }
+    } else {
+      rc = compileCondition(engine, rule, when);
+    }
+    if (rc != 0 || rule->condCount == 0) {
+      fprintf(stderr, "Rule '%s': invalid condition.\n", rule->name);
+      return -1;
+    }
+
+    cJSON *hysteresis = cJSON_GetObjectItemCaseSensitive(ruleJson, "hysteresis");
+    rule->hysteresis =
+        cJSON_IsNumber(hysteresis) ? (float)hysteresis->valuedouble : 0;
+    rule->debounceMs = getUint(ruleJson, "debounceMs");
+    rule->rateLimitMs = getUint(ruleJson, "rateLimitMs");
+
+    int actionIdx = compileAction(
+        engine, rule->name, cJSON_GetObjectItemCaseSensitive(ruleJson, "action"));
+    int clearIdx = compileAction(
+        engine, rule->name,
+        cJSON_GetObjectItemCaseSensitive(ruleJson, "clearAction"));
+    if (actionIdx == -2 || clearIdx == -2) {
+      fprintf(stderr, "Rule '%s': invalid action.\n", rule->name);
+      return -1;
+    }
+    rule->actionIdx = (int16_t)actionIdx;
+    rule->clearIdx = (int16_t)clearIdx;
+
+    for (int i = 0; i < rule->condCount; i++) {
+      engine->fieldRules[rule->conds[i].fieldId] |= 1ULL << engine->ruleCount;
+    }
+    engine->ruleCount++;
+  }
+
+  return 0;
+}
+
+void ruleEngine_SetActionCallback(ruleEngine_t *engine,
+                                  ruleActionCallback_t callback,
+                                  void *userData) {
+  if (engine) {
+    engine->actionCb = callback;
+    engine->actionUserData = userData;
+  }
+}
+
+int ruleEngine_FieldId(const ruleEngine_t *engine, const char *name) {
+  for (int i = 0; engine && i < engine->fieldCount; i++) {
+    if (strcmp(engine->fieldNames[i], name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*
+ * @brief 评估单个条件。规则处于触发状态时阈值向"保持"方向放宽hysteresis，
+ *        避免信号在阈值附近抖动时反复触发。
+ * */
+static bool evalCondition(const ruleEngine_t *engine, const ruleCondition_t *c,
+                          bool active, float hysteresis) {
+  if (!engine->valid[c->fieldId]) {
+    return false;
+  }
+
+  double v = engine->values[c->fieldId];
+  double h = active ? hysteresis : 0;
+  switch (c->op) {
+  case RULE_OP_LT:
+    return v < c->threshold + h;
+  case RULE_OP_LE:
+    return v <= c->threshold + h;
+  case RULE_OP_GT:
+    return v > c->threshold - h;
+  case RULE_OP_GE:
+    return v >= c->threshold - h;
+  case RULE_OP_EQ:
+    return v == c->threshold;
+  case RULE_OP_NE:
+    return v != c->threshold;
+  default:
+    return false;
+  }
+}
+
+/*
+ * @brief 提交一次采样，只评估依赖这些字段的规则。动作在释放锁之后
+ *        通过回调执行，避免慢速动作阻塞其他采样线程。
+ *
+ * @param engine: 规则引擎
+ *        samples/count: 本次采样的字段值
+ *        nowMs: 当前单调时间（毫秒）
+ * */
+void ruleEngine_OnSample(ruleEngine_t *engine, const ruleSample_t *samples,
+                         int count, int64_t nowMs) {
+  if (!engine || engine->ruleCount == 0) {
+    return;
+  }
+
+  int16_t fired[RULE_MAX_RULES][2];
+  int firedCount = 0;
+
+  pthread_mutex_lock(&engine->lock);
+  uint64_t start = nowNs();
+
+  uint64_t dirty = 0;
+  for (int i = 0; i < count; i++) {
+    int id = samples[i].fieldId;
+    if (id < 0 || id >= engine->fieldCount) {
+      continue;
+    }
+    engine->values[id] = samples[i].value;
+    engine->valid[id] = true;
+    dirty |= engine->fieldRules[id];
+  }
+
+  while (dirty) {
+    int idx = __builtin_ctzll(dirty);
+    dirty &= dirty - 1;
+    rule_t *rule = &engine->rules[idx];
+
+    bool match = true;
+    for (int c = 0; c < rule->condCount && match; c++) {
+      match = evalCondition(engine, &rule->conds[c], rule->active,
+                            rule->hysteresis);
+    }
+
+    if (match == rule->active) {
+      rule->pendingSinceMs = 0;
+      continue;
+    }
+
+    // 去抖：状态变化必须持续 debounceMs
+    if (rule->pendingSinceMs == 0) {
+      rule->pendingSinceMs = nowMs;
+    }
+    if (nowMs - rule->pendingSinceMs < rule->debounceMs) {
+      continue;
+    }
+
+    // 限速：未到间隔时保持等待，后续采样再尝试
+    if (rule->fireCount > 0 && nowMs - rule->lastFireMs < rule->rateLimitMs) {
+      continue;
+    }
+
+    rule->active = match;
+    rule->pendingSinceMs = 0;
+    int16_t actionIdx = match ? rule->actionIdx : rule->clearIdx;
+    if (actionIdx >= 0) {
+      rule->lastFireMs = nowMs;
+      rule->fireCount++;
+      fired[firedCount][0] = (int16_t)idx;
+      fired[firedCount][1] = actionIdx;
+      firedCount++;
+    }
+  }
+
+  uint64_t cost = nowNs() - start;
+  engine->stats.samples++;
+  engine->stats.totalNs += cost;
+  if (cost > engine->stats.maxNs) {
+    engine->stats.maxNs = cost;
+  }
+  pthread_mutex_unlock(&engine->lock);
+
+  // 规则名和动作模板在启动后只读，解锁后访问是安全的
+  for (int i = 0; i < firedCount && engine->actionCb; i++) {
+    sentinelCommand_t cmd = engine->actions[fired[i][1]];
+    cmd.receivedNs = (long long)nowNs();
+    engine->actionCb(engine->rules[fired[i][0]].name, &cmd,
+                     engine->actionUserData);
+  }
+}
+
+void ruleEngine_GetStats(ruleEngine_t *engine, ruleEngineStats_t *stats) {
+  if (!engine || !stats) {
+    return;
+  }
+
+  pthread_mutex_lock(&engine->lock);
+  *stats = engine->stats;
+  stats->ruleCount = engine->ruleCount;
+  stats->fieldCount = engine->fieldCount;
+  pthread_mutex_unlock(&engine->lock);
+}
@@ -0,0 +1,303 @@
+#include "modules/sim.h"
+#include "modules/mem_pool.h"
+#include "modules/sim_clock.h"
+#include "modules/sim_sensor.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_MEMORY_POINTS 400 // 报告中内存用量的采样点上限
+
+static simConfig_t g_config;
+static struct {
+  int64_t elapsedMs;
+  long rssKb;
+  size_t poolUsed;
+} g_memPoints[SIM_MEMORY_POINTS];
+static int g_memPointCount = 0;
+
+/* 解析仿真Broker配置（simulationConfig.broker） */
+static void parseBrokerConfig(const cJSON *config_broker,
+                              simBrokerConfig_t *config) {
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_broker, "latencyMs");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    config->latencyMs = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_broker, "jitterMs");
+  if (item && cJSON_IsNumber(item) && item->valueint >= 0) {
+    config->jitterMs = item->valueint;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_broker, "connectFailPercent");
+  if (item && cJSON_IsNumber(item) && item->valuedouble >= 0) {
+    config->connectFailPercent = item->valuedouble;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_broker, "ackLossPercent");
+  if (item && cJSON_IsNumber(item) && item->valuedouble >= 0) {
+    config->ackLossPercent = item->valuedouble;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_broker, "dropPercent");
+  if (item && cJSON_IsNumber(item) && item->valuedouble >= 0) {
+    config->dropPercent = item->valuedouble;
+  }
+
+  item = cJSON_GetObjectItemCaseSensitive(config_broker, "outageEverySec");
+  if (item && cJSON_IsNumber(item) && item->valuedouble >= 0) {
+    config->periodicEveryMs = (int64_t)(item->valuedouble * 1000);
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_broker, "outageDurationSec");
+  if (item && cJSON_IsNumber(item) && item->valuedouble >= 0) {
+    config->periodicDurationMs = (int64_t)(item->valuedouble * 1000);
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_broker, "outageMode");
+  if (item && cJSON_IsString(item)) {
+    int mode = simBroker_ParseOutageMode(item->valuestring);
+    if (mode >= 0) {
+      config->periodicMode = (simOutageMode_t)mode;
+    } else {
+      fprintf(stderr, "Unknown outage mode '%s'.\n", item->valuestring);
+    }
+  }
+
+  // 单次中断：{"atSec", "durationSec", "mode", "broker"}
+  cJSON *outages = cJSON_GetObjectItemCaseSensitive(config_broker, "outages");
+  cJSON *entry = NULL;
+  cJSON_ArrayForEach(entry, outages) {
+    if (config->outageCount >= SIM_BROKER_MAX_OUTAGES) {
+      fprintf(stderr, "Too many simulated outages (max %d).\n",
+              SIM_BROKER_MAX_OUTAGES);
+      break;
+    }
+    cJSON *at = cJSON_GetObjectItemCaseSensitive(entry, "atSec");
+    cJSON *duration = cJSON_GetObjectItemCaseSensitive(entry, "durationSec");
+    cJSON *mode = cJSON_GetObjectItemCaseSensitive(entry, "mode");
+    cJSON *broker = cJSON_GetObjectItemCaseSensitive(entry, "broker");
+    int modeValue = simBroker_ParseOutageMode(
+        cJSON_IsString(mode) ? mode->valuestring : NULL);
+    if (!cJSON_IsNumber(at) || !cJSON_IsNumber(duration) || modeValue < 0) {
+      fprintf(stderr, "Invalid simulated outage, ignored.\n");
+      continue;
+    }
+    simOutage_t *outage = &config->outages[config->outageCount++];
+    outage->startMs = (int64_t)(at->valuedouble * 1000);
+    outage->durationMs = (int64_t)(duration->valuedouble * 1000);
+    outage->mode = (simOutageMode_t)modeValue;
+    outage->broker = cJSON_IsNumber(broker) ? broker->valueint : -1;
+  }
+}
+
+void sim_ParseConfig(const cJSON *config_sim, simConfig_t *config) {
+  if (config_sim == NULL || !cJSON_IsObject(config_sim)) {
+    return;
+  }
+
+  config->enabled =
+      cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(config_sim, "enabled"));
+  cJSON *item = cJSON_GetObjectItemCaseSensitive(config_sim, "durationSec");
+  if (item && cJSON_IsNumber(item) && item->valuedouble > 0) {
+    config->durationMs = (int64_t)(item->valuedouble * 1000);
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_sim, "epochMs");
+  if (item && cJSON_IsNumber(item) && item->valuedouble >= 0) {
+    config->epochMs = (int64_t)item->valuedouble;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_sim, "seed");
+  if (item && cJSON_IsNumber(item) && item->valuedouble >= 0) {
+    config->broker.seed = (uint32_t)item->valuedouble;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_sim, "reportIntervalSec");
+  if (item && cJSON_IsNumber(item) && item->valuedouble > 0) {
+    config->reportIntervalMs = (int64_t)(item->valuedouble * 1000);
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_sim, "report");
+  if (item && cJSON_IsString(item)) {
+    snprintf(config->reportPath, sizeof(config->reportPath), "%s",
+             item->valuestring);
+  }
+  item = cJSON_GetObjectItemCaseSensitive(config_sim, "replayFile");
+  if (item && cJSON_IsString(item)) {
+    snprintf(config->replayFile, sizeof(config->replayFile), "%s",
+             item->valuestring);
+  }
+
+  cJSON *config_broker = cJSON_GetObjectItemCaseSensitive(config_sim, "broker");
+  if (config_broker && cJSON_IsObject(config_broker)) {
+    parseBrokerConfig(config_broker, &config->broker);
+  }
+}
+
+int sim_Init(const simConfig_t *config) {
+  g_config = *config;
+  g_memPointCount = 0;
+  if (simClock_Start(config->epochMs) != 0 ||
+      simBroker_Init(&config->broker) != 0 ||
+      simSensor_Init(config->replayFile, config->broker.seed) != 0) {
+    fprintf(stderr, "Simulation initial failed.\n");
+    return -1;
+  }
+  fprintf(stdout, "Simulation: %.1f hours, seed %u.\n",
+          config->durationMs / 3600000.0, config->broker.seed);
+  return 0;
+}
+
+/* 当前常驻内存（KB），读取失败返回-1 */
+static long currentRssKb(void) {
+  FILE *fp = fopen("/proc/self/statm", "r");
+  long pages = -1;
+  if (fp) {
+    if (fscanf(fp, "%*s %ld", &pages) != 1) {
+      pages = -1;
+    }
+    fclose(fp);
+  }
+  return pages < 0 ? -1 : pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void recordMemory(void) {
+  if (g_memPointCount >= SIM_MEMORY_POINTS) {
+    return;
+  }
+  memPoolStats_t memStats;
+  memPool_GetStats(&memStats);
+  g_memPoints[g_memPointCount].elapsedMs = simClock_ElapsedMs();
+  g_memPoints[g_memPointCount].rssKb = currentRssKb();
+  g_memPoints[g_memPointCount].poolUsed = memStats.usedBytes;
+  g_memPointCount++;
+}
+
+/* 写出仿真报告（JSON），返回0成功 */
+static int writeReport(const simContext_t *ctx, const char *path) {
+  brokerGroupStats_t stats;
+  brokerGroup_GetStats(ctx->brokerGroup, &stats);
+  simBrokerStats_t brokers[SIM_BROKER_MAX];
+  int brokerCount = simBroker_GetStats(brokers, SIM_BROKER_MAX);
+  simClockStats_t clockStats;
+  simClock_GetStats(&clockStats);
+  memPoolStats_t memStats;
+  memPool_GetStats(&memStats);
+
+  unsigned long enqueued = 0, sent = 0, dropped = 0, expired = 0;
+  unsigned long coalesced = 0;
+  int queued = 0;
+  for (int i = 0; i < stats.outboxCount; i++) {
+    enqueued += stats.outboxes[i].enqueued;
+    sent += stats.outboxes[i].sent;
+    dropped += stats.outboxes[i].dropped;
+    expired += stats.outboxes[i].expired;
+    queued += stats.outboxes[i].queued;
+  }
+  for (int i = 0; i < stats.sourceCount; i++) {
+    coalesced += stats.sources[i].coalesced;
+  }
+  unsigned long received = 0, duplicates = 0, lost = 0;
+  for (int i = 0; i < brokerCount; i++) {
+    received += brokers[i].received;
+    duplicates += brokers[i].duplicates;
+    lost += brokers[i].lost;
+  }
+  unsigned long produced =
+      __atomic_load_n(ctx->samplesProduced, __ATOMIC_RELAXED);
+
+  FILE *fp = fopen(path, "w");
+  if (fp == NULL) {
+    fprintf(stderr, "Error: Could not write simulation report %s\n", path);
+    return -1;
+  }
+  // received 包含每次连接后的上线消息；loss_ratio 为已发出未送达的比例，
+  // undelivered_ratio 为生成后未能发出（合并、丢弃、过期、积压）的比例；
+  // first_publish_ms 为启动到第一条消息发出的虚拟时间（启动本身不耗时）
+  fprintf(fp,
+          "{\n  \"duration_sec\": %.3f,\n  \"epoch_ms\": %lld,\n"
+          "  \"seed\": %u,\n  \"messages\": {\"produced\": %lu, "
+          "\"skipped_offline\": %lu, \"enqueued\": %lu, \"coalesced\": %lu, "
+          "\"dropped\": %lu, \"expired\": %lu, \"sent\": %lu, "
+          "\"received\": %lu, \"duplicates\": %lu, \"lost\": %lu, "
+          "\"queued_at_end\": %d, \"loss_ratio\": %.6f, "
+          "\"undelivered_ratio\": %.6f},\n  \"first_publish_ms\": %.3f,\n"
+          "  \"failovers\": %lu,\n  \"brokers\": [",
+          clockStats.elapsedMs / 1000.0, (long long)g_config.epochMs,
+          g_config.broker.seed, produced,
+          __atomic_load_n(ctx->samplesOffline, __ATOMIC_RELAXED), enqueued,
+          coalesced, dropped, expired, sent, received, duplicates, lost,
+          queued, received + lost > 0 ? (double)lost / (received + lost) : 0,
+          produced > 0 && produced > sent
+              ? (double)(produced - sent) / produced
+              : 0,
+          stats.firstSentUs ? stats.firstSentUs / 1000.0 - stats.startedMs : -1,
+          stats.failovers);
+  for (int i = 0; i < brokerCount; i++) {
+    const simBrokerStats_t *b = &brokers[i];
+    fprintf(fp,
+            "%s\n    {\"address\": \"%s\", \"connects\": %lu, "
+            "\"connect_failures\": %lu, \"sessions_lost\": %lu, "
+            "\"received\": %lu, \"duplicates\": %lu, \"lost\": %lu, "
+            "\"refused\": %lu, \"bytes\": %lu, \"probes\": %lu, "
+            "\"probe_failures\": %lu, \"outage_sec\": %.3f}",
+            i ? "," : "", b->address, b->connects, b->connectFailures,
+            b->sessionsLost, b->received, b->duplicates, b->lost, b->refused,
+            b->bytes, b->probes, b->probeFailures, b->outageMs / 1000.0);
+  }
+
+  // RSS 受分配器和线程栈影响，仅供参考；内存池用量是确定的
+  long rssStart = g_memPointCount > 0 ? g_memPoints[0].rssKb : -1;
+  long rssEnd = g_memPointCount > 0
+                    ? g_memPoints[g_memPointCount - 1].rssKb
+                    : -1;
+  fprintf(fp,
+          "\n  ],\n  \"memory\": {\"pool_used_bytes\": %zu, "
+          "\"pool_budget_bytes\": %zu, \"rss_kb_start\": %ld, "
+          "\"rss_kb_end\": %ld, \"rss_kb_growth\": %ld, \"samples\": [",
+          memStats.usedBytes, memStats.budgetBytes, rssStart, rssEnd,
+          rssEnd - rssStart);
+  for (int i = 0; i < g_memPointCount; i++) {
+    fprintf(fp, "%s\n    {\"t_sec\": %lld, \"rss_kb\": %ld, "
+                "\"pool_used_bytes\": %zu}",
+            i ? "," : "", (long long)(g_memPoints[i].elapsedMs / 1000),
+            g_memPoints[i].rssKb, g_memPoints[i].poolUsed);
+  }
+  fprintf(fp,
+          "\n  ]},\n  \"clock\": {\"threads\": %d, \"switches\": %lu, "
+          "\"advances\": %lu, \"lock_retries\": %lu}\n}\n",
+          clockStats.threads, clockStats.switches, clockStats.advances,
+          clockStats.lockRetries);
+  fclose(fp);
+  return 0;
+}
+
+/*
+ * @brief  仿真主循环：按 reportIntervalSec 记录内存，到达 durationSec 后
+ *         写出报告，然后结束虚拟时钟让各线程按真实时间退出
+ * */
+int sim_Run(const simContext_t *ctx) {
+  struct timespec wallStart, wallEnd;
+  clock_gettime(CLOCK_MONOTONIC, &wallStart);
+  recordMemory();
+
+  int64_t nextReportMs = g_config.reportIntervalMs;
+  while (!*ctx->exitFlag && simClock_ElapsedMs() < g_config.durationMs) {
+    int64_t untilMs =
+        nextReportMs < g_config.durationMs ? nextReportMs : g_config.durationMs;
+    simClock_SleepMs(untilMs - simClock_ElapsedMs());
+    if (simClock_ElapsedMs() >= nextReportMs) {
+      recordMemory();
+      fprintf(stdout, "Simulated %.1f of %.1f hours.\n",
+              simClock_ElapsedMs() / 3600000.0,
+              g_config.durationMs / 3600000.0);
+      nextReportMs += g_config.reportIntervalMs;
+    }
+  }
+  int64_t lastMs = g_memPoints[g_memPointCount - 1].elapsedMs;
+  if (lastMs != simClock_ElapsedMs()) {
+    recordMemory();
+  }
+  int rc = writeReport(ctx, g_config.reportPath);
+
+  clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+  fprintf(stderr, "Simulation finished in %.1f s wall time, report: %s\n",
+          (wallEnd.tv_sec - wallStart.tv_sec) +
+              (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9,
+          g_config.reportPath);
+  *ctx->exitFlag = true;
+  simClock_Release();
+  return rc;
+}
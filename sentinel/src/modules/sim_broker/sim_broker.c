@@ -0,0 +1,372 @@
+#include "modules/sim_broker.h"
+#include "modules/sim_clock.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NEVER INT64_MAX
+#define DEFAULT_KEEPALIVE_MS 60000
+#define OUTAGE_SCAN_MAX 100000 // 统计中断时长时最多遍历的中断次数
+
+typedef struct {
+  char key[64]; // 主机:端口
+  uint64_t rng;
+  simBrokerStats_t stats;
+} simBrokerState_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool g_active = false;
+static simBrokerConfig_t g_config;
+static simBrokerState_t g_brokers[SIM_BROKER_MAX];
+static int g_brokerCount = 0;
+
+/* xorshift64*：每个Broker一个状态，调用顺序由虚拟时钟调度决定 */
+static uint64_t nextRandom(simBrokerState_t *broker) {
+  uint64_t x = broker->rng;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  broker->rng = x;
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+static bool chance(simBrokerState_t *broker, double percent) {
+  return percent > 0 &&
+         (double)(nextRandom(broker) % 1000000) < percent * 10000.0;
+}
+
+/* 单程延迟（持有 g_lock 调用） */
+static int delayMs(simBrokerState_t *broker) {
+  int jitter = g_config.jitterMs > 0
+                   ? (int)(nextRandom(broker) % (g_config.jitterMs + 1))
+                   : 0;
+  return g_config.latencyMs + jitter;
+}
+
+/*
+ * @brief 从 "tcp://host:1883" 之类的地址得到 "host:port"，
+ *        没有端口时按协议补上默认端口，与健康探测使用的主机和端口一致
+ * */
+static void makeKey(const char *address, char *key, size_t size) {
+  static const struct {
+    const char *scheme;
+    int port;
+  } schemes[] = {{"ssl://", 8883}, {"mqtts://", 8883}, {"ws://", 80},
+                 {"wss://", 443}};
+
+  int port = 1883;
+  for (size_t i = 0; i < sizeof(schemes) / sizeof(schemes[0]); i++) {
+    if (strncmp(address, schemes[i].scheme, strlen(schemes[i].scheme)) == 0) {
+      port = schemes[i].port;
+    }
+  }
+  const char *host = strstr(address, "://");
+  host = host ? host + 3 : address;
+  int len = (int)strcspn(host, "/");
+  const char *bracket = memchr(host, ']', len);
+  const char *colon = memchr(bracket ? bracket : host, ':',
+                             len - (bracket ? bracket - host : 0));
+  if (colon) {
+    snprintf(key, size, "%.*s", len, host);
+  } else {
+    snprintf(key, size, "%.*s:%d", len, host, port);
+  }
+}
+
+/* 按地址查找Broker，首次出现时登记（持有 g_lock 调用） */
+static int findBroker(const char *key) {
+  for (int i = 0; i < g_brokerCount; i++) {
+    if (strcmp(g_brokers[i].key, key) == 0) {
+      return i;
+    }
+  }
+  if (g_brokerCount >= SIM_BROKER_MAX) {
+    fprintf(stderr, "Too many simulated brokers (max %d).\n", SIM_BROKER_MAX);
+    return -1;
+  }
+
+  simBrokerState_t *broker = &g_brokers[g_brokerCount];
+  memset(broker, 0, sizeof(*broker));
+  snprintf(broker->key, sizeof(broker->key), "%s", key);
+  snprintf(broker->stats.address, sizeof(broker->stats.address), "%s", key);
+  broker->rng = (g_config.seed + 1) * 0x9E3779B97F4A7C15ULL ^
+                (uint64_t)(g_brokerCount + 1) * 0xBF58476D1CE4E5B9ULL;
+  if (broker->rng == 0) {
+    broker->rng = 1;
+  }
+  return g_brokerCount++;
+}
+
+/*
+ * @brief 查找结束时间晚于 fromMs 的最早一次中断（包括正在进行的）
+ *
+ * @return 找到时返回true
+ * */
+static bool findOutage(int broker, int64_t fromMs, int64_t *startMs,
+                       int64_t *endMs, simOutageMode_t *mode) {
+  bool found = false;
+  for (int i = 0; i < g_config.outageCount; i++) {
+    const simOutage_t *outage = &g_config.outages[i];
+    if ((outage->broker >= 0 && outage->broker != broker) ||
+        outage->startMs + outage->durationMs <= fromMs) {
+      continue;
+    }
+    if (!found || outage->startMs < *startMs) {
+      *startMs = outage->startMs;
+      *endMs = outage->startMs + outage->durationMs;
+      *mode = outage->mode;
+      found = true;
+    }
+  }
+
+  int64_t every = g_config.periodicEveryMs;
+  int64_t duration = g_config.periodicDurationMs;
+  if (every > 0 && duration > 0) {
+    int64_t k = fromMs / every;
+    if (k < 1) {
+      k = 1;
+    } else if (k * every + duration <= fromMs) {
+      k++;
+    }
+    if (!found || k * every < *startMs) {
+      *startMs = k * every;
+      *endMs = k * every + duration;
+      *mode = g_config.periodicMode;
+      found = true;
+    }
+  }
+  return found;
+}
+
+static bool inOutage(int broker, int64_t nowMs, simOutageMode_t *mode) {
+  int64_t start, end;
+  return findOutage(broker, nowMs, &start, &end, mode) && start <= nowMs;
+}
+
+/*
+ * @brief 计算客户端发现连接断开的时间：连接被重置时立即发现；报文被丢弃
+ *        时，中断开始后的第一次PINGREQ在keep-alive间隔内得不到响应才发现，
+ *        比这更短的中断不会断开连接（期间的消息丢失）
+ * */
+static void planSession(simBrokerSession_t *session) {
+  int64_t ka = session->keepAliveMs > 0 ? session->keepAliveMs
+                                        : DEFAULT_KEEPALIVE_MS;
+  int64_t from = session->connectedMs;
+  session->outageMs = -1;
+  session->lostMs = NEVER;
+  int64_t start, end;
+  simOutageMode_t mode;
+  for (int i = 0; i < OUTAGE_SCAN_MAX &&
+                  findOutage(session->broker, from, &start, &end, &mode);
+       i++) {
+    if (session->outageMs < 0) {
+      session->outageMs = start;
+    }
+    if (mode == SIM_OUTAGE_CLOSE) {
+      session->lostMs = start;
+      session->blackhole = false;
+      return;
+    }
+    int64_t pings = (start - session->connectedMs + ka - 1) / ka;
+    int64_t ping = session->connectedMs + pings * ka;
+    if (ping < end) {
+      session->lostMs = ping + ka;
+      session->blackhole = true;
+      return;
+    }
+    from = end;
+  }
+}
+
+int simBroker_Init(const simBrokerConfig_t *config) {
+  if (config == NULL || config->outageCount < 0 ||
+      config->outageCount > SIM_BROKER_MAX_OUTAGES) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&g_lock);
+  g_config = *config;
+  g_brokerCount = 0;
+  g_active = true;
+  pthread_mutex_unlock(&g_lock);
+  return 0;
+}
+
+bool simBroker_IsActive(void) {
+  return __atomic_load_n(&g_active, __ATOMIC_ACQUIRE);
+}
+
+int simBroker_ParseOutageMode(const char *name) {
+  if (name == NULL || strcmp(name, "close") == 0) {
+    return SIM_OUTAGE_CLOSE;
+  }
+  if (strcmp(name, "blackhole") == 0) {
+    return SIM_OUTAGE_BLACKHOLE;
+  }
+  return -1;
+}
+
+int simBroker_Open(simBrokerSession_t *session, const char *address,
+                   int keepAliveSec, int connectTimeoutMs) {
+  char key[64];
+  makeKey(address, key, sizeof(key));
+  memset(session, 0, sizeof(*session));
+
+  pthread_mutex_lock(&g_lock);
+  session->broker = findBroker(key);
+  pthread_mutex_unlock(&g_lock);
+  session->keepAliveMs = keepAliveSec * 1000;
+  session->connectTimeoutMs = connectTimeoutMs;
+  return session->broker >= 0 ? 0 : -1;
+}
+
+int simBroker_Connect(simBrokerSession_t *session) {
+  simBrokerState_t *broker = &g_brokers[session->broker];
+  session->open = false;
+
+  pthread_mutex_lock(&g_lock);
+  simOutageMode_t mode;
+  bool down = inOutage(session->broker, simClock_ElapsedMs(), &mode);
+  int rttMs = delayMs(broker) + delayMs(broker);
+  bool refused = !down && chance(broker, g_config.connectFailPercent);
+  pthread_mutex_unlock(&g_lock);
+
+  // 报文被丢弃时等到连接超时，其余情况一个往返后得到结果
+  int waitMs = down && mode == SIM_OUTAGE_BLACKHOLE ? session->connectTimeoutMs
+                                                    : rttMs;
+  if (!down && rttMs > session->connectTimeoutMs) {
+    waitMs = session->connectTimeoutMs;
+    down = true;
+  }
+  simClock_SleepMs(waitMs);
+
+  pthread_mutex_lock(&g_lock);
+  int64_t now = simClock_ElapsedMs();
+  if (down || refused || inOutage(session->broker, now, &mode)) {
+    broker->stats.connectFailures++;
+    pthread_mutex_unlock(&g_lock);
+    return -1;
+  }
+  broker->stats.connects++;
+  session->open = true;
+  session->connectedMs = now;
+  planSession(session);
+  pthread_mutex_unlock(&g_lock);
+  return 0;
+}
+
+/* 连接已被发现断开时关闭（持有 g_lock 调用） */
+static bool checkLost(simBrokerSession_t *session, int64_t now) {
+  if (session->open && now >= session->lostMs) {
+    session->open = false;
+    g_brokers[session->broker].stats.sessionsLost++;
+  }
+  return !session->open;
+}
+
+int simBroker_Yield(simBrokerSession_t *session, int ms) {
+  int64_t now = simClock_ElapsedMs();
+  int64_t wake = now + ms;
+  if (session->open && session->lostMs < wake) {
+    wake = session->lostMs;
+  }
+  if (wake > now) {
+    simClock_SleepMs(wake - now);
+  }
+
+  pthread_mutex_lock(&g_lock);
+  bool lost = checkLost(session, simClock_ElapsedMs());
+  pthread_mutex_unlock(&g_lock);
+  return lost ? -1 : 0;
+}
+
+/*
+ * @brief 发布：paho发出后即返回，不等待确认。报文被丢弃期间发出的、
+ *        以及到达前Broker开始中断的消息都算作丢失
+ * */
+int simBroker_Publish(simBrokerSession_t *session, int payloadLen, int qos) {
+  simBrokerState_t *broker = &g_brokers[session->broker];
+
+  pthread_mutex_lock(&g_lock);
+  int64_t now = simClock_ElapsedMs();
+  if (checkLost(session, now)) {
+    broker->stats.refused++;
+    pthread_mutex_unlock(&g_lock);
+    return -1;
+  }
+
+  simOutageMode_t mode;
+  int64_t start, end;
+  int64_t arriveMs = now + delayMs(broker);
+  if (findOutage(session->broker, now, &start, &end, &mode) &&
+      start <= arriveMs) {
+    broker->stats.lost++;
+  } else if (qos == 0 && chance(broker, g_config.dropPercent)) {
+    broker->stats.lost++;
+  } else {
+    broker->stats.received++;
+    broker->stats.bytes += payloadLen;
+    // 确认丢失后客户端重发，Broker再收到一次
+    if (qos > 0 && chance(broker, g_config.ackLossPercent)) {
+      broker->stats.duplicates++;
+    }
+  }
+  pthread_mutex_unlock(&g_lock);
+  return 0;
+}
+
+void simBroker_Disconnect(simBrokerSession_t *session) {
+  session->open = false;
+}
+
+int simBroker_Probe(const char *host, int port, int timeoutMs) {
+  char address[80];
+  char key[64];
+  snprintf(address, sizeof(address), strchr(host, ':') ? "[%s]:%d" : "%s:%d",
+           host, port);
+  makeKey(address, key, sizeof(key));
+
+  pthread_mutex_lock(&g_lock);
+  int index = findBroker(key);
+  if (index < 0) {
+    pthread_mutex_unlock(&g_lock);
+    return -1;
+  }
+  simBrokerState_t *broker = &g_brokers[index];
+  broker->stats.probes++;
+  simOutageMode_t mode;
+  bool down = inOutage(index, simClock_ElapsedMs(), &mode);
+  int rttMs = delayMs(broker) + delayMs(broker);
+  if (down || rttMs > timeoutMs) {
+    broker->stats.probeFailures++;
+  }
+  pthread_mutex_unlock(&g_lock);
+
+  if ((down && mode == SIM_OUTAGE_BLACKHOLE) || rttMs > timeoutMs) {
+    simClock_SleepMs(timeoutMs);
+    return -1;
+  }
+  simClock_SleepMs(rttMs);
+  return down ? -1 : rttMs * 1000;
+}
+
+int simBroker_GetStats(simBrokerStats_t *stats, int max) {
+  pthread_mutex_lock(&g_lock);
+  int64_t now = simClock_ElapsedMs();
+  int count = g_brokerCount < max ? g_brokerCount : max;
+  for (int i = 0; i < count; i++) {
+    stats[i] = g_brokers[i].stats;
+    stats[i].outageMs = 0;
+    int64_t from = 0;
+    int64_t start, end;
+    simOutageMode_t mode;
+    for (int k = 0; k < OUTAGE_SCAN_MAX &&
+                    findOutage(i, from, &start, &end, &mode) && start < now;
+         k++) {
+      stats[i].outageMs += (end < now ? end : now) - start;
+      from = end;
+    }
+  }
+  pthread_mutex_unlock(&g_lock);
+  return count;
+}
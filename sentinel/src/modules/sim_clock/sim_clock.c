@@ -0,0 +1,419 @@
+#include "modules/sim_clock.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NO_DEADLINE INT64_MAX
+#define LOCK_RETRY_NS 1000000LL // 锁被占用时1毫秒（虚拟时间）后重试
+
+typedef enum {
+  MODE_REAL = 0,
+  MODE_VIRTUAL,
+  MODE_RELEASED, // 仿真已结束，真实时钟加上偏移
+} clockMode_t;
+
+/* 参与线程 */
+typedef struct {
+  bool used;
+  bool arrived;  // 线程已开始运行（创建者预留位置时为false）
+  bool queued;   // 在等待运行权，按 (wakeNs, seq) 排序
+  bool granted;  // 已获得运行权
+  bool signaled; // 条件变量等待被唤醒（而不是超时）
+  int64_t wakeNs;
+  uint64_t seq;
+  pthread_cond_t *cond; // 正在等待的条件变量
+  pthread_cond_t wake;
+  pthread_t thread;
+  int joiner; // 等待本线程退出的线程下标，-1 表示没有
+  void *(*func)(void *);
+  void *arg;
+} simThread_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_arrived = PTHREAD_COND_INITIALIZER;
+static simThread_t g_threads[SIM_CLOCK_MAX_THREADS];
+static int g_mode = MODE_REAL;
+static int64_t g_nowNs;    // 虚拟时间（原子读，持有 g_lock 时写）
+static int64_t g_startNs;  // 仿真开始时的虚拟时间
+static int64_t g_epochNs;  // 仿真开始时的墙上时间
+static int64_t g_offsetNs; // 结束仿真后加在真实单调时钟上的偏移
+static uint64_t g_seq;
+static simClockStats_t g_stats;
+
+static __thread simThread_t *t_self = NULL;
+
+static int64_t clockNs(clockid_t id) {
+  struct timespec ts;
+  clock_gettime(id, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int currentMode(void) {
+  return __atomic_load_n(&g_mode, __ATOMIC_ACQUIRE);
+}
+
+/* 调用线程是否需要经过虚拟时钟调度 */
+static bool isParticipant(void) {
+  return t_self != NULL && currentMode() == MODE_VIRTUAL;
+}
+
+bool simClock_IsVirtual(void) { return currentMode() == MODE_VIRTUAL; }
+
+int64_t simClock_NowNs(void) {
+  if (currentMode() == MODE_VIRTUAL) {
+    return __atomic_load_n(&g_nowNs, __ATOMIC_RELAXED);
+  }
+  return clockNs(CLOCK_MONOTONIC) +
+         __atomic_load_n(&g_offsetNs, __ATOMIC_RELAXED);
+}
+
+int64_t simClock_NowMs(void) { return simClock_NowNs() / 1000000; }
+
+int64_t simClock_RealtimeNs(void) {
+  if (currentMode() == MODE_REAL) {
+    return clockNs(CLOCK_REALTIME);
+  }
+  return g_epochNs + simClock_NowNs() - g_startNs;
+}
+
+int64_t simClock_RealtimeMs(void) { return simClock_RealtimeNs() / 1000000; }
+
+int64_t simClock_ElapsedMs(void) {
+  if (currentMode() == MODE_REAL) {
+    return 0;
+  }
+  return (simClock_NowNs() - g_startNs) / 1000000;
+}
+
+/*
+ * @brief 参与线程的超时时间按仿真时钟计算（仿真结束后由
+ *        simClock_CondTimedWait 换算回真实时钟），其余线程按真实时钟
+ * */
+void simClock_Deadline(struct timespec *deadline, int64_t ms) {
+  bool simTime = t_self != NULL && currentMode() != MODE_REAL;
+  int64_t ns = (simTime ? simClock_NowNs() : clockNs(CLOCK_MONOTONIC)) +
+               ms * 1000000;
+  deadline->tv_sec = ns / 1000000000LL;
+  deadline->tv_nsec = ns % 1000000000LL;
+}
+
+/* 进入等待队列（持有 g_lock 调用），已过期的时刻按当前时间排队 */
+static void enqueue(simThread_t *thread, int64_t wakeNs) {
+  thread->wakeNs = wakeNs < g_nowNs ? g_nowNs : wakeNs;
+  thread->seq = ++g_seq;
+  thread->queued = true;
+}
+
+/* 最早到期的等待线程，同时到期时先进入等待的优先 */
+static simThread_t *earliest(void) {
+  simThread_t *best = NULL;
+  for (int i = 0; i < SIM_CLOCK_MAX_THREADS; i++) {
+    simThread_t *t = &g_threads[i];
+    if (!t->used || !t->queued) {
+      continue;
+    }
+    if (best == NULL || t->wakeNs < best->wakeNs ||
+        (t->wakeNs == best->wakeNs && t->seq < best->seq)) {
+      best = t;
+    }
+  }
+  return best;
+}
+
+/*
+ * @brief 把运行权交给最早到期的线程并推进虚拟时间（持有 g_lock 调用）。
+ *        新创建的线程尚未开始运行时等它就绪，保证交接顺序与线程调度无关
+ * */
+static void handOff(simThread_t *self) {
+  while (g_mode == MODE_VIRTUAL) {
+    simThread_t *next = earliest();
+    if (next == NULL || next->wakeNs == NO_DEADLINE) {
+      fprintf(stderr, "Simulation stalled: no thread has a deadline.\n");
+      return;
+    }
+    if (!next->arrived) {
+      pthread_cond_wait(&g_arrived, &g_lock);
+      continue;
+    }
+
+    if (next->wakeNs > g_nowNs) {
+      __atomic_store_n(&g_nowNs, next->wakeNs, __ATOMIC_RELAXED);
+      g_stats.advances++;
+    }
+    next->queued = false;
+    next->granted = true;
+    if (next != self) {
+      g_stats.switches++;
+      pthread_cond_signal(&next->wake);
+    }
+    return;
+  }
+}
+
+/* 交出运行权并等待再次获得（持有 g_lock 调用） */
+static void park(simThread_t *self) {
+  handOff(self);
+  while (!self->granted && g_mode == MODE_VIRTUAL) {
+    pthread_cond_wait(&self->wake, &g_lock);
+  }
+  self->granted = false;
+}
+
+int simClock_Start(int64_t epochMs) {
+  pthread_mutex_lock(&g_lock);
+  if (g_mode == MODE_VIRTUAL) {
+    pthread_mutex_unlock(&g_lock);
+    return -1;
+  }
+
+  memset(g_threads, 0, sizeof(g_threads));
+  for (int i = 0; i < SIM_CLOCK_MAX_THREADS; i++) {
+    pthread_cond_init(&g_threads[i].wake, NULL);
+    g_threads[i].joiner = -1;
+  }
+  memset(&g_stats, 0, sizeof(g_stats));
+  g_seq = 0;
+  // 再次进入仿真时从当前时间继续，单调时钟不回退
+  g_nowNs = clockNs(CLOCK_MONOTONIC) + g_offsetNs;
+  g_startNs = g_nowNs;
+  g_epochNs = epochMs * 1000000;
+
+  simThread_t *self = &g_threads[0];
+  self->used = true;
+  self->arrived = true;
+  self->thread = pthread_self();
+  t_self = self;
+  g_stats.threads = 1;
+  __atomic_store_n(&g_mode, MODE_VIRTUAL, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&g_lock);
+  return 0;
+}
+
+void simClock_Release(void) {
+  pthread_mutex_lock(&g_lock);
+  if (g_mode == MODE_VIRTUAL) {
+    __atomic_store_n(&g_offsetNs, g_nowNs - clockNs(CLOCK_MONOTONIC),
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&g_mode, MODE_RELEASED, __ATOMIC_RELEASE);
+    for (int i = 0; i < SIM_CLOCK_MAX_THREADS; i++) {
+      if (g_threads[i].used) {
+        g_threads[i].queued = false;
+        pthread_cond_signal(&g_threads[i].wake);
+      }
+    }
+    pthread_cond_broadcast(&g_arrived);
+  }
+  pthread_mutex_unlock(&g_lock);
+}
+
+/* 参与线程的虚拟睡眠，返回false表示仿真已结束（调用者改用真实睡眠） */
+static bool virtualSleep(int64_t ns) {
+  pthread_mutex_lock(&g_lock);
+  bool virtualMode = g_mode == MODE_VIRTUAL;
+  if (virtualMode) {
+    enqueue(t_self, g_nowNs + ns);
+    park(t_self);
+  }
+  pthread_mutex_unlock(&g_lock);
+  return virtualMode;
+}
+
+/* 被信号打断时继续睡完剩余时间 */
+void simClock_SleepMs(int64_t ms) {
+  if (isParticipant() && virtualSleep(ms * 1000000)) {
+    return;
+  }
+  if (ms <= 0) {
+    return;
+  }
+  struct timespec ts = {.tv_sec = ms / 1000,
+                        .tv_nsec = (long)(ms % 1000) * 1000000};
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+  }
+}
+
+int simClock_CondTimedWait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                           const struct timespec *deadline) {
+  if (isParticipant()) {
+    simThread_t *self = t_self;
+    pthread_mutex_lock(&g_lock);
+    if (g_mode == MODE_VIRTUAL) {
+      enqueue(self, deadline ? (int64_t)deadline->tv_sec * 1000000000LL +
+                                   deadline->tv_nsec
+                             : NO_DEADLINE);
+      self->cond = cond;
+      self->signaled = false;
+      // 唤醒方持有 mutex 时同样要获得 g_lock，不会错过唤醒
+      pthread_mutex_unlock(mutex);
+      park(self);
+      bool signaled = self->signaled;
+      self->cond = NULL;
+      pthread_mutex_unlock(&g_lock);
+      simClock_Lock(mutex);
+      return signaled ? 0 : ETIMEDOUT;
+    }
+    pthread_mutex_unlock(&g_lock);
+  }
+  if (deadline == NULL) {
+    return pthread_cond_wait(cond, mutex);
+  }
+  if (t_self != NULL && currentMode() == MODE_RELEASED) {
+    int64_t ns = (int64_t)deadline->tv_sec * 1000000000LL + deadline->tv_nsec -
+                 __atomic_load_n(&g_offsetNs, __ATOMIC_RELAXED);
+    struct timespec real = {.tv_sec = ns / 1000000000LL,
+                            .tv_nsec = ns % 1000000000LL};
+    return pthread_cond_timedwait(cond, mutex, &real);
+  }
+  return pthread_cond_timedwait(cond, mutex, deadline);
+}
+
+/* 仿真模式下按进入等待的顺序唤醒参与线程，然后照常唤醒真实等待者 */
+static void wakeWaiters(pthread_cond_t *cond, bool all) {
+  if (currentMode() == MODE_VIRTUAL) {
+    pthread_mutex_lock(&g_lock);
+    for (;;) {
+      simThread_t *first = NULL;
+      for (int i = 0; i < SIM_CLOCK_MAX_THREADS; i++) {
+        simThread_t *t = &g_threads[i];
+        if (t->used && t->queued && t->cond == cond &&
+            (first == NULL || t->seq < first->seq)) {
+          first = t;
+        }
+      }
+      if (first == NULL) {
+        break;
+      }
+      first->cond = NULL;
+      first->signaled = true;
+      enqueue(first, g_nowNs);
+      if (!all) {
+        break;
+      }
+    }
+    pthread_mutex_unlock(&g_lock);
+  }
+  if (all) {
+    pthread_cond_broadcast(cond);
+  } else {
+    pthread_cond_signal(cond);
+  }
+}
+
+void simClock_CondSignal(pthread_cond_t *cond) { wakeWaiters(cond, false); }
+
+void simClock_CondBroadcast(pthread_cond_t *cond) { wakeWaiters(cond, true); }
+
+/*
+ * @brief 仿真模式下不能阻塞在被其他参与线程持有的锁上（持有者在等待
+ *        运行权），锁被占用时按虚拟时间稍后重试
+ * */
+void simClock_Lock(pthread_mutex_t *mutex) {
+  if (!isParticipant()) {
+    pthread_mutex_lock(mutex);
+    return;
+  }
+  while (pthread_mutex_trylock(mutex) != 0) {
+    __atomic_add_fetch(&g_stats.lockRetries, 1, __ATOMIC_RELAXED);
+    if (!virtualSleep(LOCK_RETRY_NS)) {
+      pthread_mutex_lock(mutex);
+      return;
+    }
+  }
+}
+
+/* 新参与线程的入口：等待第一次获得运行权，退出时把运行权交出去 */
+static void *threadEntry(void *arg) {
+  simThread_t *self = (simThread_t *)arg;
+  t_self = self;
+
+  pthread_mutex_lock(&g_lock);
+  self->arrived = true;
+  pthread_cond_broadcast(&g_arrived);
+  while (!self->granted && g_mode == MODE_VIRTUAL) {
+    pthread_cond_wait(&self->wake, &g_lock);
+  }
+  self->granted = false;
+  pthread_mutex_unlock(&g_lock);
+
+  void *result = self->func(self->arg);
+
+  pthread_mutex_lock(&g_lock);
+  if (self->joiner >= 0) {
+    enqueue(&g_threads[self->joiner], g_nowNs);
+  }
+  self->used = false;
+  self->queued = false;
+  g_stats.threads--;
+  handOff(self);
+  pthread_mutex_unlock(&g_lock);
+  t_self = NULL;
+  return result;
+}
+
+/*
+ * @brief 仿真模式下新线程在创建时按当前时间排队，由调度决定何时开始运行
+ * */
+int simClock_CreateThread(pthread_t *thread, void *(*func)(void *),
+                          void *arg) {
+  if (!isParticipant()) {
+    return pthread_create(thread, NULL, func, arg);
+  }
+
+  pthread_mutex_lock(&g_lock);
+  simThread_t *slot = NULL;
+  for (int i = 0; i < SIM_CLOCK_MAX_THREADS && slot == NULL; i++) {
+    if (!g_threads[i].used) {
+      slot = &g_threads[i];
+    }
+  }
+  if (slot == NULL) {
+    pthread_mutex_unlock(&g_lock);
+    fprintf(stderr, "Too many simulated threads (max %d).\n",
+            SIM_CLOCK_MAX_THREADS);
+    return EAGAIN;
+  }
+
+  slot->used = true;
+  slot->arrived = false;
+  slot->granted = false;
+  slot->cond = NULL;
+  slot->joiner = -1;
+  slot->func = func;
+  slot->arg = arg;
+  enqueue(slot, g_nowNs);
+  int rc = pthread_create(&slot->thread, NULL, threadEntry, slot);
+  if (rc == 0) {
+    *thread = slot->thread;
+    g_stats.threads++;
+  } else {
+    slot->used = false;
+    slot->queued = false;
+  }
+  pthread_mutex_unlock(&g_lock);
+  return rc;
+}
+
+/* 仿真模式下等待期间交出运行权，目标线程退出时重新排队 */
+int simClock_JoinThread(pthread_t thread) {
+  if (isParticipant()) {
+    pthread_mutex_lock(&g_lock);
+    for (int i = 0; i < SIM_CLOCK_MAX_THREADS; i++) {
+      simThread_t *t = &g_threads[i];
+      if (t->used && t != t_self && pthread_equal(t->thread, thread)) {
+        t->joiner = (int)(t_self - g_threads);
+        park(t_self);
+        break;
+      }
+    }
+    pthread_mutex_unlock(&g_lock);
+  }
+  return pthread_join(thread, NULL);
+}
+
+void simClock_GetStats(simClockStats_t *stats) {
+  pthread_mutex_lock(&g_lock);
+  *stats = g_stats;
+  stats->running = g_mode == MODE_VIRTUAL;
+  pthread_mutex_unlock(&g_lock);
+  stats->elapsedMs = simClock_ElapsedMs();
+}
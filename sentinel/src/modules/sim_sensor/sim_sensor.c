@@ -0,0 +1,194 @@
+#include "modules/sim_sensor.h"
+#include "modules/mem_pool.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_MAX_BYTES 512
+#define DAY_MS 86400000.0
+
+typedef struct {
+  int64_t tMs;
+  double values[SIM_SENSOR_FIELDS];
+} simSensorRow_t;
+
+static const char *g_fieldNames[SIM_SENSOR_FIELDS] = {
+    "cpu_temp_c", "cpu_load",  "mem_usage_percent",
+    "light_lux",  "proximity", "infrared"};
+
+static uint32_t g_seed = 0;
+static simSensorRow_t *g_rows = NULL;
+static int g_rowCount = 0;
+static int64_t g_periodMs = 0;
+static bool g_present[SIM_SENSOR_FIELDS];
+
+/* (种子, 字段, 秒) 的确定噪声，范围 [-1, 1) */
+static double noise(int field, int64_t second) {
+  uint64_t x = ((uint64_t)g_seed << 32) ^ ((uint64_t)field << 56) ^
+               (uint64_t)second;
+  x ^= x >> 33;
+  x *= 0xFF51AFD7ED558CCDULL;
+  x ^= x >> 33;
+  x *= 0xC4CEB9FE1A85EC53ULL;
+  x ^= x >> 33;
+  return (double)(x >> 11) / (double)(1ULL << 52) - 1.0;
+}
+
+static double clamp(double value, double low, double high) {
+  return value < low ? low : value > high ? high : value;
+}
+
+/* 没有回放数据时生成的读数：以仿真开始为午夜的日周期 */
+static double synthetic(int field, int64_t elapsedMs) {
+  double day = fmod((double)elapsedMs, DAY_MS) / DAY_MS;
+  double wave = sin(2 * M_PI * (day - 0.25)); // 6点为0，12点最高
+  double daylight = wave > 0 ? wave : 0;
+  int64_t second = elapsedMs / 1000;
+
+  switch (field) {
+  case SIM_SENSOR_CPU_TEMP:
+    return 45 + 8 * wave + 1.5 * noise(field, second);
+  case SIM_SENSOR_CPU_LOAD:
+    return clamp(25 + 15 * wave + 15 * noise(field, second), 0, 100);
+  case SIM_SENSOR_MEM_USAGE:
+    return 40 + 5 * wave + 2 * noise(field, second);
+  case SIM_SENSOR_LIGHT_LUX:
+    return floor(clamp(800 * daylight + 20 * noise(field, second), 0, 65535));
+  case SIM_SENSOR_PROXIMITY:
+    if (noise(field, second) > 0.96) {
+      return 800; // 偶尔有物体靠近
+    }
+    return floor(25 + 25 * noise(field + 8, second));
+  case SIM_SENSOR_INFRARED:
+    return floor(clamp(240 * daylight + 10 * noise(field, second), 0, 1023));
+  default:
+    return 0;
+  }
+}
+
+void simSensor_Free(void) {
+  memPool_Free(g_rows);
+  g_rows = NULL;
+  g_rowCount = 0;
+  g_periodMs = 0;
+  memset(g_present, 0, sizeof(g_present));
+}
+
+/* 解析表头，columns[i] 为第 i 列对应的字段，-1 表示忽略 */
+static int parseHeader(char *line, int *columns, int max) {
+  int count = 0;
+  char *save = NULL;
+  for (char *name = strtok_r(line, ",\r\n", &save); name && count < max;
+       name = strtok_r(NULL, ",\r\n", &save)) {
+    while (*name == ' ') {
+      name++;
+    }
+    columns[count] = -1;
+    for (int i = 0; i < SIM_SENSOR_FIELDS; i++) {
+      if (strcmp(name, g_fieldNames[i]) == 0) {
+        columns[count] = i;
+        g_present[i] = true;
+      }
+    }
+    count++;
+  }
+  return count;
+}
+
+int simSensor_Init(const char *replayPath, uint32_t seed) {
+  simSensor_Free();
+  g_seed = seed;
+  if (replayPath == NULL || replayPath[0] == '\0') {
+    return 0;
+  }
+
+  FILE *fp = fopen(replayPath, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "Error: Could not open replay file %s\n", replayPath);
+    return -1;
+  }
+  char line[LINE_MAX_BYTES];
+  int lines = 0;
+  while (fgets(line, sizeof(line), fp)) {
+    lines++;
+  }
+  rewind(fp);
+
+  int columns[SIM_SENSOR_FIELDS + 1];
+  int columnCount = 0;
+  if (fgets(line, sizeof(line), fp)) {
+    columnCount = parseHeader(line, columns, SIM_SENSOR_FIELDS + 1);
+  }
+  g_rows = lines > 1 ? (simSensorRow_t *)memPool_Alloc(sizeof(simSensorRow_t) *
+                                                       (lines - 1))
+                     : NULL;
+  if (columnCount < 2 || strncmp(line, "t_ms", 4) != 0 || g_rows == NULL) {
+    fprintf(stderr, "Invalid replay file %s (expected t_ms,<fields>...).\n",
+            replayPath);
+    fclose(fp);
+    simSensor_Free();
+    return -1;
+  }
+
+  while (fgets(line, sizeof(line), fp)) {
+    simSensorRow_t *row = &g_rows[g_rowCount];
+    char *save = NULL;
+    char *field = strtok_r(line, ",\r\n", &save);
+    if (field == NULL) {
+      continue; // 空行
+    }
+    row->tMs = strtoll(field, NULL, 10);
+    if (g_rowCount > 0 && row->tMs <= g_rows[g_rowCount - 1].tMs) {
+      fprintf(stderr, "Replay file %s: t_ms must increase (line %d).\n",
+              replayPath, g_rowCount + 2);
+      fclose(fp);
+      simSensor_Free();
+      return -1;
+    }
+    for (int i = 1; i < columnCount; i++) {
+      field = strtok_r(NULL, ",\r\n", &save);
+      if (columns[i] >= 0) {
+        row->values[columns[i]] = field ? strtod(field, NULL) : 0;
+      }
+    }
+    g_rowCount++;
+  }
+  fclose(fp);
+
+  if (g_rowCount == 0) {
+    fprintf(stderr, "Replay file %s has no samples.\n", replayPath);
+    simSensor_Free();
+    return -1;
+  }
+  // 最后一行保持一个采样间隔后回到第一行
+  int64_t last = g_rows[g_rowCount - 1].tMs;
+  int64_t step = g_rowCount > 1 ? last - g_rows[g_rowCount - 2].tMs : 1000;
+  g_periodMs = last + step;
+  return 0;
+}
+
+double simSensor_Value(simSensorField_t field, int64_t elapsedMs) {
+  if (field < 0 || field >= SIM_SENSOR_FIELDS) {
+    return 0;
+  }
+  if (g_rowCount == 0 || !g_present[field]) {
+    return synthetic(field, elapsedMs);
+  }
+
+  int64_t t = elapsedMs % g_periodMs;
+  if (t < g_rows[0].tMs) {
+    return g_rows[g_rowCount - 1].values[field]; // 循环前的最后一个值
+  }
+  int low = 0, high = g_rowCount - 1;
+  while (low < high) {
+    int mid = (low + high + 1) / 2;
+    if (g_rows[mid].tMs <= t) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+  return g_rows[low].values[field];
+}
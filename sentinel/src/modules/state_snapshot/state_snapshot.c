@@ -0,0 +1,178 @@
+#include "modules/state_snapshot.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* 文件头，位于缓冲起始处 */
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t bodyLen; // 记录部分的长度
+  uint32_t crc;     // 记录部分的CRC32
+} snapshotHeader_t;
+
+typedef struct {
+  uint16_t tag;
+  uint16_t reserved;
+  uint32_t len; // 内容长度（不含补齐）
+} snapshotRecord_t;
+
+_Static_assert(sizeof(snapshotHeader_t) == STATE_SNAPSHOT_HEADER,
+               "snapshot header size");
+_Static_assert(sizeof(snapshotRecord_t) == STATE_SNAPSHOT_RECORD,
+               "snapshot record size");
+
+static size_t padded(size_t len) { return (len + 7) & ~(size_t)7; }
+
+/* 按半字节查表，表只有16项 */
+uint32_t stateSnapshot_Crc32(const void *data, size_t len) {
+  static const uint32_t table[16] = {
+      0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4,
+      0x4db26158, 0x5005713c, 0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+      0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+  };
+  const uint8_t *p = (const uint8_t *)data;
+  uint32_t crc = 0xffffffff;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= p[i];
+    crc = (crc >> 4) ^ table[crc & 0x0f];
+    crc = (crc >> 4) ^ table[crc & 0x0f];
+  }
+  return ~crc;
+}
+
+void stateSnapshot_Begin(stateSnapshot_t *snap, void *buf, size_t cap) {
+  snap->buf = (uint8_t *)buf;
+  snap->cap = cap;
+  snap->len = STATE_SNAPSHOT_HEADER;
+  snap->truncated = 0;
+}
+
+void *stateSnapshot_Reserve(stateSnapshot_t *snap, uint16_t tag,
+                            uint32_t len) {
+  size_t size = STATE_SNAPSHOT_RECORD + padded(len);
+  if (snap->buf == NULL || snap->cap < snap->len ||
+      size > snap->cap - snap->len) {
+    snap->truncated++;
+    return NULL;
+  }
+
+  snapshotRecord_t record = {.tag = tag, .len = len};
+  uint8_t *p = snap->buf + snap->len;
+  memcpy(p, &record, sizeof(record));
+  // 补齐的字节清零，相同的状态得到相同的文件
+  memset(p + STATE_SNAPSHOT_RECORD + len, 0, padded(len) - len);
+  snap->len += size;
+  return p + STATE_SNAPSHOT_RECORD;
+}
+
+int stateSnapshot_Put(stateSnapshot_t *snap, uint16_t tag, const void *data,
+                      uint32_t len) {
+  void *p = stateSnapshot_Reserve(snap, tag, len);
+  if (p == NULL) {
+    return -1;
+  }
+  memcpy(p, data, len);
+  return 0;
+}
+
+/*
+ * @brief 填写文件头后一次写入临时文件，同步后重命名
+ * */
+int stateSnapshot_Save(stateSnapshot_t *snap, const char *path) {
+  if (snap->buf == NULL || path == NULL || path[0] == '\0') {
+    return -1;
+  }
+
+  snapshotHeader_t header = {
+      .magic = STATE_SNAPSHOT_MAGIC,
+      .version = STATE_SNAPSHOT_VERSION,
+      .bodyLen = (uint32_t)(snap->len - STATE_SNAPSHOT_HEADER),
+  };
+  header.crc = stateSnapshot_Crc32(snap->buf + STATE_SNAPSHOT_HEADER,
+                                   header.bodyLen);
+  memcpy(snap->buf, &header, sizeof(header));
+
+  char tmpPath[256];
+  if (snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path) >=
+      (int)sizeof(tmpPath)) {
+    return -1;
+  }
+  int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    perror("Error opening state snapshot");
+    return -1;
+  }
+  int rc = write(fd, snap->buf, snap->len) == (ssize_t)snap->len &&
+                   fsync(fd) == 0
+               ? 0
+               : -1;
+  close(fd);
+  if (rc != 0 || rename(tmpPath, path) != 0) {
+    perror("Error saving state snapshot");
+    unlink(tmpPath);
+    return -1;
+  }
+  return 0;
+}
+
+int stateSnapshot_Load(stateSnapshot_t *snap, void *buf, size_t cap,
+                       const char *path) {
+  stateSnapshot_Begin(snap, buf, cap);
+  snap->len = 0;
+  if (buf == NULL || path == NULL || path[0] == '\0') {
+    return -1;
+  }
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+
+  struct stat st;
+  ssize_t n = -1;
+  if (fstat(fd, &st) == 0 && st.st_size >= STATE_SNAPSHOT_HEADER &&
+      (size_t)st.st_size <= cap) {
+    n = read(fd, buf, st.st_size);
+  }
+  close(fd);
+  snapshotHeader_t header;
+  if (n < 0 || n != st.st_size) {
+    fprintf(stderr, "Ignoring unreadable state snapshot %s.\n", path);
+    return -1;
+  }
+  memcpy(&header, buf, sizeof(header));
+  if (header.magic != STATE_SNAPSHOT_MAGIC ||
+      header.version != STATE_SNAPSHOT_VERSION ||
+      header.bodyLen != (size_t)n - STATE_SNAPSHOT_HEADER ||
+      header.crc != stateSnapshot_Crc32(snap->buf + STATE_SNAPSHOT_HEADER,
+                                        header.bodyLen)) {
+    fprintf(stderr, "Ignoring invalid state snapshot %s.\n", path);
+    return -1;
+  }
+  snap->len = n;
+  return 0;
+}
+
+int stateSnapshot_Next(const stateSnapshot_t *snap, size_t *offset,
+                       uint16_t *tag, const void **data, uint32_t *len) {
+  size_t pos = *offset ? *offset : STATE_SNAPSHOT_HEADER;
+  if (snap->len < STATE_SNAPSHOT_HEADER + STATE_SNAPSHOT_RECORD ||
+      pos > snap->len - STATE_SNAPSHOT_RECORD) {
+    return -1;
+  }
+
+  snapshotRecord_t record;
+  memcpy(&record, snap->buf + pos, sizeof(record));
+  size_t size = STATE_SNAPSHOT_RECORD + padded(record.len);
+  if (size > snap->len - pos) {
+    return -1;
+  }
+  *tag = record.tag;
+  *data = snap->buf + pos + STATE_SNAPSHOT_RECORD;
+  *len = record.len;
+  *offset = pos + size;
+  return 0;
+}
@@ -0,0 +1,537 @@
+#include "modules/tcp_ingest.h"
+#include "modules/mem_pool.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TCP_INGEST_RETRY_MS 10 // 暂停的连接重试间隔
+#define TCP_INGEST_PREFIX 4    // 长度前缀字节数
+
+/* 设备连接，head/tail 为累计字节数，取模后得到环形缓冲中的位置 */
+typedef struct ingestConn {
+  int fd; // -1 表示空闲
+  uint32_t head;
+  uint32_t tail;
+  uint8_t *ring;
+  double tokens; // 令牌桶，容量为一秒的消息数
+  int64_t refillMs;
+  bool paused;
+  bool eof; // 对端已关闭，处理完缓冲中的帧后断开
+  struct ingestConn *nextPaused;
+} ingestConn_t;
+
+static tcpIngestConfig_t g_config;
+static eventLoop_t *g_loop = NULL;
+static int g_listenFd = -1;
+static int g_retryFd = -1;
+static ingestConn_t *g_conns = NULL;
+static int *g_freeConns = NULL; // 空闲连接的下标栈
+static int g_freeCount = 0;
+static uint8_t *g_scratch = NULL; // 跨越缓冲末尾的帧复制到这里解析
+static ingestConn_t *g_pausedHead = NULL;
+static tcpIngestForwardCallback_t g_forwardCb = NULL;
+static void *g_forwardUserData = NULL;
+static tcpIngestStats_t g_stats;
+
+static int64_t monotonicMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint32_t ringMask(void) { return (uint32_t)g_config.ringBytes - 1; }
+
+static uint8_t byteAt(const ingestConn_t *conn, uint32_t pos) {
+  return conn->ring[pos & ringMask()];
+}
+
+/*
+ * @brief 取得从 start 开始的 len 字节的连续视图。大多数帧在缓冲中是连续的，
+ *        直接返回缓冲内的指针；跨越末尾时拼接到 g_scratch
+ * */
+static const char *frameView(const ingestConn_t *conn, uint32_t start,
+                             uint32_t len) {
+  uint32_t pos = start & ringMask();
+  uint32_t first = (uint32_t)g_config.ringBytes - pos;
+  if (len <= first) {
+    return (const char *)conn->ring + pos;
+  }
+  memcpy(g_scratch, conn->ring + pos, first);
+  memcpy(g_scratch + first, conn->ring, len - first);
+  g_stats.copied++;
+  return (const char *)g_scratch;
+}
+
+static void closeConn(ingestConn_t *conn) {
+  eventLoop_RemoveFd(g_loop, conn->fd);
+  close(conn->fd);
+  conn->fd = -1;
+  g_freeConns[g_freeCount++] = (int)(conn - g_conns);
+  g_stats.closed++;
+  g_stats.connections--;
+}
+
+static void pauseConn(ingestConn_t *conn) {
+  conn->paused = true;
+  eventLoop_ModifyFd(g_loop, conn->fd, 0);
+  if (g_pausedHead == NULL) {
+    uint64_t retryNs = TCP_INGEST_RETRY_MS * 1000000ULL;
+    eventLoop_ArmTimer(g_retryFd, retryNs, retryNs);
+  }
+  conn->nextPaused = g_pausedHead;
+  g_pausedHead = conn;
+  g_stats.paused++;
+}
+
+static bool takeToken(ingestConn_t *conn) {
+  if (g_config.maxMsgsPerSec <= 0) {
+    return true;
+  }
+
+  int64_t now = monotonicMs();
+  conn->tokens += (double)(now - conn->refillMs) * g_config.maxMsgsPerSec /
+                  1000.0;
+  conn->refillMs = now;
+  if (conn->tokens > g_config.maxMsgsPerSec) {
+    conn->tokens = g_config.maxMsgsPerSec;
+  }
+  if (conn->tokens < 1) {
+    return false;
+  }
+  conn->tokens -= 1;
+  return true;
+}
+
+static const char *skipSpace(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+    p++;
+  }
+  return p;
+}
+
+/* 跳过字符串（p 指向开头的引号），返回结尾引号之后的位置 */
+static const char *skipString(const char *p, const char *end) {
+  for (p++; p < end; p++) {
+    if (*p == '\\') {
+      p++;
+    } else if (*p == '"') {
+      return p + 1;
+    }
+  }
+  return NULL;
+}
+
+/* 跳过任意值：字符串、嵌套的对象/数组，或数字和字面量 */
+static const char *skipValue(const char *p, const char *end) {
+  if (p < end && *p == '"') {
+    return skipString(p, end);
+  }
+  int depth = 0;
+  while (p < end) {
+    if (*p == '"') {
+      p = skipString(p, end);
+      if (!p) {
+        return NULL;
+      }
+      continue;
+    }
+    if (*p == '{' || *p == '[') {
+      depth++;
+    } else if (*p == '}' || *p == ']') {
+      if (depth == 0) {
+        return p;
+      }
+      if (--depth == 0) {
+        return p + 1;
+      }
+    } else if (*p == ',' && depth == 0) {
+      return p;
+    }
+    p++;
+  }
+  return depth == 0 ? p : NULL;
+}
+
+/*
+ * @brief 在帧内原地扫描顶层JSON对象，找到 "sensor_type" 的值，
+ *        不构建JSON树、不分配内存。值只能由小写字母、数字和下划线组成，
+ *        避免形成多级或通配Topic
+ *
+ * @return 0 成功
+ * */
+static int findSensorType(const char *frame, int len, const char **type,
+                          int *typeLen) {
+  const char *end = frame + len;
+  const char *p = skipSpace(frame, end);
+  if (p == end || *p++ != '{') {
+    return -1;
+  }
+
+  *type = NULL;
+  while (true) {
+    p = skipSpace(p, end);
+    if (p < end && *p == '}' && *type == NULL) {
+      return -1;
+    }
+    if (p == end || *p != '"') {
+      return -1;
+    }
+    const char *key = p + 1;
+    p = skipString(p, end);
+    if (!p) {
+      return -1;
+    }
+    bool isType = p - 1 - key == 11 && memcmp(key, "sensor_type", 11) == 0;
+    p = skipSpace(p, end);
+    if (p == end || *p++ != ':') {
+      return -1;
+    }
+    p = skipSpace(p, end);
+
+    const char *value = p;
+    p = skipValue(p, end);
+    if (!p) {
+      return -1;
+    }
+    if (isType) {
+      if (*value != '"') {
+        return -1;
+      }
+      *type = value + 1;
+      *typeLen = (int)(p - value - 2);
+    }
+
+    p = skipSpace(p, end);
+    if (p < end && *p == ',') {
+      p++;
+      continue;
+    }
+    if (p == end || *p != '}' || skipSpace(p + 1, end) != end) {
+      return -1;
+    }
+    break;
+  }
+
+  if (*type == NULL || *typeLen < 1 || *typeLen > TCP_INGEST_TYPE_MAX) {
+    return -1;
+  }
+  for (int i = 0; i < *typeLen; i++) {
+    char c = (*type)[i];
+    if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_')) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * @brief 取出下一帧
+ *
+ * @return 1 得到一帧（frame 为NULL表示空行），0 数据不完整，
+ *         -1 帧超过缓冲大小
+ * */
+static int nextFrame(ingestConn_t *conn, const char **frame, uint32_t *len,
+                     uint32_t *consumed) {
+  uint32_t used = conn->tail - conn->head;
+  uint32_t size = (uint32_t)g_config.ringBytes;
+  if (used == 0) {
+    return 0;
+  }
+
+  // 首字节为0：4字节大端长度前缀
+  if (byteAt(conn, conn->head) == 0) {
+    if (used < TCP_INGEST_PREFIX) {
+      return 0;
+    }
+    uint32_t frameLen = 0;
+    for (int i = 0; i < TCP_INGEST_PREFIX; i++) {
+      frameLen = frameLen << 8 | byteAt(conn, conn->head + i);
+    }
+    if (frameLen == 0 || frameLen > size - TCP_INGEST_PREFIX) {
+      return -1;
+    }
+    if (used < TCP_INGEST_PREFIX + frameLen) {
+      return 0;
+    }
+    *frame = frameView(conn, conn->head + TCP_INGEST_PREFIX, frameLen);
+    *len = frameLen;
+    *consumed = TCP_INGEST_PREFIX + frameLen;
+    return 1;
+  }
+
+  // 换行分隔：分两段查找换行符
+  uint32_t pos = conn->head & ringMask();
+  uint32_t first = size - pos < used ? size - pos : used;
+  const uint8_t *nl = memchr(conn->ring + pos, '\n', first);
+  uint32_t lineLen;
+  if (nl) {
+    lineLen = (uint32_t)(nl - (conn->ring + pos));
+  } else {
+    nl = used > first ? memchr(conn->ring, '\n', used - first) : NULL;
+    if (!nl) {
+      return used == size ? -1 : 0;
+    }
+    lineLen = first + (uint32_t)(nl - conn->ring);
+  }
+
+  *consumed = lineLen + 1;
+  if (lineLen > 0 && byteAt(conn, conn->head + lineLen - 1) == '\r') {
+    lineLen--;
+  }
+  *len = lineLen;
+  *frame = lineLen ? frameView(conn, conn->head, lineLen) : NULL;
+  return 1;
+}
+
+/*
+ * @brief 解析并转发缓冲中的完整帧。超过速率或发布繁忙时暂停连接，
+ *        未转发的帧留在缓冲中
+ * */
+static void processFrames(ingestConn_t *conn) {
+  while (!conn->paused) {
+    const char *frame;
+    uint32_t len, consumed;
+    int rc = nextFrame(conn, &frame, &len, &consumed);
+    if (rc == 0) {
+      break;
+    }
+    if (rc < 0) {
+      g_stats.oversized++;
+      closeConn(conn);
+      return;
+    }
+
+    if (frame) {
+      const char *type;
+      int typeLen = 0;
+      if (findSensorType(frame, (int)len, &type, &typeLen) != 0) {
+        g_stats.badFrames++;
+      } else if (!takeToken(conn)) {
+        g_stats.throttled++;
+        pauseConn(conn);
+        return;
+      } else if (g_forwardCb(type, typeLen, frame, (int)len,
+                             g_forwardUserData) != 0) {
+        conn->tokens += 1;
+        g_stats.busy++;
+        pauseConn(conn);
+        return;
+      } else {
+        g_stats.messages++;
+      }
+    }
+    conn->head += consumed;
+  }
+
+  if (conn->eof) {
+    closeConn(conn);
+  }
+}
+
+static void connReadHandle(int fd, uint32_t events, void *userData) {
+  ingestConn_t *conn = (ingestConn_t *)userData;
+  if (conn->fd != fd) {
+    return;
+  }
+  if (conn->paused) {
+    // 暂停时epoll仍会报告挂断，先停止监听，恢复时再断开
+    if (events & (EPOLLHUP | EPOLLERR)) {
+      eventLoop_RemoveFd(g_loop, fd);
+      conn->eof = true;
+    }
+    return;
+  }
+
+  uint32_t size = (uint32_t)g_config.ringBytes;
+  uint32_t used = conn->tail - conn->head;
+  uint32_t pos = conn->tail & ringMask();
+  uint32_t room = size - used;
+  uint32_t first = size - pos < room ? size - pos : room;
+  struct iovec iov[2] = {{conn->ring + pos, first},
+                         {conn->ring, room - first}};
+
+  ssize_t n = readv(fd, iov, room > first ? 2 : 1);
+  if (n < 0) {
+    if (errno == EAGAIN || errno == EINTR) {
+      return;
+    }
+    closeConn(conn);
+    return;
+  }
+  if (n == 0) {
+    conn->eof = true;
+  }
+  conn->tail += (uint32_t)n;
+  g_stats.bytes += (unsigned long)n;
+  processFrames(conn);
+}
+
+/* 重试暂停的连接，仍然受限的连接重新进入暂停列表 */
+static void retryTimerHandle(int fd, uint32_t events, void *userData) {
+  eventLoop_AckTimer(fd);
+
+  ingestConn_t *conn = g_pausedHead;
+  g_pausedHead = NULL;
+  while (conn) {
+    ingestConn_t *next = conn->nextPaused;
+    conn->paused = false;
+    g_stats.paused--;
+    processFrames(conn);
+    if (conn->fd >= 0 && !conn->paused) {
+      eventLoop_ModifyFd(g_loop, conn->fd, EPOLLIN);
+    }
+    conn = next;
+  }
+
+  if (g_pausedHead == NULL) {
+    eventLoop_ArmTimer(fd, 0, 0);
+  }
+}
+
+static void acceptHandle(int fd, uint32_t events, void *userData) {
+  int clientFd;
+  while ((clientFd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >=
+         0) {
+    if (g_freeCount == 0) {
+      g_stats.rejected++;
+      close(clientFd);
+      continue;
+    }
+
+    ingestConn_t *conn = &g_conns[g_freeConns[g_freeCount - 1]];
+    if (eventLoop_AddFd(g_loop, clientFd, EPOLLIN, connReadHandle, conn) !=
+        0) {
+      g_stats.rejected++;
+      close(clientFd);
+      continue;
+    }
+    g_freeCount--;
+
+    // 设备掉电时由保活探测回收连接
+    int one = 1;
+    setsockopt(clientFd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    conn->fd = clientFd;
+    conn->head = 0;
+    conn->tail = 0;
+    conn->tokens = g_config.maxMsgsPerSec;
+    conn->refillMs = monotonicMs();
+    conn->paused = false;
+    conn->eof = false;
+    g_stats.accepted++;
+    g_stats.connections++;
+  }
+}
+
+/*
+ * @brief 创建监听套接字并注册到事件循环
+ *
+ * @param config: 配置
+ *        loop: 共享的事件循环
+ *        callback: 转发回调（在事件循环线程中调用）
+ *
+ * @return 0 成功
+ * */
+int tcpIngest_Init(const tcpIngestConfig_t *config, eventLoop_t *loop,
+                   tcpIngestForwardCallback_t callback, void *userData) {
+  if (!config || !loop || !callback || config->maxClients <= 0 ||
+      config->ringBytes < 64 ||
+      (config->ringBytes & (config->ringBytes - 1)) != 0) {
+    return -1;
+  }
+
+  g_config = *config;
+  g_loop = loop;
+  g_forwardCb = callback;
+  g_forwardUserData = userData;
+  g_pausedHead = NULL;
+  memset(&g_stats, 0, sizeof(g_stats));
+
+  // 连接表和所有环形缓冲在启动时一次性分配
+  int count = config->maxClients;
+  g_conns = (ingestConn_t *)memPool_Alloc(count * sizeof(ingestConn_t));
+  g_freeConns = (int *)memPool_Alloc(count * sizeof(int));
+  uint8_t *rings = (uint8_t *)memPool_Alloc((size_t)count * config->ringBytes);
+  g_scratch = (uint8_t *)memPool_Alloc(config->ringBytes);
+  if (!g_conns || !g_freeConns || !rings || !g_scratch) {
+    return -1;
+  }
+  for (int i = 0; i < count; i++) {
+    memset(&g_conns[i], 0, sizeof(ingestConn_t));
+    g_conns[i].fd = -1;
+    g_conns[i].ring = rings + (size_t)i * config->ringBytes;
+    g_freeConns[i] = count - 1 - i;
+  }
+  g_freeCount = count;
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)config->port);
+  if (inet_pton(AF_INET, config->bindAddress, &addr.sin_addr) != 1) {
+    fprintf(stderr, "Invalid ingest bind address %s.\n", config->bindAddress);
+    return -1;
+  }
+
+  g_listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (g_listenFd < 0) {
+    perror("Error creating ingest socket");
+    return -1;
+  }
+  int one = 1;
+  setsockopt(g_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (bind(g_listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(g_listenFd, count) != 0) {
+    fprintf(stderr, "Error binding ingest socket %s:%d: %s\n",
+            config->bindAddress, config->port, strerror(errno));
+    close(g_listenFd);
+    g_listenFd = -1;
+    return -1;
+  }
+
+  g_retryFd = eventLoop_AddTimer(loop, retryTimerHandle, NULL);
+  if (g_retryFd < 0 ||
+      eventLoop_AddFd(loop, g_listenFd, EPOLLIN, acceptHandle, NULL) != 0) {
+    tcpIngest_Deinit();
+    return -1;
+  }
+  return 0;
+}
+
+int tcpIngest_Port(void) {
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  if (g_listenFd < 0 ||
+      getsockname(g_listenFd, (struct sockaddr *)&addr, &len) != 0) {
+    return -1;
+  }
+  return ntohs(addr.sin_port);
+}
+
+void tcpIngest_GetStats(tcpIngestStats_t *stats) { *stats = g_stats; }
+
+void tcpIngest_Deinit(void) {
+  for (int i = 0; g_conns && i < g_config.maxClients; i++) {
+    if (g_conns[i].fd >= 0) {
+      closeConn(&g_conns[i]);
+    }
+  }
+  g_pausedHead = NULL;
+
+  if (g_retryFd >= 0) {
+    eventLoop_RemoveFd(g_loop, g_retryFd);
+    close(g_retryFd);
+    g_retryFd = -1;
+  }
+  if (g_listenFd >= 0) {
+    eventLoop_RemoveFd(g_loop, g_listenFd);
+    close(g_listenFd);
+    g_listenFd = -1;
+  }
+}
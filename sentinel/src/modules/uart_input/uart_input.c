@@ -0,0 +1,306 @@
+#include "modules/uart_input.h"
+#include "modules/mem_pool.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define UART_REOPEN_MS 1000
+
+/* 端口运行状态 */
+typedef struct {
+  uartPortConfig_t config;
+  const uartFramer_t *framer;
+  int fd; // -1 表示未打开，由重新打开定时器重试
+  uint8_t *ring;
+  uint32_t head; // 累计字节数，取模后得到缓冲中的位置
+  uint32_t tail;
+  uint64_t rxNs; // 最近一次读取的时间
+  uartParser_t parser;
+  uartInputStats_t stats;
+} uartPort_t;
+
+static uartPort_t g_ports[UART_MAX_PORTS];
+static int g_portCount = 0;
+static eventLoop_t *g_loop = NULL;
+static int g_reopenTimerFd = -1;
+static uartFrameCallback_t g_callback = NULL;
+static void *g_userData = NULL;
+
+static const uartFramer_t *g_framers[UART_MAX_FRAMERS] = {
+    &uartFramer_Line, &uartFramer_Length, &uartFramer_Slip};
+static int g_framerCount = 3;
+
+static const struct {
+  int baud;
+  speed_t speed;
+} g_baudTable[] = {
+    {1200, B1200},       {2400, B2400},     {4800, B4800},
+    {9600, B9600},       {19200, B19200},   {38400, B38400},
+    {57600, B57600},     {115200, B115200}, {230400, B230400},
+    {460800, B460800},   {921600, B921600},
+};
+
+static uint64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int uartInput_RegisterFramer(const uartFramer_t *framer) {
+  if (!framer || !framer->name || !framer->feed ||
+      g_framerCount >= UART_MAX_FRAMERS ||
+      uartInput_FindFramer(framer->name)) {
+    return -1;
+  }
+  g_framers[g_framerCount++] = framer;
+  return 0;
+}
+
+const uartFramer_t *uartInput_FindFramer(const char *name) {
+  for (int i = 0; i < g_framerCount; i++) {
+    if (strcmp(g_framers[i]->name, name) == 0) {
+      return g_framers[i];
+    }
+  }
+  return NULL;
+}
+
+static void emitFrame(uartParser_t *parser, const uint8_t *data, int len) {
+  uartPort_t *port = (uartPort_t *)parser->context;
+  uartFrame_t frame = {.port = (int)(port - g_ports),
+                       .config = &port->config,
+                       .data = data,
+                       .len = len,
+                       .rxNs = port->rxNs};
+  g_callback(&frame, g_userData);
+}
+
+/*
+ * @brief 设置原始模式、波特率、数据位、校验位和停止位。
+ *        VMIN/VTIME 为0，read 立即返回已到达的字节
+ * */
+static int configureTermios(int fd, const uartPortConfig_t *config) {
+  speed_t speed = 0;
+  for (size_t i = 0; i < sizeof(g_baudTable) / sizeof(g_baudTable[0]); i++) {
+    if (g_baudTable[i].baud == config->baud) {
+      speed = g_baudTable[i].speed;
+    }
+  }
+  if (speed == 0) {
+    fprintf(stderr, "Unsupported baud rate %d on %s.\n", config->baud,
+            config->device);
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct termios tio;
+  if (tcgetattr(fd, &tio) != 0) {
+    fprintf(stderr, "Error reading %s attributes: %s\n", config->device,
+            strerror(errno));
+    return -1;
+  }
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, speed);
+  cfsetospeed(&tio, speed);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS);
+  tio.c_cflag |= config->dataBits == 7 ? CS7 : CS8;
+  if (config->parity != UART_PARITY_NONE) {
+    tio.c_cflag |= PARENB;
+    tio.c_iflag |= INPCK;
+    if (config->parity == UART_PARITY_ODD) {
+      tio.c_cflag |= PARODD;
+    }
+  }
+  if (config->stopBits == 2) {
+    tio.c_cflag |= CSTOPB;
+  }
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+
+  if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+    fprintf(stderr, "Error configuring %s: %s\n", config->device,
+            strerror(errno));
+    return -1;
+  }
+  tcflush(fd, TCIFLUSH);
+  return 0;
+}
+
+static void closePort(uartPort_t *port) {
+  eventLoop_RemoveFd(g_loop, port->fd);
+  close(port->fd);
+  port->fd = -1;
+  port->stats.open = false;
+}
+
+/*
+ * @brief 读入环形缓冲的空闲段，再把已用段依次交给分帧器。
+ *        一次事件最多读满一个环形缓冲，其余数据留到下一次事件
+ * */
+static void portReadHandle(int fd, uint32_t events, void *userData) {
+  uartPort_t *port = (uartPort_t *)userData;
+  if (port->fd != fd) {
+    return;
+  }
+
+  uint32_t size = (uint32_t)port->config.ringBytes;
+  uint32_t mask = size - 1;
+  uint32_t pos = port->tail & mask;
+  uint32_t room = size - (port->tail - port->head);
+  uint32_t first = size - pos < room ? size - pos : room;
+  struct iovec iov[2] = {{port->ring + pos, first},
+                         {port->ring, room - first}};
+
+  ssize_t n = readv(fd, iov, room > first ? 2 : 1);
+  if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+    return;
+  }
+  if (n <= 0) {
+    // 串口正常不会读到EOF，EOF和EIO说明设备已经消失（USB串口拔出）
+    fprintf(stderr, "UART %s read failed: %s\n", port->config.name,
+            n == 0 ? "end of file" : strerror(errno));
+    port->stats.readErrors++;
+    closePort(port);
+    return;
+  }
+  port->tail += (uint32_t)n;
+  port->stats.bytes += (unsigned long)n;
+  port->rxNs = nowNs();
+
+  while (port->head != port->tail) {
+    uint32_t start = port->head & mask;
+    uint32_t used = port->tail - port->head;
+    uint32_t chunk = size - start < used ? size - start : used;
+    port->framer->feed(&port->parser, port->ring + start, (int)chunk);
+    port->head += chunk;
+  }
+}
+
+static int openPort(uartPort_t *port) {
+  int fd = open(port->config.device,
+                O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  if (configureTermios(fd, &port->config) != 0 ||
+      eventLoop_AddFd(g_loop, fd, EPOLLIN, portReadHandle, port) != 0) {
+    int err = errno;
+    close(fd);
+    errno = err;
+    return -1;
+  }
+  port->fd = fd;
+  port->head = port->tail = 0;
+  port->parser.len = 0;
+  port->parser.state = 0;
+  port->parser.discarding = false;
+  port->stats.open = true;
+  return 0;
+}
+
+/* 每秒重新打开已关闭的端口 */
+static void reopenTimerHandle(int fd, uint32_t events, void *userData) {
+  eventLoop_AckTimer(fd);
+  for (int i = 0; i < g_portCount; i++) {
+    uartPort_t *port = &g_ports[i];
+    if (port->fd < 0 && openPort(port) == 0) {
+      port->stats.reopens++;
+      fprintf(stdout, "UART %s reopened.\n", port->config.name);
+    }
+  }
+}
+
+/*
+ * @brief 初始化模块
+ *
+ * @param loop: 共享的事件循环
+ *        callback: 帧回调（在事件循环线程中调用）
+ *
+ * @return 0 成功
+ * */
+int uartInput_Init(eventLoop_t *loop, uartFrameCallback_t callback,
+                   void *userData) {
+  if (!loop || !callback) {
+    return -1;
+  }
+
+  g_loop = loop;
+  g_callback = callback;
+  g_userData = userData;
+  g_portCount = 0;
+  g_reopenTimerFd = eventLoop_AddTimer(loop, reopenTimerHandle, NULL);
+  if (g_reopenTimerFd < 0) {
+    return -1;
+  }
+  uint64_t intervalNs = UART_REOPEN_MS * 1000000ULL;
+  return eventLoop_ArmTimer(g_reopenTimerFd, intervalNs, intervalNs);
+}
+
+int uartInput_AddPort(const uartPortConfig_t *config) {
+  if (!g_loop || !config || g_portCount >= UART_MAX_PORTS ||
+      config->maxFrame <= 0 || config->ringBytes <= 0 ||
+      (config->ringBytes & (config->ringBytes - 1)) != 0) {
+    return -1;
+  }
+  const uartFramer_t *framer = uartInput_FindFramer(config->framer);
+  if (!framer) {
+    fprintf(stderr, "Unknown UART framer %s.\n", config->framer);
+    return -1;
+  }
+  if (framer == &uartFramer_Length &&
+      (config->lengthBytes < 1 || config->lengthBytes > 2)) {
+    return -1;
+  }
+
+  uartPort_t *port = &g_ports[g_portCount];
+  memset(port, 0, sizeof(uartPort_t));
+  port->config = *config;
+  port->framer = framer;
+  port->fd = -1;
+  port->ring = (uint8_t *)memPool_Alloc(config->ringBytes);
+  port->parser.frame = (uint8_t *)memPool_Alloc(config->maxFrame);
+  if (!port->ring || !port->parser.frame) {
+    return -1;
+  }
+  port->parser.config = &port->config;
+  port->parser.stats = &port->stats;
+  port->parser.emit = emitFrame;
+  port->parser.context = port;
+
+  if (openPort(port) != 0) {
+    fprintf(stderr, "Error opening %s: %s\n", config->device,
+            strerror(errno));
+    return -1;
+  }
+  return g_portCount++;
+}
+
+int uartInput_PortCount(void) { return g_portCount; }
+
+int uartInput_GetStats(int port, uartInputStats_t *stats) {
+  if (port < 0 || port >= g_portCount) {
+    return -1;
+  }
+  *stats = g_ports[port].stats;
+  return 0;
+}
+
+void uartInput_Deinit(void) {
+  for (int i = 0; i < g_portCount; i++) {
+    if (g_ports[i].fd >= 0) {
+      closePort(&g_ports[i]);
+    }
+  }
+  g_portCount = 0;
+  if (g_reopenTimerFd >= 0) {
+    eventLoop_RemoveFd(g_loop, g_reopenTimerFd);
+    close(g_reopenTimerFd);
+    g_reopenTimerFd = -1;
+  }
+}
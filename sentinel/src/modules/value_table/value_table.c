@@ -0,0 +1,207 @@
+#include "modules/value_table.h"
+#include "modules/mem_pool.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define VALUE_READ_RETRIES 64
+
+/*
+ * @brief 创建最新值表
+ *
+ * @param table: 表
+ *        capacity: 最大表项数
+ *        shmName: POSIX共享内存名称（如 "/sentinel_values"），NULL或空表示
+ *                 只在进程内使用
+ *
+ * @return 0 成功
+ * */
+int valueTable_Init(valueTable_t *table, int capacity, const char *shmName) {
+  if (!table || capacity <= 0) {
+    return -1;
+  }
+
+  memset(table, 0, sizeof(valueTable_t));
+  table->bytes = sizeof(valueTableShm_t) + capacity * sizeof(valueEntry_t);
+
+  if (shmName && shmName[0] != '\0') {
+    snprintf(table->shmName, sizeof(table->shmName), "%s", shmName);
+    int fd = shm_open(shmName, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0 || ftruncate(fd, table->bytes) != 0) {
+      fprintf(stderr, "Error creating shared memory %s: %s\n", shmName,
+              strerror(errno));
+      if (fd >= 0) {
+        close(fd);
+      }
+      return -1;
+    }
+    void *addr = mmap(NULL, table->bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+      perror("Error mapping shared memory");
+      return -1;
+    }
+    table->shm = (valueTableShm_t *)addr;
+  } else {
+    table->shm = (valueTableShm_t *)memPool_Alloc(table->bytes);
+    if (table->shm == NULL) {
+      return -1;
+    }
+  }
+
+  memset(table->shm, 0, table->bytes);
+  table->shm->version = VALUE_TABLE_VERSION;
+  table->shm->capacity = capacity;
+  // magic 最后写入，读者看到magic时头部已经完整
+  __atomic_store_n(&table->shm->magic, VALUE_TABLE_MAGIC, __ATOMIC_RELEASE);
+  return 0;
+}
+
+/*
+ * @brief 只读映射其他进程创建的最新值表
+ *
+ * @return 0 成功
+ * */
+int valueTable_Attach(valueTable_t *table, const char *shmName) {
+  if (!table || !shmName) {
+    return -1;
+  }
+
+  memset(table, 0, sizeof(valueTable_t));
+  int fd = shm_open(shmName, O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+
+  valueTableShm_t header;
+  if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+      header.magic != VALUE_TABLE_MAGIC ||
+      header.version != VALUE_TABLE_VERSION) {
+    close(fd);
+    return -1;
+  }
+
+  table->bytes =
+      sizeof(valueTableShm_t) + header.capacity * sizeof(valueEntry_t);
+  void *addr = mmap(NULL, table->bytes, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return -1;
+  }
+  table->shm = (valueTableShm_t *)addr;
+  table->readOnly = true;
+  return 0;
+}
+
+int valueTable_Register(valueTable_t *table, const char *name) {
+  if (!table || !table->shm || table->readOnly || !name) {
+    return -1;
+  }
+
+  int index = valueTable_Find(table, name);
+  if (index >= 0) {
+    return index;
+  }
+  if (table->shm->count >= table->shm->capacity) {
+    fprintf(stderr, "Value table full, cannot register %s.\n", name);
+    return -1;
+  }
+
+  index = table->shm->count;
+  snprintf(table->shm->entries[index].name, VALUE_NAME_LEN, "%s", name);
+  __atomic_store_n(&table->shm->count, index + 1, __ATOMIC_RELEASE);
+  return index;
+}
+
+int valueTable_Find(const valueTable_t *table, const char *name) {
+  int count = valueTable_Count(table);
+  for (int i = 0; i < count; i++) {
+    if (strncmp(table->shm->entries[i].name, name, VALUE_NAME_LEN) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int valueTable_Count(const valueTable_t *table) {
+  if (!table || !table->shm) {
+    return 0;
+  }
+  return (int)__atomic_load_n(&table->shm->count, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * @brief 写入表项（seqlock写端）：seq 先变为奇数，写数据，再变为偶数。
+ *        写者从不等待读者，采样线程不会被本地接口阻塞
+ * */
+void valueTable_Write(valueTable_t *table, int index, double value,
+                      int64_t tsMs) {
+  if (!table || !table->shm || table->readOnly || index < 0 ||
+      index >= valueTable_Count(table)) {
+    return;
+  }
+
+  valueEntry_t *entry = &table->shm->entries[index];
+  uint32_t seq = __atomic_load_n(&entry->seq, __ATOMIC_RELAXED);
+  __atomic_store_n(&entry->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  entry->value = value;
+  entry->tsMs = tsMs;
+  entry->updates++;
+
+  __atomic_store_n(&entry->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * @brief 读取表项（seqlock读端）：不加锁，seq 前后一致且为偶数时
+ *        快照有效，否则重读；重试次数有上限，读者不会无限等待
+ *
+ * @return 0 成功，-1 表项不存在或写入过于频繁
+ * */
+int valueTable_Read(const valueTable_t *table, int index,
+                    valueSnapshot_t *snapshot) {
+  if (!snapshot || index < 0 || index >= valueTable_Count(table)) {
+    return -1;
+  }
+
+  const valueEntry_t *entry = &table->shm->entries[index];
+  for (int retry = 0; retry < VALUE_READ_RETRIES; retry++) {
+    uint32_t begin = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE);
+    if (begin & 1) {
+      continue;
+    }
+
+    snapshot->value = entry->value;
+    snapshot->tsMs = entry->tsMs;
+    snapshot->updates = entry->updates;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    if (__atomic_load_n(&entry->seq, __ATOMIC_RELAXED) == begin) {
+      memcpy(snapshot->name, entry->name, VALUE_NAME_LEN);
+      snapshot->name[VALUE_NAME_LEN - 1] = '\0';
+      return 0;
+    }
+  }
+  return -1;
+}
+
+void valueTable_Close(valueTable_t *table) {
+  if (!table || !table->shm) {
+    return;
+  }
+
+  if (table->readOnly || table->shmName[0] != '\0') {
+    munmap(table->shm, table->bytes);
+    if (!table->readOnly) {
+      shm_unlink(table->shmName);
+    }
+  } else {
+    memPool_Free(table->shm);
+  }
+  table->shm = NULL;
+}
@@ -0,0 +1,262 @@
+#include "modules/watchdog.h"
+#include <fcntl.h>
+#include <linux/watchdog.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+/* 线程运行状态，lastKickMs/idle/maxGapMs 由工作线程原子写入 */
+typedef struct {
+  char name[WATCHDOG_NAME_LEN];
+  int timeoutMs;
+  watchdogRestartCallback_t restart;
+  void *userData;
+  int64_t lastKickMs;
+  int idle;
+  int maxGapMs;
+  bool stalled; // 以下字段只由检查定时器在持有 g_lock 时访问
+  unsigned long stalls;
+  unsigned long restarts;
+} watchdogEntry_t;
+
+static watchdogEntry_t g_entries[WATCHDOG_MAX_THREADS];
+static int g_count = 0; // 发布新表项时原子写入
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool g_initialized = false;
+static watchdogConfig_t g_config;
+static eventLoop_t *g_loop = NULL;
+static int g_timerFd = -1;
+static int g_hwFd = -1;
+static bool g_fatal = false;
+static unsigned long g_hwFeeds = 0;
+
+static int64_t monotonicMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void checkTimerHandle(int fd, uint32_t events, void *userData) {
+  eventLoop_AckTimer(fd);
+  watchdog_Check(monotonicMs());
+}
+
+/*
+ * @brief 打开硬件看门狗，设置超时。打开后驱动开始计时，必须按间隔喂狗
+ *
+ * @return 0 成功
+ * */
+static int openHardware(void) {
+  g_hwFd = open(g_config.device, O_WRONLY | O_CLOEXEC);
+  if (g_hwFd < 0) {
+    perror("Error opening watchdog device");
+    return -1;
+  }
+
+  int timeout = g_config.hwTimeoutSec;
+  if (timeout > 0 && ioctl(g_hwFd, WDIOC_SETTIMEOUT, &timeout) != 0) {
+    fprintf(stderr, "Warning: cannot set watchdog timeout on %s.\n",
+            g_config.device);
+  }
+  if (ioctl(g_hwFd, WDIOC_GETTIMEOUT, &timeout) == 0 &&
+      timeout * 1000 <= g_config.checkIntervalMs) {
+    fprintf(stderr, "Warning: watchdog timeout %d s is shorter than the "
+                    "check interval.\n",
+            timeout);
+  }
+  return 0;
+}
+
+/*
+ * @brief 初始化看门狗
+ *
+ * @param config: 配置，device 为空时只检查线程心跳
+ *        loop: 运行检查定时器的事件循环
+ *
+ * @return 0 成功
+ * */
+int watchdog_Init(const watchdogConfig_t *config, eventLoop_t *loop) {
+  if (!config || !loop || config->checkIntervalMs <= 0) {
+    return -1;
+  }
+
+  g_config = *config;
+  g_loop = loop;
+  g_fatal = false;
+  g_hwFeeds = 0;
+  g_timerFd = eventLoop_AddTimer(loop, checkTimerHandle, NULL);
+  if (g_timerFd < 0) {
+    return -1;
+  }
+  uint64_t intervalNs = (uint64_t)g_config.checkIntervalMs * 1000000ULL;
+  eventLoop_ArmTimer(g_timerFd, intervalNs, intervalNs);
+
+  // 硬件看门狗不可用时仍然检查线程心跳
+  if (g_config.device[0] != '\0') {
+    openHardware();
+  }
+  g_initialized = true;
+  return 0;
+}
+
+int watchdog_Register(const char *name, int timeoutMs,
+                      watchdogRestartCallback_t restart, void *userData) {
+  if (!g_initialized || !name || timeoutMs <= 0) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&g_lock);
+  int id = g_count;
+  if (id >= WATCHDOG_MAX_THREADS) {
+    pthread_mutex_unlock(&g_lock);
+    fprintf(stderr, "Watchdog table full, %s not monitored.\n", name);
+    return -1;
+  }
+
+  watchdogEntry_t *entry = &g_entries[id];
+  memset(entry, 0, sizeof(watchdogEntry_t));
+  snprintf(entry->name, sizeof(entry->name), "%s", name);
+  entry->timeoutMs = timeoutMs;
+  entry->restart = restart;
+  entry->userData = userData;
+  entry->lastKickMs = monotonicMs();
+  __atomic_store_n(&g_count, id + 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&g_lock);
+  return id;
+}
+
+void watchdog_Kick(int id) {
+  if (id < 0 || id >= __atomic_load_n(&g_count, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+
+  watchdogEntry_t *entry = &g_entries[id];
+  int64_t now = monotonicMs();
+  int64_t last = __atomic_exchange_n(&entry->lastKickMs, now, __ATOMIC_RELAXED);
+  // 空闲等待的时长不计入心跳间隔
+  if (__atomic_exchange_n(&entry->idle, 0, __ATOMIC_RELAXED)) {
+    return;
+  }
+  int gap = (int)(now - last);
+  if (gap > __atomic_load_n(&entry->maxGapMs, __ATOMIC_RELAXED)) {
+    __atomic_store_n(&entry->maxGapMs, gap, __ATOMIC_RELAXED);
+  }
+}
+
+void watchdog_Idle(int id) {
+  if (id < 0 || id >= __atomic_load_n(&g_count, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  __atomic_store_n(&g_entries[id].idle, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * @brief 检查所有线程的心跳。停滞的线程报告一次，有重启回调且未超过
+ *        重启次数时重启；存在无法恢复的停滞线程时不再喂硬件看门狗
+ * */
+void watchdog_Check(int64_t nowMs) {
+  int restartIds[WATCHDOG_MAX_THREADS];
+  int restartCount = 0;
+  bool fatal = false;
+
+  pthread_mutex_lock(&g_lock);
+  int count = __atomic_load_n(&g_count, __ATOMIC_ACQUIRE);
+  for (int i = 0; i < count; i++) {
+    watchdogEntry_t *entry = &g_entries[i];
+    int64_t gap =
+        nowMs - __atomic_load_n(&entry->lastKickMs, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&entry->idle, __ATOMIC_RELAXED) ||
+        gap <= entry->timeoutMs) {
+      if (entry->stalled) {
+        fprintf(stderr, "Thread %s recovered.\n", entry->name);
+        entry->stalled = false;
+      }
+      continue;
+    }
+
+    if (!entry->stalled) {
+      entry->stalled = true;
+      entry->stalls++;
+      fprintf(stderr, "Thread %s stalled: no heartbeat for %lld ms.\n",
+              entry->name, (long long)gap);
+
+      if (entry->restart && entry->restarts < (unsigned)g_config.maxRestarts) {
+        entry->restarts++;
+        entry->stalled = false;
+        // 新线程从完整的超时时间开始计时
+        __atomic_store_n(&entry->lastKickMs, nowMs, __ATOMIC_RELAXED);
+        restartIds[restartCount++] = i;
+        continue;
+      }
+    }
+    fatal = true;
+  }
+
+  if (fatal && !g_fatal && g_hwFd >= 0) {
+    fprintf(stderr, "Unrecoverable thread stall, stop feeding %s.\n",
+            g_config.device);
+  }
+  g_fatal = fatal;
+  if (!fatal && g_hwFd >= 0 && write(g_hwFd, "\0", 1) == 1) {
+    g_hwFeeds++;
+  }
+  pthread_mutex_unlock(&g_lock);
+
+  // 回调可能创建线程，不在持有锁时调用
+  for (int i = 0; i < restartCount; i++) {
+    watchdogEntry_t *entry = &g_entries[restartIds[i]];
+    fprintf(stderr, "Restarting thread %s (%lu/%d).\n", entry->name,
+            entry->restarts, g_config.maxRestarts);
+    entry->restart(restartIds[i], entry->userData);
+  }
+}
+
+void watchdog_GetStats(watchdogStats_t *stats) {
+  memset(stats, 0, sizeof(watchdogStats_t));
+  int64_t now = monotonicMs();
+
+  pthread_mutex_lock(&g_lock);
+  stats->hardware = g_hwFd >= 0;
+  stats->fatal = g_fatal;
+  stats->hwFeeds = g_hwFeeds;
+  stats->threadCount = __atomic_load_n(&g_count, __ATOMIC_ACQUIRE);
+  for (int i = 0; i < stats->threadCount; i++) {
+    const watchdogEntry_t *entry = &g_entries[i];
+    watchdogThreadStats_t *out = &stats->threads[i];
+    memcpy(out->name, entry->name, sizeof(out->name));
+    out->timeoutMs = entry->timeoutMs;
+    out->sinceKickMs =
+        now - __atomic_load_n(&entry->lastKickMs, __ATOMIC_RELAXED);
+    out->maxGapMs = __atomic_load_n(&entry->maxGapMs, __ATOMIC_RELAXED);
+    out->idle = __atomic_load_n(&entry->idle, __ATOMIC_RELAXED);
+    out->stalled = entry->stalled;
+    out->stalls = entry->stalls;
+    out->restarts = entry->restarts;
+  }
+  pthread_mutex_unlock(&g_lock);
+}
+
+void watchdog_Deinit(void) {
+  if (g_timerFd >= 0) {
+    eventLoop_RemoveFd(g_loop, g_timerFd);
+    close(g_timerFd);
+    g_timerFd = -1;
+  }
+
+  // 写入 'V' 后关闭，支持 magic close 的驱动会停止计时
+  if (g_hwFd >= 0) {
+    if (write(g_hwFd, "V", 1) != 1) {
+      perror("Error disarming watchdog");
+    }
+    close(g_hwFd);
+    g_hwFd = -1;
+  }
+
+  pthread_mutex_lock(&g_lock);
+  __atomic_store_n(&g_count, 0, __ATOMIC_RELEASE);
+  g_initialized = false;
+  pthread_mutex_unlock(&g_lock);
+}
@@ -0,0 +1,984 @@
+#include "modules/ws_server.h"
+#include "modules/lock_profile.h"
+#include "modules/mem_pool.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WS_RECV_BYTES 1024   // 握手请求和客户端消息的接收缓冲
+#define WS_HEADER_MAX 10     // 服务端帧头最大长度（不加掩码）
+#define WS_WRAPPER_BYTES 96  // {"source":..,"t_ns":..,"data":} 外层
+#define WS_CONTROL_MAX 125   // 控制帧载荷上限
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+#define WS_OP_TEXT 0x1
+#define WS_OP_CLOSE 0x8
+#define WS_OP_PING 0x9
+#define WS_OP_PONG 0xA
+
+typedef enum {
+  WS_STATE_HTTP = 0, // 等待HTTP请求
+  WS_STATE_OPEN,     // 握手完成，接收推送
+  WS_STATE_CLOSING,  // 发送缓冲写完后断开
+} wsState_t;
+
+/* 客户端连接，head/tail 为发送缓冲的累计字节数 */
+typedef struct {
+  int fd; // -1 表示空闲
+  wsState_t state;
+  bool upgraded; // 已完成WebSocket握手
+  uint32_t mask; // 订阅的数据源
+  uint32_t head;
+  uint32_t tail;
+  uint8_t *sendRing;
+  char *recv; // WS_RECV_BYTES + 1，末尾留给'\0'
+  int recvLen;
+  bool wantWrite; // 已关注EPOLLOUT
+  int64_t stallNs; // 首次因发送缓冲满而丢帧的时间，写出数据后清零
+} wsClient_t;
+
+/* 采样线程提交、事件循环线程推送的消息 */
+typedef struct {
+  int sourceId;
+  int len;
+  int64_t tNs;
+  char *data;
+} wsMessage_t;
+
+static wsServerConfig_t g_config;
+static eventLoop_t *g_loop = NULL;
+static int g_listenFd = -1;
+static int g_notifyFd = -1;
+static wsClient_t *g_clients = NULL;
+static int *g_freeClients = NULL; // 空闲连接的下标栈
+static int g_freeCount = 0;
+static uint8_t *g_frame = NULL; // 组装推送帧
+static char g_sourceNames[WS_SERVER_MAX_SOURCES][WS_SERVER_SOURCE_NAME];
+static int g_sourceCount = 0;
+static int g_sourceSubs[WS_SERVER_MAX_SOURCES]; // 订阅者数（原子读写）
+static wsServerStats_t g_stats;
+
+// 消息队列：head 只由事件循环线程推进，生产者不会写入 head 所在的槽
+static pthread_mutex_t g_queueLock = PTHREAD_MUTEX_INITIALIZER;
+static wsMessage_t *g_queue = NULL;
+static uint64_t g_queueHead = 0;
+static uint64_t g_queueTail = 0;
+
+static int64_t monotonicNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* SHA-1，只用于计算 Sec-WebSocket-Accept */
+static uint32_t rol32(uint32_t x, int n) { return x << n | x >> (32 - n); }
+
+static void sha1Block(uint32_t state[5], const uint8_t block[64]) {
+  uint32_t w[80];
+  for (int i = 0; i < 16; i++) {
+    w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+           (uint32_t)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+  }
+  for (int i = 16; i < 80; i++) {
+    w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+  }
+
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+  uint32_t e = state[4];
+  for (int i = 0; i < 80; i++) {
+    uint32_t f, k;
+    if (i < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5A827999;
+    } else if (i < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ED9EBA1;
+    } else if (i < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8F1BBCDC;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xCA62C1D6;
+    }
+    uint32_t t = rol32(a, 5) + f + e + k + w[i];
+    e = d;
+    d = c;
+    c = rol32(b, 30);
+    b = a;
+    a = t;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+/* 输入不超过 119 字节（密钥加GUID为 24+36），两个块足够 */
+static void sha1(const uint8_t *data, int len, uint8_t digest[20]) {
+  uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476,
+                       0xC3D2E1F0};
+  uint8_t blocks[128];
+  memset(blocks, 0, sizeof(blocks));
+  memcpy(blocks, data, len);
+  blocks[len] = 0x80;
+  int total = len + 9 <= 64 ? 64 : 128;
+  uint64_t bits = (uint64_t)len * 8;
+  for (int i = 0; i < 8; i++) {
+    blocks[total - 1 - i] = (uint8_t)(bits >> (i * 8));
+  }
+  for (int i = 0; i < total; i += 64) {
+    sha1Block(state, blocks + i);
+  }
+  for (int i = 0; i < 20; i++) {
+    digest[i] = (uint8_t)(state[i / 4] >> (24 - (i % 4) * 8));
+  }
+}
+
+static int base64Encode(const uint8_t *data, int len, char *out) {
+  static const char table[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  int n = 0;
+  for (int i = 0; i < len; i += 3) {
+    uint32_t v = (uint32_t)data[i] << 16;
+    if (i + 1 < len) {
+      v |= (uint32_t)data[i + 1] << 8;
+    }
+    if (i + 2 < len) {
+      v |= data[i + 2];
+    }
+    out[n++] = table[v >> 18 & 63];
+    out[n++] = table[v >> 12 & 63];
+    out[n++] = i + 1 < len ? table[v >> 6 & 63] : '=';
+    out[n++] = i + 2 < len ? table[v & 63] : '=';
+  }
+  out[n] = '\0';
+  return n;
+}
+
+/* 写入服务端帧头（FIN置位、不加掩码），返回帧头长度 */
+static int frameHeader(uint8_t *out, int opcode, uint64_t len) {
+  out[0] = (uint8_t)(0x80 | opcode);
+  if (len < 126) {
+    out[1] = (uint8_t)len;
+    return 2;
+  }
+  if (len <= 0xFFFF) {
+    out[1] = 126;
+    out[2] = (uint8_t)(len >> 8);
+    out[3] = (uint8_t)len;
+    return 4;
+  }
+  out[1] = 127;
+  for (int i = 0; i < 8; i++) {
+    out[2 + i] = (uint8_t)(len >> (56 - i * 8));
+  }
+  return 10;
+}
+
+static uint32_t ringMask(void) {
+  return (uint32_t)g_config.sendBufferBytes - 1;
+}
+
+/* 修改订阅，同时维护各数据源的订阅者数 */
+static void setMask(wsClient_t *client, uint32_t mask) {
+  uint32_t changed = client->mask ^ mask;
+  for (int i = 0; changed && i < g_sourceCount; i++) {
+    if (changed & (1u << i)) {
+      __atomic_add_fetch(&g_sourceSubs[i], (mask & (1u << i)) ? 1 : -1,
+                         __ATOMIC_RELAXED);
+    }
+  }
+  client->mask = mask;
+}
+
+static void closeClient(wsClient_t *client) {
+  if (client->upgraded) {
+    setMask(client, 0);
+    g_stats.clients--;
+  }
+  eventLoop_RemoveFd(g_loop, client->fd);
+  close(client->fd);
+  client->fd = -1;
+  g_freeClients[g_freeCount++] = (int)(client - g_clients);
+  g_stats.closed++;
+}
+
+/* 放入发送缓冲，空间不足时不放入 */
+static bool enqueue(wsClient_t *client, const void *data, uint32_t len) {
+  uint32_t size = (uint32_t)g_config.sendBufferBytes;
+  if (size - (client->tail - client->head) < len) {
+    return false;
+  }
+  uint32_t pos = client->tail & ringMask();
+  uint32_t first = size - pos < len ? size - pos : len;
+  memcpy(client->sendRing + pos, data, first);
+  memcpy(client->sendRing, (const uint8_t *)data + first, len - first);
+  client->tail += len;
+  return true;
+}
+
+static bool sendFrame(wsClient_t *client, int opcode, const void *payload,
+                      int len) {
+  uint8_t header[WS_HEADER_MAX];
+  int headerLen = frameHeader(header, opcode, (uint64_t)len);
+  uint32_t size = (uint32_t)g_config.sendBufferBytes;
+  if (size - (client->tail - client->head) < (uint32_t)(headerLen + len)) {
+    return false;
+  }
+  enqueue(client, header, (uint32_t)headerLen);
+  enqueue(client, payload, (uint32_t)len);
+  return true;
+}
+
+/* 发送关闭帧后断开（状态码为大端两字节） */
+static void closeWith(wsClient_t *client, int code) {
+  uint8_t payload[2] = {(uint8_t)(code >> 8), (uint8_t)code};
+  if (client->state != WS_STATE_OPEN || !sendFrame(client, WS_OP_CLOSE,
+                                                   payload, 2)) {
+    closeClient(client);
+    return;
+  }
+  client->state = WS_STATE_CLOSING;
+}
+
+/*
+ * @brief 尽量写出发送缓冲，写不完时关注EPOLLOUT。关闭中的连接写完后断开
+ *
+ * @return 0 连接仍然有效
+ * */
+static int flushClient(wsClient_t *client) {
+  uint32_t size = (uint32_t)g_config.sendBufferBytes;
+  while (client->tail != client->head) {
+    uint32_t used = client->tail - client->head;
+    uint32_t pos = client->head & ringMask();
+    uint32_t first = size - pos < used ? size - pos : used;
+    struct iovec iov[2] = {{client->sendRing + pos, first},
+                           {client->sendRing, used - first}};
+    struct msghdr msg = {.msg_iov = iov, .msg_iovlen = used > first ? 2 : 1};
+    ssize_t n = sendmsg(client->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN) {
+        break;
+      }
+      closeClient(client);
+      return -1;
+    }
+    client->head += (uint32_t)n;
+    client->stallNs = 0;
+    g_stats.bytesSent += (unsigned long)n;
+  }
+
+  bool pending = client->tail != client->head;
+  if (!pending && client->state == WS_STATE_CLOSING) {
+    closeClient(client);
+    return -1;
+  }
+  if (pending != client->wantWrite) {
+    eventLoop_ModifyFd(g_loop, client->fd, EPOLLIN | (pending ? EPOLLOUT : 0));
+    client->wantWrite = pending;
+  }
+  return 0;
+}
+
+static int findSource(const char *name, int len) {
+  for (int i = 0; i < g_sourceCount; i++) {
+    if ((int)strlen(g_sourceNames[i]) == len &&
+        memcmp(g_sourceNames[i], name, len) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*
+ * @brief 解析逗号分隔的数据源列表，"*" 表示全部
+ *
+ * @return 0 成功，-1 有未知的数据源
+ * */
+static int parseSources(const char *list, int len, uint32_t *mask) {
+  *mask = 0;
+  const char *end = list + len;
+  while (list < end) {
+    const char *comma = memchr(list, ',', end - list);
+    const char *next = comma ? comma : end;
+    while (list < next && *list == ' ') {
+      list++;
+    }
+    int nameLen = (int)(next - list);
+    while (nameLen > 0 && list[nameLen - 1] == ' ') {
+      nameLen--;
+    }
+    if (nameLen == 1 && *list == '*') {
+      *mask = (1u << g_sourceCount) - 1;
+    } else if (nameLen > 0) {
+      int id = findSource(list, nameLen);
+      if (id < 0) {
+        return -1;
+      }
+      *mask |= 1u << id;
+    }
+    list = comma ? comma + 1 : end;
+  }
+  return 0;
+}
+
+/* 按订阅格式化数据源列表：{"<key>":["a","b"]} */
+static int formatSources(char *out, int size, const char *key, uint32_t mask) {
+  int len = snprintf(out, size, "{\"%s\":[", key);
+  for (int i = 0; i < g_sourceCount && len < size; i++) {
+    if (mask & (1u << i)) {
+      len += snprintf(out + len, size - len, "%s\"%s\"",
+                      out[len - 1] == '[' ? "" : ",", g_sourceNames[i]);
+    }
+  }
+  if (len < size) {
+    len += snprintf(out + len, size - len, "]}");
+  }
+  return len < size ? len : size - 1;
+}
+
+/* 回复HTTP响应后断开，headers 为附加的头字段（每行以"\r\n"结尾） */
+static void httpRespond(wsClient_t *client, const char *status,
+                        const char *headers, const char *body) {
+  char response[512];
+  int len = snprintf(response, sizeof(response),
+                     "HTTP/1.1 %s\r\n%sContent-Type: %s\r\n"
+                     "Content-Length: %zu\r\nConnection: close\r\n\r\n%s",
+                     status, headers,
+                     body[0] == '{' ? "application/json" : "text/plain",
+                     strlen(body), body);
+  if (len >= (int)sizeof(response) ||
+      !enqueue(client, response, (uint32_t)len)) {
+    closeClient(client);
+    return;
+  }
+  client->state = WS_STATE_CLOSING;
+}
+
+/* 在请求头中查找字段（名称不区分大小写），值以"\r\n"结尾 */
+static const char *headerValue(const char *request, const char *name,
+                               int *len) {
+  int nameLen = (int)strlen(name);
+  const char *line = strstr(request, "\r\n");
+  while (line && line[2] != '\0') {
+    line += 2;
+    const char *end = strstr(line, "\r\n");
+    if (!end) {
+      return NULL;
+    }
+    if (end - line > nameLen && line[nameLen] == ':' &&
+        strncasecmp(line, name, nameLen) == 0) {
+      const char *value = line + nameLen + 1;
+      while (value < end && (*value == ' ' || *value == '\t')) {
+        value++;
+      }
+      *len = (int)(end - value);
+      while (*len > 0 && (value[*len - 1] == ' ' || value[*len - 1] == '\t')) {
+        (*len)--;
+      }
+      return value;
+    }
+    line = end;
+  }
+  return NULL;
+}
+
+/* 逗号分隔的头字段值中是否包含 token（不区分大小写） */
+static bool headerHasToken(const char *value, int len, const char *token) {
+  int tokenLen = (int)strlen(token);
+  for (int i = 0; i + tokenLen <= len; i++) {
+    if (strncasecmp(value + i, token, tokenLen) == 0 &&
+        (i == 0 || value[i - 1] == ' ' || value[i - 1] == ',') &&
+        (i + tokenLen == len || value[i + tokenLen] == ' ' ||
+         value[i + tokenLen] == ',')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void handshakeFail(wsClient_t *client, const char *status,
+                          const char *body) {
+  g_stats.rejected++;
+  httpRespond(client, status, "", body);
+}
+
+/*
+ * @brief 检查握手的 Origin：不带 Origin 的（非浏览器客户端）放行，浏览器
+ *        页面发起的必须在 allowedOrigins 中（"*" 表示全部）。网关自身不提供
+ *        页面，因此不按 Host 判断同源，避免 DNS 重绑定绕过
+ * */
+static bool originAllowed(const char *request) {
+  int originLen = 0;
+  const char *origin = headerValue(request, "Origin", &originLen);
+  if (!origin) {
+    return true;
+  }
+  const char *entry = g_config.allowedOrigins;
+  while (*entry) {
+    while (*entry == ' ' || *entry == ',') {
+      entry++;
+    }
+    int entryLen = (int)strcspn(entry, ", ");
+    if ((entryLen == 1 && entry[0] == '*') ||
+        (entryLen > 0 && entryLen == originLen &&
+         strncasecmp(entry, origin, originLen) == 0)) {
+      return true;
+    }
+    entry += entryLen;
+  }
+  return false;
+}
+
+/*
+ * @brief 处理HTTP请求：GET /sources 返回数据源列表，GET /live 升级为
+ *        WebSocket，其他请求返回404
+ * */
+static void handleRequest(wsClient_t *client, const char *request) {
+  if (strncmp(request, "GET ", 4) != 0) {
+    handshakeFail(client, "405 Method Not Allowed", "GET only\n");
+    return;
+  }
+  const char *path = request + 4;
+  const char *pathEnd = strchr(path, ' ');
+  if (!pathEnd) {
+    handshakeFail(client, "400 Bad Request", "bad request line\n");
+    return;
+  }
+  const char *query = memchr(path, '?', pathEnd - path);
+  int pathLen = (int)((query ? query : pathEnd) - path);
+
+  if (pathLen == 8 && memcmp(path, "/sources", 8) == 0) {
+    char body[WS_SERVER_MAX_SOURCES * (WS_SERVER_SOURCE_NAME + 3) + 16];
+    formatSources(body, sizeof(body), "sources", UINT32_MAX);
+    httpRespond(client, "200 OK", "", body);
+    return;
+  }
+  if (pathLen != 5 || memcmp(path, "/live", 5) != 0) {
+    handshakeFail(client, "404 Not Found", "not found\n");
+    return;
+  }
+
+  int upgradeLen = 0, connectionLen = 0, versionLen = 0, keyLen = 0;
+  const char *upgrade = headerValue(request, "Upgrade", &upgradeLen);
+  const char *connection = headerValue(request, "Connection", &connectionLen);
+  const char *version =
+      headerValue(request, "Sec-WebSocket-Version", &versionLen);
+  const char *key = headerValue(request, "Sec-WebSocket-Key", &keyLen);
+  if (!upgrade || !headerHasToken(upgrade, upgradeLen, "websocket") ||
+      !connection || !headerHasToken(connection, connectionLen, "upgrade") ||
+      !key || keyLen != 24) {
+    handshakeFail(client, "400 Bad Request", "websocket upgrade required\n");
+    return;
+  }
+  if (!version || versionLen != 2 || memcmp(version, "13", 2) != 0) {
+    // RFC 6455 4.4：在响应头中给出支持的版本
+    g_stats.rejected++;
+    httpRespond(client, "426 Upgrade Required",
+                "Sec-WebSocket-Version: 13\r\n",
+                "unsupported websocket version\n");
+    return;
+  }
+  if (!originAllowed(request)) {
+    handshakeFail(client, "403 Forbidden", "origin not allowed\n");
+    return;
+  }
+
+  // ?sources=a,b 为初始订阅，也可以握手后用 subscribe 消息订阅
+  uint32_t mask = 0;
+  const char *param = query ? strstr(query, "sources=") : NULL;
+  if (param && param < pathEnd) {
+    param += 8;
+    const char *paramEnd = memchr(param, '&', pathEnd - param);
+    if (parseSources(param, (int)((paramEnd ? paramEnd : pathEnd) - param),
+                     &mask) != 0) {
+      handshakeFail(client, "404 Not Found", "unknown source\n");
+      return;
+    }
+  }
+
+  uint8_t accept[60 + 1], digest[20];
+  memcpy(accept, key, 24);
+  memcpy(accept + 24, WS_GUID, 36);
+  sha1(accept, 60, digest);
+  char acceptKey[32];
+  base64Encode(digest, 20, acceptKey);
+
+  char response[256];
+  int len = snprintf(response, sizeof(response),
+                     "HTTP/1.1 101 Switching Protocols\r\n"
+                     "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: %s\r\n\r\n",
+                     acceptKey);
+  if (!enqueue(client, response, (uint32_t)len)) {
+    closeClient(client);
+    return;
+  }
+  client->state = WS_STATE_OPEN;
+  client->upgraded = true;
+  g_stats.clients++;
+  setMask(client, mask);
+}
+
+/* 处理客户端文本消息：subscribe / unsubscribe，回复当前订阅 */
+static void handleText(wsClient_t *client, const char *text, int len) {
+  bool subscribe = len >= 10 && memcmp(text, "subscribe ", 10) == 0;
+  bool unsubscribe = len >= 12 && memcmp(text, "unsubscribe ", 12) == 0;
+  char reply[WS_SERVER_MAX_SOURCES * (WS_SERVER_SOURCE_NAME + 3) + 16];
+  int replyLen;
+  uint32_t mask;
+  if (!subscribe && !unsubscribe) {
+    replyLen = snprintf(reply, sizeof(reply),
+                        "{\"error\":\"expected subscribe or unsubscribe\"}");
+  } else if (parseSources(text + (subscribe ? 10 : 12),
+                          len - (subscribe ? 10 : 12), &mask) != 0) {
+    replyLen = snprintf(reply, sizeof(reply),
+                        "{\"error\":\"unknown source\"}");
+  } else {
+    setMask(client, subscribe ? client->mask | mask : client->mask & ~mask);
+    replyLen = formatSources(reply, sizeof(reply), "subscribed", client->mask);
+  }
+  if (!sendFrame(client, WS_OP_TEXT, reply, replyLen)) {
+    g_stats.frameDrops++;
+  }
+}
+
+/*
+ * @brief 解析接收缓冲中的完整帧。客户端帧必须加掩码，不支持分片，
+ *        消息不能超过接收缓冲
+ *
+ * @return 0 连接仍然有效
+ * */
+static int processFrames(wsClient_t *client) {
+  uint8_t *buf = (uint8_t *)client->recv;
+  while (client->state == WS_STATE_OPEN && client->recvLen >= 2) {
+    bool fin = buf[0] & 0x80;
+    int opcode = buf[0] & 0x0F;
+    bool masked = buf[1] & 0x80;
+    uint32_t len = buf[1] & 0x7F;
+    int headerLen = 2;
+    if (len == 126) {
+      if (client->recvLen < 4) {
+        break;
+      }
+      len = (uint32_t)buf[2] << 8 | buf[3];
+      headerLen = 4;
+    } else if (len == 127) {
+      closeWith(client, 1009);
+      return 0;
+    }
+    if (!masked || (opcode >= WS_OP_CLOSE && len > WS_CONTROL_MAX)) {
+      closeWith(client, 1002);
+      return 0;
+    }
+    headerLen += 4;
+    if (headerLen + len > WS_RECV_BYTES) {
+      closeWith(client, 1009);
+      return 0;
+    }
+    if ((uint32_t)client->recvLen < headerLen + len) {
+      break;
+    }
+
+    uint8_t *key = buf + headerLen - 4;
+    uint8_t *payload = buf + headerLen;
+    for (uint32_t i = 0; i < len; i++) {
+      payload[i] ^= key[i & 3];
+    }
+    if (!fin || opcode == 0) {
+      closeWith(client, 1003);
+      return 0;
+    }
+    if (opcode == WS_OP_TEXT) {
+      handleText(client, (const char *)payload, (int)len);
+    } else if (opcode == WS_OP_CLOSE) {
+      closeWith(client, len >= 2 ? payload[0] << 8 | payload[1] : 1000);
+      return 0;
+    } else if (opcode == WS_OP_PING) {
+      if (!sendFrame(client, WS_OP_PONG, payload, (int)len)) {
+        g_stats.frameDrops++;
+      }
+    } else if (opcode != WS_OP_PONG) {
+      closeWith(client, 1003);
+      return 0;
+    }
+
+    int consumed = headerLen + (int)len;
+    client->recvLen -= consumed;
+    memmove(buf, buf + consumed, client->recvLen);
+  }
+  return 0;
+}
+
+static void clientHandle(int fd, uint32_t events, void *userData) {
+  wsClient_t *client = (wsClient_t *)userData;
+  if (client->fd != fd) {
+    return;
+  }
+  if ((events & EPOLLOUT) && flushClient(client) != 0) {
+    return;
+  }
+  if (!(events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+    return;
+  }
+
+  int room = WS_RECV_BYTES - client->recvLen;
+  ssize_t n = room ? recv(fd, client->recv + client->recvLen, room, 0) : 0;
+  if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+    return;
+  }
+  if (n <= 0) {
+    // 对端关闭，或请求/消息超过接收缓冲
+    if (client->state == WS_STATE_HTTP && room == 0) {
+      handshakeFail(client, "431 Request Header Fields Too Large", "\n");
+      if (client->fd == fd) {
+        flushClient(client);
+      }
+    } else {
+      closeClient(client);
+    }
+    return;
+  }
+  if (client->state == WS_STATE_CLOSING) {
+    client->recvLen = 0; // 等待发送完成，丢弃后续数据
+    return;
+  }
+  client->recvLen += (int)n;
+
+  if (client->state == WS_STATE_HTTP) {
+    client->recv[client->recvLen] = '\0';
+    char *end = strstr(client->recv, "\r\n\r\n");
+    if (!end) {
+      return;
+    }
+    int requestLen = (int)(end + 4 - client->recv);
+    end[2] = '\0'; // 保留最后一个头字段的"\r\n"
+    handleRequest(client, client->recv);
+    if (client->fd != fd) {
+      return;
+    }
+    client->recvLen -= requestLen;
+    memmove(client->recv, client->recv + requestLen, client->recvLen);
+  }
+  processFrames(client);
+  if (client->fd == fd) {
+    flushClient(client);
+  }
+}
+
+static void acceptHandle(int fd, uint32_t events, void *userData) {
+  int clientFd;
+  while ((clientFd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >=
+         0) {
+    if (g_freeCount == 0) {
+      g_stats.rejected++;
+      close(clientFd);
+      continue;
+    }
+
+    wsClient_t *client = &g_clients[g_freeClients[g_freeCount - 1]];
+    if (eventLoop_AddFd(g_loop, clientFd, EPOLLIN, clientHandle, client) !=
+        0) {
+      g_stats.rejected++;
+      close(clientFd);
+      continue;
+    }
+    g_freeCount--;
+
+    // 推送的帧都很小，不等待合并
+    int one = 1;
+    setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    client->fd = clientFd;
+    client->state = WS_STATE_HTTP;
+    client->upgraded = false;
+    client->mask = 0;
+    client->head = 0;
+    client->tail = 0;
+    client->recvLen = 0;
+    client->wantWrite = false;
+    client->stallNs = 0;
+    g_stats.accepted++;
+  }
+}
+
+/*
+ * @brief 把一条消息放入所有订阅者的发送缓冲。帧只组装一次；缓冲放不下的
+ *        客户端丢弃这一帧，持续放不下超过 stallTimeoutMs 时断开
+ * */
+static void fanOut(const wsMessage_t *msg, int64_t nowNs) {
+  uint8_t *body = g_frame + WS_HEADER_MAX;
+  int len = snprintf((char *)body, WS_WRAPPER_BYTES,
+                     "{\"source\":\"%s\",\"t_ns\":%lld,\"data\":",
+                     g_sourceNames[msg->sourceId], (long long)msg->tNs);
+  memcpy(body + len, msg->data, msg->len);
+  len += msg->len;
+  body[len++] = '}';
+  uint8_t header[WS_HEADER_MAX];
+  int headerLen = frameHeader(header, WS_OP_TEXT, (uint64_t)len);
+  uint8_t *frame = body - headerLen;
+  memcpy(frame, header, headerLen);
+  uint32_t frameLen = (uint32_t)(headerLen + len);
+
+  uint32_t bit = 1u << msg->sourceId;
+  int64_t stallNs = (int64_t)g_config.stallTimeoutMs * 1000000;
+  for (int i = 0; i < g_config.maxClients; i++) {
+    wsClient_t *client = &g_clients[i];
+    if (client->fd < 0 || client->state != WS_STATE_OPEN ||
+        !(client->mask & bit)) {
+      continue;
+    }
+    if (enqueue(client, frame, frameLen)) {
+      g_stats.frames++;
+      continue;
+    }
+    g_stats.frameDrops++;
+    if (client->stallNs == 0) {
+      client->stallNs = nowNs;
+    } else if (nowNs - client->stallNs > stallNs) {
+      g_stats.slowClosed++;
+      closeClient(client);
+    }
+  }
+
+  uint64_t latencyUs = (uint64_t)(monotonicNs() - msg->tNs) / 1000;
+  g_stats.fanoutTotalUs += latencyUs;
+  if (latencyUs > g_stats.fanoutMaxUs) {
+    g_stats.fanoutMaxUs = latencyUs;
+  }
+}
+
+/* 取出队列中的消息逐条推送，最后统一写出各客户端的发送缓冲 */
+static void notifyHandle(int fd, uint32_t events, void *userData) {
+  uint64_t count;
+  if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+    return;
+  }
+
+  int64_t nowNs = monotonicNs();
+  for (int i = 0; i < g_config.queueSlots; i++) {
+    PROFILED_LOCK(&g_queueLock);
+    bool empty = g_queue == NULL || g_queueHead == g_queueTail;
+    const wsMessage_t *msg = &g_queue[g_queueHead % g_config.queueSlots];
+    lockProfile_Unlock(&g_queueLock);
+    if (empty) {
+      break;
+    }
+    fanOut(msg, nowNs);
+    PROFILED_LOCK(&g_queueLock);
+    g_queueHead++;
+    lockProfile_Unlock(&g_queueLock);
+  }
+
+  // 队列在本轮中没有取完时再次唤醒，避免一直占用事件循环
+  PROFILED_LOCK(&g_queueLock);
+  bool more = g_queueHead != g_queueTail;
+  lockProfile_Unlock(&g_queueLock);
+  if (more) {
+    count = 1;
+    write(fd, &count, sizeof(count));
+  }
+
+  for (int i = 0; i < g_config.maxClients; i++) {
+    wsClient_t *client = &g_clients[i];
+    if (client->fd >= 0 && !client->wantWrite &&
+        client->tail != client->head) {
+      flushClient(client);
+    }
+  }
+}
+
+int wsServer_RegisterSource(const char *name) {
+  if (name == NULL || name[0] == '\0' ||
+      strlen(name) >= WS_SERVER_SOURCE_NAME) {
+    return -1;
+  }
+  int id = findSource(name, (int)strlen(name));
+  if (id >= 0) {
+    return id;
+  }
+  if (g_sourceCount == WS_SERVER_MAX_SOURCES) {
+    return -1;
+  }
+  snprintf(g_sourceNames[g_sourceCount], WS_SERVER_SOURCE_NAME, "%s", name);
+  return g_sourceCount++;
+}
+
+void wsServer_Publish(int sourceId, const char *payload, int len) {
+  if (sourceId < 0 || sourceId >= g_sourceCount || payload == NULL ||
+      __atomic_load_n(&g_sourceSubs[sourceId], __ATOMIC_RELAXED) == 0) {
+    return;
+  }
+
+  int64_t tNs = monotonicNs();
+  PROFILED_LOCK(&g_queueLock);
+  if (g_queue == NULL) {
+    // 已停止
+  } else if (len > g_config.maxMessageBytes) {
+    g_stats.oversized++;
+  } else if (g_queueTail - g_queueHead == (uint64_t)g_config.queueSlots) {
+    g_stats.queueDrops++;
+  } else {
+    wsMessage_t *msg = &g_queue[g_queueTail % g_config.queueSlots];
+    msg->sourceId = sourceId;
+    msg->len = len;
+    msg->tNs = tNs;
+    memcpy(msg->data, payload, len);
+    g_queueTail++;
+    g_stats.published++;
+    // 队列由空变为非空时唤醒事件循环；在锁内写入，避免与停止竞争
+    if (g_queueTail - g_queueHead == 1) {
+      uint64_t one = 1;
+      write(g_notifyFd, &one, sizeof(one));
+    }
+  }
+  lockProfile_Unlock(&g_queueLock);
+}
+
+/*
+ * @brief 预分配连接表、发送缓冲和消息队列，创建监听套接字并注册到事件循环
+ *
+ * @param config: 配置
+ *        loop: 共享的事件循环
+ *
+ * @return 0 成功
+ * */
+int wsServer_Init(const wsServerConfig_t *config, eventLoop_t *loop) {
+  if (!config || !loop || config->maxClients <= 0 ||
+      config->queueSlots <= 0 || config->maxMessageBytes <= 0 ||
+      (config->sendBufferBytes & (config->sendBufferBytes - 1)) != 0 ||
+      config->sendBufferBytes <
+          WS_HEADER_MAX + WS_WRAPPER_BYTES + config->maxMessageBytes ||
+      config->sendBufferBytes < 1024) {
+    return -1;
+  }
+
+  g_config = *config;
+  g_loop = loop;
+  memset(&g_stats, 0, sizeof(g_stats));
+  memset(g_sourceSubs, 0, sizeof(g_sourceSubs));
+  g_stats.bytesPerClient =
+      (int)sizeof(wsClient_t) + config->sendBufferBytes + WS_RECV_BYTES + 1;
+
+  // 所有缓冲在启动时一次性分配
+  int count = config->maxClients;
+  g_clients = (wsClient_t *)memPool_Alloc(count * sizeof(wsClient_t));
+  g_freeClients = (int *)memPool_Alloc(count * sizeof(int));
+  uint8_t *rings =
+      (uint8_t *)memPool_Alloc((size_t)count * config->sendBufferBytes);
+  char *recvs = (char *)memPool_Alloc((size_t)count * (WS_RECV_BYTES + 1));
+  g_frame = (uint8_t *)memPool_Alloc(WS_HEADER_MAX + WS_WRAPPER_BYTES +
+                                     config->maxMessageBytes + 1);
+  wsMessage_t *queue =
+      (wsMessage_t *)memPool_Alloc(config->queueSlots * sizeof(wsMessage_t));
+  char *data = (char *)memPool_Alloc((size_t)config->queueSlots *
+                                     config->maxMessageBytes);
+  if (!g_clients || !g_freeClients || !rings || !recvs || !g_frame ||
+      !queue || !data) {
+    return -1;
+  }
+  for (int i = 0; i < count; i++) {
+    memset(&g_clients[i], 0, sizeof(wsClient_t));
+    g_clients[i].fd = -1;
+    g_clients[i].sendRing = rings + (size_t)i * config->sendBufferBytes;
+    g_clients[i].recv = recvs + (size_t)i * (WS_RECV_BYTES + 1);
+    g_freeClients[i] = count - 1 - i;
+  }
+  g_freeCount = count;
+  for (int i = 0; i < config->queueSlots; i++) {
+    queue[i].data = data + (size_t)i * config->maxMessageBytes;
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)config->port);
+  if (inet_pton(AF_INET, config->bindAddress, &addr.sin_addr) != 1) {
+    fprintf(stderr, "Invalid WebSocket bind address %s.\n",
+            config->bindAddress);
+    return -1;
+  }
+
+  g_listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (g_listenFd < 0) {
+    perror("Error creating WebSocket socket");
+    return -1;
+  }
+  int one = 1;
+  setsockopt(g_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (bind(g_listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(g_listenFd, count) != 0) {
+    fprintf(stderr, "Error binding WebSocket socket %s:%d: %s\n",
+            config->bindAddress, config->port, strerror(errno));
+    close(g_listenFd);
+    g_listenFd = -1;
+    return -1;
+  }
+
+  g_notifyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (g_notifyFd < 0 ||
+      eventLoop_AddFd(loop, g_notifyFd, EPOLLIN, notifyHandle, NULL) != 0 ||
+      eventLoop_AddFd(loop, g_listenFd, EPOLLIN, acceptHandle, NULL) != 0) {
+    wsServer_Deinit();
+    return -1;
+  }
+
+  PROFILED_LOCK(&g_queueLock);
+  g_queue = queue;
+  g_queueHead = 0;
+  g_queueTail = 0;
+  lockProfile_Unlock(&g_queueLock);
+  return 0;
+}
+
+int wsServer_Port(void) {
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  if (g_listenFd < 0 ||
+      getsockname(g_listenFd, (struct sockaddr *)&addr, &len) != 0) {
+    return -1;
+  }
+  return ntohs(addr.sin_port);
+}
+
+void wsServer_GetStats(wsServerStats_t *stats) {
+  PROFILED_LOCK(&g_queueLock);
+  *stats = g_stats;
+  lockProfile_Unlock(&g_queueLock);
+}
+
+void wsServer_Deinit(void) {
+  // 先停止接收消息，采样线程可能仍在调用 wsServer_Publish
+  PROFILED_LOCK(&g_queueLock);
+  g_queue = NULL;
+  lockProfile_Unlock(&g_queueLock);
+
+  for (int i = 0; g_clients && i < g_config.maxClients; i++) {
+    if (g_clients[i].fd >= 0) {
+      closeClient(&g_clients[i]);
+    }
+  }
+  if (g_notifyFd >= 0) {
+    eventLoop_RemoveFd(g_loop, g_notifyFd);
+    close(g_notifyFd);
+    g_notifyFd = -1;
+  }
+  if (g_listenFd >= 0) {
+    eventLoop_RemoveFd(g_loop, g_listenFd);
+    close(g_listenFd);
+    g_listenFd = -1;
+  }
+}
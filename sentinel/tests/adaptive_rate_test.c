@@ -0,0 +1,319 @@
+#include "../include/modules/adaptive_rate.h"
+#include "test_check.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * 自适应采样在虚拟时间上回放几段光照曲线：稳定的夜间、开灯的阶跃、飘过的
+ * 云和缓慢的日出。每段曲线分别用控制器和固定1 Hz采样，比较采样数和平均
+ * 跟踪误差（最后一个采样保持到下一个采样，与曲线的差）。另外检查CPU预算
+ * 对采样间隔的缩放。
+ *
+ * ./adaptive_rate_test trace.csv 回放设备上记录的曲线，每行 "t_ms,value"
+ * */
+/* 与 sentinel_config.json 中光照的默认配置一致 */
+static const adaptiveRateConfig_t g_lightConfig = {
+    .minHz = 0.2,
+    .maxHz = 5,
+    .window = 8,
+    .changeThreshold = 50,
+    .stdThreshold = 20,
+    .decay = 0.8,
+};
+static const adaptiveRateConfig_t g_fixedConfig = {
+    .minHz = 1, .maxHz = 1, .window = 2, .decay = 1};
+
+#define TRACE_STEP_MS 10
+
+typedef struct {
+  int64_t *times;
+  double *values;
+  int count;
+} trace_t;
+
+typedef struct {
+  unsigned long samples;
+  double meanError;
+  double peakHz;
+} replayResult_t;
+
+static unsigned int g_seed = 12345;
+
+/* 确定性的噪声，幅度 ±amplitude */
+static double noise(double amplitude) {
+  g_seed = g_seed * 1103515245 + 12345;
+  return amplitude * (((g_seed >> 16) & 0x7fff) / 16383.5 - 1.0);
+}
+
+static void traceAlloc(trace_t *trace, int64_t durationMs) {
+  trace->count = (int)(durationMs / TRACE_STEP_MS);
+  trace->times = malloc(sizeof(int64_t) * trace->count);
+  trace->values = malloc(sizeof(double) * trace->count);
+  for (int i = 0; i < trace->count; i++) {
+    trace->times[i] = (int64_t)i * TRACE_STEP_MS;
+  }
+}
+
+static void traceFree(trace_t *trace) {
+  free(trace->times);
+  free(trace->values);
+}
+
+/*
+ * 按控制器给出的间隔采样，误差为每个轨迹点与最近一次采样值之差的平均值。
+ * fromMs 之前的样本用于建立基线，不计入统计
+ */
+static replayResult_t replay(const trace_t *trace,
+                             const adaptiveRateConfig_t *config,
+                             const adaptiveBudget_t *budget, int64_t fromMs) {
+  adaptiveRate_t rate;
+  replayResult_t result = {0};
+  adaptiveRate_Init(&rate, config, budget);
+
+  int64_t nextMs = trace->times[0];
+  double held = trace->values[0];
+  double errorSum = 0;
+  int errorCount = 0;
+  for (int i = 0; i < trace->count; i++) {
+    int64_t t = trace->times[i];
+    if (t >= nextMs) {
+      held = trace->values[i];
+      adaptiveRate_OnSample(&rate, held, t);
+      nextMs = t + adaptiveRate_IntervalMs(&rate);
+      if (t >= fromMs) {
+        result.samples++;
+        double hz = adaptiveRate_EffectiveHz(&rate);
+        result.peakHz = hz > result.peakHz ? hz : result.peakHz;
+      }
+    }
+    if (t >= fromMs) {
+      errorSum += fabs(trace->values[i] - held);
+      errorCount++;
+    }
+  }
+  result.meanError = errorCount ? errorSum / errorCount : 0;
+  return result;
+}
+
+static void report(const char *name, const trace_t *trace, int64_t fromMs,
+                   replayResult_t *adaptive, replayResult_t *fixed) {
+  *adaptive = replay(trace, &g_lightConfig, NULL, fromMs);
+  *fixed = replay(trace, &g_fixedConfig, NULL, fromMs);
+  printf("%-8s adaptive %4lu samples, error %6.2f lux, peak %.2f Hz | "
+         "1 Hz %4lu samples, error %6.2f lux\n",
+         name, adaptive->samples, adaptive->meanError, adaptive->peakHz,
+         fixed->samples, fixed->meanError);
+}
+
+static void testConfig(void) {
+  adaptiveRate_t rate;
+  adaptiveRateConfig_t config = g_lightConfig;
+  CHECK(adaptiveRate_Init(&rate, &config, NULL) == 0);
+  CHECK(adaptiveRate_EffectiveHz(&rate) == config.maxHz);
+  CHECK(adaptiveRate_IntervalMs(&rate) == 200);
+
+  config.minHz = 0;
+  CHECK(adaptiveRate_Init(&rate, &config, NULL) == -1);
+  config = g_lightConfig;
+  config.maxHz = 0.1;
+  CHECK(adaptiveRate_Init(&rate, &config, NULL) == -1);
+  config = g_lightConfig;
+  config.window = ADAPTIVE_RATE_WINDOW + 1;
+  CHECK(adaptiveRate_Init(&rate, &config, NULL) == -1);
+  config = g_lightConfig;
+  config.decay = 1.5;
+  CHECK(adaptiveRate_Init(&rate, &config, NULL) == -1);
+}
+
+/* 夜间：5 lux 附近的小噪声，采样率应降到 minHz */
+static void testStableNight(void) {
+  trace_t trace;
+  traceAlloc(&trace, 600 * 1000);
+  for (int i = 0; i < trace.count; i++) {
+    trace.values[i] = 5 + noise(1);
+  }
+
+  replayResult_t adaptive, fixed;
+  report("night", &trace, 60 * 1000, &adaptive, &fixed);
+  CHECK(adaptive.samples * 4 < fixed.samples);
+  CHECK(adaptive.meanError < 2);
+  traceFree(&trace);
+}
+
+/* 开灯：5 lux 跳变到 500 lux，检测后立即升到 maxHz，之后逐步回落 */
+static void testLightSwitch(void) {
+  trace_t trace;
+  traceAlloc(&trace, 180 * 1000);
+  for (int i = 0; i < trace.count; i++) {
+    trace.values[i] = (trace.times[i] < 60 * 1000 ? 5 : 500) + noise(1);
+  }
+
+  adaptiveRate_t rate;
+  adaptiveRate_Init(&rate, &g_lightConfig, NULL);
+  int64_t nextMs = 0;
+  int64_t detectedMs = -1;
+  int64_t settledMs = -1;
+  for (int i = 0; i < trace.count; i++) {
+    int64_t t = trace.times[i];
+    if (t < nextMs) {
+      continue;
+    }
+    adaptiveRate_OnSample(&rate, trace.values[i], t);
+    nextMs = t + adaptiveRate_IntervalMs(&rate);
+    double hz = adaptiveRate_EffectiveHz(&rate);
+    if (t == 59 * 1000) {
+      CHECK(hz < 0.3);
+    }
+    if (t >= 60 * 1000 && detectedMs < 0 && hz == g_lightConfig.maxHz) {
+      detectedMs = t;
+    }
+    if (detectedMs >= 0 && settledMs < 0 && hz < 0.3) {
+      settledMs = t;
+    }
+  }
+  printf("switch   detected after %lld ms, back below 0.3 Hz after %lld ms\n",
+         (long long)(detectedMs - 60 * 1000),
+         (long long)(settledMs - detectedMs));
+  // 平稳时最长采样间隔为 1/minHz
+  CHECK(detectedMs >= 60 * 1000 && detectedMs <= 65 * 1000);
+  CHECK(settledMs > detectedMs && settledMs - detectedMs < 60 * 1000);
+  traceFree(&trace);
+}
+
+/* 云层经过：周期10秒、幅度200 lux的波动，采样率应提高并减小跟踪误差 */
+static void testPassingCloud(void) {
+  trace_t trace;
+  traceAlloc(&trace, 120 * 1000);
+  for (int i = 0; i < trace.count; i++) {
+    double t = trace.times[i] / 1000.0;
+    trace.values[i] = 600 + 200 * sin(2 * M_PI * t / 10) + noise(5);
+  }
+
+  replayResult_t adaptive, fixed;
+  report("cloud", &trace, 10 * 1000, &adaptive, &fixed);
+  CHECK(adaptive.peakHz == g_lightConfig.maxHz);
+  CHECK(adaptive.meanError < fixed.meanError);
+  traceFree(&trace);
+}
+
+/* 日出：10分钟内从 0 线性升到 1000 lux（约1.7 lux/秒），保持低采样率 */
+static void testDawnRamp(void) {
+  trace_t trace;
+  traceAlloc(&trace, 600 * 1000);
+  for (int i = 0; i < trace.count; i++) {
+    trace.values[i] = trace.times[i] / 600.0 + noise(1);
+  }
+
+  replayResult_t adaptive, fixed;
+  report("dawn", &trace, 60 * 1000, &adaptive, &fixed);
+  CHECK(adaptive.samples * 2 < fixed.samples);
+  CHECK(adaptive.meanError < 10);
+  traceFree(&trace);
+}
+
+/* CPU预算：超出上限时按比例降低，采样率不低于 minHz；恢复时逐步回升 */
+static void testBudget(void) {
+  adaptiveBudget_t budget;
+  adaptiveRate_BudgetInit(&budget, 20);
+  CHECK(adaptiveRate_BudgetScale(&budget) == 1);
+
+  adaptiveRate_t rate;
+  adaptiveRate_Init(&rate, &g_lightConfig, &budget);
+  CHECK(adaptiveRate_EffectiveHz(&rate) == 5);
+
+  adaptiveRate_UpdateBudget(&budget, 40);
+  CHECK(adaptiveRate_BudgetScale(&budget) == 0.5);
+  CHECK(adaptiveRate_EffectiveHz(&rate) == 2.5);
+
+  for (int i = 0; i < 10; i++) {
+    adaptiveRate_UpdateBudget(&budget, 80);
+  }
+  CHECK(adaptiveRate_BudgetScale(&budget) == budget.minScale);
+  CHECK(fabs(adaptiveRate_EffectiveHz(&rate) - 5 * budget.minScale) < 1e-9);
+  rate.rateHz = 1;
+  CHECK(adaptiveRate_EffectiveHz(&rate) == g_lightConfig.minHz);
+  rate.rateHz = g_lightConfig.maxHz;
+
+  int steps = 0;
+  while (adaptiveRate_BudgetScale(&budget) < 1 && steps < 100) {
+    adaptiveRate_UpdateBudget(&budget, 10);
+    steps++;
+  }
+  CHECK(steps > 5 && steps < 20);
+
+  // 不限制时缩放系数保持不变
+  adaptiveRate_BudgetInit(&budget, 0);
+  adaptiveRate_UpdateBudget(&budget, 90);
+  CHECK(adaptiveRate_BudgetScale(&budget) == 1);
+
+  // 预算限制下回放云层轨迹：样本数随缩放系数减少
+  trace_t trace;
+  traceAlloc(&trace, 60 * 1000);
+  for (int i = 0; i < trace.count; i++) {
+    double t = trace.times[i] / 1000.0;
+    trace.values[i] = 600 + 200 * sin(2 * M_PI * t / 10);
+  }
+  adaptiveRate_BudgetInit(&budget, 20);
+  replayResult_t full = replay(&trace, &g_lightConfig, &budget, 0);
+  adaptiveRate_UpdateBudget(&budget, 80);
+  replayResult_t throttled = replay(&trace, &g_lightConfig, &budget, 0);
+  printf("budget   cloud samples %lu -> %lu at scale %.2f\n", full.samples,
+         throttled.samples, adaptiveRate_BudgetScale(&budget));
+  CHECK(throttled.samples * 3 < full.samples);
+  traceFree(&trace);
+}
+
+/* 回放记录的轨迹（每行 "t_ms,value"），只输出对比结果 */
+static int replayCsv(const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    perror(path);
+    return -1;
+  }
+
+  trace_t trace = {0};
+  int capacity = 0;
+  long long t;
+  double value;
+  char line[128];
+  while (fgets(line, sizeof(line), fp)) {
+    if (sscanf(line, "%lld,%lf", &t, &value) != 2) {
+      continue;
+    }
+    if (trace.count == capacity) {
+      capacity = capacity ? capacity * 2 : 1024;
+      trace.times = realloc(trace.times, sizeof(int64_t) * capacity);
+      trace.values = realloc(trace.values, sizeof(double) * capacity);
+    }
+    trace.times[trace.count] = t;
+    trace.values[trace.count] = value;
+    trace.count++;
+  }
+  fclose(fp);
+
+  if (trace.count == 0) {
+    fprintf(stderr, "%s: no samples\n", path);
+    return -1;
+  }
+  replayResult_t adaptive, fixed;
+  report("trace", &trace, trace.times[0], &adaptive, &fixed);
+  traceFree(&trace);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    return replayCsv(argv[1]) == 0 ? 0 : 1;
+  }
+
+  testConfig();
+  testStableNight();
+  testLightSwitch();
+  testPassingCloud();
+  testDawnRamp();
+  testBudget();
+
+  return testReport("adaptive_rate_test");
+}
@@ -0,0 +1,1033 @@
+#include "../include/modules/broker_group.h"
+#include "../include/modules/mem_pool.h"
+#include "cJSON/cJSON.h"
+#include "test_check.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * 多Broker的切换和扇出，对着本地的Broker替身运行，以及发送调度：上行变慢
+ * 时控制消息绕过批量消息的洪流，批量数据源按权重分享链路，只保留最新值的
+ * 数据源被合并，限速的类别保持设定的速率。第一次连接还未完成时积压的消息
+ * 在暂停后导出，由新的Broker组重新入队后发出。扇出模式下两条链路同时收到
+ * 命令，各自解析到自己的 arena 中；两条链路同时报告的连接变化逐个、按顺序
+ * 交给上层。Broker拒绝的消息直接丢弃，暂时性错误重试有限次数后丢弃。
+ *
+ * 替身是按行计数消息的TCP监听，mqttClient_* 由下面的按行客户端代替，只测
+ * Broker组本身（探测、切换、每个Broker的队列）。Paho头文件只用到类型，不
+ * 链接Paho库
+ * */
+#define MESSAGE_COUNT 2000
+#define MESSAGE_INTERVAL_US 1000
+
+static int64_t nowMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* ---------------- 本地Broker替身 ---------------- */
+
+typedef struct {
+  int port;
+  int listenFd;
+  volatile bool running;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  int clientFds[8];
+  int clientCount;
+  unsigned char seen[MESSAGE_COUNT]; // 按序号记录收到的消息
+  int received;
+  int64_t firstMs; // 首条消息到达时间
+} standIn_t;
+
+static void *standInThread(void *arg) {
+  standIn_t *b = (standIn_t *)arg;
+  char buffer[4096];
+  int lens[8] = {0};
+  char lines[8][256];
+
+  while (b->running) {
+    struct pollfd pfds[9];
+    int n = 0;
+    pfds[n++] = (struct pollfd){b->listenFd, POLLIN, 0};
+    pthread_mutex_lock(&b->lock);
+    for (int i = 0; i < b->clientCount; i++) {
+      pfds[n++] = (struct pollfd){b->clientFds[i], POLLIN, 0};
+    }
+    pthread_mutex_unlock(&b->lock);
+    if (poll(pfds, n, 20) <= 0) {
+      continue;
+    }
+
+    if (pfds[0].revents & POLLIN) {
+      int fd = accept(b->listenFd, NULL, NULL);
+      pthread_mutex_lock(&b->lock);
+      if (fd >= 0 && b->clientCount < 8) {
+        lens[b->clientCount] = 0;
+        b->clientFds[b->clientCount++] = fd;
+      } else if (fd >= 0) {
+        close(fd);
+      }
+      pthread_mutex_unlock(&b->lock);
+    }
+
+    for (int i = n - 1; i >= 1; i--) {
+      if (!(pfds[i].revents & (POLLIN | POLLHUP))) {
+        continue;
+      }
+      ssize_t len = read(pfds[i].fd, buffer, sizeof(buffer));
+      if (len <= 0) {
+        // 健康探测或客户端断开，移除该连接（倒序遍历，下标不受影响）
+        int c = i - 1;
+        pthread_mutex_lock(&b->lock);
+        close(b->clientFds[c]);
+        b->clientCount--;
+        b->clientFds[c] = b->clientFds[b->clientCount];
+        lens[c] = lens[b->clientCount];
+        memcpy(lines[c], lines[b->clientCount], lens[c]);
+        pthread_mutex_unlock(&b->lock);
+        continue;
+      }
+      for (ssize_t k = 0; k < len; k++) {
+        int c = i - 1;
+        if (buffer[k] != '\n') {
+          if (lens[c] < 255) {
+            lines[c][lens[c]++] = buffer[k];
+          }
+          continue;
+        }
+        lines[c][lens[c]] = '\0';
+        lens[c] = 0;
+        const char *seq = strstr(lines[c], "seq=");
+        if (seq) {
+          int id = atoi(seq + 4);
+          pthread_mutex_lock(&b->lock);
+          if (id >= 0 && id < MESSAGE_COUNT && !b->seen[id]) {
+            b->seen[id] = 1;
+            if (b->received++ == 0) {
+              b->firstMs = nowMs();
+            }
+          }
+          pthread_mutex_unlock(&b->lock);
+        }
+      }
+    }
+  }
+  return NULL;
+}
+
+static void standInStart(standIn_t *b, int port) {
+  b->listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  int on = 1;
+  setsockopt(b->listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  struct sockaddr_in addr = {0};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  bind(b->listenFd, (struct sockaddr *)&addr, sizeof(addr));
+  listen(b->listenFd, 16);
+  socklen_t len = sizeof(addr);
+  getsockname(b->listenFd, (struct sockaddr *)&addr, &len);
+  b->port = ntohs(addr.sin_port);
+  b->clientCount = 0;
+  b->running = true;
+  pthread_mutex_init(&b->lock, NULL);
+  pthread_create(&b->thread, NULL, standInThread, b);
+}
+
+/* 模拟Broker进程被杀：监听套接字和所有连接立即关闭 */
+static void standInKill(standIn_t *b) {
+  b->running = false;
+  pthread_join(b->thread, NULL);
+  close(b->listenFd);
+  for (int i = 0; i < b->clientCount; i++) {
+    close(b->clientFds[i]);
+  }
+  b->clientCount = 0;
+}
+
+/* 向所有连接发送一行（下行命令） */
+static void standInSend(standIn_t *b, const char *line) {
+  int len = strlen(line);
+  pthread_mutex_lock(&b->lock);
+  for (int i = 0; i < b->clientCount; i++) {
+    send(b->clientFds[i], line, len, MSG_NOSIGNAL);
+  }
+  pthread_mutex_unlock(&b->lock);
+}
+
+/* ---------------- 替代 mqtt_client.c 的行协议客户端 ---------------- */
+
+typedef struct {
+  mqttClientContext_t *ctx;
+  int port;
+  int fd;
+} fakeConn_t;
+
+static fakeConn_t g_conns[BROKER_GROUP_MAX * 2];
+static int g_connCount = 0;
+static volatile int g_publishDelayUs = 0; // 模拟慢速上行链路
+// 发布到 g_failTopic 时返回 g_failReason，并统计尝试次数
+static const char *g_failTopic = NULL;
+static int g_failReason = MQTTCLIENT_SUCCESS;
+static volatile int g_failAttempts = 0;
+
+static fakeConn_t *connOf(mqttClientContext_t *ctx) {
+  for (int i = 0; i < g_connCount; i++) {
+    if (g_conns[i].ctx == ctx) {
+      return &g_conns[i];
+    }
+  }
+  return NULL;
+}
+
+static void setConnected(mqttClientContext_t *ctx, bool connected) {
+  __atomic_store_n(&ctx->isConnected, connected, __ATOMIC_RELEASE);
+  if (ctx->onConnStatusCb) {
+    ctx->onConnStatusCb(connected, ctx->onConnStatusUserData);
+  }
+}
+
+static void *fakeClientThread(void *arg) {
+  mqttClientContext_t *ctx = (mqttClientContext_t *)arg;
+  fakeConn_t *conn = connOf(ctx);
+  char line[512];
+  int lineLen = 0;
+
+  while (!ctx->shouldExit) {
+    if (!mqttClient_IsConnected(ctx)) {
+      int fd = socket(AF_INET, SOCK_STREAM, 0);
+      struct sockaddr_in addr = {0};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      addr.sin_port = htons(conn->port);
+      if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        pthread_mutex_lock(&ctx->lock);
+        conn->fd = fd;
+        pthread_mutex_unlock(&ctx->lock);
+        setConnected(ctx, true);
+      } else {
+        close(fd);
+        usleep(50 * 1000); // reconnectDelay
+      }
+      continue;
+    }
+
+    // 与paho的接收线程一样，对端关闭时立即报告连接丢失，
+    // 收到的每一行作为命令消息交给命令回调
+    struct pollfd pfd = {conn->fd, POLLIN, 0};
+    char buffer[1024];
+    ssize_t len = 0;
+    if (poll(&pfd, 1, 20) == 1 &&
+        (len = recv(conn->fd, buffer, sizeof(buffer), 0)) <= 0) {
+      pthread_mutex_lock(&ctx->lock);
+      close(conn->fd);
+      conn->fd = -1;
+      pthread_mutex_unlock(&ctx->lock);
+      setConnected(ctx, false);
+      lineLen = 0;
+      continue;
+    }
+    for (ssize_t k = 0; k < len; k++) {
+      if (buffer[k] != '\n') {
+        if (lineLen < (int)sizeof(line) - 1) {
+          line[lineLen++] = buffer[k];
+        }
+        continue;
+      }
+      line[lineLen] = '\0';
+      if (ctx->onCommandCb) {
+        ctx->onCommandCb("sentinel/test/cmd", line, lineLen,
+                         ctx->onCommandUserData);
+      }
+      lineLen = 0;
+    }
+  }
+  return NULL;
+}
+
+int mqttClient_Init(mqttClientContext_t *ctx,
+                    const mqttClientConfig_t *config) {
+  memset(ctx, 0, sizeof(mqttClientContext_t));
+  ctx->config = *config;
+  ctx->config.brokerAddress = strdup(config->brokerAddress);
+  pthread_mutex_init(&ctx->lock, NULL);
+  fakeConn_t *conn = &g_conns[g_connCount++];
+  conn->ctx = ctx;
+  conn->port = atoi(strrchr(config->brokerAddress, ':') + 1);
+  conn->fd = -1;
+  return 0;
+}
+
+void mqttClient_RegisterCommandCallback(mqttClientContext_t *ctx,
+                                        mqttOnCommandCallback_t callback,
+                                        void *userData) {
+  ctx->onCommandCb = callback;
+  ctx->onCommandUserData = userData;
+}
+
+void mqttClient_RegisterConnectionStatusCallback(
+    mqttClientContext_t *ctx, mqttOnConnectionStatusCallback_t callback,
+    void *userData) {
+  ctx->onConnStatusCb = callback;
+  ctx->onConnStatusUserData = userData;
+}
+
+void mqttClient_SetLWT(mqttClientContext_t *ctx, const char *topic,
+                       const char *payload, int qos) {}
+
+int mqttClient_AddSubscription(mqttClientContext_t *ctx, const char *topic,
+                               int qos) {
+  return 0;
+}
+
+int mqttClient_Start(mqttClientContext_t *ctx) {
+  if (ctx->threadRunning) {
+    return 0;
+  }
+  ctx->shouldExit = false;
+  ctx->threadRunning = true;
+  return pthread_create(&ctx->reconnectThread, NULL, fakeClientThread, ctx);
+}
+
+void mqttClient_Disconnect(mqttClientContext_t *ctx) {
+  ctx->shouldExit = true;
+  if (ctx->threadRunning) {
+    pthread_join(ctx->reconnectThread, NULL);
+    ctx->threadRunning = false;
+  }
+  fakeConn_t *conn = connOf(ctx);
+  if (mqttClient_IsConnected(ctx)) {
+    close(conn->fd);
+    conn->fd = -1;
+    setConnected(ctx, false);
+  }
+}
+
+void mqttClient_Stop(mqttClientContext_t *ctx) {
+  mqttClient_Disconnect(ctx);
+  free(ctx->config.brokerAddress);
+}
+
+int mqttClient_PublishWithOptions(mqttClientContext_t *ctx, const char *topic,
+                                  const char *payload, int payloadLen, int qos,
+                                  bool retained,
+                                  const mqttPublishOptions_t *options,
+                                  int *reasonCode) {
+  fakeConn_t *conn = connOf(ctx);
+  if (g_publishDelayUs > 0) {
+    usleep(g_publishDelayUs);
+  }
+  if (g_failTopic && strcmp(topic, g_failTopic) == 0) {
+    g_failAttempts++;
+    *reasonCode = g_failReason;
+    return -1;
+  }
+  char line[512];
+  int len = snprintf(line, sizeof(line), "%s %.*s\n", topic, payloadLen,
+                     payload);
+  pthread_mutex_lock(&ctx->lock);
+  int rc = -1;
+  if (conn->fd >= 0 && send(conn->fd, line, len, MSG_NOSIGNAL) == len) {
+    rc = 0;
+  }
+  pthread_mutex_unlock(&ctx->lock);
+  if (reasonCode) {
+    *reasonCode = rc == 0 ? MQTTCLIENT_SUCCESS : MQTTCLIENT_DISCONNECTED;
+  }
+  return rc;
+}
+
+bool mqttClient_IsConnected(const mqttClientContext_t *ctx) {
+  return __atomic_load_n(&ctx->isConnected, __ATOMIC_ACQUIRE);
+}
+
+int mqttClient_ConnectTimeoutMs(const mqttClientContext_t *ctx) {
+  return 1000;
+}
+
+void mqttClient_GetConnectStats(const mqttClientContext_t *ctx,
+                                mqttConnectStats_t *stats) {
+  memset(stats, 0, sizeof(mqttConnectStats_t));
+}
+
+void mqttClient_GetPublishStats(const mqttClientContext_t *ctx,
+                                mqttPublishStats_t *stats) {
+  memset(stats, 0, sizeof(mqttPublishStats_t));
+}
+
+/* ---------------- 测试 ---------------- */
+
+static volatile int g_groupConnected = 0;
+
+static void groupStatusHandle(bool isConnected, void *userData) {
+  g_groupConnected = isConnected;
+}
+
+static bool waitFor(volatile int *flag, int value, int timeoutMs) {
+  int64_t deadline = nowMs() + timeoutMs;
+  while (*flag != value && nowMs() < deadline) {
+    usleep(1000);
+  }
+  return *flag == value;
+}
+
+static void publishSeqWithOptions(brokerGroup_t *group, int seq,
+                                  const mqttPublishOptions_t *options) {
+  char payload[64];
+  int len = snprintf(payload, sizeof(payload), "{\"seq=%d\"}", seq);
+  brokerGroup_Publish(group, BROKER_SOURCE_DEFAULT, "sentinel/test/status",
+                      payload, len, 1, false, options);
+}
+
+static void publishSeq(brokerGroup_t *group, int seq) {
+  publishSeqWithOptions(group, seq, NULL);
+}
+
+static brokerClassConfig_t g_classes[BROKER_CLASS_COUNT]; // 默认全部为0
+
+static void groupConfig(brokerGroupConfig_t *config, brokerMode_t mode,
+                        standIn_t *brokers, int count, char addresses[][64]) {
+  *config = (brokerGroupConfig_t){
+      .mode = mode,
+      .brokerCount = count,
+      .probeIntervalMs = 200,
+      .probeTimeoutMs = 100,
+      .probeFailThreshold = 2,
+      .switchTimeoutMs = 2000,
+      .queueDepth = 64,
+      .queueSlotBytes = 256,
+  };
+  memcpy(config->classes, g_classes, sizeof(g_classes));
+  for (int i = 0; i < count; i++) {
+    snprintf(addresses[i], 64, "tcp://127.0.0.1:%d", brokers[i].port);
+    config->brokerAddresses[i] = addresses[i];
+  }
+}
+
+static void initGroup(brokerGroup_t *group, brokerMode_t mode,
+                      standIn_t *brokers, int count, char addresses[][64]) {
+  brokerGroupConfig_t config;
+  groupConfig(&config, mode, brokers, count, addresses);
+  mqttClientConfig_t clientConfig = {.clientID = "test"};
+  g_connCount = 0;
+  g_groupConnected = 0;
+  CHECK(brokerGroup_Init(group, &config, &clientConfig) == 0);
+  brokerGroup_RegisterConnectionStatusCallback(group, groupStatusHandle, NULL);
+  CHECK(brokerGroup_Start(group) == 0);
+  CHECK(waitFor(&g_groupConnected, 1, 2000));
+}
+
+/* 1. 故障切换：以1kHz持续发布，杀掉当前Broker，统计切换时间和丢失 */
+static void testFailover(void) {
+  static standIn_t brokers[3];
+  char addresses[3][64];
+  memset(brokers, 0, sizeof(brokers));
+  for (int i = 0; i < 3; i++) {
+    standInStart(&brokers[i], 0);
+  }
+
+  brokerGroup_t group;
+  initGroup(&group, BROKER_MODE_FAILOVER, brokers, 3, addresses);
+  usleep(300 * 1000); // 让备用Broker完成首轮探测
+
+  int64_t killMs = 0;
+  for (int seq = 0; seq < MESSAGE_COUNT; seq++) {
+    if (seq == MESSAGE_COUNT / 2) {
+      standInKill(&brokers[0]);
+      killMs = nowMs();
+    }
+    publishSeq(&group, seq);
+    usleep(MESSAGE_INTERVAL_US);
+  }
+  usleep(300 * 1000); // 等待队列排空
+
+  brokerGroupStats_t stats;
+  brokerGroup_GetStats(&group, &stats);
+  int lost = 0;
+  for (int seq = 0; seq < MESSAGE_COUNT; seq++) {
+    if (!brokers[0].seen[seq] && !brokers[1].seen[seq] &&
+        !brokers[2].seen[seq]) {
+      lost++;
+    }
+  }
+  printf("failover: active %d, failovers %lu, switch %d ms, first message on "
+         "standby %lld ms after kill, lost %d/%d, queue high water %d\n",
+         stats.active, stats.failovers, stats.lastFailoverMs,
+         (long long)(brokers[1].firstMs - killMs), lost, MESSAGE_COUNT,
+         stats.outboxes[0].highWater);
+
+  CHECK(stats.active == 1);
+  CHECK(stats.failovers == 1);
+  CHECK(stats.lastFailoverMs < 500);
+  CHECK(brokers[2].received == 0);
+  CHECK(stats.outboxes[0].dropped == 0);
+  // 只有写入已关闭连接、尚未检测到断开的少量消息会丢失
+  CHECK(lost <= 5);
+
+  brokerGroup_Stop(&group);
+  standInKill(&brokers[1]);
+  standInKill(&brokers[2]);
+}
+
+/* 2. 扇出：一个Broker宕机只影响它自己的队列，恢复后补发队列中的消息 */
+static void testFanout(void) {
+  static standIn_t brokers[2];
+  char addresses[2][64];
+  memset(brokers, 0, sizeof(brokers));
+  for (int i = 0; i < 2; i++) {
+    standInStart(&brokers[i], 0);
+  }
+
+  brokerGroup_t group;
+  initGroup(&group, BROKER_MODE_FANOUT, brokers, 2, addresses);
+  usleep(100 * 1000);
+
+  int port = brokers[1].port;
+  int64_t start = nowMs();
+  for (int seq = 0; seq < MESSAGE_COUNT; seq++) {
+    if (seq == MESSAGE_COUNT / 4) {
+      standInKill(&brokers[1]);
+    }
+    publishSeq(&group, seq);
+    usleep(MESSAGE_INTERVAL_US / 4);
+  }
+  int64_t elapsed = nowMs() - start;
+  usleep(200 * 1000);
+  CHECK(brokers[0].received == MESSAGE_COUNT);
+
+  // 恢复后，队列中最后 queueDepth 条消息被补发
+  memset(brokers[1].seen, 0, sizeof(brokers[1].seen));
+  brokers[1].received = 0;
+  standInStart(&brokers[1], port);
+  usleep(500 * 1000);
+
+  brokerGroupStats_t stats;
+  brokerGroup_GetStats(&group, &stats);
+  printf("fanout: %d messages in %lld ms, broker0 %d, broker1 replayed %d, "
+         "outbox1 dropped %lu, high water %d\n",
+         MESSAGE_COUNT, (long long)elapsed, brokers[0].received,
+         brokers[1].received, stats.outboxes[1].dropped,
+         stats.outboxes[1].highWater);
+
+  CHECK(stats.outboxes[0].dropped == 0);
+  CHECK(stats.outboxes[1].dropped > 0);
+  CHECK(stats.outboxes[1].highWater == 64);
+  CHECK(brokers[1].received >= 64);
+  CHECK(brokers[1].seen[MESSAGE_COUNT - 1]);
+  CHECK(stats.outboxes[1].queued == 0);
+
+  brokerGroup_Stop(&group);
+  standInKill(&brokers[0]);
+  standInKill(&brokers[1]);
+}
+
+/* 3. 消息过期：断线期间积压的消息过期后不再发送 */
+static void testExpiry(void) {
+  static standIn_t brokers[1];
+  char addresses[1][64];
+  memset(brokers, 0, sizeof(brokers));
+  standInStart(&brokers[0], 0);
+
+  brokerGroup_t group;
+  initGroup(&group, BROKER_MODE_FAILOVER, brokers, 1, addresses);
+  int port = brokers[0].port;
+  standInKill(&brokers[0]);
+  usleep(100 * 1000);
+
+  mqttPublishOptions_t options = {.messageExpirySec = 1};
+  for (int seq = 0; seq < 10; seq++) {
+    publishSeqWithOptions(&group, seq, &options);
+  }
+  usleep(1200 * 1000);
+  for (int seq = 10; seq < 20; seq++) {
+    publishSeqWithOptions(&group, seq, &options);
+  }
+  standInStart(&brokers[0], port);
+  usleep(500 * 1000);
+
+  brokerGroupStats_t stats;
+  brokerGroup_GetStats(&group, &stats);
+  printf("expiry: delivered %d, expired %lu\n", brokers[0].received,
+         stats.outboxes[0].expired);
+  CHECK(stats.outboxes[0].expired == 10);
+  CHECK(brokers[0].received == 10);
+  CHECK(!brokers[0].seen[9] && brokers[0].seen[10] && brokers[0].seen[19]);
+
+  brokerGroup_Stop(&group);
+  standInKill(&brokers[0]);
+}
+
+static void publishFrom(brokerGroup_t *group, int source, const char *topic,
+                        int seq) {
+  char payload[64];
+  int len = snprintf(payload, sizeof(payload), "{\"seq=%d\"}", seq);
+  CHECK(brokerGroup_Publish(group, source, topic, payload, len, 0, false,
+                            NULL) == 0);
+}
+
+/*
+ * 4. 优先级和公平分配：上行链路每条消息2ms，两个权重3:1的批量数据源
+ *    持续超速发送，同一优先级还有一个合并的数据源（只发最新值），
+ *    同时有周期性的命令响应和状态消息
+ * */
+static void testPriority(void) {
+  static standIn_t brokers[1];
+  char addresses[1][64];
+  memset(brokers, 0, sizeof(brokers));
+  standInStart(&brokers[0], 0);
+
+  brokerGroup_t group;
+  initGroup(&group, BROKER_MODE_FAILOVER, brokers, 1, addresses);
+  int control = brokerGroup_AddSource(&group, "control",
+                                      BROKER_CLASS_CONTROL, 1, false);
+  int status =
+      brokerGroup_AddSource(&group, "status", BROKER_CLASS_STATUS, 1, true);
+  int bulkA =
+      brokerGroup_AddSource(&group, "bulk_a", BROKER_CLASS_BULK, 3, false);
+  int bulkB =
+      brokerGroup_AddSource(&group, "bulk_b", BROKER_CLASS_BULK, 1, false);
+  int latest =
+      brokerGroup_AddSource(&group, "latest", BROKER_CLASS_BULK, 1, true);
+  CHECK(control > 0 && status > 0 && bulkA > 0 && bulkB > 0 && latest > 0);
+  CHECK(brokerGroup_AddSource(&group, "bad", BROKER_CLASS_COUNT, 1, false) <
+        0);
+  g_publishDelayUs = 2000;
+
+  int controls = 0;
+  int statusPublished = 0;
+  for (int i = 0; i < 4000; i++) {
+    if (i % 80 == 0) {
+      publishFrom(&group, control, "sentinel/test/response", controls++);
+    }
+    if (i % 40 == 0) {
+      publishFrom(&group, status, "sentinel/test/status", MESSAGE_COUNT);
+      statusPublished++;
+    }
+    publishFrom(&group, latest, "sentinel/test/latest", MESSAGE_COUNT);
+    publishFrom(&group, bulkA, "sentinel/test/bulk_a", MESSAGE_COUNT);
+    publishFrom(&group, bulkB, "sentinel/test/bulk_b", MESSAGE_COUNT);
+    usleep(250);
+  }
+
+  // 两个批量数据源都有积压时按权重分配
+  brokerGroupStats_t stats;
+  brokerGroup_GetStats(&group, &stats);
+  double ratio = stats.sources[bulkB].sent
+                     ? (double)stats.sources[bulkA].sent /
+                           stats.sources[bulkB].sent
+                     : 0;
+  usleep(300 * 1000); // 等待队列排空
+  g_publishDelayUs = 0;
+  brokerGroup_GetStats(&group, &stats);
+
+  const brokerClassStats_t *ctl = &stats.outboxes[0].classes[0];
+  const brokerClassStats_t *st = &stats.outboxes[0].classes[2];
+  const brokerClassStats_t *bulk = &stats.outboxes[0].classes[3];
+  printf("priority: control sent %lu p99 %u us max %u us, status sent %lu "
+         "max %u us, bulk sent %lu dropped %lu coalesced %lu p50 %u us p99 "
+         "%u us, bulk_a:bulk_b %.2f\n",
+         ctl->sent, ctl->latencyP99Us, ctl->latencyMaxUs, st->sent,
+         st->latencyMaxUs, bulk->sent, bulk->dropped, bulk->coalesced,
+         bulk->latencyP50Us, bulk->latencyP99Us, ratio);
+
+  CHECK(ctl->sent == (unsigned long)controls && ctl->dropped == 0);
+  // 百分位数在直方图桶内插值，不会超过实测的最大值
+  CHECK(ctl->latencyP99Us <= ctl->latencyMaxUs);
+  CHECK(bulk->latencyP50Us <= bulk->latencyP99Us);
+  CHECK(bulk->latencyP99Us <= bulk->latencyMaxUs);
+  CHECK(brokers[0].received == controls);
+  // 合并数据源的延迟从最后一次替换算起，批量优先级取p99比较
+  CHECK(ctl->latencyMaxUs * 10 < bulk->latencyP99Us);
+  CHECK(st->dropped == 0);
+  CHECK(st->sent + st->coalesced == (unsigned long)statusPublished);
+  CHECK(st->latencyMaxUs * 10 < bulk->latencyP99Us);
+  CHECK(bulk->dropped > 0);
+  CHECK(stats.sources[bulkA].dropped > 0 && stats.sources[bulkB].dropped > 0);
+  // 合并的数据源始终只占一个槽位，不会被丢弃
+  CHECK(stats.sources[latest].coalesced > 0);
+  CHECK(stats.sources[latest].dropped == 0);
+  CHECK(bulk->highWater == 64);
+  CHECK(ratio > 2.5 && ratio < 3.5);
+
+  brokerGroup_Stop(&group);
+  standInKill(&brokers[0]);
+}
+
+/* 5. 令牌桶：批量优先级限速100条/秒（突发10条），命令响应不受影响 */
+static void testRateLimit(void) {
+  static standIn_t brokers[1];
+  char addresses[1][64];
+  memset(brokers, 0, sizeof(brokers));
+  standInStart(&brokers[0], 0);
+
+  g_classes[BROKER_CLASS_BULK] =
+      (brokerClassConfig_t){.depth = 32, .ratePerSec = 100, .burst = 10};
+  brokerGroup_t group;
+  initGroup(&group, BROKER_MODE_FAILOVER, brokers, 1, addresses);
+  memset(g_classes, 0, sizeof(g_classes));
+  int control = brokerGroup_AddSource(&group, "control",
+                                      BROKER_CLASS_CONTROL, 1, false);
+  CHECK(brokerGroup_QueueRoom(&group, BROKER_CLASS_BULK) == 32);
+  CHECK(brokerGroup_QueueRoom(&group, BROKER_CLASS_CONTROL) == 64);
+
+  int64_t start = nowMs();
+  for (int i = 0; i < 2000; i++) {
+    if (i % 100 == 0) {
+      publishFrom(&group, control, "sentinel/test/response", i / 100);
+    }
+    publishFrom(&group, BROKER_SOURCE_DEFAULT, "sentinel/test/bulk",
+                MESSAGE_COUNT);
+    usleep(500);
+  }
+  int64_t elapsed = nowMs() - start;
+  usleep(50 * 1000);
+
+  brokerGroupStats_t stats;
+  brokerGroup_GetStats(&group, &stats);
+  const brokerClassStats_t *ctl = &stats.outboxes[0].classes[0];
+  const brokerClassStats_t *bulk = &stats.outboxes[0].classes[3];
+  unsigned long expected = 10 + 100 * (elapsed + 50) / 1000;
+  printf("rate limit: bulk sent %lu in %lld ms (expected ~%lu), high water "
+         "%d, control sent %lu max %u us\n",
+         bulk->sent, (long long)elapsed + 50, expected, bulk->highWater,
+         ctl->sent, ctl->latencyMaxUs);
+
+  CHECK(bulk->sent <= expected + 2);
+  CHECK(bulk->sent + 20 >= expected);
+  CHECK(bulk->highWater == 32);
+  CHECK(ctl->sent == 20 && ctl->dropped == 0);
+  CHECK(brokerGroup_QueueRoom(&group, BROKER_CLASS_CONTROL) == 64);
+
+  brokerGroup_Stop(&group);
+  standInKill(&brokers[0]);
+}
+
+/* 导出的消息，复制出来后原队列可以释放 */
+typedef struct {
+  char data[8][128];
+  brokerQueuedMessage_t msgs[8];
+  int count;
+} exported_t;
+
+static int exportHandle(const brokerQueuedMessage_t *msg, void *userData) {
+  exported_t *out = (exported_t *)userData;
+  if (out->count >= 8) {
+    return -1;
+  }
+  char *data = out->data[out->count];
+  int topicLen = snprintf(data, 64, "%s", msg->topic);
+  memcpy(data + topicLen + 1, msg->payload, msg->payloadLen);
+  out->msgs[out->count] = *msg;
+  out->msgs[out->count].topic = data;
+  out->msgs[out->count].payload = data + topicLen + 1;
+  out->count++;
+  return 0;
+}
+
+/*
+ * 6. 启动和恢复：首次连接期间视为在线，消息排队并在连接后发出；
+ *    暂停后导出积压的消息，新的实例在启动前恢复，连接后补发
+ * */
+static void testResume(void) {
+  static standIn_t brokers[1];
+  char addresses[1][64];
+  memset(brokers, 0, sizeof(brokers));
+  standInStart(&brokers[0], 0);
+  int port = brokers[0].port;
+  standInKill(&brokers[0]);
+
+  brokerGroupConfig_t config;
+  groupConfig(&config, BROKER_MODE_FAILOVER, brokers, 1, addresses);
+  mqttClientConfig_t clientConfig = {.clientID = "test"};
+  g_connCount = 0;
+
+  brokerGroup_t group;
+  CHECK(brokerGroup_Init(&group, &config, &clientConfig) == 0);
+  CHECK(!brokerGroup_IsConnected(&group));
+  CHECK(brokerGroup_Start(&group) == 0);
+  CHECK(brokerGroup_IsConnected(&group)); // 首次连接尚未超时
+  for (int seq = 0; seq < 5; seq++) {
+    publishSeq(&group, seq);
+  }
+  usleep(100 * 1000);
+  brokerGroup_Pause(&group);
+
+  static exported_t exported;
+  memset(&exported, 0, sizeof(exported));
+  CHECK(brokerGroup_ExportQueued(&group, exportHandle, &exported) == 5);
+  CHECK(exported.count == 5);
+  CHECK(strstr(exported.msgs[0].payload, "seq=0") != NULL);
+  CHECK(exported.msgs[4].ageUs >= 100 * 1000);
+  brokerGroupStats_t stats;
+  brokerGroup_GetStats(&group, &stats);
+  CHECK(stats.firstSentUs == 0);
+  brokerGroup_Stop(&group);
+
+  // 重启：先恢复积压的消息再启动
+  standInStart(&brokers[0], port);
+  g_connCount = 0;
+  g_groupConnected = 0;
+  CHECK(brokerGroup_Init(&group, &config, &clientConfig) == 0);
+  brokerGroup_RegisterConnectionStatusCallback(&group, groupStatusHandle,
+                                               NULL);
+  for (int i = 0; i < exported.count; i++) {
+    CHECK(brokerGroup_Requeue(&group, &exported.msgs[i]) == 0);
+  }
+  CHECK(brokerGroup_Start(&group) == 0);
+  CHECK(waitFor(&g_groupConnected, 1, 2000));
+  usleep(200 * 1000);
+
+  brokerGroup_GetStats(&group, &stats);
+  printf("resume: restored %d, delivered %d, first publish %.1f ms after "
+         "start\n",
+         exported.count, brokers[0].received,
+         stats.firstSentUs / 1000.0 - stats.startedMs);
+  CHECK(brokers[0].received == 5);
+  CHECK(brokers[0].seen[0] && brokers[0].seen[4]);
+  CHECK(stats.firstSentUs > 0);
+  CHECK(stats.firstSentUs / 1000 >= stats.startedMs);
+
+  brokerGroup_Stop(&group);
+  standInKill(&brokers[0]);
+}
+
+/* 每个Broker的命令解析状态，与网关一样通过 userData 传入 */
+typedef struct {
+  memArena_t arena;
+  char pad; // 该Broker下发的命令中 pad 字段的字符
+  volatile int parsed;
+  int corrupted;
+} linkParse_t;
+
+static void commandParseHandle(const char *topic, const char *payload,
+                               int payloadLen, void *userData) {
+  linkParse_t *link = (linkParse_t *)userData;
+  memArena_BindCJSON(&link->arena);
+  cJSON *root = cJSON_ParseWithLength(payload, payloadLen);
+  sched_yield(); // 让另一个接收线程在解析树仍在使用时运行
+  const cJSON *pad = cJSON_GetObjectItem(root, "pad");
+  bool ok = cJSON_IsString(pad) && strlen(pad->valuestring) == 64;
+  for (int i = 0; ok && i < 64; i++) {
+    ok = pad->valuestring[i] == link->pad;
+  }
+  cJSON_Delete(root);
+  memArena_BindCJSON(NULL);
+  memArena_Reset(&link->arena);
+  if (!ok) {
+    link->corrupted++;
+  }
+  __atomic_add_fetch(&link->parsed, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * 7. 扇出模式下两个Broker的接收线程同时下发命令，各自用自己的arena解析，
+ *    解析树不会被另一个线程的 reset 覆盖
+ * */
+static void testConcurrentCommands(void) {
+  static standIn_t brokers[2];
+  char addresses[2][64];
+  memset(brokers, 0, sizeof(brokers));
+  for (int i = 0; i < 2; i++) {
+    standInStart(&brokers[i], 0);
+  }
+
+  brokerGroupConfig_t config;
+  groupConfig(&config, BROKER_MODE_FANOUT, brokers, 2, addresses);
+  mqttClientConfig_t clientConfig = {.clientID = "test"};
+  g_connCount = 0;
+  g_groupConnected = 0;
+  memPool_InstallCJSONHooks();
+  static linkParse_t links[2];
+  brokerGroup_t group;
+  CHECK(brokerGroup_Init(&group, &config, &clientConfig) == 0);
+  for (int i = 0; i < 2; i++) {
+    memset(&links[i], 0, sizeof(links[i]));
+    links[i].pad = 'a' + i;
+    CHECK(memArena_Init(&links[i].arena, 4096) == 0);
+    CHECK(brokerGroup_RegisterLinkCommandCallback(&group, i,
+                                                  commandParseHandle,
+                                                  &links[i]) == 0);
+  }
+  CHECK(brokerGroup_RegisterLinkCommandCallback(&group, 2, commandParseHandle,
+                                                NULL) == -1);
+  brokerGroup_RegisterConnectionStatusCallback(&group, groupStatusHandle,
+                                               NULL);
+  CHECK(brokerGroup_Start(&group) == 0);
+  CHECK(waitFor(&g_groupConnected, 1, 2000));
+  usleep(100 * 1000); // 两个连接都已建立
+
+  const int count = 500;
+  for (int seq = 0; seq < count; seq++) {
+    for (int i = 0; i < 2; i++) {
+      char line[128];
+      char pad[65];
+      memset(pad, links[i].pad, 64);
+      pad[64] = '\0';
+      snprintf(line, sizeof(line), "{\"seq\":%d,\"pad\":\"%s\"}\n", seq, pad);
+      standInSend(&brokers[i], line);
+    }
+  }
+  waitFor(&links[0].parsed, count, 2000);
+  waitFor(&links[1].parsed, count, 2000);
+
+  printf("concurrent commands: parsed %d/%d, corrupted %d/%d, arena peak "
+         "%zu/%zu bytes\n",
+         links[0].parsed, links[1].parsed, links[0].corrupted,
+         links[1].corrupted, links[0].arena.peak, links[1].arena.peak);
+  for (int i = 0; i < 2; i++) {
+    CHECK(links[i].parsed == count);
+    CHECK(links[i].corrupted == 0);
+    CHECK(links[i].arena.failed == 0);
+  }
+
+  brokerGroup_Stop(&group);
+  standInKill(&brokers[0]);
+  standInKill(&brokers[1]);
+  cJSON_InitHooks(NULL);
+}
+
+/* 状态通知的记录：检查通知是否重叠、是否交替 */
+static volatile int g_notifyInside = 0;
+static int g_notifyOverlaps = 0;
+static int g_notifyRepeats = 0;
+static int g_notifyCount = 0;
+static int g_notifyLast = 0;
+
+static void notifyRecordHandle(bool isConnected, void *userData) {
+  if (__atomic_add_fetch(&g_notifyInside, 1, __ATOMIC_ACQ_REL) > 1) {
+    g_notifyOverlaps++;
+  }
+  sched_yield(); // 让另一个线程在通知进行中到达
+  if (g_notifyCount++ > 0 && isConnected == g_notifyLast) {
+    g_notifyRepeats++;
+  }
+  g_notifyLast = isConnected;
+  __atomic_sub_fetch(&g_notifyInside, 1, __ATOMIC_ACQ_REL);
+}
+
+typedef struct {
+  mqttClientContext_t *ctx;
+  int rounds;
+} flapArgs_t;
+
+/* 模拟一个Broker的paho线程反复上报连接和断开 */
+static void *flapThread(void *arg) {
+  flapArgs_t *args = (flapArgs_t *)arg;
+  for (int i = 0; i < args->rounds; i++) {
+    setConnected(args->ctx, i % 2 == 0);
+    if (i % 7 == 0) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+/*
+ * 8. 两个Broker的线程同时上报状态变化：上层的通知不重叠、严格交替，
+ *    最后一次通知与汇总状态一致
+ * */
+static void testStatusNotify(void) {
+  static standIn_t brokers[2];
+  char addresses[2][64];
+  memset(brokers, 0, sizeof(brokers));
+  brokers[0].port = 1;
+  brokers[1].port = 2;
+
+  brokerGroupConfig_t config;
+  groupConfig(&config, BROKER_MODE_FANOUT, brokers, 2, addresses);
+  mqttClientConfig_t clientConfig = {.clientID = "test"};
+  g_connCount = 0;
+  brokerGroup_t group;
+  CHECK(brokerGroup_Init(&group, &config, &clientConfig) == 0);
+  brokerGroup_RegisterConnectionStatusCallback(&group, notifyRecordHandle,
+                                               NULL);
+
+  // 不启动连接线程，直接在两个线程中调用各Broker的状态回调
+  pthread_t threads[2];
+  flapArgs_t args[2];
+  for (int i = 0; i < 2; i++) {
+    args[i] = (flapArgs_t){.ctx = &group.links[i].ctx, .rounds = 20001};
+    pthread_create(&threads[i], NULL, flapThread, &args[i]);
+  }
+  for (int i = 0; i < 2; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  printf("status notify: %d notifications, overlaps %d, repeats %d, last %d\n",
+         g_notifyCount, g_notifyOverlaps, g_notifyRepeats, g_notifyLast);
+  CHECK(g_notifyCount > 0);
+  CHECK(g_notifyOverlaps == 0);
+  CHECK(g_notifyRepeats == 0);
+  CHECK(g_notifyLast == 1); // 两个Broker最后都上报了连接
+  CHECK(brokerGroup_IsConnected(&group));
+
+  brokerGroup_Stop(&group);
+}
+
+/*
+ * 9. 发布失败：Broker拒绝的消息只发一次就丢弃，暂时性错误重试5次后丢弃，
+ *    之后的消息照常发出
+ * */
+static void testPublishFailure(void) {
+  static standIn_t brokers[1];
+  char addresses[1][64];
+  memset(brokers, 0, sizeof(brokers));
+  standInStart(&brokers[0], 0);
+
+  brokerGroup_t group;
+  initGroup(&group, BROKER_MODE_FAILOVER, brokers, 1, addresses);
+  const char *failTopic = "sentinel/test/fail";
+  int reasons[2] = {MQTTREASONCODE_TOPIC_NAME_INVALID,
+                    MQTTCLIENT_MAX_MESSAGES_INFLIGHT};
+  int expected[2] = {1, 5};
+  for (int i = 0; i < 2; i++) {
+    g_failReason = reasons[i];
+    g_failAttempts = 0;
+    g_failTopic = failTopic;
+    brokerGroup_Publish(&group, BROKER_SOURCE_DEFAULT, failTopic, "{}", 2, 1,
+                        false, NULL);
+    publishSeq(&group, i);
+    usleep(300 * 1000);
+    printf("publish failure %d: attempts %d\n", i, g_failAttempts);
+    CHECK(g_failAttempts == expected[i]);
+    CHECK(brokers[0].seen[i]);
+  }
+  g_failTopic = NULL;
+
+  brokerGroupStats_t stats;
+  brokerGroup_GetStats(&group, &stats);
+  CHECK(stats.outboxes[0].failed == 2);
+  CHECK(stats.outboxes[0].classes[BROKER_CLASS_BULK].failed == 2);
+  CHECK(stats.outboxes[0].queued == 0);
+
+  brokerGroup_Stop(&group);
+  standInKill(&brokers[0]);
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  testFailover();
+  testFanout();
+  testExpiry();
+  testPriority();
+  testRateLimit();
+  testResume();
+  testConcurrentCommands();
+  testStatusNotify();
+  testPublishFailure();
+
+  return testReport("broker_group_test");
+}
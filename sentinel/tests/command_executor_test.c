@@ -0,0 +1,217 @@
+#include "../include/modules/command_dispatch.h"
+#include "../include/modules/command_executor.h"
+#include "../include/modules/mem_pool.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * 命令执行器：同一目标的命令按到达顺序逐个执行，不同目标并行；在队列中超过
+ * 截止时间的命令不执行，以 COMMAND_ERR_TIMEOUT 完成；取消会移除排队的命令
+ * 或标记正在执行的命令；队列满时拒绝；每条执行过的命令都计入两个直方图
+ * */
+#define MAX_EVENTS 32
+
+typedef struct {
+  char commandId[64];
+  long long startMs;
+  long long endMs;
+  bool sawCancel;
+} runEvent_t;
+
+typedef struct {
+  char commandId[64];
+  int errorCode;
+} doneEvent_t;
+
+static pthread_mutex_t g_eventLock = PTHREAD_MUTEX_INITIALIZER;
+static runEvent_t g_runs[MAX_EVENTS];
+static int g_runCount = 0;
+static doneEvent_t g_dones[MAX_EVENTS];
+static int g_doneCount = 0;
+
+static long long nowMs(void) { return commandDispatch_NowNs() / 1000000; }
+
+/* 睡眠 value 毫秒，期间每5ms检查一次取消 */
+static int slowHandle(const sentinelCommand_t *cmd,
+                      sentinelCommandResult_t *result, void *userData) {
+  runEvent_t event = {.startMs = nowMs()};
+  snprintf(event.commandId, sizeof(event.commandId), "%s", cmd->commandId);
+  for (int elapsed = 0; elapsed < (int)cmd->value; elapsed += 5) {
+    if (commandExecutor_Cancelled()) {
+      event.sawCancel = true;
+      break;
+    }
+    usleep(5000);
+  }
+  event.endMs = nowMs();
+
+  pthread_mutex_lock(&g_eventLock);
+  g_runs[g_runCount++] = event;
+  pthread_mutex_unlock(&g_eventLock);
+  return event.sawCancel ? COMMAND_ERR_CANCELLED : COMMAND_OK;
+}
+
+static void doneHandle(const sentinelCommand_t *cmd,
+                       const sentinelCommandResult_t *result, void *userData) {
+  pthread_mutex_lock(&g_eventLock);
+  snprintf(g_dones[g_doneCount].commandId, sizeof(g_dones[0].commandId), "%s",
+           cmd->commandId);
+  g_dones[g_doneCount].errorCode = result->errorCode;
+  g_doneCount++;
+  pthread_mutex_unlock(&g_eventLock);
+}
+
+static void submit(const char *id, const char *target, int ms, int timeoutMs,
+                   int expectRc) {
+  sentinelCommand_t cmd;
+  memset(&cmd, 0, sizeof(cmd));
+  snprintf(cmd.commandId, sizeof(cmd.commandId), "%s", id);
+  snprintf(cmd.target, sizeof(cmd.target), "%s", target);
+  snprintf(cmd.action, sizeof(cmd.action), "run");
+  cmd.hasValue = true;
+  cmd.value = ms;
+  cmd.timeoutMs = timeoutMs;
+  CHECK(commandExecutor_Submit(&cmd) == expectRc);
+}
+
+static void waitDone(int count) {
+  for (int i = 0; i < 400; i++) {
+    pthread_mutex_lock(&g_eventLock);
+    int done = g_doneCount;
+    pthread_mutex_unlock(&g_eventLock);
+    if (done >= count) {
+      return;
+    }
+    usleep(5000);
+  }
+}
+
+static const runEvent_t *findRun(const char *id) {
+  for (int i = 0; i < g_runCount; i++) {
+    if (strcmp(g_runs[i].commandId, id) == 0) {
+      return &g_runs[i];
+    }
+  }
+  return NULL;
+}
+
+static int findDone(const char *id) {
+  for (int i = 0; i < g_doneCount; i++) {
+    if (strcmp(g_dones[i].commandId, id) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void reset(void) {
+  g_runCount = 0;
+  g_doneCount = 0;
+}
+
+static void testOrdering(void) {
+  commandExecutorConfig_t config = {.workers = 3, .queueDepth = 8};
+  CHECK(commandExecutor_Init(&config, doneHandle, NULL) == 0);
+  reset();
+
+  submit("a1", "slow_a", 60, 0, 0);
+  submit("a2", "slow_a", 20, 0, 0);
+  submit("b1", "slow_b", 60, 0, 0);
+  submit("c1", "fast", 0, 0, 0);
+  waitDone(4);
+
+  const runEvent_t *a1 = findRun("a1"), *a2 = findRun("a2");
+  const runEvent_t *b1 = findRun("b1"), *c1 = findRun("c1");
+  CHECK(a1 && a2 && b1 && c1);
+  if (a1 && a2 && b1 && c1) {
+    CHECK(a2->startMs >= a1->endMs); // 同一 target 逐条执行
+    CHECK(b1->startMs < a1->endMs);  // 不同 target 并行
+    CHECK(c1->endMs < a1->endMs);    // 不被慢命令阻塞
+  }
+  CHECK(findDone("a1") < findDone("a2"));
+  commandExecutor_Deinit();
+}
+
+static void testDeadlineAndCancel(void) {
+  commandExecutorConfig_t config = {.workers = 1, .queueDepth = 3};
+  CHECK(commandExecutor_Init(&config, doneHandle, NULL) == 0);
+  reset();
+
+  submit("busy", "slow_a", 100, 0, 0);
+  usleep(10000);
+  submit("expire", "slow_b", 10, 20, 0);
+  submit("queued", "slow_b", 10, 0, 0);
+  submit("extra", "slow_b", 10, 0, 0);
+  submit("overflow", "slow_b", 10, 0, -1); // 队列已满
+
+  CHECK(commandExecutor_Cancel("queued") == 1);
+  usleep(30000); // "expire" 在队列中超过期限
+  CHECK(commandExecutor_Cancel("busy") == 2);
+  CHECK(commandExecutor_Cancel("unknown") == 0);
+  waitDone(4);
+
+  int i = findDone("expire");
+  CHECK(i >= 0 && g_dones[i].errorCode == COMMAND_ERR_TIMEOUT);
+  i = findDone("queued");
+  CHECK(i >= 0 && g_dones[i].errorCode == COMMAND_ERR_CANCELLED);
+  i = findDone("busy");
+  CHECK(i >= 0 && g_dones[i].errorCode == COMMAND_ERR_CANCELLED);
+  i = findDone("extra");
+  CHECK(i >= 0 && g_dones[i].errorCode == COMMAND_OK);
+  CHECK(findRun("expire") == NULL);
+  CHECK(findRun("queued") == NULL);
+  const runEvent_t *busy = findRun("busy");
+  CHECK(busy && busy->sawCancel && busy->endMs - busy->startMs < 90);
+  CHECK(!commandExecutor_Cancelled()); // 不在工作线程上
+
+  // 停止后统计保留，计数已包含最后一条命令
+  commandExecutor_Deinit();
+  commandExecutorStats_t stats;
+  commandExecutor_GetStats(&stats);
+  CHECK(stats.submitted == 4);
+  CHECK(stats.rejected == 1);
+  CHECK(stats.expired == 1);
+  CHECK(stats.cancelled == 1);
+  CHECK(stats.executed == 2);
+  CHECK(stats.queued == 0 && stats.running == 0);
+  CHECK(stats.maxQueued == 3);
+  unsigned long queueSum = 0, execSum = 0;
+  for (int b = 0; b < COMMAND_HIST_BUCKETS; b++) {
+    queueSum += stats.queueHist[b];
+    execSum += stats.execHist[b];
+  }
+  CHECK(queueSum == 2 && execSum == 2);
+  CHECK(stats.execMaxUs >= 5000);
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+  commandDispatch_Register("slow_a", slowHandle, NULL);
+  commandDispatch_Register("slow_b", slowHandle, NULL);
+  commandDispatch_Register("fast", slowHandle, NULL);
+
+  // timeout_ms 为命令的期限
+  const char *json = "{\"command_id\":\"t1\",\"target\":\"fast\","
+                     "\"action\":\"run\",\"timeout_ms\":250}";
+  sentinelCommand_t parsed;
+  CHECK(commandDispatch_Parse(json, strlen(json), &parsed) == 0);
+  CHECK(parsed.timeoutMs == 250);
+
+  CHECK(commandExecutor_BucketLimitMs(0) == 1);
+  CHECK(commandExecutor_BucketLimitMs(10) == 1024);
+  CHECK(commandExecutor_BucketLimitMs(COMMAND_HIST_BUCKETS - 1) == -1);
+
+  testOrdering();
+  testDeadlineAndCancel();
+
+  // 停止后不再接收命令
+  sentinelCommand_t cmd = {.target = "fast"};
+  CHECK(commandExecutor_Submit(&cmd) == -1);
+
+  return testReport("command_executor_test");
+}
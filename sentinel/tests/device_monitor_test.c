@@ -1,4 +1,4 @@
-#include "../src/modules/device_monitor/device_monitor.h"
+#include "../include/modules/device_monitor.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
@@ -10,12 +10,14 @@ int main(int argc, char *argv[]) {
   float memoryUsageRate = 0.0;
 
   while (1) {
+    sleep(1);
     cpuTemperature = getCpuTemperature();
     cpuLoad = getCpuLoad();
     memoryUsageRate = getMemUsage();
 
-    printf("cpuTemperature = %f \ncpuLoad = %lf \nmemoryUsageRate = %f \n",
-           cpuTemperature, cpuLoad, memoryUsageRate);
+    printf("cpuTemperature = %f \ncpuLoad = %lf \nmemoryUsageRate = %f \n"
+           "processCpuLoad = %lf \n",
+           cpuTemperature, cpuLoad, memoryUsageRate, getProcessCpuLoad());
   }
   return EXIT_SUCCESS;
 }
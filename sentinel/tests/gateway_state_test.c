@@ -0,0 +1,239 @@
+#include "../include/modules/gateway_state.h"
+#include "../include/modules/mem_pool.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * 网关运行状态：启动阶段的记录和启动完成前等待的线程被放行；快照通过
+ * visitor 保存计数器、CPU负载基线和积压的消息，重启后计数器累加、消息
+ * 按数据源名称（而不是ID）重新入队并保留压缩属性，未知的数据源被跳过，
+ * 恢复后删除快照文件
+ * */
+#define TEST_PATH "/tmp/sentinel_gateway_state_test.snap"
+#define MAX_MESSAGES 8
+
+static const mqttPublishOptions_t g_json;
+static const mqttPublishOptions_t g_packed;
+
+/* 测试用的网关：数据源名称表、计数器、CPU基线和发送队列 */
+typedef struct {
+  const char *names[4]; // 下标为数据源ID
+  gatewayCounters_t counters;
+  CpuTimes cpu;
+  bool cpuRestored;
+  brokerQueuedMessage_t queue[MAX_MESSAGES];
+  int queued;
+} fakeGateway_t;
+
+static void getCounters(gatewayCounters_t *counters, void *userData) {
+  *counters = ((fakeGateway_t *)userData)->counters;
+}
+
+static void addCounters(const gatewayCounters_t *counters, void *userData) {
+  fakeGateway_t *gw = (fakeGateway_t *)userData;
+  gw->counters.samplesProduced += counters->samplesProduced;
+  gw->counters.samplesOffline += counters->samplesOffline;
+}
+
+static void getCpuBaseline(CpuTimes *cpu, void *userData) {
+  *cpu = ((fakeGateway_t *)userData)->cpu;
+}
+
+static void setCpuBaseline(const CpuTimes *cpu, void *userData) {
+  fakeGateway_t *gw = (fakeGateway_t *)userData;
+  gw->cpu = *cpu;
+  gw->cpuRestored = true;
+}
+
+static int exportQueued(brokerQueuedVisitor_t visitor, void *visitorData,
+                        void *userData) {
+  fakeGateway_t *gw = (fakeGateway_t *)userData;
+  for (int i = 0; i < gw->queued; i++) {
+    visitor(&gw->queue[i], visitorData);
+  }
+  return gw->queued;
+}
+
+/* 恢复的消息复制一份 topic 和载荷，快照缓冲之后会被复用 */
+static char g_copies[MAX_MESSAGES][2][64];
+
+static int requeue(const brokerQueuedMessage_t *msg, void *userData) {
+  fakeGateway_t *gw = (fakeGateway_t *)userData;
+  if (gw->queued == MAX_MESSAGES) {
+    return -1;
+  }
+  brokerQueuedMessage_t *copy = &gw->queue[gw->queued];
+  *copy = *msg;
+  snprintf(g_copies[gw->queued][0], 64, "%s", msg->topic);
+  memcpy(g_copies[gw->queued][1], msg->payload, msg->payloadLen);
+  copy->topic = g_copies[gw->queued][0];
+  copy->payload = g_copies[gw->queued][1];
+  gw->queued++;
+  return 0;
+}
+
+static const char *sourceName(int source, void *userData) {
+  fakeGateway_t *gw = (fakeGateway_t *)userData;
+  return source >= 0 && source < 4 ? gw->names[source] : NULL;
+}
+
+static int sourceByName(const char *name, int len, void *userData) {
+  fakeGateway_t *gw = (fakeGateway_t *)userData;
+  for (int i = 0; i < 4; i++) {
+    if (gw->names[i] && (int)strlen(gw->names[i]) == len &&
+        memcmp(gw->names[i], name, len) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static gatewayStateVisitor_t visitorFor(fakeGateway_t *gw) {
+  gatewayStateVisitor_t visitor = {
+      .getCounters = getCounters,
+      .addCounters = addCounters,
+      .getCpuBaseline = getCpuBaseline,
+      .setCpuBaseline = setCpuBaseline,
+      .exportQueued = exportQueued,
+      .requeue = requeue,
+      .sourceName = sourceName,
+      .sourceByName = sourceByName,
+      .packedOptions = &g_packed,
+      .jsonOptions = &g_json,
+      .userData = gw,
+  };
+  return visitor;
+}
+
+static void *waitReadyThread(void *arg) {
+  gatewayState_WaitReady();
+  __atomic_store_n((int *)arg, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+static void testStartup(void) {
+  gatewayState_StartupBegin();
+  gatewayState_PhaseDone("config");
+  int released = 0;
+  pthread_t thread;
+  CHECK(pthread_create(&thread, NULL, waitReadyThread, &released) == 0);
+  usleep(20000);
+  CHECK(__atomic_load_n(&released, __ATOMIC_ACQUIRE) == 0);
+  gatewayState_PhaseDone("broker");
+  gatewayState_Ready();
+  pthread_join(thread, NULL);
+  CHECK(released == 1);
+  gatewayState_WaitReady(); // 启动完成后立即返回
+
+  char out[1024];
+  int len = gatewayState_FormatStartup(out, sizeof(out), -1);
+  CHECK(len > 0 && len == (int)strlen(out));
+  CHECK(strstr(out, "{\"phases\":[{\"name\":\"config\",\"us\":") == out);
+  CHECK(strstr(out, "{\"name\":\"broker\",\"us\":") != NULL);
+  CHECK(strstr(out, "\"first_publish_ms\":null") != NULL);
+  CHECK(strstr(out, "\"snapshot\":{\"enabled\":false") != NULL);
+  gatewayState_FormatStartup(out, sizeof(out), 12.5);
+  CHECK(strstr(out, "\"first_publish_ms\":12.500") != NULL);
+  // 缓冲不足时截断
+  CHECK(gatewayState_FormatStartup(out, 16, -1) == 15);
+}
+
+static void testSnapshot(void) {
+  unlink(TEST_PATH);
+  gatewayStateConfig_t config = {.enabled = true,
+                                 .path = TEST_PATH,
+                                 .intervalSec = 0,
+                                 .maxBytes = 4096};
+  fakeGateway_t before = {
+      .names = {"status", "light", NULL, NULL},
+      .counters = {.samplesProduced = 500, .samplesOffline = 20},
+      .cpu = {.user = 7, .total = 100},
+      .queue = {{.source = 1,
+                 .topic = "sentinel/dev/light",
+                 .payload = "\x01\x02\x03",
+                 .payloadLen = 3,
+                 .qos = 1,
+                 .options = &g_packed,
+                 .ageUs = 1000},
+                {.source = 0,
+                 .topic = "sentinel/dev/status",
+                 .payload = "{\"a\":1}",
+                 .payloadLen = 7,
+                 .retained = true,
+                 .options = &g_json,
+                 .ageUs = 2000},
+                {.source = 2, // 没有名称，不保存
+                 .topic = "sentinel/dev/other",
+                 .payload = "x",
+                 .payloadLen = 1,
+                 .options = &g_json}},
+      .queued = 3,
+  };
+  gatewayStateVisitor_t visitor = visitorFor(&before);
+  CHECK(gatewayState_Init(&config, &visitor) == 0); // 还没有快照
+  gatewayStateStats_t stats;
+  gatewayState_GetStats(&stats);
+  CHECK(stats.enabled && !stats.restored);
+  CHECK(gatewayState_Save() == 0);
+  gatewayState_GetStats(&stats);
+  CHECK(stats.saves == 1 && stats.saveFailures == 0);
+  CHECK(stats.lastMessages == 3 && stats.truncated == 0);
+  CHECK(access(TEST_PATH, F_OK) == 0);
+
+  // 重启后数据源ID改变，按名称恢复
+  fakeGateway_t after = {
+      .names = {NULL, NULL, "status", "light"},
+      .counters = {.samplesProduced = 3, .samplesOffline = 1},
+  };
+  visitor = visitorFor(&after);
+  CHECK(gatewayState_Init(&config, &visitor) == 0);
+  gatewayState_GetStats(&stats);
+  CHECK(stats.restored && stats.restoredMessages == 2);
+  CHECK(stats.skippedMessages == 0);
+  CHECK(stats.savedAgoMs >= 0);
+  CHECK(access(TEST_PATH, F_OK) != 0);
+  CHECK(after.counters.samplesProduced == 503);
+  CHECK(after.counters.samplesOffline == 21);
+  if (access("/proc/sys/kernel/random/boot_id", R_OK) == 0) {
+    CHECK(after.cpuRestored && after.cpu.user == 7 && after.cpu.total == 100);
+  }
+  CHECK(after.queued == 2);
+  CHECK(after.queue[0].source == 3 && after.queue[0].options == &g_packed);
+  CHECK(strcmp(after.queue[0].topic, "sentinel/dev/light") == 0);
+  CHECK(after.queue[0].payloadLen == 3 &&
+        memcmp(after.queue[0].payload, "\x01\x02\x03", 3) == 0);
+  CHECK(after.queue[0].qos == 1 && !after.queue[0].retained);
+  CHECK(after.queue[0].ageUs >= 1000);
+  CHECK(after.queue[1].source == 2 && after.queue[1].options == &g_json);
+  CHECK(after.queue[1].retained && after.queue[1].ageUs >= 2000);
+
+  // 数据源在新版本中被移除时跳过它的消息
+  CHECK(gatewayState_Save() == 0);
+  fakeGateway_t renamed = {.names = {"status", NULL, NULL, NULL}};
+  visitor = visitorFor(&renamed);
+  CHECK(gatewayState_Init(&config, &visitor) == 0);
+  gatewayState_GetStats(&stats);
+  CHECK(stats.restoredMessages == 3 && stats.skippedMessages == 1);
+  CHECK(renamed.queued == 1 && renamed.queue[0].source == 0);
+  CHECK(renamed.counters.samplesProduced == 503);
+
+  // 关闭时不分配缓冲，也不保存
+  config.enabled = false;
+  CHECK(gatewayState_Init(&config, &visitor) == 0);
+  CHECK(gatewayState_Save() == -1);
+  CHECK(access(TEST_PATH, F_OK) != 0);
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  testStartup();
+  testSnapshot();
+
+  return testReport("gateway_state_test");
+}
@@ -0,0 +1,135 @@
+#include "../include/modules/event_loop.h"
+#include "../include/modules/gpio_input.h"
+#include "../include/modules/mem_pool.h"
+#include "test_check.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * GPIO输入的消抖和上报，gpioevent_data 记录通过管道写入，代替GPIO线的事件
+ * 文件描述符
+ * */
+/* 与内核 struct gpioevent_data 布局一致 */
+struct fakeEvent {
+  uint64_t timestamp;
+  uint32_t id;
+};
+
+#define RISING 1
+#define FALLING 2
+#define MS 1000000ULL
+
+static gpioEvent_t g_events[32];
+static int g_eventCount = 0;
+
+static void onEvent(const gpioEvent_t *event, void *userData) {
+  if (g_eventCount < 32) {
+    g_events[g_eventCount++] = *event;
+  }
+}
+
+static void inject(int fd, uint64_t ts, uint32_t id) {
+  struct fakeEvent ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.timestamp = ts;
+  ev.id = id;
+  if (write(fd, &ev, sizeof(ev)) != sizeof(ev)) {
+    perror("write");
+  }
+}
+
+static void pump(eventLoop_t *loop, int ms) {
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  do {
+    eventLoop_RunOnce(loop, 5);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  } while ((now.tv_sec - start.tv_sec) * 1000 +
+               (now.tv_nsec - start.tv_nsec) / 1000000 <
+           ms);
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  eventLoop_t loop;
+  CHECK(eventLoop_Init(&loop, 16) == 0);
+  CHECK(gpioInput_Init(&loop, onEvent, NULL) == 0);
+
+  gpioLineConfig_t button = {.name = "key0",
+                             .line = 18,
+                             .edge = GPIO_EDGE_BOTH,
+                             .activeLow = true,
+                             .debounceMs = 20};
+  gpioLineConfig_t irq = {.name = "ap3216c_int",
+                          .line = 1,
+                          .edge = GPIO_EDGE_FALLING,
+                          .trigger = "light"};
+  int buttonPipe[2], irqPipe[2];
+  CHECK(pipe(buttonPipe) == 0 && pipe(irqPipe) == 0);
+  // 按键未按下：物理高电平，activeLow 后为0
+  CHECK(gpioInput_AddLineFd(&button, buttonPipe[0], 0) == 0);
+  CHECK(gpioInput_AddLineFd(&irq, irqPipe[0], -1) == 0);
+
+  /* 1. 按下时的抖动：只立即上报第一个边沿 */
+  inject(buttonPipe[1], 1000 * MS, FALLING);
+  inject(buttonPipe[1], 1001 * MS, RISING);
+  inject(buttonPipe[1], 1002 * MS, FALLING);
+  eventLoop_RunOnce(&loop, 50);
+  CHECK(g_eventCount == 1);
+  CHECK(g_events[0].value == 1 && !g_events[0].settled);
+  CHECK(g_events[0].kernelTsNs == 1000 * MS);
+  CHECK(strcmp(g_events[0].config->name, "key0") == 0);
+
+  /* 窗口结束后最终电平与已上报一致，不补报 */
+  pump(&loop, 40);
+  CHECK(g_eventCount == 1);
+
+  /* 2. 松开时抖动并停在错误方向之后的最终电平：窗口结束后补报 */
+  inject(buttonPipe[1], 2000 * MS, RISING);  // 松开 -> 0，立即上报
+  inject(buttonPipe[1], 2003 * MS, FALLING); // 抖回按下
+  eventLoop_RunOnce(&loop, 50);
+  CHECK(g_eventCount == 2 && g_events[1].value == 0);
+  pump(&loop, 40);
+  CHECK(g_eventCount == 3);
+  CHECK(g_events[2].value == 1 && g_events[2].settled);
+  CHECK(g_events[2].kernelTsNs == 2003 * MS);
+
+  /* 3. 窗口外的边沿立即上报 */
+  inject(buttonPipe[1], 3000 * MS, RISING);
+  eventLoop_RunOnce(&loop, 50);
+  CHECK(g_eventCount == 4 && g_events[3].value == 0);
+
+  /* 4. 单边沿中断线：无去抖，每个边沿都上报，且上报延迟在毫秒级 */
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  inject(irqPipe[1], 4000 * MS, FALLING);
+  inject(irqPipe[1], 4001 * MS, FALLING);
+  eventLoop_RunOnce(&loop, 50);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  CHECK(g_eventCount == 6);
+  CHECK(strcmp(g_events[5].config->trigger, "light") == 0);
+  long latencyUs = (t1.tv_sec - t0.tv_sec) * 1000000 +
+                   (t1.tv_nsec - t0.tv_nsec) / 1000;
+  CHECK(latencyUs < 5000);
+
+  gpioInputStats_t stats;
+  gpioInput_GetStats(&stats);
+  CHECK(stats.rawEdges == 8);
+  CHECK(stats.delivered == 6);
+  CHECK(stats.suppressed == 3);
+  printf("edges %lu delivered %lu suppressed %lu, irq latency %ld us\n",
+         stats.rawEdges, stats.delivered, stats.suppressed, latencyUs);
+
+  gpioInput_Deinit();
+  close(buttonPipe[1]);
+  close(irqPipe[1]);
+  close(buttonPipe[0]);
+  close(irqPipe[0]);
+
+  return testReport("gpio_input_test");
+}
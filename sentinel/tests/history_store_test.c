@@ -0,0 +1,262 @@
+#include "../include/modules/history_store.h"
+#include "test_check.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Gorilla编码的历史数据：精确的往返、环形空间回收、重新打开，以及追加开销、
+ * 压缩率和区间查询的基准
+ *
+ * ./history_store_test [trace.csv] 同时输出设备上记录的曲线（每行
+ * "timestamp_ms,value"）的压缩率
+ * */
+#define TEST_PATH "/tmp/sentinel_history_test.db"
+#define BENCH_PATH "/tmp/sentinel_history_bench.db"
+#define DAY_MS (24LL * 3600 * 1000)
+
+static double nowSec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void openStore(historyStore_t *store, const char *path,
+                      uint32_t blockBytes, uint32_t blockCount) {
+  historyStoreConfig_t config;
+  memset(&config, 0, sizeof(config));
+  snprintf(config.path, sizeof(config.path), "%s", path);
+  config.blockBytes = blockBytes;
+  config.blockCount = blockCount;
+  CHECK(historyStore_Open(store, &config) == 0);
+}
+
+/* 每个样本一个1ms宽的桶，验证解码值与写入值逐位一致 */
+static void testRoundTrip(void) {
+  historyStore_t store;
+  unlink(TEST_PATH);
+  openStore(&store, TEST_PATH, 4096, 64);
+  int id = historyStore_SeriesId(&store, "status.cpu_load");
+  CHECK(id == 0);
+  CHECK(historyStore_SeriesId(&store, "status.cpu_load") == 0);
+
+  enum { N = 2000 };
+  static double values[N];
+  static int64_t stamps[N];
+  int64_t ts = 1700000000000LL;
+  srand(7);
+  for (int i = 0; i < N; i++) {
+    // 混合：重复值、整数、随机小数、负数、大跳变的时间间隔
+    if (i % 7 == 0 && i > 0) {
+      values[i] = values[i - 1];
+    } else if (i % 5 == 0) {
+      values[i] = rand() % 1000;
+    } else if (i % 11 == 0) {
+      values[i] = -((double)rand() / RAND_MAX) * 1e6;
+    } else {
+      values[i] = (double)rand() / RAND_MAX * 100.0;
+    }
+    ts += (i % 97 == 0) ? 3600000 + rand() % 5000 : 1000 + rand() % 5;
+    stamps[i] = ts;
+    CHECK(historyStore_Append(&store, id, ts, values[i]) == 0);
+  }
+
+  static historyBucket_t buckets[N];
+  int errors = 0;
+  for (int i = 0; i < N; i += 50) {
+    int count = historyStore_Query(&store, id, stamps[i], stamps[i] + 1, 1,
+                                   buckets, 1);
+    if (count != 1 || buckets[0].count != 1 || buckets[0].min != values[i]) {
+      errors++;
+    }
+  }
+  CHECK(errors == 0);
+
+  // 整个范围一个桶：计数和最大值
+  int count = historyStore_Query(&store, id, stamps[0], stamps[N - 1] + 1,
+                                 stamps[N - 1] + 1 - stamps[0], buckets, 1);
+  CHECK(count == 1 && buckets[0].count == N);
+
+  // 时间戳回退：写入新块，旧数据保持可查询
+  CHECK(historyStore_Append(&store, id, stamps[0] - 10000, 42.0) == 0);
+  count = historyStore_Query(&store, id, stamps[0] - 10000,
+                             stamps[0] - 9999, 1, buckets, 1);
+  CHECK(count == 1 && buckets[0].count == 1 && buckets[0].max == 42.0);
+
+  /* 重新打开：序列名称和已有数据保留 */
+  historyStore_Close(&store);
+  openStore(&store, TEST_PATH, 4096, 64);
+  CHECK(historyStore_FindSeries(&store, "status.cpu_load") == 0);
+  count = historyStore_Query(&store, id, stamps[100], stamps[100] + 1, 1,
+                             buckets, 1);
+  CHECK(count == 1 && buckets[0].min == values[100]);
+  CHECK(historyStore_Append(&store, id, stamps[N - 1] + 1000, 1.5) == 0);
+  historyStore_Close(&store);
+
+  /* 几何参数改变时重建 */
+  openStore(&store, TEST_PATH, 2048, 16);
+  CHECK(historyStore_FindSeries(&store, "status.cpu_load") < 0);
+  historyStore_Close(&store);
+  unlink(TEST_PATH);
+}
+
+/* 小容量存储：写满后回收最旧的块，最近的数据始终可查 */
+static void testRing(void) {
+  historyStore_t store;
+  unlink(TEST_PATH);
+  openStore(&store, TEST_PATH, 1024, 8);
+  int a = historyStore_SeriesId(&store, "light.light_lux");
+  int b = historyStore_SeriesId(&store, "status.cpu_temp_c");
+
+  int64_t ts = 0;
+  for (int i = 0; i < 20000; i++) {
+    ts += 1000;
+    historyStore_Append(&store, a, ts, (double)(i % 1000));
+    historyStore_Append(&store, b, ts, 40.0 + (i % 13) * 0.37);
+  }
+
+  historyStoreStats_t stats;
+  historyStore_GetStats(&store, &stats);
+  CHECK(stats.blocksUsed == 8);
+  CHECK(stats.samples < 40000);
+
+  historyBucket_t buckets[4];
+  int count = historyStore_Query(&store, a, ts - 999, ts + 1, 1000, buckets, 4);
+  CHECK(count == 1 && buckets[0].count == 1 && buckets[0].max == 19999 % 1000);
+  count = historyStore_Query(&store, b, ts - 999, ts + 1, 1000, buckets, 4);
+  CHECK(count == 1 && buckets[0].count == 1);
+  count = historyStore_Query(&store, a, 0, 100000, 100000, buckets, 1);
+  CHECK(count == 1 && buckets[0].count == 0);
+  historyStore_Close(&store);
+  unlink(TEST_PATH);
+}
+
+/* 合成的1Hz轨迹，数值的形态与采集代码一致 */
+typedef double (*traceFunc_t)(int i);
+
+static double traceCpuTemp(int i) {
+  // thermal_zone 毫摄氏度 / 1000，经过float
+  double day = sin(i * 2 * M_PI / 86400.0);
+  int milli = 45000 + (int)(5000 * day) + (rand() % 7 - 3) * 125;
+  return (double)(float)(milli / 1000.0f);
+}
+
+static double traceCpuLoad(int i) {
+  // /proc/stat 在1秒内约100个jiffies，按float精度保存
+  int total = 100 + rand() % 3;
+  int busy = (rand() % 100 < 80) ? rand() % 4 : rand() % 40;
+  return (double)(float)(100.0 * busy / total);
+}
+
+static double traceLight(int i) {
+  // AP3216C 整数读数：白天的光照曲线加噪声，夜间接近0
+  double phase = sin((i % 86400) * 2 * M_PI / 86400.0);
+  int lux = phase > 0 ? (int)(phase * 800) + rand() % 10 : rand() % 3;
+  return lux;
+}
+
+static void benchTrace(historyStore_t *store, const char *name,
+                       traceFunc_t func, int samples) {
+  int id = historyStore_SeriesId(store, name);
+  historyStoreStats_t before;
+  historyStore_GetStats(store, &before);
+
+  int64_t ts = 1700000000000LL;
+  double start = nowSec();
+  for (int i = 0; i < samples; i++) {
+    ts += 1000 + rand() % 4; // sleep(1) 加采集耗时的抖动
+    historyStore_Append(store, id, ts, func(i));
+  }
+  double elapsed = nowSec() - start;
+
+  historyStoreStats_t after;
+  historyStore_GetStats(store, &after);
+  double bytes = (double)(after.storedBytes - before.storedBytes);
+  printf("  %-20s %8d samples  %6.1f ns/append  %5.2f B/sample  "
+         "ratio %5.1fx\n",
+         name, samples, elapsed * 1e9 / samples, bytes / samples,
+         16.0 * samples / bytes);
+}
+
+static void benchCsv(historyStore_t *store, const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    perror(path);
+    return;
+  }
+  int id = historyStore_SeriesId(store, "trace.csv");
+  historyStoreStats_t before, after;
+  historyStore_GetStats(store, &before);
+  long long ts;
+  double value;
+  int samples = 0;
+  while (fscanf(fp, "%lld,%lf", &ts, &value) == 2) {
+    historyStore_Append(store, id, ts, value);
+    samples++;
+  }
+  fclose(fp);
+  historyStore_GetStats(store, &after);
+  double bytes = (double)(after.storedBytes - before.storedBytes);
+  if (samples > 0) {
+    printf("  %-20s %8d samples  %5.2f B/sample  ratio %5.1fx\n", path,
+           samples, bytes / samples, 16.0 * samples / bytes);
+  }
+}
+
+static void benchQuery(historyStore_t *store, const char *name, int64_t endMs,
+                       int64_t spanMs, const char *label) {
+  int id = historyStore_FindSeries(store, name);
+  historyBucket_t buckets[60];
+  int rounds = 20;
+  double start = nowSec();
+  int count = 0;
+  for (int i = 0; i < rounds; i++) {
+    count = historyStore_Query(store, id, endMs - spanMs, endMs,
+                               (spanMs + 59) / 60, buckets, 60);
+  }
+  double elapsed = (nowSec() - start) / rounds;
+  long samples = 0;
+  for (int i = 0; i < count; i++) {
+    samples += buckets[i].count;
+  }
+  printf("  query %-4s -> 60 points: %8.3f ms (%ld samples decoded)\n", label,
+         elapsed * 1e3, samples);
+}
+
+int main(int argc, char *argv[]) {
+  testRoundTrip();
+  testRing();
+
+  /* 基准：一周的1Hz数据，8MB存储 */
+  historyStore_t store;
+  unlink(BENCH_PATH);
+  openStore(&store, BENCH_PATH, 4096, 2048);
+  srand(1);
+  int week = 7 * 86400;
+  printf("append / compression (1 Hz, 7 days per series, 16 B raw):\n");
+  benchTrace(&store, "status.cpu_temp_c", traceCpuTemp, week);
+  benchTrace(&store, "status.cpu_load", traceCpuLoad, week);
+  benchTrace(&store, "light.light_lux", traceLight, week);
+  if (argc > 1) {
+    benchCsv(&store, argv[1]);
+  }
+
+  historyStoreStats_t stats;
+  historyStore_GetStats(&store, &stats);
+  printf("store: %u/%u blocks, %llu samples, %llu bytes\n", stats.blocksUsed,
+         stats.blockCount, (unsigned long long)stats.samples,
+         (unsigned long long)stats.storedBytes);
+
+  int64_t endMs = 1700000000000LL + (int64_t)week * 1000;
+  printf("range query latency:\n");
+  benchQuery(&store, "light.light_lux", endMs, 3600 * 1000LL, "1h");
+  benchQuery(&store, "light.light_lux", endMs, DAY_MS, "24h");
+  benchQuery(&store, "light.light_lux", endMs, 7 * DAY_MS, "7d");
+  historyStore_Close(&store);
+  unlink(BENCH_PATH);
+
+  return testReport("history_store_test");
+}
@@ -0,0 +1,195 @@
+#include "../include/modules/event_loop.h"
+#include "../include/modules/iio_capture.h"
+#include "../include/modules/mem_pool.h"
+#include "test_check.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * IIO触发缓冲采集，使用假的 sysfs 目录，预先准备的二进制扫描数据写入FIFO，
+ * 代替 /dev/iio:device0
+ * */
+#define FAKE_ROOT "/tmp/sentinel_fake_iio"
+#define DEVICE_DIR FAKE_ROOT "/sys/iio:device0"
+
+static iioSample_t g_samples[64];
+static int g_sampleCount = 0;
+
+static void onSample(const iioSample_t *sample, void *userData) {
+  if (g_sampleCount < 64) {
+    g_samples[g_sampleCount++] = *sample;
+  }
+}
+
+static void writeFile(const char *path, const char *value) {
+  FILE *fp = fopen(path, "w");
+  if (fp) {
+    fputs(value, fp);
+    fclose(fp);
+  }
+}
+
+static void readFile(const char *path, char *buffer, size_t size) {
+  buffer[0] = '\0';
+  FILE *fp = fopen(path, "r");
+  if (fp) {
+    if (fgets(buffer, size, fp) == NULL) {
+      buffer[0] = '\0';
+    }
+    fclose(fp);
+  }
+}
+
+static void addElement(const char *name, int index, const char *type) {
+  char path[256];
+  char value[16];
+  snprintf(path, sizeof(path), DEVICE_DIR "/scan_elements/%s_en", name);
+  writeFile(path, "0");
+  snprintf(path, sizeof(path), DEVICE_DIR "/scan_elements/%s_index", name);
+  snprintf(value, sizeof(value), "%d\n", index);
+  writeFile(path, value);
+  snprintf(path, sizeof(path), DEVICE_DIR "/scan_elements/%s_type", name);
+  writeFile(path, type);
+}
+
+/*
+ * 伪造的AP3216C：ALS le:u16/16，IR le:u10/16（低10位），
+ * PS be:s12/16>>4，timestamp le:s64/64。
+ * 扫描布局：[als:2][ir:2][ps:2][pad:2][ts:8] = 16 字节
+ * */
+static void buildTree(void) {
+  if (system("rm -rf " FAKE_ROOT) != 0) {
+    // 目录不存在
+  }
+  mkdir(FAKE_ROOT, 0755);
+  mkdir(FAKE_ROOT "/sys", 0755);
+  mkdir(DEVICE_DIR, 0755);
+  mkdir(DEVICE_DIR "/scan_elements", 0755);
+  mkdir(DEVICE_DIR "/buffer", 0755);
+  mkdir(DEVICE_DIR "/trigger", 0755);
+  mkdir(FAKE_ROOT "/dev", 0755);
+
+  // 故意打乱配置顺序，布局应按index排列
+  addElement("in_illuminance", 0, "le:u16/16>>0\n");
+  addElement("in_intensity_ir", 1, "le:u10/16>>0\n");
+  addElement("in_proximity", 2, "be:s12/16>>4\n");
+  addElement("in_timestamp", 3, "le:s64/64>>0\n");
+  writeFile(DEVICE_DIR "/in_illuminance_scale", "0.35\n");
+  writeFile(DEVICE_DIR "/buffer/length", "0");
+  writeFile(DEVICE_DIR "/buffer/watermark", "1");
+  writeFile(DEVICE_DIR "/buffer/enable", "0");
+  writeFile(DEVICE_DIR "/trigger/current_trigger", "");
+  mkfifo(FAKE_ROOT "/dev/iio:device0", 0600);
+}
+
+static void packScan(uint8_t *scan, uint16_t als, uint16_t ir, int16_t ps,
+                     int64_t ts) {
+  memset(scan, 0, 16);
+  scan[0] = als & 0xff;
+  scan[1] = als >> 8;
+  // IR 高6位为无效位，应被掩掉
+  uint16_t irWord = (ir & 0x3ff) | 0xfc00;
+  scan[2] = irWord & 0xff;
+  scan[3] = irWord >> 8;
+  uint16_t psWord = (uint16_t)(ps << 4) | 0x000f;
+  scan[4] = psWord >> 8;
+  scan[5] = psWord & 0xff;
+  for (int i = 0; i < 8; i++) {
+    scan[8 + i] = (uint8_t)((uint64_t)ts >> (8 * i));
+  }
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+  buildTree();
+
+  iioScanType_t type;
+  CHECK(iioCapture_ParseType("be:s12/16>>4", &type) == 0);
+  CHECK(type.bigEndian && type.isSigned && type.bits == 12 &&
+        type.storageBits == 16 && type.shift == 4);
+  CHECK(iioCapture_ParseType("le:u10/16>>0", &type) == 0);
+  CHECK(!type.bigEndian && !type.isSigned && type.bits == 10);
+  CHECK(iioCapture_ParseType("le:s16/16X2>>0", &type) != 0);
+  CHECK(iioCapture_ParseType("le:s20/16>>0", &type) != 0);
+  CHECK(iioCapture_ParseType("garbage", &type) != 0);
+
+  eventLoop_t loop;
+  CHECK(eventLoop_Init(&loop, 8) == 0);
+
+  iioCaptureConfig_t config;
+  memset(&config, 0, sizeof(config));
+  snprintf(config.sysfsRoot, sizeof(config.sysfsRoot), FAKE_ROOT "/sys");
+  snprintf(config.devRoot, sizeof(config.devRoot), FAKE_ROOT "/dev");
+  snprintf(config.device, sizeof(config.device), "iio:device0");
+  snprintf(config.trigger, sizeof(config.trigger), "ap3216c-dev0");
+  config.bufferLength = 128;
+  config.watermark = 4;
+  config.timestamp = true;
+  config.channelCount = 3;
+  snprintf(config.channels[0].element, 32, "in_proximity");
+  snprintf(config.channels[1].element, 32, "in_illuminance");
+  snprintf(config.channels[2].element, 32, "in_intensity_ir");
+  CHECK(iioCapture_Init(&config, &loop, onSample, NULL) == 0);
+
+  char value[64];
+  readFile(DEVICE_DIR "/scan_elements/in_proximity_en", value, sizeof(value));
+  CHECK(strcmp(value, "1") == 0);
+  readFile(DEVICE_DIR "/scan_elements/in_timestamp_en", value, sizeof(value));
+  CHECK(strcmp(value, "1") == 0);
+  readFile(DEVICE_DIR "/trigger/current_trigger", value, sizeof(value));
+  CHECK(strcmp(value, "ap3216c-dev0") == 0);
+  readFile(DEVICE_DIR "/buffer/length", value, sizeof(value));
+  CHECK(strcmp(value, "128") == 0);
+  readFile(DEVICE_DIR "/buffer/enable", value, sizeof(value));
+  CHECK(strcmp(value, "1") == 0);
+
+  iioCaptureStats_t stats;
+  iioCapture_GetStats(&stats);
+  CHECK(stats.scanBytes == 16);
+
+  int writer = open(FAKE_ROOT "/dev/iio:device0", O_WRONLY);
+  CHECK(writer >= 0);
+
+  /* 一次写入5个扫描，最后一个拆成两半，验证不完整扫描的拼接 */
+  uint8_t scans[5 * 16];
+  for (int i = 0; i < 5; i++) {
+    packScan(scans + i * 16, 1000 + i, 300 + i, -20 + i,
+             1700000000000000000LL + i * 1000000LL);
+  }
+  CHECK(write(writer, scans, 4 * 16 + 7) == 4 * 16 + 7);
+  eventLoop_RunOnce(&loop, 100);
+  CHECK(g_sampleCount == 4);
+  CHECK(write(writer, scans + 4 * 16 + 7, 9) == 9);
+  eventLoop_RunOnce(&loop, 100);
+  CHECK(g_sampleCount == 5);
+
+  // values 顺序与配置一致：proximity, illuminance, ir
+  CHECK(g_samples[0].channelCount == 3);
+  CHECK(g_samples[0].raw[0] == -20);
+  CHECK(g_samples[0].raw[1] == 1000);
+  CHECK(g_samples[0].values[1] > 349.99 && g_samples[0].values[1] < 350.01);
+  CHECK(g_samples[0].raw[2] == 300);
+  CHECK(g_samples[4].raw[0] == -16);
+  CHECK(g_samples[4].raw[2] == 304);
+  CHECK(g_samples[4].timestampNs == 1700000000000000000LL + 4000000LL);
+
+  iioCapture_GetStats(&stats);
+  CHECK(stats.samples == 5);
+  CHECK(stats.reads == 2);
+  printf("scan %d bytes, %lu samples in %lu reads\n", stats.scanBytes,
+         stats.samples, stats.reads);
+
+  iioCapture_Deinit();
+  readFile(DEVICE_DIR "/buffer/enable", value, sizeof(value));
+  CHECK(strcmp(value, "0") == 0);
+  close(writer);
+
+  return testReport("iio_capture_test");
+}
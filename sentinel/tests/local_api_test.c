@@ -0,0 +1,233 @@
+#include "../include/modules/event_loop.h"
+#include "../include/modules/local_api.h"
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/value_table.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * 最新值表和本地读取接口：写入繁忙时 seqlock 读到一致的值，只读方式挂载
+ * 共享内存，Unix socket 的请求和应答
+ * */
+#define SHM_NAME "/sentinel_values_test"
+#define SOCKET_PATH "/tmp/sentinel_api_test.sock"
+
+static valueTable_t g_table;
+static volatile int g_stop = 0;
+
+static double nowUs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* 写者：value 与 tsMs 总是相同，updates 比它们大1 */
+static void *writerThread(void *arg) {
+  int index = *(int *)arg;
+  for (int64_t i = 0; !g_stop; i++) {
+    valueTable_Write(&g_table, index, (double)i, i);
+  }
+  return NULL;
+}
+
+typedef struct {
+  valueTable_t *table;
+  int index;
+  unsigned long reads;
+  unsigned long torn;
+  unsigned long busy;
+} readerArg_t;
+
+static void *readerThread(void *arg) {
+  readerArg_t *r = (readerArg_t *)arg;
+  while (!g_stop) {
+    valueSnapshot_t s;
+    if (valueTable_Read(r->table, r->index, &s) != 0) {
+      r->busy++;
+      continue;
+    }
+    r->reads++;
+    if (s.updates > 0 &&
+        (s.value != (double)s.tsMs || s.updates != (uint64_t)s.tsMs + 1)) {
+      r->torn++;
+    }
+  }
+  return NULL;
+}
+
+static int connectApi(void) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  snprintf(addr.sun_path, sizeof(addr.sun_path), SOCKET_PATH);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int readLine(int fd, char *out, size_t size) {
+  size_t pos = 0;
+  while (pos + 1 < size) {
+    ssize_t n = read(fd, out + pos, 1);
+    if (n <= 0) {
+      return -1;
+    }
+    if (out[pos++] == '\n') {
+      break;
+    }
+  }
+  out[pos] = '\0';
+  return (int)pos;
+}
+
+/* 发送一行请求并读取一行响应 */
+static int request(int fd, const char *line, char *out, size_t size) {
+  char buffer[128];
+  int len = snprintf(buffer, sizeof(buffer), "%s\n", line);
+  if (write(fd, buffer, len) != len) {
+    return -1;
+  }
+  return readLine(fd, out, size);
+}
+
+static int compareDouble(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  /* 1. 共享内存表与登记 */
+  CHECK(valueTable_Init(&g_table, 8, SHM_NAME) == 0);
+  int temp = valueTable_Register(&g_table, "status.cpu_temp_c");
+  int lux = valueTable_Register(&g_table, "light.light_lux");
+  int busyEntry = valueTable_Register(&g_table, "bench.counter");
+  CHECK(temp == 0 && lux == 1 && busyEntry == 2);
+  CHECK(valueTable_Register(&g_table, "light.light_lux") == 1);
+  valueTable_Write(&g_table, temp, 47.5, 1700000000123LL);
+  valueTable_Write(&g_table, lux, 321, 1700000000456LL);
+
+  valueTable_t reader;
+  CHECK(valueTable_Attach(&reader, SHM_NAME) == 0);
+  CHECK(valueTable_Count(&reader) == 3);
+  valueSnapshot_t snap;
+  CHECK(valueTable_Read(&reader, valueTable_Find(&reader, "light.light_lux"),
+                        &snap) == 0);
+  CHECK(snap.value == 321 && snap.tsMs == 1700000000456LL && snap.updates == 1);
+
+  /* 2. 写者全速写入时，进程内和共享内存读者都不能读到撕裂的数据 */
+  pthread_t writer, readers[2];
+  readerArg_t args[2] = {{.table = &g_table, .index = busyEntry},
+                         {.table = &reader, .index = busyEntry}};
+  pthread_create(&writer, NULL, writerThread, &busyEntry);
+  for (int i = 0; i < 2; i++) {
+    pthread_create(&readers[i], NULL, readerThread, &args[i]);
+  }
+  usleep(300 * 1000);
+  g_stop = 1;
+  pthread_join(writer, NULL);
+  for (int i = 0; i < 2; i++) {
+    pthread_join(readers[i], NULL);
+  }
+  CHECK(args[0].reads > 0 && args[1].reads > 0);
+  CHECK(args[0].torn == 0 && args[1].torn == 0);
+  printf("seqlock: %lu + %lu reads, torn %lu, retries exhausted %lu\n",
+         args[0].reads, args[1].reads, args[0].torn + args[1].torn,
+         args[0].busy + args[1].busy);
+
+  /* 3. Unix域套接字接口 */
+  eventLoop_t loop;
+  CHECK(eventLoop_Init(&loop, 16) == 0);
+  localApiConfig_t config = {.socketPath = SOCKET_PATH, .maxClients = 2};
+  CHECK(localApi_Init(&config, &loop, &g_table) == 0);
+  CHECK(eventLoop_Start(&loop) == 0);
+
+  int fd = connectApi();
+  CHECK(fd >= 0);
+  char line[256];
+  request(fd, "PING", line, sizeof(line));
+  CHECK(strcmp(line, "OK pong\n") == 0);
+  request(fd, "GET status.cpu_temp_c", line, sizeof(line));
+  CHECK(strcmp(line, "OK status.cpu_temp_c 47.5 1700000000123\n") == 0);
+  request(fd, "GET nope", line, sizeof(line));
+  CHECK(strcmp(line, "ERR unknown\n") == 0);
+  request(fd, "HELLO", line, sizeof(line));
+  CHECK(strcmp(line, "ERR bad request\n") == 0);
+  request(fd, "LIST", line, sizeof(line));
+  CHECK(strcmp(line, "OK 3\n") == 0);
+  readLine(fd, line, sizeof(line));
+  CHECK(strcmp(line, "status.cpu_temp_c 47.5 1700000000123\n") == 0);
+  readLine(fd, line, sizeof(line));
+  CHECK(strncmp(line, "light.light_lux 321 ", 20) == 0);
+  readLine(fd, line, sizeof(line));
+  CHECK(strncmp(line, "bench.counter ", 14) == 0);
+
+  // 往返延迟
+  enum { ROUNDS = 5000 };
+  static double samples[ROUNDS];
+  for (int i = 0; i < ROUNDS; i++) {
+    double start = nowUs();
+    request(fd, "GET light.light_lux", line, sizeof(line));
+    samples[i] = nowUs() - start;
+  }
+  qsort(samples, ROUNDS, sizeof(double), compareDouble);
+  CHECK(strncmp(line, "OK light.light_lux 321 ", 23) == 0);
+  printf("GET round trip: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+         samples[ROUNDS / 2], samples[ROUNDS * 99 / 100], samples[ROUNDS - 1]);
+  CHECK(samples[ROUNDS / 2] < 1000);
+
+  // 超出连接数的客户端被拒绝
+  int second = connectApi();
+  int third = connectApi();
+  CHECK(second >= 0 && third >= 0);
+  usleep(20 * 1000);
+  CHECK(read(third, line, sizeof(line)) == 0);
+
+  /* 4. 不读取响应的客户端被断开，不影响其他客户端 */
+  close(second);
+  int slow = connectApi();
+  int rcvbuf = 1024;
+  setsockopt(slow, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  char flood[5 * 4000];
+  for (int i = 0; i < 4000; i++) {
+    memcpy(flood + i * 5, "LIST\n", 5);
+  }
+  ssize_t sent = 0;
+  while (sent < (ssize_t)sizeof(flood)) {
+    ssize_t n = send(slow, flood + sent, sizeof(flood) - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      break;
+    }
+    sent += n;
+  }
+  usleep(50 * 1000);
+  localApiStats_t stats;
+  localApi_GetStats(&stats);
+  CHECK(stats.dropped >= 1);
+  request(fd, "PING", line, sizeof(line));
+  CHECK(strcmp(line, "OK pong\n") == 0);
+  printf("accepted %lu, requests %lu, rejected %lu, dropped %lu\n",
+         stats.accepted, stats.requests, stats.rejected, stats.dropped);
+
+  close(slow);
+  close(third);
+  close(fd);
+  eventLoop_Stop(&loop);
+  localApi_Deinit();
+  valueTable_Close(&reader);
+  valueTable_Close(&g_table);
+
+  return testReport("local_api_test");
+}
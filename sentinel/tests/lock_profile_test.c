@@ -0,0 +1,138 @@
+#include "../include/modules/lock_profile.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * 锁分析：一个线程每次持有互斥锁约30 ms（与发布时在网络调用期间持有客户端
+ * 锁相同），另一个线程争用；报告中耗时长的临界区排在最前，等待时间记在争用
+ * 的一方，条件变量的等待不计入持有时间
+ * */
+#define HOLD_ROUNDS 5
+#define HOLD_MS 30
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static volatile int g_holding = 0;
+
+static const lockSiteStats_t *findSite(const lockSiteStats_t *sites, int count,
+                                       const char *func) {
+  for (int i = 0; i < count; i++) {
+    if (strstr(sites[i].name, func)) {
+      return &sites[i];
+    }
+  }
+  return NULL;
+}
+
+static void *holderThreadFunc(void *arg) {
+  for (int i = 0; i < HOLD_ROUNDS; i++) {
+    PROFILED_LOCK(&g_lock);
+    g_holding = 1;
+    usleep(HOLD_MS * 1000);
+    g_holding = 0;
+    lockProfile_Unlock(&g_lock);
+    usleep(5 * 1000);
+  }
+  return NULL;
+}
+
+static void contenderLoop(void) {
+  while (!g_holding) {
+    usleep(1000);
+  }
+  for (int i = 0; i < HOLD_ROUNDS; i++) {
+    PROFILED_LOCK(&g_lock);
+    lockProfile_Unlock(&g_lock);
+    usleep(HOLD_MS * 1000);
+  }
+}
+
+static void condWaiter(void) {
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_nsec += 50 * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  PROFILED_LOCK(&g_lock);
+  lockProfile_CondTimedWait(&g_cond, &g_lock, &deadline);
+  lockProfile_Unlock(&g_lock);
+}
+
+/* 非LIFO顺序解锁的两把锁都要计入 */
+static void nestedLocks(void) {
+  static pthread_mutex_t inner = PTHREAD_MUTEX_INITIALIZER;
+  PROFILED_LOCK(&g_lock);
+  PROFILED_LOCK(&inner);
+  lockProfile_Unlock(&g_lock);
+  lockProfile_Unlock(&inner);
+}
+
+int main(void) {
+  // 未启用时不登记任何位置
+  PROFILED_LOCK(&g_lock);
+  lockProfile_Unlock(&g_lock);
+  lockSiteStats_t sites[8];
+  CHECK(!lockProfile_IsEnabled());
+  CHECK(lockProfile_GetSites(sites, 8) == 0);
+
+  lockProfile_SetEnabled(true);
+  pthread_t thread;
+  pthread_create(&thread, NULL, holderThreadFunc, NULL);
+  contenderLoop();
+  pthread_join(thread, NULL);
+  condWaiter();
+  nestedLocks();
+
+  int count = lockProfile_GetSites(sites, 8);
+  CHECK(count == 5);
+  for (int i = 0; i < count; i++) {
+    printf("%-40s acq %lu cont %lu wait p99 %u us hold p99 %u us "
+           "total %.3f us\n",
+           sites[i].name, sites[i].acquisitions, sites[i].contended,
+           sites[i].waitP99Us, sites[i].holdP99Us,
+           sites[i].holdTotalNs / 1000.0);
+    // 不足1微秒的临界区同样计入总持有时间
+    CHECK(sites[i].holdTotalNs > 0);
+  }
+
+  const lockSiteStats_t *holder = findSite(sites, count, "holderThreadFunc");
+  const lockSiteStats_t *contender = findSite(sites, count, "contenderLoop");
+  const lockSiteStats_t *waiter = findSite(sites, count, "condWaiter");
+  CHECK(holder && contender && waiter);
+  if (holder && contender && waiter) {
+    CHECK(holder == &sites[0]);
+    CHECK(holder->acquisitions == HOLD_ROUNDS);
+    CHECK(holder->holdMaxUs >= HOLD_MS * 1000);
+    CHECK(holder->holdP99Us >= 32768);
+    CHECK(contender->acquisitions == HOLD_ROUNDS);
+    CHECK(contender->contended >= 1);
+    CHECK(contender->waitMaxUs >= 10000);
+    CHECK(contender->holdMaxUs < 10000);
+    // 条件变量等待的50毫秒不算持有
+    CHECK(waiter->acquisitions == 1);
+    CHECK(waiter->holdMaxUs < 10000);
+  }
+
+  // 截断时保留持有时间最长的位置
+  lockSiteStats_t top;
+  CHECK(lockProfile_GetSites(&top, 1) == 1);
+  CHECK(holder && strcmp(top.name, holder->name) == 0);
+
+  lockProfile_Reset();
+  CHECK(lockProfile_GetSites(sites, 8) == 0);
+
+  // 关闭后加锁的记录不会残留在持有栈中
+  lockProfile_SetEnabled(false);
+  PROFILED_LOCK(&g_lock);
+  lockProfile_Unlock(&g_lock);
+  CHECK(lockProfile_GetSites(sites, 8) == 0);
+
+  return testReport("lock_profile_test");
+}
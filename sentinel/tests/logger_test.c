@@ -0,0 +1,404 @@
+#include "../include/modules/logger.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * 异步日志：延迟格式化的输出与 printf 相同（覆盖代码中用到的参数类型），
+ * 同一位置重复的消息（Broker断开时循环输出的 "MQTT Client does not
+ * connected."）合并为 "repeated N times"，按位置限速和按大小轮转生效，已
+ * 退出线程的环形缓冲被回收，并对比阻塞的 fprintf 测量热路径开销
+ * */
+#define LOG_PATH "/tmp/sentinel_logger_test.log"
+#define THREADS 4
+#define PER_THREAD 20000
+#define BENCH_ROUNDS 20000
+
+static loggerConfig_t baseConfig(void) {
+  loggerConfig_t config = {
+      .level = LOG_LEVEL_INFO,
+      .file = LOG_PATH,
+      .maxThreads = 8,
+      .ringSlots = 1024,
+      .flushIntervalMs = 20,
+      .summaryIntervalMs = 600000,
+  };
+  return config;
+}
+
+static void removeLogs(void) {
+  char path[64];
+  unlink(LOG_PATH);
+  for (int i = 1; i <= 4; i++) {
+    snprintf(path, sizeof(path), "%s.%d", LOG_PATH, i);
+    unlink(path);
+  }
+}
+
+static char *readLog(const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  char *text = (char *)malloc(size + 1);
+  size_t n = fread(text, 1, size, fp);
+  text[n] = '\0';
+  fclose(fp);
+  return text;
+}
+
+static int countOccurrences(const char *text, const char *needle) {
+  int count = 0;
+  for (const char *p = text; (p = strstr(p, needle)); p += strlen(needle)) {
+    count++;
+  }
+  return count;
+}
+
+static int countLines(const char *text) { return countOccurrences(text, "\n"); }
+
+/* 调用线程的CPU时间：单核上后台线程的格式化和写入不计入调用方 */
+static int64_t threadCpuNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* 与采样线程相同的调用位置：每次都是同一条消息 */
+static void brokerDown(void) {
+  LOGGER_WARN("MQTT Client does not connected.\n");
+}
+
+static void brokerStatus(int attempt) {
+  LOGGER_WARN("Broker %s unreachable (attempt %d)", "tcp://10.0.0.1:1883",
+              attempt);
+}
+
+static void testFormatting(void) {
+  removeLogs();
+  loggerConfig_t config = baseConfig();
+  CHECK(logger_Init(&config) == 0);
+
+  char longName[300];
+  memset(longName, 'x', sizeof(longName) - 1);
+  longName[sizeof(longName) - 1] = '\0';
+  int value = 42;
+  LOGGER_INFO("ints %d %u %ld %lld %zu %x %05d|%-4d", -7, 7u, -123456789L,
+              -1234567890123LL, (size_t)99, 255u, value, 3);
+  // 超出 LOGGER_MAX_ARGS 的转换说明原样输出
+  LOGGER_INFO("%d %d %d %d %d %d %d %d %c", 1, 2, 3, 4, 5, 6, 7, 8, 'k');
+  LOGGER_INFO("floats %.2f %e %g %5.1f %*.*f", 3.14159, 1e-9, 0.5, 2.25, 8,
+              3, 1.0 / 3);
+  LOGGER_INFO("strings [%s] [%8s] [%-6s|] [%.3s] %%", "abc", "pad", "left",
+              "truncate");
+  LOGGER_INFO("null %s", (const char *)NULL);
+  LOGGER_INFO("long %s end", longName);
+  char parts[4][61];
+  for (int i = 0; i < 4; i++) {
+    memset(parts[i], 'a' + i, 60);
+    parts[i][60] = '\0';
+  }
+  LOGGER_INFO("parts %s|%s|%s|%s|%d", parts[0], parts[1], parts[2], parts[3],
+              77);
+  LOGGER_DEBUG("debug hidden %d", 1);
+  logger_SetLevel(LOG_LEVEL_DEBUG);
+  LOGGER_DEBUG("debug shown %d", 2);
+  logger_SetLevel(LOG_LEVEL_WARN);
+  LOGGER_INFO("info hidden");
+  LOGGER_ERROR("error shown %s", "e");
+  logger_Callback(LOG_LEVEL_WARN, "callback %s %d\n", "mqtt", 5);
+  logger_SetLevel(LOG_LEVEL_INFO);
+  logger_Flush();
+
+  char *text = readLog(LOG_PATH);
+  CHECK(text != NULL);
+  if (text) {
+    char expected[400];
+    snprintf(expected, sizeof(expected), "ints %d %u %ld %lld %zu %x %05d|%-4d",
+             -7, 7u, -123456789L, -1234567890123LL, (size_t)99, 255u, value, 3);
+    CHECK(strstr(text, expected) != NULL);
+    CHECK(strstr(text, " 1 2 3 4 5 6 7 8 %c\n") != NULL);
+    snprintf(expected, sizeof(expected), "floats %.2f %e %g %5.1f %*.*f",
+             3.14159, 1e-9, 0.5, 2.25, 8, 3, 1.0 / 3);
+    CHECK(strstr(text, expected) != NULL);
+    CHECK(strstr(text, "strings [abc] [     pad] [left  |] [tru] %") != NULL);
+    CHECK(strstr(text, "null (null)") != NULL);
+    // 超长的字符串参数截断，格式串的其余部分照常输出
+    const char *line = strstr(text, "long x");
+    CHECK(line && strstr(line, "x end\n") &&
+          strstr(line, "x end\n") - line < (int)sizeof(longName) / 2);
+    // 几个字符串参数共用 strings：放不下的部分截断，之后的参数写成标记
+    char expectedParts[200];
+    snprintf(expectedParts, sizeof(expectedParts), "parts %s|%.34s|(trunc)|"
+             "(trunc)|77\n", parts[0], parts[1]);
+    CHECK(strstr(text, expectedParts) != NULL);
+    CHECK(strstr(text, "debug hidden") == NULL);
+    CHECK(strstr(text, "DEBUG") && strstr(text, "debug shown 2") != NULL);
+    CHECK(strstr(text, "info hidden") == NULL);
+    CHECK(strstr(text, "ERROR") && strstr(text, "error shown e") != NULL);
+    // 回调没有位置信息，结尾换行不重复
+    CHECK(strstr(text, "callback mqtt 5\n") != NULL);
+    CHECK(strstr(text, "logger_test.c:") != NULL);
+    CHECK(countOccurrences(text, "\n\n") == 0);
+    CHECK(countLines(text) == 10);
+    free(text);
+  }
+  logger_Deinit();
+}
+
+static void testRepeats(void) {
+  removeLogs();
+  loggerConfig_t config = baseConfig();
+  CHECK(logger_Init(&config) == 0);
+
+  for (int i = 0; i < 600; i++) {
+    brokerDown();
+  }
+  brokerStatus(1);
+  brokerStatus(1);
+  brokerStatus(2); // 参数不同，不合并
+  logger_Flush();
+  char *text = readLog(LOG_PATH);
+  CHECK(text != NULL);
+  if (text) {
+    // 消息未变化时只有第一条，汇总在下一次汇总周期输出
+    CHECK(countOccurrences(text, "MQTT Client does not connected.") == 1);
+    CHECK(strstr(text, "times: MQTT") == NULL);
+    CHECK(countOccurrences(text, "unreachable (attempt 1)") == 1);
+    CHECK(countOccurrences(text, "unreachable (attempt 2)") == 1);
+    // 消息变化时先输出之前合并的条数
+    CHECK(strstr(text, "message repeated 1 times: Broker %s") != NULL);
+    free(text);
+  }
+
+  brokerDown();
+  loggerStats_t stats;
+  logger_GetStats(&stats);
+  CHECK(stats.repeats == 601);
+  logger_Deinit(); // 停止时输出未汇总的条数
+
+  text = readLog(LOG_PATH);
+  if (text) {
+    CHECK(strstr(text, "message repeated 600 times: MQTT Client does not "
+                       "connected.\n") != NULL);
+    free(text);
+  }
+}
+
+static void testRateLimit(void) {
+  removeLogs();
+  loggerConfig_t config = baseConfig();
+  config.rateLimit = 5;
+  config.rateWindowMs = 300;
+  config.summaryIntervalMs = 100;
+  CHECK(logger_Init(&config) == 0);
+
+  for (int i = 0; i < 100; i++) {
+    brokerStatus(i);
+  }
+  usleep(350 * 1000); // 新窗口，且汇总已输出
+  for (int i = 100; i < 103; i++) {
+    brokerStatus(i);
+  }
+  logger_Flush();
+  loggerStats_t stats;
+  logger_GetStats(&stats);
+  CHECK(stats.limited == 95);
+  logger_Deinit();
+
+  char *text = readLog(LOG_PATH);
+  CHECK(text != NULL);
+  if (text) {
+    // 5 + 3 条，以及一行限流汇总
+    CHECK(countOccurrences(text, "unreachable") == 9);
+    CHECK(strstr(text, "(attempt 4)") && !strstr(text, "(attempt 5)"));
+    CHECK(strstr(text, "95 messages suppressed by rate limit") != NULL);
+    CHECK(strstr(text, "(attempt 102)") != NULL);
+    free(text);
+  }
+}
+
+static void testRotation(void) {
+  removeLogs();
+  loggerConfig_t config = baseConfig();
+  config.maxBytes = 4096;
+  config.maxFiles = 2;
+  CHECK(logger_Init(&config) == 0);
+  for (int i = 0; i < 1000; i++) {
+    LOGGER_INFO("rotation line %04d padding to make the line longer", i);
+    if (i % 100 == 0) {
+      logger_Flush();
+    }
+  }
+  logger_Flush();
+  loggerStats_t stats;
+  logger_GetStats(&stats);
+  CHECK(stats.rotations >= 10);
+  logger_Deinit();
+
+  char *current = readLog(LOG_PATH);
+  char *first = readLog(LOG_PATH ".1");
+  char *second = readLog(LOG_PATH ".2");
+  char *third = readLog(LOG_PATH ".3");
+  CHECK(current && first && second && !third);
+  if (current && first && second) {
+    // 按批写入，文件可能超出一个写缓冲的大小
+    CHECK(strlen(first) >= 4096 && strlen(first) < 4096 + 16384);
+    // 每次写入后检查大小，最后一批可能已经轮转
+    CHECK(strstr(current, "rotation line 0999") ||
+          strstr(first, "rotation line 0999"));
+    CHECK(!strstr(current, "rotation line 0000 ") &&
+          !strstr(first, "rotation line 0000 ") &&
+          !strstr(second, "rotation line 0000 "));
+  }
+  free(current);
+  free(first);
+  free(second);
+  free(third);
+}
+
+static void *producerThreadFunc(void *arg) {
+  int id = (int)(intptr_t)arg;
+  for (int i = 0; i < PER_THREAD; i++) {
+    LOGGER_INFO("producer %d seq %d", id, i);
+    if (i % 256 == 255) {
+      usleep(100); // 让出CPU给后台线程
+    }
+  }
+  return NULL;
+}
+
+static void testThreads(void) {
+  removeLogs();
+  loggerConfig_t config = baseConfig();
+  config.maxThreads = 2;
+  config.ringSlots = 4096;
+  CHECK(logger_Init(&config) == 0);
+
+  pthread_t threads[THREADS];
+  for (int i = 0; i < THREADS; i++) {
+    pthread_create(&threads[i], NULL, producerThreadFunc, (void *)(intptr_t)i);
+  }
+  for (int i = 0; i < THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  logger_Flush();
+  loggerStats_t stats;
+  logger_GetStats(&stats);
+  // 超出缓冲数的线程同步输出；缓冲满才丢弃
+  CHECK(stats.direct > 0);
+  CHECK(stats.lines + stats.dropped == THREADS * PER_THREAD);
+
+  // 已退出线程的缓冲被回收，后续线程仍可使用
+  for (int i = 0; i < 6; i++) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, producerThreadFunc,
+                   (void *)(intptr_t)(THREADS + i));
+    pthread_join(thread, NULL);
+    logger_Flush();
+  }
+  loggerStats_t after;
+  logger_GetStats(&after);
+  CHECK(after.direct == stats.direct);
+  CHECK(after.threads == 0);
+  logger_Deinit();
+
+  // 同一线程的消息保持顺序
+  char *text = readLog(LOG_PATH);
+  CHECK(text != NULL);
+  if (text) {
+    int last[THREADS + 6];
+    for (int i = 0; i < THREADS + 6; i++) {
+      last[i] = -1;
+    }
+    bool ordered = true;
+    int count = 0;
+    for (const char *p = text; (p = strstr(p, "producer ")); p++) {
+      // sscanf 每次都会计算剩余文本的长度，这里直接用 strtol
+      char *end;
+      int id = (int)strtol(p + 9, &end, 10);
+      int seq = strncmp(end, " seq ", 5) == 0 ? atoi(end + 5) : -1;
+      if (seq >= 0 && id >= 0 && id < THREADS + 6) {
+        ordered = ordered && seq > last[id];
+        last[id] = seq;
+        count++;
+      }
+    }
+    CHECK(ordered);
+    CHECK(count == (int)after.lines);
+    printf("threads: %lu lines, %lu dropped, %lu direct, %lu writes\n",
+           after.lines, after.dropped, after.direct, after.writes);
+    free(text);
+  }
+}
+
+static void testBenchmark(void) {
+  removeLogs();
+  loggerConfig_t config = baseConfig();
+  config.ringSlots = 1 << 15;
+  CHECK(logger_Init(&config) == 0);
+
+  int64_t start = threadCpuNs();
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    LOGGER_DEBUG("disabled %d", i);
+  }
+  double disabledNs = (double)(threadCpuNs() - start) / BENCH_ROUNDS;
+
+  start = threadCpuNs();
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    brokerDown();
+  }
+  double repeatNs = (double)(threadCpuNs() - start) / BENCH_ROUNDS;
+
+  start = threadCpuNs();
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    LOGGER_INFO("Light %d lux, ir %d, topic %s, load %.2f", i, i * 3,
+                "sentinel/dev/light", i * 0.01);
+  }
+  double enabledNs = (double)(threadCpuNs() - start) / BENCH_ROUNDS;
+  logger_Flush();
+  loggerStats_t stats;
+  logger_GetStats(&stats);
+  logger_Deinit();
+
+  FILE *fp = fopen(LOG_PATH ".bench", "w");
+  setvbuf(fp, NULL, _IONBF, 0); // 与stderr一样不缓冲
+  start = threadCpuNs();
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    fprintf(fp, "Light %d lux, ir %d, topic %s, load %.2f\n", i, i * 3,
+            "sentinel/dev/light", i * 0.01);
+  }
+  double fprintfNs = (double)(threadCpuNs() - start) / BENCH_ROUNDS;
+  fclose(fp);
+  unlink(LOG_PATH ".bench");
+
+  printf("hot path: disabled %.1f ns, repeated %.1f ns, enabled %.1f ns "
+         "(%lu dropped), unbuffered fprintf %.1f ns\n",
+         disabledNs, repeatNs, enabledNs, stats.dropped, fprintfNs);
+  CHECK(stats.dropped == 0);
+  CHECK(enabledNs < fprintfNs);
+  CHECK(repeatNs < enabledNs);
+  CHECK(disabledNs < 20);
+}
+
+int main(void) {
+  // 初始化之前同步输出到stderr
+  LOGGER_WARN("logger not started yet (expected on stderr)");
+
+  testFormatting();
+  testRepeats();
+  testRateLimit();
+  testRotation();
+  testThreads();
+  testBenchmark();
+  removeLogs();
+
+  return testReport("logger_test");
+}
@@ -0,0 +1,242 @@
+#include "../include/modules/command_dispatch.h"
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/mqtt_client.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * 替换 malloc 并统计内存池封存后的每次调用。封存后走网关处理命令的真实
+ * 路径：paho_msg_arrived 把消息复制到预分配的接收缓冲，回调中在 arena 上
+ * commandDispatch_Parse、执行并格式化响应，再经 mqttClient_Publish 发布，
+ * 同时按采样线程的方式发布状态载荷。整个稳态不能分配内存，arena 和接收
+ * 缓冲也不能出现放不下而退回 malloc 的情况。Paho由下面的替身提供
+ * */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+#define ROUNDS 100000
+
+static int g_counting = 0;
+static unsigned long g_mallocCalls = 0;
+
+void *malloc(size_t size) {
+  if (g_counting)
+    g_mallocCalls++;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+  if (g_counting)
+    g_mallocCalls++;
+  return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  if (g_counting)
+    g_mallocCalls++;
+  return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) { __libc_free(ptr); }
+
+/* Paho的替身：只记录发布，收到的消息由测试直接交给 paho_msg_arrived */
+static unsigned long g_published = 0;
+
+int MQTTClient_createWithOptions(MQTTClient *handle, const char *serverURI,
+                                 const char *clientId, int persistence_type,
+                                 void *persistence_context,
+                                 MQTTClient_createOptions *options) {
+  *handle = (MQTTClient)&g_published;
+  return MQTTCLIENT_SUCCESS;
+}
+
+int MQTTClient_setCallbacks(MQTTClient handle, void *context,
+                            MQTTClient_connectionLost *cl,
+                            MQTTClient_messageArrived *ma,
+                            MQTTClient_deliveryComplete *dc) {
+  return MQTTCLIENT_SUCCESS;
+}
+
+int MQTTClient_publishMessage(MQTTClient handle, const char *topicName,
+                              MQTTClient_message *msg,
+                              MQTTClient_deliveryToken *dt) {
+  g_published++;
+  return MQTTCLIENT_SUCCESS;
+}
+
+void MQTTClient_freeMessage(MQTTClient_message **msg) {}
+void MQTTClient_free(void *ptr) {}
+
+/* 以下只在连接、MQTT 5 和断开时用到 */
+int MQTTClient_setDisconnected(MQTTClient handle, void *context,
+                               MQTTClient_disconnected *co) {
+  return MQTTCLIENT_SUCCESS;
+}
+int MQTTClient_setPublished(MQTTClient handle, void *context,
+                            MQTTClient_published *co) {
+  return MQTTCLIENT_SUCCESS;
+}
+int MQTTClient_connect(MQTTClient handle, MQTTClient_connectOptions *options) {
+  return MQTTCLIENT_FAILURE;
+}
+MQTTResponse MQTTClient_connect5(MQTTClient handle,
+                                 MQTTClient_connectOptions *options,
+                                 MQTTProperties *connectProperties,
+                                 MQTTProperties *willProperties) {
+  MQTTResponse response = MQTTResponse_initializer;
+  response.reasonCode = MQTTREASONCODE_UNSPECIFIED_ERROR;
+  return response;
+}
+int MQTTClient_disconnect(MQTTClient handle, int timeout) {
+  return MQTTCLIENT_SUCCESS;
+}
+int MQTTClient_disconnect5(MQTTClient handle, int timeout,
+                           enum MQTTReasonCodes reason,
+                           MQTTProperties *props) {
+  return MQTTCLIENT_SUCCESS;
+}
+int MQTTClient_subscribe(MQTTClient handle, const char *topic, int qos) {
+  return MQTTCLIENT_SUCCESS;
+}
+MQTTResponse MQTTClient_subscribe5(MQTTClient handle, const char *topic,
+                                   int qos, MQTTSubscribe_options *opts,
+                                   MQTTProperties *props) {
+  MQTTResponse response = MQTTResponse_initializer;
+  return response;
+}
+MQTTResponse MQTTClient_publishMessage5(MQTTClient handle,
+                                        const char *topicName,
+                                        MQTTClient_message *msg,
+                                        MQTTClient_deliveryToken *dt) {
+  MQTTResponse response = MQTTResponse_initializer;
+  g_published++;
+  return response;
+}
+void MQTTClient_destroy(MQTTClient *handle) {}
+int MQTTProperties_add(MQTTProperties *props, const MQTTProperty *prop) {
+  return 0;
+}
+void MQTTProperties_free(MQTTProperties *props) {}
+int MQTTProperties_hasProperty(MQTTProperties *props,
+                               enum MQTTPropertyCodes propid) {
+  return 0;
+}
+int MQTTProperties_getNumericValue(MQTTProperties *props,
+                                   enum MQTTPropertyCodes propid) {
+  return -1;
+}
+void MQTTClient_yield(void) {}
+void MQTTResponse_free(MQTTResponse response) {}
+const char *MQTTReasonCode_toString(enum MQTTReasonCodes value) { return ""; }
+
+/* mqtt_client.c 交给Paho的接收回调，头文件中没有声明 */
+int paho_msg_arrived(void *context, char *topicName, int topicLen,
+                     MQTTClient_message *message);
+
+/* 网关的状态：命令处理、响应Topic和命令arena */
+static mqttClientContext_t g_client;
+static memArena_t g_arena;
+static char *g_responseTopic;
+static int g_handled = 0;
+
+static int ledHandle(const sentinelCommand_t *cmd,
+                     sentinelCommandResult_t *result, void *userData) {
+  snprintf(result->resultData, sizeof(result->resultData), "{\"state\":%d}",
+           (int)cmd->value);
+  return COMMAND_OK;
+}
+
+/* 与网关的命令回调相同：arena 上解析，执行后发布响应 */
+static void commandHandle(const char *topic, const char *payload,
+                          int payloadLen, void *userData) {
+  sentinelCommand_t cmd;
+  memArena_BindCJSON(&g_arena);
+  int rc = commandDispatch_Parse(payload, payloadLen, &cmd);
+  memArena_BindCJSON(NULL);
+  memArena_Reset(&g_arena);
+  if (rc != 0) {
+    return;
+  }
+
+  sentinelCommandResult_t result;
+  commandDispatch_Execute(&cmd, &result);
+  char response[512];
+  int len =
+      commandDispatch_FormatResponse(&cmd, &result, response, sizeof(response));
+  if (mqttClient_Publish(&g_client, g_responseTopic, response, len, 1,
+                         false) == 0) {
+    g_handled++;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  memPoolConfig_t config = {
+      .staticMode = true,
+      .budgetBytes = 64 * 1024,
+      .maxPayloadBytes = 1024,
+      .maxTopicLen = 128,
+      .commandArenaBytes = 16 * 1024,
+  };
+  const char *command =
+      "{\"command_id\":\"CTL_LED_20231201_123456\",\"target\":"
+      "\"gpio_led_alarm\",\"action\":\"set_state\",\"value\":1,"
+      "\"device_specific_params\":{\"duration_ms\":500}}";
+  char commandTopic[] = "sentinel/ATK-IMX6U-01/command";
+
+  // 启动阶段：所有内存一次性预留
+  CHECK(memPool_Init(&config) == 0);
+  mqttClientConfig_t clientConfig = {
+      .brokerAddress = "tcp://127.0.0.1:1883",
+      .clientID = "ATK-IMX6U-01",
+      .keepAliveInterval = 60,
+      .maxPayloadBytes = config.maxPayloadBytes,
+      .maxTopicLen = config.maxTopicLen,
+  };
+  CHECK(mqttClient_Init(&g_client, &clientConfig) == 0);
+  mqttClient_RegisterCommandCallback(&g_client, commandHandle, NULL);
+  CHECK(memArena_Init(&g_arena, config.commandArenaBytes) == 0);
+  CHECK(commandDispatch_Register("gpio_led_alarm", ledHandle, NULL) == 0);
+  g_responseTopic = memPool_Strdup("sentinel/ATK-IMX6U-01/response");
+  char *statusTopic = memPool_Strdup("sentinel/ATK-IMX6U-01/status");
+  CHECK(g_responseTopic && statusTopic);
+  memPool_InstallCJSONHooks();
+  printf("%s\n", statusTopic); // stdio 的缓冲在计数之前分配
+  memPool_Seal();
+  // 连接由重连线程建立，这里直接置为已连接
+  __atomic_store_n(&g_client.isConnected, true, __ATOMIC_RELEASE);
+
+  // 稳态
+  g_counting = 1;
+  char payload[256];
+  for (int i = 0; i < ROUNDS; i++) {
+    MQTTClient_message message = MQTTClient_message_initializer;
+    message.payload = (void *)command;
+    message.payloadlen = strlen(command);
+    paho_msg_arrived(&g_client, commandTopic, 0, &message);
+
+    int len = snprintf(
+        payload, sizeof(payload),
+        "{\"timestamp_ms\": %d,\"cpu_temp_c\": %lf,\"peak_rss_kb\": %ld}", i,
+        48.5, memPool_GetPeakRssKb());
+    mqttClient_Publish(&g_client, statusTopic, payload, len, 0, false);
+  }
+  void *late = memPool_Alloc(16);
+  g_counting = 0;
+
+  printf("commands handled = %d, published = %lu, arena peak = %zu bytes, "
+         "malloc calls = %lu\n",
+         g_handled, g_published, g_arena.peak, g_mallocCalls);
+  printf("peak RSS = %ld KB\n", memPool_GetPeakRssKb());
+
+  CHECK(g_mallocCalls == 0);
+  CHECK(g_handled == ROUNDS);
+  CHECK(g_published == 2 * ROUNDS);
+  CHECK(g_arena.failed == 0);
+  CHECK(g_client.rxDropped == 0);
+  CHECK(late == NULL);
+  return testReport("mem_pool_test");
+}
@@ -0,0 +1,513 @@
+#include "../include/modules/event_loop.h"
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/modbus_poller.h"
+#include "test_check.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Modbus TCP轮询，对着进程内的从站模拟器：请求合并、数值解码和缩放、异常
+ * 应答、流水线请求乱序应答、超时和重连，以及多个设备时每秒读取的寄存器数
+ * 和轮询周期延迟的基准
+ * */
+#define SIM_MAX_CONNS 512
+#define SIM_EXCEPTION_BASE 60000 // 保持寄存器从这里开始返回非法地址异常
+#define BENCH_DEVICES 200
+#define MAX_CYCLE_RECORDS 200000
+
+/* ---- 从站模拟器：单线程epoll，同一次读到的多个请求倒序应答 ---- */
+static uint16_t g_holding[65536];
+static uint16_t g_input[65536];
+static int g_simListenFd = -1;
+static int g_simPort = 0;
+static volatile int g_simStop = 0;
+static volatile int g_simSilent = 0; // 不应答，模拟从站卡死
+static int g_simMaxBatch = 0; // 一次读到的最多请求数（流水线深度）
+static unsigned long g_simReordered = 0;
+
+typedef struct {
+  int fd;
+  uint8_t buf[1024];
+  int len;
+} simConn_t;
+
+static int simRespond(const uint8_t *req, uint8_t *out) {
+  uint8_t function = req[7];
+  uint16_t start = (uint16_t)(req[8] << 8 | req[9]);
+  uint16_t count = (uint16_t)(req[10] << 8 | req[11]);
+  const uint16_t *table = function == 3 ? g_holding : g_input;
+  memcpy(out, req, 4); // 事务ID和协议ID
+  out[6] = req[6];
+
+  if ((function != 3 && function != 4) || count < 1 || count > 125 ||
+      start + count > 65536 ||
+      (function == 3 && start + count > SIM_EXCEPTION_BASE)) {
+    out[4] = 0;
+    out[5] = 3;
+    out[7] = function | 0x80;
+    out[8] = 2; // 非法数据地址
+    return 9;
+  }
+  int len = 3 + count * 2;
+  out[4] = 0;
+  out[5] = (uint8_t)len;
+  out[7] = function;
+  out[8] = (uint8_t)(count * 2);
+  for (int i = 0; i < count; i++) {
+    out[9 + i * 2] = table[start + i] >> 8;
+    out[10 + i * 2] = table[start + i] & 0xff;
+  }
+  return 6 + len;
+}
+
+static void simServe(simConn_t *conn) {
+  ssize_t n = recv(conn->fd, conn->buf + conn->len,
+                   sizeof(conn->buf) - conn->len, 0);
+  if (n <= 0) {
+    close(conn->fd);
+    conn->fd = -1;
+    return;
+  }
+  conn->len += (int)n;
+
+  int count = conn->len / 12;
+  if (g_simSilent) {
+    conn->len = 0;
+    return;
+  }
+  static uint8_t out[64 * 260];
+  int outLen = 0;
+  for (int i = count - 1; i >= 0; i--) {
+    outLen += simRespond(conn->buf + i * 12, out + outLen);
+  }
+  memmove(conn->buf, conn->buf + count * 12, conn->len - count * 12);
+  conn->len -= count * 12;
+  g_simReordered += count > 1;
+  if (count > g_simMaxBatch) {
+    g_simMaxBatch = count;
+  }
+  if (outLen > 0 && send(conn->fd, out, outLen, MSG_NOSIGNAL) != outLen) {
+    close(conn->fd);
+    conn->fd = -1;
+  }
+}
+
+static void *simThread(void *arg) {
+  static simConn_t conns[SIM_MAX_CONNS];
+  int epollFd = epoll_create1(0);
+  struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, g_simListenFd, &ev);
+  for (int i = 0; i < SIM_MAX_CONNS; i++) {
+    conns[i].fd = -1;
+  }
+
+  struct epoll_event events[64];
+  while (!g_simStop) {
+    int n = epoll_wait(epollFd, events, 64, 50);
+    for (int i = 0; i < n; i++) {
+      simConn_t *conn = (simConn_t *)events[i].data.ptr;
+      if (conn) {
+        if (conn->fd >= 0) {
+          simServe(conn);
+        }
+        continue;
+      }
+      int fd = accept(g_simListenFd, NULL, NULL);
+      int slot = 0;
+      while (slot < SIM_MAX_CONNS && conns[slot].fd >= 0) {
+        slot++;
+      }
+      if (fd < 0 || slot == SIM_MAX_CONNS) {
+        if (fd >= 0) {
+          close(fd);
+        }
+        continue;
+      }
+      conns[slot].fd = fd;
+      conns[slot].len = 0;
+      struct epoll_event cev = {.events = EPOLLIN, .data.ptr = &conns[slot]};
+      epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &cev);
+    }
+  }
+  for (int i = 0; i < SIM_MAX_CONNS; i++) {
+    if (conns[i].fd >= 0) {
+      close(conns[i].fd);
+    }
+  }
+  close(epollFd);
+  return NULL;
+}
+
+static int simStart(pthread_t *thread) {
+  struct sockaddr_in addr = {.sin_family = AF_INET};
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+  socklen_t len = sizeof(addr);
+  g_simListenFd = socket(AF_INET, SOCK_STREAM, 0);
+  if (g_simListenFd < 0 ||
+      bind(g_simListenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(g_simListenFd, SIM_MAX_CONNS) != 0 ||
+      getsockname(g_simListenFd, (struct sockaddr *)&addr, &len) != 0) {
+    return -1;
+  }
+  g_simPort = ntohs(addr.sin_port);
+  return pthread_create(thread, NULL, simThread, NULL);
+}
+
+/* ---- 轮询回调记录 ---- */
+static pthread_mutex_t g_recordLock = PTHREAD_MUTEX_INITIALIZER;
+static modbusValue_t g_lastValues[MODBUS_MAX_POINTS];
+static int g_lastCount = 0;
+static unsigned long g_cycles = 0;
+static int64_t *g_cycleUs = NULL;
+static unsigned long g_cycleRecords = 0;
+
+static void pollHandle(const char *device, const modbusValue_t *values,
+                       int count, int64_t cycleUs, void *userData) {
+  pthread_mutex_lock(&g_recordLock);
+  memcpy(g_lastValues, values, count * sizeof(modbusValue_t));
+  g_lastCount = count;
+  g_cycles++;
+  if (g_cycleRecords < MAX_CYCLE_RECORDS) {
+    g_cycleUs[g_cycleRecords++] = cycleUs;
+  }
+  pthread_mutex_unlock(&g_recordLock);
+}
+
+static unsigned long cycles(void) {
+  pthread_mutex_lock(&g_recordLock);
+  unsigned long count = g_cycles;
+  pthread_mutex_unlock(&g_recordLock);
+  return count;
+}
+
+static void resetRecords(void) {
+  pthread_mutex_lock(&g_recordLock);
+  g_cycles = 0;
+  g_cycleRecords = 0;
+  g_lastCount = 0;
+  pthread_mutex_unlock(&g_recordLock);
+}
+
+static double nowUs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void sleepMs(int ms) {
+  struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000};
+  nanosleep(&ts, NULL);
+}
+
+static int waitCycles(unsigned long count, int timeoutMs) {
+  double deadline = nowUs() + timeoutMs * 1000.0;
+  while (cycles() < count && nowUs() < deadline) {
+    sleepMs(2);
+  }
+  return cycles() >= count;
+}
+
+static void addPoint(modbusDeviceConfig_t *device, const char *name,
+                     modbusTable_t table, uint16_t address, modbusType_t type,
+                     double scale) {
+  modbusPointConfig_t *point = &device->points[device->pointCount++];
+  snprintf(point->name, sizeof(point->name), "%s", name);
+  point->table = table;
+  point->address = address;
+  point->type = type;
+  point->swapWords = false;
+  point->scale = scale;
+  point->offset = 0;
+}
+
+static void initDevice(modbusDeviceConfig_t *device, const char *name,
+                       int intervalMs) {
+  memset(device, 0, sizeof(*device));
+  snprintf(device->name, sizeof(device->name), "%s", name);
+  snprintf(device->host, sizeof(device->host), "127.0.0.1");
+  device->port = g_simPort;
+  device->unitId = 1;
+  device->intervalMs = intervalMs;
+}
+
+static const modbusValue_t *findValue(const char *name) {
+  for (int i = 0; i < g_lastCount; i++) {
+    if (strcmp(g_lastValues[i].name, name) == 0) {
+      return &g_lastValues[i];
+    }
+  }
+  return NULL;
+}
+
+/* 电表：保持寄存器0-3、10-11、40，输入寄存器0、5-6 */
+static void meterDevice(modbusDeviceConfig_t *device) {
+  initDevice(device, "meter", 20);
+  addPoint(device, "voltage", MODBUS_TABLE_HOLDING, 0, MODBUS_TYPE_U16, 0.1);
+  addPoint(device, "current", MODBUS_TABLE_INPUT, 0, MODBUS_TYPE_I16, 0.01);
+  addPoint(device, "offset", MODBUS_TABLE_HOLDING, 1, MODBUS_TYPE_I16, 1);
+  addPoint(device, "energy", MODBUS_TABLE_HOLDING, 2, MODBUS_TYPE_U32, 1);
+  addPoint(device, "freq", MODBUS_TABLE_HOLDING, 10, MODBUS_TYPE_F32, 1);
+  addPoint(device, "status", MODBUS_TABLE_HOLDING, 40, MODBUS_TYPE_U16, 1);
+  addPoint(device, "power", MODBUS_TABLE_INPUT, 5, MODBUS_TYPE_I32, 1);
+  device->points[6].swapWords = true;
+  device->points[6].offset = 0.5;
+}
+
+static void testPollAndDecode(eventLoop_t *loop) {
+  g_holding[0] = 2305;   // 230.5 V
+  g_holding[1] = 0xfffe; // -2
+  g_holding[2] = 0x0001; // 65538
+  g_holding[3] = 0x0002;
+  float freq = 49.75f;
+  uint32_t bits;
+  memcpy(&bits, &freq, sizeof(bits));
+  g_holding[10] = bits >> 16;
+  g_holding[11] = bits & 0xffff;
+  g_holding[40] = 7;
+  g_input[0] = (uint16_t)-150; // -1.5 A
+  g_input[5] = 0xff9c;         // 低字在前：-100
+  g_input[6] = 0xffff;
+
+  modbusPollerConfig_t config = {.maxDevices = 4,
+                                 .maxGap = 8,
+                                 .maxRegs = 125,
+                                 .maxInFlight = 4,
+                                 .timeoutMs = 200};
+  CHECK(modbusPoller_Init(&config, loop, pollHandle, NULL) == 0);
+  modbusDeviceConfig_t device;
+  meterDevice(&device);
+  CHECK(modbusPoller_AddDevice(&device) == 0);
+  CHECK(eventLoop_Start(loop) == 0);
+
+  // 保持寄存器 [0,12) 和 [40,41)，输入寄存器 [0,7)
+  const char *name;
+  modbusDeviceStats_t stats;
+  CHECK(modbusPoller_GetDeviceStats(0, &name, &stats) == 0);
+  CHECK(strcmp(name, "meter") == 0);
+  CHECK(stats.requestsPerCycle == 3);
+  CHECK(stats.registersPerCycle == 12 + 1 + 7);
+
+  resetRecords();
+  CHECK(waitCycles(3, 2000));
+  pthread_mutex_lock(&g_recordLock);
+  CHECK(g_lastCount == 7);
+  const modbusValue_t *v = findValue("voltage");
+  CHECK(v && v->valid && v->value > 230.49 && v->value < 230.51);
+  v = findValue("current");
+  CHECK(v && v->valid && v->value > -1.51 && v->value < -1.49);
+  v = findValue("offset");
+  CHECK(v && v->valid && v->value == -2);
+  v = findValue("energy");
+  CHECK(v && v->valid && v->value == 65538);
+  v = findValue("freq");
+  CHECK(v && v->valid && v->value == 49.75);
+  v = findValue("status");
+  CHECK(v && v->valid && v->value == 7);
+  v = findValue("power");
+  CHECK(v && v->valid && v->value == -99.5);
+  pthread_mutex_unlock(&g_recordLock);
+
+  // 三个请求一次发出，模拟器倒序应答
+  CHECK(g_simMaxBatch == 3);
+  CHECK(g_simReordered > 0);
+
+  // 更小的单请求上限拆分保持寄存器 [0,12)
+  eventLoop_Stop(loop);
+  modbusPoller_Deinit();
+  config.maxRegs = 10;
+  CHECK(modbusPoller_Init(&config, loop, pollHandle, NULL) == 0);
+  CHECK(modbusPoller_AddDevice(&device) == 0);
+  modbusPoller_GetDeviceStats(0, &name, &stats);
+  CHECK(stats.requestsPerCycle == 4);
+
+  // 不同寄存器表、越界和非法类型
+  modbusDeviceConfig_t bad;
+  initDevice(&bad, "bad", 20);
+  addPoint(&bad, "x", MODBUS_TABLE_HOLDING, 65535, MODBUS_TYPE_U32, 1);
+  CHECK(modbusPoller_AddDevice(&bad) == -1);
+  initDevice(&bad, "bad", 20);
+  addPoint(&bad, "x", (modbusTable_t)1, 0, MODBUS_TYPE_U16, 1);
+  CHECK(modbusPoller_AddDevice(&bad) == -1);
+  modbusPoller_Deinit();
+}
+
+/* 异常响应只影响该请求覆盖的测点 */
+static void testException(eventLoop_t *loop) {
+  modbusPollerConfig_t config = {.maxDevices = 1,
+                                 .maxGap = 8,
+                                 .maxRegs = 125,
+                                 .maxInFlight = 4,
+                                 .timeoutMs = 200};
+  CHECK(modbusPoller_Init(&config, loop, pollHandle, NULL) == 0);
+  modbusDeviceConfig_t device;
+  initDevice(&device, "hvac", 20);
+  addPoint(&device, "setpoint", MODBUS_TABLE_HOLDING, 0, MODBUS_TYPE_U16, 0.1);
+  addPoint(&device, "missing", MODBUS_TABLE_HOLDING, SIM_EXCEPTION_BASE,
+           MODBUS_TYPE_U16, 1);
+  CHECK(modbusPoller_AddDevice(&device) == 0);
+  CHECK(eventLoop_Start(loop) == 0);
+
+  resetRecords();
+  CHECK(waitCycles(2, 2000));
+  pthread_mutex_lock(&g_recordLock);
+  const modbusValue_t *v = findValue("setpoint");
+  CHECK(v && v->valid && v->value > 230.49 && v->value < 230.51);
+  v = findValue("missing");
+  CHECK(v && !v->valid);
+  pthread_mutex_unlock(&g_recordLock);
+
+  const char *name;
+  modbusDeviceStats_t stats;
+  modbusPoller_GetDeviceStats(0, &name, &stats);
+  CHECK(stats.exceptions >= 2);
+  CHECK(stats.connected);
+  eventLoop_Stop(loop);
+  modbusPoller_Deinit();
+}
+
+/* 从站不应答时超时断开，恢复后重连继续轮询 */
+static void testTimeout(eventLoop_t *loop) {
+  modbusPollerConfig_t config = {.maxDevices = 1,
+                                 .maxGap = 8,
+                                 .maxRegs = 125,
+                                 .maxInFlight = 4,
+                                 .timeoutMs = 50};
+  CHECK(modbusPoller_Init(&config, loop, pollHandle, NULL) == 0);
+  modbusDeviceConfig_t device;
+  meterDevice(&device);
+  CHECK(modbusPoller_AddDevice(&device) == 0);
+  CHECK(eventLoop_Start(loop) == 0);
+  resetRecords();
+  CHECK(waitCycles(2, 2000));
+
+  g_simSilent = 1;
+  sleepMs(200);
+  const char *name;
+  modbusDeviceStats_t stats;
+  modbusPoller_GetDeviceStats(0, &name, &stats);
+  CHECK(stats.timeouts >= 1);
+  CHECK(stats.overruns >= 1);
+
+  g_simSilent = 0;
+  unsigned long before = cycles();
+  CHECK(waitCycles(before + 3, 2000));
+  modbusPoller_GetDeviceStats(0, &name, &stats);
+  CHECK(stats.reconnects >= 1);
+  CHECK(stats.connected);
+  eventLoop_Stop(loop);
+  modbusPoller_Deinit();
+}
+
+static int compareInt64(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+/*
+ * 基准：BENCH_DEVICES 个设备各32个测点（分布在4个寄存器段），
+ * 比较逐点读取、合并、合并加流水线三种方式
+ * */
+static void benchmark(eventLoop_t *loop, int maxGap, int maxInFlight,
+                      const char *label) {
+  modbusPollerConfig_t config = {.maxDevices = BENCH_DEVICES,
+                                 .maxGap = maxGap,
+                                 .maxRegs = 125,
+                                 .maxInFlight = maxInFlight,
+                                 .timeoutMs = 1000};
+  CHECK(modbusPoller_Init(&config, loop, pollHandle, NULL) == 0);
+  for (int d = 0; d < BENCH_DEVICES; d++) {
+    modbusDeviceConfig_t device;
+    char name[24];
+    snprintf(name, sizeof(name), "dev%d", d);
+    initDevice(&device, name, 50);
+    for (int i = 0; i < MODBUS_MAX_POINTS; i++) {
+      char point[24];
+      snprintf(point, sizeof(point), "p%d", i);
+      // 4段，每段8个测点，测点间隔2个寄存器
+      uint16_t address = (uint16_t)((i / 8) * 200 + (i % 8) * 2);
+      addPoint(&device, point, i % 2 ? MODBUS_TABLE_HOLDING
+                                     : MODBUS_TABLE_INPUT,
+               address, MODBUS_TYPE_U16, 1);
+    }
+    CHECK(modbusPoller_AddDevice(&device) == d);
+  }
+  CHECK(eventLoop_Start(loop) == 0);
+
+  sleepMs(300); // 等待连接建立和轮询错开
+  resetRecords();
+  unsigned long registersBefore = 0;
+  const char *name;
+  modbusDeviceStats_t stats;
+  for (int d = 0; d < BENCH_DEVICES; d++) {
+    modbusPoller_GetDeviceStats(d, &name, &stats);
+    registersBefore += stats.registers;
+  }
+  double startUs = nowUs();
+  sleepMs(2000);
+  double elapsedS = (nowUs() - startUs) / 1e6;
+
+  unsigned long registers = 0, overruns = 0;
+  int requestsPerCycle = 0;
+  for (int d = 0; d < BENCH_DEVICES; d++) {
+    modbusPoller_GetDeviceStats(d, &name, &stats);
+    registers += stats.registers;
+    overruns += stats.overruns + stats.timeouts;
+    requestsPerCycle = stats.requestsPerCycle;
+    CHECK(stats.connected);
+  }
+  registers -= registersBefore;
+
+  pthread_mutex_lock(&g_recordLock);
+  unsigned long count = g_cycleRecords;
+  qsort(g_cycleUs, count, sizeof(int64_t), compareInt64);
+  CHECK(count > 0);
+  if (count > 0) {
+    printf("%s: %d devices, %d requests/cycle, %.0f registers/sec, "
+           "%.0f cycles/sec, cycle p50 %lld us, p99 %lld us, "
+           "%lu overruns\n",
+           label, BENCH_DEVICES, requestsPerCycle, registers / elapsedS,
+           count / elapsedS, (long long)g_cycleUs[count / 2],
+           (long long)g_cycleUs[count * 99 / 100], overruns);
+  }
+  pthread_mutex_unlock(&g_recordLock);
+  eventLoop_Stop(loop);
+  modbusPoller_Deinit();
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+  g_cycleUs = (int64_t *)malloc(MAX_CYCLE_RECORDS * sizeof(int64_t));
+
+  pthread_t sim;
+  eventLoop_t loop;
+  if (!g_cycleUs || simStart(&sim) != 0 ||
+      eventLoop_Init(&loop, 2 * BENCH_DEVICES + 8) != 0) {
+    fprintf(stderr, "setup failed\n");
+    return 1;
+  }
+
+  testPollAndDecode(&loop);
+  testException(&loop);
+  testTimeout(&loop);
+  benchmark(&loop, 0, 1, "per-point, sequential");
+  benchmark(&loop, 0, 8, "per-point, pipelined");
+  benchmark(&loop, 8, 1, "coalesced, sequential");
+  benchmark(&loop, 8, 8, "coalesced, pipelined");
+
+  g_simStop = 1;
+  pthread_join(sim, NULL);
+  close(g_simListenFd);
+  free(g_cycleUs);
+
+  return testReport("modbus_poller_test");
+}
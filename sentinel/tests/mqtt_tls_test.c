@@ -0,0 +1,316 @@
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/mqtt_tls.h"
+#include "test_check.h"
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * TLS辅助函数：配置检查、十六进制PSK解析和Paho的PSK回调。进程内的OpenSSL
+ * 服务端代替Broker，客户端按Paho根据 MQTTClient_SSLOptions 设置 SSL_CTX 的
+ * 方式配置（CA、客户端证书、PSK回调，设置PSK时使用TLS 1.2），比较完整证书
+ * 握手、PSK握手和（作为参考的）会话票据恢复的耗时。证书由 openssl 命令行
+ * 生成
+ * */
+#define CERT_DIR "/tmp/sentinel_tls_test"
+#define HANDSHAKES 50
+#define PSK_IDENTITY "ATK-IMX6U-01"
+#define PSK_KEY_HEX "00112233445566778899aabbccddeeff"
+
+static mqttTlsPsk_t g_psk;
+
+static double nowUs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int generateCerts(void) {
+  const char *script =
+      "set -e; rm -rf " CERT_DIR "; mkdir -p " CERT_DIR "; cd " CERT_DIR ";"
+      "for ca in ca other; do"
+      "  openssl req -x509 -newkey rsa:2048 -nodes -days 1 -subj /CN=$ca"
+      "    -keyout $ca.key -out $ca.crt;"
+      "done;"
+      "for n in server client; do"
+      "  openssl req -newkey rsa:2048 -nodes -subj /CN=$n"
+      "    -keyout $n.key -out $n.csr;"
+      "  openssl x509 -req -in $n.csr -CA ca.crt -CAkey ca.key"
+      "    -CAcreateserial -days 1 -out $n.crt;"
+      "done";
+  char cmd[1024];
+  snprintf(cmd, sizeof(cmd), "sh -c '%s' >/dev/null 2>&1", script);
+  return system(cmd) == 0 ? 0 : -1;
+}
+
+/* ---------------- 模拟Broker ---------------- */
+
+static unsigned int serverPskHandle(SSL *ssl, const char *identity,
+                                    unsigned char *psk,
+                                    unsigned int maxPskLen) {
+  unsigned char key[MQTT_TLS_PSK_KEY_MAX];
+  int keyLen = mqttTls_ParseHexKey(PSK_KEY_HEX, key, sizeof(key));
+  if (strcmp(identity, PSK_IDENTITY) != 0 || keyLen > (int)maxPskLen) {
+    return 0;
+  }
+  memcpy(psk, key, keyLen);
+  return keyLen;
+}
+
+/* psk: Broker只提供PSK套件；否则要求客户端证书 */
+static SSL_CTX *createServerCtx(bool psk) {
+  SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+  SSL_CTX_use_certificate_file(ctx, CERT_DIR "/server.crt", SSL_FILETYPE_PEM);
+  SSL_CTX_use_PrivateKey_file(ctx, CERT_DIR "/server.key", SSL_FILETYPE_PEM);
+  if (psk) {
+    SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_cipher_list(ctx, "PSK-AES128-GCM-SHA256");
+    SSL_CTX_set_psk_server_callback(ctx, serverPskHandle);
+  } else {
+    SSL_CTX_load_verify_locations(ctx, CERT_DIR "/ca.crt", NULL);
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT,
+                       NULL);
+    // 校验客户端证书时必须设置，否则会话无法恢复
+    SSL_CTX_set_session_id_context(ctx, (const unsigned char *)"sentinel", 8);
+  }
+  return ctx;
+}
+
+typedef struct {
+  SSL_CTX *ctx;
+  int fd;
+} serverJob_t;
+
+static void *serverThread(void *arg) {
+  serverJob_t *job = (serverJob_t *)arg;
+  SSL *ssl = SSL_new(job->ctx);
+  SSL_set_fd(ssl, job->fd);
+  if (SSL_accept(ssl) == 1) {
+    char byte;
+    SSL_read(ssl, &byte, 1);
+    SSL_shutdown(ssl);
+  }
+  SSL_free(ssl);
+  close(job->fd);
+  return NULL;
+}
+
+/* ---------------- 客户端（按paho的方式配置） ---------------- */
+
+/* paho在OpenSSL回调中转调 ssl_psk_cb，并传入 ssl_psk_context */
+static unsigned int clientPskHandle(SSL *ssl, const char *hint,
+                                    char *identity,
+                                    unsigned int maxIdentityLen,
+                                    unsigned char *psk,
+                                    unsigned int maxPskLen) {
+  return mqttTls_PskCallback(hint, identity, maxIdentityLen, psk, maxPskLen,
+                             &g_psk);
+}
+
+static SSL_CTX *createClientCtx(const char *caFile, bool psk) {
+  SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+  SSL_CTX_load_verify_locations(ctx, caFile, NULL);
+  SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, NULL);
+  SSL_CTX_use_certificate_file(ctx, CERT_DIR "/client.crt", SSL_FILETYPE_PEM);
+  SSL_CTX_use_PrivateKey_file(ctx, CERT_DIR "/client.key", SSL_FILETYPE_PEM);
+  if (psk) {
+    SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_psk_client_callback(ctx, clientPskHandle);
+  }
+  return ctx;
+}
+
+/*
+ * @brief  完成一次握手，返回耗时（微秒），失败返回-1。
+ *         session 非NULL时尝试恢复该会话，并在握手后换成新的会话
+ * */
+static double handshake(SSL_CTX *serverCtx, SSL_CTX *clientCtx,
+                        SSL_SESSION **session, bool *reused) {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    return -1;
+  }
+
+  serverJob_t job = {serverCtx, fds[1]};
+  pthread_t thread;
+  pthread_create(&thread, NULL, serverThread, &job);
+
+  SSL *ssl = SSL_new(clientCtx);
+  SSL_set_fd(ssl, fds[0]);
+  if (session && *session) {
+    SSL_set_session(ssl, *session);
+  }
+  double start = nowUs();
+  int ok = SSL_connect(ssl) == 1;
+  double elapsed = nowUs() - start;
+  if (ok) {
+    // TLS 1.3 的会话票据在握手之后才发送，写一个字节等待服务端读取
+    SSL_write(ssl, "x", 1);
+    char byte;
+    SSL_read(ssl, &byte, 1);
+    if (reused) {
+      *reused = SSL_session_reused(ssl);
+    }
+    if (session) {
+      SSL_SESSION_free(*session);
+      *session = SSL_get1_session(ssl);
+    }
+  } else {
+    ERR_clear_error();
+  }
+  SSL_free(ssl);
+  close(fds[0]);
+  pthread_join(thread, NULL);
+  return ok ? elapsed : -1;
+}
+
+static double averageHandshake(SSL_CTX *serverCtx, SSL_CTX *clientCtx,
+                               bool resume, int *reusedCount) {
+  SSL_SESSION *session = NULL;
+  double total = 0;
+  int count = 0;
+  *reusedCount = 0;
+  for (int i = 0; i < HANDSHAKES; i++) {
+    bool reused = false;
+    double us = handshake(serverCtx, clientCtx, resume ? &session : NULL,
+                          &reused);
+    CHECK(us >= 0);
+    // 恢复模式下第一次是完整握手，不计入
+    if (us >= 0 && (!resume || i > 0)) {
+      total += us;
+      count++;
+      *reusedCount += reused;
+    }
+  }
+  SSL_SESSION_free(session);
+  return count ? total / count : -1;
+}
+
+/* ---------------- 测试 ---------------- */
+
+static void testHexKey(void) {
+  unsigned char key[4];
+  CHECK(mqttTls_ParseHexKey("a0B1c2", key, sizeof(key)) == 3);
+  CHECK(key[0] == 0xa0 && key[1] == 0xb1 && key[2] == 0xc2);
+  CHECK(mqttTls_ParseHexKey("", key, sizeof(key)) == 0);
+  CHECK(mqttTls_ParseHexKey("abc", key, sizeof(key)) == -1);
+  CHECK(mqttTls_ParseHexKey("zz", key, sizeof(key)) == -1);
+  CHECK(mqttTls_ParseHexKey("0011223344", key, sizeof(key)) == -1);
+  CHECK(mqttTls_ParseHexKey(NULL, key, sizeof(key)) == -1);
+}
+
+static void testPskCallback(void) {
+  mqttTlsPsk_t psk;
+  CHECK(mqttTls_InitPsk(&psk, NULL, NULL) == 0 && psk.keyLen == 0);
+  CHECK(mqttTls_InitPsk(&psk, "id", "xyz") == -1);
+  CHECK(mqttTls_InitPsk(&psk, PSK_IDENTITY, PSK_KEY_HEX) == 0);
+  CHECK(psk.keyLen == 16);
+
+  char identity[64];
+  unsigned char key[64];
+  CHECK(mqttTls_PskCallback(NULL, identity, sizeof(identity), key,
+                            sizeof(key), &psk) == 16);
+  CHECK(strcmp(identity, PSK_IDENTITY) == 0 && key[15] == 0xff);
+  CHECK(psk.invocations == 1);
+  // 缓冲区不足时不使用PSK，也不计数
+  CHECK(mqttTls_PskCallback(NULL, identity, 4, key, sizeof(key), &psk) == 0);
+  CHECK(mqttTls_PskCallback(NULL, identity, sizeof(identity), key, 8,
+                            &psk) == 0);
+  CHECK(psk.invocations == 1);
+}
+
+static void testCheckConfig(void) {
+  mqttTlsConfig_t config;
+  memset(&config, 0, sizeof(config));
+  CHECK(mqttTls_CheckConfig(&config) == 0); // 未启用
+
+  config.enabled = true;
+  config.verifyServer = true;
+  CHECK(mqttTls_CheckConfig(&config) == -1); // 缺少CA
+  config.caFile = CERT_DIR "/ca.crt";
+  CHECK(mqttTls_CheckConfig(&config) == 0);
+  config.certFile = CERT_DIR "/client.crt";
+  CHECK(mqttTls_CheckConfig(&config) == -1); // 缺少私钥
+  config.keyFile = CERT_DIR "/missing.key";
+  CHECK(mqttTls_CheckConfig(&config) == -1);
+  config.keyFile = CERT_DIR "/client.key";
+  CHECK(mqttTls_CheckConfig(&config) == 0);
+  config.pskIdentity = PSK_IDENTITY;
+  config.pskKey = "0g";
+  CHECK(mqttTls_CheckConfig(&config) == -1);
+  config.pskKey = PSK_KEY_HEX;
+  CHECK(mqttTls_CheckConfig(&config) == 0);
+
+  // 复制后字符串来自内存池，与原配置无关
+  mqttTlsConfig_t copy;
+  mqttTls_CopyConfig(&copy, &config);
+  CHECK(copy.caFile != config.caFile &&
+        strcmp(copy.caFile, config.caFile) == 0);
+  CHECK(copy.caPath == NULL && copy.verifyServer);
+  mqttTls_FreeConfig(&copy);
+  CHECK(copy.caFile == NULL);
+}
+
+static void testHandshakes(void) {
+  SSL_CTX *certServer = createServerCtx(false);
+  SSL_CTX *pskServer = createServerCtx(true);
+  SSL_CTX *certClient = createClientCtx(CERT_DIR "/ca.crt", false);
+  SSL_CTX *pskClient = createClientCtx(CERT_DIR "/ca.crt", true);
+  SSL_CTX *wrongCaClient = createClientCtx(CERT_DIR "/other.crt", false);
+
+  // 服务端证书不是由配置的CA签发，握手必须失败
+  CHECK(handshake(certServer, wrongCaClient, NULL, NULL) < 0);
+
+  int reused = 0;
+  double fullUs = averageHandshake(certServer, certClient, false, &reused);
+  CHECK(fullUs > 0 && reused == 0);
+
+  mqttTls_InitPsk(&g_psk, PSK_IDENTITY, PSK_KEY_HEX);
+  double pskUs = averageHandshake(pskServer, pskClient, false, &reused);
+  CHECK(pskUs > 0);
+  // 每次握手恰好调用一次PSK回调，mqttClient据此统计PSK握手次数
+  CHECK(g_psk.invocations == HANDSHAKES);
+
+  // Broker不支持PSK时回退到证书握手，回调不被调用
+  g_psk.invocations = 0;
+  CHECK(handshake(certServer, pskClient, NULL, NULL) >= 0);
+  CHECK(g_psk.invocations == 0);
+
+  // 参考：会话恢复（paho没有提供复用会话的接口）
+  double resumedUs = averageHandshake(certServer, certClient, true, &reused);
+  // 会话能否恢复取决于本机OpenSSL的配置，只作参考，不作为测试条件
+  CHECK(resumedUs > 0);
+
+  printf("handshake: full (RSA-2048, mutual auth) %.0f us, PSK %.0f us, "
+         "session resumption %.0f us (%d/%d reused)\n",
+         fullUs, pskUs, resumedUs, reused, HANDSHAKES - 1);
+  CHECK(pskUs < fullUs);
+
+  SSL_CTX_free(certServer);
+  SSL_CTX_free(pskServer);
+  SSL_CTX_free(certClient);
+  SSL_CTX_free(pskClient);
+  SSL_CTX_free(wrongCaClient);
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+  if (generateCerts() != 0) {
+    fprintf(stderr, "setup failed (is the openssl tool installed?)\n");
+    return 1;
+  }
+
+  testHexKey();
+  testPskCallback();
+  testCheckConfig();
+  testHandshakes();
+
+  return testReport("mqtt_tls_test");
+}
@@ -0,0 +1,148 @@
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/mqtt_v5.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * MQTT 5辅助函数：重连前后的主题别名分配，属性和PUBLISH报文长度的编码，以及
+ * MQTT 3.1.1、不带别名的MQTT 5和带别名的MQTT 5发送每条遥测消息的字节数
+ * */
+static void testAliasTable(void) {
+  mqttTopicAliasTable_t table;
+  bool established;
+
+  CHECK(mqttV5_AliasInit(&table, MQTT_TOPIC_ALIAS_MAX + 1, 64) == -1);
+  CHECK(mqttV5_AliasInit(&table, 0, 64) == 0);
+  mqttV5_AliasReset(&table, 10);
+  CHECK(mqttV5_AliasLookup(&table, "a", &established) == 0);
+
+  CHECK(mqttV5_AliasInit(&table, 2, 16) == 0);
+  // 连接之前（或Broker不支持别名）不使用别名
+  CHECK(mqttV5_AliasLookup(&table, "a", &established) == 0);
+
+  mqttV5_AliasReset(&table, 10);
+  CHECK(table.max == 2);
+  CHECK(mqttV5_AliasLookup(&table, "sentinel/a", &established) == 1);
+  CHECK(!established);
+  CHECK(mqttV5_AliasLookup(&table, "sentinel/a", &established) == 1);
+  CHECK(established);
+  CHECK(mqttV5_AliasLookup(&table, "sentinel/b", &established) == 2);
+  CHECK(!established);
+  // 别名用完后新Topic按完整Topic发送，已有别名不受影响
+  CHECK(mqttV5_AliasLookup(&table, "sentinel/c", &established) == 0);
+  CHECK(mqttV5_AliasLookup(&table, "sentinel/b", &established) == 2);
+  CHECK(established);
+  CHECK(mqttV5_AliasLookup(&table, "sentinel/too-long-topic", &established) ==
+        0);
+
+  // 重连后别名重新分配，第一次使用必须再次携带Topic
+  mqttV5_AliasReset(&table, 1);
+  CHECK(table.max == 1);
+  CHECK(mqttV5_AliasLookup(&table, "sentinel/b", &established) == 1);
+  CHECK(!established);
+  CHECK(mqttV5_AliasLookup(&table, "sentinel/a", &established) == 0);
+
+  mqttV5_AliasReset(&table, 0);
+  CHECK(mqttV5_AliasLookup(&table, "sentinel/b", &established) == 0);
+  CHECK(!established);
+  mqttV5_AliasFree(&table);
+}
+
+static void testPacketSize(void) {
+  // 3.1.1：固定头1 + 剩余长度1 + Topic长度2 + "a/b" + "hi"
+  CHECK(mqttV5_PublishPacketSize(4, 3, 2, 0, 0) == 9);
+  // QoS 1 多2字节报文标识符
+  CHECK(mqttV5_PublishPacketSize(4, 3, 2, 1, 0) == 11);
+  // MQTT 5 多1字节属性长度
+  CHECK(mqttV5_PublishPacketSize(5, 3, 2, 0, 0) == 10);
+  // 剩余长度 >= 128 时变长整数为2字节
+  CHECK(mqttV5_PublishPacketSize(4, 3, 122, 0, 0) == 129);
+  CHECK(mqttV5_PublishPacketSize(4, 3, 123, 0, 0) == 131);
+
+  CHECK(mqttV5_PropertiesLength(NULL, 0) == 0);
+  CHECK(mqttV5_PropertiesLength(NULL, 1) == 3);
+  mqttPublishOptions_t options = {
+      .contentType = "application/json",
+      .messageExpirySec = 60,
+      .userPropertyCount = 1,
+      .userProperties = {{"dict", "1"}},
+  };
+  CHECK(mqttV5_PropertiesLength(&options, 0) == 19 + 5 + 10);
+  CHECK(mqttV5_PropertiesLength(&options, 3) == 19 + 5 + 10 + 3);
+}
+
+/* 模拟一段时间的遥测：状态和光照各 MESSAGES/2 条，QoS 0 */
+#define MESSAGES 120
+
+typedef struct {
+  const char *topic;
+  const char *payload;
+} sample_t;
+
+static double bytesPerMessage(int mqttVersion, int aliasMax,
+                              const mqttPublishOptions_t *options,
+                              const sample_t *samples, int sampleCount) {
+  mqttTopicAliasTable_t table;
+  mqttV5_AliasInit(&table, aliasMax, 64);
+  mqttV5_AliasReset(&table, aliasMax);
+
+  unsigned long bytes = 0;
+  for (int i = 0; i < MESSAGES; i++) {
+    const sample_t *sample = &samples[i % sampleCount];
+    bool established = false;
+    int alias = mqttV5_AliasLookup(&table, sample->topic, &established);
+    int topicLen = established ? 0 : (int)strlen(sample->topic);
+    int propertiesLen =
+        mqttVersion == 5 ? mqttV5_PropertiesLength(options, alias) : 0;
+    bytes += mqttV5_PublishPacketSize(mqttVersion, topicLen,
+                                      strlen(sample->payload), 0,
+                                      propertiesLen);
+  }
+  mqttV5_AliasFree(&table);
+  return (double)bytes / MESSAGES;
+}
+
+static void testBytesOnWire(void) {
+  const sample_t samples[] = {
+      {"sentinel/ATK-IMX6U-01/status",
+       "{\"timestamp_ms\": 1701374400,\"cpu_temp_c\": 45.250000,"
+       "\"cpu_load\": 0.120000,\"mem_usage_percent\": 31.500000,"
+       "\"peak_rss_kb\": 2048}"},
+      {"sentinel/ATK-IMX6U-01/light",
+       "{\"timestamp_ms\": 1701374400,\"light_lux\": 321,"
+       "\"infrared_cd\": 12, \"sensor_id\": \"light_sensor\"}"},
+  };
+  const mqttPublishOptions_t json = {.contentType = "application/json"};
+
+  double v3 = bytesPerMessage(4, 0, NULL, samples, 2);
+  double v5 = bytesPerMessage(5, 0, NULL, samples, 2);
+  double v5Alias = bytesPerMessage(5, 8, NULL, samples, 2);
+  double v5Json = bytesPerMessage(5, 0, &json, samples, 2);
+  double v5AliasJson = bytesPerMessage(5, 8, &json, samples, 2);
+
+  printf("bytes/message: 3.1.1 %.1f, v5 %.1f, v5+alias %.1f "
+         "(%.0f%% of 3.1.1), v5+content-type %.1f, "
+         "v5+alias+content-type %.1f\n",
+         v3, v5, v5Alias, 100.0 * v5Alias / v3, v5Json, v5AliasJson);
+
+  CHECK(v5 == v3 + 1);
+  // 状态/光照Topic约28字节，别名（3字节属性）每条节省约25字节
+  CHECK(v3 - v5Alias > 20);
+  CHECK(v5AliasJson < v5Json);
+
+  // 别名数量少于Topic数量时，多出的Topic按完整Topic发送
+  double v5OneAlias = bytesPerMessage(5, 1, NULL, samples, 2);
+  CHECK(v5OneAlias > v5Alias && v5OneAlias < v5);
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  testAliasTable();
+  testPacketSize();
+  testBytesOnWire();
+
+  return testReport("mqtt_v5_test");
+}
@@ -0,0 +1,281 @@
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/ota_update.h"
+#include "../include/modules/sha256.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * SHA-256测试向量和OTA下载：分片按MQTT回调交付的方式送入（8字节头加数据），
+ * 包括重复的分片、缺失的分片、传输中途掉电（未刷写的写缓冲丢失，从持久化的
+ * 偏移继续下载）、损坏的镜像，以及重启后分片大小超过写缓冲的已保存会话。
+ * 输出8 MB镜像的写入吞吐
+ * */
+#define TARGET "/tmp/sentinel_ota_test.img"
+#define STATE "/tmp/sentinel_ota_test.state"
+#define CHUNK 4096
+#define IMAGE_BYTES (8 * 1024 * 1024 + 1000)
+
+static int g_reports = 0;
+static otaStatus_t g_lastReport;
+
+static void progressHandle(const otaStatus_t *status, void *userData) {
+  g_reports++;
+  g_lastReport = *status;
+}
+
+static void testSha256(void) {
+  const struct {
+    const char *input;
+    const char *digest;
+  } vectors[] = {
+      {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+      {"abc",
+       "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+      {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+       "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+  };
+  for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    sha256_t sha;
+    uint8_t digest[SHA256_DIGEST_LEN];
+    char hex[SHA256_DIGEST_LEN * 2 + 1];
+    sha256_Init(&sha);
+    sha256_Update(&sha, vectors[i].input, strlen(vectors[i].input));
+    sha256_Final(&sha, digest);
+    sha256_ToHex(digest, hex);
+    CHECK(strcmp(hex, vectors[i].digest) == 0);
+  }
+
+  // 一百万个 'a'，按不规则长度分段输入
+  char block[997];
+  memset(block, 'a', sizeof(block));
+  sha256_t sha;
+  sha256_Init(&sha);
+  size_t left = 1000000;
+  size_t step = 1;
+  while (left > 0) {
+    size_t n = step < left ? step : left;
+    sha256_Update(&sha, block, n);
+    left -= n;
+    step = (step * 7 + 61) % sizeof(block) + 1;
+  }
+  uint8_t digest[SHA256_DIGEST_LEN];
+  uint8_t parsed[SHA256_DIGEST_LEN];
+  sha256_Final(&sha, digest);
+  CHECK(sha256_ParseHex("cdc76e5c9914fb9281a1c7e284d73e67"
+                        "f1809a48a497200e046d39ccc7112cd0",
+                        parsed) == 0);
+  CHECK(memcmp(digest, parsed, SHA256_DIGEST_LEN) == 0);
+  CHECK(sha256_ParseHex("xyz", parsed) != 0);
+}
+
+/* 生成带头的分片消息 */
+static int makeChunk(uint8_t *out, uint32_t session, uint32_t seq,
+                     const uint8_t *image, size_t size) {
+  size_t offset = (size_t)seq * CHUNK;
+  size_t len = size - offset < CHUNK ? size - offset : CHUNK;
+  uint32_t fields[2] = {session, seq};
+  for (int i = 0; i < 2; i++) {
+    out[i * 4] = (uint8_t)(fields[i] >> 24);
+    out[i * 4 + 1] = (uint8_t)(fields[i] >> 16);
+    out[i * 4 + 2] = (uint8_t)(fields[i] >> 8);
+    out[i * 4 + 3] = (uint8_t)fields[i];
+  }
+  memcpy(out + OTA_CHUNK_HEADER, image + offset, len);
+  return (int)(OTA_CHUNK_HEADER + len);
+}
+
+static bool fileMatches(const uint8_t *image, size_t size) {
+  FILE *fp = fopen(TARGET, "rb");
+  if (!fp) {
+    return false;
+  }
+  uint8_t *copy = malloc(size + 1);
+  size_t n = fread(copy, 1, size + 1, fp);
+  fclose(fp);
+  bool same = n == size && memcmp(copy, image, size) == 0;
+  free(copy);
+  return same;
+}
+
+static double elapsedSec(const struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+  testSha256();
+
+  unlink(TARGET);
+  unlink(STATE);
+  uint8_t *image = malloc(IMAGE_BYTES);
+  srand(1);
+  for (size_t i = 0; i < IMAGE_BYTES; i++) {
+    image[i] = (uint8_t)rand();
+  }
+  uint8_t digest[SHA256_DIGEST_LEN];
+  sha256_t sha;
+  sha256_Init(&sha);
+  sha256_Update(&sha, image, IMAGE_BYTES);
+  sha256_Final(&sha, digest);
+  uint32_t chunks = (IMAGE_BYTES + CHUNK - 1) / CHUNK;
+
+  otaConfig_t config = {
+      .target = TARGET,
+      .stateFile = STATE,
+      .bufferBytes = 65536,
+      .maxChunkBytes = CHUNK,
+      .progressStepPercent = 10,
+  };
+  otaUpdate_t ota;
+  otaStatus_t status;
+  uint8_t message[OTA_CHUNK_HEADER + CHUNK];
+  CHECK(otaUpdate_Init(&ota, &config, progressHandle, NULL) == 0);
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.state == OTA_STATE_IDLE);
+
+  // 分片大小必须按扇区对齐、整除写缓冲且不超过上限
+  CHECK(otaUpdate_Begin(&ota, 7, IMAGE_BYTES, 1000, digest) != 0);
+  CHECK(otaUpdate_Begin(&ota, 7, IMAGE_BYTES, 2 * CHUNK, digest) != 0);
+  CHECK(otaUpdate_Begin(&ota, 7, IMAGE_BYTES, CHUNK, digest) == 0);
+
+  // 前40%，其间有重复分片和一个缺口
+  uint32_t crashAt = chunks * 2 / 5;
+  for (uint32_t seq = 0; seq < crashAt; seq++) {
+    int len = makeChunk(message, 7, seq, image, IMAGE_BYTES);
+    CHECK(otaUpdate_WriteChunk(&ota, message, len) == 0);
+    if (seq == 10) {
+      CHECK(otaUpdate_WriteChunk(&ota, message, len) == 0);
+    }
+    if (seq == 20) {
+      int reports = g_reports;
+      len = makeChunk(message, 7, seq + 2, image, IMAGE_BYTES);
+      CHECK(otaUpdate_WriteChunk(&ota, message, len) != 0);
+      len = makeChunk(message, 7, seq + 3, image, IMAGE_BYTES);
+      CHECK(otaUpdate_WriteChunk(&ota, message, len) != 0);
+      CHECK(g_reports == reports + 1 && g_lastReport.nextSeq == seq + 1);
+    }
+  }
+  int len = makeChunk(message, 99, crashAt, image, IMAGE_BYTES);
+  CHECK(otaUpdate_WriteChunk(&ota, message, len) != 0);
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.received == (uint64_t)crashAt * CHUNK);
+  CHECK(status.duplicates == 1 && status.gaps == 2);
+  CHECK(status.committed % config.bufferBytes == 0);
+  CHECK(status.committed < status.received);
+
+  // 掉电：写缓冲丢失，重新初始化后从持久化的偏移继续
+  uint64_t committed = status.committed;
+  close(ota.fd);
+  CHECK(otaUpdate_Init(&ota, &config, progressHandle, NULL) == 0);
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.state == OTA_STATE_DOWNLOADING && status.resumed);
+  CHECK(status.received == committed);
+  CHECK(status.nextSeq == committed / CHUNK);
+  CHECK(otaUpdate_Begin(&ota, 7, IMAGE_BYTES, CHUNK, digest) == 0);
+
+  for (uint32_t seq = status.nextSeq - 2; seq < chunks; seq++) {
+    len = makeChunk(message, 7, seq, image, IMAGE_BYTES);
+    CHECK(otaUpdate_WriteChunk(&ota, message, len) == 0);
+  }
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.state == OTA_STATE_VERIFIED);
+  CHECK(status.committed == IMAGE_BYTES && status.duplicates == 2);
+  CHECK(g_lastReport.state == OTA_STATE_VERIFIED);
+  CHECK(fileMatches(image, IMAGE_BYTES));
+
+  // 已校验的镜像再次 start 保持 verified
+  CHECK(otaUpdate_Begin(&ota, 7, IMAGE_BYTES, CHUNK, digest) == 0);
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.state == OTA_STATE_VERIFIED);
+  CHECK(otaUpdate_Apply(&ota) != 0); // 未配置 applyCommand
+
+  // 完整下载一次，测量写入速率
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  CHECK(otaUpdate_Begin(&ota, 8, IMAGE_BYTES, CHUNK, digest) == 0);
+  for (uint32_t seq = 0; seq < chunks; seq++) {
+    len = makeChunk(message, 8, seq, image, IMAGE_BYTES);
+    otaUpdate_WriteChunk(&ota, message, len);
+  }
+  double seconds = elapsedSec(&start);
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.state == OTA_STATE_VERIFIED);
+  CHECK(status.writes == (IMAGE_BYTES + 65535) / 65536);
+  printf("8 MB image in %.2f s (%.1f MB/s, %lu writes of %u bytes)\n",
+         seconds, IMAGE_BYTES / seconds / 1048576, status.writes,
+         config.bufferBytes);
+
+  // 损坏的镜像
+  CHECK(otaUpdate_Begin(&ota, 9, IMAGE_BYTES, CHUNK, digest) == 0);
+  image[IMAGE_BYTES / 2] ^= 0x01;
+  for (uint32_t seq = 0; seq < chunks; seq++) {
+    len = makeChunk(message, 9, seq, image, IMAGE_BYTES);
+    otaUpdate_WriteChunk(&ota, message, len);
+  }
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.state == OTA_STATE_FAILED);
+  CHECK(strcmp(status.error, "sha256 mismatch") == 0);
+
+  // 分片长度错误
+  CHECK(otaUpdate_Begin(&ota, 10, IMAGE_BYTES, CHUNK, digest) == 0);
+  len = makeChunk(message, 10, 0, image, IMAGE_BYTES);
+  CHECK(otaUpdate_WriteChunk(&ota, message, len - 1) != 0);
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.state == OTA_STATE_FAILED);
+
+  otaUpdate_Abort(&ota);
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.state == OTA_STATE_IDLE);
+  CHECK(access(STATE, F_OK) != 0);
+
+  // 重启后写缓冲变小（仍然对齐，但不能被分片整除）：放弃续传，从0开始
+  CHECK(otaUpdate_Begin(&ota, 11, IMAGE_BYTES, CHUNK, digest) == 0);
+  for (uint32_t seq = 0; seq < 40; seq++) {
+    len = makeChunk(message, 11, seq, image, IMAGE_BYTES);
+    CHECK(otaUpdate_WriteChunk(&ota, message, len) == 0);
+  }
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.committed > 0);
+  otaUpdate_Deinit(&ota);
+  otaConfig_t smaller = config;
+  smaller.bufferBytes = 6 * 1024;
+  CHECK(otaUpdate_Init(&ota, &smaller, progressHandle, NULL) == 0);
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.state == OTA_STATE_FAILED && !status.resumed);
+  CHECK(status.committed == 0 && status.nextSeq == 0);
+  CHECK(otaUpdate_Begin(&ota, 11, IMAGE_BYTES, CHUNK, digest) != 0);
+  CHECK(otaUpdate_Begin(&ota, 11, IMAGE_BYTES, 2048, digest) == 0);
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.state == OTA_STATE_DOWNLOADING && status.nextSeq == 0);
+  len = makeChunk(message, 11, 0, image, IMAGE_BYTES);
+  CHECK(otaUpdate_WriteChunk(&ota, message, len) != 0); // 4096字节的旧分片
+  otaUpdate_Abort(&ota);
+  otaUpdate_Deinit(&ota);
+
+  // 分片上限在重启后收紧（静态内存模式）同样放弃续传
+  CHECK(otaUpdate_Init(&ota, &config, progressHandle, NULL) == 0);
+  CHECK(otaUpdate_Begin(&ota, 12, IMAGE_BYTES, CHUNK, digest) == 0);
+  for (uint32_t seq = 0; seq < 20; seq++) {
+    len = makeChunk(message, 12, seq, image, IMAGE_BYTES);
+    otaUpdate_WriteChunk(&ota, message, len);
+  }
+  otaUpdate_Deinit(&ota);
+  smaller = config;
+  smaller.maxChunkBytes = 1024;
+  CHECK(otaUpdate_Init(&ota, &smaller, progressHandle, NULL) == 0);
+  otaUpdate_GetStatus(&ota, &status);
+  CHECK(status.state == OTA_STATE_FAILED);
+  otaUpdate_Abort(&ota);
+  otaUpdate_Deinit(&ota);
+
+  free(image);
+  unlink(TARGET);
+  return testReport("ota_update_test");
+}
@@ -0,0 +1,107 @@
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/payload_codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * 上行载荷编解码的往返检查和基准。用工具链编译（cmake
+ * -DCMAKE_TOOLCHAIN_FILE=toolchain.cmake）后在板上运行，得到Cortex-A7上的
+ * 数据
+ * */
+static double nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int bench(payloadCodec_t *codec, const char *name, const char *payload) {
+  static uint8_t packed[PAYLOAD_CODEC_BOUND(8192)];
+  static char unpacked[8192];
+  int len = strlen(payload);
+  int rounds = 20000;
+
+  int packedLen = payloadCodec_Compress(codec, payload, len, packed,
+                                        sizeof(packed));
+  if (packedLen < 0) {
+    printf("%-14s raw %5d B, not compressible\n", name, len);
+    return -1;
+  }
+  int outLen = payloadCodec_Decompress(packed, packedLen, unpacked,
+                                       sizeof(unpacked));
+  if (outLen != len || memcmp(unpacked, payload, len) != 0) {
+    fprintf(stderr, "FAIL: %s round trip mismatch\n", name);
+    return -1;
+  }
+
+  double t0 = nowNs();
+  for (int i = 0; i < rounds; i++) {
+    payloadCodec_Compress(codec, payload, len, packed, sizeof(packed));
+  }
+  double t1 = nowNs();
+  for (int i = 0; i < rounds; i++) {
+    payloadCodec_Decompress(packed, packedLen, unpacked, sizeof(unpacked));
+  }
+  double t2 = nowNs();
+
+  printf("%-14s raw %5d B -> %5d B (%.1f%%), compress %.2f us/msg, "
+         "decompress %.2f us/msg\n",
+         name, len, packedLen, 100.0 * packedLen / len,
+         (t1 - t0) / rounds / 1000, (t2 - t1) / rounds / 1000);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  payloadCodecConfig_t config = {
+      .enabled = true, .minBytes = 32, .maxPayloadBytes = 8192};
+  payloadCodec_t codec;
+  char status[256], light[256], batch[8192];
+  int failed = 0;
+
+  memPool_Init(&memConfig);
+  if (payloadCodec_Init(&codec, &config) != 0) {
+    return EXIT_FAILURE;
+  }
+
+  snprintf(status, sizeof(status),
+           "{\"timestamp_ms\": %ld,\"cpu_temp_c\": %lf,\"cpu_load\": "
+           "%f,\"mem_usage_percent\": %f,\"peak_rss_kb\": %ld}",
+           1760000123L, 48.312, 12.5, 37.25, 3948L);
+  snprintf(light, sizeof(light),
+           "{\"timestamp_ms\": %ld,\"light_lux\": %d,\"infrared_cd\": %d, "
+           "\"sensor_id\": \"%s\"}",
+           1760000123L, 512, 37, "light_sensor");
+
+  // 60 samples in one payload, as a buffered upload would send them
+  int pos = snprintf(batch, sizeof(batch), "[");
+  for (int i = 0; i < 60; i++) {
+    pos += snprintf(batch + pos, sizeof(batch) - pos,
+                    "%s{\"timestamp_ms\": %ld,\"light_lux\": %d,"
+                    "\"infrared_cd\": %d, \"sensor_id\": \"light_sensor\"}",
+                    i ? "," : "", 1760000123L + i, 500 + (i * 7) % 40,
+                    30 + i % 5);
+  }
+  snprintf(batch + pos, sizeof(batch) - pos, "]");
+
+  failed |= bench(&codec, "status", status);
+  failed |= bench(&codec, "light", light);
+  failed |= bench(&codec, "light x60", batch);
+
+  // corrupted frames must be rejected, never overrun the output
+  uint8_t packed[PAYLOAD_CODEC_BOUND(256)];
+  char out[256];
+  int packedLen = payloadCodec_Compress(&codec, status, strlen(status), packed,
+                                        sizeof(packed));
+  for (int cut = 1; cut < packedLen; cut++) {
+    if (payloadCodec_Decompress(packed, cut, out, sizeof(out)) ==
+        (int)strlen(status)) {
+      fprintf(stderr, "FAIL: truncated frame accepted\n");
+      failed = 1;
+    }
+  }
+
+  printf("%s\n", failed ? "FAIL" : "PASS");
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,214 @@
+#include "../include/modules/perf_counters.h"
+#include "test_check.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * 硬件计数器：一个模拟的采样周期（从类似 sysfs 的文件读传感器、JSON序列化、
+ * 写入由消费者读取的管道）用 PERF_LAP 分成几个阶段，输出每个阶段的耗时、
+ * 周期数、IPC、缓存和分支未命中以及上下文切换。perf_event_open 被拒绝时
+ * （容器、没有PMU的虚拟机、perf_event_paranoid）硬件列为空，耗时和上下文
+ * 切换（getrusage）照常统计。另外检查关闭时的快速路径、重置，以及线程退出
+ * 时关闭它打开的计数器
+ * */
+#define CYCLES 5000
+#define HW_EVENTS                                                              \
+  ((1u << PERF_EVENT_CYCLES) | (1u << PERF_EVENT_INSTRUCTIONS) |               \
+   (1u << PERF_EVENT_CACHE_MISSES) | (1u << PERF_EVENT_BRANCH_MISSES))
+
+static int g_pipe[2];
+
+static double nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static const perfStageStats_t *findStage(const perfStageStats_t *stages,
+                                         int count, const char *name) {
+  for (int i = 0; i < count; i++) {
+    if (strcmp(stages[i].name, name) == 0) {
+      return &stages[i];
+    }
+  }
+  return NULL;
+}
+
+static int countOpenFds(void) {
+  int count = 0;
+  DIR *dir = opendir("/proc/self/fd");
+  while (dir && readdir(dir)) {
+    count++;
+  }
+  if (dir) {
+    closedir(dir);
+  }
+  return count;
+}
+
+/* 一个采样周期：读取、序列化、入队，与采样线程的阶段划分一致 */
+static void samplingCycle(int seq) {
+  perfSnapshot_t perf;
+  perfCounters_Begin(&perf);
+
+  char raw[256];
+  int fd = open("/proc/self/stat", O_RDONLY);
+  ssize_t n = fd >= 0 ? read(fd, raw, sizeof(raw) - 1) : 0;
+  if (fd >= 0) {
+    close(fd);
+  }
+  raw[n > 0 ? n : 0] = '\0';
+  int lux = 0;
+  for (ssize_t i = 0; i < n; i++) {
+    lux += raw[i];
+  }
+  PERF_LAP(&perf, "read");
+
+  char payload[256];
+  int len = snprintf(payload, sizeof(payload),
+                     "{\"timestamp_ms\": %d,\"light_lux\": %d,"
+                     "\"infrared_cd\": %d, \"sensor_id\": \"%s\", "
+                     "\"sample_hz\": %.2f}",
+                     seq, lux, lux / 3, "light_sensor", 10.0 / (seq % 7 + 1));
+  PERF_LAP(&perf, "serialize");
+
+  if (write(g_pipe[1], payload, len) == len) {
+    char drain[256];
+    CHECK(read(g_pipe[0], drain, sizeof(drain)) == len);
+  }
+  PERF_LAP(&perf, "publish");
+}
+
+static void printStages(const perfStageStats_t *stages, int count) {
+  printf("%-10s %8s %10s %10s %6s %8s %8s %6s\n", "stage", "samples",
+         "avg_ns", "cycles", "ipc", "cache", "branch", "cs");
+  for (int i = 0; i < count; i++) {
+    const perfStageStats_t *s = &stages[i];
+    double avg[PERF_EVENT_COUNT];
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+      avg[e] = s->counted[e] ? (double)s->counts[e] / s->counted[e] : -1;
+    }
+    double ipc = avg[PERF_EVENT_CYCLES] > 0
+                     ? avg[PERF_EVENT_INSTRUCTIONS] / avg[PERF_EVENT_CYCLES]
+                     : -1;
+    printf("%-10s %8lu %10.0f %10.0f %6.2f %8.1f %8.1f %6.3f\n", s->name,
+           s->samples, (double)s->wallNs / s->samples, avg[PERF_EVENT_CYCLES],
+           ipc, avg[PERF_EVENT_CACHE_MISSES], avg[PERF_EVENT_BRANCH_MISSES],
+           avg[PERF_EVENT_CONTEXT_SWITCHES]);
+  }
+}
+
+static void testDisabled(void) {
+  perfCounters_SetEnabled(false);
+  for (int i = 0; i < 100; i++) {
+    samplingCycle(i);
+  }
+  perfStageStats_t stages[8];
+  CHECK(perfCounters_GetStages(stages, 8) == 0);
+}
+
+static void testStages(void) {
+  perfCounters_SetEnabled(true);
+  for (int i = 0; i < CYCLES; i++) {
+    samplingCycle(i);
+  }
+
+  perfCountersStatus_t status;
+  perfCounters_GetStatus(&status);
+  bool hardware = (status.available & HW_EVENTS) != 0;
+  printf("perf_event_paranoid %d, available 0x%x (%s)\n", status.paranoid,
+         status.available,
+         hardware ? "hardware counters"
+                  : status.openErrno ? strerror(status.openErrno) : "none");
+  CHECK(status.available & (1u << PERF_EVENT_CONTEXT_SWITCHES));
+
+  perfStageStats_t stages[8];
+  int count = perfCounters_GetStages(stages, 8);
+  CHECK(count == 3);
+  CHECK(count == 3 && strcmp(stages[0].name, "read") == 0 &&
+        strcmp(stages[2].name, "publish") == 0);
+  printStages(stages, count);
+
+  for (int i = 0; i < count; i++) {
+    const perfStageStats_t *s = &stages[i];
+    CHECK(s->samples == CYCLES);
+    CHECK(s->wallNs > 0 && s->maxWallNs > 0);
+    CHECK(s->counted[PERF_EVENT_CONTEXT_SWITCHES] == CYCLES);
+    for (int e = 0; e < PERF_EVENT_CONTEXT_SWITCHES; e++) {
+      if (!(status.available & (1u << e))) {
+        // 不可用的事件不能留下计数
+        CHECK(s->counted[e] == 0 && s->counts[e] == 0);
+      }
+    }
+  }
+  const perfStageStats_t *serialize = findStage(stages, count, "serialize");
+  if (hardware && serialize &&
+      (status.available & (1u << PERF_EVENT_INSTRUCTIONS))) {
+    CHECK(serialize->counted[PERF_EVENT_INSTRUCTIONS] > 0);
+    CHECK(serialize->counts[PERF_EVENT_INSTRUCTIONS] > 0);
+  }
+
+  perfCounters_Reset();
+  CHECK(perfCounters_GetStages(stages, 8) == 0);
+}
+
+/* 每个阶段边界的开销：关闭时只有一次原子读 */
+static void testOverhead(void) {
+  const int laps = 200000;
+  perfSnapshot_t perf;
+  for (int enabled = 0; enabled <= 1; enabled++) {
+    perfCounters_SetEnabled(enabled);
+    perfCounters_Begin(&perf);
+    double startNs = nowNs();
+    for (int i = 0; i < laps; i++) {
+      PERF_LAP(&perf, "overhead");
+    }
+    printf("lap overhead %s: %.1f ns\n", enabled ? "enabled" : "disabled",
+           (nowNs() - startNs) / laps);
+  }
+  perfCounters_SetEnabled(false);
+  perfCounters_Reset();
+}
+
+static void *sampledThread(void *arg) {
+  for (int i = 0; i < 10; i++) {
+    samplingCycle(i);
+  }
+  return NULL;
+}
+
+/* 采样线程被看门狗重建时，旧线程的计数器随线程退出关闭 */
+static void testThreadExit(void) {
+  perfCounters_SetEnabled(true);
+  int before = countOpenFds();
+  for (int i = 0; i < 20; i++) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, sampledThread, NULL);
+    pthread_join(thread, NULL);
+  }
+  CHECK(countOpenFds() == before);
+
+  perfStageStats_t stages[8];
+  int count = perfCounters_GetStages(stages, 8);
+  const perfStageStats_t *read = findStage(stages, count, "read");
+  CHECK(read && read->samples == 200);
+  perfCounters_SetEnabled(false);
+}
+
+int main(void) {
+  if (pipe(g_pipe) != 0) {
+    return 1;
+  }
+
+  testDisabled();
+  testStages();
+  testOverhead();
+  testThreadExit();
+
+  return testReport("perf_counters_test");
+}
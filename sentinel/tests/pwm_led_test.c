@@ -0,0 +1,120 @@
+#include "../include/modules/command_dispatch.h"
+#include "../include/modules/event_loop.h"
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/pwm_led.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * PWM执行器，使用假的 sysfs 目录：通过命令分发执行 set / fade / blink，由
+ * 共用的事件循环定时器驱动
+ * */
+#define FAKE_ROOT "/tmp/sentinel_fake_pwm"
+
+static long readDuty(void) {
+  char buffer[32] = {0};
+  FILE *fp = fopen(FAKE_ROOT "/pwmchip0/pwm0/duty_cycle", "r");
+  if (!fp)
+    return -1;
+  if (fgets(buffer, sizeof(buffer), fp) == NULL)
+    buffer[0] = '\0';
+  fclose(fp);
+  return strtol(buffer, NULL, 10);
+}
+
+static void touch(const char *path) {
+  FILE *fp = fopen(path, "w");
+  if (fp)
+    fclose(fp);
+}
+
+static void runLoopMs(eventLoop_t *loop, int ms) {
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  do {
+    eventLoop_RunOnce(loop, 10);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  } while ((now.tv_sec - start.tv_sec) * 1000 +
+               (now.tv_nsec - start.tv_nsec) / 1000000 <
+           ms);
+}
+
+static int sendCommand(const char *json, sentinelCommandResult_t *result) {
+  sentinelCommand_t cmd;
+  if (commandDispatch_Parse(json, strlen(json), &cmd) != 0)
+    return -1;
+  return commandDispatch_Execute(&cmd, result);
+}
+
+int main(int argc, char *argv[]) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  if (system("rm -rf " FAKE_ROOT) != 0)
+    return EXIT_FAILURE;
+  mkdir(FAKE_ROOT, 0755);
+  mkdir(FAKE_ROOT "/pwmchip0", 0755);
+  mkdir(FAKE_ROOT "/pwmchip0/pwm0", 0755);
+  touch(FAKE_ROOT "/pwmchip0/export");
+  touch(FAKE_ROOT "/pwmchip0/pwm0/period");
+  touch(FAKE_ROOT "/pwmchip0/pwm0/duty_cycle");
+  touch(FAKE_ROOT "/pwmchip0/pwm0/enable");
+
+  pwmLedConfig_t config = {.sysfsRoot = FAKE_ROOT, .tickUs = 5000};
+  config.channelCount = 1;
+  snprintf(config.channels[0].name, sizeof(config.channels[0].name),
+           "pwm_led0");
+  config.channels[0].periodNs = 1000000;
+
+  eventLoop_t loop;
+  CHECK(eventLoop_Init(&loop, 8) == 0);
+  CHECK(pwmLed_Init(&config, &loop) == 0);
+
+  sentinelCommandResult_t result;
+  CHECK(sendCommand("{\"command_id\":\"1\",\"target\":\"pwm_led0\",\"action\":"
+                    "\"set\",\"value\":50}",
+                    &result) == COMMAND_OK);
+  CHECK(readDuty() == 500000);
+
+  // 200 steps over 1 s
+  CHECK(sendCommand("{\"command_id\":\"2\",\"target\":\"pwm_led0\",\"action\":"
+                    "\"fade\",\"value\":100,\"device_specific_params\":"
+                    "{\"duration_ms\":1000}}",
+                    &result) == COMMAND_OK);
+  runLoopMs(&loop, 500);
+  long mid = readDuty();
+  CHECK(mid > 600000 && mid < 900000);
+  runLoopMs(&loop, 600);
+  CHECK(readDuty() == 1000000);
+
+  pwmLatencyStats_t stats;
+  pwmLed_GetLatencyStats(&stats);
+  unsigned long fadeWrites = stats.writes;
+
+  CHECK(sendCommand("{\"command_id\":\"3\",\"target\":\"pwm_led0\",\"action\":"
+                    "\"blink\",\"value\":100,\"device_specific_params\":"
+                    "{\"period_ms\":100,\"count\":3}}",
+                    &result) == COMMAND_OK);
+  runLoopMs(&loop, 400);
+  CHECK(readDuty() == 0);
+  CHECK(pwmLed_GetLevel("pwm_led0") == 0);
+
+  CHECK(sendCommand("{\"command_id\":\"4\",\"target\":\"pwm_led0\",\"action\":"
+                    "\"set\",\"value\":150}",
+                    &result) == COMMAND_ERR_INVALID_VALUE);
+
+  pwmLed_GetLatencyStats(&stats);
+  printf("fade writes = %lu, total writes = %lu\n", fadeWrites, stats.writes);
+  printf("command->output latency: avg %.1f us, max %.1f us (%lu samples)\n",
+         stats.totalNs / 1000.0 / stats.count, stats.maxNs / 1000.0,
+         stats.count);
+  printf("%s\n", result.resultData);
+
+  pwmLed_Deinit();
+  return testReport("pwm_led_test");
+}
@@ -0,0 +1,241 @@
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/sim_broker.h"
+#include "../include/modules/sim_clock.h"
+#include "../include/modules/sim_sensor.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * 仿真Broker和传感器，在主线程中按虚拟时钟驱动："close" 中断在开始时立即
+ * 结束会话，结束前拒绝重连；黑洞在第一次没有应答的 ping 之后一个保活周期
+ * 被发现，短于保活周期的黑洞只丢失其间发出的消息。丢弃和丢失确认的统计
+ * 能对上，相同种子时结果相同；探测与客户端地址共用同一个Broker；回放的传感
+ * 器数值按阶梯保持并循环
+ * */
+static simBrokerConfig_t baseConfig(void) {
+  simBrokerConfig_t config;
+  memset(&config, 0, sizeof(config));
+  config.seed = 1;
+  config.latencyMs = 20;
+  return config;
+}
+
+static void addOutage(simBrokerConfig_t *config, int64_t startMs,
+                      int64_t durationMs, simOutageMode_t mode) {
+  simOutage_t *outage = &config->outages[config->outageCount++];
+  outage->startMs = startMs;
+  outage->durationMs = durationMs;
+  outage->mode = mode;
+  outage->broker = -1;
+}
+
+/* 持续 yield 直到连接断开，返回断开时的虚拟时间 */
+static int64_t yieldUntilLost(simBrokerSession_t *session, int64_t limitMs) {
+  while (simClock_ElapsedMs() < limitMs) {
+    if (simBroker_Yield(session, 1000) != 0) {
+      return simClock_ElapsedMs();
+    }
+  }
+  return -1;
+}
+
+static void testCloseOutage(void) {
+  simBrokerConfig_t config = baseConfig();
+  addOutage(&config, 10000, 5000, SIM_OUTAGE_CLOSE);
+  simClock_Start(0);
+  CHECK(simBroker_Init(&config) == 0);
+
+  simBrokerSession_t session;
+  CHECK(simBroker_Open(&session, "tcp://127.0.0.1:1883", 60, 3000) == 0);
+  CHECK(simBroker_Connect(&session) == 0);
+  CHECK(simClock_ElapsedMs() == 40); // 一个往返
+  CHECK(simBroker_Publish(&session, 10, 1) == 0);
+  CHECK(yieldUntilLost(&session, 20000) == 10000);
+  CHECK(simBroker_Publish(&session, 10, 1) == -1);
+
+  // 中断期间重连被拒绝（一个往返后），结束后恢复
+  CHECK(simBroker_Connect(&session) == -1);
+  CHECK(simClock_ElapsedMs() == 10040);
+  simClock_SleepMs(5000);
+  CHECK(simBroker_Connect(&session) == 0);
+
+  simBrokerStats_t stats;
+  CHECK(simBroker_GetStats(&stats, 1) == 1);
+  CHECK(strcmp(stats.address, "127.0.0.1:1883") == 0);
+  CHECK(stats.connects == 2);
+  CHECK(stats.connectFailures == 1);
+  CHECK(stats.sessionsLost == 1);
+  CHECK(stats.received == 1);
+  CHECK(stats.refused == 1);
+  CHECK(stats.bytes == 10);
+  CHECK(stats.outageMs == 5000);
+  simClock_Release();
+}
+
+static void testBlackhole(void) {
+  simBrokerConfig_t config = baseConfig();
+  addOutage(&config, 100000, 200000, SIM_OUTAGE_BLACKHOLE);
+  addOutage(&config, 400000, 5000, SIM_OUTAGE_BLACKHOLE);
+  simClock_Start(0);
+  CHECK(simBroker_Init(&config) == 0);
+
+  simBrokerSession_t session;
+  CHECK(simBroker_Open(&session, "tcp://10.0.0.1", 60, 3000) == 0);
+  CHECK(simBroker_Connect(&session) == 0);
+
+  // 连接于 40ms，PINGREQ 在 40+60000k：中断后第一次为 120040，再过一个
+  // keep-alive 间隔发现断开
+  simClock_SleepMs(100000 - 40);
+  CHECK(simBroker_Publish(&session, 10, 1) == 0); // 发出但丢失
+  CHECK(yieldUntilLost(&session, 300000) == 180040);
+
+  // 报文被丢弃时连接等到超时才失败
+  CHECK(simBroker_Connect(&session) == -1);
+  CHECK(simClock_ElapsedMs() == 183040);
+  simClock_SleepMs(300000 - 183040);
+  CHECK(simBroker_Connect(&session) == 0);
+
+  // 连接于 300040，5秒的中断落在两次PINGREQ之间，不会被发现
+  simClock_SleepMs(400000 - 300040);
+  CHECK(simBroker_Publish(&session, 10, 0) == 0);
+  CHECK(yieldUntilLost(&session, 500000) == -1);
+  CHECK(simBroker_Publish(&session, 10, 0) == 0);
+
+  simBrokerStats_t stats;
+  CHECK(simBroker_GetStats(&stats, 1) == 1);
+  CHECK(strcmp(stats.address, "10.0.0.1:1883") == 0);
+  CHECK(stats.sessionsLost == 1);
+  CHECK(stats.lost == 2);
+  CHECK(stats.received == 1);
+  CHECK(stats.outageMs == 205000);
+  simClock_Release();
+}
+
+/* 发送 count 条消息后返回统计 */
+static simBrokerStats_t publishMany(const simBrokerConfig_t *config,
+                                    int count, int qos) {
+  simClock_Start(0);
+  simBroker_Init(config);
+  simBrokerSession_t session;
+  simBroker_Open(&session, "tcp://broker.local:1883", 60, 3000);
+  CHECK(simBroker_Connect(&session) == 0);
+  for (int i = 0; i < count; i++) {
+    CHECK(simBroker_Publish(&session, 100, qos) == 0);
+    simClock_SleepMs(10);
+  }
+  simBrokerStats_t stats;
+  simBroker_GetStats(&stats, 1);
+  simClock_Release();
+  return stats;
+}
+
+static void testLossAccounting(void) {
+  simBrokerConfig_t config = baseConfig();
+  config.jitterMs = 10;
+  config.dropPercent = 50;
+  config.ackLossPercent = 50;
+
+  simBrokerStats_t first = publishMany(&config, 1000, 0);
+  CHECK(first.received + first.lost == 1000);
+  CHECK(first.lost > 400 && first.lost < 600);
+  CHECK(first.duplicates == 0);
+  CHECK(first.bytes == first.received * 100);
+
+  simBrokerStats_t second = publishMany(&config, 1000, 0);
+  CHECK(memcmp(&first, &second, sizeof(first)) == 0);
+
+  config.seed = 2;
+  second = publishMany(&config, 1000, 0);
+  CHECK(second.lost != first.lost);
+
+  // QoS 1 不会丢失，确认丢失只产生重复
+  simBrokerStats_t acked = publishMany(&config, 1000, 1);
+  CHECK(acked.received == 1000);
+  CHECK(acked.lost == 0);
+  CHECK(acked.duplicates > 400 && acked.duplicates < 600);
+}
+
+static void testProbe(void) {
+  simBrokerConfig_t config = baseConfig();
+  config.periodicEveryMs = 1000000;
+  config.periodicDurationMs = 100000;
+  config.periodicMode = SIM_OUTAGE_BLACKHOLE;
+  simClock_Start(0);
+  CHECK(simBroker_Init(&config) == 0);
+
+  simBrokerSession_t session;
+  CHECK(simBroker_Open(&session, "ssl://[::1]", 60, 3000) == 0);
+  CHECK(simBroker_Probe("::1", 8883, 1000) == 40000);
+  CHECK(simBroker_Probe("10.0.0.2", 1883, 1000) == 40000);
+  CHECK(simBroker_Probe("10.0.0.2", 1883, 30) == -1); // 往返超过超时
+
+  simClock_SleepMs(1000000 - simClock_ElapsedMs());
+  int64_t before = simClock_ElapsedMs();
+  CHECK(simBroker_Probe("::1", 8883, 1000) == -1);
+  CHECK(simClock_ElapsedMs() - before == 1000);
+
+  simClock_SleepMs(3600000 - simClock_ElapsedMs());
+  simBrokerStats_t stats[SIM_BROKER_MAX];
+  CHECK(simBroker_GetStats(stats, SIM_BROKER_MAX) == 2);
+  CHECK(strcmp(stats[0].address, "[::1]:8883") == 0);
+  CHECK(stats[0].probes == 2);
+  CHECK(stats[0].probeFailures == 1);
+  CHECK(stats[1].probes == 2);
+  CHECK(stats[1].probeFailures == 1);
+  CHECK(stats[0].outageMs == 300000); // 1000、2000、3000 秒各 100 秒
+  simClock_Release();
+}
+
+static void testSensorReplay(void) {
+  char path[] = "/tmp/sim_sensor_testXXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd >= 0);
+  FILE *fp = fdopen(fd, "w");
+  fputs("t_ms,cpu_temp_c,unknown,light_lux\n", fp);
+  fputs("0,40.5,1,100\n", fp);
+  fputs("1000,50,2,200\n", fp);
+  fclose(fp);
+
+  CHECK(simSensor_Init(path, 7) == 0);
+  CHECK(simSensor_Value(SIM_SENSOR_CPU_TEMP, 0) == 40.5);
+  CHECK(simSensor_Value(SIM_SENSOR_CPU_TEMP, 999) == 40.5);
+  CHECK(simSensor_Value(SIM_SENSOR_LIGHT_LUX, 1500) == 200);
+  CHECK(simSensor_Value(SIM_SENSOR_LIGHT_LUX, 2500) == 100); // 周期 2000ms
+
+  // 文件中没有的列按种子生成，结果确定且在范围内
+  double load = simSensor_Value(SIM_SENSOR_CPU_LOAD, 43200000);
+  CHECK(load >= 0 && load <= 100);
+  CHECK(simSensor_Value(SIM_SENSOR_CPU_LOAD, 43200000) == load);
+  simSensor_Free();
+
+  fp = fopen(path, "w");
+  fputs("t_ms,cpu_temp_c\n1000,40\n1000,41\n", fp);
+  fclose(fp);
+  CHECK(simSensor_Init(path, 7) == -1);
+  CHECK(simSensor_Init("/nonexistent/replay.csv", 7) == -1);
+  unlink(path);
+
+  // 没有回放文件时：同一种子同一时间得到同一值，光照夜间为0
+  CHECK(simSensor_Init(NULL, 7) == 0);
+  CHECK(simSensor_Value(SIM_SENSOR_LIGHT_LUX, 0) < 20);
+  CHECK(simSensor_Value(SIM_SENSOR_LIGHT_LUX, 43200000) > 500);
+  double temp = simSensor_Value(SIM_SENSOR_CPU_TEMP, 123456);
+  CHECK(simSensor_Init(NULL, 7) == 0);
+  CHECK(simSensor_Value(SIM_SENSOR_CPU_TEMP, 123456) == temp);
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  testCloseOutage();
+  testBlackhole();
+  testLossAccounting();
+  testProbe();
+  testSensorReplay();
+
+  return testReport("sim_broker_test");
+}
@@ -0,0 +1,204 @@
+#include "../include/modules/sim_clock.h"
+#include "test_check.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * 虚拟时钟：三个按不同周期睡眠的线程按时间戳顺序运行，虚拟时间准确，第二次
+ * 运行的调度相同；一小时的一秒睡眠只用远少于一秒的真实时间；条件变量的等待
+ * 恰好在通知（或截止时间）时唤醒，simClock_Lock 在持有者睡眠时不会死锁，
+ * join 等到目标线程在虚拟时间上退出
+ * */
+#define ROUNDS 50
+#define LOG_MAX (3 * ROUNDS)
+
+typedef struct {
+  int id;
+  int64_t ms;
+} logEntry_t;
+
+static pthread_mutex_t g_logLock = PTHREAD_MUTEX_INITIALIZER;
+static logEntry_t g_log[LOG_MAX];
+static int g_logCount = 0;
+static const int g_periods[3] = {7, 11, 14};
+
+static void *periodicThread(void *arg) {
+  int id = (int)(intptr_t)arg;
+  for (int i = 0; i < ROUNDS; i++) {
+    simClock_SleepMs(g_periods[id]);
+    simClock_Lock(&g_logLock);
+    g_log[g_logCount].id = id;
+    g_log[g_logCount].ms = simClock_ElapsedMs();
+    g_logCount++;
+    pthread_mutex_unlock(&g_logLock);
+  }
+  return NULL;
+}
+
+static int runSchedule(logEntry_t *out) {
+  g_logCount = 0;
+  simClock_Start(1700000000000LL);
+  pthread_t threads[3];
+  for (int i = 0; i < 3; i++) {
+    CHECK(simClock_CreateThread(&threads[i], periodicThread,
+                                (void *)(intptr_t)i) == 0);
+  }
+  for (int i = 0; i < 3; i++) {
+    simClock_JoinThread(threads[i]);
+  }
+  simClock_Release();
+  memcpy(out, g_log, sizeof(g_log));
+  return g_logCount;
+}
+
+static void testSchedule(void) {
+  static logEntry_t first[LOG_MAX], second[LOG_MAX];
+  int count = runSchedule(first);
+  CHECK(count == LOG_MAX);
+
+  int seen[3] = {0};
+  for (int i = 0; i < count; i++) {
+    int id = first[i].id;
+    seen[id]++;
+    CHECK(first[i].ms == (int64_t)seen[id] * g_periods[id]);
+    if (i > 0) {
+      CHECK(first[i].ms >= first[i - 1].ms);
+    }
+  }
+  // 同时到期时先进入等待（上一次醒来更早）的线程先运行
+  for (int i = 1; i < count; i++) {
+    if (first[i].ms == first[i - 1].ms) {
+      CHECK(first[i - 1].ms - g_periods[first[i - 1].id] <=
+            first[i].ms - g_periods[first[i].id]);
+    }
+  }
+
+  CHECK(runSchedule(second) == count);
+  CHECK(memcmp(first, second, sizeof(logEntry_t) * count) == 0);
+}
+
+static void testSpeed(void) {
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  simClock_Start(1700000000000LL);
+  int64_t realtimeStart = simClock_RealtimeMs();
+  for (int i = 0; i < 3600; i++) {
+    simClock_SleepMs(1000);
+  }
+  CHECK(simClock_ElapsedMs() == 3600 * 1000);
+  CHECK(simClock_RealtimeMs() - realtimeStart == 3600 * 1000);
+  CHECK(realtimeStart == 1700000000000LL);
+  simClock_Release();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double wall =
+      (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  CHECK(wall < 1.0);
+
+  // 仿真结束后时间不回退，睡眠按真实时间
+  int64_t before = simClock_NowMs();
+  simClock_SleepMs(20);
+  CHECK(simClock_NowMs() - before >= 20);
+  CHECK(!simClock_IsVirtual());
+}
+
+static pthread_mutex_t g_condLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static bool g_ready = false;
+static int64_t g_wokeMs[2];
+static int g_waitRc[2];
+
+static void *waiterThread(void *arg) {
+  struct timespec deadline;
+  simClock_Lock(&g_condLock);
+  simClock_Deadline(&deadline, 50);
+  while (!g_ready) {
+    if ((g_waitRc[0] = simClock_CondTimedWait(&g_cond, &g_condLock,
+                                              &deadline)) != 0) {
+      break;
+    }
+  }
+  g_wokeMs[0] = simClock_ElapsedMs();
+
+  // 第二次没有人唤醒，在截止时间超时
+  simClock_Deadline(&deadline, 50);
+  g_waitRc[1] = simClock_CondTimedWait(&g_cond, &g_condLock, &deadline);
+  g_wokeMs[1] = simClock_ElapsedMs();
+  pthread_mutex_unlock(&g_condLock);
+  return NULL;
+}
+
+static void testCondition(void) {
+  simClock_Start(0);
+  pthread_t waiter;
+  CHECK(simClock_CreateThread(&waiter, waiterThread, NULL) == 0);
+  simClock_SleepMs(30);
+  simClock_Lock(&g_condLock);
+  g_ready = true;
+  simClock_CondSignal(&g_cond);
+  pthread_mutex_unlock(&g_condLock);
+  simClock_JoinThread(waiter);
+  simClock_Release();
+
+  CHECK(g_waitRc[0] == 0);
+  CHECK(g_wokeMs[0] == 30);
+  CHECK(g_waitRc[1] == ETIMEDOUT);
+  CHECK(g_wokeMs[1] == 80);
+}
+
+static pthread_mutex_t g_busyLock = PTHREAD_MUTEX_INITIALIZER;
+static int64_t g_acquiredMs = -1;
+
+static void *holderThread(void *arg) {
+  simClock_Lock(&g_busyLock);
+  simClock_SleepMs(20); // 持锁睡眠（如持有客户端锁进行连接）
+  pthread_mutex_unlock(&g_busyLock);
+  simClock_SleepMs(100);
+  return NULL;
+}
+
+static void *contenderThread(void *arg) {
+  simClock_SleepMs(5);
+  simClock_Lock(&g_busyLock);
+  g_acquiredMs = simClock_ElapsedMs();
+  pthread_mutex_unlock(&g_busyLock);
+  return NULL;
+}
+
+static void testLockAndJoin(void) {
+  simClock_Start(0);
+  pthread_t holder, contender;
+  CHECK(simClock_CreateThread(&holder, holderThread, NULL) == 0);
+  CHECK(simClock_CreateThread(&contender, contenderThread, NULL) == 0);
+  simClock_JoinThread(contender);
+  CHECK(g_acquiredMs >= 20 && g_acquiredMs <= 21);
+
+  simClockStats_t stats;
+  simClock_GetStats(&stats);
+  CHECK(stats.running);
+  CHECK(stats.lockRetries > 0);
+  CHECK(stats.threads == 2);
+
+  // 主线程等待持锁线程退出，期间虚拟时间前进到它退出的时刻
+  simClock_JoinThread(holder);
+  CHECK(simClock_ElapsedMs() == 120);
+  simClock_GetStats(&stats);
+  CHECK(stats.threads == 1);
+  simClock_Release();
+}
+
+int main(void) {
+  // 未进入仿真时直接使用系统时钟
+  CHECK(!simClock_IsVirtual());
+  CHECK(simClock_ElapsedMs() == 0);
+  CHECK(simClock_RealtimeMs() > 1600000000000LL);
+
+  testSchedule();
+  testSpeed();
+  testCondition();
+  testLockAndJoin();
+
+  return testReport("sim_clock_test");
+}
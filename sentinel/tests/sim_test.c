@@ -0,0 +1,130 @@
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/sim.h"
+#include "../include/modules/sim_clock.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * 仿真入口：simulationConfig 的解析（秒换算为毫秒、中断列表、无效项被
+ * 忽略），以及 sim_Run 在虚拟时钟上运行到设定时长，按间隔记录内存，
+ * 写出的报告带有配置、计数器和Broker组的统计，并置位退出标志。
+ * Broker组只用到统计接口，由下面的替身提供
+ * */
+#define REPORT_PATH "/tmp/sentinel_sim_test_report.json"
+
+/* Broker组的替身：一个发送队列，第一条消息在启动后1.5秒发出 */
+void brokerGroup_GetStats(brokerGroup_t *group, brokerGroupStats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->startedMs = 10;
+  stats->firstSentUs = 11500;
+  stats->failovers = 2;
+  stats->outboxCount = 1;
+  stats->outboxes[0].enqueued = 90;
+  stats->outboxes[0].sent = 80;
+  stats->outboxes[0].dropped = 4;
+  stats->outboxes[0].queued = 6;
+}
+
+static void testParse(void) {
+  const char *text =
+      "{\"enabled\":true,\"durationSec\":7200,\"epochMs\":1000,\"seed\":7,"
+      "\"reportIntervalSec\":3600,\"report\":\"" REPORT_PATH "\","
+      "\"broker\":{\"latencyMs\":5,\"jitterMs\":0,\"dropPercent\":1.5,"
+      "\"outageEverySec\":600,\"outageDurationSec\":30,"
+      "\"outageMode\":\"close\",\"outages\":["
+      "{\"atSec\":100,\"durationSec\":20,\"mode\":\"blackhole\",\"broker\":1},"
+      "{\"atSec\":200,\"durationSec\":20,\"mode\":\"bogus\"},"
+      "{\"atSec\":300,\"durationSec\":1.5,\"mode\":\"close\"}]}}";
+  cJSON *root = cJSON_Parse(text);
+  simConfig_t config = {.durationMs = 1, .broker = {.latencyMs = 20}};
+  sim_ParseConfig(root, &config);
+  cJSON_Delete(root);
+
+  CHECK(config.enabled);
+  CHECK(config.durationMs == 7200000 && config.epochMs == 1000);
+  CHECK(config.reportIntervalMs == 3600000);
+  CHECK(strcmp(config.reportPath, REPORT_PATH) == 0);
+  CHECK(config.replayFile[0] == '\0');
+  CHECK(config.broker.seed == 7 && config.broker.latencyMs == 5);
+  CHECK(config.broker.dropPercent == 1.5);
+  CHECK(config.broker.periodicEveryMs == 600000);
+  CHECK(config.broker.periodicDurationMs == 30000);
+  CHECK(config.broker.periodicMode == SIM_OUTAGE_CLOSE);
+  CHECK(config.broker.outageCount == 2); // 无效的中断被忽略
+  CHECK(config.broker.outages[0].startMs == 100000);
+  CHECK(config.broker.outages[0].mode == SIM_OUTAGE_BLACKHOLE);
+  CHECK(config.broker.outages[0].broker == 1);
+  CHECK(config.broker.outages[1].durationMs == 1500);
+  CHECK(config.broker.outages[1].broker == -1);
+
+  // 没有 simulationConfig 时保持原值
+  simConfig_t untouched = {.durationMs = 42};
+  sim_ParseConfig(NULL, &untouched);
+  CHECK(!untouched.enabled && untouched.durationMs == 42);
+}
+
+static void testRun(void) {
+  simConfig_t config = {.enabled = true,
+                        .durationMs = 7200000,
+                        .epochMs = 1704067200000LL,
+                        .reportIntervalMs = 3600000,
+                        .reportPath = REPORT_PATH,
+                        .broker = {.seed = 3}};
+  CHECK(sim_Init(&config) == 0);
+  CHECK(simClock_RealtimeMs() == 1704067200000LL);
+
+  brokerGroup_t group;
+  unsigned long produced = 100, offline = 7;
+  bool exitFlag = false;
+  simContext_t ctx = {.brokerGroup = &group,
+                      .samplesProduced = &produced,
+                      .samplesOffline = &offline,
+                      .exitFlag = &exitFlag};
+  CHECK(sim_Run(&ctx) == 0);
+  CHECK(exitFlag);
+
+  FILE *fp = fopen(REPORT_PATH, "r");
+  CHECK(fp != NULL);
+  if (fp == NULL) {
+    return;
+  }
+  char report[8192];
+  size_t len = fread(report, 1, sizeof(report) - 1, fp);
+  report[len] = '\0';
+  fclose(fp);
+  cJSON *root = cJSON_Parse(report);
+  CHECK(root != NULL);
+  cJSON *messages = cJSON_GetObjectItem(root, "messages");
+  cJSON *memory = cJSON_GetObjectItem(root, "memory");
+  CHECK(cJSON_GetObjectItem(root, "duration_sec")->valuedouble == 7200);
+  CHECK(cJSON_GetObjectItem(root, "seed")->valueint == 3);
+  CHECK(cJSON_GetObjectItem(root, "failovers")->valueint == 2);
+  CHECK(cJSON_GetObjectItem(root, "first_publish_ms")->valuedouble == 1.5);
+  CHECK(cJSON_GetObjectItem(messages, "produced")->valueint == 100);
+  CHECK(cJSON_GetObjectItem(messages, "skipped_offline")->valueint == 7);
+  CHECK(cJSON_GetObjectItem(messages, "sent")->valueint == 80);
+  CHECK(cJSON_GetObjectItem(messages, "queued_at_end")->valueint == 6);
+  CHECK(cJSON_GetObjectItem(messages, "undelivered_ratio")->valuedouble ==
+        0.2);
+  CHECK(cJSON_GetArraySize(cJSON_GetObjectItem(root, "brokers")) == 0);
+  // 开始、每小时一次
+  cJSON *samples = cJSON_GetObjectItem(memory, "samples");
+  CHECK(cJSON_GetArraySize(samples) == 3);
+  CHECK(cJSON_GetObjectItem(cJSON_GetArrayItem(samples, 2), "t_sec")
+            ->valueint == 7200);
+  cJSON_Delete(root);
+  unlink(REPORT_PATH);
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  testParse();
+  testRun();
+
+  return testReport("sim_test");
+}
@@ -0,0 +1,197 @@
+#include "../include/modules/state_snapshot.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * 状态快照格式：往返、CRC-32校验值，拒绝损坏、截断和其他程序的文件，记录
+ * 溢出和跳过未知标签，以及完整大小快照的保存和读取耗时
+ * */
+#define TEST_PATH "/tmp/sentinel_state_snapshot_test.snap"
+#define BUF_BYTES 16384
+
+static uint64_t g_buf[BUF_BYTES / 8];
+static uint64_t g_readBuf[BUF_BYTES / 8];
+
+static int64_t nowUs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* 直接改写文件中的一个字节 */
+static void patchByte(long offset, int delta) {
+  FILE *fp = fopen(TEST_PATH, "r+b");
+  if (!fp) {
+    failures++;
+    return;
+  }
+  fseek(fp, offset, SEEK_SET);
+  int c = fgetc(fp);
+  fseek(fp, offset, SEEK_SET);
+  fputc((c + delta) & 0xff, fp);
+  fclose(fp);
+}
+
+static void testCrc(void) {
+  CHECK(stateSnapshot_Crc32("123456789", 9) == 0xcbf43926);
+  CHECK(stateSnapshot_Crc32("", 0) == 0);
+}
+
+static void testRoundTrip(void) {
+  stateSnapshot_t snap;
+  stateSnapshot_Begin(&snap, g_buf, sizeof(g_buf));
+  uint64_t counters[2] = {12345, 67};
+  CHECK(stateSnapshot_Put(&snap, 1, counters, sizeof(counters)) == 0);
+  CHECK(stateSnapshot_Put(&snap, 99, "unknown", 7) == 0); // 读取时跳过
+  char *text = stateSnapshot_Reserve(&snap, 2, 5);
+  CHECK(text != NULL && ((uintptr_t)text & 7) == 0);
+  memcpy(text, "hello", 5);
+  CHECK(stateSnapshot_Put(&snap, 3, "", 0) == 0);
+  CHECK(snap.len == STATE_SNAPSHOT_HEADER + 4 * STATE_SNAPSHOT_RECORD + 16 +
+                        8 + 8);
+  CHECK(stateSnapshot_Save(&snap, TEST_PATH) == 0);
+  CHECK(access(TEST_PATH ".tmp", F_OK) != 0);
+
+  stateSnapshot_t loaded;
+  CHECK(stateSnapshot_Load(&loaded, g_readBuf, sizeof(g_readBuf),
+                           TEST_PATH) == 0);
+  CHECK(loaded.len == snap.len);
+  size_t offset = 0;
+  uint16_t tag;
+  const void *data;
+  uint32_t len;
+  int seen = 0;
+  while (stateSnapshot_Next(&loaded, &offset, &tag, &data, &len) == 0) {
+    switch (tag) {
+    case 1:
+      CHECK(len == sizeof(counters) && memcmp(data, counters, len) == 0);
+      seen |= 1;
+      break;
+    case 2:
+      CHECK(len == 5 && memcmp(data, "hello", 5) == 0);
+      seen |= 2;
+      break;
+    case 3:
+      CHECK(len == 0);
+      seen |= 4;
+      break;
+    default:
+      CHECK(tag == 99);
+      break;
+    }
+  }
+  CHECK(seen == 7);
+  CHECK(offset == loaded.len);
+}
+
+/* 损坏、截断、魔数不对的文件都被拒绝 */
+static void testReject(void) {
+  stateSnapshot_t snap;
+  stateSnapshot_Begin(&snap, g_buf, sizeof(g_buf));
+  stateSnapshot_Put(&snap, 1, "payload!", 8);
+  CHECK(stateSnapshot_Save(&snap, TEST_PATH) == 0);
+  long size = (long)snap.len;
+
+  stateSnapshot_t loaded;
+  patchByte(STATE_SNAPSHOT_HEADER + STATE_SNAPSHOT_RECORD, 1);
+  CHECK(stateSnapshot_Load(&loaded, g_readBuf, sizeof(g_readBuf),
+                           TEST_PATH) == -1);
+  CHECK(loaded.len == 0);
+
+  CHECK(stateSnapshot_Save(&snap, TEST_PATH) == 0);
+  CHECK(truncate(TEST_PATH, size - 1) == 0);
+  CHECK(stateSnapshot_Load(&loaded, g_readBuf, sizeof(g_readBuf),
+                           TEST_PATH) == -1);
+
+  CHECK(stateSnapshot_Save(&snap, TEST_PATH) == 0);
+  patchByte(0, 1);
+  CHECK(stateSnapshot_Load(&loaded, g_readBuf, sizeof(g_readBuf),
+                           TEST_PATH) == -1);
+
+  // 缓冲小于文件
+  CHECK(stateSnapshot_Save(&snap, TEST_PATH) == 0);
+  CHECK(stateSnapshot_Load(&loaded, g_readBuf, size - 8, TEST_PATH) == -1);
+
+  unlink(TEST_PATH);
+  CHECK(stateSnapshot_Load(&loaded, g_readBuf, sizeof(g_readBuf),
+                           TEST_PATH) == -1);
+}
+
+/* 空间不足时已写入的记录保留，计数未写入的记录 */
+static void testOverflow(void) {
+  static uint64_t small[8]; // 64字节
+  stateSnapshot_t snap;
+  stateSnapshot_Begin(&snap, small, sizeof(small));
+  CHECK(stateSnapshot_Put(&snap, 1, "0123456789abcdef", 16) == 0);
+  CHECK(stateSnapshot_Put(&snap, 2, "0123456789abcdef", 16) == 0);
+  CHECK(stateSnapshot_Put(&snap, 3, "x", 1) == -1);
+  CHECK(stateSnapshot_Reserve(&snap, 4, 1000) == NULL);
+  CHECK(snap.truncated == 2);
+  CHECK(snap.len == sizeof(small));
+
+  CHECK(stateSnapshot_Save(&snap, TEST_PATH) == 0);
+  stateSnapshot_t loaded;
+  CHECK(stateSnapshot_Load(&loaded, g_readBuf, sizeof(g_readBuf),
+                           TEST_PATH) == 0);
+  size_t offset = 0;
+  uint16_t tag;
+  const void *data;
+  uint32_t len;
+  int count = 0;
+  while (stateSnapshot_Next(&loaded, &offset, &tag, &data, &len) == 0) {
+    count++;
+  }
+  CHECK(count == 2);
+  unlink(TEST_PATH);
+}
+
+/* 写满缓冲的快照的保存和读取耗时（保存包含 fsync） */
+static void benchFull(void) {
+  stateSnapshot_t snap;
+  stateSnapshot_Begin(&snap, g_buf, sizeof(g_buf));
+  char message[200];
+  memset(message, 'm', sizeof(message));
+  int records = 0;
+  int64_t start = nowUs();
+  while (stateSnapshot_Put(&snap, 4, message, sizeof(message)) == 0) {
+    records++;
+  }
+  int64_t buildUs = nowUs() - start;
+  start = nowUs();
+  CHECK(stateSnapshot_Save(&snap, TEST_PATH) == 0);
+  int64_t saveUs = nowUs() - start;
+
+  stateSnapshot_t loaded;
+  start = nowUs();
+  CHECK(stateSnapshot_Load(&loaded, g_readBuf, sizeof(g_readBuf),
+                           TEST_PATH) == 0);
+  size_t offset = 0;
+  uint16_t tag;
+  const void *data;
+  uint32_t len;
+  int count = 0;
+  while (stateSnapshot_Next(&loaded, &offset, &tag, &data, &len) == 0) {
+    count++;
+  }
+  int64_t loadUs = nowUs() - start;
+  CHECK(count == records);
+  printf("full snapshot: %d records, %zu bytes, build %lld us, save %lld us, "
+         "load %lld us\n",
+         records, snap.len, (long long)buildUs, (long long)saveUs,
+         (long long)loadUs);
+  unlink(TEST_PATH);
+}
+
+int main(void) {
+  testCrc();
+  testRoundTrip();
+  testReject();
+  testOverflow();
+  benchFull();
+
+  return testReport("state_snapshot_test");
+}
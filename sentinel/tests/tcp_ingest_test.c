@@ -0,0 +1,417 @@
+#include "../include/modules/event_loop.h"
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/tcp_ingest.h"
+#include "test_check.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * TCP接入服务：几千个本地设备连接的负载（输出每秒转发的消息数和转发延迟），
+ * 换行和长度前缀混合的分帧（帧跨过环形缓冲的末尾），发布繁忙时按设备反压，
+ * 以及不影响其他设备的按设备限速
+ * */
+#define LOAD_CLIENTS 2000
+#define LOAD_MESSAGES 50 // 每个设备发送的读数
+#define MAX_RECORDS (LOAD_CLIENTS * LOAD_MESSAGES)
+
+static eventLoop_t g_loop;
+
+// 转发回调记录（只在事件循环线程写入）
+static volatile int g_busy = 0;
+static volatile unsigned long g_forwarded = 0;
+static double *g_latencyUs = NULL;
+static int g_lastSeq[LOAD_CLIENTS];
+static unsigned long g_outOfOrder = 0;
+static char g_lastType[TCP_INGEST_TYPE_MAX + 1];
+static char g_lastPayload[256];
+
+static double nowUs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void sleepMs(int ms) {
+  struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000};
+  nanosleep(&ts, NULL);
+}
+
+/* 载荷形如 {"sensor_type":"temp","dev":3,"seq":7,"t_us":123.0} */
+static int forwardHandle(const char *sensorType, int typeLen,
+                         const char *payload, int payloadLen, void *userData) {
+  if (g_busy) {
+    return -1;
+  }
+
+  double receivedUs = nowUs();
+  snprintf(g_lastType, sizeof(g_lastType), "%.*s", typeLen, sensorType);
+  snprintf(g_lastPayload, sizeof(g_lastPayload), "%.*s", payloadLen, payload);
+
+  int dev, seq;
+  double sentUs;
+  const char *fields = strstr(g_lastPayload, "\"dev\":");
+  if (fields &&
+      sscanf(fields, "\"dev\":%d,\"seq\":%d,\"t_us\":%lf", &dev, &seq,
+             &sentUs) == 3 &&
+      dev >= 0 && dev < LOAD_CLIENTS) {
+    if (seq != g_lastSeq[dev] + 1) {
+      g_outOfOrder++;
+    }
+    g_lastSeq[dev] = seq;
+    if (g_forwarded < MAX_RECORDS) {
+      g_latencyUs[g_forwarded] = receivedUs - sentUs;
+    }
+  }
+  __atomic_add_fetch(&g_forwarded, 1, __ATOMIC_RELEASE);
+  return 0;
+}
+
+static unsigned long forwarded(void) {
+  return __atomic_load_n(&g_forwarded, __ATOMIC_ACQUIRE);
+}
+
+static void resetRecords(void) {
+  g_forwarded = 0;
+  g_outOfOrder = 0;
+  for (int i = 0; i < LOAD_CLIENTS; i++) {
+    g_lastSeq[i] = -1;
+  }
+}
+
+static int startServer(int maxClients, int ringBytes, int maxMsgsPerSec) {
+  tcpIngestConfig_t config = {.bindAddress = "127.0.0.1",
+                              .port = 0,
+                              .maxClients = maxClients,
+                              .ringBytes = ringBytes,
+                              .maxMsgsPerSec = maxMsgsPerSec};
+  resetRecords();
+  if (tcpIngest_Init(&config, &g_loop, forwardHandle, NULL) != 0) {
+    return -1;
+  }
+  return eventLoop_Start(&g_loop);
+}
+
+static void stopServer(void) {
+  eventLoop_Stop(&g_loop);
+  tcpIngest_Deinit();
+}
+
+static int connectClient(void) {
+  struct sockaddr_in addr = {.sin_family = AF_INET,
+                             .sin_port = htons((uint16_t)tcpIngest_Port())};
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int sendAll(int fd, const void *data, size_t len) {
+  const char *p = (const char *)data;
+  while (len > 0) {
+    ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if (n <= 0) {
+      return -1;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+static int sendReading(int fd, int dev, int seq) {
+  char line[128];
+  int len = snprintf(line, sizeof(line),
+                     "{\"sensor_type\":\"temp\",\"dev\":%d,\"seq\":%d,"
+                     "\"t_us\":%.1f}\n",
+                     dev, seq, nowUs());
+  return sendAll(fd, line, len);
+}
+
+static int sendPrefixed(int fd, const char *json) {
+  uint32_t len = (uint32_t)strlen(json);
+  uint8_t prefix[4] = {len >> 24, len >> 16, len >> 8, len};
+  if (sendAll(fd, prefix, sizeof(prefix)) != 0) {
+    return -1;
+  }
+  return sendAll(fd, json, len);
+}
+
+/* 等待转发数量达到 count，返回是否达到 */
+static int waitForwarded(unsigned long count, int timeoutMs) {
+  double deadline = nowUs() + timeoutMs * 1000.0;
+  while (forwarded() < count && nowUs() < deadline) {
+    sleepMs(1);
+  }
+  return forwarded() >= count;
+}
+
+/* 等待服务端断开：未读完的数据会使关闭变成RST */
+static int peerClosed(int fd) {
+  char byte;
+  struct timeval tv = {1, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  ssize_t n = recv(fd, &byte, 1, 0);
+  return n == 0 || (n < 0 && errno == ECONNRESET);
+}
+
+static int compareDouble(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+static void testLoad(void) {
+  CHECK(startServer(LOAD_CLIENTS, 2048, 0) == 0);
+
+  static int fds[LOAD_CLIENTS];
+  int connected = 0;
+  for (int i = 0; i < LOAD_CLIENTS; i++) {
+    fds[i] = connectClient();
+    connected += fds[i] >= 0;
+  }
+  CHECK(connected == LOAD_CLIENTS);
+
+  tcpIngestStats_t stats;
+  double deadline = nowUs() + 5e6;
+  do {
+    sleepMs(5);
+    tcpIngest_GetStats(&stats);
+  } while (stats.connections < connected && nowUs() < deadline);
+  CHECK(stats.connections == LOAD_CLIENTS);
+
+  // 所有设备轮流发送，模拟大量设备同时上报
+  unsigned long total = (unsigned long)connected * LOAD_MESSAGES;
+  double startUs = nowUs();
+  for (int seq = 0; seq < LOAD_MESSAGES; seq++) {
+    for (int i = 0; i < LOAD_CLIENTS; i++) {
+      if (fds[i] >= 0) {
+        sendReading(fds[i], i, seq);
+      }
+    }
+  }
+  CHECK(waitForwarded(total, 20000));
+  double elapsedUs = nowUs() - startUs;
+
+  unsigned long count = forwarded();
+  CHECK(count == total);
+  CHECK(g_outOfOrder == 0);
+  qsort(g_latencyUs, count, sizeof(double), compareDouble);
+  printf("load: %d devices, %lu messages in %.0f ms, %.0f msgs/sec, "
+         "latency p50 %.0f us, p99 %.0f us, max %.0f us\n",
+         connected, count, elapsedUs / 1000, count / (elapsedUs / 1e6),
+         g_latencyUs[count / 2], g_latencyUs[count * 99 / 100],
+         g_latencyUs[count - 1]);
+
+  // 超出连接数的设备被拒绝
+  int extra = connectClient();
+  sleepMs(50);
+  tcpIngest_GetStats(&stats);
+  CHECK(stats.rejected == 1);
+  CHECK(stats.badFrames == 0 && stats.oversized == 0);
+  if (extra >= 0) {
+    close(extra);
+  }
+
+  for (int i = 0; i < LOAD_CLIENTS; i++) {
+    if (fds[i] >= 0) {
+      close(fds[i]);
+    }
+  }
+  deadline = nowUs() + 5e6;
+  do {
+    sleepMs(5);
+    tcpIngest_GetStats(&stats);
+  } while (stats.connections > 0 && nowUs() < deadline);
+  CHECK(stats.connections == 0);
+  stopServer();
+}
+
+static void testFraming(void) {
+  CHECK(startServer(4, 128, 0) == 0);
+  int fd = connectClient();
+  CHECK(fd >= 0);
+
+  // 换行、CRLF、长度前缀、空行混用
+  const char *stream = "{\"sensor_type\":\"soil\",\"moisture\":31}\r\n"
+                       "\n"
+                       "  {\"id\":{\"sensor_type\":\"x\"},\"sensor_type\":"
+                       "\"air_q2\",\"pm25\":[1,{\"a\":\"}\"}]}\n";
+  sendAll(fd, stream, strlen(stream));
+  sendPrefixed(fd, "{\"sensor_type\":\"co2\",\"ppm\":415}");
+  CHECK(waitForwarded(3, 1000));
+  CHECK(strcmp(g_lastType, "co2") == 0);
+  CHECK(strcmp(g_lastPayload, "{\"sensor_type\":\"co2\",\"ppm\":415}") == 0);
+
+  // 无法识别的帧丢弃，连接保持
+  const char *bad[] = {
+      "not json\n",
+      "{\"value\":1}\n",
+      "{\"sensor_type\":\"Temp\"}\n",
+      "{\"sensor_type\":\"a/b\"}\n",
+      "{\"sensor_type\":42}\n",
+      "{\"sensor_type\":\"temp\"} trailing\n",
+      "{\"sensor_type\":\"temp\",\"v\":\"unterminated}\n",
+  };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    sendAll(fd, bad[i], strlen(bad[i]));
+  }
+
+  // 不同长度的帧使后续帧跨越128字节环形缓冲的末尾
+  char line[128];
+  for (int i = 0; i < 40; i++) {
+    int len = snprintf(line, sizeof(line),
+                       "{\"sensor_type\":\"wrap\",\"n\":%d,\"pad\":\"%.*s\"}\n",
+                       i, i % 23, "xxxxxxxxxxxxxxxxxxxxxxx");
+    sendAll(fd, line, len);
+  }
+  CHECK(waitForwarded(43, 1000));
+  CHECK(strcmp(g_lastType, "wrap") == 0);
+  CHECK(strstr(g_lastPayload, "\"n\":39,") != NULL);
+
+  tcpIngestStats_t stats;
+  tcpIngest_GetStats(&stats);
+  CHECK(stats.badFrames == sizeof(bad) / sizeof(bad[0]));
+  CHECK(stats.copied > 0);
+  CHECK(stats.connections == 1);
+
+  // 超过缓冲的帧断开连接
+  char big[200];
+  memset(big, 'x', sizeof(big));
+  sendAll(fd, big, sizeof(big));
+  CHECK(peerClosed(fd));
+  sleepMs(20); // 统计在关闭套接字之后更新
+  tcpIngest_GetStats(&stats);
+  CHECK(stats.oversized == 1);
+  CHECK(stats.connections == 0);
+  close(fd);
+
+  // 长度前缀超过缓冲同样断开
+  fd = connectClient();
+  uint8_t prefix[4] = {0, 0, 1, 0};
+  sendAll(fd, prefix, sizeof(prefix));
+  CHECK(peerClosed(fd));
+  close(fd);
+  stopServer();
+}
+
+/* 发布通道繁忙期间读数保留在连接中，恢复后按顺序全部转发 */
+static void testBusy(void) {
+  CHECK(startServer(4, 256, 0) == 0);
+  int fd = connectClient();
+  CHECK(fd >= 0);
+
+  g_busy = 1;
+  for (int seq = 0; seq < 500; seq++) {
+    sendReading(fd, 0, seq);
+  }
+  sleepMs(200);
+  CHECK(forwarded() == 0);
+  tcpIngestStats_t stats;
+  tcpIngest_GetStats(&stats);
+  CHECK(stats.busy > 0);
+  CHECK(stats.paused == 1);
+
+  g_busy = 0;
+  CHECK(waitForwarded(500, 2000));
+  CHECK(forwarded() == 500);
+  CHECK(g_outOfOrder == 0);
+  CHECK(g_lastSeq[0] == 499);
+  tcpIngest_GetStats(&stats);
+  CHECK(stats.paused == 0);
+
+  // 暂停期间对端关闭，恢复后转发剩余读数再回收连接
+  g_busy = 1;
+  for (int seq = 500; seq < 520; seq++) {
+    sendReading(fd, 0, seq);
+  }
+  sleepMs(20);
+  close(fd);
+  sleepMs(20);
+  g_busy = 0;
+  CHECK(waitForwarded(520, 1000));
+  sleepMs(50);
+  tcpIngest_GetStats(&stats);
+  CHECK(stats.connections == 0);
+  stopServer();
+}
+
+/* 速率受限的设备被暂停，其他设备不受影响 */
+static void testThrottle(void) {
+  CHECK(startServer(4, 1024, 50) == 0);
+  int slow = connectClient();
+  int other = connectClient();
+  CHECK(slow >= 0 && other >= 0);
+
+  double startUs = nowUs();
+  for (int seq = 0; seq < 100; seq++) {
+    sendReading(slow, 0, seq);
+  }
+  sleepMs(100);
+  for (int seq = 0; seq < 10; seq++) {
+    sendReading(other, 1, seq);
+  }
+  double deadline = nowUs() + 1e6;
+  while (g_lastSeq[1] < 9 && nowUs() < deadline) {
+    sleepMs(1);
+  }
+  double otherMs = (nowUs() - startUs) / 1000 - 100;
+  CHECK(g_lastSeq[1] == 9);
+  CHECK(otherMs < 100);
+
+  CHECK(waitForwarded(110, 3000));
+  double slowMs = (nowUs() - startUs) / 1000;
+  tcpIngestStats_t stats;
+  tcpIngest_GetStats(&stats);
+  printf("throttle: 100 readings at 50/s took %.0f ms, other device %.1f ms, "
+         "%lu pauses\n",
+         slowMs, otherMs, stats.throttled);
+  // 先用完50条的突发额度，其余50条按50条/秒放行
+  CHECK(slowMs > 850 && slowMs < 1500);
+  CHECK(stats.throttled > 0);
+  CHECK(g_outOfOrder == 0);
+
+  close(slow);
+  close(other);
+  stopServer();
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  // 每个设备一个套接字，两端共占 2 * LOAD_CLIENTS 个描述符
+  struct rlimit limit;
+  getrlimit(RLIMIT_NOFILE, &limit);
+  if (limit.rlim_cur < 2 * LOAD_CLIENTS + 64) {
+    limit.rlim_cur = 2 * LOAD_CLIENTS + 64;
+    if (limit.rlim_cur > limit.rlim_max ||
+        setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+      fprintf(stderr, "need %d file descriptors\n", 2 * LOAD_CLIENTS + 64);
+      return 1;
+    }
+  }
+
+  g_latencyUs = (double *)malloc(MAX_RECORDS * sizeof(double));
+  if (!g_latencyUs || eventLoop_Init(&g_loop, LOAD_CLIENTS + 8) != 0) {
+    return 1;
+  }
+
+  testLoad();
+  testFraming();
+  testBusy();
+  testThrottle();
+
+  free(g_latencyUs);
+  return testReport("tcp_ingest_test");
+}
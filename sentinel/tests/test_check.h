@@ -0,0 +1,36 @@
+#ifndef _TEST_CHECK_H
+#define _TEST_CHECK_H
+
+#include <stdio.h>
+
+/*
+ * 单元测试共用的检查：条件不成立时输出位置并计数，测试继续往下执行，
+ * main 最后用 testReport 输出结果并返回退出码。每个测试只有一个源文件
+ * 包含本头文件
+ * */
+
+static int failures = 0;
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+/*
+ * @brief 输出 "<name>: all passed" 或失败的个数
+ *
+ * @return main 的退出码，有失败时为1
+ * */
+static inline int testReport(const char *name) {
+  if (failures) {
+    printf("%s: %d failure(s)\n", name, failures);
+    return 1;
+  }
+  printf("%s: all passed\n", name);
+  return 0;
+}
+
+#endif // !_TEST_CHECK_H
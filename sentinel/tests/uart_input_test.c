@@ -0,0 +1,540 @@
+#include "../include/modules/event_loop.h"
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/uart_input.h"
+#include "test_check.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * 串口接入：按行、长度前缀和SLIP分帧器逐字节和成块输入（CRC、转义、重新
+ * 同步、溢出），自定义分帧器，每种分帧器的解析吞吐，以及在伪终端上检查
+ * termios 设置，按限定和不限定的字节速率传输分帧的读数（输出MB/s和从字节
+ * 到回调的延迟），设备消失后继续运行
+ * */
+#define MAX_FRAMES 16
+#define MAX_LATENCIES 400000
+
+static double nowUs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void sleepMs(int ms) {
+  struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000};
+  nanosleep(&ts, NULL);
+}
+
+/* ---- 分帧器单元测试：帧收集到数组中 ---- */
+typedef struct {
+  char frames[MAX_FRAMES][64];
+  int lens[MAX_FRAMES];
+  int count;
+} collected_t;
+
+static void collectEmit(uartParser_t *parser, const uint8_t *data, int len) {
+  collected_t *out = (collected_t *)parser->context;
+  if (out->count < MAX_FRAMES && len < 64) {
+    memcpy(out->frames[out->count], data, len);
+    out->frames[out->count][len] = '\0';
+    out->lens[out->count++] = len;
+  }
+}
+
+static uint8_t g_frameBuf[4096];
+
+static void initParser(uartParser_t *parser, const uartPortConfig_t *config,
+                       uartInputStats_t *stats, collected_t *out) {
+  memset(parser, 0, sizeof(*parser));
+  memset(stats, 0, sizeof(*stats));
+  memset(out, 0, sizeof(*out));
+  parser->config = config;
+  parser->frame = g_frameBuf;
+  parser->stats = stats;
+  parser->emit = collectEmit;
+  parser->context = out;
+}
+
+/* 先逐字节输入，再整块输入，两种方式的结果必须一致 */
+static void feedBoth(const uartFramer_t *framer,
+                     const uartPortConfig_t *config, const uint8_t *data,
+                     int len, collected_t *out, uartInputStats_t *stats) {
+  uartParser_t parser;
+  collected_t whole;
+  uartInputStats_t wholeStats;
+  initParser(&parser, config, &wholeStats, &whole);
+  framer->feed(&parser, data, len);
+
+  initParser(&parser, config, stats, out);
+  for (int i = 0; i < len; i++) {
+    framer->feed(&parser, data + i, 1);
+  }
+  CHECK(whole.count == out->count);
+  CHECK(wholeStats.frames == stats->frames);
+  CHECK(wholeStats.badFrames == stats->badFrames);
+  CHECK(wholeStats.overflows == stats->overflows);
+  for (int i = 0; i < out->count && i < whole.count; i++) {
+    CHECK(whole.lens[i] == out->lens[i]);
+    CHECK(memcmp(whole.frames[i], out->frames[i], out->lens[i]) == 0);
+  }
+}
+
+/* SLIP 编码：数据 + CRC（大端），转义后以 END 结尾 */
+static int slipEncode(const uint8_t *data, int len, uint8_t *out,
+                      bool corrupt) {
+  uint8_t raw[300];
+  memcpy(raw, data, len);
+  uint16_t crc = uartFramer_Crc16(data, len) ^ (corrupt ? 1 : 0);
+  raw[len] = crc >> 8;
+  raw[len + 1] = crc & 0xff;
+  int n = 0;
+  out[n++] = 0xc0; // 前导 END 冲掉线路噪声
+  for (int i = 0; i < len + 2; i++) {
+    if (raw[i] == 0xc0) {
+      out[n++] = 0xdb;
+      out[n++] = 0xdc;
+    } else if (raw[i] == 0xdb) {
+      out[n++] = 0xdb;
+      out[n++] = 0xdd;
+    } else {
+      out[n++] = raw[i];
+    }
+  }
+  out[n++] = 0xc0;
+  return n;
+}
+
+static void testFramers(void) {
+  CHECK(uartFramer_Crc16((const uint8_t *)"123456789", 9) == 0x29b1);
+
+  uartPortConfig_t config = {.maxFrame = 16, .lengthBytes = 2,
+                             .syncByte = 0xaa};
+  collected_t out;
+  uartInputStats_t stats;
+
+  const char *lines = "a\r\nbb\n\n0123456789abcdefXYZ\nok\n";
+  feedBoth(&uartFramer_Line, &config, (const uint8_t *)lines, strlen(lines),
+           &out, &stats);
+  CHECK(out.count == 3);
+  CHECK(strcmp(out.frames[0], "a") == 0);
+  CHECK(strcmp(out.frames[1], "bb") == 0);
+  CHECK(strcmp(out.frames[2], "ok") == 0);
+  CHECK(stats.overflows == 1);
+
+  // 噪声、正常帧、长度0、超长、正常帧
+  const uint8_t lengthStream[] = {0x01, 0x02, 0xaa, 0x00, 0x03, 'x', 'y',
+                                  'z',  0xaa, 0x00, 0x00, 0xaa, 0x01, 0x00,
+                                  0xaa, 0x00, 0x02, 0xaa, 'i'};
+  feedBoth(&uartFramer_Length, &config, lengthStream, sizeof(lengthStream),
+           &out, &stats);
+  CHECK(out.count == 2);
+  CHECK(strcmp(out.frames[0], "xyz") == 0);
+  CHECK(out.lens[1] == 2 && out.frames[1][0] == (char)0xaa &&
+        out.frames[1][1] == 'i');
+  CHECK(stats.badFrames == 2);
+
+  // 无同步字节、1字节长度
+  uartPortConfig_t plain = {.maxFrame = 16, .lengthBytes = 1,
+                            .syncByte = -1};
+  const uint8_t plainStream[] = {2, 'h', 'i', 1, '!'};
+  feedBoth(&uartFramer_Length, &plain, plainStream, sizeof(plainStream), &out,
+           &stats);
+  CHECK(out.count == 2 && strcmp(out.frames[1], "!") == 0);
+
+  // 含特殊字节的帧、CRC错误、非法转义、正常帧
+  uint8_t slip[256];
+  int n = 0;
+  const uint8_t special[] = {'a', 0xc0, 'b', 0xdb, 'c'};
+  n += slipEncode(special, sizeof(special), slip + n, false);
+  n += slipEncode((const uint8_t *)"bad", 3, slip + n, true);
+  slip[n++] = 'x';
+  slip[n++] = 0xdb;
+  slip[n++] = 'q';
+  slip[n++] = 'y';
+  slip[n++] = 0xc0;
+  n += slipEncode((const uint8_t *)"tail", 4, slip + n, false);
+  feedBoth(&uartFramer_Slip, &config, slip, n, &out, &stats);
+  CHECK(out.count == 2);
+  CHECK(out.lens[0] == 5 && memcmp(out.frames[0], special, 5) == 0);
+  CHECK(strcmp(out.frames[1], "tail") == 0);
+  CHECK(stats.badFrames == 2);
+
+  // 超长 SLIP 帧丢弃到下一个 END
+  uint8_t longFrame[40];
+  memset(longFrame, 'L', sizeof(longFrame));
+  n = slipEncode(longFrame, sizeof(longFrame), slip, false);
+  n += slipEncode((const uint8_t *)"ok", 2, slip + n, false);
+  feedBoth(&uartFramer_Slip, &config, slip, n, &out, &stats);
+  CHECK(out.count == 1 && strcmp(out.frames[0], "ok") == 0);
+  CHECK(stats.overflows == 1);
+}
+
+/* 自定义分帧器：固定4字节 */
+static void fixedFeed(uartParser_t *parser, const uint8_t *data, int len) {
+  for (int i = 0; i < len; i++) {
+    parser->frame[parser->len++] = data[i];
+    if (parser->len == 4) {
+      parser->stats->frames++;
+      parser->emit(parser, parser->frame, 4);
+      parser->len = 0;
+    }
+  }
+}
+
+static const uartFramer_t g_fixedFramer = {"fixed4", fixedFeed};
+
+static void testCustomFramer(void) {
+  CHECK(uartInput_RegisterFramer(&g_fixedFramer) == 0);
+  CHECK(uartInput_RegisterFramer(&g_fixedFramer) == -1);
+  CHECK(uartInput_FindFramer("fixed4") == &g_fixedFramer);
+  CHECK(uartInput_FindFramer("slip") == &uartFramer_Slip);
+  CHECK(uartInput_FindFramer("none") == NULL);
+
+  uartPortConfig_t config = {.maxFrame = 16};
+  collected_t out;
+  uartInputStats_t stats;
+  feedBoth(&g_fixedFramer, &config, (const uint8_t *)"abcdefgh", 8, &out,
+           &stats);
+  CHECK(out.count == 2 && strcmp(out.frames[1], "efgh") == 0);
+}
+
+static void countEmit(uartParser_t *parser, const uint8_t *data, int len) {
+  (*(unsigned long *)parser->context)++;
+}
+
+/* 纯解析吞吐：4KB 分段输入 */
+static void benchFramer(const uartFramer_t *framer,
+                        const uartPortConfig_t *config, const uint8_t *stream,
+                        int len, unsigned long expectFrames) {
+  uartParser_t parser;
+  uartInputStats_t stats;
+  unsigned long frames = 0;
+  memset(&parser, 0, sizeof(parser));
+  memset(&stats, 0, sizeof(stats));
+  parser.config = config;
+  parser.frame = g_frameBuf;
+  parser.stats = &stats;
+  parser.emit = countEmit;
+  parser.context = &frames;
+
+  int rounds = 16;
+  double startUs = nowUs();
+  for (int r = 0; r < rounds; r++) {
+    for (int off = 0; off < len; off += 4096) {
+      framer->feed(&parser, stream + off, len - off < 4096 ? len - off : 4096);
+    }
+  }
+  double elapsedS = (nowUs() - startUs) / 1e6;
+  CHECK(frames == expectFrames * rounds);
+  CHECK(stats.badFrames == 0);
+  printf("parse %-6s: %.0f MB/s, %.1f M frames/s\n", framer->name,
+         (double)len * rounds / elapsedS / 1e6, frames / elapsedS / 1e6);
+}
+
+static void testParseThroughput(void) {
+  int size = 4 << 20;
+  uint8_t *stream = (uint8_t *)malloc(size + 512);
+  uartPortConfig_t config = {.maxFrame = 256, .lengthBytes = 1,
+                             .syncByte = 0xaa};
+  char line[96];
+
+  int len = 0;
+  unsigned long count = 0;
+  while (len < size) {
+    int n = snprintf(line, sizeof(line),
+                     "{\"pm25\":%lu,\"pm10\":%lu,\"temp\":23.%lu}\n",
+                     count % 500, count % 700, count % 10);
+    memcpy(stream + len, line, n);
+    len += n;
+    count++;
+  }
+  benchFramer(&uartFramer_Line, &config, stream, len, count);
+
+  len = 0;
+  count = 0;
+  while (len < size) {
+    int n = snprintf(line, sizeof(line), "{\"pm25\":%lu,\"pm10\":%lu}",
+                     count % 500, count % 700);
+    stream[len++] = 0xaa;
+    stream[len++] = (uint8_t)n;
+    memcpy(stream + len, line, n);
+    len += n;
+    count++;
+  }
+  benchFramer(&uartFramer_Length, &config, stream, len, count);
+
+  len = 0;
+  count = 0;
+  while (len < size) {
+    uint8_t payload[32];
+    for (int i = 0; i < 32; i++) {
+      payload[i] = (uint8_t)(count * 31 + i * 7); // 含需要转义的字节
+    }
+    len += slipEncode(payload, sizeof(payload), stream + len, false) - 1;
+    count++;
+  }
+  stream[len++] = 0xc0;
+  benchFramer(&uartFramer_Slip, &config, stream, len, count);
+  free(stream);
+}
+
+/* ---- 伪终端测试 ---- */
+static eventLoop_t g_loop;
+static pthread_mutex_t g_recordLock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long g_frames = 0;
+static unsigned long g_outOfOrder = 0;
+static long g_lastSeq = -1;
+static double *g_latencyUs = NULL;
+static unsigned long g_latencyCount = 0;
+
+/* 载荷形如 {"seq":N,"t_us":T,...}，SLIP 和 line 两种帧相同 */
+static void frameHandle(const uartFrame_t *frame, void *userData) {
+  char text[128];
+  int len = frame->len < 127 ? frame->len : 127;
+  memcpy(text, frame->data, len);
+  text[len] = '\0';
+
+  long seq;
+  double sentUs;
+  double receivedUs = nowUs();
+  pthread_mutex_lock(&g_recordLock);
+  if (sscanf(text, "{\"seq\":%ld,\"t_us\":%lf", &seq, &sentUs) == 2) {
+    if (seq != g_lastSeq + 1) {
+      g_outOfOrder++;
+    }
+    g_lastSeq = seq;
+    if (g_latencyCount < MAX_LATENCIES) {
+      g_latencyUs[g_latencyCount++] = receivedUs - sentUs;
+    }
+  }
+  g_frames++;
+  pthread_mutex_unlock(&g_recordLock);
+}
+
+static void resetRecords(void) {
+  pthread_mutex_lock(&g_recordLock);
+  g_frames = 0;
+  g_outOfOrder = 0;
+  g_lastSeq = -1;
+  g_latencyCount = 0;
+  pthread_mutex_unlock(&g_recordLock);
+}
+
+static unsigned long frames(void) {
+  pthread_mutex_lock(&g_recordLock);
+  unsigned long count = g_frames;
+  pthread_mutex_unlock(&g_recordLock);
+  return count;
+}
+
+static int openPty(char *slaveName, size_t size) {
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 ||
+      ptsname_r(master, slaveName, size) != 0) {
+    return -1;
+  }
+  return master;
+}
+
+static void portConfig(uartPortConfig_t *config, const char *device,
+                       const char *framer) {
+  memset(config, 0, sizeof(*config));
+  snprintf(config->name, sizeof(config->name), "pty_%s", framer);
+  snprintf(config->device, sizeof(config->device), "%s", device);
+  snprintf(config->framer, sizeof(config->framer), "%s", framer);
+  snprintf(config->sensorType, sizeof(config->sensorType), "air_quality");
+  config->baud = 115200;
+  config->parity = UART_PARITY_NONE;
+  config->dataBits = 8;
+  config->stopBits = 1;
+  config->maxFrame = 256;
+  config->ringBytes = 4096;
+  config->syncByte = -1;
+}
+
+static void testTermios(void) {
+  char slave[64];
+  int master = openPty(slave, sizeof(slave));
+  CHECK(master >= 0);
+
+  uartPortConfig_t config;
+  portConfig(&config, slave, "line");
+  config.baud = 9600;
+  config.parity = UART_PARITY_ODD;
+  config.dataBits = 7;
+  config.stopBits = 2;
+  CHECK(uartInput_Init(&g_loop, frameHandle, NULL) == 0);
+  CHECK(uartInput_AddPort(&config) == 0);
+
+  int fd = open(slave, O_RDWR | O_NOCTTY);
+  struct termios tio;
+  CHECK(fd >= 0 && tcgetattr(fd, &tio) == 0);
+  // 伪终端驱动会忽略数据位和校验位，只能检查波特率、停止位和原始模式
+  CHECK(cfgetispeed(&tio) == B9600);
+  CHECK(tio.c_cflag & CSTOPB);
+  CHECK(!(tio.c_lflag & (ICANON | ECHO)));
+  CHECK(tio.c_cc[VMIN] == 0 && tio.c_cc[VTIME] == 0);
+  close(fd);
+
+  config.baud = 12345;
+  CHECK(uartInput_AddPort(&config) == -1);
+  snprintf(config.framer, sizeof(config.framer), "nope");
+  config.baud = 9600;
+  CHECK(uartInput_AddPort(&config) == -1);
+  uartInput_Deinit();
+  close(master);
+}
+
+typedef struct {
+  int fd;
+  const char *framer;
+  long count;
+  double bytesPerSec; // 0 表示不限速
+  unsigned long written;
+} writerArgs_t;
+
+static void *writerThread(void *arg) {
+  writerArgs_t *args = (writerArgs_t *)arg;
+  uint8_t frame[160];
+  double startUs = nowUs();
+  bool slip = strcmp(args->framer, "slip") == 0;
+
+  for (long seq = 0; seq < args->count; seq++) {
+    char text[128];
+    if (args->bytesPerSec > 0) {
+      // 按字节速率发送，模拟真实串口的线速
+      double dueUs = startUs + args->written * 1e6 / args->bytesPerSec;
+      while (nowUs() < dueUs) {
+        struct timespec ts = {0, 50000};
+        nanosleep(&ts, NULL);
+      }
+    }
+    int n = snprintf(text, sizeof(text),
+                     "{\"seq\":%ld,\"t_us\":%.1f,\"pm25\":%ld,\"pm10\":%ld}",
+                     seq, nowUs(), seq % 500, seq % 700);
+    int len;
+    if (slip) {
+      len = slipEncode((const uint8_t *)text, n, frame, false);
+    } else {
+      memcpy(frame, text, n);
+      frame[n] = '\n';
+      len = n + 1;
+    }
+    if (write(args->fd, frame, len) != len) {
+      break;
+    }
+    args->written += len;
+  }
+  return NULL;
+}
+
+static int compareDouble(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+static void streamRun(const char *framer, long count, double bytesPerSec,
+                      const char *label) {
+  char slave[64];
+  int master = openPty(slave, sizeof(slave));
+  CHECK(master >= 0);
+  uartPortConfig_t config;
+  portConfig(&config, slave, framer);
+  CHECK(uartInput_Init(&g_loop, frameHandle, NULL) == 0);
+  CHECK(uartInput_AddPort(&config) == 0);
+  resetRecords();
+
+  writerArgs_t args = {.fd = master, .framer = framer, .count = count,
+                       .bytesPerSec = bytesPerSec};
+  pthread_t writer;
+  double startUs = nowUs();
+  pthread_create(&writer, NULL, writerThread, &args);
+  pthread_join(writer, NULL);
+  double deadline = nowUs() + 5e6;
+  while (frames() < (unsigned long)count && nowUs() < deadline) {
+    sleepMs(1);
+  }
+  double elapsedS = (nowUs() - startUs) / 1e6;
+
+  uartInputStats_t stats;
+  uartInput_GetStats(0, &stats);
+  CHECK(frames() == (unsigned long)count);
+  CHECK(stats.frames == (unsigned long)count);
+  CHECK(stats.badFrames == 0 && stats.overflows == 0);
+  CHECK(stats.bytes == args.written);
+
+  pthread_mutex_lock(&g_recordLock);
+  CHECK(g_outOfOrder == 0);
+  unsigned long n = g_latencyCount;
+  qsort(g_latencyUs, n, sizeof(double), compareDouble);
+  if (n > 0) {
+    printf("%s: %lu frames, %.2f MB/s, latency p50 %.0f us, p99 %.0f us, "
+           "max %.0f us\n",
+           label, n, args.written / elapsedS / 1e6, g_latencyUs[n / 2],
+           g_latencyUs[n * 99 / 100], g_latencyUs[n - 1]);
+  }
+  pthread_mutex_unlock(&g_recordLock);
+
+  uartInput_Deinit();
+  close(master);
+}
+
+/* 设备消失（主端关闭）后端口关闭，不影响事件循环 */
+static void testHangup(void) {
+  char slave[64];
+  int master = openPty(slave, sizeof(slave));
+  uartPortConfig_t config;
+  portConfig(&config, slave, "line");
+  CHECK(uartInput_Init(&g_loop, frameHandle, NULL) == 0);
+  CHECK(uartInput_AddPort(&config) == 0);
+  resetRecords();
+
+  CHECK(write(master, "{\"seq\":0,\"t_us\":0}\n", 19) == 19);
+  double deadline = nowUs() + 1e6;
+  while (frames() < 1 && nowUs() < deadline) {
+    sleepMs(1);
+  }
+  CHECK(frames() == 1);
+
+  close(master);
+  uartInputStats_t stats;
+  deadline = nowUs() + 1e6;
+  do {
+    sleepMs(5);
+    uartInput_GetStats(0, &stats);
+  } while (stats.open && nowUs() < deadline);
+  CHECK(!stats.open);
+  CHECK(stats.readErrors == 1);
+  uartInput_Deinit();
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+  g_latencyUs = (double *)malloc(MAX_LATENCIES * sizeof(double));
+  if (!g_latencyUs || eventLoop_Init(&g_loop, 16) != 0 ||
+      eventLoop_Start(&g_loop) != 0) {
+    return 1;
+  }
+
+  testFramers();
+  testCustomFramer();
+  testParseThroughput();
+  testTermios();
+  // 115200 波特约 11.5 KB/s，921600 波特约 92 KB/s
+  streamRun("line", 2000, 11520, "pty line 115200");
+  streamRun("slip", 10000, 92160, "pty slip 921600");
+  streamRun("line", 200000, 0, "pty line unpaced");
+  streamRun("slip", 200000, 0, "pty slip unpaced");
+  testHangup();
+
+  eventLoop_Stop(&g_loop);
+  free(g_latencyUs);
+  return testReport("uart_input_test");
+}
@@ -0,0 +1,181 @@
+#include "../include/modules/event_loop.h"
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/watchdog.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * 线程看门狗：停滞检测、重启回调、空闲等待和硬件看门狗喂狗，用普通文件代替
+ * /dev/watchdog（ioctl 失败，只检查写入）。最后一项在运行中的事件循环上执行
+ * 检查定时器，工作线程阻塞在互斥锁上
+ * */
+#define FAKE_DEVICE "/tmp/sentinel_watchdog_test.dev"
+
+static int g_restarts = 0;
+static int g_restartId = -1;
+
+static int64_t monotonicMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void restartHandle(int id, void *userData) {
+  __atomic_add_fetch(&g_restarts, 1, __ATOMIC_RELAXED);
+  g_restartId = id;
+}
+
+static const watchdogThreadStats_t *findThread(const watchdogStats_t *stats,
+                                               const char *name) {
+  for (int i = 0; i < stats->threadCount; i++) {
+    if (strcmp(stats->threads[i].name, name) == 0) {
+      return &stats->threads[i];
+    }
+  }
+  return NULL;
+}
+
+/* 用虚拟时间调用 watchdog_Check，检查停滞、重启、空闲和喂狗 */
+static void testCheck(eventLoop_t *loop) {
+  CHECK(watchdog_Register("early", 100, NULL, NULL) == -1);
+  watchdog_Kick(-1);
+  watchdog_Idle(-1);
+
+  FILE *fp = fopen(FAKE_DEVICE, "w");
+  fclose(fp);
+  watchdogConfig_t config = {
+      .device = FAKE_DEVICE,
+      .hwTimeoutSec = 10,
+      .checkIntervalMs = 1000,
+      .maxRestarts = 1,
+  };
+  CHECK(watchdog_Init(&config, loop) == 0);
+
+  int worker = watchdog_Register("worker", 200, restartHandle, NULL);
+  int helper = watchdog_Register("helper", 200, NULL, NULL);
+  CHECK(worker == 0 && helper == 1);
+
+  int64_t now = monotonicMs();
+  watchdog_Check(now + 150);
+  watchdogStats_t stats;
+  watchdog_GetStats(&stats);
+  CHECK(stats.hardware);
+  CHECK(!stats.fatal && stats.hwFeeds == 1);
+
+  // 两个线程都停滞：worker 被重启，helper 无法恢复，停止喂狗
+  watchdog_Check(now + 300);
+  watchdog_GetStats(&stats);
+  CHECK(g_restarts == 1 && g_restartId == worker);
+  CHECK(stats.fatal && stats.hwFeeds == 1);
+  CHECK(findThread(&stats, "helper")->stalled);
+  CHECK(findThread(&stats, "helper")->stalls == 1);
+  CHECK(!findThread(&stats, "worker")->stalled);
+  CHECK(findThread(&stats, "worker")->restarts == 1);
+
+  // 停滞只报告一次
+  watchdog_Check(now + 350);
+  watchdog_GetStats(&stats);
+  CHECK(findThread(&stats, "helper")->stalls == 1);
+  CHECK(stats.hwFeeds == 1);
+
+  // helper 恢复后重新喂狗
+  watchdog_Kick(helper);
+  watchdog_Check(monotonicMs());
+  watchdog_GetStats(&stats);
+  CHECK(!stats.fatal && stats.hwFeeds == 2);
+  CHECK(!findThread(&stats, "helper")->stalled);
+
+  // 空闲等待中的线程不检查，空闲时长不计入心跳间隔
+  watchdog_Idle(helper);
+  watchdog_Check(monotonicMs() + 5000);
+  watchdog_GetStats(&stats);
+  CHECK(findThread(&stats, "helper")->idle);
+  CHECK(!findThread(&stats, "helper")->stalled);
+  // worker 已用完重启次数，再次停滞即无法恢复
+  CHECK(g_restarts == 1);
+  CHECK(findThread(&stats, "worker")->stalls == 2);
+  CHECK(stats.fatal);
+  usleep(20 * 1000);
+  watchdog_Kick(helper);
+  watchdog_GetStats(&stats);
+  CHECK(!findThread(&stats, "helper")->idle);
+  CHECK(findThread(&stats, "helper")->maxGapMs < 200);
+
+  watchdog_Deinit();
+  CHECK(watchdog_Register("after", 100, NULL, NULL) == -1);
+
+  // 每次喂狗写入一个字节，关闭前写入 'V'
+  char buffer[16];
+  fp = fopen(FAKE_DEVICE, "r");
+  size_t n = fread(buffer, 1, sizeof(buffer), fp);
+  fclose(fp);
+  unlink(FAKE_DEVICE);
+  CHECK(n == 3 && buffer[0] == '\0' && buffer[1] == '\0' && buffer[2] == 'V');
+}
+
+static pthread_mutex_t g_sharedLock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int g_stop = 0;
+static int g_workerId = -1;
+
+static void *workerThreadFunc(void *arg) {
+  while (!g_stop) {
+    watchdog_Kick(g_workerId);
+    pthread_mutex_lock(&g_sharedLock);
+    pthread_mutex_unlock(&g_sharedLock);
+    usleep(10 * 1000);
+  }
+  return NULL;
+}
+
+/* 事件循环上的检查定时器发现被锁阻塞的线程 */
+static void testLiveStall(eventLoop_t *loop) {
+  watchdogConfig_t config = {.checkIntervalMs = 50, .maxRestarts = 0};
+  CHECK(watchdog_Init(&config, loop) == 0);
+  g_workerId = watchdog_Register("blocked", 150, NULL, NULL);
+  CHECK(eventLoop_Start(loop) == 0);
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, workerThreadFunc, NULL);
+  usleep(200 * 1000);
+  watchdogStats_t stats;
+  watchdog_GetStats(&stats);
+  CHECK(!stats.hardware && !stats.fatal);
+  CHECK(stats.threads[0].stalls == 0);
+
+  // 持锁400毫秒，模拟持锁进行网络调用
+  int64_t start = monotonicMs();
+  pthread_mutex_lock(&g_sharedLock);
+  usleep(400 * 1000);
+  watchdog_GetStats(&stats);
+  pthread_mutex_unlock(&g_sharedLock);
+  CHECK(stats.fatal && stats.threads[0].stalled);
+  printf("blocked worker reported after <= %lld ms, stalls %lu\n",
+         (long long)(monotonicMs() - start), stats.threads[0].stalls);
+
+  usleep(150 * 1000);
+  watchdog_GetStats(&stats);
+  CHECK(!stats.fatal && !stats.threads[0].stalled);
+  CHECK(stats.threads[0].stalls == 1);
+  CHECK(stats.threads[0].maxGapMs >= 390);
+
+  g_stop = 1;
+  pthread_join(thread, NULL);
+  eventLoop_Stop(loop);
+  watchdog_Deinit();
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  eventLoop_t loop;
+  CHECK(eventLoop_Init(&loop, 8) == 0);
+  testCheck(&loop);
+  testLiveStall(&loop);
+
+  return testReport("watchdog_test");
+}
@@ -0,0 +1,639 @@
+#include "../include/modules/event_loop.h"
+#include "../include/modules/mem_pool.h"
+#include "../include/modules/ws_server.h"
+#include "test_check.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * WebSocket实时数据：RFC 6455握手和HTTP错误应答，已打开连接上的订阅、取消
+ * 订阅、ping 和关闭，每个采样只发给订阅者，停滞的客户端先被丢弃消息再被断开，
+ * 同时快速的客户端收到每个采样且发布的开销不变，以及几百个本地客户端的负载
+ * （输出扇出延迟和每个客户端的内存）
+ * */
+#define LOAD_CLIENTS 500
+#define LOAD_MESSAGES 200
+#define LOAD_INTERVAL_US 2000
+#define CLIENT_BUF 8192
+#define RFC_KEY "dGhlIHNhbXBsZSBub25jZQ=="
+#define RFC_ACCEPT "s3pPLMBiTxaQ9kYGzzhZRbK+xOo="
+
+static eventLoop_t g_loop;
+static int g_status, g_light, g_gpio;
+
+static int64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void sleepUs(int us) {
+  struct timespec ts = {us / 1000000, (long)(us % 1000000) * 1000};
+  nanosleep(&ts, NULL);
+}
+
+static int startServer(int maxClients, int sendBufferBytes, int stallMs) {
+  wsServerConfig_t config = {.bindAddress = "127.0.0.1",
+                             .port = 0,
+                             .maxClients = maxClients,
+                             .sendBufferBytes = sendBufferBytes,
+                             .queueSlots = 64,
+                             .maxMessageBytes = 1024,
+                             .stallTimeoutMs = stallMs,
+                             .allowedOrigins = "http://dash.local:3000"};
+  if (wsServer_Init(&config, &g_loop) != 0) {
+    return -1;
+  }
+  return eventLoop_Start(&g_loop);
+}
+
+static void stopServer(void) {
+  eventLoop_Stop(&g_loop);
+  wsServer_Deinit();
+}
+
+/* 连接并设置接收超时，rcvbuf 为0时使用默认的接收缓冲 */
+static int connectClient(int rcvbuf) {
+  struct sockaddr_in addr = {.sin_family = AF_INET,
+                             .sin_port = htons((uint16_t)wsServer_Port())};
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  struct timeval timeout = {2, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  if (rcvbuf > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  }
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int sendAll(int fd, const void *data, size_t len) {
+  const char *p = (const char *)data;
+  while (len > 0) {
+    ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if (n <= 0) {
+      return -1;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+static int recvAll(int fd, void *data, size_t len) {
+  return recv(fd, data, len, MSG_WAITALL) == (ssize_t)len ? 0 : -1;
+}
+
+/* 读取HTTP响应头（逐字节读，不越过响应头） */
+static int readHead(int fd, char *out, int size) {
+  int len = 0;
+  while (len < size - 1) {
+    if (recv(fd, out + len, 1, 0) != 1) {
+      break;
+    }
+    len++;
+    out[len] = '\0';
+    if (len >= 4 && memcmp(out + len - 4, "\r\n\r\n", 4) == 0) {
+      return len;
+    }
+  }
+  out[len] = '\0';
+  return -1;
+}
+
+/* 发送请求并读取完整响应（服务端写完后断开） */
+static int httpGet(const char *request, char *out, int size) {
+  int fd = connectClient(0);
+  if (fd < 0 || sendAll(fd, request, strlen(request)) != 0) {
+    return -1;
+  }
+  int len = 0;
+  ssize_t n;
+  while (len < size - 1 && (n = recv(fd, out + len, size - 1 - len, 0)) > 0) {
+    len += (int)n;
+  }
+  out[len] = '\0';
+  close(fd);
+  return len;
+}
+
+static int upgrade(const char *query, int rcvbuf) {
+  int fd = connectClient(rcvbuf);
+  char request[256], head[512];
+  snprintf(request, sizeof(request),
+           "GET /live%s HTTP/1.1\r\nHost: localhost\r\n"
+           "Upgrade: websocket\r\nConnection: keep-alive, Upgrade\r\n"
+           "Sec-WebSocket-Key: " RFC_KEY "\r\n"
+           "Sec-WebSocket-Version: 13\r\n\r\n",
+           query);
+  if (fd < 0 || sendAll(fd, request, strlen(request)) != 0 ||
+      readHead(fd, head, sizeof(head)) < 0 ||
+      strncmp(head, "HTTP/1.1 101 ", 13) != 0 ||
+      strstr(head, "Sec-WebSocket-Accept: " RFC_ACCEPT "\r\n") == NULL) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  return fd;
+}
+
+/* 带 Origin 头发起握手，返回响应的状态码 */
+static int originStatus(const char *origin) {
+  int fd = connectClient(0);
+  char request[256], head[512];
+  snprintf(request, sizeof(request),
+           "GET /live HTTP/1.1\r\nHost: localhost\r\nOrigin: %s\r\n"
+           "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+           "Sec-WebSocket-Key: " RFC_KEY "\r\n"
+           "Sec-WebSocket-Version: 13\r\n\r\n",
+           origin);
+  int status = -1;
+  if (fd >= 0 && sendAll(fd, request, strlen(request)) == 0 &&
+      readHead(fd, head, sizeof(head)) > 9) {
+    status = atoi(head + 9);
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+  return status;
+}
+
+/* 发送加掩码的客户端帧 */
+static int sendFrame(int fd, int opcode, const char *payload, int len) {
+  uint8_t frame[256];
+  uint8_t key[4] = {0x12, 0x34, 0x56, 0x78};
+  frame[0] = (uint8_t)(0x80 | opcode);
+  frame[1] = (uint8_t)(0x80 | len);
+  memcpy(frame + 2, key, 4);
+  for (int i = 0; i < len; i++) {
+    frame[6 + i] = (uint8_t)payload[i] ^ key[i & 3];
+  }
+  return sendAll(fd, frame, 6 + len);
+}
+
+/* 读取一帧服务端帧，返回载荷长度，-1 表示超时或断开 */
+static int readFrame(int fd, int *opcode, char *out, int size) {
+  uint8_t head[10];
+  if (recvAll(fd, head, 2) != 0 || (head[1] & 0x80)) {
+    return -1;
+  }
+  *opcode = head[0] & 0x0F;
+  uint64_t len = head[1] & 0x7F;
+  if (len == 126) {
+    if (recvAll(fd, head + 2, 2) != 0) {
+      return -1;
+    }
+    len = (uint64_t)head[2] << 8 | head[3];
+  } else if (len == 127) {
+    return -1;
+  }
+  if (len >= (uint64_t)size || recvAll(fd, out, len) != 0) {
+    return -1;
+  }
+  out[len] = '\0';
+  return (int)len;
+}
+
+static bool readText(int fd, const char *expect) {
+  char text[2048];
+  int opcode;
+  int len = readFrame(fd, &opcode, text, sizeof(text));
+  if (len < 0 || opcode != 1 || strcmp(text, expect) != 0) {
+    fprintf(stderr, "got \"%s\", expected \"%s\"\n", len < 0 ? "" : text,
+            expect);
+    return false;
+  }
+  return true;
+}
+
+static void testHandshake(void) {
+  CHECK(startServer(8, 4096, 1000) == 0);
+  char response[1024];
+
+  int fd = upgrade("", 0);
+  CHECK(fd >= 0);
+
+  CHECK(httpGet("GET /sources HTTP/1.1\r\n\r\n", response,
+                sizeof(response)) > 0);
+  CHECK(strncmp(response, "HTTP/1.1 200 OK\r\n", 17) == 0);
+  CHECK(strstr(response, "\r\n\r\n{\"sources\":[\"status\",\"light\","
+                         "\"gpio\"]}") != NULL);
+  CHECK(httpGet("GET /nope HTTP/1.1\r\n\r\n", response, sizeof(response)) > 0);
+  CHECK(strncmp(response, "HTTP/1.1 404 ", 13) == 0);
+  CHECK(httpGet("GET /live HTTP/1.1\r\n\r\n", response, sizeof(response)) > 0);
+  CHECK(strncmp(response, "HTTP/1.1 400 ", 13) == 0);
+  CHECK(httpGet("GET /live HTTP/1.1\r\nUpgrade: WebSocket\r\n"
+                "Connection: Upgrade\r\nSec-WebSocket-Key: " RFC_KEY "\r\n"
+                "Sec-WebSocket-Version: 8\r\n\r\n",
+                response, sizeof(response)) > 0);
+  CHECK(strncmp(response, "HTTP/1.1 426 ", 13) == 0);
+  CHECK(strstr(response, "\r\nSec-WebSocket-Version: 13\r\n") != NULL);
+  CHECK(strstr(strstr(response, "\r\n\r\n"), "Sec-WebSocket") == NULL);
+  CHECK(httpGet("GET /live?sources=light,bogus HTTP/1.1\r\n"
+                "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                "Sec-WebSocket-Key: " RFC_KEY "\r\n"
+                "Sec-WebSocket-Version: 13\r\n\r\n",
+                response, sizeof(response)) > 0);
+  CHECK(strncmp(response, "HTTP/1.1 404 ", 13) == 0);
+
+  // 浏览器页面只能从 allowedOrigins 中的来源握手
+  CHECK(originStatus("http://evil.example") == 403);
+  CHECK(originStatus("null") == 403);
+  CHECK(originStatus("http://localhost") == 403);
+  CHECK(originStatus("http://DASH.local:3000") == 101);
+
+  // 订阅、取消订阅和控制帧
+  const char *cmd = "subscribe light, status";
+  CHECK(sendFrame(fd, 1, cmd, strlen(cmd)) == 0);
+  CHECK(readText(fd, "{\"subscribed\":[\"status\",\"light\"]}"));
+  cmd = "unsubscribe status";
+  CHECK(sendFrame(fd, 1, cmd, strlen(cmd)) == 0);
+  CHECK(readText(fd, "{\"subscribed\":[\"light\"]}"));
+  cmd = "subscribe bogus";
+  CHECK(sendFrame(fd, 1, cmd, strlen(cmd)) == 0);
+  CHECK(readText(fd, "{\"error\":\"unknown source\"}"));
+  cmd = "subscribe *";
+  CHECK(sendFrame(fd, 1, cmd, strlen(cmd)) == 0);
+  CHECK(readText(fd, "{\"subscribed\":[\"status\",\"light\",\"gpio\"]}"));
+
+  char payload[256];
+  int opcode;
+  CHECK(sendFrame(fd, 9, "hi", 2) == 0);
+  CHECK(readFrame(fd, &opcode, payload, sizeof(payload)) == 2);
+  CHECK(opcode == 10 && memcmp(payload, "hi", 2) == 0);
+  CHECK(sendFrame(fd, 8, "\x03\xe8", 2) == 0);
+  CHECK(readFrame(fd, &opcode, payload, sizeof(payload)) == 2);
+  CHECK(opcode == 8 && memcmp(payload, "\x03\xe8", 2) == 0);
+  CHECK(recv(fd, payload, 1, 0) == 0);
+  close(fd);
+
+  // 未加掩码的帧以1002关闭
+  fd = upgrade("", 0);
+  uint8_t unmasked[] = {0x81, 0x02, 'h', 'i'};
+  CHECK(sendAll(fd, unmasked, sizeof(unmasked)) == 0);
+  CHECK(readFrame(fd, &opcode, payload, sizeof(payload)) == 2);
+  CHECK(opcode == 8 && payload[0] == 0x03 && payload[1] == (char)0xea);
+  close(fd);
+
+  stopServer();
+  wsServerStats_t stats;
+  wsServer_GetStats(&stats);
+  CHECK(stats.accepted == 11);
+  CHECK(stats.rejected == 7);
+  CHECK(stats.closed == 11);
+  CHECK(stats.clients == 0);
+}
+
+static void testFanOut(void) {
+  CHECK(startServer(8, 4096, 1000) == 0);
+  int a = upgrade("?sources=light", 0);
+  int b = upgrade("?sources=status,light", 0);
+  CHECK(a >= 0 && b >= 0);
+
+  char big[301];
+  memset(big, 'x', sizeof(big));
+  big[0] = '"';
+  big[299] = '"';
+  big[300] = '\0';
+  wsServer_Publish(g_light, "{\"v\":1}", 7);
+  wsServer_Publish(g_gpio, "{\"v\":0}", 7); // 没有订阅者
+  wsServer_Publish(g_status, big, 300);
+
+  char text[2048];
+  int opcode;
+  CHECK(readFrame(a, &opcode, text, sizeof(text)) > 0);
+  CHECK(strncmp(text, "{\"source\":\"light\",\"t_ns\":", 25) == 0);
+  CHECK(strstr(text, ",\"data\":{\"v\":1}}") != NULL);
+  int64_t tNs = strtoll(text + 25, NULL, 10);
+  CHECK(tNs > 0 && tNs <= nowNs());
+
+  CHECK(readFrame(b, &opcode, text, sizeof(text)) > 0);
+  CHECK(strstr(text, "\"source\":\"light\"") != NULL);
+  CHECK(readFrame(b, &opcode, text, sizeof(text)) > 300); // 16位长度
+  CHECK(strncmp(text, "{\"source\":\"status\"", 18) == 0);
+  CHECK(strstr(text, big) != NULL);
+
+  // a 不应收到 status（等待一个之后发布的 light 作为分界）
+  wsServer_Publish(g_light, "{\"v\":2}", 7);
+  CHECK(readFrame(a, &opcode, text, sizeof(text)) > 0);
+  CHECK(strstr(text, "{\"v\":2}") != NULL);
+
+  // 超过 maxMessageBytes 的消息丢弃
+  char *huge = calloc(1, 2000);
+  wsServer_Publish(g_light, huge, 2000);
+  free(huge);
+
+  close(a);
+  close(b);
+  stopServer();
+  wsServerStats_t stats;
+  wsServer_GetStats(&stats);
+  CHECK(stats.published == 3);
+  CHECK(stats.frames == 5);
+  CHECK(stats.oversized == 1);
+  CHECK(stats.frameDrops == 0);
+}
+
+typedef struct {
+  int fd;
+  volatile int received;
+  volatile bool stop;
+} reader_t;
+
+static void *readerThread(void *arg) {
+  reader_t *reader = (reader_t *)arg;
+  char text[2048];
+  int opcode;
+  while (!reader->stop) {
+    if (readFrame(reader->fd, &opcode, text, sizeof(text)) < 0) {
+      break;
+    }
+    reader->received++;
+  }
+  return NULL;
+}
+
+/*
+ * 慢客户端不读取，接收窗口关闭后发送缓冲写满：丢弃它的帧并在持续
+ * stallTimeoutMs 后断开；同时订阅的快客户端收到全部消息
+ * */
+static void testSlowClient(void) {
+  CHECK(startServer(8, 4096, 100) == 0);
+  reader_t fast = {.fd = upgrade("?sources=light", 0)};
+  int slow = upgrade("?sources=light", 2048);
+  CHECK(fast.fd >= 0 && slow >= 0);
+  pthread_t thread;
+  pthread_create(&thread, NULL, readerThread, &fast);
+
+  char payload[1001];
+  memset(payload, 'x', sizeof(payload));
+  payload[0] = '"';
+  payload[999] = '"';
+  int published = 0;
+  int64_t totalPublishNs = 0, maxPublishNs = 0;
+  wsServerStats_t stats;
+  int64_t deadline = nowNs() + 10000000000LL;
+  do {
+    int64_t start = nowNs();
+    wsServer_Publish(g_light, payload, 1000);
+    int64_t took = nowNs() - start;
+    totalPublishNs += took;
+    if (took > maxPublishNs) {
+      maxPublishNs = took;
+    }
+    published++;
+    sleepUs(500);
+    wsServer_GetStats(&stats);
+  } while (stats.slowClosed == 0 && nowNs() < deadline);
+  // 断开后再发布一些，快客户端不受影响
+  for (int i = 0; i < 20; i++) {
+    wsServer_Publish(g_light, payload, 1000);
+    published++;
+    sleepUs(500);
+  }
+
+  for (int i = 0; i < 200 && fast.received < published; i++) {
+    sleepUs(10000);
+  }
+  wsServer_GetStats(&stats);
+  printf("slow client: disconnected after %d messages (%lu frames dropped), "
+         "fast client got %d/%d, publish call avg %.1f us max %.1f us\n",
+         published - 20, stats.frameDrops, fast.received, published,
+         totalPublishNs / 1e3 / (published - 20), maxPublishNs / 1e3);
+  CHECK(stats.slowClosed == 1);
+  CHECK(stats.frameDrops > 0);
+  CHECK(stats.queueDrops == 0);
+  CHECK(fast.received == published);
+  CHECK(stats.clients == 1);
+
+  // 慢客户端读完内核中的数据后看到连接断开
+  char buf[4096];
+  ssize_t n;
+  while ((n = recv(slow, buf, sizeof(buf), 0)) > 0) {
+  }
+  CHECK(n == 0);
+  close(slow);
+
+  fast.stop = true;
+  shutdown(fast.fd, SHUT_RDWR);
+  pthread_join(thread, NULL);
+  close(fast.fd);
+  stopServer();
+}
+
+/* 负载测试的客户端：按流解析服务端帧 */
+typedef struct {
+  int fd;
+  int len;
+  int received;
+  char buf[CLIENT_BUF];
+} loadClient_t;
+
+static loadClient_t *g_loadClients = NULL;
+static double *g_latencyUs = NULL;
+static volatile int g_loadReceived = 0;
+static volatile bool g_loadStop = false;
+static int g_epollFd = -1;
+
+static void loadParse(loadClient_t *client, int64_t now) {
+  int pos = 0;
+  while (client->len - pos >= 4) {
+    const uint8_t *p = (const uint8_t *)client->buf + pos;
+    int len = p[1] & 0x7F, headerLen = 2;
+    if (len == 126) {
+      len = p[2] << 8 | p[3];
+      headerLen = 4;
+    }
+    if (client->len - pos < headerLen + len) {
+      break;
+    }
+    const char *t = memmem(p + headerLen, len, "\"t_ns\":", 7);
+    if (t && g_loadReceived < LOAD_CLIENTS * LOAD_MESSAGES) {
+      g_latencyUs[g_loadReceived] = (now - strtoll(t + 7, NULL, 10)) / 1e3;
+    }
+    client->received++;
+    g_loadReceived++;
+    pos += headerLen + len;
+  }
+  client->len -= pos;
+  memmove(client->buf, client->buf + pos, client->len);
+}
+
+static void *loadReaderThread(void *arg) {
+  struct epoll_event events[64];
+  while (!g_loadStop) {
+    int n = epoll_wait(g_epollFd, events, 64, 50);
+    int64_t now = nowNs();
+    for (int i = 0; i < n; i++) {
+      loadClient_t *client = (loadClient_t *)events[i].data.ptr;
+      ssize_t got = recv(client->fd, client->buf + client->len,
+                         CLIENT_BUF - client->len, MSG_DONTWAIT);
+      if (got > 0) {
+        client->len += (int)got;
+        loadParse(client, now);
+      }
+    }
+  }
+  return NULL;
+}
+
+static int compareDouble(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+static long rssKb(void) {
+  FILE *fp = fopen("/proc/self/status", "r");
+  char line[128];
+  long kb = -1;
+  while (fp && fgets(line, sizeof(line), fp)) {
+    if (sscanf(line, "VmRSS: %ld kB", &kb) == 1) {
+      break;
+    }
+  }
+  if (fp) {
+    fclose(fp);
+  }
+  return kb;
+}
+
+static void testLoad(void) {
+  long rssBefore = rssKb();
+  CHECK(startServer(LOAD_CLIENTS, 16384, 1000) == 0);
+  g_loadClients = calloc(LOAD_CLIENTS, sizeof(loadClient_t));
+  g_latencyUs = malloc(LOAD_CLIENTS * LOAD_MESSAGES * sizeof(double));
+  g_epollFd = epoll_create1(0);
+
+  int connected = 0;
+  for (int i = 0; i < LOAD_CLIENTS; i++) {
+    loadClient_t *client = &g_loadClients[i];
+    client->fd = upgrade("?sources=light", 0);
+    if (client->fd < 0) {
+      break;
+    }
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = client};
+    epoll_ctl(g_epollFd, EPOLL_CTL_ADD, client->fd, &event);
+    connected++;
+  }
+  CHECK(connected == LOAD_CLIENTS);
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, loadReaderThread, NULL);
+  char payload[128];
+  int64_t startNs = nowNs();
+  for (int i = 0; i < LOAD_MESSAGES; i++) {
+    int len = snprintf(payload, sizeof(payload),
+                       "{\"timestamp_ms\": %d,\"light_lux\": %d,"
+                       "\"infrared_cd\": %d}",
+                       i, 100 + i, 7);
+    wsServer_Publish(g_light, payload, len);
+    sleepUs(LOAD_INTERVAL_US);
+  }
+  int expected = connected * LOAD_MESSAGES;
+  for (int i = 0; i < 500 && g_loadReceived < expected; i++) {
+    sleepUs(10000);
+  }
+  double seconds = (nowNs() - startNs) / 1e9;
+  g_loadStop = true;
+  pthread_join(thread, NULL);
+
+  wsServerStats_t stats;
+  wsServer_GetStats(&stats);
+  int count = g_loadReceived < expected ? g_loadReceived : expected;
+  qsort(g_latencyUs, count, sizeof(double), compareDouble);
+  if (count > 0) {
+    printf("load: %d clients x %d samples, %d frames in %.2f s; "
+           "publish->client latency p50 %.0f us, p99 %.0f us, max %.0f us; "
+           "fan-out avg %.0f us, max %llu us\n",
+           connected, LOAD_MESSAGES, count, seconds,
+           g_latencyUs[count / 2], g_latencyUs[count * 99 / 100],
+           g_latencyUs[count - 1],
+           (double)stats.fanoutTotalUs / stats.published,
+           (unsigned long long)stats.fanoutMaxUs);
+  }
+  // 连接表和缓冲在启动时一次性分配，RSS 随实际写入的发送缓冲增长
+  long rssKbPerClient = (rssKb() - rssBefore) * 1024 / connected;
+  printf("load: %d bytes reserved per client, process RSS +%ld bytes per "
+         "connected client (including this test's client buffers)\n",
+         stats.bytesPerClient, rssKbPerClient);
+  CHECK(g_loadReceived == expected);
+  CHECK(stats.frameDrops == 0);
+  CHECK(stats.queueDrops == 0);
+  CHECK(stats.clients == connected);
+  for (int i = 0; i < connected; i++) {
+    CHECK(g_loadClients[i].received == LOAD_MESSAGES);
+    if (g_loadClients[i].received != LOAD_MESSAGES) {
+      break;
+    }
+  }
+
+  for (int i = 0; i < connected; i++) {
+    close(g_loadClients[i].fd);
+  }
+  close(g_epollFd);
+  stopServer();
+  free(g_latencyUs);
+  free(g_loadClients);
+}
+
+int main(void) {
+  memPoolConfig_t memConfig = {.staticMode = false};
+  memPool_Init(&memConfig);
+
+  // 每个客户端两端共占两个描述符
+  struct rlimit limit;
+  getrlimit(RLIMIT_NOFILE, &limit);
+  if (limit.rlim_cur < 2 * LOAD_CLIENTS + 64) {
+    limit.rlim_cur = 2 * LOAD_CLIENTS + 64;
+    if (limit.rlim_cur > limit.rlim_max ||
+        setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+      fprintf(stderr, "need %d file descriptors\n", 2 * LOAD_CLIENTS + 64);
+      return 1;
+    }
+  }
+
+  g_status = wsServer_RegisterSource("status");
+  g_light = wsServer_RegisterSource("light");
+  g_gpio = wsServer_RegisterSource("gpio");
+  CHECK(g_status == 0 && g_light == 1 && g_gpio == 2);
+  CHECK(wsServer_RegisterSource("light") == g_light);
+  CHECK(wsServer_RegisterSource("a_very_long_source_name") == -1);
+  if (eventLoop_Init(&g_loop, LOAD_CLIENTS + 8) != 0) {
+    return 1;
+  }
+
+  // 发送缓冲必须是2的幂且能容纳最大的帧
+  wsServerConfig_t bad = {.bindAddress = "127.0.0.1",
+                          .maxClients = 1,
+                          .sendBufferBytes = 1000,
+                          .queueSlots = 1,
+                          .maxMessageBytes = 100};
+  CHECK(wsServer_Init(&bad, &g_loop) == -1);
+  bad.sendBufferBytes = 1024;
+  bad.maxMessageBytes = 1000;
+  CHECK(wsServer_Init(&bad, &g_loop) == -1);
+
+  testHandshake();
+  testFanOut();
+  testSlowClient();
+  testLoad();
+
+  return testReport("ws_server_test");
+}